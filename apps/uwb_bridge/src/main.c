@@ -0,0 +1,736 @@
+/**
+ * Copyright (C) 2017-2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file main.c
+ * @brief Gateway bridge daemon, publishes UWB records to local consumers
+ *
+ * @details uwb_bridge [-s socket] [-d tty] [-b baud] [-l rate] [-t secs]
+ *   serves the bridge on a Unix domain socket. Records come from a node on
+ *   a serial port, its JSON console output one line per record, and/or from
+ *   a synthetic producer thread publishing rate range records per second.
+ *   Every secs seconds the bridge counters and delivery latency are printed
+ *   to stderr.
+ *
+ *   With -m name range records are also written in binary to the shared
+ *   memory ring name, see uwb_bridge_shm.h. With -k the synthetic producer
+ *   runs unpaced and writes the shared memory ring only, a soak load.
+ *
+ *   With -y ms the host clock is disciplined to the WCS master timeline of
+ *   the node, a "wcs time" request every ms, see uwb_bridge_tsync.h. Every
+ *   update is published as a tsync record and the clock is written to the
+ *   shared memory ring for consumers. With -u the node is on a uart and the
+ *   serialisation of the request and the longer reply at baud is taken out.
+ *
+ * uwb_bridge -Y jitter [-y ms] [-t secs]
+ *   time sync over a simulated link, exponential queueing of mean jitter usec
+ *   each way to a node whose clock runs 40 ppm fast, an hour of exchanges in
+ *   simulated time. Prints the true error of the disciplined clock every secs
+ *   and fails if its rms over the locked part exceeds jitter / 4.
+ *
+ * uwb_bridge -c socket [-t secs]
+ *   consumer, counts records and drop notices and measures the latency of
+ *   synthetic records from their utime, CLOCK_MONOTONIC usec at publish.
+ *
+ * uwb_bridge -M name [-t secs]
+ *   shared memory consumer, counts records and lost records, checks that
+ *   record numbers only advance and agree with the loss count, and that no
+ *   synthetic record was torn by the producer overwriting it during the copy.
+ *   The disciplined clock is shown once the producer runs time sync.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <pthread.h>
+#include <termios.h>
+#include <time.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sched.h>
+
+#include <os/os.h>
+#include <json_stream/json_stream.h>
+#include <json_stream/json_stream_decode.h>
+#include <uwb_bridge/uwb_bridge.h>
+#include <uwb_bridge/uwb_bridge_unix.h>
+#include <uwb_bridge/uwb_bridge_shm.h>
+#include <uwb_bridge/uwb_bridge_tsync.h>
+
+#define SYNTH_UID 0x55a6
+
+static volatile sig_atomic_t g_stop;
+static struct uwb_bridge_unix g_ux;
+static struct uwb_bridge_shm g_shm;
+static struct json_record g_rec;
+
+//! Host time sync with the node on the serial port
+struct tsync_link {
+    struct uwb_bridge_tsync ts;        //!< Estimator
+    uint32_t period;                   //!< Request period, ms, 0 when off
+    uint32_t id;                       //!< Id of the request outstanding
+    int64_t t1;                        //!< Its host time, ns, 0 when none
+    uint16_t req_len;                  //!< Its length
+    int64_t char_ns;                   //!< Serialisation per character, ns, 0 off a uart
+    int64_t next;                      //!< Host time of the next request, ns
+    uint32_t invalid;                  //!< Replies while the node's wcs was not following a master
+};
+static struct tsync_link g_tsync;
+
+static void
+on_signal(int sig)
+{
+    g_stop = 1;
+}
+
+static uint64_t
+now_usec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000u;
+}
+
+static int64_t
+now_nsec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static speed_t
+baud_to_speed(long baud)
+{
+    switch (baud) {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 230400: return B230400;
+        case 460800: return B460800;
+        case 921600: return B921600;
+        default: return B115200;
+    }
+}
+
+static int
+serial_open(const char * dev, long baud)
+{
+    struct termios tio;
+    int fd = open(dev, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+
+    if (fd < 0) {
+        return -1;
+    }
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, baud_to_speed(baud));
+        cfsetospeed(&tio, baud_to_speed(baud));
+        tio.c_cflag |= CLOCAL | CREAD;
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    return fd;
+}
+
+/* Type of a console line from the node, by schema where the decoder knows it */
+static uwb_bridge_type_t
+classify(const char * line, uint16_t len)
+{
+    uint32_t consumed;
+
+    if (json_stream_decode(line, len, &g_rec, &consumed) == JSON_DECODE_OK) {
+        return (g_rec.type == JSON_RECORD_SURVEY) ? UWB_BRIDGE_TYPE_SURVEY : UWB_BRIDGE_TYPE_RANGE;
+    }
+    if (memmem(line, len, "\"ccp", 4)) {
+        return UWB_BRIDGE_TYPE_CCP;
+    }
+    if (memmem(line, len, "\"pos", 4)) {
+        return UWB_BRIDGE_TYPE_POSITION;
+    }
+    if (memmem(line, len, "\"msg\"", 5) || memmem(line, len, "\"diag\"", 6)) {
+        return UWB_BRIDGE_TYPE_DIAG;
+    }
+    return UWB_BRIDGE_TYPE_TEXT;
+}
+
+static void
+tsync_publish(struct uwb_bridge_instance * br, struct uwb_bridge_tsync * ts)
+{
+    struct json_stream js;
+    char buf[MYNEWT_VAL(UWB_BRIDGE_MAX_RECORD)];
+
+    json_stream_init(&js, buf, sizeof(buf), NULL, NULL);
+    json_stream_object_start(&js);
+    json_stream_key(&js, "utime");
+    json_stream_uint(&js, now_usec());
+    json_stream_key(&js, "tsync");
+    json_stream_object_start(&js);
+    json_stream_key(&js, "locked");
+    json_stream_uint(&js, (ts->clock.flags & UWB_BRIDGE_TSYNC_LOCKED) ? 1 : 0);
+    json_stream_key(&js, "offset");
+    json_stream_int(&js, ts->stats.error);
+    json_stream_key(&js, "jitter");
+    json_stream_float(&js, ts->clock.jitter);
+    json_stream_key(&js, "ppm");
+    json_stream_float(&js, ts->clock.rate * 1e6);
+    json_stream_key(&js, "delay");
+    json_stream_int(&js, ts->stats.delay);
+    json_stream_object_finish(&js);
+    json_stream_object_finish(&js);
+    uwb_bridge_publish(br, UWB_BRIDGE_TYPE_TSYNC, buf, js.wr);
+}
+
+/* Ask the node for its master time */
+static void
+tsync_request(struct tsync_link * tl, int fd)
+{
+    char req[32];
+    int len = snprintf(req, sizeof(req), "wcs time %u\n", (unsigned) ++tl->id);
+
+    tl->t1 = now_nsec();
+    tl->req_len = len;
+    if (write(fd, req, len) != len) {
+        tl->t1 = 0;
+    }
+    tl->next = tl->t1 + tl->period * 1000000ll;
+}
+
+/* Reply of the node received at t4, len characters with its line end */
+static void
+tsync_reply(struct uwb_bridge_instance * br, struct tsync_link * tl, const char * line, uint16_t len, int64_t t4)
+{
+    unsigned long id, valid;
+    unsigned long long t2, t3;
+
+    if (sscanf(line, "{\"tsync\": {\"id\": %lu, \"valid\": %lu, \"t2\": %llu, \"t3\": %llu", &id, &valid, &t2, &t3) != 4
+        || tl->t1 == 0 || id != tl->id) {
+        return;
+    }
+    if (!valid) {
+        tl->invalid++;
+    }
+    // The request is complete at the node after its last character, the reply only leaves with its first
+    tl->ts.asymmetry = ((int64_t) tl->req_len - len) * tl->char_ns;
+    if (uwb_bridge_tsync_update(&tl->ts, tl->t1, uwb_bridge_tsync_dtu_to_ns(t2), uwb_bridge_tsync_dtu_to_ns(t3), t4) > 0) {
+        tsync_publish(br, &tl->ts);
+        if (g_shm.hdr) {
+            uwb_bridge_shm_set_clock(&g_shm, &tl->ts.clock);
+        }
+    }
+    tl->t1 = 0;
+}
+
+//! Console line assembly
+struct serial_line {
+    uint16_t len;
+    uint16_t overlong:1;
+    uint16_t cr:1;
+    char buf[MYNEWT_VAL(UWB_BRIDGE_MAX_RECORD)];
+};
+
+static int
+serial_read(struct uwb_bridge_instance * br, int fd, struct serial_line * sl)
+{
+    char chunk[512];
+    ssize_t n = read(fd, chunk, sizeof(chunk));
+    int64_t t4 = now_nsec();
+
+    if (n <= 0) {
+        return (n == 0 || (errno != EAGAIN && errno != EINTR)) ? -1 : 0;
+    }
+    for (ssize_t i = 0; i < n; i++) {
+        char c = chunk[i];
+        if (c == '\n') {
+            /* Only JSON objects are records, boot banners and prompts are not */
+            if (!sl->overlong && sl->len > 9 && !strncmp(sl->buf, "{\"tsync\":", 9)) {
+                tsync_reply(br, &g_tsync, sl->buf, sl->len + 1 + sl->cr, t4);
+            } else if (!sl->overlong && sl->len && sl->buf[0] == '{') {
+                uwb_bridge_type_t type = classify(sl->buf, sl->len);
+                uwb_bridge_publish(br, type, sl->buf, sl->len);
+                if (g_shm.hdr && type == UWB_BRIDGE_TYPE_RANGE) {
+                    struct uwb_bridge_shm_rec rec = {
+                        .type = UWB_BRIDGE_TYPE_RANGE,
+                        .uid = g_rec.twr.uid,
+                        .peer = g_rec.twr.peer,
+                        .value = g_rec.twr.rng,
+                        .rssi = g_rec.twr.rssi,
+                    };
+                    uwb_bridge_shm_put(&g_shm, &rec);
+                }
+            }
+            sl->len = 0;
+            sl->overlong = 0;
+            sl->cr = 0;
+        } else if (c == '\r') {
+            sl->cr = 1;
+        } else {
+            if (sl->len == sizeof(sl->buf)) {
+                sl->overlong = 1;
+            } else {
+                sl->buf[sl->len++] = c;
+            }
+        }
+    }
+    return 0;
+}
+
+//! Synthetic load
+struct synth {
+    struct uwb_bridge_instance * br;
+    uint32_t rate;
+    bool flood;
+    pthread_t thread;
+};
+
+/* Synthetic binary record n, every field derived from n so a torn copy shows */
+static void
+synth_shm(uint64_t n)
+{
+    struct uwb_bridge_shm_rec rec = {
+        .type = UWB_BRIDGE_TYPE_RANGE,
+        .timestamp = n,
+        .frame_seq = n & 0xff,
+        .uid = SYNTH_UID,
+        .peer = 0x1000 + (n & 0xff),
+        .value = 1.0f + (n % 1000) * 0.001f,
+    };
+    uwb_bridge_shm_put(&g_shm, &rec);
+}
+
+static bool
+synth_shm_check(const struct uwb_bridge_shm_rec * rec)
+{
+    uint64_t n = rec->timestamp;
+    return rec->frame_seq == (n & 0xff) && rec->peer == 0x1000 + (n & 0xff)
+        && rec->value == 1.0f + (n % 1000) * 0.001f;
+}
+
+static void *
+synth_task(void * arg)
+{
+    struct synth * sy = (struct synth *) arg;
+    struct json_stream js;
+    char buf[MYNEWT_VAL(UWB_BRIDGE_MAX_RECORD)];
+    struct timespec next;
+    uint64_t period = 1000000000ull / sy->rate;
+    uint32_t n = 0;
+
+    if (sy->flood) {
+        while (!g_stop) {
+            synth_shm(n++);
+        }
+        return NULL;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (!g_stop) {
+        json_stream_init(&js, buf, sizeof(buf), NULL, NULL);
+        json_stream_object_start(&js);
+        json_stream_key(&js, "utime");
+        json_stream_uint(&js, now_usec());
+        json_stream_key(&js, "twr");
+        json_stream_object_start(&js);
+        json_stream_key(&js, "rng");
+        json_stream_float(&js, 1.0f + (n % 1000) * 0.001f);
+        json_stream_key(&js, "uid");
+        json_stream_hex16(&js, 0x1000 + (n & 0xff));
+        json_stream_object_finish(&js);
+        json_stream_key(&js, "uid");
+        json_stream_hex16(&js, SYNTH_UID);
+        json_stream_object_finish(&js);
+        uwb_bridge_publish(sy->br, UWB_BRIDGE_TYPE_RANGE, buf, js.wr);
+        if (g_shm.hdr) {
+            synth_shm(n);
+        }
+        n++;
+
+        next.tv_nsec += period;
+        while (next.tv_nsec >= 1000000000) {
+            next.tv_nsec -= 1000000000;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+    return NULL;
+}
+
+static void
+print_bridge(struct uwb_bridge_instance * br, uint32_t * last_seq, double secs)
+{
+    uint32_t seq = br->seq;
+    uint32_t delivered = 0, dropped = 0, readers = 0;
+
+    for (int i = 0; i < MYNEWT_VAL(UWB_BRIDGE_MAX_READERS); i++) {
+        if (br->readers[i].active) {
+            readers++;
+            delivered += br->readers[i].delivered;
+            dropped += br->readers[i].dropped;
+        }
+    }
+    fprintf(stderr, "{\"published\": %u,\"rate\": %.0f,\"readers\": %u,\"delivered\": %u,\"dropped\": %u,"
+        "\"latency\": {\"mean\": %.0f,\"max\": %u}}\n",
+        seq, (seq - *last_seq) / secs, readers, delivered, dropped,
+        br->latency.n ? (double) br->latency.sum / br->latency.n : 0.0, br->latency.max);
+    *last_seq = seq;
+    br->latency = (struct uwb_bridge_latency){0};
+}
+
+static void
+print_shm(uint64_t * last_head, double secs)
+{
+    uint64_t head = __atomic_load_n(&g_shm.hdr->head, __ATOMIC_RELAXED);
+
+    fprintf(stderr, "{\"shm\": {\"published\": %llu,\"rate\": %.0f}}\n",
+        (unsigned long long) head, (head - *last_head) / secs);
+    *last_head = head;
+}
+
+static void
+print_tsync(struct uwb_bridge_tsync * ts)
+{
+    fprintf(stderr, "{\"tsync\": {\"locked\": %d,\"offset\": %lld,\"jitter\": %.0f,\"ppm\": %.3f,"
+        "\"delay\": %lld,\"delay_min\": %lld,\"exchanges\": %u,\"rejected\": %u,\"used\": %u,\"steps\": %u,"
+        "\"invalid\": %u}}\n",
+        (ts->clock.flags & UWB_BRIDGE_TSYNC_LOCKED) ? 1 : 0, (long long) ts->stats.error, ts->clock.jitter,
+        ts->clock.rate * 1e6, (long long) ts->stats.delay, (long long) ts->stats.delay_min,
+        ts->stats.exchanges, ts->stats.rejected, ts->stats.used, ts->stats.steps, g_tsync.invalid);
+}
+
+static int
+serve(const char * path, const char * dev, long baud, uint32_t rate, uint32_t interval,
+      const char * shm, bool flood)
+{
+    struct uwb_bridge_instance * br = uwb_bridge_init(NULL);
+    struct serial_line * sl = calloc(1, sizeof(struct serial_line));
+    struct synth sy = {.br = br, .rate = rate, .flood = flood};
+    uint64_t last = now_usec(), last_head = 0;
+    uint32_t last_seq = 0;
+    int fd = -1, rc;
+
+    assert(sl);
+    if (uwb_bridge_unix_open(&g_ux, br, path) != OS_OK) {
+        fprintf(stderr, "uwb_bridge: cannot listen on %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    if (shm && uwb_bridge_shm_create(&g_shm, shm) != OS_OK) {
+        fprintf(stderr, "uwb_bridge: cannot create %s: %s\n", shm, strerror(errno));
+        uwb_bridge_unix_close(&g_ux);
+        return 1;
+    }
+    if (dev && (fd = serial_open(dev, baud)) < 0) {
+        fprintf(stderr, "uwb_bridge: cannot open %s: %s\n", dev, strerror(errno));
+        uwb_bridge_shm_destroy(&g_shm);
+        uwb_bridge_unix_close(&g_ux);
+        return 1;
+    }
+    if (rate || (flood && g_shm.hdr)) {
+        pthread_create(&sy.thread, NULL, synth_task, &sy);
+    }
+
+    while (!g_stop) {
+        rc = uwb_bridge_unix_poll(&g_ux, fd, 100);
+        if (rc < 0) {
+            break;
+        }
+        if (rc == 1 && serial_read(br, fd, sl) < 0) {
+            fprintf(stderr, "uwb_bridge: %s closed\n", dev);
+            break;
+        }
+        if (fd >= 0 && g_tsync.period && now_nsec() >= g_tsync.next) {
+            tsync_request(&g_tsync, fd);
+        }
+        if (interval && now_usec() - last >= interval * 1000000ull) {
+            print_bridge(br, &last_seq, (now_usec() - last) / 1e6);
+            if (g_shm.hdr) {
+                print_shm(&last_head, (now_usec() - last) / 1e6);
+            }
+            if (g_tsync.period) {
+                print_tsync(&g_tsync.ts);
+            }
+            last = now_usec();
+        }
+    }
+
+    g_stop = 1;
+    if (rate || (flood && g_shm.hdr)) {
+        pthread_join(sy.thread, NULL);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    uwb_bridge_shm_destroy(&g_shm);
+    uwb_bridge_unix_close(&g_ux);
+    uwb_bridge_free(br);
+    free(sl);
+    return 0;
+}
+
+static int
+consume(const char * path, uint32_t interval)
+{
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    char buf[8192], line[MYNEWT_VAL(UWB_BRIDGE_MAX_RECORD) + 32];
+    uint64_t records = 0, dropped = 0, lat_sum = 0, lat_n = 0, lat_max = 0;
+    uint64_t last = now_usec(), last_records = 0;
+    uint16_t len = 0;
+    int fd;
+
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        fprintf(stderr, "uwb_bridge: cannot connect to %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    while (!g_stop) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) {
+            break;
+        }
+        for (ssize_t i = 0; i < n; i++) {
+            if (buf[i] != '\n') {
+                if (len < sizeof(line) - 1) {
+                    line[len++] = buf[i];
+                }
+                continue;
+            }
+            line[len] = '\0';
+            if (!strncmp(line, "{\"dropped\": ", 12)) {
+                dropped += strtoull(line + 12, NULL, 10);
+            } else {
+                records++;
+                if (!strncmp(line, "{\"utime\": ", 10)) {
+                    uint64_t t = strtoull(line + 10, NULL, 10), now = now_usec();
+                    if (now >= t && now - t < 10000000u) {
+                        lat_sum += now - t;
+                        lat_n++;
+                        if (now - t > lat_max) {
+                            lat_max = now - t;
+                        }
+                    }
+                }
+            }
+            len = 0;
+        }
+        if (interval && now_usec() - last >= interval * 1000000ull) {
+            double secs = (now_usec() - last) / 1e6;
+            printf("{\"records\": %llu,\"rate\": %.0f,\"dropped\": %llu,\"latency\": {\"mean\": %.1f,\"max\": %llu}}\n",
+                (unsigned long long) records, (records - last_records) / secs, (unsigned long long) dropped,
+                lat_n ? (double) lat_sum / lat_n : 0.0, (unsigned long long) lat_max);
+            fflush(stdout);
+            last = now_usec();
+            last_records = records;
+            lat_sum = lat_n = lat_max = 0;
+        }
+    }
+    close(fd);
+    return 0;
+}
+
+static int
+consume_shm(const char * name, uint32_t interval)
+{
+    struct uwb_bridge_shm_reader rd;
+    struct uwb_bridge_shm_rec rec;
+    struct uwb_bridge_tsync_clock clock;
+    uint64_t last = now_usec(), last_delivered = 0, lost = 0, prev = 0;
+    uint64_t order = 0, accounting = 0, torn = 0, lat_sum = 0, lat_n = 0, lat_max = 0;
+    uint64_t start;
+    bool first = true;
+    int rc;
+
+    if (uwb_bridge_shm_open(&rd, name, false) != OS_OK) {
+        fprintf(stderr, "uwb_bridge: cannot open %s\n", name);
+        return 1;
+    }
+    start = rd.cursor;
+    while (!g_stop) {
+        rc = uwb_bridge_shm_read(&rd, &rec);
+        if (rc < 0) {
+            break;
+        }
+        if (rc == 0) {
+            /* Caught up, let the producer run */
+            sched_yield();
+        } else {
+            /* Records only advance, by one plus the records lost in between */
+            if (!first) {
+                if (rec.seq <= prev) {
+                    order++;
+                } else if (rec.seq - prev - 1 != rd.lost - lost) {
+                    accounting++;
+                }
+            }
+            first = false;
+            prev = rec.seq;
+            lost = rd.lost;
+            if (rec.uid == SYNTH_UID && !synth_shm_check(&rec)) {
+                torn++;
+            }
+            if ((rd.delivered & 0xff) == 0) {
+                uint64_t now = now_usec();
+                if (now >= rec.utime && now - rec.utime < 10000000u) {
+                    lat_sum += now - rec.utime;
+                    lat_n++;
+                    if (now - rec.utime > lat_max) {
+                        lat_max = now - rec.utime;
+                    }
+                }
+            }
+        }
+        if (interval && (rc == 0 || (rd.delivered & 0xfff) == 0) && now_usec() - last >= interval * 1000000ull) {
+            double secs = (now_usec() - last) / 1e6;
+            printf("{\"records\": %llu,\"rate\": %.0f,\"lost\": %llu,\"errors\": {\"order\": %llu,\"accounting\": %llu,\"torn\": %llu},"
+                "\"latency\": {\"mean\": %.1f,\"max\": %llu}}\n",
+                (unsigned long long) rd.delivered, (rd.delivered - last_delivered) / secs, (unsigned long long) rd.lost,
+                (unsigned long long) order, (unsigned long long) accounting, (unsigned long long) torn,
+                lat_n ? (double) lat_sum / lat_n : 0.0, (unsigned long long) lat_max);
+            if ((rc = uwb_bridge_shm_get_clock(&rd, &clock)) >= 0) {
+                // Master time now of the clock the producer disciplines
+                printf("{\"clock\": {\"locked\": %d,\"master\": %lld,\"ppm\": %.3f,\"jitter\": %.0f}}\n",
+                    rc, (long long) uwb_bridge_tsync_to_master(&clock, now_nsec()), clock.rate * 1e6, clock.jitter);
+            }
+            fflush(stdout);
+            last = now_usec();
+            last_delivered = rd.delivered;
+            lat_sum = lat_n = lat_max = 0;
+        }
+    }
+    if (rd.delivered + rd.lost != rd.cursor - start) {
+        accounting++;
+    }
+    printf("{\"records\": %llu,\"lost\": %llu,\"passed\": %llu,\"errors\": {\"order\": %llu,\"accounting\": %llu,\"torn\": %llu}}\n",
+        (unsigned long long) rd.delivered, (unsigned long long) rd.lost, (unsigned long long) (rd.cursor - start),
+        (unsigned long long) order, (unsigned long long) accounting, (unsigned long long) torn);
+    uwb_bridge_shm_close(&rd);
+    return (order || accounting || torn) ? 1 : 0;
+}
+
+/* Exponential queueing delay of mean ns */
+static int64_t
+sim_queue(double mean)
+{
+    return (int64_t)(-mean * log(1.0 - drand48()));
+}
+
+static int
+tsync_sim(uint32_t jitter, uint32_t period, uint32_t interval)
+{
+    struct uwb_bridge_tsync * ts = &g_tsync.ts;
+    const double drift = 40e-6;                        // Master runs fast
+    const int64_t master0 = 123456789012345ll;         // Master time at host 0
+    const int64_t base = 150000, turnaround = 80000;   // Fixed path and node delays, ns
+    const int64_t asymmetry = 30000;                   // Request minus reply path, known
+    double sum = 0, bound = jitter * 1000.0 / 4;
+    uint64_t n = 0;
+    int64_t host = 1000000000, next_print = host + interval * 1000000000ll;
+
+    srand48(1);
+    uwb_bridge_tsync_init(ts);
+    ts->asymmetry = asymmetry;
+    for (; host < 3600 * 1000000000ll; host += period * 1000000ll) {
+        int64_t t1 = host;
+        int64_t rx = t1 + base + asymmetry / 2 + sim_queue(jitter * 1000.0);
+        int64_t t2 = master0 + rx + (int64_t)(rx * drift);
+        int64_t t3 = t2 + turnaround;
+        int64_t tx = rx + (int64_t)(turnaround / (1 + drift));
+        int64_t t4 = tx + base - asymmetry / 2 + sim_queue(jitter * 1000.0);
+
+        uwb_bridge_tsync_update(ts, t1, t2, t3, t4);
+        if (ts->clock.flags & UWB_BRIDGE_TSYNC_LOCKED) {
+            // Converged after a few minutes
+            int64_t error = uwb_bridge_tsync_to_master(&ts->clock, t4) - (master0 + t4 + (int64_t)(t4 * drift));
+            if (host > 600 * 1000000000ll) {
+                sum += (double) error * error;
+                n++;
+            }
+            if (interval && host >= next_print) {
+                fprintf(stderr, "{\"utime\": %lld,\"error\": %lld,\"ppm_error\": %.4f}\n",
+                    (long long)(host / 1000), (long long) error, ts->clock.rate * 1e6 - drift * 1e6);
+                print_tsync(ts);
+                next_print += interval * 1000000000ll;
+            }
+        }
+    }
+    fprintf(stderr, "{\"tsync_sim\": {\"jitter\": %u,\"rms_error\": %.0f,\"bound\": %.0f}}\n",
+        jitter * 1000, n ? sqrt(sum / n) : -1.0, bound);
+    return (n && sqrt(sum / n) <= bound) ? 0 : 1;
+}
+
+int main(int argc, char **argv){
+    const char * path = "/tmp/uwb_bridge.sock", * dev = NULL, * consumer = NULL;
+    const char * shm = NULL, * shm_consumer = NULL;
+    bool flood = false;
+    long baud = 115200;
+    uint32_t rate = 0, interval = 0, sim_jitter = 0;
+    bool uart = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:d:b:l:t:c:m:kM:y:uY:")) != -1) {
+        switch (opt) {
+            case 's': path = optarg; break;
+            case 'd': dev = optarg; break;
+            case 'b': baud = strtol(optarg, NULL, 0); break;
+            case 'l': rate = strtoul(optarg, NULL, 0); break;
+            case 't': interval = strtoul(optarg, NULL, 0); break;
+            case 'c': consumer = optarg; break;
+            case 'm': shm = optarg; break;
+            case 'k': flood = true; break;
+            case 'M': shm_consumer = optarg; break;
+            case 'y': g_tsync.period = strtoul(optarg, NULL, 0); break;
+            case 'u': uart = true; break;
+            case 'Y': sim_jitter = strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-s socket] [-d tty [-y ms [-u]]] [-b baud] [-l rate] [-t secs] [-m shm [-k]]\n"
+                                "       %s -c socket [-t secs]\n"
+                                "       %s -M shm [-t secs]\n"
+                                "       %s -Y jitter [-y ms] [-t secs]\n", argv[0], argv[0], argv[0], argv[0]);
+                return 2;
+        }
+    }
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (consumer) {
+        return consume(consumer, interval);
+    }
+    if (shm_consumer) {
+        return consume_shm(shm_consumer, interval);
+    }
+    if (sim_jitter) {
+        return tsync_sim(sim_jitter, g_tsync.period ? g_tsync.period : 1000, interval);
+    }
+    uwb_bridge_tsync_init(&g_tsync.ts);
+    if (uart) {
+        // 10 bits a character, start and stop
+        g_tsync.char_ns = 10000000000ll / baud;
+    }
+    return serve(path, dev, baud, rate, interval, shm, flood);
+}
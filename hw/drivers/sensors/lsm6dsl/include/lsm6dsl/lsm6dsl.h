@@ -72,7 +72,23 @@ enum lsm6dsl_gyro_rate {
 };
     
 #define LSM6DSL_WHO_AM_I_VAL 0x6A
-    
+
+#define LSM6DSL_FIFO_MAX_SAMPLES (MYNEWT_VAL(LSM6DSL_FIFO_MAX_SAMPLES))
+
+/* One gyro/accel pair out of the fifo, timestamp in os_cputime ticks
+ * reconstructed from the fifo output data rate */
+struct lsm6dsl_fifo_sample {
+    int16_t gyro[3];
+    int16_t acc[3];
+    uint32_t timestamp;
+};
+
+struct lsm6dsl;
+
+/* Called with each burst read from the fifo */
+typedef void (*lsm6dsl_fifo_cb_t)(struct lsm6dsl *dev, struct lsm6dsl_fifo_sample *samples,
+                                  uint16_t nsamples, void *arg);
+
 struct lsm6dsl_cfg {
     enum lsm6dsl_accel_range accel_range;
     enum lsm6dsl_accel_rate accel_rate;
@@ -80,6 +96,7 @@ struct lsm6dsl_cfg {
     enum lsm6dsl_gyro_rate gyro_rate;
     uint8_t int_enable;
     uint8_t lpf_cfg;     /* See LSM6DSL_CTRL8_XL control reg in datasheet */
+    uint16_t fifo_wtm;   /* Fifo watermark in samples, 0 disables fifo mode */
     sensor_type_t mask;
 };
 
@@ -91,6 +108,9 @@ struct lsm6dsl {
     struct os_mutex *bus_mutex;
     struct lsm6dsl_cfg cfg;
     os_time_t last_read_time;
+    lsm6dsl_fifo_cb_t fifo_cb;
+    void *fifo_cb_arg;
+    struct lsm6dsl_fifo_sample fifo[LSM6DSL_FIFO_MAX_SAMPLES];
 };
 
 int lsm6dsl_reset(struct lsm6dsl *dev);
@@ -112,6 +132,12 @@ int lsm6dsl_init(struct os_dev *, void *);
 int lsm6dsl_config(struct lsm6dsl *, struct lsm6dsl_cfg *);
 
 int lsm6dsl_read_raw(struct lsm6dsl *dev, int16_t gyro[], int16_t acc[]);
+
+int lsm6dsl_fifo_config(struct lsm6dsl *dev, uint16_t wtm);
+int lsm6dsl_fifo_set_cb(struct lsm6dsl *dev, lsm6dsl_fifo_cb_t cb, void *arg);
+int lsm6dsl_fifo_count(struct lsm6dsl *dev, uint16_t *nsamples, uint8_t *overrun);
+int lsm6dsl_fifo_read(struct lsm6dsl *dev, struct lsm6dsl_fifo_sample *samples,
+    uint16_t max_samples, uint16_t *nsamples);
     
 #ifdef __cplusplus
 }
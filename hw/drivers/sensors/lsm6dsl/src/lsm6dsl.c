@@ -46,6 +46,10 @@ STATS_SECT_START(lsm6dsl_stats)
     STATS_SECT_ENTRY(read_errors)
     STATS_SECT_ENTRY(write_errors)
     STATS_SECT_ENTRY(mutex_errors)
+    STATS_SECT_ENTRY(bus_xfers)
+    STATS_SECT_ENTRY(fifo_reads)
+    STATS_SECT_ENTRY(fifo_samples)
+    STATS_SECT_ENTRY(fifo_overruns)
 STATS_SECT_END
 
 /* Global variable used to hold stats data */
@@ -56,6 +60,10 @@ STATS_NAME_START(lsm6dsl_stats)
     STATS_NAME(lsm6dsl_stats, read_errors)
     STATS_NAME(lsm6dsl_stats, write_errors)
     STATS_NAME(lsm6dsl_stats, mutex_errors)
+    STATS_NAME(lsm6dsl_stats, bus_xfers)
+    STATS_NAME(lsm6dsl_stats, fifo_reads)
+    STATS_NAME(lsm6dsl_stats, fifo_samples)
+    STATS_NAME(lsm6dsl_stats, fifo_overruns)
 STATS_NAME_END(lsm6dsl_stats)
 
 #define LOG_MODULE_LSM6DSL    (80)
@@ -74,6 +82,11 @@ static const struct sensor_driver g_lsm6dsl_sensor_driver = {
     lsm6dsl_sensor_get_config
 };
 
+/* Output data rates in 0.1Hz, indexed by the ODR field of CTRL1_XL/CTRL2_G/FIFO_CTRL5 */
+static const uint32_t lsm6dsl_odr_dhz[] = {
+    0, 125, 260, 520, 1040, 2080, 4160, 8330, 16600, 33300, 66600
+};
+
 /**
  * Writes a single byte to the specified register
  *
@@ -101,6 +114,7 @@ lsm6dsl_write8(struct lsm6dsl *dev, uint8_t reg, uint32_t value)
         }
     }
 
+    STATS_INC(g_lsm6dsl_stats, bus_xfers);
 #if MYNEWT_VAL(LSM6DSL_USE_SPI)
     rc=0;
     hal_gpio_write(itf->si_cs_pin, 0);
@@ -164,6 +178,7 @@ lsm6dsl_read8(struct lsm6dsl *dev, uint8_t reg, uint8_t *value)
         }
     }
 
+    STATS_INC(g_lsm6dsl_stats, bus_xfers);
 #if MYNEWT_VAL(LSM6DSL_USE_SPI)
     rc=0;
     hal_gpio_write(itf->si_cs_pin, 0);
@@ -239,6 +254,7 @@ lsm6dsl_read_bytes(struct lsm6dsl *dev, uint8_t reg, uint8_t *buffer, uint32_t l
         }
     }
 
+    STATS_INC(g_lsm6dsl_stats, bus_xfers);
 #if MYNEWT_VAL(LSM6DSL_USE_SPI)
     int i;
     rc=0;
@@ -390,7 +406,187 @@ lsm6dsl_enable_interrupt(struct lsm6dsl *dev, uint8_t enable)
     if (rc) {
         return rc;
     }
-    return lsm6dsl_write8(dev, LSM6DSL_INT1_CTRL, (enable)? 0x03 : 0x00);
+    if (!enable) {
+        return lsm6dsl_write8(dev, LSM6DSL_INT1_CTRL, 0x00);
+    }
+    /* In fifo mode only interrupt on the watermark */
+    return lsm6dsl_write8(dev, LSM6DSL_INT1_CTRL,
+                          (dev->cfg.fifo_wtm) ? LSM6DSL_INT1_FTH : LSM6DSL_INT1_DRDY);
+}
+
+/**
+ * Configures the fifo in continuous mode with a watermark. Gyro and accel
+ * samples are stored without decimation at the accelerometer output data rate,
+ * gyro and accel rates should therefore be set equal.
+ *
+ * @param The device
+ * @param Watermark in samples, 0 disables the fifo (bypass mode)
+ *
+ * @return 0 on success, non-zero error on failure.
+ */
+int
+lsm6dsl_fifo_config(struct lsm6dsl *dev, uint16_t wtm)
+{
+    int rc;
+    uint16_t words;
+    uint8_t odr;
+
+    if (wtm > LSM6DSL_FIFO_MAX_SAMPLES) {
+        wtm = LSM6DSL_FIFO_MAX_SAMPLES;
+    }
+
+    /* Bypass mode also empties the fifo */
+    rc = lsm6dsl_write8(dev, LSM6DSL_FIFO_CTRL5, LSM6DSL_FIFO_MODE_BYPASS);
+    if (rc) {
+        return rc;
+    }
+    dev->cfg.fifo_wtm = wtm;
+
+    if (wtm) {
+        words = wtm * LSM6DSL_FIFO_WORDS_PER_SAMPLE;
+        rc = lsm6dsl_write8(dev, LSM6DSL_FIFO_CTRL1, words & 0xFF);
+        if (rc) {
+            return rc;
+        }
+        rc = lsm6dsl_write8(dev, LSM6DSL_FIFO_CTRL2, (words >> 8) & 0x07);
+        if (rc) {
+            return rc;
+        }
+        rc = lsm6dsl_write8(dev, LSM6DSL_FIFO_CTRL3,
+                            LSM6DSL_FIFO_DEC_GYRO_NONE | LSM6DSL_FIFO_DEC_XL_NONE);
+        if (rc) {
+            return rc;
+        }
+        odr = ((uint8_t)dev->cfg.accel_rate) >> 4;
+        rc = lsm6dsl_write8(dev, LSM6DSL_FIFO_CTRL5,
+                            (odr << 3) | LSM6DSL_FIFO_MODE_CONTINUOUS);
+        if (rc) {
+            return rc;
+        }
+    }
+
+    return lsm6dsl_enable_interrupt(dev, dev->cfg.int_enable);
+}
+
+/**
+ * Sets a callback receiving every burst read from the fifo through the
+ * sensor read path.
+ *
+ * @param The device
+ * @param Callback, NULL to remove
+ * @param Argument passed to the callback
+ *
+ * @return 0 on success
+ */
+int
+lsm6dsl_fifo_set_cb(struct lsm6dsl *dev, lsm6dsl_fifo_cb_t cb, void *arg)
+{
+    dev->fifo_cb = cb;
+    dev->fifo_cb_arg = arg;
+    return 0;
+}
+
+/**
+ * Reads the number of complete samples waiting in the fifo.
+ *
+ * @param The device
+ * @param Pointer to number of samples
+ * @param Pointer to overrun flag, may be NULL
+ *
+ * @return 0 on success, non-zero error on failure.
+ */
+int
+lsm6dsl_fifo_count(struct lsm6dsl *dev, uint16_t *nsamples, uint8_t *overrun)
+{
+    int rc;
+    uint8_t status[2];
+
+    rc = lsm6dsl_read_bytes(dev, LSM6DSL_FIFO_STATUS1, status, sizeof(status));
+    if (rc) {
+        return rc;
+    }
+
+    *nsamples = (((uint16_t)(status[1] & LSM6DSL_FIFO_STATUS2_DIFF_MASK) << 8) | status[0])
+        / LSM6DSL_FIFO_WORDS_PER_SAMPLE;
+    if (overrun) {
+        *overrun = (status[1] & LSM6DSL_FIFO_STATUS2_OVER_RUN) != 0;
+    }
+    return 0;
+}
+
+/**
+ * Drains up to max_samples from the fifo in a single burst read. The fifo
+ * output registers roll back automatically so the whole batch is one bus
+ * transaction. Timestamps are reconstructed backwards from the time of
+ * the read using the fifo output data rate.
+ *
+ * @param The device
+ * @param Array receiving the samples
+ * @param Size of the array
+ * @param Pointer to number of samples read
+ *
+ * @return 0 on success, non-zero error on failure.
+ */
+int
+lsm6dsl_fifo_read(struct lsm6dsl *dev, struct lsm6dsl_fifo_sample *samples,
+                  uint16_t max_samples, uint16_t *nsamples)
+{
+    int rc;
+    int i;
+    uint16_t count, n;
+    uint8_t overrun;
+    uint8_t *raw = (uint8_t *)samples;
+    uint32_t now, period = 0;
+    uint8_t odr;
+
+    *nsamples = 0;
+    rc = lsm6dsl_fifo_count(dev, &count, &overrun);
+    if (rc) {
+        return rc;
+    }
+    if (overrun) {
+        STATS_INC(g_lsm6dsl_stats, fifo_overruns);
+    }
+
+    n = (count < max_samples) ? count : max_samples;
+    if (n == 0) {
+        return 0;
+    }
+
+    /* Raw fifo data is unpacked in place, back to front */
+    rc = lsm6dsl_read_bytes(dev, LSM6DSL_FIFO_DATA_OUT_L, raw,
+                            n * LSM6DSL_FIFO_WORDS_PER_SAMPLE * 2);
+    if (rc) {
+        return rc;
+    }
+    now = os_cputime_get32();
+
+    odr = ((uint8_t)dev->cfg.accel_rate) >> 4;
+    if (odr && odr < sizeof(lsm6dsl_odr_dhz)/sizeof(lsm6dsl_odr_dhz[0])) {
+        period = os_cputime_usecs_to_ticks(10000000UL / lsm6dsl_odr_dhz[odr]);
+    }
+
+    for (i = n - 1; i >= 0; i--) {
+        uint8_t *p = raw + i * LSM6DSL_FIFO_WORDS_PER_SAMPLE * 2;
+        int16_t v[LSM6DSL_FIFO_WORDS_PER_SAMPLE];
+        int j;
+        for (j = 0; j < LSM6DSL_FIFO_WORDS_PER_SAMPLE; j++) {
+            v[j] = (int16_t)((p[2*j + 1] << 8) | p[2*j]);
+        }
+        /* Gyro is the first data set in the fifo pattern */
+        samples[i].gyro[0] = v[0];
+        samples[i].gyro[1] = v[1];
+        samples[i].gyro[2] = v[2];
+        samples[i].acc[0] = v[3];
+        samples[i].acc[1] = v[4];
+        samples[i].acc[2] = v[5];
+        samples[i].timestamp = now - (count - 1 - i) * period;
+    }
+
+    STATS_INC(g_lsm6dsl_stats, fifo_reads);
+    STATS_INCN(g_lsm6dsl_stats, fifo_samples, n);
+    *nsamples = n;
+    return 0;
 }
 
 
@@ -508,11 +704,11 @@ lsm6dsl_config(struct lsm6dsl *lsm, struct lsm6dsl_cfg *cfg)
         return rc;
     }
     
-    rc = lsm6dsl_enable_interrupt(lsm, cfg->int_enable);
+    lsm->cfg.int_enable = cfg->int_enable;
+    rc = lsm6dsl_fifo_config(lsm, cfg->fifo_wtm);
     if (rc) {
         return rc;
     }
-    lsm->cfg.int_enable = cfg->int_enable;
         
     rc = sensor_set_type_mask(&(lsm->sensor), cfg->mask);
     if (rc) {
@@ -557,73 +753,60 @@ lsm6dsl_read_raw(struct lsm6dsl *dev, int16_t gyro[], int16_t acc[])
 }
 
 
+static float
+lsm6dsl_accel_lsb(enum lsm6dsl_accel_range range)
+{
+    switch (range) {
+        case LSM6DSL_ACCEL_RANGE_2: /* +/- 2g - 16384 LSB/g */
+        /* Falls through */
+        default:
+            return 16384.0F;
+        case LSM6DSL_ACCEL_RANGE_4: /* +/- 4g - 8192 LSB/g */
+            return 8192.0F;
+        case LSM6DSL_ACCEL_RANGE_8: /* +/- 8g - 4096 LSB/g */
+            return 4096.0F;
+        case LSM6DSL_ACCEL_RANGE_16: /* +/- 16g - 2048 LSB/g */
+            return 2048.0F;
+    }
+}
+
+static float
+lsm6dsl_gyro_lsb(enum lsm6dsl_gyro_range range)
+{
+    switch (range) {
+        case LSM6DSL_GYRO_RANGE_245: /* +/- 245 Deg/s - 133 LSB/Deg/s */
+        /* Falls through */
+        default:
+            return 131.0F;
+        case LSM6DSL_GYRO_RANGE_500: /* +/- 500 Deg/s - 65.5 LSB/Deg/s */
+            return 65.5F;
+        case LSM6DSL_GYRO_RANGE_1000: /* +/- 1000 Deg/s - 32.8 LSB/Deg/s */
+            return 32.8F;
+        case LSM6DSL_GYRO_RANGE_2000: /* +/- 2000 Deg/s - 16.4 LSB/Deg/s */
+            return 16.4F;
+    }
+}
+
 static int
-lsm6dsl_sensor_read(struct sensor *sensor, sensor_type_t type,
-        sensor_data_func_t data_func, void *data_arg, uint32_t timeout)
+lsm6dsl_sensor_deliver(struct sensor *sensor, struct lsm6dsl *lsm, sensor_type_t type,
+        sensor_data_func_t data_func, void *data_arg, int16_t gyro[], int16_t acc[])
 {
-    (void)timeout;
     int rc;
-    int16_t x, y, z;
-    uint8_t payload[14];
     float lsb;
-    struct lsm6dsl *lsm;
     union {
         struct sensor_accel_data sad;
         struct sensor_gyro_data sgd;
     } databuf;
 
-    memset(payload, 0, sizeof(payload));
-    
-    /* If the read isn't looking for accel or gyro, don't do anything. */
-    if (!(type & SENSOR_TYPE_ACCELEROMETER) &&
-       (!(type & SENSOR_TYPE_GYROSCOPE))) {
-        return SYS_EINVAL;
-    }
-
-    lsm = (struct lsm6dsl *) SENSOR_GET_DEVICE(sensor);
-
-    if (type & (SENSOR_TYPE_ACCELEROMETER|SENSOR_TYPE_GYROSCOPE)) {
-#if 1
-        rc = lsm6dsl_read_bytes(lsm, LSM6DSL_OUT_TEMP_L, payload, 14);
-#else
-        for (int i=0;i<14;i++) {
-            rc = lsm6dsl_read8(lsm, LSM6DSL_OUT_TEMP_L+i, payload+i);
-        }
-#endif
-        if (rc) {
-            return rc;
-        }
-    }
-
-    
     /* Get a new accelerometer sample */
     if (type & SENSOR_TYPE_ACCELEROMETER) {
-        x = (((int16_t)payload[9] << 8) | payload[8]);
-        y = (((int16_t)payload[11] << 8) | payload[10]);
-        z = (((int16_t)payload[13] << 8) | payload[12]);
-
-        switch (lsm->cfg.accel_range) {
-            case LSM6DSL_ACCEL_RANGE_2: /* +/- 2g - 16384 LSB/g */
-            /* Falls through */
-            default:
-                lsb = 16384.0F;
-            break;
-            case LSM6DSL_ACCEL_RANGE_4: /* +/- 4g - 8192 LSB/g */
-                lsb = 8192.0F;
-            break;
-            case LSM6DSL_ACCEL_RANGE_8: /* +/- 8g - 4096 LSB/g */
-                lsb = 4096.0F;
-            break;
-            case LSM6DSL_ACCEL_RANGE_16: /* +/- 16g - 2048 LSB/g */
-                lsb = 2048.0F;
-            break;
-        }
+        lsb = lsm6dsl_accel_lsb(lsm->cfg.accel_range);
 
-        databuf.sad.sad_x = (x / lsb) * STANDARD_ACCEL_GRAVITY;
+        databuf.sad.sad_x = (acc[0] / lsb) * STANDARD_ACCEL_GRAVITY;
         databuf.sad.sad_x_is_valid = 1;
-        databuf.sad.sad_y = (y / lsb) * STANDARD_ACCEL_GRAVITY;
+        databuf.sad.sad_y = (acc[1] / lsb) * STANDARD_ACCEL_GRAVITY;
         databuf.sad.sad_y_is_valid = 1;
-        databuf.sad.sad_z = (z / lsb) * STANDARD_ACCEL_GRAVITY;
+        databuf.sad.sad_z = (acc[2] / lsb) * STANDARD_ACCEL_GRAVITY;
         databuf.sad.sad_z_is_valid = 1;
 
         rc = data_func(sensor, data_arg, &databuf.sad,
@@ -635,32 +818,13 @@ lsm6dsl_sensor_read(struct sensor *sensor, sensor_type_t type,
 
     /* Get a new gyroscope sample */
     if (type & SENSOR_TYPE_GYROSCOPE) {
-        x = (int16_t)((payload[3] << 8) | payload[2]);
-        y = (int16_t)((payload[5] << 8) | payload[4]);
-        z = (int16_t)((payload[7] << 8) | payload[6]);
-
-        switch (lsm->cfg.gyro_range) {
-            case LSM6DSL_GYRO_RANGE_245: /* +/- 245 Deg/s - 133 LSB/Deg/s */
-            /* Falls through */
-            default:
-                lsb = 131.0F;
-            break;
-            case LSM6DSL_GYRO_RANGE_500: /* +/- 500 Deg/s - 65.5 LSB/Deg/s */
-                lsb = 65.5F;
-            break;
-            case LSM6DSL_GYRO_RANGE_1000: /* +/- 1000 Deg/s - 32.8 LSB/Deg/s */
-                lsb = 32.8F;
-            break;
-            case LSM6DSL_GYRO_RANGE_2000: /* +/- 2000 Deg/s - 16.4 LSB/Deg/s */
-                lsb = 16.4F;
-            break;
-        }
+        lsb = lsm6dsl_gyro_lsb(lsm->cfg.gyro_range);
 
-        databuf.sgd.sgd_x = x / lsb;
+        databuf.sgd.sgd_x = gyro[0] / lsb;
         databuf.sgd.sgd_x_is_valid = 1;
-        databuf.sgd.sgd_y = y / lsb;
+        databuf.sgd.sgd_y = gyro[1] / lsb;
         databuf.sgd.sgd_y_is_valid = 1;
-        databuf.sgd.sgd_z = z / lsb;
+        databuf.sgd.sgd_z = gyro[2] / lsb;
         databuf.sgd.sgd_z_is_valid = 1;
 
         rc = data_func(sensor, data_arg, &databuf.sgd, SENSOR_TYPE_GYROSCOPE);
@@ -672,6 +836,51 @@ lsm6dsl_sensor_read(struct sensor *sensor, sensor_type_t type,
     return 0;
 }
 
+static int
+lsm6dsl_sensor_read(struct sensor *sensor, sensor_type_t type,
+        sensor_data_func_t data_func, void *data_arg, uint32_t timeout)
+{
+    (void)timeout;
+    int rc;
+    uint16_t i, n;
+    int16_t gyro[3], acc[3];
+    struct lsm6dsl *lsm;
+
+    /* If the read isn't looking for accel or gyro, don't do anything. */
+    if (!(type & SENSOR_TYPE_ACCELEROMETER) &&
+       (!(type & SENSOR_TYPE_GYROSCOPE))) {
+        return SYS_EINVAL;
+    }
+
+    lsm = (struct lsm6dsl *) SENSOR_GET_DEVICE(sensor);
+
+    /* In fifo mode deliver the whole batch from one burst read */
+    if (lsm->cfg.fifo_wtm) {
+        rc = lsm6dsl_fifo_read(lsm, lsm->fifo, LSM6DSL_FIFO_MAX_SAMPLES, &n);
+        if (rc) {
+            return rc;
+        }
+        if (n && lsm->fifo_cb) {
+            lsm->fifo_cb(lsm, lsm->fifo, n, lsm->fifo_cb_arg);
+        }
+        for (i = 0; i < n; i++) {
+            rc = lsm6dsl_sensor_deliver(sensor, lsm, type, data_func, data_arg,
+                                        lsm->fifo[i].gyro, lsm->fifo[i].acc);
+            if (rc) {
+                return rc;
+            }
+        }
+        return 0;
+    }
+
+    rc = lsm6dsl_read_raw(lsm, gyro, acc);
+    if (rc) {
+        return rc;
+    }
+
+    return lsm6dsl_sensor_deliver(sensor, lsm, type, data_func, data_arg, gyro, acc);
+}
+
 static int
 lsm6dsl_sensor_get_config(struct sensor *sensor, sensor_type_t type,
         struct sensor_cfg *cfg)
@@ -132,6 +132,24 @@ enum lsm6dsl_registers {
     LSM6DSL_Z_OFS_USR                   = 0x75,
 };
 
+/* FIFO_CTRL3 */
+#define LSM6DSL_FIFO_DEC_GYRO_NONE      (0x01 << 3)
+#define LSM6DSL_FIFO_DEC_XL_NONE        (0x01)
+/* FIFO_CTRL5 */
+#define LSM6DSL_FIFO_MODE_BYPASS        (0x00)
+#define LSM6DSL_FIFO_MODE_CONTINUOUS    (0x06)
+/* FIFO_STATUS2 */
+#define LSM6DSL_FIFO_STATUS2_WTM        (0x80)
+#define LSM6DSL_FIFO_STATUS2_OVER_RUN   (0x40)
+#define LSM6DSL_FIFO_STATUS2_EMPTY      (0x10)
+#define LSM6DSL_FIFO_STATUS2_DIFF_MASK  (0x07)
+/* INT1_CTRL */
+#define LSM6DSL_INT1_FTH                (0x08)
+#define LSM6DSL_INT1_DRDY               (0x03)
+
+/* Fifo words (16 bit) per gyro/accel sample */
+#define LSM6DSL_FIFO_WORDS_PER_SAMPLE   (6)
+
 int lsm6dsl_write8(struct lsm6dsl *dev, uint8_t reg, uint32_t value);
 int lsm6dsl_read8(struct lsm6dsl *dev, uint8_t reg, uint8_t *value);
 int lsm6dsl_read_bytes(struct lsm6dsl *dev, uint8_t reg, uint8_t *buffer, uint32_t length);
@@ -0,0 +1,162 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "lsm6dsl_test.h"
+
+struct lsm6dsl_sim g_lsm6dsl_sim;
+
+void
+lsm6dsl_sim_reset(void)
+{
+    memset(&g_lsm6dsl_sim, 0, sizeof(g_lsm6dsl_sim));
+    g_lsm6dsl_sim.regs[LSM6DSL_WHO_AM_I] = LSM6DSL_WHO_AM_I_VAL;
+}
+
+/**
+ * One output data rate period of the device, in continuous mode the fifo
+ * stores the gyro data set followed by the accel data set.
+ */
+void
+lsm6dsl_sim_sample(const int16_t gyro[3], const int16_t acc[3])
+{
+    struct lsm6dsl_sim *sim = &g_lsm6dsl_sim;
+    int i;
+
+    if ((sim->regs[LSM6DSL_FIFO_CTRL5] & 0x07) != LSM6DSL_FIFO_MODE_CONTINUOUS) {
+        return;
+    }
+    if (sim->fifo_len + LSM6DSL_FIFO_WORDS_PER_SAMPLE > LSM6DSL_SIM_FIFO_WORDS) {
+        /* Continuous mode drops the oldest sample */
+        memmove(sim->fifo, sim->fifo + LSM6DSL_FIFO_WORDS_PER_SAMPLE,
+                (sim->fifo_len - LSM6DSL_FIFO_WORDS_PER_SAMPLE) * 2);
+        sim->fifo_len -= LSM6DSL_FIFO_WORDS_PER_SAMPLE;
+        sim->overrun = 1;
+    }
+    for (i = 0; i < 3; i++) {
+        sim->fifo[sim->fifo_len++] = (uint16_t)gyro[i];
+    }
+    for (i = 0; i < 3; i++) {
+        sim->fifo[sim->fifo_len++] = (uint16_t)acc[i];
+    }
+}
+
+static uint8_t
+sim_fifo_byte(void)
+{
+    struct lsm6dsl_sim *sim = &g_lsm6dsl_sim;
+    uint16_t w;
+
+    if (sim->fifo_len == 0) {
+        return 0;
+    }
+    w = sim->fifo[0];
+    if (sim->fifo_byte) {
+        memmove(sim->fifo, sim->fifo + 1, --sim->fifo_len * 2);
+    }
+    sim->fifo_byte ^= 1;
+    return (sim->fifo_byte) ? w & 0xff : w >> 8;
+}
+
+static uint8_t
+sim_read(void)
+{
+    struct lsm6dsl_sim *sim = &g_lsm6dsl_sim;
+    uint8_t v;
+
+    switch (sim->ptr) {
+    case LSM6DSL_FIFO_DATA_OUT_L:
+        v = sim_fifo_byte();
+        break;
+    case LSM6DSL_FIFO_DATA_OUT_H:
+        /* Burst reads of the fifo output roll back to DATA_OUT_L */
+        v = sim_fifo_byte();
+        sim->ptr = LSM6DSL_FIFO_DATA_OUT_L;
+        return v;
+    case LSM6DSL_FIFO_STATUS1:
+        v = sim->fifo_len & 0xff;
+        break;
+    case LSM6DSL_FIFO_STATUS2:
+        v = (sim->fifo_len >> 8) & LSM6DSL_FIFO_STATUS2_DIFF_MASK;
+        if (sim->fifo_len == 0) {
+            v |= LSM6DSL_FIFO_STATUS2_EMPTY;
+        }
+        if (sim->overrun) {
+            v |= LSM6DSL_FIFO_STATUS2_OVER_RUN;
+        }
+        break;
+    default:
+        v = sim->regs[sim->ptr & 0x7f];
+        break;
+    }
+    sim->ptr++;
+    return v;
+}
+
+static void
+sim_write(uint8_t v)
+{
+    struct lsm6dsl_sim *sim = &g_lsm6dsl_sim;
+
+    if (sim->ptr == LSM6DSL_FIFO_CTRL5 && (v & 0x07) == LSM6DSL_FIFO_MODE_BYPASS) {
+        sim->fifo_len = 0;
+        sim->fifo_byte = 0;
+        sim->overrun = 0;
+    }
+    sim->regs[sim->ptr++ & 0x7f] = v;
+}
+
+int
+hal_i2c_master_write(uint8_t i2c_num, struct hal_i2c_master_data *pdata,
+                     uint32_t timeout, uint8_t last_op)
+{
+    int i;
+
+    g_lsm6dsl_sim.writes++;
+    if (pdata->len == 0) {
+        return 0;
+    }
+    g_lsm6dsl_sim.ptr = pdata->buffer[0];
+    for (i = 1; i < pdata->len; i++) {
+        sim_write(pdata->buffer[i]);
+    }
+    return 0;
+}
+
+int
+hal_i2c_master_read(uint8_t i2c_num, struct hal_i2c_master_data *pdata,
+                    uint32_t timeout, uint8_t last_op)
+{
+    int i;
+
+    g_lsm6dsl_sim.reads++;
+    for (i = 0; i < pdata->len; i++) {
+        pdata->buffer[i] = sim_read();
+    }
+    return 0;
+}
+
+void
+lsm6dsl_test_dev_init(struct lsm6dsl *dev)
+{
+    memset(dev, 0, sizeof(*dev));
+    dev->sensor.s_itf.si_type = SENSOR_ITF_I2C;
+    dev->sensor.s_itf.si_addr = 0x6a;
+    dev->cfg.accel_rate = LSM6DSL_ACCEL_RATE_104;
+    dev->cfg.gyro_rate = LSM6DSL_GYRO_RATE_104;
+}
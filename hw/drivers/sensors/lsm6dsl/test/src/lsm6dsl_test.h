@@ -0,0 +1,66 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _LSM6DSL_TEST_H
+#define _LSM6DSL_TEST_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "testutil/testutil.h"
+#include "hal/hal_i2c.h"
+#include "sensor/sensor.h"
+
+#include "lsm6dsl/lsm6dsl.h"
+#include "../../src/lsm6dsl_priv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 4kbyte fifo of 16 bit words */
+#define LSM6DSL_SIM_FIFO_WORDS (2048)
+
+/* Register level model of the device behind hal_i2c */
+struct lsm6dsl_sim {
+    uint8_t regs[128];
+    uint8_t ptr;
+    uint16_t fifo[LSM6DSL_SIM_FIFO_WORDS];
+    uint16_t fifo_len;
+    uint8_t fifo_byte;
+    uint8_t overrun;
+    uint32_t reads;
+    uint32_t writes;
+};
+
+extern struct lsm6dsl_sim g_lsm6dsl_sim;
+
+void lsm6dsl_sim_reset(void);
+void lsm6dsl_sim_sample(const int16_t gyro[3], const int16_t acc[3]);
+void lsm6dsl_test_dev_init(struct lsm6dsl *dev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
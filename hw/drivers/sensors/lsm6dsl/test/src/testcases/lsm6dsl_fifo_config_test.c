@@ -0,0 +1,62 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "lsm6dsl_test.h"
+
+TEST_CASE(lsm6dsl_fifo_config_test)
+{
+    struct lsm6dsl dev;
+    int16_t gyro[3] = {1, 2, 3}, acc[3] = {4, 5, 6};
+    struct lsm6dsl_sim *sim = &g_lsm6dsl_sim;
+    uint16_t words;
+    int rc;
+
+    lsm6dsl_sim_reset();
+    lsm6dsl_test_dev_init(&dev);
+    dev.cfg.int_enable = 1;
+
+    rc = lsm6dsl_fifo_config(&dev, 16);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(dev.cfg.fifo_wtm == 16);
+
+    /* Watermark in words, fifo at the accel data rate, no decimation */
+    words = sim->regs[LSM6DSL_FIFO_CTRL1] | ((uint16_t)sim->regs[LSM6DSL_FIFO_CTRL2] << 8);
+    TEST_ASSERT(words == 16 * LSM6DSL_FIFO_WORDS_PER_SAMPLE, "wtm %d words", words);
+    TEST_ASSERT(sim->regs[LSM6DSL_FIFO_CTRL3] ==
+                (LSM6DSL_FIFO_DEC_GYRO_NONE | LSM6DSL_FIFO_DEC_XL_NONE));
+    TEST_ASSERT(sim->regs[LSM6DSL_FIFO_CTRL5] ==
+                ((LSM6DSL_ACCEL_RATE_104 >> 4) << 3 | LSM6DSL_FIFO_MODE_CONTINUOUS));
+    TEST_ASSERT(sim->regs[LSM6DSL_INT1_CTRL] == LSM6DSL_INT1_FTH);
+
+    lsm6dsl_sim_sample(gyro, acc);
+    TEST_ASSERT(sim->fifo_len == LSM6DSL_FIFO_WORDS_PER_SAMPLE);
+
+    /* Bypass mode empties the fifo and goes back to data ready interrupts */
+    rc = lsm6dsl_fifo_config(&dev, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(sim->fifo_len == 0);
+    TEST_ASSERT(sim->regs[LSM6DSL_FIFO_CTRL5] == LSM6DSL_FIFO_MODE_BYPASS);
+    TEST_ASSERT(sim->regs[LSM6DSL_INT1_CTRL] == LSM6DSL_INT1_DRDY);
+    lsm6dsl_sim_sample(gyro, acc);
+    TEST_ASSERT(sim->fifo_len == 0);
+
+    /* The watermark is limited by the sample buffer */
+    rc = lsm6dsl_fifo_config(&dev, 1000);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(dev.cfg.fifo_wtm == LSM6DSL_FIFO_MAX_SAMPLES);
+}
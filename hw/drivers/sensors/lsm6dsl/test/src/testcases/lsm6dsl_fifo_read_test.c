@@ -0,0 +1,133 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "lsm6dsl_test.h"
+
+/* Synthetic motion, distinct and signed on every axis */
+static void
+motion(int k, int16_t gyro[3], int16_t acc[3])
+{
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        gyro[i] = (int16_t)(-k * 131 - i * 7 + 250);
+        acc[i] = (int16_t)(k * 97 + i * 1000 - 16000);
+    }
+}
+
+static void
+check_samples(struct lsm6dsl_fifo_sample *samples, int n, int first)
+{
+    int16_t gyro[3], acc[3];
+    int i, j;
+
+    for (i = 0; i < n; i++) {
+        motion(first + i, gyro, acc);
+        for (j = 0; j < 3; j++) {
+            TEST_ASSERT(samples[i].gyro[j] == gyro[j], "sample %d gyro %d: %d != %d",
+                        first + i, j, samples[i].gyro[j], gyro[j]);
+            TEST_ASSERT(samples[i].acc[j] == acc[j], "sample %d acc %d: %d != %d",
+                        first + i, j, samples[i].acc[j], acc[j]);
+        }
+    }
+}
+
+TEST_CASE(lsm6dsl_fifo_read_test)
+{
+    struct lsm6dsl dev;
+    struct lsm6dsl_sim *sim = &g_lsm6dsl_sim;
+    int16_t gyro[3], acc[3];
+    uint32_t t0, t1, period, reads;
+    uint16_t n;
+    uint8_t overrun;
+    int i, rc;
+
+    lsm6dsl_sim_reset();
+    lsm6dsl_test_dev_init(&dev);
+    rc = lsm6dsl_fifo_config(&dev, LSM6DSL_FIFO_MAX_SAMPLES);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < LSM6DSL_FIFO_MAX_SAMPLES; i++) {
+        motion(i, gyro, acc);
+        lsm6dsl_sim_sample(gyro, acc);
+    }
+
+    rc = lsm6dsl_fifo_count(&dev, &n, &overrun);
+    TEST_ASSERT(rc == 0 && n == LSM6DSL_FIFO_MAX_SAMPLES && !overrun);
+
+    reads = sim->reads;
+    t0 = os_cputime_get32();
+    rc = lsm6dsl_fifo_read(&dev, dev.fifo, LSM6DSL_FIFO_MAX_SAMPLES, &n);
+    t1 = os_cputime_get32();
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(n == LSM6DSL_FIFO_MAX_SAMPLES, "n %d", n);
+    TEST_ASSERT(sim->fifo_len == 0);
+
+    /* Status and one burst, independent of the batch size */
+    TEST_ASSERT(sim->reads - reads == 2, "%d reads", sim->reads - reads);
+
+    check_samples(dev.fifo, n, 0);
+
+    /* Newest sample at the time of the read, older ones one period apart */
+    period = os_cputime_usecs_to_ticks(10000000UL / 1040);
+    TEST_ASSERT((int32_t)(dev.fifo[n - 1].timestamp - t0) >= 0);
+    TEST_ASSERT((int32_t)(t1 - dev.fifo[n - 1].timestamp) >= 0);
+    for (i = 1; i < n; i++) {
+        TEST_ASSERT(dev.fifo[i].timestamp - dev.fifo[i - 1].timestamp == period);
+    }
+
+    /* Empty fifo */
+    rc = lsm6dsl_fifo_read(&dev, dev.fifo, LSM6DSL_FIFO_MAX_SAMPLES, &n);
+    TEST_ASSERT(rc == 0 && n == 0);
+}
+
+TEST_CASE(lsm6dsl_fifo_partial_test)
+{
+    struct lsm6dsl dev;
+    struct lsm6dsl_sim *sim = &g_lsm6dsl_sim;
+    struct lsm6dsl_fifo_sample first[8];
+    int16_t gyro[3], acc[3];
+    uint32_t period;
+    uint16_t n;
+    int i, rc;
+
+    lsm6dsl_sim_reset();
+    lsm6dsl_test_dev_init(&dev);
+    rc = lsm6dsl_fifo_config(&dev, 8);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < 20; i++) {
+        motion(i, gyro, acc);
+        lsm6dsl_sim_sample(gyro, acc);
+    }
+
+    /* Draining less than is queued returns the oldest samples */
+    rc = lsm6dsl_fifo_read(&dev, first, 8, &n);
+    TEST_ASSERT_FATAL(rc == 0 && n == 8);
+    check_samples(first, n, 0);
+    TEST_ASSERT(sim->fifo_len == 12 * LSM6DSL_FIFO_WORDS_PER_SAMPLE);
+
+    /* and dates them behind the samples still in the fifo */
+    rc = lsm6dsl_fifo_read(&dev, dev.fifo, LSM6DSL_FIFO_MAX_SAMPLES, &n);
+    TEST_ASSERT_FATAL(rc == 0 && n == 12);
+    check_samples(dev.fifo, n, 8);
+
+    period = os_cputime_usecs_to_ticks(10000000UL / 1040);
+    TEST_ASSERT((int32_t)(dev.fifo[0].timestamp - first[7].timestamp) > 0);
+    TEST_ASSERT(first[7].timestamp - first[0].timestamp == 7 * period);
+}
@@ -67,6 +67,22 @@ enum mpu6500_clock_select {
 #define MPU6500_INT_LATCH_EN (0x20)
 #define MPU6500_INT_RD_CLEAR (0x10)
 
+#define MPU6500_FIFO_MAX_SAMPLES (MYNEWT_VAL(MPU6500_FIFO_MAX_SAMPLES))
+
+/* One accel/gyro pair out of the fifo, timestamp in os_cputime ticks
+ * reconstructed from the sample rate */
+struct mpu6500_fifo_sample {
+    int16_t acc[3];
+    int16_t gyro[3];
+    uint32_t timestamp;
+};
+
+struct mpu6500;
+
+/* Called with each burst read from the fifo */
+typedef void (*mpu6500_fifo_cb_t)(struct mpu6500 *dev, struct mpu6500_fifo_sample *samples,
+                                  uint16_t nsamples, void *arg);
+
 struct mpu6500_cfg {
     enum mpu6500_accel_range accel_range;
     enum mpu6500_gyro_range  gyro_range;
@@ -76,6 +92,7 @@ struct mpu6500_cfg {
     uint8_t lpf_cfg; /* See data sheet */
     uint8_t int_enable;
     uint8_t int_cfg;
+    uint16_t fifo_wtm; /* Samples per fifo batch, 0 disables fifo mode */
     sensor_type_t mask;
 };
 
@@ -84,6 +101,9 @@ struct mpu6500 {
     struct sensor sensor;
     struct mpu6500_cfg cfg;
     os_time_t last_read_time;
+    mpu6500_fifo_cb_t fifo_cb;
+    void *fifo_cb_arg;
+    struct mpu6500_fifo_sample fifo[MPU6500_FIFO_MAX_SAMPLES];
 };
 
 int mpu6500_reset(struct sensor_itf *itf);
@@ -110,6 +130,12 @@ int mpu6500_config_interrupt(struct sensor_itf *itf, uint8_t cfg);
 int mpu6500_init(struct os_dev *, void *);
 int mpu6500_config(struct mpu6500 *, struct mpu6500_cfg *);
 
+int mpu6500_fifo_config(struct mpu6500 *mpu, uint16_t wtm);
+int mpu6500_fifo_set_cb(struct mpu6500 *mpu, mpu6500_fifo_cb_t cb, void *arg);
+int mpu6500_fifo_count(struct mpu6500 *mpu, uint16_t *nsamples, uint8_t *overrun);
+int mpu6500_fifo_read(struct mpu6500 *mpu, struct mpu6500_fifo_sample *samples,
+    uint16_t max_samples, uint16_t *nsamples);
+
 #ifdef __cplusplus
 }
 #endif
@@ -37,12 +37,20 @@
 STATS_SECT_START(mpu6500_stat_section)
     STATS_SECT_ENTRY(read_errors)
     STATS_SECT_ENTRY(write_errors)
+    STATS_SECT_ENTRY(bus_xfers)
+    STATS_SECT_ENTRY(fifo_reads)
+    STATS_SECT_ENTRY(fifo_samples)
+    STATS_SECT_ENTRY(fifo_overruns)
 STATS_SECT_END
 
 /* Define stat names for querying */
 STATS_NAME_START(mpu6500_stat_section)
     STATS_NAME(mpu6500_stat_section, read_errors)
     STATS_NAME(mpu6500_stat_section, write_errors)
+    STATS_NAME(mpu6500_stat_section, bus_xfers)
+    STATS_NAME(mpu6500_stat_section, fifo_reads)
+    STATS_NAME(mpu6500_stat_section, fifo_samples)
+    STATS_NAME(mpu6500_stat_section, fifo_overruns)
 STATS_NAME_END(mpu6500_stat_section)
 
 /* Global variable used to hold stats data */
@@ -85,6 +93,7 @@ mpu6500_write8(struct sensor_itf *itf, uint8_t reg, uint32_t value)
         .buffer = payload
     };
 
+    STATS_INC(g_mpu6500stats, bus_xfers);
     rc = hal_i2c_master_write(itf->si_num, &data_struct,
                               OS_TICKS_PER_SEC / 10, 1);
 
@@ -117,6 +126,7 @@ mpu6500_read8(struct sensor_itf *itf, uint8_t reg, uint8_t *value)
         .buffer = &reg
     };
 
+    STATS_INC(g_mpu6500stats, bus_xfers);
     /* Register write */
     rc = hal_i2c_master_write(itf->si_num, &data_struct,
                               OS_TICKS_PER_SEC / 10, 0);
@@ -139,16 +149,19 @@ mpu6500_read8(struct sensor_itf *itf, uint8_t reg, uint8_t *value)
 }
 
 /**
- * Reads a six bytes from the specified register
+ * Reads a number of bytes starting at the specified register in a single
+ * bus transaction
  *
  * @param The sensor interface
  * @param The register address to read from
- * @param Pointer to where the register value should be written
+ * @param Pointer to where the register values should be written
+ * @param Number of bytes to read
  *
  * @return 0 on success, non-zero error on failure.
  */
 int
-mpu6500_read48(struct sensor_itf *itf, uint8_t reg, uint8_t *buffer)
+mpu6500_read_bytes(struct sensor_itf *itf, uint8_t reg, uint8_t *buffer,
+                   uint16_t len)
 {
     int rc;
 
@@ -158,6 +171,7 @@ mpu6500_read48(struct sensor_itf *itf, uint8_t reg, uint8_t *buffer)
         .buffer = &reg
     };
 
+    STATS_INC(g_mpu6500stats, bus_xfers);
     /* Register write */
     rc = hal_i2c_master_write(itf->si_num, &data_struct,
                               OS_TICKS_PER_SEC / 10, 0);
@@ -167,8 +181,8 @@ mpu6500_read48(struct sensor_itf *itf, uint8_t reg, uint8_t *buffer)
         return rc;
     }
 
-    /* Read six bytes back */
-    data_struct.len = 6;
+    /* Read len bytes back */
+    data_struct.len = len;
     data_struct.buffer = buffer;
     rc = hal_i2c_master_read(itf->si_num, &data_struct,
                              OS_TICKS_PER_SEC / 10, 1);
@@ -180,6 +194,21 @@ mpu6500_read48(struct sensor_itf *itf, uint8_t reg, uint8_t *buffer)
     return rc;
 }
 
+/**
+ * Reads a six bytes from the specified register
+ *
+ * @param The sensor interface
+ * @param The register address to read from
+ * @param Pointer to where the register value should be written
+ *
+ * @return 0 on success, non-zero error on failure.
+ */
+int
+mpu6500_read48(struct sensor_itf *itf, uint8_t reg, uint8_t *buffer)
+{
+    return mpu6500_read_bytes(itf, reg, buffer, 6);
+}
+
 int
 mpu6500_reset(struct sensor_itf *itf)
 {
@@ -339,6 +368,211 @@ mpu6500_enable_interrupt(struct sensor_itf *itf, uint8_t enable)
     return mpu6500_write8(itf, MPU6500_INT_ENABLE, reg);
 }
 
+/**
+ * Returns the sample period in microseconds, the gyro output rate is 8kHz
+ * with the digital low pass filter bypassed and 1kHz otherwise.
+ */
+static uint32_t
+mpu6500_sample_period_usecs(struct mpu6500 *mpu)
+{
+    uint32_t base = (mpu->cfg.lpf_cfg == 0 || mpu->cfg.lpf_cfg == 7) ? 125 : 1000;
+    return base * (1 + (uint32_t)mpu->cfg.sample_rate_div);
+}
+
+/**
+ * Configures the fifo to store accel and gyro samples at the sample rate.
+ * The mpu6500 has no watermark interrupt, in fifo mode the data ready
+ * interrupt is replaced by the overflow interrupt and the fifo is expected
+ * to be drained every wtm sample periods, e.g. from a timer.
+ *
+ * @param The device
+ * @param Samples per batch, 0 disables the fifo
+ *
+ * @return 0 on success, non-zero error on failure.
+ */
+int
+mpu6500_fifo_config(struct mpu6500 *mpu, uint16_t wtm)
+{
+    int rc;
+    uint8_t reg;
+    struct sensor_itf *itf;
+
+    itf = SENSOR_GET_ITF(&(mpu->sensor));
+
+    if (wtm > MPU6500_FIFO_MAX_SAMPLES) {
+        wtm = MPU6500_FIFO_MAX_SAMPLES;
+    }
+    if (wtm > MPU6500_FIFO_SIZE / MPU6500_FIFO_SAMPLE_BYTES) {
+        wtm = MPU6500_FIFO_SIZE / MPU6500_FIFO_SAMPLE_BYTES;
+    }
+
+    /* Stop and empty the fifo */
+    rc = mpu6500_write8(itf, MPU6500_FIFO_EN, 0);
+    if (rc) {
+        return rc;
+    }
+    /* Keep the other USER_CTRL bits, e.g. I2C master and I2C interface disable */
+    rc = mpu6500_read8(itf, MPU6500_USER_CTRL, &reg);
+    if (rc) {
+        return rc;
+    }
+    reg &= ~MPU6500_USER_FIFO_EN;
+    rc = mpu6500_write8(itf, MPU6500_USER_CTRL, reg | MPU6500_USER_FIFO_RST);
+    if (rc) {
+        return rc;
+    }
+    mpu->cfg.fifo_wtm = wtm;
+
+    if (wtm) {
+        rc = mpu6500_write8(itf, MPU6500_USER_CTRL, reg | MPU6500_USER_FIFO_EN);
+        if (rc) {
+            return rc;
+        }
+        rc = mpu6500_write8(itf, MPU6500_FIFO_EN,
+                            MPU6500_FIFO_EN_ACCEL | MPU6500_FIFO_EN_GYRO);
+        if (rc) {
+            return rc;
+        }
+    }
+
+    rc = mpu6500_read8(itf, MPU6500_INT_ENABLE, &reg);
+    if (rc) {
+        return rc;
+    }
+    reg &= ~(MPU6500_DATA_RDY_EN | MPU6500_FIFO_OFLOW_EN);
+    if (mpu->cfg.int_enable) {
+        reg |= (wtm) ? MPU6500_FIFO_OFLOW_EN : MPU6500_DATA_RDY_EN;
+    }
+    return mpu6500_write8(itf, MPU6500_INT_ENABLE, reg);
+}
+
+/**
+ * Sets a callback receiving every burst read from the fifo through the
+ * sensor read path.
+ *
+ * @param The device
+ * @param Callback, NULL to remove
+ * @param Argument passed to the callback
+ *
+ * @return 0 on success
+ */
+int
+mpu6500_fifo_set_cb(struct mpu6500 *mpu, mpu6500_fifo_cb_t cb, void *arg)
+{
+    mpu->fifo_cb = cb;
+    mpu->fifo_cb_arg = arg;
+    return 0;
+}
+
+/**
+ * Reads the number of complete samples waiting in the fifo.
+ *
+ * @param The device
+ * @param Pointer to number of samples
+ * @param Pointer to overflow flag, may be NULL. Reading it clears the
+ *        interrupt status.
+ *
+ * @return 0 on success, non-zero error on failure.
+ */
+int
+mpu6500_fifo_count(struct mpu6500 *mpu, uint16_t *nsamples, uint8_t *overrun)
+{
+    int rc;
+    uint8_t reg;
+    uint8_t payload[2];
+    struct sensor_itf *itf;
+
+    itf = SENSOR_GET_ITF(&(mpu->sensor));
+
+    if (overrun) {
+        rc = mpu6500_read8(itf, MPU6500_INT_STATUS, &reg);
+        if (rc) {
+            return rc;
+        }
+        *overrun = (reg & MPU6500_FIFO_OFLOW_INT) != 0;
+    }
+
+    rc = mpu6500_read_bytes(itf, MPU6500_FIFO_COUNT_H, payload, sizeof(payload));
+    if (rc) {
+        return rc;
+    }
+
+    *nsamples = (((uint16_t)(payload[0] & 0x1f) << 8) | payload[1])
+        / MPU6500_FIFO_SAMPLE_BYTES;
+    return 0;
+}
+
+/**
+ * Drains up to max_samples from the fifo in a single burst read of the
+ * FIFO_R_W register. Timestamps are reconstructed backwards from the time
+ * of the read using the sample rate.
+ *
+ * @param The device
+ * @param Array receiving the samples
+ * @param Size of the array
+ * @param Pointer to number of samples read
+ *
+ * @return 0 on success, non-zero error on failure.
+ */
+int
+mpu6500_fifo_read(struct mpu6500 *mpu, struct mpu6500_fifo_sample *samples,
+                  uint16_t max_samples, uint16_t *nsamples)
+{
+    int rc;
+    int i, j;
+    uint16_t count, n;
+    uint8_t overrun;
+    uint8_t *raw = (uint8_t *)samples;
+    uint32_t now, period;
+    struct sensor_itf *itf;
+
+    itf = SENSOR_GET_ITF(&(mpu->sensor));
+
+    *nsamples = 0;
+    rc = mpu6500_fifo_count(mpu, &count, &overrun);
+    if (rc) {
+        return rc;
+    }
+    if (overrun) {
+        STATS_INC(g_mpu6500stats, fifo_overruns);
+    }
+
+    n = (count < max_samples) ? count : max_samples;
+    if (n == 0) {
+        return 0;
+    }
+
+    /* Raw fifo data is unpacked in place, back to front */
+    rc = mpu6500_read_bytes(itf, MPU6500_FIFO_R_W, raw,
+                            n * MPU6500_FIFO_SAMPLE_BYTES);
+    if (rc) {
+        return rc;
+    }
+    now = os_cputime_get32();
+    period = os_cputime_usecs_to_ticks(mpu6500_sample_period_usecs(mpu));
+
+    for (i = n - 1; i >= 0; i--) {
+        uint8_t *p = raw + i * MPU6500_FIFO_SAMPLE_BYTES;
+        int16_t v[MPU6500_FIFO_SAMPLE_BYTES / 2];
+        for (j = 0; j < MPU6500_FIFO_SAMPLE_BYTES / 2; j++) {
+            v[j] = (int16_t)((p[2*j] << 8) | p[2*j + 1]);
+        }
+        /* Fifo order follows the register map, accel before gyro */
+        samples[i].acc[0] = v[0];
+        samples[i].acc[1] = v[1];
+        samples[i].acc[2] = v[2];
+        samples[i].gyro[0] = v[3];
+        samples[i].gyro[1] = v[4];
+        samples[i].gyro[2] = v[5];
+        samples[i].timestamp = now - (count - 1 - i) * period;
+    }
+
+    STATS_INC(g_mpu6500stats, fifo_reads);
+    STATS_INCN(g_mpu6500stats, fifo_samples, n);
+    *nsamples = n;
+    return 0;
+}
+
 int
 mpu6500_config_interrupt(struct sensor_itf *itf, uint8_t cfg)
 {
@@ -479,14 +713,13 @@ mpu6500_config(struct mpu6500 *mpu, struct mpu6500_cfg *cfg)
 
     mpu->cfg.int_cfg = cfg->int_cfg;
 
-    /* Enable/disable interrupt */
-    rc = mpu6500_enable_interrupt(itf, cfg->int_enable);
+    /* Enable/disable interrupt, data ready or fifo overflow */
+    mpu->cfg.int_enable = cfg->int_enable;
+    rc = mpu6500_fifo_config(mpu, cfg->fifo_wtm);
     if (rc) {
         return rc;
     }
 
-    mpu->cfg.int_enable = cfg->int_enable;
-
     rc = sensor_set_type_mask(&(mpu->sensor), cfg->mask);
     if (rc) {
         return rc;
@@ -497,21 +730,99 @@ mpu6500_config(struct mpu6500 *mpu, struct mpu6500_cfg *cfg)
     return 0;
 }
 
+static float
+mpu6500_accel_lsb(enum mpu6500_accel_range range)
+{
+    switch (range) {
+        case MPU6500_ACCEL_RANGE_2: /* +/- 2g - 16384 LSB/g */
+        /* Falls through */
+        default:
+            return 16384.0F;
+        case MPU6500_ACCEL_RANGE_4: /* +/- 4g - 8192 LSB/g */
+            return 8192.0F;
+        case MPU6500_ACCEL_RANGE_8: /* +/- 8g - 4096 LSB/g */
+            return 4096.0F;
+        case MPU6500_ACCEL_RANGE_16: /* +/- 16g - 2048 LSB/g */
+            return 2048.0F;
+    }
+}
+
+static float
+mpu6500_gyro_lsb(enum mpu6500_gyro_range range)
+{
+    switch (range) {
+        case MPU6500_GYRO_RANGE_250: /* +/- 250 Deg/s - 131 LSB/Deg/s */
+        /* Falls through */
+        default:
+            return 131.0F;
+        case MPU6500_GYRO_RANGE_500: /* +/- 500 Deg/s - 65.5 LSB/Deg/s */
+            return 65.5F;
+        case MPU6500_GYRO_RANGE_1000: /* +/- 1000 Deg/s - 32.8 LSB/Deg/s */
+            return 32.8F;
+        case MPU6500_GYRO_RANGE_2000: /* +/- 2000 Deg/s - 16.4 LSB/Deg/s */
+            return 16.4F;
+    }
+}
+
+static int
+mpu6500_sensor_deliver(struct sensor *sensor, struct mpu6500 *mpu, sensor_type_t type,
+        sensor_data_func_t data_func, void *data_arg, int16_t acc[], int16_t gyro[])
+{
+    int rc;
+    float lsb;
+    union {
+        struct sensor_accel_data sad;
+        struct sensor_gyro_data sgd;
+    } databuf;
+
+    if (type & SENSOR_TYPE_ACCELEROMETER) {
+        lsb = mpu6500_accel_lsb(mpu->cfg.accel_range);
+
+        databuf.sad.sad_x = (acc[0] / lsb) * STANDARD_ACCEL_GRAVITY;
+        databuf.sad.sad_x_is_valid = 1;
+        databuf.sad.sad_y = (acc[1] / lsb) * STANDARD_ACCEL_GRAVITY;
+        databuf.sad.sad_y_is_valid = 1;
+        databuf.sad.sad_z = (acc[2] / lsb) * STANDARD_ACCEL_GRAVITY;
+        databuf.sad.sad_z_is_valid = 1;
+
+        rc = data_func(sensor, data_arg, &databuf.sad,
+                SENSOR_TYPE_ACCELEROMETER);
+        if (rc) {
+            return rc;
+        }
+    }
+
+    if (type & SENSOR_TYPE_GYROSCOPE) {
+        lsb = mpu6500_gyro_lsb(mpu->cfg.gyro_range);
+
+        databuf.sgd.sgd_x = gyro[0] / lsb;
+        databuf.sgd.sgd_x_is_valid = 1;
+        databuf.sgd.sgd_y = gyro[1] / lsb;
+        databuf.sgd.sgd_y_is_valid = 1;
+        databuf.sgd.sgd_z = gyro[2] / lsb;
+        databuf.sgd.sgd_z_is_valid = 1;
+
+        rc = data_func(sensor, data_arg, &databuf.sgd, SENSOR_TYPE_GYROSCOPE);
+        if (rc) {
+            return rc;
+        }
+    }
+
+    return 0;
+}
+
 static int
 mpu6500_sensor_read(struct sensor *sensor, sensor_type_t type,
         sensor_data_func_t data_func, void *data_arg, uint32_t timeout)
 {
     (void)timeout;
     int rc;
-    int16_t x, y, z;
+    int i;
+    uint16_t n;
+    int16_t acc[3] = {0}, gyro[3] = {0};
     uint8_t payload[6];
-    float lsb;
     struct sensor_itf *itf;
     struct mpu6500 *mpu;
-    union {
-        struct sensor_accel_data sad;
-        struct sensor_gyro_data sgd;
-    } databuf;
 
     /* If the read isn't looking for accel or gyro, don't do anything. */
     if (!(type & SENSOR_TYPE_ACCELEROMETER) &&
@@ -522,46 +833,35 @@ mpu6500_sensor_read(struct sensor *sensor, sensor_type_t type,
     itf = SENSOR_GET_ITF(sensor);
     mpu = (struct mpu6500 *) SENSOR_GET_DEVICE(sensor);
 
-    /* Get a new accelerometer sample */
-    if (type & SENSOR_TYPE_ACCELEROMETER) {
-        rc = mpu6500_read48(itf, MPU6500_ACCEL_XOUT_H, payload);
+    /* In fifo mode deliver everything queued since the last read */
+    if (mpu->cfg.fifo_wtm) {
+        rc = mpu6500_fifo_read(mpu, mpu->fifo, MPU6500_FIFO_MAX_SAMPLES, &n);
         if (rc) {
             return rc;
         }
-
-        x = (int16_t)((payload[0] << 8) | payload[1]);
-        y = (int16_t)((payload[2] << 8) | payload[3]);
-        z = (int16_t)((payload[4] << 8) | payload[5]);
-
-        switch (mpu->cfg.gyro_range) {
-            case MPU6500_ACCEL_RANGE_2: /* +/- 2g - 16384 LSB/g */
-            /* Falls through */
-            default:
-                lsb = 16384.0F;
-            break;
-            case MPU6500_ACCEL_RANGE_4: /* +/- 4g - 8192 LSB/g */
-                lsb = 8192.0F;
-            break;
-            case MPU6500_ACCEL_RANGE_8: /* +/- 8g - 4096 LSB/g */
-                lsb = 4096.0F;
-            break;
-            case MPU6500_ACCEL_RANGE_16: /* +/- 16g - 2048 LSB/g */
-                lsb = 2048.0F;
-            break;
+        if (n && mpu->fifo_cb) {
+            mpu->fifo_cb(mpu, mpu->fifo, n, mpu->fifo_cb_arg);
         }
+        for (i = 0; i < n; i++) {
+            rc = mpu6500_sensor_deliver(sensor, mpu, type, data_func, data_arg,
+                                        mpu->fifo[i].acc, mpu->fifo[i].gyro);
+            if (rc) {
+                return rc;
+            }
+        }
+        return 0;
+    }
 
-        databuf.sad.sad_x = (x / lsb) * STANDARD_ACCEL_GRAVITY;
-        databuf.sad.sad_x_is_valid = 1;
-        databuf.sad.sad_y = (y / lsb) * STANDARD_ACCEL_GRAVITY;
-        databuf.sad.sad_y_is_valid = 1;
-        databuf.sad.sad_z = (z / lsb) * STANDARD_ACCEL_GRAVITY;
-        databuf.sad.sad_z_is_valid = 1;
-
-        rc = data_func(sensor, data_arg, &databuf.sad,
-                SENSOR_TYPE_ACCELEROMETER);
+    /* Get a new accelerometer sample */
+    if (type & SENSOR_TYPE_ACCELEROMETER) {
+        rc = mpu6500_read48(itf, MPU6500_ACCEL_XOUT_H, payload);
         if (rc) {
             return rc;
         }
+
+        acc[0] = (int16_t)((payload[0] << 8) | payload[1]);
+        acc[1] = (int16_t)((payload[2] << 8) | payload[3]);
+        acc[2] = (int16_t)((payload[4] << 8) | payload[5]);
     }
 
     /* Get a new gyroscope sample */
@@ -571,41 +871,12 @@ mpu6500_sensor_read(struct sensor *sensor, sensor_type_t type,
             return rc;
         }
 
-        x = (int16_t)((payload[0] << 8) | payload[1]);
-        y = (int16_t)((payload[2] << 8) | payload[3]);
-        z = (int16_t)((payload[4] << 8) | payload[5]);
-
-        switch (mpu->cfg.gyro_range) {
-            case MPU6500_GYRO_RANGE_250: /* +/- 250 Deg/s - 131 LSB/Deg/s */
-            /* Falls through */
-            default:
-                lsb = 131.0F;
-            break;
-            case MPU6500_GYRO_RANGE_500: /* +/- 500 Deg/s - 65.5 LSB/Deg/s */
-                lsb = 65.5F;
-            break;
-            case MPU6500_GYRO_RANGE_1000: /* +/- 1000 Deg/s - 32.8 LSB/Deg/s */
-                lsb = 32.8F;
-            break;
-            case MPU6500_GYRO_RANGE_2000: /* +/- 2000 Deg/s - 16.4 LSB/Deg/s */
-                lsb = 16.4F;
-            break;
-        }
-
-        databuf.sgd.sgd_x = x / lsb;
-        databuf.sgd.sgd_x_is_valid = 1;
-        databuf.sgd.sgd_y = y / lsb;
-        databuf.sgd.sgd_y_is_valid = 1;
-        databuf.sgd.sgd_z = z / lsb;
-        databuf.sgd.sgd_z_is_valid = 1;
-
-        rc = data_func(sensor, data_arg, &databuf.sgd, SENSOR_TYPE_GYROSCOPE);
-        if (rc) {
-            return rc;
-        }
+        gyro[0] = (int16_t)((payload[0] << 8) | payload[1]);
+        gyro[1] = (int16_t)((payload[2] << 8) | payload[3]);
+        gyro[2] = (int16_t)((payload[4] << 8) | payload[5]);
     }
 
-    return 0;
+    return mpu6500_sensor_deliver(sensor, mpu, type, data_func, data_arg, acc, gyro);
 }
 
 static int
@@ -114,10 +114,25 @@ enum mpu6500_registers {
 #define MPU6500_DATA_RDY_EN (0x01)
 #define MPU6500_DEVICE_RESET (0x80)
 #define MPU6500_SLEEP (0x40)
+#define MPU6500_FIFO_OFLOW_EN (0x10)
+#define MPU6500_FIFO_OFLOW_INT (0x10)
+
+/* FIFO_EN */
+#define MPU6500_FIFO_EN_GYRO (0x70)
+#define MPU6500_FIFO_EN_ACCEL (0x08)
+/* USER_CTRL */
+#define MPU6500_USER_FIFO_EN (0x40)
+#define MPU6500_USER_FIFO_RST (0x04)
+
+/* Hardware fifo size and bytes per accel+gyro sample */
+#define MPU6500_FIFO_SIZE (512)
+#define MPU6500_FIFO_SAMPLE_BYTES (12)
 
 int mpu6500_write8(struct sensor_itf *itf, uint8_t reg, uint32_t value);
 int mpu6500_read8(struct sensor_itf *itf, uint8_t reg, uint8_t *value);
 int mpu6500_read48(struct sensor_itf *itf, uint8_t reg, uint8_t *buffer);
+int mpu6500_read_bytes(struct sensor_itf *itf, uint8_t reg, uint8_t *buffer,
+    uint16_t len);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,154 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "mpu6500_test.h"
+
+struct mpu6500_sim g_mpu6500_sim;
+
+void
+mpu6500_sim_reset(void)
+{
+    memset(&g_mpu6500_sim, 0, sizeof(g_mpu6500_sim));
+    g_mpu6500_sim.regs[MPU6500_WHO_AM_I] = MPU6500_WHO_AM_I_VAL;
+}
+
+static void
+sim_put16(int16_t v)
+{
+    struct mpu6500_sim *sim = &g_mpu6500_sim;
+
+    if (sim->fifo_len + 2 > sizeof(sim->fifo)) {
+        sim->regs[MPU6500_INT_STATUS] |= MPU6500_FIFO_OFLOW_INT;
+        return;
+    }
+    sim->fifo[sim->fifo_len++] = (uint16_t)v >> 8;
+    sim->fifo[sim->fifo_len++] = (uint16_t)v & 0xff;
+}
+
+/**
+ * One sample period of the device, the fifo only takes data when enabled
+ * in both USER_CTRL and FIFO_EN.
+ */
+void
+mpu6500_sim_sample(const int16_t acc[3], const int16_t gyro[3])
+{
+    struct mpu6500_sim *sim = &g_mpu6500_sim;
+    int i;
+
+    if (!(sim->regs[MPU6500_USER_CTRL] & MPU6500_USER_FIFO_EN)) {
+        return;
+    }
+    if (sim->regs[MPU6500_FIFO_EN] & MPU6500_FIFO_EN_ACCEL) {
+        for (i = 0; i < 3; i++) {
+            sim_put16(acc[i]);
+        }
+    }
+    if ((sim->regs[MPU6500_FIFO_EN] & MPU6500_FIFO_EN_GYRO) == MPU6500_FIFO_EN_GYRO) {
+        for (i = 0; i < 3; i++) {
+            sim_put16(gyro[i]);
+        }
+    }
+}
+
+static uint8_t
+sim_read(void)
+{
+    struct mpu6500_sim *sim = &g_mpu6500_sim;
+    uint8_t v;
+
+    switch (sim->ptr) {
+    case MPU6500_FIFO_R_W:
+        /* Reads from the fifo port do not advance the register pointer */
+        if (sim->fifo_len == 0) {
+            return 0xff;
+        }
+        v = sim->fifo[0];
+        memmove(sim->fifo, sim->fifo + 1, --sim->fifo_len);
+        return v;
+    case MPU6500_FIFO_COUNT_H:
+        v = sim->fifo_len >> 8;
+        break;
+    case MPU6500_FIFO_COUNT_L:
+        v = sim->fifo_len & 0xff;
+        break;
+    case MPU6500_INT_STATUS:
+        v = sim->regs[sim->ptr];
+        sim->regs[sim->ptr] = 0;
+        break;
+    default:
+        v = sim->regs[sim->ptr & 0x7f];
+        break;
+    }
+    sim->ptr++;
+    return v;
+}
+
+static void
+sim_write(uint8_t v)
+{
+    struct mpu6500_sim *sim = &g_mpu6500_sim;
+
+    if (sim->ptr == MPU6500_USER_CTRL && (v & MPU6500_USER_FIFO_RST)) {
+        /* Self clearing */
+        sim->fifo_len = 0;
+        v &= ~MPU6500_USER_FIFO_RST;
+    }
+    sim->regs[sim->ptr++ & 0x7f] = v;
+}
+
+int
+hal_i2c_master_write(uint8_t i2c_num, struct hal_i2c_master_data *pdata,
+                     uint32_t timeout, uint8_t last_op)
+{
+    int i;
+
+    g_mpu6500_sim.writes++;
+    if (pdata->len == 0) {
+        return 0;
+    }
+    g_mpu6500_sim.ptr = pdata->buffer[0];
+    for (i = 1; i < pdata->len; i++) {
+        sim_write(pdata->buffer[i]);
+    }
+    return 0;
+}
+
+int
+hal_i2c_master_read(uint8_t i2c_num, struct hal_i2c_master_data *pdata,
+                    uint32_t timeout, uint8_t last_op)
+{
+    int i;
+
+    g_mpu6500_sim.reads++;
+    for (i = 0; i < pdata->len; i++) {
+        pdata->buffer[i] = sim_read();
+    }
+    return 0;
+}
+
+void
+mpu6500_test_dev_init(struct mpu6500 *mpu)
+{
+    memset(mpu, 0, sizeof(*mpu));
+    mpu->sensor.s_itf.si_type = SENSOR_ITF_I2C;
+    mpu->sensor.s_itf.si_addr = 0x68;
+    /* 1kHz gyro output with the lpf on, divided down to 100Hz */
+    mpu->cfg.lpf_cfg = 1;
+    mpu->cfg.sample_rate_div = 9;
+}
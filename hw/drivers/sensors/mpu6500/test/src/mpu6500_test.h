@@ -0,0 +1,61 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _MPU6500_TEST_H
+#define _MPU6500_TEST_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "testutil/testutil.h"
+#include "hal/hal_i2c.h"
+#include "sensor/sensor.h"
+
+#include "mpu6500/mpu6500.h"
+#include "../../src/mpu6500_priv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Register level model of the device behind hal_i2c */
+struct mpu6500_sim {
+    uint8_t regs[128];
+    uint8_t ptr;
+    uint8_t fifo[MPU6500_FIFO_SIZE];
+    uint16_t fifo_len;
+    uint32_t reads;
+    uint32_t writes;
+};
+
+extern struct mpu6500_sim g_mpu6500_sim;
+
+void mpu6500_sim_reset(void);
+void mpu6500_sim_sample(const int16_t acc[3], const int16_t gyro[3]);
+void mpu6500_test_dev_init(struct mpu6500 *mpu);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,69 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "mpu6500_test.h"
+
+#define USER_CTRL_I2C_MST_EN (0x20)
+#define USER_CTRL_I2C_IF_DIS (0x10)
+
+TEST_CASE(mpu6500_fifo_config_test)
+{
+    struct mpu6500 mpu;
+    int16_t acc[3] = {1, 2, 3}, gyro[3] = {4, 5, 6};
+    struct mpu6500_sim *sim = &g_mpu6500_sim;
+    int rc;
+
+    mpu6500_sim_reset();
+    mpu6500_test_dev_init(&mpu);
+
+    /* Bits set up elsewhere in USER_CTRL must survive fifo configuration */
+    sim->regs[MPU6500_USER_CTRL] = USER_CTRL_I2C_MST_EN | USER_CTRL_I2C_IF_DIS;
+
+    rc = mpu6500_fifo_config(&mpu, 8);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(mpu.cfg.fifo_wtm == 8);
+    TEST_ASSERT(sim->regs[MPU6500_USER_CTRL] ==
+                (USER_CTRL_I2C_MST_EN | USER_CTRL_I2C_IF_DIS | MPU6500_USER_FIFO_EN),
+                "USER_CTRL 0x%02x", sim->regs[MPU6500_USER_CTRL]);
+    TEST_ASSERT(sim->regs[MPU6500_FIFO_EN] ==
+                (MPU6500_FIFO_EN_ACCEL | MPU6500_FIFO_EN_GYRO));
+
+    mpu6500_sim_sample(acc, gyro);
+    TEST_ASSERT(sim->fifo_len == MPU6500_FIFO_SAMPLE_BYTES);
+
+    /* Reconfiguring empties the fifo */
+    rc = mpu6500_fifo_config(&mpu, 4);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(sim->fifo_len == 0);
+
+    /* Disabling stops the fifo and still leaves the other bits alone */
+    rc = mpu6500_fifo_config(&mpu, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(sim->regs[MPU6500_USER_CTRL] ==
+                (USER_CTRL_I2C_MST_EN | USER_CTRL_I2C_IF_DIS),
+                "USER_CTRL 0x%02x", sim->regs[MPU6500_USER_CTRL]);
+    TEST_ASSERT(sim->regs[MPU6500_FIFO_EN] == 0);
+    mpu6500_sim_sample(acc, gyro);
+    TEST_ASSERT(sim->fifo_len == 0);
+
+    /* The watermark is limited by the hardware fifo and the sample buffer */
+    rc = mpu6500_fifo_config(&mpu, 1000);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(mpu.cfg.fifo_wtm <= MPU6500_FIFO_MAX_SAMPLES);
+    TEST_ASSERT(mpu.cfg.fifo_wtm <= MPU6500_FIFO_SIZE / MPU6500_FIFO_SAMPLE_BYTES);
+}
@@ -0,0 +1,129 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "mpu6500_test.h"
+
+/* Synthetic motion, distinct and signed on every axis */
+static void
+motion(int k, int16_t acc[3], int16_t gyro[3])
+{
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        acc[i] = (int16_t)(k * 97 + i * 1000 - 16000);
+        gyro[i] = (int16_t)(-k * 131 - i * 7 + 250);
+    }
+}
+
+static void
+check_samples(struct mpu6500_fifo_sample *samples, int n, int first)
+{
+    int16_t acc[3], gyro[3];
+    int i, j;
+
+    for (i = 0; i < n; i++) {
+        motion(first + i, acc, gyro);
+        for (j = 0; j < 3; j++) {
+            TEST_ASSERT(samples[i].acc[j] == acc[j], "sample %d acc %d: %d != %d",
+                        first + i, j, samples[i].acc[j], acc[j]);
+            TEST_ASSERT(samples[i].gyro[j] == gyro[j], "sample %d gyro %d: %d != %d",
+                        first + i, j, samples[i].gyro[j], gyro[j]);
+        }
+    }
+}
+
+TEST_CASE(mpu6500_fifo_read_test)
+{
+    struct mpu6500 mpu;
+    struct mpu6500_sim *sim = &g_mpu6500_sim;
+    int16_t acc[3], gyro[3];
+    uint32_t t0, t1, period, reads;
+    uint16_t n;
+    int i, rc;
+
+    mpu6500_sim_reset();
+    mpu6500_test_dev_init(&mpu);
+    rc = mpu6500_fifo_config(&mpu, MPU6500_FIFO_MAX_SAMPLES);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < MPU6500_FIFO_MAX_SAMPLES; i++) {
+        motion(i, acc, gyro);
+        mpu6500_sim_sample(acc, gyro);
+    }
+
+    reads = sim->reads;
+    t0 = os_cputime_get32();
+    rc = mpu6500_fifo_read(&mpu, mpu.fifo, MPU6500_FIFO_MAX_SAMPLES, &n);
+    t1 = os_cputime_get32();
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(n == MPU6500_FIFO_MAX_SAMPLES, "n %d", n);
+    TEST_ASSERT(sim->fifo_len == 0);
+
+    /* Status, count and one burst, independent of the batch size */
+    TEST_ASSERT(sim->reads - reads == 3, "%d reads", sim->reads - reads);
+
+    check_samples(mpu.fifo, n, 0);
+
+    /* Newest sample at the time of the read, older ones one period apart */
+    period = os_cputime_usecs_to_ticks(10000);
+    TEST_ASSERT((int32_t)(mpu.fifo[n - 1].timestamp - t0) >= 0);
+    TEST_ASSERT((int32_t)(t1 - mpu.fifo[n - 1].timestamp) >= 0);
+    for (i = 1; i < n; i++) {
+        TEST_ASSERT(mpu.fifo[i].timestamp - mpu.fifo[i - 1].timestamp == period);
+    }
+
+    /* Empty fifo */
+    rc = mpu6500_fifo_read(&mpu, mpu.fifo, MPU6500_FIFO_MAX_SAMPLES, &n);
+    TEST_ASSERT(rc == 0 && n == 0);
+}
+
+TEST_CASE(mpu6500_fifo_partial_test)
+{
+    struct mpu6500 mpu;
+    struct mpu6500_sim *sim = &g_mpu6500_sim;
+    struct mpu6500_fifo_sample first[8];
+    int16_t acc[3], gyro[3];
+    uint32_t period;
+    uint16_t n;
+    int i, rc;
+
+    mpu6500_sim_reset();
+    mpu6500_test_dev_init(&mpu);
+    rc = mpu6500_fifo_config(&mpu, 8);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < 20; i++) {
+        motion(i, acc, gyro);
+        mpu6500_sim_sample(acc, gyro);
+    }
+
+    /* Draining less than is queued returns the oldest samples */
+    rc = mpu6500_fifo_read(&mpu, first, 8, &n);
+    TEST_ASSERT_FATAL(rc == 0 && n == 8);
+    check_samples(first, n, 0);
+    TEST_ASSERT(sim->fifo_len == 12 * MPU6500_FIFO_SAMPLE_BYTES);
+
+    /* and dates them behind the samples still in the fifo */
+    rc = mpu6500_fifo_read(&mpu, mpu.fifo, MPU6500_FIFO_MAX_SAMPLES, &n);
+    TEST_ASSERT_FATAL(rc == 0 && n == 12);
+    check_samples(mpu.fifo, n, 8);
+
+    period = os_cputime_usecs_to_ticks(10000);
+    TEST_ASSERT((int32_t)(mpu.fifo[0].timestamp - first[7].timestamp) > 0);
+    TEST_ASSERT(first[7].timestamp - first[0].timestamp == 7 * period);
+}
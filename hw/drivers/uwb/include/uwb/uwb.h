@@ -55,6 +55,19 @@ typedef enum uwb_extension_id {
     UWBEXT_RTDOA = 0x40,                     //!< RTDoA
     UWBEXT_RTDOA_BH,                         //!< RTDoA Backhaul
     UWBEXT_SURVEY = 0x50,                    //!< Survey
+    UWBEXT_FLOOR = 0x60,                     //!< Barometric floor detection
+    UWBEXT_LINKADAPT,                        //!< Link adaptation
+    UWBEXT_AGILITY,                          //!< Channel and preamble code agility
+    UWBEXT_LINKDIAG,                         //!< Per peer receive diagnostics
+    UWBEXT_AGGR,                             //!< Frame aggregation
+    UWBEXT_BRIDGE,                           //!< Host bridge
+    UWBEXT_BRIDGE_SHM,                       //!< Host bridge, shared memory ring
+    UWBEXT_PEER_SCHED,                       //!< Multi-peer ranging session scheduler
+    UWBEXT_SEC,                              //!< Frame authentication
+    UWBEXT_RNG_GUARD,                        //!< Ranging integrity checks
+    UWBEXT_DIVERSITY,                        //!< Dual radio diversity ranging
+    UWBEXT_XCS,                              //!< Cross-cell clock synchronization
+    UWBEXT_HANDOVER,                         //!< Tag handover between ccp cells
     UWBEXT_APP0 = 1024,
     UWBEXT_APP1,
     UWBEXT_APP2
@@ -178,6 +191,17 @@ struct uwb_dev_txrf_config {
     };
 };
 
+//! Frame filter options, frames of a type not listed are dropped by the transceiver.
+#define UWB_FF_NOTYPE_EN      0x000   //!< No frame types allowed (frame filtering disabled)
+#define UWB_FF_COORD_EN       0x002   //!< Behave as coordinator, accept frames without destination address (PAN ID has to match)
+#define UWB_FF_BEACON_EN      0x004   //!< Beacon frames allowed
+#define UWB_FF_DATA_EN        0x008   //!< Data frames allowed
+#define UWB_FF_ACK_EN         0x010   //!< Ack frames allowed
+#define UWB_FF_MAC_EN         0x020   //!< MAC command frames allowed
+#define UWB_FF_RSVD_EN        0x040   //!< Reserved frame types allowed
+#define UWB_FF_TYPE4_EN       0x080   //!< Frames with frame type 4 allowed
+#define UWB_FF_TYPE5_EN       0x100   //!< Frames with frame type 5 allowed
+
 //! UWB device configuration parameters.
 struct uwb_dev_config{
     uint8_t channel;                        //!< channel number {1, 2, 3, 4, 5, 7, 9}
@@ -564,6 +588,39 @@ typedef void (*uwb_set_uid_func_t)(struct uwb_dev * dev, uint16_t uid);
  */
 typedef void (*uwb_set_euid_func_t)(struct uwb_dev * dev, uint64_t euid);
 
+/**
+ * Configure hardware frame filtering. Data, beacon and MAC command frames are
+ * only accepted when their destination PAN ID and address match the device
+ * pan_id and uid, or are the broadcast PAN ID/address 0xffff.
+ *
+ * @param inst    Pointer to struct uwb_dev.
+ * @param enable  Bitmask of UWB_FF_* frame types to accept, UWB_FF_NOTYPE_EN disables filtering
+ *
+ * @return struct uwb_dev_status
+ */
+typedef struct uwb_dev_status (*uwb_mac_framefilter_func_t)(struct uwb_dev * dev, uint16_t enable);
+
+/**
+ * Enable hardware acknowledgement of data frames with the ack request bit set.
+ * Requires frame filtering.
+ *
+ * @param inst    Pointer to struct uwb_dev.
+ * @param enable  Enables or disables auto-ACK
+ *
+ * @return struct uwb_dev_status
+ */
+typedef struct uwb_dev_status (*uwb_set_autoack_func_t)(struct uwb_dev * dev, bool enable);
+
+/**
+ * Delay the automatic acknowledgement, enables auto-ACK.
+ *
+ * @param inst    Pointer to struct uwb_dev.
+ * @param delay   Turnaround in preamble symbols, 0 sends as soon as possible
+ *
+ * @return struct uwb_dev_status
+ */
+typedef struct uwb_dev_status (*uwb_set_autoack_delay_func_t)(struct uwb_dev * dev, uint8_t delay);
+
 /**
  * Calculate the clock offset ratio from the carrior integrator value
  *
@@ -615,6 +672,17 @@ typedef float (*uwb_calc_rssi_func_t)(struct uwb_dev * dev, struct uwb_dev_rxdia
  */
 typedef float (*uwb_calc_fppl_func_t)(struct uwb_dev * dev, struct uwb_dev_rxdiag * diag);
 
+/**
+ * Calculate the first path signal to noise ratio from an rxdiag structure,
+ * amplitudes and noise as accumulated over the preamble symbols received
+ *
+ * @param inst  Pointer to struct uwb_dev.
+ * @param diag  Pointer to struct uwb_dev_rxdiag.
+ *
+ * @return snr (dB) on success
+ */
+typedef float (*uwb_calc_fp_snr_func_t)(struct uwb_dev * dev, struct uwb_dev_rxdiag * diag);
+
 /**
  * Give a rough estimate of how likely the received packet is
  * line of sight (LOS).
@@ -670,11 +738,15 @@ struct uwb_driver_funcs {
     uwb_set_panid_func_t uf_set_panid;
     uwb_set_uid_func_t uf_set_uid;
     uwb_set_euid_func_t uf_set_euid;
+    uwb_mac_framefilter_func_t uf_mac_framefilter;
+    uwb_set_autoack_func_t uf_set_autoack;
+    uwb_set_autoack_delay_func_t uf_set_autoack_delay;
     uwb_calc_clock_offset_ratio_func_t uf_calc_clock_offset_ratio;
     uwb_get_rssi_func_t uf_get_rssi;
     uwb_get_fppl_func_t uf_get_fppl;
     uwb_calc_rssi_func_t uf_calc_rssi;
     uwb_calc_fppl_func_t uf_calc_fppl;
+    uwb_calc_fp_snr_func_t uf_calc_fp_snr;
     uwb_estimate_los_func_t uf_estimate_los;
     uwb_sync_to_ext_clock_func_t uf_sync_to_ext_clock;
 };
@@ -1215,6 +1287,47 @@ static inline void uwb_set_euid(struct uwb_dev * dev, uint64_t euid)
     return (dev->uw_funcs->uf_set_euid(dev, euid));
 }
 
+/**
+ * Configure hardware frame filtering. The filter follows later changes made
+ * with uwb_set_panid() and uwb_set_uid(). Broadcast frames are always accepted.
+ *
+ * @param inst    Pointer to struct uwb_dev.
+ * @param enable  Bitmask of UWB_FF_* frame types to accept, UWB_FF_NOTYPE_EN disables filtering
+ *
+ * @return struct uwb_dev_status
+ */
+static inline struct uwb_dev_status uwb_mac_framefilter(struct uwb_dev * dev, uint16_t enable)
+{
+    return (dev->uw_funcs->uf_mac_framefilter(dev, enable));
+}
+
+/**
+ * Enable hardware acknowledgement of data frames with the ack request bit set
+ * and addressed to this device. Requires frame filtering.
+ *
+ * @param inst    Pointer to struct uwb_dev.
+ * @param enable  Enables or disables auto-ACK
+ *
+ * @return struct uwb_dev_status
+ */
+static inline struct uwb_dev_status uwb_set_autoack(struct uwb_dev * dev, bool enable)
+{
+    return (dev->uw_funcs->uf_set_autoack(dev, enable));
+}
+
+/**
+ * Delay the automatic acknowledgement, enables auto-ACK.
+ *
+ * @param inst    Pointer to struct uwb_dev.
+ * @param delay   Turnaround in preamble symbols, 0 sends as soon as possible
+ *
+ * @return struct uwb_dev_status
+ */
+static inline struct uwb_dev_status uwb_set_autoack_delay(struct uwb_dev * dev, uint8_t delay)
+{
+    return (dev->uw_funcs->uf_set_autoack_delay(dev, delay));
+}
+
 /**
  * Calculate the clock offset ratio from the carrior integrator value
  *
@@ -1282,6 +1395,19 @@ static inline float uwb_calc_fppl(struct uwb_dev * dev, struct uwb_dev_rxdiag *
     return (dev->uw_funcs->uf_calc_fppl(dev, diag));
 }
 
+/**
+ * Calculate the first path signal to noise ratio from an rxdiag structure
+ *
+ * @param inst  Pointer to struct uwb_dev.
+ * @param diag  Pointer to struct uwb_dev_rxdiag.
+ *
+ * @return snr (dB) on success
+ */
+static inline float uwb_calc_fp_snr(struct uwb_dev * dev, struct uwb_dev_rxdiag * diag)
+{
+    return (dev->uw_funcs->uf_calc_fp_snr(dev, diag));
+}
+
 /**
  * Give a rough estimate of how likely the received packet is
  * line of sight (LOS). Taken from 4.7 of DW1000 manual 2.12
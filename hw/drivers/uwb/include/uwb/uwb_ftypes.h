@@ -43,6 +43,11 @@ extern "C" {
 #define FCNTL_IEEE_BLINK_ANC_64 0x57        //!< Anchor blink frame control
 #define FCNTL_IEEE_RANGE_16     0x8841      //!< Range frame control 
 #define FCNTL_IEEE_PROVISION_16 0x8844      //!< Provision frame control
+#define FCNTL_IEEE_DATA_ACK_16  0x8861      //!< Data frame control, 16-bit addressing, acknowledgement requested
+#define FCNTL_IEEE_ACK          0x0002      //!< Acknowledgement frame control
+#define FCNTL_IEEE_FTYPE_MASK   0x0007      //!< Frame type field of the frame control
+#define FCNTL_IEEE_SECURITY     0x0008      //!< Security enabled bit of the frame control
+#define FCNTL_IEEE_ACK_REQ      0x0020      //!< Acknowledgement request bit of the frame control
 
 //! IEEE 802.15.4e standard blink. It is a 12-byte frame composed of the following fields.
 typedef union{
@@ -113,6 +118,16 @@ typedef union {
     uint8_t array[sizeof(struct _ieee_std_frame_t)];  //!< Array of size standard frame
 } ieee_std_frame_t;
 
+//! IEEE 802.15.4 acknowledgement frame, sent by the transceiver when auto-ACK is enabled.
+typedef union {
+//! Structure of acknowledgement frame
+    struct _ieee_ack_frame_t{
+        uint16_t fctrl;             //!< Frame control (0x0002 to indicate an acknowledgement)
+        uint8_t seq_num;            //!< Sequence number of the acknowledged frame
+    }__attribute__((__packed__,aligned(1)));
+    uint8_t array[sizeof(struct _ieee_ack_frame_t)];  //!< Array of size acknowledgement frame
+} ieee_ack_frame_t;
+
 
 #ifdef __cplusplus
 }
@@ -96,6 +96,37 @@ typedef struct _dw1000_dev_rxdiag_t{
     uint16_t    pacc_cnt;                   //!<  Count of preamble symbols accumulated
 } __attribute__((packed, aligned(1))) dw1000_dev_rxdiag_t;
 
+#define DW1000_OTP_CALIB_NCHAN (8)     //!< Channel slots in calibration snapshot, indexed by channel number
+#define DW1000_OTP_CALIB_NPRF  (2)     //!< PRF slots in calibration snapshot, indexed by prf - DWT_PRF_16M
+
+//! Per channel and PRF calibration extension, values not held in OTP.
+typedef struct _dw1000_otp_calib_chan_t{
+    uint32_t power;                    //!< TX_POWER register value
+    uint16_t rx_antenna_delay;         //!< Receive antenna delay
+    uint16_t tx_antenna_delay;         //!< Transmit antenna delay
+    uint8_t PGdly;                     //!< TX_CAL pulse generator delay
+    uint8_t valid;                     //!< Entry holds calibrated values
+} dw1000_otp_calib_chan_t;
+
+//! Calibration snapshot, read once from OTP and reused on reset and reconfiguration.
+typedef struct _dw1000_otp_calib_t{
+    uint32_t part_id;                  //!< OTP_PARTID_ADDRESS
+    uint32_t lot_id;                   //!< OTP_LOTID_ADDRESS
+    uint32_t ldo_tune;                 //!< OTP_LDOTUNE_ADDRESS
+    uint16_t xtrim;                    //!< OTP_XTRIM_ADDRESS, trim in bits 0-4 and revision in bits 8-15
+    uint8_t vbat;                      //!< OTP_VBAT_ADDRESS
+    uint8_t vtemp;                     //!< OTP_VTEMP_ADDRESS
+    dw1000_otp_calib_chan_t chan[DW1000_OTP_CALIB_NPRF][DW1000_OTP_CALIB_NCHAN]; //!< Per channel and PRF extensions
+    uint16_t crc;                      //!< CRC16 over all preceding fields
+} dw1000_otp_calib_t;
+
+//! Calibration extension in use and the configured antenna delays it replaced
+typedef struct _dw1000_otp_calib_applied_t{
+    dw1000_otp_calib_chan_t chan;      //!< Entry applied, valid clear if none
+    uint16_t rx_antenna_delay;         //!< Configured receive antenna delay
+    uint16_t tx_antenna_delay;         //!< Configured transmit antenna delay
+} dw1000_otp_calib_applied_t;
+
 struct _dw1000_dev_instance_t;
 
 //! Device instance parameters.
@@ -118,7 +149,12 @@ typedef struct _dw1000_dev_instance_t{
     uint8_t otp_vbat;              //!< OTP parameter for voltage 
     uint8_t otp_temp;              //!< OTP parameter for temperature
     uint8_t xtal_trim;             //!< Crystal trim
+    dw1000_otp_calib_t otp_calib;  //!< Calibration snapshot
+#if MYNEWT_VAL(DW1000_OTP_CALIB_APPLY)
+    dw1000_otp_calib_applied_t otp_applied; //!< Calibration extension applied by dw1000_mac_config
+#endif
     uint32_t sys_cfg_reg;          //!< System config register
+    uint16_t framefilter;          //!< Frame types accepted when frame filtering is enabled
     uint32_t tx_fctrl;             //!< Transmit frame control register parameter 
     uint32_t sys_status;           //!< SYS_STATUS_ID for current event
     
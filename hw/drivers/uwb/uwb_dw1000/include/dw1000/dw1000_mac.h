@@ -84,6 +84,8 @@ extern "C" {
 #define DWT_FF_ACK_EN               0x010           //!< Ack frames allowed
 #define DWT_FF_MAC_EN               0x020           //!< MAC control frames allowed
 #define DWT_FF_RSVD_EN              0x040           //!< Reserved frame types allowed
+#define DWT_FF_TYPE4_EN             0x080           //!< Frame type 4 allowed
+#define DWT_FF_TYPE5_EN             0x100           //!< Frame type 5 allowed
 
 
 //! DW1000 SLEEP and WAKEUP configuration parameters.
@@ -150,7 +152,9 @@ struct uwb_dev_status dw1000_stop_rx(struct _dw1000_dev_instance_t * inst);
 void dw1000_write_tx_fctrl(struct _dw1000_dev_instance_t * inst, uint16_t txFrameLength, uint16_t txBufferOffset);
 struct uwb_dev_status dw1000_sync_rxbufptrs(struct _dw1000_dev_instance_t * inst);
 struct uwb_dev_status dw1000_read_accdata(struct _dw1000_dev_instance_t * inst, uint8_t *buffer, uint16_t len, uint16_t accOffset);
-struct uwb_dev_status dw1000_enable_autoack(struct _dw1000_dev_instance_t * inst, uint8_t delay);
+struct uwb_dev_status dw1000_set_autoack(struct _dw1000_dev_instance_t * inst, bool enable);
+struct uwb_dev_status dw1000_set_autoack_delay(struct _dw1000_dev_instance_t * inst, uint8_t delay);
+struct uwb_dev_status dw1000_mac_set_panadr(struct _dw1000_dev_instance_t * inst, uint16_t pan_id, uint16_t short_address);
 struct uwb_dev_status dw1000_set_dblrxbuff(struct _dw1000_dev_instance_t * inst, bool flag);
 struct uwb_dev_status dw1000_set_rx_timeout(struct _dw1000_dev_instance_t * inst, uint16_t timeout);
 struct uwb_dev_status dw1000_adj_rx_timeout(struct _dw1000_dev_instance_t * inst, uint16_t timeout);
@@ -159,6 +163,7 @@ float dw1000_calc_rssi(struct _dw1000_dev_instance_t * inst, struct _dw1000_dev_
 float dw1000_get_rssi(struct _dw1000_dev_instance_t * inst);
 float dw1000_calc_fppl(struct _dw1000_dev_instance_t * inst, struct _dw1000_dev_rxdiag_t * diag);
 float dw1000_get_fppl(struct _dw1000_dev_instance_t * inst);
+float dw1000_calc_fp_snr(struct _dw1000_dev_instance_t * inst, struct _dw1000_dev_rxdiag_t * diag);
 float dw1000_estimate_los(float rssi, float fppl);
     
 int32_t dw1000_read_carrier_integrator(struct _dw1000_dev_instance_t * inst);
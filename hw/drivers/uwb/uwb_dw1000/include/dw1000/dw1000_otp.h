@@ -34,6 +34,7 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -52,7 +53,19 @@ extern "C" {
 #define OTP_XTRIM_ADDRESS  (0x1E)         //!< OTP address definition for crystal trim
 
 uint32_t _dw1000_otp_read(struct _dw1000_dev_instance_t * inst, uint16_t address);
-void dw1000_opt_read(struct _dw1000_dev_instance_t * inst, uint32_t address, uint32_t * buffer, uint16_t length);
+void dw1000_phy_otp_read(struct _dw1000_dev_instance_t * inst, uint32_t address, uint32_t * buffer, uint16_t length);
+
+uint16_t dw1000_otp_calib_crc(const dw1000_otp_calib_t * calib);
+bool dw1000_otp_calib_valid(const dw1000_otp_calib_t * calib);
+void dw1000_otp_calib_read(struct _dw1000_dev_instance_t * inst);
+void dw1000_otp_calib_load(struct _dw1000_dev_instance_t * inst);
+int dw1000_otp_calib_import(struct _dw1000_dev_instance_t * inst, const dw1000_otp_calib_t * calib);
+void dw1000_otp_calib_export(struct _dw1000_dev_instance_t * inst, dw1000_otp_calib_t * calib);
+dw1000_otp_calib_chan_t * dw1000_otp_calib_chan(struct _dw1000_dev_instance_t * inst, uint8_t channel, uint8_t prf);
+int dw1000_otp_calib_set_chan(struct _dw1000_dev_instance_t * inst, uint8_t channel, uint8_t prf, const dw1000_otp_calib_chan_t * entry);
+#if MYNEWT_VAL(DW1000_OTP_CALIB_APPLY)
+void dw1000_otp_calib_apply(struct _dw1000_dev_instance_t * inst, uint8_t channel, uint8_t prf, struct uwb_dev_txrf_config * txrf);
+#endif
 
 #ifdef __cplusplus
 }
@@ -50,6 +50,9 @@ STATS_SECT_START(mac_stat_section)
     STATS_SECT_ENTRY(LDE_err)
     STATS_SECT_ENTRY(RX_err)
     STATS_SECT_ENTRY(TXBUF_err)
+    STATS_SECT_ENTRY(AAT_cnt)
+    STATS_SECT_ENTRY(IRQ_cnt)
+    STATS_SECT_ENTRY(IRQ_usec)
 STATS_SECT_END
 #endif
 
@@ -32,6 +32,7 @@
 #include <dw1000/dw1000_hal.h>
 #include <dw1000/dw1000_dev.h>
 #include <dw1000/dw1000_regs.h>
+#include <dw1000/dw1000_otp.h>
 
 #include <shell/shell.h>
 #include <console/console.h>
@@ -47,6 +48,9 @@
 #if MYNEWT_VAL(SURVEY_ENABLED)
 #include <survey/survey.h>
 #endif
+#if MYNEWT_VAL(CLI_BATCH_ENABLED)
+#include <cli_batch/cli_batch.h>
+#endif
 
 
 #if MYNEWT_VAL(DW1000_CLI)
@@ -56,6 +60,7 @@ static int dw1000_cli_cmd(int argc, char **argv);
 #if MYNEWT_VAL(SHELL_CMD_HELP)
 const struct shell_param cmd_dw1000_param[] = {
     {"dump", "[instance] dump all registers"},
+    {"otp", "[instance] show calibration snapshot"},
     {NULL,NULL},
 };
 
@@ -72,6 +77,12 @@ static struct shell_cmd shell_dw1000_cmd = {
 #endif
 };
 
+#if MYNEWT_VAL(CLI_BATCH_ENABLED)
+static struct cli_batch_cmd batch_dw1000_cmd = {
+    .cmd = &shell_dw1000_cmd,
+};
+#endif
+
 static void
 dw1000_dump_registers(struct _dw1000_dev_instance_t * inst)
 {
@@ -143,6 +154,27 @@ dw1000_dump_registers(struct _dw1000_dev_instance_t * inst)
 #endif
 }
 
+static void
+dw1000_dump_otp_calib(struct _dw1000_dev_instance_t * inst)
+{
+    dw1000_otp_calib_t * calib = &inst->otp_calib;
+
+    console_printf("{\"part_id\"=\"0x%08lX\",\"lot_id\"=\"0x%08lX\",\"ldo_tune\"=\"0x%08lX\",",
+                   (unsigned long)calib->part_id, (unsigned long)calib->lot_id, (unsigned long)calib->ldo_tune);
+    console_printf("\"xtrim\"=\"0x%04X\",\"vbat\"=%d,\"vtemp\"=%d,\"valid\"=%d}\n",
+                   calib->xtrim, calib->vbat, calib->vtemp, dw1000_otp_calib_valid(calib));
+    for (int p = 0; p < DW1000_OTP_CALIB_NPRF; p++) {
+        for (int c = 0; c < DW1000_OTP_CALIB_NCHAN; c++) {
+            dw1000_otp_calib_chan_t * chan = &calib->chan[p][c];
+            if (!chan->valid)
+                continue;
+            console_printf("{\"chan\"=%d,\"prf\"=%d,\"power\"=\"0x%08lX\",\"pgdly\"=\"0x%02X\",\"rx_antd\"=%d,\"tx_antd\"=%d}\n",
+                           c, p + DWT_PRF_16M, (unsigned long)chan->power, chan->PGdly,
+                           chan->rx_antenna_delay, chan->tx_antenna_delay);
+        }
+    }
+}
+
 static void
 dw1000_cli_too_few_args(void)
 {
@@ -157,7 +189,7 @@ dw1000_cli_cmd(int argc, char **argv)
     
     if (argc < 2) {
         dw1000_cli_too_few_args();
-        return 0;
+        return OS_EINVAL;
     }
     
     if (!strcmp(argv[1], "dump")) {
@@ -168,8 +200,17 @@ dw1000_cli_cmd(int argc, char **argv)
         }
         inst = hal_dw1000_inst(inst_n);
         dw1000_dump_registers(inst);
+    } else if (!strcmp(argv[1], "otp")) {
+        if (argc < 3) {
+            inst_n=0;
+        } else {
+            inst_n = strtol(argv[2], NULL, 0);
+        }
+        inst = hal_dw1000_inst(inst_n);
+        dw1000_dump_otp_calib(inst);
     } else {
         console_printf("Unknown cmd\n");
+        return OS_EINVAL;
     }
 
     return 0;
@@ -182,6 +223,9 @@ int
 dw1000_cli_register(void)
 {
 #if MYNEWT_VAL(DW1000_CLI)
+#if MYNEWT_VAL(CLI_BATCH_ENABLED)
+    cli_batch_register(&batch_dw1000_cmd);
+#endif
     return shell_cmd_register(&shell_dw1000_cmd);
 #else
     return 0;
@@ -316,7 +316,11 @@ retry:
     }
     inst->uwb_dev.euid = (((uint64_t)inst->lot_id) << 32) + inst->part_id;
 
+    /* Frame types accepted once filtering is enabled, kept across resets */
+    if (inst->framefilter == 0)
+        inst->framefilter = DWT_FF_BEACON_EN | DWT_FF_DATA_EN | DWT_FF_RSVD_EN | DWT_FF_TYPE4_EN | DWT_FF_TYPE5_EN;
     dw1000_set_panid(inst,inst->uwb_dev.pan_id);
+    dw1000_set_address16(inst,inst->uwb_dev.uid);
     dw1000_mac_init(inst, NULL);
 
     return OS_OK;
@@ -721,13 +725,13 @@ uwb_dw1000_set_on_error_continue(struct uwb_dev * dev, bool enable)
 inline static void
 uwb_dw1000_set_panid(struct uwb_dev * dev, uint16_t pan_id)
 {
-    return dw1000_set_panid((dw1000_dev_instance_t *)dev, pan_id);
+    dw1000_mac_set_panadr((dw1000_dev_instance_t *)dev, pan_id, dev->uid);
 }
 
 inline static void
 uwb_dw1000_set_uid(struct uwb_dev * dev, uint16_t uid)
 {
-    return dw1000_set_address16((dw1000_dev_instance_t *)dev, uid);
+    dw1000_mac_set_panadr((dw1000_dev_instance_t *)dev, dev->pan_id, uid);
 }
 
 inline static void
@@ -771,12 +775,36 @@ uwb_dw1000_calc_fppl(struct uwb_dev * dev, struct uwb_dev_rxdiag * diag)
     return dw1000_calc_fppl((dw1000_dev_instance_t *)dev, (struct _dw1000_dev_rxdiag_t*)diag);
 }
 
+inline static float
+uwb_dw1000_calc_fp_snr(struct uwb_dev * dev, struct uwb_dev_rxdiag * diag)
+{
+    return dw1000_calc_fp_snr((dw1000_dev_instance_t *)dev, (struct _dw1000_dev_rxdiag_t*)diag);
+}
+
 inline static float
 uwb_dw1000_estimate_los(struct uwb_dev * dev, float rssi, float fppl)
 {
     return dw1000_estimate_los(rssi, fppl);
 }
 
+inline static struct uwb_dev_status
+uwb_dw1000_mac_framefilter(struct uwb_dev * dev, uint16_t enable)
+{
+    return dw1000_mac_framefilter((dw1000_dev_instance_t *)dev, enable);
+}
+
+inline static struct uwb_dev_status
+uwb_dw1000_set_autoack(struct uwb_dev * dev, bool enable)
+{
+    return dw1000_set_autoack((dw1000_dev_instance_t *)dev, enable);
+}
+
+inline static struct uwb_dev_status
+uwb_dw1000_set_autoack_delay(struct uwb_dev * dev, uint8_t delay)
+{
+    return dw1000_set_autoack_delay((dw1000_dev_instance_t *)dev, delay);
+}
+
 static const struct uwb_driver_funcs dw1000_uwb_funcs = {
     .uf_mac_config = uwb_dw1000_mac_config,
     .uf_txrf_config = uwb_dw1000_txrf_config,
@@ -812,11 +840,15 @@ static const struct uwb_driver_funcs dw1000_uwb_funcs = {
     .uf_set_panid = uwb_dw1000_set_panid,
     .uf_set_uid = uwb_dw1000_set_uid,
     .uf_set_euid = uwb_dw1000_set_euid,
+    .uf_mac_framefilter = uwb_dw1000_mac_framefilter,
+    .uf_set_autoack = uwb_dw1000_set_autoack,
+    .uf_set_autoack_delay = uwb_dw1000_set_autoack_delay,
     .uf_calc_clock_offset_ratio = uwb_dw1000_calc_clock_offset_ratio,
     .uf_get_rssi = uwb_dw1000_get_rssi,
     .uf_get_fppl = uwb_dw1000_get_fppl,
     .uf_calc_rssi = uwb_dw1000_calc_rssi,
     .uf_calc_fppl = uwb_dw1000_calc_fppl,
+    .uf_calc_fp_snr = uwb_dw1000_calc_fp_snr,
     .uf_estimate_los = uwb_dw1000_estimate_los,
 };
 
@@ -90,6 +90,9 @@ static dw1000_dev_instance_t hal_dw1000_instances[]= {
 #if MYNEWT_VAL(DW1000_MAC_FILTERING)
                     .framefilter_enabled = 1,
 #endif
+#if MYNEWT_VAL(DW1000_MAC_AUTOACK)
+                    .autoack_enabled = 1,
+#endif
 #if MYNEWT_VAL(DW1000_BIAS_CORRECTION_ENABLED)
                     .bias_correction_enable = 1,
 #endif
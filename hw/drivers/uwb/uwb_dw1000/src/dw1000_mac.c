@@ -58,6 +58,9 @@ STATS_NAME_START(mac_stat_section)
     STATS_NAME(mac_stat_section, LDE_err)
     STATS_NAME(mac_stat_section, RX_err)
     STATS_NAME(mac_stat_section, TXBUF_err)
+    STATS_NAME(mac_stat_section, AAT_cnt)
+    STATS_NAME(mac_stat_section, IRQ_cnt)
+    STATS_NAME(mac_stat_section, IRQ_usec)
 STATS_NAME_END(mac_stat_section)
 
 #define MAC_STATS_INC(__X) STATS_INC(inst->stat, __X)
@@ -357,6 +360,11 @@ dw1000_mac_config(struct _dw1000_dev_instance_t * inst,
 
     dw1000_write_reg(inst, CHAN_CTRL_ID, 0, regval, sizeof(uint32_t)) ;
 
+#if MYNEWT_VAL(DW1000_OTP_CALIB_APPLY)
+    /* Apply per channel and PRF calibration from the snapshot, if any */
+    dw1000_otp_calib_apply(inst, chan, config->prf, &config->txrf);
+#endif
+
     /* Set up TX Preamble Size, PRF and Data Rate */
     inst->tx_fctrl = (((uint32_t)(config->tx.preambleLength | config->prf)) << TX_FCTRL_TXPRF_SHFT) |
         (((uint32_t)config->dataRate) << TX_FCTRL_TXBR_SHFT);
@@ -369,11 +377,15 @@ dw1000_mac_config(struct _dw1000_dev_instance_t * inst,
     /* Request TX start and TRX off at the same time */
     dw1000_write_reg(inst, SYS_CTRL_ID, SYS_CTRL_OFFSET, SYS_CTRL_TXSTRT | SYS_CTRL_TRXOFF, sizeof(uint8_t));
 
-#if MYNEWT_VAL(DW1000_MAC_FILTERING)
-    if(inst->config.framefilter_enabled){
-        dw1000_mac_framefilter(inst, DWT_FF_BEACON_EN | DWT_FF_DATA_EN | DWT_FF_RSVD_EN );
+    /* The sys_cfg write above holds the filter and auto-ACK bits last applied, reapply
+     * them in case the caller's config differs */
+    if(config->framefilter_enabled){
+        bool autoack = config->autoack_enabled;
+        dw1000_mac_framefilter(inst, inst->framefilter);
+        dw1000_set_autoack(inst, autoack);
+    }else{
+        dw1000_mac_framefilter(inst, DWT_FF_NOTYPE_EN);
     }
-#endif
     
     if (config->rxauto_enable)
         assert(config->trxoff_enable);
@@ -897,12 +909,18 @@ dw1000_mac_framefilter(struct _dw1000_dev_instance_t * inst, uint16_t enable)
 
     inst->uwb_dev.config.framefilter_enabled = (enable > 0);
     if(inst->uwb_dev.config.framefilter_enabled){   // Enable frame filtering and configure frame types
+        inst->framefilter = enable & SYS_CFG_FF_ALL_EN;
         sys_cfg_reg &= ~(SYS_CFG_FF_ALL_EN);  // Clear all
-        sys_cfg_reg |= (enable & SYS_CFG_FF_ALL_EN) | SYS_CFG_FFE;
-    }else
-        sys_cfg_reg &= ~(SYS_CFG_FFE);
+        sys_cfg_reg |= inst->framefilter | SYS_CFG_FFE;
+        if(inst->uwb_dev.config.autoack_enabled)
+            sys_cfg_reg |= SYS_CFG_FFAA;       // Acks to our own requests
+    }else{
+        sys_cfg_reg &= ~(SYS_CFG_FFE | SYS_CFG_AUTOACK);    // Auto-ACK depends on the filter
+        inst->uwb_dev.config.autoack_enabled = 0;
+    }
 
     dw1000_write_reg(inst, SYS_CFG_ID,0, sys_cfg_reg, sizeof(uint32_t)); 
+    inst->sys_cfg_reg = sys_cfg_reg;
     err = dpl_mutex_release(&inst->mutex);  
     assert(err == DPL_OK);
 
@@ -912,12 +930,13 @@ dw1000_mac_framefilter(struct _dw1000_dev_instance_t * inst, uint16_t enable)
 
 
 /**
- * API to enable the auto-ACK feature. If the delay (parameter) is 0, the ACK will be sent as-soon-as-possable
- * otherwise it will be sent with a programmed delay (in symbols), max is 255.
+ * API to enable the auto-ACK feature. Data and MAC command frames addressed to this device with the ACK request
+ * bit set are acknowledged by the transceiver without involving the host. Acknowledgement frames are accepted
+ * while auto-ACK is enabled.
  * NOTE: needs to have frame filtering enabled as well.
  *
  * @param inst    Pointer to _dw1000_dev_instance_t.
- * @param enable  If non-zero the ACK is sent after this delay, max is 255.
+ * @param enable  Enables or disables auto-ACK.
  * @return struct uwb_dev_status
  *
  */
@@ -933,12 +952,15 @@ dw1000_set_autoack(struct _dw1000_dev_instance_t * inst, bool enable)
 
     inst->uwb_dev.config.autoack_enabled = (enable > 0);
     if(inst->uwb_dev.config.autoack_enabled){
-        sys_cfg_reg |= SYS_CFG_AUTOACK;
-        dw1000_write_reg(inst, SYS_CFG_ID,0, sys_cfg_reg, sizeof(uint32_t));
+        // A device requesting acknowledgements also has to receive them
+        sys_cfg_reg |= SYS_CFG_AUTOACK | SYS_CFG_FFAA;
     } else {
         sys_cfg_reg &= ~SYS_CFG_AUTOACK;
-        dw1000_write_reg(inst, SYS_CFG_ID,0, sys_cfg_reg, sizeof(uint32_t));
+        if ((inst->framefilter & DWT_FF_ACK_EN) == 0)
+            sys_cfg_reg &= ~SYS_CFG_FFAA;
     }
+    dw1000_write_reg(inst, SYS_CFG_ID,0, sys_cfg_reg, sizeof(uint32_t));
+    inst->sys_cfg_reg = sys_cfg_reg;
 
     err = dpl_mutex_release(&inst->mutex);  
     assert(err == DPL_OK);
@@ -966,8 +988,7 @@ dw1000_set_autoack_delay(struct _dw1000_dev_instance_t * inst, uint8_t delay)
     assert(err == DPL_OK);
 
     inst->uwb_dev.config.autoack_delay_enabled = (delay > 0);
-    if (inst->control.autoack_delay_enabled)
-        dw1000_write_reg(inst, ACK_RESP_T_ID, ACK_RESP_T_ACK_TIM_OFFSET, delay, sizeof(uint8_t)); // In symbols
+    dw1000_write_reg(inst, ACK_RESP_T_ID, ACK_RESP_T_ACK_TIM_OFFSET, delay, sizeof(uint8_t)); // In symbols
 
     err = dpl_mutex_release(&inst->mutex);  
     assert(err == DPL_OK);
@@ -978,6 +999,31 @@ dw1000_set_autoack_delay(struct _dw1000_dev_instance_t * inst, uint8_t delay)
 }
 
 
+/**
+ * API to program the PAN ID and short address the frame filter and auto-ACK match against.
+ * Takes effect for the next frame received, also while the receiver is on.
+ *
+ * @param inst           Pointer to _dw1000_dev_instance_t.
+ * @param pan_id         PAN identifier.
+ * @param short_address  16-bit short address.
+ * @return struct uwb_dev_status
+ *
+ */
+struct uwb_dev_status
+dw1000_mac_set_panadr(struct _dw1000_dev_instance_t * inst, uint16_t pan_id, uint16_t short_address)
+{
+    dpl_error_t err = dpl_mutex_pend(&inst->mutex,  DPL_TIMEOUT_NEVER); // Block if request pending
+    assert(err == DPL_OK);
+
+    dw1000_write_reg(inst, PANADR_ID, 0, ((uint32_t)pan_id << 16) | short_address, sizeof(uint32_t));
+
+    err = dpl_mutex_release(&inst->mutex);  
+    assert(err == DPL_OK);
+
+    return inst->uwb_dev.status;
+}
+
+
 /**
  * Wait-for-Response turn-around Time. This 20-bit field is used to configure the turn-around time between TX complete 
  * and RX enable when the wait for response function is being used. This function is enabled by the WAIT4RESP control in 
@@ -1207,7 +1253,8 @@ dw1000_tasks_init(struct _dw1000_dev_instance_t * inst)
     /* Setup interrupt mask */
     dw1000_phy_interrupt_mask(inst,          SYS_MASK_MCPLOCK | SYS_MASK_MRXDFR | SYS_MASK_MLDEERR |  SYS_MASK_MTXFRS  | SYS_MASK_ALL_RX_TO   | SYS_MASK_ALL_RX_ERR | SYS_MASK_MTXBERR, false);
     dw1000_write_reg(inst, SYS_STATUS_ID, 0, SYS_STATUS_SLP2INIT | SYS_STATUS_CPLOCK| SYS_STATUS_RXDFR | SYS_STATUS_LDEERR | SYS_STATUS_TXFRS | SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR | SYS_STATUS_TXBERR, sizeof(uint32_t));
-    dw1000_phy_interrupt_mask(inst,          SYS_MASK_MCPLOCK | SYS_MASK_MRXDFR | SYS_MASK_MLDEERR | SYS_MASK_MTXFRS  | SYS_MASK_ALL_RX_TO   | SYS_MASK_ALL_RX_ERR | SYS_MASK_MTXBERR, true);
+    /* Frames rejected by the frame filter should not wake the host */
+    dw1000_phy_interrupt_mask(inst,          SYS_MASK_MCPLOCK | SYS_MASK_MRXDFR | SYS_MASK_MLDEERR | SYS_MASK_MTXFRS  | SYS_MASK_ALL_RX_TO   | (SYS_MASK_ALL_RX_ERR & ~SYS_MASK_MAFFREJ) | SYS_MASK_MTXBERR, true);
 }
 
 
@@ -1272,9 +1319,20 @@ dw1000_interrupt_ev_cb(struct dpl_event *ev)
 {
     dw1000_dev_instance_t * inst = dpl_event_get_arg(ev);
 
+#if MYNEWT_VAL(DW1000_MAC_STATS)
+    uint32_t irq_start = os_cputime_get32();
+    MAC_STATS_INC(IRQ_cnt);
+#endif
     inst->sys_status = dw1000_read_reg(inst, SYS_STATUS_ID, 0, sizeof(uint32_t)); // Read status register low 32bits
     //printf("inst->sys_status= %lX\n",inst->sys_status);
 
+    // A frame rejected by the frame filter is not an error, the receiver has already re-enabled itself.
+    // The event is masked and only seen here alongside another event.
+    if(inst->sys_status & SYS_STATUS_AFFREJ){
+        dw1000_write_reg(inst, SYS_STATUS_ID, 0, SYS_STATUS_AFFREJ, sizeof(uint32_t));
+        inst->sys_status &= ~SYS_STATUS_AFFREJ;
+    }
+
     // Set status flags
     inst->uwb_dev.status.rx_error = (inst->sys_status & SYS_STATUS_ALL_RX_ERR) !=0;
     inst->uwb_dev.status.rx_timeout_error = (inst->sys_status & SYS_STATUS_ALL_RX_TO) !=0;
@@ -1336,7 +1394,7 @@ dw1000_interrupt_ev_cb(struct dpl_event *ev)
         // implementation works only for IEEE802.15.4-2011 compliant frames).
         // This issue is not documented at the time of writing this code. It should be in next release of DW1000 User Manual (v2.09, from July 2016).
 
-        if((inst->sys_status & SYS_STATUS_AAT) && ((inst->uwb_dev.fctrl & MAC_FTYPE_ACK) == 0)){
+        if((inst->sys_status & SYS_STATUS_AAT) && ((inst->uwb_dev.fctrl & FCNTL_IEEE_ACK_REQ) == 0)){
             dw1000_write_reg(inst, SYS_STATUS_ID, 0, SYS_STATUS_AAT, sizeof(uint8_t));     // Clear AAT status bit in register
             inst->sys_status &= ~SYS_STATUS_AAT; // Clear AAT status bit in callback data register copy
         }
@@ -1416,7 +1474,13 @@ dw1000_interrupt_ev_cb(struct dpl_event *ev)
 
     // Handle TX confirmation event
     if(inst->sys_status & SYS_STATUS_TXFRS){
-        MAC_STATS_INC(TFG_cnt);
+        // An acknowledgement sent by auto-ACK is not a frame any of the services transmitted
+        bool autoack_tx = (inst->sys_status & SYS_STATUS_AAT) && inst->uwb_dev.config.autoack_enabled;
+        if (autoack_tx){
+            MAC_STATS_INC(AAT_cnt);
+        }else{
+            MAC_STATS_INC(TFG_cnt);
+        }
 
         dw1000_write_reg(inst, SYS_STATUS_ID, 0, SYS_STATUS_ALL_TX, sizeof(uint32_t)); // Clear TX event bits
         // In the case where this TXFRS interrupt is due to the automatic transmission of an ACK solicited by a response (with ACK request bit set)
@@ -1438,7 +1502,7 @@ dw1000_interrupt_ev_cb(struct dpl_event *ev)
         
         // Call the corresponding callback if present
         struct uwb_mac_interface * cbs = NULL;
-        if(!(SLIST_EMPTY(&inst->uwb_dev.interface_cbs))){ 
+        if(!autoack_tx && !(SLIST_EMPTY(&inst->uwb_dev.interface_cbs))){ 
             SLIST_FOREACH(cbs, &inst->uwb_dev.interface_cbs, next){    
             if (cbs!=NULL && cbs->tx_complete_cb) 
                 if(cbs->tx_complete_cb((struct uwb_dev*)inst,cbs)) break;
@@ -1543,8 +1607,10 @@ dw1000_interrupt_ev_cb(struct dpl_event *ev)
                 if (cbs->sleep_cb((struct uwb_dev*)inst,cbs)) continue; 
             }   
         }         
-        return;
     }
+#if MYNEWT_VAL(DW1000_MAC_STATS)
+    MAC_STATS_INCN(IRQ_usec, os_cputime_ticks_to_usecs(os_cputime_get32() - irq_start));
+#endif
 }
 
 
@@ -1625,6 +1691,31 @@ dw1000_get_rssi(struct _dw1000_dev_instance_t * inst)
     return dw1000_calc_rssi(inst, &inst->rxdiag);
 }
 
+/**
+ * API to calculate the first path signal to noise ratio from an rxdiag
+ * structure, rms of the three first path amplitudes over the noise standard
+ * deviation. Both are accumulator values so the ratio carries the gain of the
+ * preamble symbols accumulated.
+ *
+ * @param inst  Pointer to _dw1000_dev_instance_t.
+ * @param diag  Pointer to _dw1000_dev_rxdiag_t.
+ *
+ * @return snr (dB) on success
+ */
+float
+dw1000_calc_fp_snr(struct _dw1000_dev_instance_t * inst,
+                   struct _dw1000_dev_rxdiag_t * diag)
+{
+    if (diag->pacc_cnt == 0 || diag->rx_std == 0) {
+        return -INFINITY;
+    }
+    float v = (float)diag->fp_amp*diag->fp_amp +
+        (float)diag->fp_amp2*diag->fp_amp2 +
+        (float)diag->fp_amp3*diag->fp_amp3;
+    v /= 3.0f * diag->rx_std * diag->rx_std;
+    return 10.0f*log10f(v);
+}
+
 /**
  * API to give a rough estimate of how likely the received packet is
  * line of sight (LOS). Taken from 4.7 of DW1000 manual.
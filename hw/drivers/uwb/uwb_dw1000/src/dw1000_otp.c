@@ -31,11 +31,13 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <stddef.h>
 #include <assert.h>
 #include <os/os.h>
 #include <hal/hal_spi.h>
 #include <hal/hal_gpio.h>
 
+#include <uwb/uwb_mac.h>
 #include <dw1000/dw1000_regs.h>
 #include <dw1000/dw1000_dev.h>
 #include <dw1000/dw1000_hal.h>
@@ -84,3 +86,201 @@ uint32_t _dw1000_otp_read(struct _dw1000_dev_instance_t * inst, uint16_t address
     return  (uint32_t) dw1000_read_reg(inst, OTP_IF_ID, OTP_RDAT, sizeof(uint32_t));
 }
 
+/**
+ * API to calculate the CRC16 (CCITT, poly 0x1021, init 0xffff) of a calibration snapshot.
+ * The crc field itself is excluded.
+ *
+ * @param calib    Pointer to dw1000_otp_calib_t.
+ * @return crc over all fields preceding calib->crc
+ */
+uint16_t dw1000_otp_calib_crc(const dw1000_otp_calib_t * calib)
+{
+    const uint8_t * data = (const uint8_t *) calib;
+    uint16_t crc = 0xffff;
+
+    for (uint16_t i = 0; i < offsetof(dw1000_otp_calib_t, crc); i++) {
+        crc ^= (uint16_t) data[i] << 8;
+        for (uint8_t j = 0; j < 8; j++)
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    }
+    return crc;
+}
+
+/**
+ * API to check that a calibration snapshot has been populated and is intact.
+ *
+ * @param calib    Pointer to dw1000_otp_calib_t.
+ * @return true if the stored crc matches the contents
+ */
+bool dw1000_otp_calib_valid(const dw1000_otp_calib_t * calib)
+{
+    return calib->part_id != 0 && calib->crc == dw1000_otp_calib_crc(calib);
+}
+
+/**
+ * API to read the OTP parameters into the calibration snapshot. Per channel extensions
+ * of an already valid snapshot are preserved. The caller must hold the system clock on XTAL,
+ * see dw1000_phy_otp_read().
+ *
+ * @param inst     Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+void dw1000_otp_calib_read(struct _dw1000_dev_instance_t * inst)
+{
+    dw1000_otp_calib_t * calib = &inst->otp_calib;
+
+    if (!dw1000_otp_calib_valid(calib))
+        memset(calib, 0, sizeof(dw1000_otp_calib_t));
+
+    calib->xtrim = _dw1000_otp_read(inst, OTP_XTRIM_ADDRESS) & 0xffff;
+    calib->ldo_tune = _dw1000_otp_read(inst, OTP_LDOTUNE_ADDRESS);
+    calib->part_id = _dw1000_otp_read(inst, OTP_PARTID_ADDRESS);
+    calib->lot_id = _dw1000_otp_read(inst, OTP_LOTID_ADDRESS);
+    calib->vbat = _dw1000_otp_read(inst, OTP_VBAT_ADDRESS);
+    calib->vtemp = _dw1000_otp_read(inst, OTP_VTEMP_ADDRESS);
+    calib->crc = dw1000_otp_calib_crc(calib);
+}
+
+/**
+ * API to populate the calibration snapshot. OTP is only read if the snapshot
+ * is not already valid, reset and reconfiguration paths therefore avoid the OTP transactions.
+ *
+ * @param inst     Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+void dw1000_otp_calib_load(struct _dw1000_dev_instance_t * inst)
+{
+    if (!dw1000_otp_calib_valid(&inst->otp_calib))
+        dw1000_otp_calib_read(inst);
+}
+
+/**
+ * API to import a calibration snapshot, e.g. one previously exported and kept in flash.
+ * The snapshot is rejected if the crc fails or if it belongs to a different part.
+ *
+ * @param inst     Pointer to dw1000_dev_instance_t.
+ * @param calib    Pointer to dw1000_otp_calib_t to import.
+ * @return OS_OK on success, OS_EINVAL if the snapshot is not valid for this device
+ */
+int dw1000_otp_calib_import(struct _dw1000_dev_instance_t * inst, const dw1000_otp_calib_t * calib)
+{
+    if (!dw1000_otp_calib_valid(calib))
+        return OS_EINVAL;
+
+    dw1000_phy_sysclk_XTAL(inst);
+    uint32_t part_id = _dw1000_otp_read(inst, OTP_PARTID_ADDRESS);
+    dw1000_phy_sysclk_SEQ(inst);
+
+    if (part_id != calib->part_id)
+        return OS_EINVAL;
+
+    memcpy(&inst->otp_calib, calib, sizeof(dw1000_otp_calib_t));
+    return OS_OK;
+}
+
+/**
+ * API to export the calibration snapshot for storage.
+ *
+ * @param inst     Pointer to dw1000_dev_instance_t.
+ * @param calib    Pointer to dw1000_otp_calib_t receiving the snapshot.
+ * @return void
+ */
+void dw1000_otp_calib_export(struct _dw1000_dev_instance_t * inst, dw1000_otp_calib_t * calib)
+{
+    memcpy(calib, &inst->otp_calib, sizeof(dw1000_otp_calib_t));
+}
+
+/**
+ * API to look up the per channel and PRF calibration extension.
+ *
+ * @param inst     Pointer to dw1000_dev_instance_t.
+ * @param channel  Channel number {1, 2, 3, 4, 5, 7}.
+ * @param prf      DWT_PRF_16M or DWT_PRF_64M.
+ * @return pointer to the entry if valid, NULL otherwise
+ */
+dw1000_otp_calib_chan_t * dw1000_otp_calib_chan(struct _dw1000_dev_instance_t * inst, uint8_t channel, uint8_t prf)
+{
+    uint8_t prf_idx = prf - DWT_PRF_16M;
+
+    if (channel >= DW1000_OTP_CALIB_NCHAN || prf_idx >= DW1000_OTP_CALIB_NPRF)
+        return NULL;
+    if (!inst->otp_calib.chan[prf_idx][channel].valid)
+        return NULL;
+    return &inst->otp_calib.chan[prf_idx][channel];
+}
+
+/**
+ * API to set or clear a per channel and PRF calibration extension. Applied by dw1000_mac_config()
+ * on the next configuration of that channel and PRF when DW1000_OTP_CALIB_APPLY is set.
+ *
+ * @param inst     Pointer to dw1000_dev_instance_t.
+ * @param channel  Channel number {1, 2, 3, 4, 5, 7}.
+ * @param prf      DWT_PRF_16M or DWT_PRF_64M.
+ * @param entry    Pointer to dw1000_otp_calib_chan_t, NULL clears the entry.
+ * @return OS_OK on success, OS_EINVAL on bad channel or prf
+ */
+int dw1000_otp_calib_set_chan(struct _dw1000_dev_instance_t * inst, uint8_t channel, uint8_t prf, const dw1000_otp_calib_chan_t * entry)
+{
+    uint8_t prf_idx = prf - DWT_PRF_16M;
+
+    if (channel >= DW1000_OTP_CALIB_NCHAN || prf_idx >= DW1000_OTP_CALIB_NPRF)
+        return OS_EINVAL;
+
+    dw1000_otp_calib_chan_t * chan = &inst->otp_calib.chan[prf_idx][channel];
+    if (entry) {
+        memcpy(chan, entry, sizeof(dw1000_otp_calib_chan_t));
+        chan->valid = 1;
+    } else {
+        memset(chan, 0, sizeof(dw1000_otp_calib_chan_t));
+    }
+    inst->otp_calib.crc = dw1000_otp_calib_crc(&inst->otp_calib);
+    return OS_OK;
+}
+
+#if MYNEWT_VAL(DW1000_OTP_CALIB_APPLY)
+/**
+ * API to apply the calibration extension of a channel and PRF. Its tx power and PG delay
+ * are written over the configured ones, which are left untouched in txrf, and its antenna
+ * delays replace the configured ones until a channel without extension is configured.
+ * Antenna delays changed while an extension was in use are kept as the configured ones.
+ *
+ * @param inst     Pointer to dw1000_dev_instance_t.
+ * @param channel  Channel number {1, 2, 3, 4, 5, 7}.
+ * @param prf      DWT_PRF_16M or DWT_PRF_64M.
+ * @param txrf     Configured tx power and PG delay.
+ * @return void
+ */
+void dw1000_otp_calib_apply(struct _dw1000_dev_instance_t * inst, uint8_t channel, uint8_t prf, struct uwb_dev_txrf_config * txrf)
+{
+    dw1000_otp_calib_applied_t * applied = &inst->otp_applied;
+    dw1000_otp_calib_chan_t * calib = dw1000_otp_calib_chan(inst, channel, prf);
+
+    if (applied->chan.valid) {
+        if (inst->uwb_dev.rx_antenna_delay == applied->chan.rx_antenna_delay)
+            inst->uwb_dev.rx_antenna_delay = applied->rx_antenna_delay;
+        if (inst->uwb_dev.tx_antenna_delay == applied->chan.tx_antenna_delay)
+            inst->uwb_dev.tx_antenna_delay = applied->tx_antenna_delay;
+        applied->chan.valid = 0;
+        if (calib == NULL) {
+            dw1000_phy_config_txrf(inst, txrf);
+            dw1000_phy_set_rx_antennadelay(inst, inst->uwb_dev.rx_antenna_delay);
+            dw1000_phy_set_tx_antennadelay(inst, inst->uwb_dev.tx_antenna_delay);
+        }
+    }
+    if (calib == NULL)
+        return;
+
+    struct uwb_dev_txrf_config calib_txrf = *txrf;
+    calib_txrf.PGdly = calib->PGdly;
+    calib_txrf.power = calib->power;
+    dw1000_phy_config_txrf(inst, &calib_txrf);
+
+    applied->chan = *calib;
+    applied->rx_antenna_delay = inst->uwb_dev.rx_antenna_delay;
+    applied->tx_antenna_delay = inst->uwb_dev.tx_antenna_delay;
+    inst->uwb_dev.rx_antenna_delay = calib->rx_antenna_delay;
+    inst->uwb_dev.tx_antenna_delay = calib->tx_antenna_delay;
+    dw1000_phy_set_rx_antennadelay(inst, inst->uwb_dev.rx_antenna_delay);
+    dw1000_phy_set_tx_antennadelay(inst, inst->uwb_dev.tx_antenna_delay);
+}
+#endif
@@ -182,27 +182,27 @@ dw1000_phy_init(struct _dw1000_dev_instance_t * inst, struct uwb_dev_txrf_config
     reg |= EC_CTRL_PLLLCK;
     dw1000_write_reg(inst, EXT_SYNC_ID, EC_CTRL_OFFSET, reg, sizeof(uint8_t));
 
-    // Read OTP revision number
-    uint32_t otp_addr = (uint32_t) _dw1000_otp_read(inst, OTP_XTRIM_ADDRESS) & 0xffff;    // Read 32 bit value, XTAL trim val is in low octet-0 (5 bits)
-    inst->otp_rev = (otp_addr >> 8) & 0xff;                                               // OTP revision is next byte
+    // Read OTP parameters once, later resets reuse the calibration snapshot
+    dw1000_otp_calib_load(inst);
+    dw1000_otp_calib_t * calib = &inst->otp_calib;
+    inst->otp_rev = (calib->xtrim >> 8) & 0xff;                                           // OTP revision is next byte
 
     // Load LDO tune from OTP and kick it if there is a value actually programmed.
-    uint32_t ldo_tune = _dw1000_otp_read(inst, OTP_LDOTUNE_ADDRESS);
-    if((ldo_tune & 0xFF) != 0){
+    if((calib->ldo_tune & 0xFF) != 0){
         dw1000_write_reg(inst, OTP_IF_ID, OTP_SF, OTP_SF_LDO_KICK, sizeof(uint8_t)); // Set load LDE kick bit
         inst->uwb_dev.status.LDO_enabled = 1; // LDO tune must be kicked at wake-up
     }
     // Load Part and Lot ID from OTP
-    inst->part_id = _dw1000_otp_read(inst, OTP_PARTID_ADDRESS);
-    inst->lot_id = _dw1000_otp_read(inst, OTP_LOTID_ADDRESS);
+    inst->part_id = calib->part_id;
+    inst->lot_id = calib->lot_id;
 
     // Load vbat and vtemp from OTP
-    inst->otp_vbat = _dw1000_otp_read(inst, OTP_VBAT_ADDRESS);
-    inst->otp_temp = _dw1000_otp_read(inst, OTP_VTEMP_ADDRESS);
+    inst->otp_vbat = calib->vbat;
+    inst->otp_temp = calib->vtemp;
     
     // XTAL trim value is set in OTP for DW1000 module and EVK/TREK boards but that might not be the case in a custom design
-    if (otp_addr & 0x1F) // A value of 0 means that the crystal has not been trimmed
-        inst->xtal_trim = otp_addr & 0x1F;
+    if (calib->xtrim & 0x1F) // A value of 0 means that the crystal has not been trimmed
+        inst->xtal_trim = calib->xtrim & 0x1F;
     else
         inst->xtal_trim = FS_XTALT_MIDRANGE ; // Set to mid-range if no calibration value inside
     // The 3 MSb in this 8-bit register must be kept to 0b011 to avoid any malfunction.
@@ -0,0 +1,163 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file aggr.h
+ * @brief MAC frame aggregation
+ *
+ * @details Small frames for the same destination are queued with
+ * aggr_send() and coalesced into one aggregate, paying preamble, sfd and
+ * phr once. An aggregate is sent when the next frame would not fit, when
+ * AGGR_MAX_SUBFRAMES are queued or AGGR_LATENCY_MS after the first frame was
+ * queued. Each subframe carries its index, length and a crc16; the receiver
+ * acknowledges unicast aggregates with a bitmap of the subframes it took and
+ * only the missing ones are resent. On receive every valid subframe is
+ * handed, as if received on its own, to the mac interfaces registered after
+ * aggregation. Queued frames are complete mac frames without fcs. Frames
+ * whose exchange depends on reception timestamps, ranging, must not be
+ * aggregated and consumers must not transmit from rx_complete_cb for an
+ * aggregated frame, the selective ack may still be on air. uwb_lwip queues
+ * its frames here with UWB_LWIP_AGGR.
+ */
+
+#ifndef _AGGR_H_
+#define _AGGR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stats/stats.h>
+#include <dpl/dpl.h>
+#include <uwb/uwb.h>
+#include <uwb/uwb_ftypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if MYNEWT_VAL(AGGR_MAX_SUBFRAMES) > 32
+#error "AGGR_MAX_SUBFRAMES must fit the 32 bit ack bitmap"
+#endif
+
+#if MYNEWT_VAL(AGGR_STATS)
+STATS_SECT_START(aggr_stat_section)
+    STATS_SECT_ENTRY(queued)
+    STATS_SECT_ENTRY(aggregates)
+    STATS_SECT_ENTRY(subframes)
+    STATS_SECT_ENTRY(retries)
+    STATS_SECT_ENTRY(acked)
+    STATS_SECT_ENTRY(partial)
+    STATS_SECT_ENTRY(dropped)
+    STATS_SECT_ENTRY(rx_aggregates)
+    STATS_SECT_ENTRY(rx_subframes)
+    STATS_SECT_ENTRY(rx_crc_error)
+    STATS_SECT_ENTRY(rx_duplicate)
+    STATS_SECT_ENTRY(ack_tx)
+    STATS_SECT_ENTRY(rx_timeout)
+    STATS_SECT_ENTRY(start_tx_error)
+STATS_SECT_END
+#define AGGR_STATS_INC(__X) STATS_INC(ag->stat, __X)
+#define AGGR_STATS_INCN(__X,__N) STATS_INCN(ag->stat, __X, __N)
+#else
+#define AGGR_STATS_INC(__X) {}
+#define AGGR_STATS_INCN(__X,__N) {}
+#endif
+
+//! Aggregate header, followed by nsub subframes
+typedef union {
+    struct _aggr_frame_t{
+        struct _ieee_rng_request_frame_t;
+        uint8_t nsub;                  //!< Subframes following
+    }__attribute__((__packed__,aligned(1)));
+    uint8_t array[sizeof(struct _aggr_frame_t)];
+}aggr_frame_t;
+
+//! Subframe header, followed by len bytes and a crc16 over header and data
+typedef struct _aggr_subframe_t{
+    uint8_t idx;                       //!< Index in the original aggregate
+    uint16_t len;                      //!< Data length
+}__attribute__((__packed__,aligned(1))) aggr_subframe_t;
+
+#define AGGR_SUBFRAME_OVERHEAD (sizeof(aggr_subframe_t) + sizeof(uint16_t))
+
+//! Selective acknowledgement
+typedef union {
+    struct _aggr_ack_frame_t{
+        struct _ieee_rng_request_frame_t;
+        uint32_t bitmap;               //!< Subframe indexes received, cumulative over retries
+    }__attribute__((__packed__,aligned(1)));
+    uint8_t array[sizeof(struct _aggr_ack_frame_t)];
+}aggr_ack_frame_t;
+
+//! Per destination queue
+struct aggr_queue {
+    uint16_t dst;                      //!< Destination, 0 marks a free queue
+    uint16_t len;                      //!< Bytes queued including subframe overhead
+    uint8_t nsub;                      //!< Subframes queued
+    uint32_t first;                    //!< Cputime the first subframe was queued
+    uint8_t buf[MYNEWT_VAL(AGGR_MAX_LEN)]; //!< Subframes
+};
+
+//! Aggregation status
+typedef struct _aggr_status_t{
+    uint16_t selfmalloc:1;             //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;            //!< Instance allocated
+    uint16_t acked:1;                  //!< Selective ack received
+    uint16_t broadcast:1;              //!< Waiting for a broadcast aggregate to leave
+    uint16_t start_tx_error:1;         //!< Start transmit error
+    uint16_t rx_timeout_error:1;       //!< Receive timeout error
+}aggr_status_t;
+
+//! Aggregation instance
+struct aggr_instance {
+#if MYNEWT_VAL(AGGR_STATS)
+    STATS_SECT_DECL(aggr_stat_section) stat; //!< Stats instance
+#endif
+    struct uwb_dev * dev_inst;         //!< Structure of uwb_dev
+    struct uwb_mac_interface cbs;      //!< MAC layer callbacks
+    struct dpl_mutex mutex;            //!< Protects the queues
+    struct dpl_sem sem;                //!< Signals the selective ack
+    struct dpl_callout callout;        //!< Latency deadline of the oldest queue
+    aggr_status_t status;              //!< Status
+    uint16_t max_len;                  //!< Aggregate length limit for the phr mode
+    uint8_t seq_num;                   //!< Aggregate sequence number
+    uint32_t ack_bitmap;               //!< Bitmap of the last selective ack
+    uint16_t rx_src;                   //!< Source of the last aggregate received
+    uint8_t rx_seq_num;                //!< Sequence number of the last aggregate received
+    uint32_t rx_bitmap;                //!< Subframes of the last aggregate delivered
+    aggr_ack_frame_t ack;              //!< Selective ack frame
+    uint64_t airtime_usec;             //!< Airtime of aggregates sent
+    uint64_t unaggregated_usec;        //!< Airtime the same frames would take sent one by one
+    uint8_t txbuf[MYNEWT_VAL(AGGR_MAX_LEN)]; //!< Aggregate being sent
+    uint8_t rxbuf[MYNEWT_VAL(AGGR_MAX_LEN)]; //!< Aggregate being dispatched
+    struct aggr_queue queues[MYNEWT_VAL(AGGR_MAX_DEST)];
+};
+
+struct aggr_instance * aggr_init(struct aggr_instance * ag, struct uwb_dev * inst);
+void aggr_free(struct aggr_instance * ag);
+struct aggr_instance * aggr_get_instance(void);
+
+int aggr_send(struct aggr_instance * ag, uint16_t dst, const uint8_t * frame, uint16_t len);
+int aggr_flush(struct aggr_instance * ag, uint16_t dst);
+int aggr_flush_all(struct aggr_instance * ag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AGGR_H_ */
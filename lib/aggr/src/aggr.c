@@ -0,0 +1,671 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file aggr.c
+ * @brief MAC frame aggregation
+ *
+ * @details The queues are protected by a mutex and sent from the caller of
+ * aggr_send or aggr_flush, or from the default event queue when the latency
+ * deadline of the oldest queue expires. Sending blocks until the selective
+ * ack or its timeout, bounded by the airtime should no interrupt end the
+ * wait. A retry keeps the sequence number and the original subframe
+ * indexes so the receiver drops subframes it already delivered.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <os/os.h>
+#include <sysinit/sysinit.h>
+#include <stats/stats.h>
+#include <crc/crc16.h>
+#include <uwb/uwb_mac.h>
+#include <uwb_rng/uwb_rng.h>
+#include <aggr/aggr.h>
+
+#if MYNEWT_VAL(AGGR_STATS)
+STATS_NAME_START(aggr_stat_section)
+    STATS_NAME(aggr_stat_section, queued)
+    STATS_NAME(aggr_stat_section, aggregates)
+    STATS_NAME(aggr_stat_section, subframes)
+    STATS_NAME(aggr_stat_section, retries)
+    STATS_NAME(aggr_stat_section, acked)
+    STATS_NAME(aggr_stat_section, partial)
+    STATS_NAME(aggr_stat_section, dropped)
+    STATS_NAME(aggr_stat_section, rx_aggregates)
+    STATS_NAME(aggr_stat_section, rx_subframes)
+    STATS_NAME(aggr_stat_section, rx_crc_error)
+    STATS_NAME(aggr_stat_section, rx_duplicate)
+    STATS_NAME(aggr_stat_section, ack_tx)
+    STATS_NAME(aggr_stat_section, rx_timeout)
+    STATS_NAME(aggr_stat_section, start_tx_error)
+STATS_NAME_END(aggr_stat_section)
+#endif
+
+static struct aggr_instance * g_aggr = NULL;
+
+static bool rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static bool tx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static bool rx_timeout_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static bool rx_error_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static bool reset_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static void aggr_latency_cb(struct dpl_event * ev);
+
+#if MYNEWT_VAL(AGGR_CLI)
+int aggr_cli_register(void);
+#endif
+
+/**
+ * @fn aggr_init(struct aggr_instance * ag, struct uwb_dev * inst)
+ * @brief Allocate and initialise an aggregation instance.
+ *
+ * @param ag    Pointer to struct aggr_instance, NULL to allocate.
+ * @param inst  Pointer to struct uwb_dev.
+ *
+ * @return struct aggr_instance *
+ */
+struct aggr_instance *
+aggr_init(struct aggr_instance * ag, struct uwb_dev * inst)
+{
+    assert(inst);
+
+    if (ag == NULL) {
+        ag = (struct aggr_instance *) malloc(sizeof(struct aggr_instance));
+        assert(ag);
+        memset(ag, 0, sizeof(struct aggr_instance));
+        ag->status.selfmalloc = 1;
+    }
+    if (!ag->status.initialized) {
+        dpl_error_t err = dpl_sem_init(&ag->sem, 0x1);
+        assert(err == DPL_OK);
+        err = dpl_mutex_init(&ag->mutex);
+        assert(err == DPL_OK);
+        dpl_callout_init(&ag->callout, dpl_eventq_dflt_get(), aggr_latency_cb, (void *) ag);
+    }
+    ag->dev_inst = inst;
+    ag->max_len = MYNEWT_VAL(AGGR_MAX_LEN);
+    if (inst->config.rx.phrMode != DWT_PHRMODE_EXT && ag->max_len > 125) {
+        ag->max_len = 125;
+    }
+
+    ag->cbs = (struct uwb_mac_interface){
+        .id = UWBEXT_AGGR,
+        .inst_ptr = (void *) ag,
+        .rx_complete_cb = rx_complete_cb,
+        .tx_complete_cb = tx_complete_cb,
+        .rx_timeout_cb = rx_timeout_cb,
+        .rx_error_cb = rx_error_cb,
+        .reset_cb = reset_cb
+    };
+    if (!ag->status.initialized) {
+        uwb_mac_append_interface(inst, &ag->cbs);
+#if MYNEWT_VAL(AGGR_STATS)
+        int rc = stats_init(
+                    STATS_HDR(ag->stat),
+                    STATS_SIZE_INIT_PARMS(ag->stat, STATS_SIZE_32),
+                    STATS_NAME_INIT_PARMS(aggr_stat_section)
+            );
+        rc |= stats_register("aggr", STATS_HDR(ag->stat));
+        assert(rc == 0);
+#endif
+    }
+    ag->status.initialized = 1;
+    g_aggr = ag;
+    return ag;
+}
+
+/**
+ * @fn aggr_free(struct aggr_instance * ag)
+ * @brief Discard queued frames and free the instance.
+ *
+ * @param ag  Pointer to struct aggr_instance.
+ *
+ * @return void
+ */
+void
+aggr_free(struct aggr_instance * ag)
+{
+    assert(ag);
+    dpl_callout_stop(&ag->callout);
+    uwb_mac_remove_interface(ag->dev_inst, ag->cbs.id);
+    if (g_aggr == ag) {
+        g_aggr = NULL;
+    }
+    if (ag->status.selfmalloc) {
+        free(ag);
+    } else {
+        ag->status.initialized = 0;
+    }
+}
+
+/**
+ * @fn aggr_get_instance(void)
+ * @brief Instance created by the last aggr_init, used by the cli.
+ *
+ * @return struct aggr_instance *
+ */
+struct aggr_instance *
+aggr_get_instance(void)
+{
+    return g_aggr;
+}
+
+/**
+ * @fn aggr_build(struct aggr_instance * ag, struct aggr_queue * q, uint32_t pending)
+ * @brief Write the aggregate of the pending subframes of a queue to txbuf.
+ *
+ * @return aggregate length
+ */
+static uint16_t
+aggr_build(struct aggr_instance * ag, struct aggr_queue * q, uint32_t pending)
+{
+    aggr_frame_t * frame = (aggr_frame_t *) ag->txbuf;
+    uint16_t len = sizeof(aggr_frame_t);
+    aggr_subframe_t sub;
+
+    frame->fctrl = FCNTL_IEEE_RANGE_16;
+    frame->PANID = 0xDECA;
+    frame->seq_num = ag->seq_num;
+    frame->src_address = ag->dev_inst->my_short_address;
+    frame->dst_address = q->dst;
+    frame->code = DWT_AGGR_DATA;
+    frame->nsub = 0;
+    for (uint16_t off = 0; off < q->len; off += AGGR_SUBFRAME_OVERHEAD + sub.len) {
+        memcpy(&sub, q->buf + off, sizeof(sub));
+        if (pending & (1UL << sub.idx)) {
+            memcpy(ag->txbuf + len, q->buf + off, AGGR_SUBFRAME_OVERHEAD + sub.len);
+            len += AGGR_SUBFRAME_OVERHEAD + sub.len;
+            frame->nsub++;
+        }
+    }
+    return len;
+}
+
+/**
+ * @fn aggr_queue_send(struct aggr_instance * ag, struct aggr_queue * q)
+ * @brief Send a queue and free it, resending unacknowledged subframes up to
+ * AGGR_RETRIES times. Called with the mutex held, blocks until the ack.
+ *
+ * @return OS_OK, OS_TIMEOUT if subframes were dropped
+ */
+static int
+aggr_queue_send(struct aggr_instance * ag, struct aggr_queue * q)
+{
+    struct uwb_dev * inst = ag->dev_inst;
+    bool unicast = (q->dst != UWB_BROADCAST_ADDRESS);
+    uint32_t pending = (q->nsub < 32) ? (1UL << q->nsub) - 1 : 0xffffffffUL;
+    uint32_t ack_timeout = uwb_phy_frame_duration(inst, sizeof(aggr_ack_frame_t)) + MYNEWT_VAL(AGGR_ACK_TIMEOUT);
+    uint16_t len;
+    dpl_error_t err;
+
+    AGGR_STATS_INC(aggregates);
+    AGGR_STATS_INCN(subframes, q->nsub);
+    ag->seq_num++;
+    for (uint16_t attempt = 0; attempt <= MYNEWT_VAL(AGGR_RETRIES) && pending; attempt++) {
+        if (attempt) {
+            AGGR_STATS_INC(retries);
+        }
+        len = aggr_build(ag, q, pending);
+        ag->airtime_usec += uwb_phy_frame_duration(inst, len);
+
+        err = dpl_sem_pend(&ag->sem, DPL_TIMEOUT_NEVER);
+        assert(err == DPL_OK);
+        ag->status.acked = 0;
+        ag->status.broadcast = !unicast;
+        uwb_write_tx(inst, ag->txbuf, 0, len);
+        uwb_write_tx_fctrl(inst, len, 0);
+        if (unicast) {
+            uwb_set_wait4resp(inst, true);
+            uwb_set_wait4resp_delay(inst, 0);
+            uwb_set_rx_timeout(inst, ack_timeout);
+            uwb_set_rxauto_disable(inst, true);
+        }
+        ag->status.start_tx_error = uwb_start_tx(inst).start_tx_error;
+        if (ag->status.start_tx_error) {
+            AGGR_STATS_INC(start_tx_error);
+            dpl_sem_release(&ag->sem);
+        }
+        // Wait for completion of transactions, bounded should no interrupt end it
+        err = dpl_sem_pend(&ag->sem, dpl_time_ms_to_ticks32((uwb_phy_frame_duration(inst, len)
+                           + (unicast ? ack_timeout : 0)) / 1000 + 2));
+        if (err == DPL_TIMEOUT) {
+            // The ack is taken as lost, the callbacks ignore it from here on
+            uwb_phy_forcetrxoff(inst);
+            AGGR_STATS_INC(rx_timeout);
+        } else {
+            assert(err == DPL_OK);
+        }
+        ag->status.broadcast = 0;
+        err = dpl_sem_release(&ag->sem);
+        assert(err == DPL_OK);
+
+        if (!unicast && !ag->status.start_tx_error) {
+            pending = 0;
+        } else if (ag->status.acked) {
+            pending &= ~ag->ack_bitmap;
+            if (pending) {
+                AGGR_STATS_INC(partial);
+            } else {
+                AGGR_STATS_INC(acked);
+            }
+        }
+    }
+
+    q->dst = 0;
+    q->len = 0;
+    q->nsub = 0;
+    if (pending) {
+        uint16_t n = 0;
+        for (; pending; pending &= pending - 1) {
+            n++;
+        }
+        AGGR_STATS_INCN(dropped, n);
+        return OS_TIMEOUT;
+    }
+    return OS_OK;
+}
+
+/**
+ * @fn aggr_rearm(struct aggr_instance * ag)
+ * @brief Arm the latency deadline of the oldest queue.
+ */
+static void
+aggr_rearm(struct aggr_instance * ag)
+{
+    uint32_t now = os_cputime_get32();
+    uint32_t oldest = 0;
+    bool any = false;
+
+    for (uint16_t i = 0; i < MYNEWT_VAL(AGGR_MAX_DEST); i++) {
+        struct aggr_queue * q = &ag->queues[i];
+        if (q->dst && (!any || now - q->first > oldest)) {
+            oldest = now - q->first;
+            any = true;
+        }
+    }
+    if (!any) {
+        dpl_callout_stop(&ag->callout);
+        return;
+    }
+    oldest = os_cputime_ticks_to_usecs(oldest) / 1000;
+    dpl_callout_reset(&ag->callout, (oldest >= MYNEWT_VAL(AGGR_LATENCY_MS)) ? 0 :
+                      dpl_time_ms_to_ticks32(MYNEWT_VAL(AGGR_LATENCY_MS) - oldest));
+}
+
+/**
+ * @fn aggr_queue_get(struct aggr_instance * ag, uint16_t dst, uint16_t need)
+ * @brief Queue of a destination with room for need bytes, sending full
+ * queues or the oldest queue to make room. Called with the mutex held.
+ */
+static struct aggr_queue *
+aggr_queue_get(struct aggr_instance * ag, uint16_t dst, uint16_t need)
+{
+    struct aggr_queue * q = NULL, * free_q = NULL, * oldest = NULL;
+    uint32_t now = os_cputime_get32();
+
+    for (uint16_t i = 0; i < MYNEWT_VAL(AGGR_MAX_DEST); i++) {
+        struct aggr_queue * it = &ag->queues[i];
+        if (it->dst == dst) {
+            q = it;
+        } else if (!it->dst) {
+            free_q = free_q ? free_q : it;
+        } else if (oldest == NULL || now - it->first > now - oldest->first) {
+            oldest = it;
+        }
+    }
+    if (q && sizeof(aggr_frame_t) + q->len + need > ag->max_len) {
+        aggr_queue_send(ag, q);
+        free_q = q;
+        q = NULL;
+    }
+    if (q == NULL) {
+        if (free_q == NULL) {
+            aggr_queue_send(ag, oldest);
+            free_q = oldest;
+        }
+        q = free_q;
+        q->dst = dst;
+        q->first = now;
+    }
+    return q;
+}
+
+/**
+ * @fn aggr_send(struct aggr_instance * ag, uint16_t dst, const uint8_t * frame, uint16_t len)
+ * @brief Queue a frame for aggregation. May block sending a queue to make room.
+ *
+ * @param ag     Pointer to struct aggr_instance.
+ * @param dst    Destination short address, UWB_BROADCAST_ADDRESS for unacknowledged broadcast.
+ * @param frame  Complete mac frame without fcs.
+ * @param len    Frame length.
+ *
+ * @return OS_OK, OS_EINVAL if the frame can never fit an aggregate
+ */
+int
+aggr_send(struct aggr_instance * ag, uint16_t dst, const uint8_t * frame, uint16_t len)
+{
+    uint16_t need = len + AGGR_SUBFRAME_OVERHEAD;
+    struct aggr_queue * q;
+    aggr_subframe_t sub;
+    uint16_t crc;
+
+    if (dst == 0 || sizeof(aggr_frame_t) + need > ag->max_len) {
+        return OS_EINVAL;
+    }
+    dpl_error_t err = dpl_mutex_pend(&ag->mutex, DPL_TIMEOUT_NEVER);
+    assert(err == DPL_OK);
+
+    q = aggr_queue_get(ag, dst, need);
+    sub.idx = q->nsub;
+    sub.len = len;
+    memcpy(q->buf + q->len, &sub, sizeof(sub));
+    memcpy(q->buf + q->len + sizeof(sub), frame, len);
+    crc = crc16_ccitt(0, q->buf + q->len, sizeof(sub) + len);
+    q->buf[q->len + sizeof(sub) + len] = crc & 0xff;
+    q->buf[q->len + sizeof(sub) + len + 1] = crc >> 8;
+    q->len += need;
+    q->nsub++;
+    ag->unaggregated_usec += uwb_phy_frame_duration(ag->dev_inst, len);
+    AGGR_STATS_INC(queued);
+
+    if (q->nsub >= MYNEWT_VAL(AGGR_MAX_SUBFRAMES)) {
+        aggr_queue_send(ag, q);
+    }
+    aggr_rearm(ag);
+    err = dpl_mutex_release(&ag->mutex);
+    assert(err == DPL_OK);
+    return OS_OK;
+}
+
+/**
+ * @fn aggr_flush(struct aggr_instance * ag, uint16_t dst)
+ * @brief Send the queue of a destination now.
+ *
+ * @return OS_OK, OS_ENOENT if nothing is queued, OS_TIMEOUT if subframes were dropped
+ */
+int
+aggr_flush(struct aggr_instance * ag, uint16_t dst)
+{
+    int rc = OS_ENOENT;
+
+    dpl_error_t err = dpl_mutex_pend(&ag->mutex, DPL_TIMEOUT_NEVER);
+    assert(err == DPL_OK);
+    for (uint16_t i = 0; i < MYNEWT_VAL(AGGR_MAX_DEST); i++) {
+        if (dst && ag->queues[i].dst == dst) {
+            rc = aggr_queue_send(ag, &ag->queues[i]);
+        }
+    }
+    aggr_rearm(ag);
+    err = dpl_mutex_release(&ag->mutex);
+    assert(err == DPL_OK);
+    return rc;
+}
+
+/**
+ * @fn aggr_flush_all(struct aggr_instance * ag)
+ * @brief Send all queues now.
+ *
+ * @return OS_OK, OS_TIMEOUT if subframes were dropped
+ */
+int
+aggr_flush_all(struct aggr_instance * ag)
+{
+    int rc = OS_OK;
+
+    dpl_error_t err = dpl_mutex_pend(&ag->mutex, DPL_TIMEOUT_NEVER);
+    assert(err == DPL_OK);
+    for (uint16_t i = 0; i < MYNEWT_VAL(AGGR_MAX_DEST); i++) {
+        if (ag->queues[i].dst && aggr_queue_send(ag, &ag->queues[i]) != OS_OK) {
+            rc = OS_TIMEOUT;
+        }
+    }
+    aggr_rearm(ag);
+    err = dpl_mutex_release(&ag->mutex);
+    assert(err == DPL_OK);
+    return rc;
+}
+
+/**
+ * @fn aggr_latency_cb(struct dpl_event * ev)
+ * @brief Send every queue whose first subframe reached AGGR_LATENCY_MS.
+ */
+static void
+aggr_latency_cb(struct dpl_event * ev)
+{
+    struct aggr_instance * ag = (struct aggr_instance *) dpl_event_get_arg(ev);
+    uint32_t now = os_cputime_get32();
+
+    dpl_error_t err = dpl_mutex_pend(&ag->mutex, DPL_TIMEOUT_NEVER);
+    assert(err == DPL_OK);
+    for (uint16_t i = 0; i < MYNEWT_VAL(AGGR_MAX_DEST); i++) {
+        struct aggr_queue * q = &ag->queues[i];
+        if (q->dst && os_cputime_ticks_to_usecs(now - q->first) >= MYNEWT_VAL(AGGR_LATENCY_MS) * 1000UL) {
+            aggr_queue_send(ag, q);
+        }
+    }
+    aggr_rearm(ag);
+    err = dpl_mutex_release(&ag->mutex);
+    assert(err == DPL_OK);
+}
+
+/**
+ * @fn aggr_dispatch(struct aggr_instance * ag, struct uwb_mac_interface * cbs, uint16_t off)
+ * @brief Hand one subframe to the interfaces registered after aggregation,
+ * as if it had been received on its own.
+ */
+static void
+aggr_dispatch(struct aggr_instance * ag, struct uwb_mac_interface * cbs, uint16_t off)
+{
+    struct uwb_dev * inst = ag->dev_inst;
+    aggr_subframe_t sub;
+
+    memcpy(&sub, ag->rxbuf + off, sizeof(sub));
+    memcpy(inst->rxbuf, ag->rxbuf + off + sizeof(sub), sub.len);
+    inst->frame_len = sub.len;
+    inst->fctrl = (sub.len >= sizeof(uint16_t)) ? (inst->rxbuf[0] | (inst->rxbuf[1] << 8)) : 0;
+    AGGR_STATS_INC(rx_subframes);
+    for (struct uwb_mac_interface * it = SLIST_NEXT(cbs, next); it != NULL; it = SLIST_NEXT(it, next)) {
+        if (it->rx_complete_cb && it->rx_complete_cb(inst, it)) {
+            break;
+        }
+    }
+}
+
+/**
+ * @fn aggr_rx_aggregate(struct aggr_instance * ag, struct uwb_mac_interface * cbs)
+ * @brief Check the subframes of a received aggregate, acknowledge and
+ * dispatch those that are valid and not yet delivered.
+ */
+static void
+aggr_rx_aggregate(struct aggr_instance * ag, struct uwb_mac_interface * cbs)
+{
+    struct uwb_dev * inst = ag->dev_inst;
+    aggr_frame_t * frame = (aggr_frame_t *) ag->rxbuf;
+    uint16_t len = inst->frame_len;
+    uint16_t offs[MYNEWT_VAL(AGGR_MAX_SUBFRAMES)];
+    uint16_t nfresh = 0;
+    uint32_t delivered = 0;
+    aggr_subframe_t sub;
+
+    memcpy(ag->rxbuf, inst->rxbuf, len);
+    AGGR_STATS_INC(rx_aggregates);
+    if (frame->src_address == ag->rx_src && frame->seq_num == ag->rx_seq_num) {
+        delivered = ag->rx_bitmap;
+    }
+
+    uint16_t off = sizeof(aggr_frame_t);
+    for (uint8_t i = 0; i < frame->nsub && off + sizeof(sub) <= len; i++) {
+        uint16_t crc;
+        memcpy(&sub, ag->rxbuf + off, sizeof(sub));
+        if (off + AGGR_SUBFRAME_OVERHEAD + sub.len > len) {
+            AGGR_STATS_INC(rx_crc_error);
+            break;
+        }
+        crc = ag->rxbuf[off + sizeof(sub) + sub.len] | (ag->rxbuf[off + sizeof(sub) + sub.len + 1] << 8);
+        if (sub.idx >= MYNEWT_VAL(AGGR_MAX_SUBFRAMES) || crc != crc16_ccitt(0, ag->rxbuf + off, sizeof(sub) + sub.len)) {
+            AGGR_STATS_INC(rx_crc_error);
+        } else if (delivered & (1UL << sub.idx)) {
+            AGGR_STATS_INC(rx_duplicate);
+        } else {
+            delivered |= 1UL << sub.idx;
+            offs[nfresh++] = off;
+        }
+        off += AGGR_SUBFRAME_OVERHEAD + sub.len;
+    }
+    ag->rx_src = frame->src_address;
+    ag->rx_seq_num = frame->seq_num;
+    ag->rx_bitmap = delivered;
+
+    if (frame->dst_address == inst->my_short_address) {
+        ag->ack.fctrl = FCNTL_IEEE_RANGE_16;
+        ag->ack.PANID = 0xDECA;
+        ag->ack.seq_num = frame->seq_num;
+        ag->ack.src_address = inst->my_short_address;
+        ag->ack.dst_address = frame->src_address;
+        ag->ack.code = DWT_AGGR_ACK;
+        ag->ack.bitmap = delivered;
+        uwb_write_tx(inst, ag->ack.array, 0, sizeof(aggr_ack_frame_t));
+        uwb_write_tx_fctrl(inst, sizeof(aggr_ack_frame_t), 0);
+        if (uwb_start_tx(inst).start_tx_error) {
+            AGGR_STATS_INC(start_tx_error);
+        } else {
+            AGGR_STATS_INC(ack_tx);
+        }
+    }
+    for (uint16_t i = 0; i < nfresh; i++) {
+        aggr_dispatch(ag, cbs, offs[i]);
+    }
+    // The services test the frame control of the last frame received on tx complete of the ack
+    inst->fctrl = FCNTL_IEEE_RANGE_16;
+}
+
+/**
+ * @fn rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+ * @brief Take aggregates and selective acks.
+ *
+ * @return true if the frame was an aggregation frame
+ */
+static bool
+rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct aggr_instance * ag = (struct aggr_instance *) cbs->inst_ptr;
+    aggr_ack_frame_t * frame = (aggr_ack_frame_t *) inst->rxbuf;
+
+    if (inst->fctrl != FCNTL_IEEE_RANGE_16 || inst->frame_len < sizeof(ieee_rng_request_frame_t)) {
+        return false;
+    }
+    switch (frame->code) {
+        case DWT_AGGR_DATA:
+            if (inst->frame_len < sizeof(aggr_frame_t) || inst->frame_len > sizeof(ag->rxbuf)) {
+                return true;
+            }
+            if (frame->dst_address != inst->my_short_address && frame->dst_address != UWB_BROADCAST_ADDRESS) {
+                return true;
+            }
+            aggr_rx_aggregate(ag, cbs);
+            return true;
+        case DWT_AGGR_ACK:
+            if (dpl_sem_get_count(&ag->sem) == 1 || ag->status.broadcast) {
+                return true;
+            }
+            if (inst->frame_len < sizeof(aggr_ack_frame_t) || frame->dst_address != inst->my_short_address
+                || frame->seq_num != ag->seq_num || frame->src_address != ((aggr_frame_t *) ag->txbuf)->dst_address) {
+                // Not our ack, the receiver stopped on it, keep listening until the rx timeout
+                if (!inst->status.rx_restarted) {
+                    uwb_start_rx(inst);
+                }
+                return true;
+            }
+            ag->ack_bitmap = frame->bitmap;
+            ag->status.acked = 1;
+            dpl_sem_release(&ag->sem);
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool
+tx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct aggr_instance * ag = (struct aggr_instance *) cbs->inst_ptr;
+
+    if (!ag->status.broadcast || dpl_sem_get_count(&ag->sem) == 1) {
+        return false;
+    }
+    ag->status.broadcast = 0;
+    dpl_sem_release(&ag->sem);
+    return true;
+}
+
+static bool
+rx_timeout_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct aggr_instance * ag = (struct aggr_instance *) cbs->inst_ptr;
+
+    if (dpl_sem_get_count(&ag->sem) == 1 || ag->status.broadcast) {
+        return false;
+    }
+    AGGR_STATS_INC(rx_timeout);
+    dpl_sem_release(&ag->sem);
+    return true;
+}
+
+static bool
+rx_error_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct aggr_instance * ag = (struct aggr_instance *) cbs->inst_ptr;
+
+    if (dpl_sem_get_count(&ag->sem) == 1 || ag->status.broadcast) {
+        return false;
+    }
+    /* A corrupted ack, treat as lost */
+    dpl_sem_release(&ag->sem);
+    return true;
+}
+
+static bool
+reset_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct aggr_instance * ag = (struct aggr_instance *) cbs->inst_ptr;
+
+    if (dpl_sem_get_count(&ag->sem) == 1) {
+        return false;
+    }
+    ag->status.broadcast = 0;
+    dpl_sem_release(&ag->sem);
+    return true;
+}
+
+void
+aggr_pkg_init(void)
+{
+#if MYNEWT_VAL(AGGR_VERBOSE)
+    printf("{\"utime\": %lu,\"msg\": \"aggr_pkg_init\"}\n", os_cputime_ticks_to_usecs(os_cputime_get32()));
+#endif
+#if MYNEWT_VAL(UWB_DEVICE_0)
+    aggr_init(NULL, uwb_dev_idx_lookup(0));
+#endif
+#if MYNEWT_VAL(AGGR_CLI)
+    int rc = aggr_cli_register();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+}
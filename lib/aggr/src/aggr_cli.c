@@ -0,0 +1,132 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <os/os.h>
+#include <syscfg/syscfg.h>
+
+#if MYNEWT_VAL(AGGR_CLI)
+
+#include <string.h>
+#include <stdlib.h>
+
+#include <shell/shell.h>
+#include <console/console.h>
+
+#include "aggr/aggr.h"
+
+static int aggr_cli_cmd(int argc, char **argv);
+
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+const struct shell_param cmd_aggr_param[] = {
+    {"status", "queues and airtime against unaggregated frames"},
+    {"flush", "send all queues now"},
+    {"bench", "<dst> <n> <len> queue n data frames of len bytes, flush and time it"},
+    {NULL,NULL},
+};
+
+const struct shell_cmd_help cmd_aggr_help = {
+	"aggr", "<cmd>", cmd_aggr_param
+};
+#endif
+
+static struct shell_cmd shell_aggr_cmd = {
+    .sc_cmd = "aggr",
+    .sc_cmd_func = aggr_cli_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+    .help = &cmd_aggr_help
+#endif
+};
+
+static void
+aggr_cli_status(struct aggr_instance * ag)
+{
+    console_printf("max_len: %d, airtime_usec: %llu, unaggregated_usec: %llu\n",
+                   ag->max_len, ag->airtime_usec, ag->unaggregated_usec);
+    console_printf("#dst, nsub, len\n");
+    for (int i = 0; i < MYNEWT_VAL(AGGR_MAX_DEST); i++) {
+        if (ag->queues[i].dst) {
+            console_printf("%4x, %d, %d\n", ag->queues[i].dst, ag->queues[i].nsub, ag->queues[i].len);
+        }
+    }
+}
+
+static void
+aggr_cli_bench(struct aggr_instance * ag, uint16_t dst, int n, int len)
+{
+    ieee_std_frame_t * frame;
+    uint64_t airtime = ag->airtime_usec;
+    uint64_t unaggregated = ag->unaggregated_usec;
+    uint32_t start;
+    int rc = OS_OK;
+
+    if (len < sizeof(ieee_std_frame_t) || (frame = (ieee_std_frame_t *) calloc(1, len)) == NULL) {
+        console_printf("Failed\n");
+        return;
+    }
+    /* A code no service answers to */
+    frame->fctrl = FCNTL_IEEE_RANGE_16;
+    frame->code = 0xffff;
+    frame->PANID = 0xDECA;
+    frame->src_address = ag->dev_inst->my_short_address;
+    frame->dst_address = dst;
+
+    start = os_cputime_get32();
+    for (int i = 0; i < n && rc == OS_OK; i++) {
+        frame->seq_num = i;
+        rc = aggr_send(ag, dst, (uint8_t *) frame, len);
+    }
+    if (rc == OS_OK) {
+        rc = aggr_flush(ag, dst);
+    }
+    console_printf("rc: %d, usec: %lu, airtime_usec: %llu, unaggregated_usec: %llu\n", rc,
+                   os_cputime_ticks_to_usecs(os_cputime_get32() - start),
+                   ag->airtime_usec - airtime, ag->unaggregated_usec - unaggregated);
+    free(frame);
+}
+
+static int
+aggr_cli_cmd(int argc, char **argv)
+{
+    struct aggr_instance * ag = aggr_get_instance();
+
+    if (argc < 2) {
+        return 0;
+    }
+    if (ag == NULL) {
+        console_printf("No aggr instance\n");
+        return 0;
+    }
+
+    if (!strcmp(argv[1], "status")) {
+        aggr_cli_status(ag);
+    } else if (!strcmp(argv[1], "flush")) {
+        aggr_flush_all(ag);
+    } else if (!strcmp(argv[1], "bench") && argc > 4) {
+        aggr_cli_bench(ag, strtol(argv[2], NULL, 0), strtol(argv[3], NULL, 0), strtol(argv[4], NULL, 0));
+    } else {
+        console_printf("Unknown cmd\n");
+    }
+    return 0;
+}
+
+int
+aggr_cli_register(void)
+{
+    return shell_cmd_register(&shell_aggr_cmd);
+}
+#endif /* MYNEWT_VAL(AGGR_CLI) */
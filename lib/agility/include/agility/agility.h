@@ -0,0 +1,152 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file agility.h
+ * @brief Interference aware channel and preamble code agility
+ *
+ * @details Every node keeps the error ratio of each channel and preamble code
+ * pair it has listened on, fed from the receive complete, error and timeout
+ * callbacks. When the error ratio of the pair in use exceeds
+ * AGILITY_THRESHOLD the clock master picks the cleanest candidate and
+ * announces it together with an epoch, the clock calibration sequence number
+ * at which the whole cell switches. The switch is applied right after the
+ * epoch calibration frame so the next superframe runs on the new pair. Each
+ * cell has an identifier; announcements of other cells mark the announced
+ * pair occupied, which steers neighbouring cells onto different codes.
+ */
+
+#ifndef _AGILITY_H_
+#define _AGILITY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stats/stats.h>
+#include <dpl/dpl.h>
+#include <uwb/uwb.h>
+#include <uwb/uwb_ftypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AGILITY_NONE (0xff)                //!< No candidate
+
+#if MYNEWT_VAL(AGILITY_STATS)
+STATS_SECT_START(agility_stat_section)
+    STATS_SECT_ENTRY(rx_ok)
+    STATS_SECT_ENTRY(rx_error)
+    STATS_SECT_ENTRY(rx_timeout)
+    STATS_SECT_ENTRY(evaluate)
+    STATS_SECT_ENTRY(schedule)
+    STATS_SECT_ENTRY(announce)
+    STATS_SECT_ENTRY(switch_rx)
+    STATS_SECT_ENTRY(switch_applied)
+    STATS_SECT_ENTRY(fallback)
+    STATS_SECT_ENTRY(occupied)
+    STATS_SECT_ENTRY(scan)
+    STATS_SECT_ENTRY(start_tx_error)
+    STATS_SECT_ENTRY(start_rx_error)
+STATS_SECT_END
+#define AGILITY_STATS_INC(__X) STATS_INC(ag->stat, __X)
+#else
+#define AGILITY_STATS_INC(__X) {}
+#endif
+
+//! Switch announcement frame
+typedef union {
+    struct _agility_frame_t{
+        struct _ieee_rng_request_frame_t;
+        uint8_t cell;                  //!< Cell of the announcing clock master
+        uint8_t channel;               //!< Channel to switch to
+        uint8_t preamble_code;         //!< Preamble code to switch to, used for tx and rx
+        uint8_t epoch;                 //!< Clock calibration sequence number after which to switch
+    }__attribute__((__packed__,aligned(1)));
+    uint8_t array[sizeof(struct _agility_frame_t)];
+}agility_frame_t;
+
+//! Channel and preamble code pair
+struct agility_candidate {
+    uint8_t channel;                   //!< Channel
+    uint8_t preamble_code;             //!< Preamble code
+    float error_ratio;                 //!< Receive error ratio, moving average
+    uint32_t samples;                  //!< Receive outcomes counted
+    uint32_t rx_ok;                    //!< Frames received
+    uint32_t rx_error;                 //!< Receive errors, PHR, SFD timeout, crc, lde
+    uint32_t rx_timeout;               //!< Receive timeouts
+    uint32_t occupied_at;              //!< Cputime a neighbouring cell last announced this pair
+    bool occupied;                     //!< occupied_at is valid
+};
+
+//! Agility status
+typedef struct _agility_status_t{
+    uint16_t selfmalloc:1;             //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;            //!< Instance allocated
+    uint16_t pending:1;                //!< Switch scheduled
+    uint16_t epoch_rx:1;               //!< Epoch calibration frame seen
+    uint16_t scanning:1;               //!< Receiver held on a candidate by agility_scan
+    uint16_t start_tx_error:1;         //!< Start transmit error
+    uint16_t start_rx_error:1;         //!< Start receive error
+}agility_status_t;
+
+struct uwb_ccp_instance;
+
+//! Agility instance
+struct agility_instance {
+#if MYNEWT_VAL(AGILITY_STATS)
+    STATS_SECT_DECL(agility_stat_section) stat; //!< Stats instance
+#endif
+    struct uwb_dev * dev_inst;         //!< Structure of uwb_dev
+    struct uwb_ccp_instance * ccp;     //!< Clock calibration, looked up on first use
+    struct uwb_mac_interface cbs;      //!< MAC layer callbacks
+    struct dpl_sem sem;                //!< Serialises scans
+    struct dpl_callout callout;        //!< Applies the pending switch
+    agility_status_t status;           //!< Status
+    agility_frame_t frame;             //!< Announcement frame
+    uint8_t cell;                      //!< Cell identifier
+    uint8_t current;                   //!< Candidate in use
+    uint8_t measure;                   //!< Candidate receive outcomes are counted against
+    uint8_t pending;                   //!< Candidate scheduled, valid if status.pending
+    uint8_t epoch;                     //!< Clock calibration sequence number of the switch
+    uint32_t switched;                 //!< Cputime of the last switch
+    uint16_t ncandidates;              //!< Entries in candidates[]
+    struct agility_candidate candidates[MYNEWT_VAL(AGILITY_MAX_CANDIDATES)];
+};
+
+struct agility_instance * agility_init(struct agility_instance * ag, struct uwb_dev * inst);
+void agility_free(struct agility_instance * ag);
+struct agility_instance * agility_get_instance(void);
+
+bool agility_code_valid(uint8_t channel, uint8_t prf, uint8_t preamble_code);
+int agility_add_candidate(struct agility_instance * ag, uint8_t channel, uint8_t preamble_code);
+uint8_t agility_find(struct agility_instance * ag, uint8_t channel, uint8_t preamble_code);
+void agility_set_cell(struct agility_instance * ag, uint8_t cell);
+float agility_score(struct agility_instance * ag, uint8_t idx);
+
+int agility_apply(struct agility_instance * ag, uint8_t idx);
+uint8_t agility_evaluate(struct agility_instance * ag);
+int agility_schedule(struct agility_instance * ag, uint8_t idx);
+agility_status_t agility_announce(struct agility_instance * ag, uint64_t dx_time);
+agility_status_t agility_scan(struct agility_instance * ag, uint8_t idx, uint32_t duration_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AGILITY_H_ */
@@ -0,0 +1,752 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file agility.c
+ * @brief Interference aware channel and preamble code agility
+ *
+ * @details Receive outcomes are counted against the pair the receiver is on,
+ * a good frame as 0 and a receive error as 1 in a moving average. Receive
+ * timeouts are counted but do not enter the error ratio, an idle channel is
+ * not a bad one. Pairs other than the one in use are only measured through
+ * agility_scan, unmeasured pairs score AGILITY_UNKNOWN_SCORE. A channel
+ * change reprograms the pulse generator delay, the transmit power is kept.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <os/os.h>
+#include <sysinit/sysinit.h>
+#include <stats/stats.h>
+#include <uwb_rng/uwb_rng.h>
+#include <uwb_ccp/uwb_ccp.h>
+#include <dw1000/dw1000_mac.h>
+#include <dw1000/dw1000_regs.h>
+#include <agility/agility.h>
+
+#if MYNEWT_VAL(AGILITY_STATS)
+STATS_NAME_START(agility_stat_section)
+    STATS_NAME(agility_stat_section, rx_ok)
+    STATS_NAME(agility_stat_section, rx_error)
+    STATS_NAME(agility_stat_section, rx_timeout)
+    STATS_NAME(agility_stat_section, evaluate)
+    STATS_NAME(agility_stat_section, schedule)
+    STATS_NAME(agility_stat_section, announce)
+    STATS_NAME(agility_stat_section, switch_rx)
+    STATS_NAME(agility_stat_section, switch_applied)
+    STATS_NAME(agility_stat_section, fallback)
+    STATS_NAME(agility_stat_section, occupied)
+    STATS_NAME(agility_stat_section, scan)
+    STATS_NAME(agility_stat_section, start_tx_error)
+    STATS_NAME(agility_stat_section, start_rx_error)
+STATS_NAME_END(agility_stat_section)
+#endif
+
+static struct agility_instance * g_agility = NULL;
+
+static bool rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static bool tx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static bool rx_error_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static bool rx_timeout_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static void agility_switch_cb(struct dpl_event * ev);
+
+#if MYNEWT_VAL(AGILITY_CLI)
+int agility_cli_register(void);
+#endif
+
+/**
+ * @fn agility_codes(uint8_t channel, uint8_t prf, uint8_t * first)
+ * @brief Preamble codes of a channel and prf, IEEE802.15.4-2011 table 39.
+ *
+ * @return number of consecutive codes starting at first, 0 for an unsupported channel
+ */
+static uint8_t
+agility_codes(uint8_t channel, uint8_t prf, uint8_t * first)
+{
+    if (prf == DWT_PRF_16M) {
+        switch (channel) {
+            case 1: *first = 1; return 2;
+            case 2: case 5: *first = 3; return 2;
+            case 3: *first = 5; return 2;
+            case 4: case 7: *first = 7; return 2;
+            default: return 0;
+        }
+    }
+    switch (channel) {
+        case 1: case 2: case 3: case 5: *first = 9; return 4;
+        case 4: case 7: *first = 17; return 4;
+        default: return 0;
+    }
+}
+
+/**
+ * @fn agility_pgdly(uint8_t channel)
+ * @brief Recommended pulse generator delay of a channel, as set by uwbcfg.
+ */
+static uint8_t
+agility_pgdly(uint8_t channel)
+{
+    switch (channel) {
+        case 1: return TC_PGDELAY_CH1;
+        case 2: return TC_PGDELAY_CH2;
+        case 3: return TC_PGDELAY_CH3;
+        case 4: return TC_PGDELAY_CH4;
+        case 5: return TC_PGDELAY_CH5;
+        default: return TC_PGDELAY_CH7;
+    }
+}
+
+/**
+ * @fn agility_init(struct agility_instance * ag, struct uwb_dev * inst)
+ * @brief Allocate and initialise an agility instance. The pair in the device
+ * configuration becomes the first candidate, followed by every valid pair of
+ * the channels in AGILITY_CHANNELS.
+ *
+ * @param ag    Pointer to struct agility_instance, NULL to allocate.
+ * @param inst  Pointer to struct uwb_dev.
+ *
+ * @return struct agility_instance *
+ */
+struct agility_instance *
+agility_init(struct agility_instance * ag, struct uwb_dev * inst)
+{
+    assert(inst);
+
+    if (ag == NULL) {
+        ag = (struct agility_instance *) malloc(sizeof(struct agility_instance));
+        assert(ag);
+        memset(ag, 0, sizeof(struct agility_instance));
+        ag->status.selfmalloc = 1;
+    }
+    if (!ag->status.initialized) {
+        dpl_error_t err = dpl_sem_init(&ag->sem, 0x1);
+        assert(err == DPL_OK);
+        dpl_callout_init(&ag->callout, &inst->eventq, agility_switch_cb, (void *) ag);
+    }
+    ag->dev_inst = inst;
+    ag->cell = MYNEWT_VAL(AGILITY_CELL);
+    ag->ncandidates = 0;
+    ag->status.pending = 0;
+
+    agility_add_candidate(ag, inst->config.channel, inst->config.rx.preambleCodeIndex);
+    ag->current = ag->measure = 0;
+    ag->switched = os_cputime_get32();
+    for (uint8_t ch = 1; ch <= 7; ch++) {
+        uint8_t first, n;
+        if (MYNEWT_VAL(AGILITY_CHANNELS) ? !(MYNEWT_VAL(AGILITY_CHANNELS) & (1 << ch)) : ch != inst->config.channel) {
+            continue;
+        }
+        n = agility_codes(ch, inst->config.prf, &first);
+        for (uint8_t code = first; code < first + n; code++) {
+            agility_add_candidate(ag, ch, code);
+        }
+    }
+
+    ag->cbs = (struct uwb_mac_interface){
+        .id = UWBEXT_AGILITY,
+        .inst_ptr = (void *) ag,
+        .rx_complete_cb = rx_complete_cb,
+        .tx_complete_cb = tx_complete_cb,
+        .rx_error_cb = rx_error_cb,
+        .rx_timeout_cb = rx_timeout_cb
+    };
+    if (!ag->status.initialized) {
+        uwb_mac_append_interface(inst, &ag->cbs);
+#if MYNEWT_VAL(AGILITY_STATS)
+        int rc = stats_init(
+                    STATS_HDR(ag->stat),
+                    STATS_SIZE_INIT_PARMS(ag->stat, STATS_SIZE_32),
+                    STATS_NAME_INIT_PARMS(agility_stat_section)
+            );
+        rc |= stats_register("agility", STATS_HDR(ag->stat));
+        assert(rc == 0);
+#endif
+    }
+    ag->status.initialized = 1;
+    g_agility = ag;
+    return ag;
+}
+
+/**
+ * @fn agility_free(struct agility_instance * ag)
+ * @brief Cancel a pending switch and free the instance. The device stays on
+ * the pair in use.
+ *
+ * @param ag  Pointer to struct agility_instance.
+ *
+ * @return void
+ */
+void
+agility_free(struct agility_instance * ag)
+{
+    assert(ag);
+    dpl_callout_stop(&ag->callout);
+    uwb_mac_remove_interface(ag->dev_inst, ag->cbs.id);
+    if (g_agility == ag) {
+        g_agility = NULL;
+    }
+    if (ag->status.selfmalloc) {
+        free(ag);
+    } else {
+        ag->status.initialized = 0;
+    }
+}
+
+/**
+ * @fn agility_get_instance(void)
+ * @brief Instance created by the last agility_init, used by the cli.
+ *
+ * @return struct agility_instance *
+ */
+struct agility_instance *
+agility_get_instance(void)
+{
+    return g_agility;
+}
+
+/**
+ * @fn agility_code_valid(uint8_t channel, uint8_t prf, uint8_t preamble_code)
+ * @brief Check a preamble code may be used on a channel at a prf.
+ *
+ * @return bool
+ */
+bool
+agility_code_valid(uint8_t channel, uint8_t prf, uint8_t preamble_code)
+{
+    uint8_t first, n = agility_codes(channel, prf, &first);
+
+    return n && preamble_code >= first && preamble_code < first + n;
+}
+
+/**
+ * @fn agility_find(struct agility_instance * ag, uint8_t channel, uint8_t preamble_code)
+ * @brief Candidate index of a pair.
+ *
+ * @return index, AGILITY_NONE if the pair is not a candidate
+ */
+uint8_t
+agility_find(struct agility_instance * ag, uint8_t channel, uint8_t preamble_code)
+{
+    for (uint8_t i = 0; i < ag->ncandidates; i++) {
+        if (ag->candidates[i].channel == channel && ag->candidates[i].preamble_code == preamble_code) {
+            return i;
+        }
+    }
+    return AGILITY_NONE;
+}
+
+/**
+ * @fn agility_add_candidate(struct agility_instance * ag, uint8_t channel, uint8_t preamble_code)
+ * @brief Offer a pair for switching, a no-op if already a candidate.
+ *
+ * @param ag             Pointer to struct agility_instance.
+ * @param channel        Channel.
+ * @param preamble_code  Preamble code, must be valid for the channel at the configured prf.
+ *
+ * @return OS_OK, OS_EINVAL for an invalid pair, OS_ENOMEM if the table is full
+ */
+int
+agility_add_candidate(struct agility_instance * ag, uint8_t channel, uint8_t preamble_code)
+{
+    if (!agility_code_valid(channel, ag->dev_inst->config.prf, preamble_code)) {
+        return OS_EINVAL;
+    }
+    if (agility_find(ag, channel, preamble_code) != AGILITY_NONE) {
+        return OS_OK;
+    }
+    if (ag->ncandidates >= MYNEWT_VAL(AGILITY_MAX_CANDIDATES)) {
+        return OS_ENOMEM;
+    }
+    ag->candidates[ag->ncandidates++] = (struct agility_candidate){
+        .channel = channel,
+        .preamble_code = preamble_code
+    };
+    return OS_OK;
+}
+
+/**
+ * @fn agility_set_cell(struct agility_instance * ag, uint8_t cell)
+ * @brief Set the cell identifier, announcements of other cells are not followed.
+ *
+ * @return void
+ */
+void
+agility_set_cell(struct agility_instance * ag, uint8_t cell)
+{
+    ag->cell = cell;
+}
+
+/**
+ * @fn agility_score(struct agility_instance * ag, uint8_t idx)
+ * @brief Score of a candidate, lower is cleaner. The error ratio once enough
+ * outcomes are counted, plus one while a neighbouring cell uses the pair.
+ *
+ * @param ag   Pointer to struct agility_instance.
+ * @param idx  Candidate index.
+ *
+ * @return score
+ */
+float
+agility_score(struct agility_instance * ag, uint8_t idx)
+{
+    struct agility_candidate * c = &ag->candidates[idx];
+    float score = (c->samples < MYNEWT_VAL(AGILITY_MIN_SAMPLES)) ?
+        MYNEWT_VAL(AGILITY_UNKNOWN_SCORE) : c->error_ratio;
+
+    if (c->occupied) {
+        uint32_t age = os_cputime_ticks_to_usecs(os_cputime_get32() - c->occupied_at);
+        if (age < MYNEWT_VAL(AGILITY_OCCUPIED_MS) * 1000UL) {
+            score += 1.0f;
+        } else {
+            c->occupied = false;
+        }
+    }
+    return score;
+}
+
+/**
+ * @fn agility_program(struct agility_instance * ag, uint8_t idx)
+ * @brief Program the channel and preamble code of a candidate, tx and rx
+ * use the same code.
+ */
+static void
+agility_program(struct agility_instance * ag, uint8_t idx)
+{
+    struct uwb_dev * inst = ag->dev_inst;
+    struct agility_candidate * c = &ag->candidates[idx];
+    struct uwb_dev_config config = inst->config;
+
+    uwb_phy_forcetrxoff(inst);
+    if (config.channel != c->channel) {
+        config.txrf.PGdly = agility_pgdly(c->channel);
+        uwb_txrf_config(inst, &config.txrf);
+    }
+    config.channel = c->channel;
+    config.rx.preambleCodeIndex = c->preamble_code;
+    config.tx.preambleCodeIndex = c->preamble_code;
+    uwb_mac_config(inst, &config);
+}
+
+/**
+ * @fn agility_apply(struct agility_instance * ag, uint8_t idx)
+ * @brief Switch this node to a candidate immediately, the device must be
+ * idle. Use agility_schedule to switch a whole cell.
+ *
+ * @param ag   Pointer to struct agility_instance.
+ * @param idx  Candidate index.
+ *
+ * @return OS_OK, OS_EINVAL for an unknown candidate
+ */
+int
+agility_apply(struct agility_instance * ag, uint8_t idx)
+{
+    if (idx >= ag->ncandidates) {
+        return OS_EINVAL;
+    }
+    agility_program(ag, idx);
+    ag->current = ag->measure = idx;
+    ag->switched = os_cputime_get32();
+    AGILITY_STATS_INC(switch_applied);
+#if MYNEWT_VAL(AGILITY_VERBOSE)
+    printf("{\"utime\": %lu,\"msg\": \"agility_apply\",\"ch\": %d,\"code\": %d}\n",
+           os_cputime_ticks_to_usecs(os_cputime_get32()),
+           ag->candidates[idx].channel, ag->candidates[idx].preamble_code);
+#endif
+    return OS_OK;
+}
+
+/**
+ * @fn agility_ccp(struct agility_instance * ag)
+ * @brief Clock calibration instance, registered after agility.
+ */
+static struct uwb_ccp_instance *
+agility_ccp(struct agility_instance * ag)
+{
+    if (ag->ccp == NULL) {
+        ag->ccp = (struct uwb_ccp_instance *) uwb_mac_find_cb_inst_ptr(ag->dev_inst, UWBEXT_CCP);
+    }
+    return ag->ccp;
+}
+
+/**
+ * @fn agility_arm(struct agility_instance * ag, uint8_t periods)
+ * @brief Switch anyway after a number of clock calibration periods in case
+ * the epoch frame is missed.
+ */
+static void
+agility_arm(struct agility_instance * ag, uint8_t periods)
+{
+    uint32_t ms = periods * uwb_dwt_usecs_to_usecs(ag->ccp->period) / 1000;
+
+    dpl_callout_reset(&ag->callout, dpl_time_ms_to_ticks32(ms));
+}
+
+/**
+ * @fn agility_schedule(struct agility_instance * ag, uint8_t idx)
+ * @brief Schedule a cell wide switch AGILITY_EPOCH_DELAY clock calibration
+ * periods ahead, clock master only. Announce it with agility_announce
+ * until it takes effect.
+ *
+ * @param ag   Pointer to struct agility_instance.
+ * @param idx  Candidate index.
+ *
+ * @return OS_OK, OS_EINVAL for an unknown candidate, OS_ENOENT without clock calibration
+ */
+int
+agility_schedule(struct agility_instance * ag, uint8_t idx)
+{
+    struct uwb_ccp_instance * ccp = agility_ccp(ag);
+
+    if (idx >= ag->ncandidates || idx == ag->current) {
+        return OS_EINVAL;
+    }
+    if (ccp == NULL) {
+        return OS_ENOENT;
+    }
+    ag->pending = idx;
+    ag->epoch = ccp->seq_num + MYNEWT_VAL(AGILITY_EPOCH_DELAY);
+    ag->status.epoch_rx = 0;
+    ag->status.pending = 1;
+    agility_arm(ag, MYNEWT_VAL(AGILITY_EPOCH_DELAY) + MYNEWT_VAL(AGILITY_FALLBACK_PERIODS));
+    AGILITY_STATS_INC(schedule);
+    return OS_OK;
+}
+
+/**
+ * @fn agility_evaluate(struct agility_instance * ag)
+ * @brief Clock master policy, call periodically e.g. from the ccp
+ * postprocess. Schedules a switch when the pair in use scores above
+ * AGILITY_THRESHOLD, the last switch is at least AGILITY_DWELL_MS old and a
+ * candidate scores AGILITY_HYSTERESIS better.
+ *
+ * @param ag  Pointer to struct agility_instance.
+ *
+ * @return candidate scheduled, AGILITY_NONE if none
+ */
+uint8_t
+agility_evaluate(struct agility_instance * ag)
+{
+    uint8_t best = AGILITY_NONE;
+    float current, best_score = INFINITY;
+
+    AGILITY_STATS_INC(evaluate);
+    if (ag->status.pending) {
+        return AGILITY_NONE;
+    }
+    current = agility_score(ag, ag->current);
+    if (current <= MYNEWT_VAL(AGILITY_THRESHOLD)) {
+        return AGILITY_NONE;
+    }
+    if (os_cputime_ticks_to_usecs(os_cputime_get32() - ag->switched) < MYNEWT_VAL(AGILITY_DWELL_MS) * 1000UL) {
+        return AGILITY_NONE;
+    }
+    for (uint8_t i = 0; i < ag->ncandidates; i++) {
+        float score = agility_score(ag, i);
+        if (i != ag->current && score < best_score) {
+            best = i;
+            best_score = score;
+        }
+    }
+    if (best == AGILITY_NONE || best_score + MYNEWT_VAL(AGILITY_HYSTERESIS) >= current) {
+        return AGILITY_NONE;
+    }
+    if (agility_schedule(ag, best) != OS_OK) {
+        return AGILITY_NONE;
+    }
+    return best;
+}
+
+/**
+ * @fn agility_announce(struct agility_instance * ag, uint64_t dx_time)
+ * @brief Broadcast the pending switch, call from a tdma slot of the clock
+ * master on every superframe until the epoch. Does nothing without a
+ * pending switch.
+ *
+ * @param ag       Pointer to struct agility_instance.
+ * @param dx_time  Delayed start time, 0 to start immediately.
+ *
+ * @return agility_status_t
+ */
+agility_status_t
+agility_announce(struct agility_instance * ag, uint64_t dx_time)
+{
+    struct uwb_dev * inst = ag->dev_inst;
+    struct agility_candidate * c;
+
+    if (!ag->status.pending) {
+        return ag->status;
+    }
+    c = &ag->candidates[ag->pending];
+    ag->frame.fctrl = FCNTL_IEEE_RANGE_16;
+    ag->frame.PANID = 0xDECA;
+    ag->frame.seq_num++;
+    ag->frame.src_address = inst->my_short_address;
+    ag->frame.dst_address = 0xffff;
+    ag->frame.code = DWT_AGILITY_SWITCH;
+    ag->frame.cell = ag->cell;
+    ag->frame.channel = c->channel;
+    ag->frame.preamble_code = c->preamble_code;
+    ag->frame.epoch = ag->epoch;
+
+    uwb_write_tx(inst, ag->frame.array, 0, sizeof(agility_frame_t));
+    uwb_write_tx_fctrl(inst, sizeof(agility_frame_t), 0);
+    if (dx_time) {
+        uwb_set_delay_start(inst, dx_time);
+    }
+    ag->status.start_tx_error = uwb_start_tx(inst).start_tx_error;
+    if (ag->status.start_tx_error) {
+        AGILITY_STATS_INC(start_tx_error);
+    } else {
+        AGILITY_STATS_INC(announce);
+    }
+    return ag->status;
+}
+
+/**
+ * @fn agility_scan(struct agility_instance * ag, uint8_t idx, uint32_t duration_ms)
+ * @brief Listen on a candidate to measure it, then return to the pair in
+ * use. Blocks for duration_ms and misses all traffic of the cell meanwhile,
+ * schedule it in idle superframes. Not allowed while a switch is pending.
+ *
+ * @param ag           Pointer to struct agility_instance.
+ * @param idx          Candidate index.
+ * @param duration_ms  Listen time.
+ *
+ * @return agility_status_t
+ */
+agility_status_t
+agility_scan(struct agility_instance * ag, uint8_t idx, uint32_t duration_ms)
+{
+    struct uwb_dev * inst = ag->dev_inst;
+
+    if (idx >= ag->ncandidates || ag->status.pending) {
+        return ag->status;
+    }
+    dpl_error_t err = dpl_sem_pend(&ag->sem, DPL_TIMEOUT_NEVER);
+    assert(err == DPL_OK);
+    AGILITY_STATS_INC(scan);
+
+    if (idx != ag->current) {
+        agility_program(ag, idx);
+    }
+    ag->measure = idx;
+    ag->status.scanning = 1;
+    uwb_set_rx_timeout(inst, 0);
+    ag->status.start_rx_error = uwb_start_rx(inst).start_rx_error;
+    if (ag->status.start_rx_error) {
+        AGILITY_STATS_INC(start_rx_error);
+    } else {
+        dpl_time_delay(dpl_time_ms_to_ticks32(duration_ms));
+    }
+    ag->status.scanning = 0;
+    uwb_phy_forcetrxoff(inst);
+    if (idx != ag->current) {
+        agility_program(ag, ag->current);
+    }
+    ag->measure = ag->current;
+
+    err = dpl_sem_release(&ag->sem);
+    assert(err == DPL_OK);
+    return ag->status;
+}
+
+/**
+ * @fn agility_switch_cb(struct dpl_event * ev)
+ * @brief Apply the pending switch, at the epoch or on fallback.
+ */
+static void
+agility_switch_cb(struct dpl_event * ev)
+{
+    struct agility_instance * ag = (struct agility_instance *) dpl_event_get_arg(ev);
+
+    if (!ag->status.pending) {
+        return;
+    }
+    if (!ag->status.epoch_rx) {
+        AGILITY_STATS_INC(fallback);
+    }
+    /* Wait for a running scan to restore the pair in use */
+    dpl_error_t err = dpl_sem_pend(&ag->sem, DPL_TIMEOUT_NEVER);
+    assert(err == DPL_OK);
+    ag->status.pending = 0;
+    agility_apply(ag, ag->pending);
+    err = dpl_sem_release(&ag->sem);
+    assert(err == DPL_OK);
+}
+
+/**
+ * @fn agility_outcome(struct agility_instance * ag, bool error)
+ * @brief Count a receive outcome against the pair being measured.
+ */
+static void
+agility_outcome(struct agility_instance * ag, bool error)
+{
+    struct agility_candidate * c = &ag->candidates[ag->measure];
+
+    c->samples++;
+    c->error_ratio += ((error ? 1.0f : 0.0f) - c->error_ratio) * (1.0f/16);
+    if (error) {
+        c->rx_error++;
+        AGILITY_STATS_INC(rx_error);
+    } else {
+        c->rx_ok++;
+        AGILITY_STATS_INC(rx_ok);
+    }
+}
+
+/**
+ * @fn agility_epoch(struct agility_instance * ag, uint8_t seq_num)
+ * @brief Trigger the pending switch once the epoch calibration frame is seen.
+ */
+static void
+agility_epoch(struct agility_instance * ag, uint8_t seq_num)
+{
+    if (ag->status.pending && (int8_t)(seq_num - ag->epoch) >= 0) {
+        ag->status.epoch_rx = 1;
+        dpl_callout_reset(&ag->callout, 0);
+    }
+}
+
+/**
+ * @fn agility_switch_rx(struct agility_instance * ag, agility_frame_t * frame)
+ * @brief Follow an announcement of our clock master, mark the pair of a
+ * neighbouring cell occupied.
+ */
+static void
+agility_switch_rx(struct agility_instance * ag, agility_frame_t * frame)
+{
+    struct uwb_ccp_instance * ccp = agility_ccp(ag);
+    uint8_t idx = agility_find(ag, frame->channel, frame->preamble_code);
+
+    if (frame->cell != ag->cell) {
+        if (idx != AGILITY_NONE) {
+            ag->candidates[idx].occupied = true;
+            ag->candidates[idx].occupied_at = os_cputime_get32();
+            AGILITY_STATS_INC(occupied);
+        }
+        return;
+    }
+    if (ccp == NULL || ccp->config.role == CCP_ROLE_MASTER) {
+        return;
+    }
+    if (idx == AGILITY_NONE) {
+        if (agility_add_candidate(ag, frame->channel, frame->preamble_code) != OS_OK) {
+            return;
+        }
+        idx = ag->ncandidates - 1;
+    }
+    if (idx == ag->current || (ag->status.pending && ag->pending == idx && ag->epoch == frame->epoch)) {
+        return;
+    }
+    ag->pending = idx;
+    ag->epoch = frame->epoch;
+    ag->status.epoch_rx = 0;
+    ag->status.pending = 1;
+    agility_arm(ag, (uint8_t)(frame->epoch - ccp->seq_num) + MYNEWT_VAL(AGILITY_FALLBACK_PERIODS));
+    AGILITY_STATS_INC(switch_rx);
+}
+
+/**
+ * @fn rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+ * @brief Count the frame, watch the clock calibration sequence for the epoch
+ * and take switch announcements.
+ *
+ * @return true if the frame was consumed
+ */
+static bool
+rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct agility_instance * ag = (struct agility_instance *) cbs->inst_ptr;
+    agility_frame_t * frame = (agility_frame_t *) inst->rxbuf;
+
+    agility_outcome(ag, false);
+    if (ag->status.scanning) {
+        /* Traffic on a candidate is not ours */
+        uwb_start_rx(inst);
+        return true;
+    }
+    if (inst->fctrl_array[0] == FCNTL_IEEE_BLINK_CCP_64) {
+        agility_epoch(ag, ((uwb_ccp_blink_frame_t *) inst->rxbuf)->seq_num);
+        return false;
+    }
+    if (inst->fctrl != FCNTL_IEEE_RANGE_16 || inst->frame_len < sizeof(agility_frame_t)
+        || frame->code != DWT_AGILITY_SWITCH) {
+        return false;
+    }
+    agility_switch_rx(ag, frame);
+    return true;
+}
+
+/**
+ * @fn tx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+ * @brief On the clock master the epoch is its own calibration frame.
+ *
+ * @return false
+ */
+static bool
+tx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct agility_instance * ag = (struct agility_instance *) cbs->inst_ptr;
+    struct uwb_ccp_instance * ccp = agility_ccp(ag);
+
+    if (ccp && inst->fctrl_array[0] == FCNTL_IEEE_BLINK_CCP_64 && ccp->config.role == CCP_ROLE_MASTER) {
+        agility_epoch(ag, ccp->seq_num);
+    }
+    return false;
+}
+
+static bool
+rx_error_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct agility_instance * ag = (struct agility_instance *) cbs->inst_ptr;
+
+    agility_outcome(ag, true);
+    if (ag->status.scanning) {
+        uwb_start_rx(inst);
+    }
+    return false;
+}
+
+static bool
+rx_timeout_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct agility_instance * ag = (struct agility_instance *) cbs->inst_ptr;
+
+    ag->candidates[ag->measure].rx_timeout++;
+    AGILITY_STATS_INC(rx_timeout);
+    return false;
+}
+
+void
+agility_pkg_init(void)
+{
+#if MYNEWT_VAL(AGILITY_VERBOSE)
+    printf("{\"utime\": %lu,\"msg\": \"agility_pkg_init\"}\n", os_cputime_ticks_to_usecs(os_cputime_get32()));
+#endif
+#if MYNEWT_VAL(UWB_DEVICE_0)
+    agility_init(NULL, uwb_dev_idx_lookup(0));
+#endif
+#if MYNEWT_VAL(AGILITY_CLI)
+    int rc = agility_cli_register();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+}
@@ -0,0 +1,141 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <os/os.h>
+#include <syscfg/syscfg.h>
+
+#if MYNEWT_VAL(AGILITY_CLI)
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <shell/shell.h>
+#include <console/console.h>
+
+#include "agility/agility.h"
+
+static int agility_cli_cmd(int argc, char **argv);
+
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+const struct shell_param cmd_agility_param[] = {
+    {"list", "candidate pairs, error ratio and score"},
+    {"status", "pair in use and pending switch"},
+    {"add", "<ch> <code> add a candidate pair"},
+    {"cell", "<id> set the cell identifier"},
+    {"switch", "<idx> schedule a cell wide switch, clock master"},
+    {"apply", "<idx> switch this node only"},
+    {"scan", "<idx> <ms> listen on a candidate"},
+    {NULL,NULL},
+};
+
+const struct shell_cmd_help cmd_agility_help = {
+	"agility", "<cmd>", cmd_agility_param
+};
+#endif
+
+static struct shell_cmd shell_agility_cmd = {
+    .sc_cmd = "agility",
+    .sc_cmd_func = agility_cli_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+    .help = &cmd_agility_help
+#endif
+};
+
+static void
+print_float(float v)
+{
+    console_printf("%s%d.%03d", (v < 0) ? "-" : "", (int)fabsf(v),
+                   (int)((fabsf(v) - (int)fabsf(v))*1000));
+}
+
+static void
+agility_cli_list(struct agility_instance * ag)
+{
+    console_printf("#idx, ch, code, error_ratio, score, samples, rx_ok, rx_error, rx_timeout\n");
+    for (int i = 0; i < ag->ncandidates; i++) {
+        struct agility_candidate * c = &ag->candidates[i];
+        console_printf("%d%s, %d, %d, ", i, (i == ag->current) ? "*" : "",
+                       c->channel, c->preamble_code);
+        print_float(c->error_ratio);
+        console_printf(", ");
+        print_float(agility_score(ag, i));
+        console_printf(", %lu, %lu, %lu, %lu\n", c->samples, c->rx_ok,
+                       c->rx_error, c->rx_timeout);
+    }
+}
+
+static void
+agility_cli_status(struct agility_instance * ag)
+{
+    struct agility_candidate * c = &ag->candidates[ag->current];
+
+    console_printf("cell: %d, ch: %d, code: %d", ag->cell, c->channel, c->preamble_code);
+    if (ag->status.pending) {
+        c = &ag->candidates[ag->pending];
+        console_printf(", pending ch: %d, code: %d, epoch: %d", c->channel,
+                       c->preamble_code, ag->epoch);
+    }
+    console_printf("\n");
+}
+
+static int
+agility_cli_cmd(int argc, char **argv)
+{
+    struct agility_instance * ag = agility_get_instance();
+
+    if (argc < 2) {
+        return 0;
+    }
+    if (ag == NULL) {
+        console_printf("No agility instance\n");
+        return 0;
+    }
+
+    if (!strcmp(argv[1], "list")) {
+        agility_cli_list(ag);
+    } else if (!strcmp(argv[1], "status")) {
+        agility_cli_status(ag);
+    } else if (!strcmp(argv[1], "add") && argc > 3) {
+        if (agility_add_candidate(ag, strtol(argv[2], NULL, 0), strtol(argv[3], NULL, 0)) != OS_OK) {
+            console_printf("Failed\n");
+        }
+    } else if (!strcmp(argv[1], "cell") && argc > 2) {
+        agility_set_cell(ag, strtol(argv[2], NULL, 0));
+    } else if (!strcmp(argv[1], "switch") && argc > 2) {
+        if (agility_schedule(ag, strtol(argv[2], NULL, 0)) != OS_OK) {
+            console_printf("Failed\n");
+        }
+    } else if (!strcmp(argv[1], "apply") && argc > 2) {
+        if (agility_apply(ag, strtol(argv[2], NULL, 0)) != OS_OK) {
+            console_printf("Failed\n");
+        }
+    } else if (!strcmp(argv[1], "scan") && argc > 3) {
+        agility_scan(ag, strtol(argv[2], NULL, 0), strtol(argv[3], NULL, 0));
+    } else {
+        console_printf("Unknown cmd\n");
+    }
+    return 0;
+}
+
+int
+agility_cli_register(void)
+{
+    return shell_cmd_register(&shell_agility_cmd);
+}
+#endif /* MYNEWT_VAL(AGILITY_CLI) */
@@ -0,0 +1,120 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file cli_batch.h
+ * @brief Batched, scriptable execution of shell commands
+ *
+ * @details A script, one command per line, is queued with cli_batch_add()
+ * or passed whole to cli_batch_exec(). Nothing runs until the whole script
+ * has been accepted: every line must name a command registered with
+ * cli_batch_register(). The commands then run in order and the batch stops
+ * at the first one returning non zero. Commands that registered a rollback
+ * hook are rolled back, latest first, so a failing commissioning script
+ * does not leave the device half configured.
+ *
+ * The outcome of a batch is a single JSON line written to the console in
+ * one go:
+ * {"batch": 3,"steps": [{"cmd": "cfg","rc": 0},{"cmd": "dw1000","rc": 2}],"done": 1,"rc": 2,"rollback": 1}
+ */
+
+#ifndef _CLI_BATCH_H_
+#define _CLI_BATCH_H_
+
+#include <stdint.h>
+#include <os/os.h>
+#include <os/queue.h>
+#include <stats/stats.h>
+#include <shell/shell.h>
+#include <json_stream/json_stream.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if MYNEWT_VAL(CLI_BATCH_STATS)
+STATS_SECT_START(cli_batch_stat_section)
+    STATS_SECT_ENTRY(batches)
+    STATS_SECT_ENTRY(steps)
+    STATS_SECT_ENTRY(failed)
+    STATS_SECT_ENTRY(rejected)
+    STATS_SECT_ENTRY(rollback)
+STATS_SECT_END
+#define CLI_BATCH_STATS_INC(__X) STATS_INC(g_cli_batch.stat, __X)
+#else
+#define CLI_BATCH_STATS_INC(__X) {}
+#endif
+
+//! Prepare or rollback hook
+typedef int (*cli_batch_hook_t)(void * arg);
+
+//! Batchable command
+struct cli_batch_cmd {
+    SLIST_ENTRY(cli_batch_cmd) next;   //!< Registry link
+    const struct shell_cmd * cmd;      //!< Shell command, its sc_cmd names it in scripts
+    cli_batch_hook_t prepare;          //!< Called before a batch using cmd runs, may be NULL
+    cli_batch_hook_t rollback;         //!< Called when a later step fails, may be NULL
+    void * arg;                        //!< Hook argument
+    uint8_t used:1;                    //!< Internal, cmd appears in the running batch
+};
+
+//! Batch status
+typedef struct _cli_batch_status_t{
+    uint16_t initialized:1;            //!< Instance initialised
+    uint16_t busy:1;                   //!< Batch running
+    uint16_t rollback:1;               //!< Last batch was rolled back
+    uint16_t overflow:1;               //!< Script did not fit, cleared by cli_batch_begin
+}cli_batch_status_t;
+
+//! Batch engine
+struct cli_batch_instance {
+#if MYNEWT_VAL(CLI_BATCH_STATS)
+    STATS_SECT_DECL(cli_batch_stat_section) stat; //!< Stats instance
+#endif
+    cli_batch_status_t status;         //!< Status
+    SLIST_HEAD(, cli_batch_cmd) cmds;  //!< Registered commands
+    uint32_t seq;                      //!< Batch number
+    uint16_t len;                      //!< Bytes of queued script
+    uint16_t nsteps;                   //!< Lines of queued script
+    struct cli_batch_cmd * steps[MYNEWT_VAL(CLI_BATCH_MAX_STEPS)]; //!< Command of each step
+    char script[MYNEWT_VAL(CLI_BATCH_SCRIPT_SIZE)]; //!< Queued script, lines separated by '\n'
+    char line[MYNEWT_VAL(CLI_BATCH_LINE_LEN)];      //!< Line being tokenised
+    struct json_stream js;             //!< Result encoder
+    char out[MYNEWT_VAL(CLI_BATCH_OUT_SIZE)];       //!< Result buffer
+};
+
+extern struct cli_batch_instance g_cli_batch;
+
+int cli_batch_register(struct cli_batch_cmd * bc);
+struct cli_batch_cmd * cli_batch_find(const char * name);
+void cli_batch_begin(void);
+int cli_batch_add(const char * line);
+int cli_batch_run(void);
+int cli_batch_exec(const char * script);
+
+#if MYNEWT_VAL(CLI_BATCH_CFG)
+int cli_batch_cfg_register(void);
+#endif
+int cli_batch_cli_register(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CLI_BATCH_H_ */
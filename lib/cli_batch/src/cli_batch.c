@@ -0,0 +1,382 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file cli_batch.c
+ * @brief Batched, scriptable execution of shell commands
+ */
+
+#include <assert.h>
+#include <string.h>
+#include <stdbool.h>
+#include <os/os.h>
+#include <syscfg/syscfg.h>
+#include <sysinit/sysinit.h>
+#include <console/console.h>
+
+#include <cli_batch/cli_batch.h>
+
+#if MYNEWT_VAL(CLI_BATCH_STATS)
+STATS_NAME_START(cli_batch_stat_section)
+    STATS_NAME(cli_batch_stat_section, batches)
+    STATS_NAME(cli_batch_stat_section, steps)
+    STATS_NAME(cli_batch_stat_section, failed)
+    STATS_NAME(cli_batch_stat_section, rejected)
+    STATS_NAME(cli_batch_stat_section, rollback)
+STATS_NAME_END(cli_batch_stat_section)
+#endif
+
+/*
+ * Zero initialised, the command list is valid before cli_batch_pkg_init so
+ * command sets initialised earlier can register.
+ */
+struct cli_batch_instance g_cli_batch;
+
+static int
+console_flush(void * arg, const char * data, uint16_t len)
+{
+    console_write(data, len);
+    return len;
+}
+
+/**
+ * @fn cli_batch_register(struct cli_batch_cmd * bc)
+ * @brief Make a shell command available to batches. The command stays
+ * registered with the shell as well.
+ *
+ * @param bc     Batchable command, must stay valid.
+ *
+ * @return OS_OK on success, OS_EINVAL if the name is already taken
+ */
+int
+cli_batch_register(struct cli_batch_cmd * bc)
+{
+    assert(bc->cmd && bc->cmd->sc_cmd_func);
+    if (cli_batch_find(bc->cmd->sc_cmd))
+        return OS_EINVAL;
+    bc->used = 0;
+    SLIST_INSERT_HEAD(&g_cli_batch.cmds, bc, next);
+    return OS_OK;
+}
+
+/**
+ * @fn cli_batch_find(const char * name)
+ * @brief Look up a batchable command.
+ *
+ * @param name   Command name.
+ *
+ * @return command, NULL if not registered
+ */
+struct cli_batch_cmd *
+cli_batch_find(const char * name)
+{
+    struct cli_batch_cmd * bc;
+
+    SLIST_FOREACH(bc, &g_cli_batch.cmds, next) {
+        if (!strcmp(bc->cmd->sc_cmd, name))
+            return bc;
+    }
+    return NULL;
+}
+
+/**
+ * @fn cli_batch_begin(void)
+ * @brief Discard the queued script and start a new one.
+ *
+ * @return void
+ */
+void
+cli_batch_begin(void)
+{
+    g_cli_batch.len = 0;
+    g_cli_batch.nsteps = 0;
+    g_cli_batch.status.overflow = 0;
+}
+
+/*
+ * Queue the n bytes at line, trimmed. line need not be terminated, so
+ * cli_batch_exec can queue straight from its script.
+ */
+static int
+queue_line(struct cli_batch_instance * cb, const char * line, uint16_t n)
+{
+    while (n && (*line == ' ' || *line == '\t')) {
+        line++;
+        n--;
+    }
+    while (n && (line[n - 1] == ' ' || line[n - 1] == '\t'))
+        n--;
+    if (n == 0 || line[0] == '#')
+        return OS_OK;
+
+    if (n >= sizeof(cb->line) || cb->len + n + 1 > sizeof(cb->script)
+        || cb->nsteps == MYNEWT_VAL(CLI_BATCH_MAX_STEPS)) {
+        cb->status.overflow = 1;
+        return OS_ENOMEM;
+    }
+    memcpy(&cb->script[cb->len], line, n);
+    cb->len += n;
+    cb->script[cb->len++] = '\n';
+    cb->nsteps++;
+    return OS_OK;
+}
+
+/**
+ * @fn cli_batch_add(const char * line)
+ * @brief Queue one command line. Blank lines and lines starting with '#'
+ * are ignored. If the script overflows the batch is rejected when run.
+ *
+ * @param line   Command line, up to the first newline.
+ *
+ * @return OS_OK on success, OS_EBUSY while a batch runs, OS_ENOMEM if the script is full
+ */
+int
+cli_batch_add(const char * line)
+{
+    struct cli_batch_instance * cb = &g_cli_batch;
+    uint16_t n = 0;
+
+    if (cb->status.busy)
+        return OS_EBUSY;
+
+    while (line[n] && line[n] != '\n' && line[n] != '\r')
+        n++;
+    return queue_line(cb, line, n);
+}
+
+/*
+ * Copy the line starting at script offset off into cb->line and split it in
+ * place, double quotes group words. Returns the offset of the next line.
+ */
+static uint16_t
+tokenise(struct cli_batch_instance * cb, uint16_t off, int * argc, char ** argv)
+{
+    char * p = cb->line;
+    uint16_t n = 0;
+
+    while (cb->script[off + n] != '\n')
+        n++;
+    memcpy(cb->line, &cb->script[off], n);
+    cb->line[n] = '\0';
+
+    *argc = 0;
+    while (*p) {
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if (*p == '\0')
+            break;
+        if (*argc == MYNEWT_VAL(CLI_BATCH_MAX_ARGS) - 1) {
+            *argc = -1;
+            break;
+        }
+        if (*p == '"') {
+            argv[(*argc)++] = ++p;
+            while (*p && *p != '"')
+                p++;
+        } else {
+            argv[(*argc)++] = p;
+            while (*p && *p != ' ' && *p != '\t')
+                p++;
+        }
+        if (*p)
+            *p++ = '\0';
+    }
+    if (*argc >= 0)
+        argv[*argc] = NULL;
+    return off + n + 1;
+}
+
+static void
+result_step(struct cli_batch_instance * cb, const char * name, int rc)
+{
+    json_stream_object_start(&cb->js);
+    json_stream_key(&cb->js, "cmd");
+    json_stream_string(&cb->js, name);
+    json_stream_key(&cb->js, "rc");
+    json_stream_int(&cb->js, rc);
+    json_stream_object_finish(&cb->js);
+}
+
+/**
+ * @fn cli_batch_run(void)
+ * @brief Run the queued script. Every line is checked against the registry
+ * before anything runs, then the prepare hooks of the commands used are
+ * called, then the commands run in order until one fails. On failure the
+ * rollback hooks of the commands that ran, the failing one included, are
+ * called latest first. A single result record is written to the console
+ * and the script is discarded.
+ *
+ * @return OS_OK if every command succeeded, else the first non zero return
+ */
+int
+cli_batch_run(void)
+{
+    struct cli_batch_instance * cb = &g_cli_batch;
+    struct cli_batch_cmd * bc;
+    char * argv[MYNEWT_VAL(CLI_BATCH_MAX_ARGS)];
+    int argc, rc = OS_OK;
+    uint16_t off, i, done = 0, ran = 0;
+
+    if (cb->status.busy)
+        return OS_EBUSY;
+    cb->status.busy = 1;
+    cb->status.rollback = 0;
+    cb->seq++;
+    CLI_BATCH_STATS_INC(batches);
+
+    json_stream_record_start(&cb->js);
+    json_stream_object_start(&cb->js);
+    json_stream_key(&cb->js, "batch");
+    json_stream_uint(&cb->js, cb->seq);
+    json_stream_key(&cb->js, "steps");
+    json_stream_array_start(&cb->js);
+
+    /* Accept the whole script or nothing */
+    if (cb->status.overflow)
+        rc = OS_ENOMEM;
+    for (i = 0, off = 0; rc == OS_OK && i < cb->nsteps; i++) {
+        off = tokenise(cb, off, &argc, argv);
+        if (argc < 0) {
+            rc = OS_EINVAL;
+            result_step(cb, cb->line, rc);
+        } else if ((cb->steps[i] = cli_batch_find(argv[0])) == NULL) {
+            rc = OS_ENOENT;
+            result_step(cb, argv[0], rc);
+        }
+    }
+    SLIST_FOREACH(bc, &cb->cmds, next)
+        bc->used = 0;
+    for (i = 0; rc == OS_OK && i < cb->nsteps; i++) {
+        bc = cb->steps[i];
+        if (bc->used)
+            continue;
+        bc->used = 1;
+        if (bc->prepare && (rc = bc->prepare(bc->arg)) != 0)
+            result_step(cb, bc->cmd->sc_cmd, rc);
+    }
+    if (rc != OS_OK)
+        CLI_BATCH_STATS_INC(rejected);
+
+    for (i = 0, off = 0; rc == OS_OK && i < cb->nsteps; i++) {
+        bc = cb->steps[i];
+        off = tokenise(cb, off, &argc, argv);
+        rc = bc->cmd->sc_cmd_func(argc, argv);
+        result_step(cb, bc->cmd->sc_cmd, rc);
+        CLI_BATCH_STATS_INC(steps);
+        ran++;
+        if (rc == 0)
+            done++;
+    }
+
+    if (rc != OS_OK && ran) {
+        CLI_BATCH_STATS_INC(failed);
+        /* used still marks the commands whose rollback is pending */
+        for (i = ran; i > 0; i--) {
+            bc = cb->steps[i - 1];
+            if (!bc->used)
+                continue;
+            bc->used = 0;
+            if (bc->rollback) {
+                bc->rollback(bc->arg);
+                cb->status.rollback = 1;
+            }
+        }
+        if (cb->status.rollback)
+            CLI_BATCH_STATS_INC(rollback);
+    }
+    SLIST_FOREACH(bc, &cb->cmds, next)
+        bc->used = 0;
+
+    json_stream_array_finish(&cb->js);
+    json_stream_key(&cb->js, "done");
+    json_stream_uint(&cb->js, done);
+    json_stream_key(&cb->js, "rc");
+    json_stream_int(&cb->js, rc);
+    json_stream_key(&cb->js, "rollback");
+    json_stream_uint(&cb->js, cb->status.rollback);
+    json_stream_object_finish(&cb->js);
+    json_stream_record_end(&cb->js);
+
+    cli_batch_begin();
+    cb->status.busy = 0;
+    return rc;
+}
+
+/**
+ * @fn cli_batch_exec(const char * script)
+ * @brief Queue and run a whole script, lines separated by newlines or by
+ * ';' outside double quotes.
+ *
+ * @param script Script.
+ *
+ * @return as cli_batch_run(), OS_ENOMEM if the script does not fit
+ */
+int
+cli_batch_exec(const char * script)
+{
+    struct cli_batch_instance * cb = &g_cli_batch;
+    bool quoted = false;
+    uint16_t n;
+
+    if (cb->status.busy)
+        return OS_EBUSY;
+    cli_batch_begin();
+    while (*script) {
+        for (n = 0; script[n] && script[n] != '\n' && (quoted || script[n] != ';'); n++) {
+            if (script[n] == '"')
+                quoted = !quoted;
+        }
+        queue_line(cb, script, (n && script[n - 1] == '\r') ? n - 1 : n);
+        script += n;
+        if (*script)
+            script++;
+    }
+    return cli_batch_run();
+}
+
+/**
+ * @fn cli_batch_pkg_init(void)
+ * @brief API to initialise the package, registers the batch shell command
+ * and the built in cfg command.
+ *
+ * @return void
+ */
+void
+cli_batch_pkg_init(void)
+{
+    struct cli_batch_instance * cb = &g_cli_batch;
+
+    if (cb->status.initialized)
+        return;
+    json_stream_init(&cb->js, cb->out, sizeof(cb->out), console_flush, NULL);
+#if MYNEWT_VAL(CLI_BATCH_STATS)
+    int rc = stats_init(
+                STATS_HDR(cb->stat),
+                STATS_SIZE_INIT_PARMS(cb->stat, STATS_SIZE_32),
+                STATS_NAME_INIT_PARMS(cli_batch_stat_section)
+        );
+    rc |= stats_register("cli_batch", STATS_HDR(cb->stat));
+    assert(rc == 0);
+#endif
+    cb->status.initialized = 1;
+#if MYNEWT_VAL(CLI_BATCH_CFG)
+    cli_batch_cfg_register();
+#endif
+    cli_batch_cli_register();
+}
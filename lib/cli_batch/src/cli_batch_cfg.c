@@ -0,0 +1,169 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file cli_batch_cfg.c
+ * @brief Config command with rollback, for use in batches
+ *
+ * @details cfg <name>            show a value, e.g. cfg uwb/channel
+ *          cfg <name> <value>    set a value
+ *          cfg commit            apply set values
+ *          cfg save              persist values
+ *
+ * Within a batch the previous value of every name set is kept, if the batch
+ * fails the values are restored latest first and committed again.
+ */
+
+#include <string.h>
+#include <os/os.h>
+#include <syscfg/syscfg.h>
+#include <console/console.h>
+#include <config/config.h>
+
+#include <cli_batch/cli_batch.h>
+
+#if MYNEWT_VAL(CLI_BATCH_CFG)
+
+//! Undo entry
+struct cfg_undo {
+    char name[MYNEWT_VAL(CLI_BATCH_CFG_NAME_LEN)];
+    char val[MYNEWT_VAL(CLI_BATCH_CFG_VAL_LEN)];
+};
+
+static struct cfg_undo g_undo[MYNEWT_VAL(CLI_BATCH_CFG_MAX_UNDO)];
+static uint16_t g_nundo;
+
+static int cfg_cli_cmd(int argc, char **argv);
+
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+const struct shell_param cmd_cfg_param[] = {
+    {"<name>", "show value"},
+    {"<name> <value>", "set value"},
+    {"commit", "apply set values"},
+    {"save", "persist values"},
+    {NULL,NULL},
+};
+
+const struct shell_cmd_help cmd_cfg_help = {
+	"config", "cfg <name> [value]", cmd_cfg_param
+};
+#endif
+
+static struct shell_cmd shell_cfg_cmd = {
+    .sc_cmd = "cfg",
+    .sc_cmd_func = cfg_cli_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+    .help = &cmd_cfg_help
+#endif
+};
+
+static int
+cfg_prepare(void * arg)
+{
+    g_nundo = 0;
+    return OS_OK;
+}
+
+static int
+cfg_rollback(void * arg)
+{
+    while (g_nundo) {
+        g_nundo--;
+        conf_set_value(g_undo[g_nundo].name, g_undo[g_nundo].val);
+    }
+    return conf_commit(NULL);
+}
+
+static struct cli_batch_cmd batch_cfg_cmd = {
+    .cmd = &shell_cfg_cmd,
+    .prepare = cfg_prepare,
+    .rollback = cfg_rollback,
+};
+
+/*
+ * Keep the current value of name so a failing batch can restore it. A value
+ * that cannot be kept fails the set, rollback would be incomplete otherwise.
+ */
+static int
+cfg_undo_push(char * name)
+{
+    struct cfg_undo * u;
+
+    if (g_nundo == MYNEWT_VAL(CLI_BATCH_CFG_MAX_UNDO)
+        || strlen(name) >= sizeof(u->name))
+        return OS_ENOMEM;
+    u = &g_undo[g_nundo];
+    if (conf_get_value(name, u->val, sizeof(u->val)) == NULL)
+        return OS_ENOENT;
+    strcpy(u->name, name);
+    g_nundo++;
+    return OS_OK;
+}
+
+static int
+cfg_cli_cmd(int argc, char **argv)
+{
+    char buf[MYNEWT_VAL(CLI_BATCH_CFG_VAL_LEN)];
+    char * val;
+    int rc;
+
+    if (argc < 2) {
+        console_printf("Too few args\n");
+        return OS_EINVAL;
+    }
+    if (argc == 2 && !strcmp(argv[1], "commit"))
+        return conf_commit(NULL);
+    if (argc == 2 && !strcmp(argv[1], "save"))
+        return conf_save();
+
+    if (argc == 2) {
+        val = conf_get_value(argv[1], buf, sizeof(buf));
+        if (val == NULL)
+            return OS_ENOENT;
+        console_printf("%s = %s\n", argv[1], val);
+        return OS_OK;
+    }
+
+    if (g_cli_batch.status.busy) {
+        rc = cfg_undo_push(argv[1]);
+        if (rc)
+            return rc;
+    }
+    rc = conf_set_value(argv[1], argv[2]);
+    if (rc && g_cli_batch.status.busy)
+        g_nundo--;
+    return rc;
+}
+
+/**
+ * @fn cli_batch_cfg_register(void)
+ * @brief Register the cfg command with the shell and the batch engine.
+ *
+ * @return OS_OK on success
+ */
+int
+cli_batch_cfg_register(void)
+{
+    int rc = cli_batch_register(&batch_cfg_cmd);
+    if (rc)
+        return rc;
+    return shell_cmd_register(&shell_cfg_cmd);
+}
+
+#endif
@@ -0,0 +1,138 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file cli_batch_cli.c
+ * @brief Shell front end of the batch engine
+ */
+
+#include <string.h>
+#include <os/os.h>
+#include <syscfg/syscfg.h>
+#include <console/console.h>
+
+#include <cli_batch/cli_batch.h>
+
+static int cli_batch_cli_cmd(int argc, char **argv);
+
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+const struct shell_param cmd_batch_param[] = {
+    {"begin", "start a new script"},
+    {"add", "<cmd ...> queue a command"},
+    {"run", "run the queued script"},
+    {"abort", "discard the queued script"},
+    {"exec", "<cmd ; cmd ...> queue and run"},
+    {"status", "show queued steps and commands"},
+    {NULL,NULL},
+};
+
+const struct shell_cmd_help cmd_batch_help = {
+	"batch", "batch <cmd>", cmd_batch_param
+};
+#endif
+
+static struct shell_cmd shell_batch_cmd = {
+    .sc_cmd = "batch",
+    .sc_cmd_func = cli_batch_cli_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+    .help = &cmd_batch_help
+#endif
+};
+
+/*
+ * The shell has split the line already, join the words back. Kept apart
+ * from g_cli_batch.line, which cli_batch_run tokenises into.
+ */
+static char g_args[MYNEWT_VAL(CLI_BATCH_SCRIPT_SIZE)];
+
+static char *
+join_args(int argc, char **argv)
+{
+    char * line = g_args;
+    uint16_t len = 0, n;
+    int i;
+
+    for (i = 0; i < argc; i++) {
+        n = strlen(argv[i]);
+        if (len + n + 2 > sizeof(g_args))
+            return NULL;
+        if (i)
+            line[len++] = ' ';
+        memcpy(&line[len], argv[i], n);
+        len += n;
+    }
+    line[len] = '\0';
+    return line;
+}
+
+static int
+cli_batch_cli_cmd(int argc, char **argv)
+{
+    struct cli_batch_cmd * bc;
+    char * line;
+    int rc;
+
+    if (argc < 2) {
+        console_printf("Too few args\n");
+        return OS_EINVAL;
+    }
+
+    if (!strcmp(argv[1], "begin") || !strcmp(argv[1], "abort")) {
+        if (g_cli_batch.status.busy)
+            return OS_EBUSY;
+        cli_batch_begin();
+    } else if (!strcmp(argv[1], "add")) {
+        if ((line = join_args(argc - 2, &argv[2])) == NULL)
+            return OS_ENOMEM;
+        rc = cli_batch_add(line);
+        if (rc)
+            console_printf("batch add failed %d\n", rc);
+        return rc;
+    } else if (!strcmp(argv[1], "run")) {
+        return cli_batch_run();
+    } else if (!strcmp(argv[1], "exec")) {
+        if ((line = join_args(argc - 2, &argv[2])) == NULL)
+            return OS_ENOMEM;
+        return cli_batch_exec(line);
+    } else if (!strcmp(argv[1], "status")) {
+        console_printf("batch %lu steps %u bytes %u%s%s\n",
+            (unsigned long)g_cli_batch.seq, g_cli_batch.nsteps, g_cli_batch.len,
+            g_cli_batch.status.overflow ? " overflow" : "",
+            g_cli_batch.status.rollback ? " rollback" : "");
+        SLIST_FOREACH(bc, &g_cli_batch.cmds, next) {
+            console_printf("  %s%s\n", bc->cmd->sc_cmd, bc->rollback ? " (rollback)" : "");
+        }
+    } else {
+        console_printf("Unknown cmd\n");
+        return OS_EINVAL;
+    }
+    return 0;
+}
+
+/**
+ * @fn cli_batch_cli_register(void)
+ * @brief Register the batch shell command.
+ *
+ * @return OS_OK on success
+ */
+int
+cli_batch_cli_register(void)
+{
+    return shell_cmd_register(&shell_batch_cmd);
+}
@@ -0,0 +1,129 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "cli_batch_test.h"
+
+struct cli_batch_test_log g_cli_batch_test_log;
+
+static char g_out[MYNEWT_VAL(CLI_BATCH_OUT_SIZE)];
+
+static void
+trace(const char * s)
+{
+    strncat(g_cli_batch_test_log.trace, s,
+            sizeof(g_cli_batch_test_log.trace) - strlen(g_cli_batch_test_log.trace) - 1);
+}
+
+static void
+trace_cmd(int argc, char **argv)
+{
+    for (int i = 0; i < argc; i++) {
+        trace(argv[i]);
+        trace((i < argc - 1) ? "|" : ";");
+    }
+}
+
+static int
+set_cmd(int argc, char **argv)
+{
+    trace_cmd(argc, argv);
+    return (argc > 1) ? atoi(argv[1]) : 0;
+}
+
+static int
+log_cmd(int argc, char **argv)
+{
+    trace_cmd(argc, argv);
+    return 0;
+}
+
+static int
+nest_cmd(int argc, char **argv)
+{
+    trace_cmd(argc, argv);
+    g_cli_batch_test_log.nested_rc = cli_batch_exec((argc > 1) ? argv[1] : "");
+    return 0;
+}
+
+static int
+prepare_hook(void * arg)
+{
+    trace("+");
+    trace((const char *)arg);
+    trace(";");
+    return g_cli_batch_test_log.prepare_rc;
+}
+
+static int
+rollback_hook(void * arg)
+{
+    trace("-");
+    trace((const char *)arg);
+    trace(";");
+    return 0;
+}
+
+static const struct shell_cmd g_cmds[CLI_BATCH_TEST_NCMDS] = {
+    [CLI_BATCH_TEST_SET] = {.sc_cmd = "set", .sc_cmd_func = set_cmd},
+    [CLI_BATCH_TEST_LOG] = {.sc_cmd = "log", .sc_cmd_func = log_cmd},
+    [CLI_BATCH_TEST_ARM] = {.sc_cmd = "arm", .sc_cmd_func = log_cmd},
+    [CLI_BATCH_TEST_NEST] = {.sc_cmd = "nest", .sc_cmd_func = nest_cmd},
+};
+
+static struct cli_batch_cmd g_batch_cmds[CLI_BATCH_TEST_NCMDS];
+
+/* Result records, appended to the log as the console would show them */
+static int
+out_flush(void * arg, const char * data, uint16_t len)
+{
+    struct cli_batch_test_log * log = &g_cli_batch_test_log;
+    uint16_t used = strlen(log->out);
+
+    if (used + len >= sizeof(log->out))
+        len = sizeof(log->out) - used - 1;
+    memcpy(&log->out[used], data, len);
+    log->out[used + len] = '\0';
+    return len;
+}
+
+/**
+ * Reset the batch engine with only the stub commands registered, its
+ * result records going to g_cli_batch_test_log.out.
+ */
+void
+cli_batch_test_setup(void)
+{
+    memset(&g_cli_batch, 0, sizeof(g_cli_batch));
+    memset(&g_cli_batch_test_log, 0, sizeof(g_cli_batch_test_log));
+    json_stream_init(&g_cli_batch.js, g_out, sizeof(g_out), out_flush, NULL);
+    g_cli_batch.status.initialized = 1;
+
+    memset(g_batch_cmds, 0, sizeof(g_batch_cmds));
+    for (uint16_t i = 0; i < CLI_BATCH_TEST_NCMDS; i++) {
+        g_batch_cmds[i].cmd = &g_cmds[i];
+        g_batch_cmds[i].arg = (void *)g_cmds[i].sc_cmd;
+    }
+    g_batch_cmds[CLI_BATCH_TEST_SET].rollback = rollback_hook;
+    g_batch_cmds[CLI_BATCH_TEST_ARM].prepare = prepare_hook;
+    g_batch_cmds[CLI_BATCH_TEST_ARM].rollback = rollback_hook;
+    for (uint16_t i = 0; i < CLI_BATCH_TEST_NCMDS; i++) {
+        TEST_ASSERT(cli_batch_register(&g_batch_cmds[i]) == OS_OK);
+    }
+    TEST_ASSERT(cli_batch_register(&g_batch_cmds[CLI_BATCH_TEST_SET]) == OS_EINVAL);
+}
@@ -0,0 +1,47 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "cli_batch_test.h"
+
+TEST_CASE_DECL(cli_batch_reject_test)
+TEST_CASE_DECL(cli_batch_rollback_test)
+TEST_CASE_DECL(cli_batch_split_test)
+TEST_CASE_DECL(cli_batch_overflow_test)
+TEST_CASE_DECL(cli_batch_exec_test)
+
+TEST_SUITE(cli_batch_test_all)
+{
+    cli_batch_reject_test();
+    cli_batch_rollback_test();
+    cli_batch_split_test();
+    cli_batch_overflow_test();
+    cli_batch_exec_test();
+}
+
+#if MYNEWT_VAL(SELFTEST)
+int
+main(int argc, char **argv)
+{
+    sysinit();
+
+    cli_batch_test_all();
+
+    return tu_any_failed;
+}
+#endif
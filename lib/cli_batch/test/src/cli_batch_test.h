@@ -0,0 +1,63 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _CLI_BATCH_TEST_H
+#define _CLI_BATCH_TEST_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "testutil/testutil.h"
+
+#include "cli_batch/cli_batch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Stub commands, registered by cli_batch_test_setup()
+typedef enum _cli_batch_test_cmd_t{
+    CLI_BATCH_TEST_SET = 0,            //!< "set", returns its first argument as a number, rollback hook
+    CLI_BATCH_TEST_LOG,                //!< "log", returns 0, no hooks
+    CLI_BATCH_TEST_ARM,                //!< "arm", returns 0, prepare and rollback hooks
+    CLI_BATCH_TEST_NEST,               //!< "nest", runs its arguments as a nested batch
+    CLI_BATCH_TEST_NCMDS
+}cli_batch_test_cmd_t;
+
+//! What the stub commands and hooks saw
+struct cli_batch_test_log {
+    char trace[512];                   //!< One entry per call, "cmd arg|arg;" or "+prepare;" / "-rollback;"
+    int nested_rc;                     //!< Result of the nested batch of "nest"
+    int prepare_rc;                    //!< Returned by the prepare hook of "arm"
+    char out[1024];                    //!< Result records written
+};
+
+extern struct cli_batch_test_log g_cli_batch_test_log;
+
+void cli_batch_test_setup(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,51 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "cli_batch_test.h"
+
+/**
+ * cli_batch_exec leaves its script untouched, so it runs from a string
+ * literal, discards a script queued before it, and a batch started from
+ * inside a running batch is refused without disturbing the outer one.
+ */
+TEST_CASE(cli_batch_exec_test)
+{
+    struct cli_batch_test_log * log = &g_cli_batch_test_log;
+
+    cli_batch_test_setup();
+    TEST_ASSERT(cli_batch_exec("set 0;log a;log b") == OS_OK);
+    TEST_ASSERT(!strcmp(log->trace, "set|0;log|a;log|b;"), "%s", log->trace);
+
+    log->trace[0] = '\0';
+    TEST_ASSERT(cli_batch_add("set 9") == OS_OK);
+    TEST_ASSERT(cli_batch_exec("log") == OS_OK);
+    TEST_ASSERT(!strcmp(log->trace, "log;"), "%s", log->trace);
+
+    log->trace[0] = '\0';
+    TEST_ASSERT(cli_batch_exec("log;nest \"set 2\";log") == OS_OK);
+    TEST_ASSERT(log->nested_rc == OS_EBUSY);
+    TEST_ASSERT(!strcmp(log->trace, "log;nest|set 2;log;"), "%s", log->trace);
+    TEST_ASSERT(!g_cli_batch.status.busy);
+
+    g_cli_batch.status.busy = 1;
+    TEST_ASSERT(cli_batch_add("log") == OS_EBUSY);
+    TEST_ASSERT(cli_batch_run() == OS_EBUSY);
+    TEST_ASSERT(cli_batch_exec("log") == OS_EBUSY);
+    g_cli_batch.status.busy = 0;
+    TEST_ASSERT(g_cli_batch.nsteps == 0);
+}
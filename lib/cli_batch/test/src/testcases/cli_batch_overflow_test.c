@@ -0,0 +1,68 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "cli_batch_test.h"
+
+/**
+ * A script longer than the buffer, with more steps than allowed or with a
+ * line longer than CLI_BATCH_LINE_LEN is rejected whole when run.
+ */
+TEST_CASE(cli_batch_overflow_test)
+{
+    struct cli_batch_test_log * log = &g_cli_batch_test_log;
+    char line[MYNEWT_VAL(CLI_BATCH_SCRIPT_SIZE) + 32];
+    uint16_t i;
+
+    cli_batch_test_setup();
+
+    // Steps
+    for (i = 0; i < MYNEWT_VAL(CLI_BATCH_MAX_STEPS); i++)
+        TEST_ASSERT(cli_batch_add("log") == OS_OK);
+    TEST_ASSERT(cli_batch_add("log") == OS_ENOMEM);
+    TEST_ASSERT(g_cli_batch.status.overflow);
+    TEST_ASSERT(cli_batch_run() == OS_ENOMEM);
+    TEST_ASSERT(log->trace[0] == '\0');
+    TEST_ASSERT(!g_cli_batch.status.overflow);
+
+    // Line, one byte short of the buffer fits
+    memset(line, 'x', sizeof(line));
+    memcpy(line, "log ", 4);
+    line[MYNEWT_VAL(CLI_BATCH_LINE_LEN)] = '\0';
+    TEST_ASSERT(cli_batch_add(line) == OS_ENOMEM);
+    cli_batch_begin();
+    line[MYNEWT_VAL(CLI_BATCH_LINE_LEN) - 1] = '\0';
+    TEST_ASSERT(cli_batch_add(line) == OS_OK);
+    TEST_ASSERT(cli_batch_run() == OS_OK);
+    TEST_ASSERT(strlen(log->trace) == MYNEWT_VAL(CLI_BATCH_LINE_LEN));
+
+    // Script, through exec. 24 byte lines fill it before the step limit
+    memset(line, 0, sizeof(line));
+    for (i = 0; (i + 1) * 25 <= MYNEWT_VAL(CLI_BATCH_SCRIPT_SIZE); i++)
+        strcat(line, "log 0123456789abcdefghij;");
+    TEST_ASSERT_FATAL(i < MYNEWT_VAL(CLI_BATCH_MAX_STEPS));
+    log->trace[0] = '\0';
+    TEST_ASSERT(cli_batch_exec(line) == OS_OK);
+    TEST_ASSERT(strlen(log->trace) == i * 25);
+    strcat(line, "log 0123456789abcdefghij");
+    log->trace[0] = '\0';
+    TEST_ASSERT(cli_batch_exec(line) == OS_ENOMEM);
+    TEST_ASSERT(log->trace[0] == '\0');
+#if MYNEWT_VAL(CLI_BATCH_STATS)
+    TEST_ASSERT(g_cli_batch.stat.rejected == 2);
+#endif
+}
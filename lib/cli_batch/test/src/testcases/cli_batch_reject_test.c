@@ -0,0 +1,72 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "cli_batch_test.h"
+
+/**
+ * The whole script is checked before anything runs: an unknown command, a
+ * line with too many arguments or a failing prepare hook rejects the batch
+ * with no command run and no rollback.
+ */
+TEST_CASE(cli_batch_reject_test)
+{
+    struct cli_batch_test_log * log = &g_cli_batch_test_log;
+    char line[MYNEWT_VAL(CLI_BATCH_LINE_LEN)];
+    char expect[96];
+
+    cli_batch_test_setup();
+    TEST_ASSERT(cli_batch_add("set 0") == OS_OK);
+    TEST_ASSERT(cli_batch_add("arm") == OS_OK);
+    TEST_ASSERT(cli_batch_add("nosuch 1") == OS_OK);
+    TEST_ASSERT(cli_batch_add("log") == OS_OK);
+    TEST_ASSERT(cli_batch_run() == OS_ENOENT);
+    TEST_ASSERT(log->trace[0] == '\0', "ran %s", log->trace);
+    TEST_ASSERT(!g_cli_batch.status.rollback);
+    snprintf(expect, sizeof(expect),
+             "{\"batch\": 1,\"steps\": [{\"cmd\": \"nosuch\",\"rc\": %d}],\"done\": 0,\"rc\": %d,\"rollback\": 0}\n",
+             OS_ENOENT, OS_ENOENT);
+    TEST_ASSERT(!strcmp(log->out, expect), "%s", log->out);
+    // The script is discarded either way
+    TEST_ASSERT(g_cli_batch.nsteps == 0 && g_cli_batch.len == 0);
+
+    // One argument too many
+    strcpy(line, "log");
+    for (uint16_t i = 1; i < MYNEWT_VAL(CLI_BATCH_MAX_ARGS); i++)
+        strcat(line, " a");
+    TEST_ASSERT(cli_batch_add("set 0") == OS_OK);
+    TEST_ASSERT(cli_batch_add(line) == OS_OK);
+    TEST_ASSERT(cli_batch_run() == OS_EINVAL);
+    TEST_ASSERT(log->trace[0] == '\0', "ran %s", log->trace);
+    // One less fits
+    line[strlen(line) - 2] = '\0';
+    TEST_ASSERT(cli_batch_exec(line) == OS_OK);
+    TEST_ASSERT(log->trace[0] == 'l');
+
+    // A prepare hook refusing
+    log->trace[0] = '\0';
+    log->prepare_rc = 7;
+    TEST_ASSERT(cli_batch_exec("set 0;arm;arm") == 7);
+    TEST_ASSERT(!strcmp(log->trace, "+arm;"), "%s", log->trace);
+    TEST_ASSERT(!g_cli_batch.status.rollback);
+#if MYNEWT_VAL(CLI_BATCH_STATS)
+    TEST_ASSERT(g_cli_batch.stat.rejected == 3);
+    TEST_ASSERT(g_cli_batch.stat.failed == 0);
+    TEST_ASSERT(g_cli_batch.stat.steps == 1);
+    TEST_ASSERT(g_cli_batch.stat.batches == 4);
+#endif
+}
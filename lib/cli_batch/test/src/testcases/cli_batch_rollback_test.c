@@ -0,0 +1,62 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "cli_batch_test.h"
+
+/**
+ * The batch stops at the first command failing. The commands that ran,
+ * the failing one included, are rolled back latest first, each command
+ * once however many times it ran. Prepare hooks likewise run once.
+ */
+TEST_CASE(cli_batch_rollback_test)
+{
+    struct cli_batch_test_log * log = &g_cli_batch_test_log;
+
+    cli_batch_test_setup();
+    TEST_ASSERT(cli_batch_exec("set 0 a\nlog b\narm\nset 0 c\narm\nlog d") == OS_OK);
+    TEST_ASSERT(!strcmp(log->trace, "+arm;set|0|a;log|b;arm;set|0|c;arm;log|d;"), "%s", log->trace);
+    TEST_ASSERT(!g_cli_batch.status.rollback);
+
+    log->trace[0] = '\0';
+    log->out[0] = '\0';
+    TEST_ASSERT(cli_batch_exec("arm x\nset 0\nlog\nset 5\nlog never\nset 0") == 5);
+    TEST_ASSERT(!strcmp(log->trace, "+arm;arm|x;set|0;log;set|5;-set;-arm;"), "%s", log->trace);
+    TEST_ASSERT(g_cli_batch.status.rollback);
+    TEST_ASSERT(!strcmp(log->out,
+        "{\"batch\": 2,\"steps\": [{\"cmd\": \"arm\",\"rc\": 0},{\"cmd\": \"set\",\"rc\": 0},"
+        "{\"cmd\": \"log\",\"rc\": 0},{\"cmd\": \"set\",\"rc\": 5}],\"done\": 3,\"rc\": 5,\"rollback\": 1}\n"),
+        "%s", log->out);
+
+    // Failing first, only its own rollback
+    log->trace[0] = '\0';
+    TEST_ASSERT(cli_batch_exec("set -1;arm") == -1);
+    TEST_ASSERT(!strcmp(log->trace, "+arm;set|-1;-set;"), "%s", log->trace);
+
+    // set ran twice and is rolled back once, nest has no hook
+    log->trace[0] = '\0';
+    TEST_ASSERT(cli_batch_exec("set 0;arm;nest \"\";set 4") == 4);
+    TEST_ASSERT(!strcmp(log->trace, "+arm;set|0;arm;nest|;set|4;-set;-arm;"), "%s", log->trace);
+
+    // The flag only describes the last batch
+    TEST_ASSERT(cli_batch_exec("log") == OS_OK);
+    TEST_ASSERT(!g_cli_batch.status.rollback);
+#if MYNEWT_VAL(CLI_BATCH_STATS)
+    TEST_ASSERT(g_cli_batch.stat.failed == 3);
+    TEST_ASSERT(g_cli_batch.stat.rollback == 3);
+#endif
+}
@@ -0,0 +1,46 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "cli_batch_test.h"
+
+/**
+ * Scripts split on newlines and on ';' outside double quotes, lines are
+ * trimmed and blank or '#' lines skipped, quotes group words.
+ */
+TEST_CASE(cli_batch_split_test)
+{
+    struct cli_batch_test_log * log = &g_cli_batch_test_log;
+
+    cli_batch_test_setup();
+    TEST_ASSERT(cli_batch_exec("log \"a; b\" c;log\t\"\"  d ;  # skipped; ;\r\n\n  log \"e f\"g\r\nlog") == OS_OK);
+    TEST_ASSERT(!strcmp(log->trace, "log|a; b|c;log||d;log|e f|g;log;"), "%s", log->trace);
+
+    // An unterminated quote runs to the end of the line
+    log->trace[0] = '\0';
+    TEST_ASSERT(cli_batch_exec("log \"x y") == OS_OK);
+    TEST_ASSERT(!strcmp(log->trace, "log|x y;"), "%s", log->trace);
+
+    // cli_batch_add takes one line, up to the first newline
+    log->trace[0] = '\0';
+    TEST_ASSERT(cli_batch_add("  log 1;2  \nlog 3") == OS_OK);
+    TEST_ASSERT(cli_batch_add("# comment") == OS_OK);
+    TEST_ASSERT(cli_batch_add(" \t ") == OS_OK);
+    TEST_ASSERT(g_cli_batch.nsteps == 1);
+    TEST_ASSERT(cli_batch_run() == OS_OK);
+    TEST_ASSERT(!strcmp(log->trace, "log|1;2;"), "%s", log->trace);
+}
@@ -0,0 +1,147 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file diversity.h
+ * @brief Dual radio diversity ranging
+ *
+ * @details On nodes with two transceivers on one clock, such as the DWM1002,
+ * the first radio runs the uwb_rng exchange while the second listens and
+ * timestamps the same frames. Once the radios are synchronised with
+ * diversity_sync() the counters agree to within DIVERSITY_OFFSET, so the
+ * receive timestamps of the second radio can stand in for those of the first
+ * in the exchange and give a second time of flight over its own antenna and
+ * channel from the one request. Each range gets a standard deviation from
+ * the quality model of uwb_rng, the receiver diagnostics being those of the
+ * radio; the two are averaged with inverse variance weights or the better
+ * one is taken, and the phase difference between the radios is reported for
+ * the last frame both received. The result of the last range is in
+ * diversity_instance::last when the complete_cb of the applications run.
+ *
+ * The second radio must not range itself, its uwb_rng sees the frames as
+ * unsolicited and passes them on. It takes frames addressed to the first
+ * radio, so it needs frame filtering off or the same short address.
+ */
+
+#ifndef _DIVERSITY_H_
+#define _DIVERSITY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stats/stats.h>
+#include <uwb/uwb.h>
+#include <uwb_rng/uwb_rng.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DIVERSITY_SLAVE_MISS (0x01)    //!< Second radio missed a frame of the exchange
+#define DIVERSITY_DISAGREE   (0x02)    //!< Ranges further apart than DIVERSITY_GATE allows
+#define DIVERSITY_COMBINED   (0x04)    //!< Range is the weighted mean of both radios
+#define DIVERSITY_UNSYNCED   (0x08)    //!< Radios not synchronised, first radio only
+
+#if MYNEWT_VAL(DIVERSITY_STATS)
+STATS_SECT_START(diversity_stat_section)
+    STATS_SECT_ENTRY(rx_frames)
+    STATS_SECT_ENTRY(ranges)
+    STATS_SECT_ENTRY(slave_miss)
+    STATS_SECT_ENTRY(unsynced)
+    STATS_SECT_ENTRY(disagree)
+    STATS_SECT_ENTRY(combined)
+    STATS_SECT_ENTRY(radio0)
+    STATS_SECT_ENTRY(radio1)
+STATS_SECT_END
+#define DIVERSITY_STATS_INC(__X) STATS_INC(div->stat, __X)
+#else
+#define DIVERSITY_STATS_INC(__X) {}
+#endif
+
+//! Ranging frame heard by the second radio
+struct diversity_rx {
+    uint16_t src_address;              //!< Source short address, 0 marks a free entry
+    uint8_t seq_num;                   //!< Sequence number
+    uint16_t code;                     //!< Ranging code
+    uint64_t timestamp;                //!< Receive timestamp, dwt units
+    int32_t carrier_integrator;        //!< Carrier integrator
+    union {
+        struct uwb_dev_rxdiag diag;    //!< Receiver diagnostics, rxd_len 0 if not enabled
+        uint8_t diag_storage[MYNEWT_VAL(UWB_DEV_RXDIAG_MAXLEN)];
+    };
+};
+
+//! Outcome of one range over both radios
+struct diversity_result {
+    uint16_t peer;                     //!< Peer short address
+    uint16_t code;                     //!< Ranging code of the exchange
+    uint8_t flags;                     //!< DIVERSITY_* flags
+    uint8_t radio;                     //!< Radio of lower standard deviation
+    float tof;                         //!< Time of flight reported, dwt units
+    float range;                       //!< Range reported, m
+    float stdev;                       //!< Its standard deviation, m
+    float ranges[2];                   //!< Range of each radio, m, NAN for a miss
+    float stdevs[2];                   //!< Standard deviation of each, m
+    float pdoa;                        //!< Phase of the second radio minus the first, radians, NAN if unknown
+};
+
+//! Status
+typedef struct _diversity_status_t{
+    uint16_t selfmalloc:1;             //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;            //!< Instance allocated
+    uint16_t listening:1;              //!< Second radio in continuous receive
+    uint16_t valid:1;                  //!< last holds a result
+}diversity_status_t;
+
+//! Diversity instance
+struct diversity_instance {
+#if MYNEWT_VAL(DIVERSITY_STATS)
+    STATS_SECT_DECL(diversity_stat_section) stat; //!< Stats instance
+#endif
+    struct uwb_dev * dev_inst;         //!< Radio running the exchange
+    struct uwb_dev * slave;            //!< Radio listening
+    struct uwb_rng_instance * rng;     //!< Ranging instance of dev_inst
+    struct uwb_mac_interface cbs;      //!< MAC layer callbacks of dev_inst
+    struct uwb_mac_interface slave_cbs; //!< MAC layer callbacks of the slave
+    diversity_status_t status;         //!< Status
+    int32_t offset;                    //!< Slave minus master timestamp of a frame, dwt units
+    uint16_t idx;                      //!< Ring index of the last range combined
+    uint16_t rx_idx;                   //!< Entries written to rx
+    struct diversity_result last;      //!< Result of the last range
+    struct diversity_rx rx[MYNEWT_VAL(DIVERSITY_RX_FRAMES)]; //!< Frames heard by the slave
+};
+
+struct diversity_instance * diversity_init(struct diversity_instance * div, struct uwb_rng_instance * rng,
+                                           struct uwb_dev * slave);
+void diversity_free(struct diversity_instance * div);
+struct diversity_instance * diversity_get_instance(struct uwb_dev * inst);
+
+struct uwb_dev_status diversity_sync(struct diversity_instance * div);
+struct uwb_dev_status diversity_listen(struct diversity_instance * div);
+void diversity_stop(struct diversity_instance * div);
+
+struct diversity_rx * diversity_find_rx(struct diversity_instance * div, uint16_t src_address, uint8_t seq_num);
+bool diversity_range(struct diversity_instance * div, uint16_t idx, struct diversity_result * result);
+void diversity_combine(const struct uwb_rng_quality quality[2], const float tof[2],
+                       struct diversity_result * result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DIVERSITY_H_ */
@@ -0,0 +1,524 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file diversity.c
+ * @brief Dual radio diversity ranging
+ *
+ * @details The completed exchange is copied from the rng frame ring and the
+ * receive timestamps of the first radio replaced by those the second radio
+ * took of the same frames, found by source and sequence number. At a double
+ * sided responder these are the request and the second response, at the
+ * initiator the first response which appears in both frames. A single sided
+ * initiator received the response, a responder the request. Single sided
+ * timestamps are carried in the clock of the WCS master when UWB_WCS_ENABLED
+ * and are converted the same way.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <os/os.h>
+#include <sysinit/sysinit.h>
+#include <stats/stats.h>
+#include <uwb/uwb_mac.h>
+#include <uwb/uwb_ftypes.h>
+#if MYNEWT_VAL(CIR_ENABLED)
+#include <cir/cir.h>
+#endif
+#if MYNEWT_VAL(UWB_WCS_ENABLED)
+#include <uwb_wcs/uwb_wcs.h>
+#endif
+#include <diversity/diversity.h>
+
+#if MYNEWT_VAL(DIVERSITY_ENABLED)
+
+#if MYNEWT_VAL(DIVERSITY_STATS)
+STATS_NAME_START(diversity_stat_section)
+    STATS_NAME(diversity_stat_section, rx_frames)
+    STATS_NAME(diversity_stat_section, ranges)
+    STATS_NAME(diversity_stat_section, slave_miss)
+    STATS_NAME(diversity_stat_section, unsynced)
+    STATS_NAME(diversity_stat_section, disagree)
+    STATS_NAME(diversity_stat_section, combined)
+    STATS_NAME(diversity_stat_section, radio0)
+    STATS_NAME(diversity_stat_section, radio1)
+STATS_NAME_END(diversity_stat_section)
+#endif
+
+static bool complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static bool slave_rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static bool slave_rx_error_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+
+#if MYNEWT_VAL(DIVERSITY_CLI)
+int diversity_cli_register(void);
+#endif
+
+/**
+ * @fn diversity_init(struct diversity_instance * div, struct uwb_rng_instance * rng, struct uwb_dev * slave)
+ * @brief Allocate and initialise diversity ranging over an rng instance and
+ * a second radio sharing its clock.
+ *
+ * @param div   Pointer to struct diversity_instance, NULL to allocate.
+ * @param rng   Pointer to struct uwb_rng_instance of the radio ranging.
+ * @param slave Pointer to struct uwb_dev of the radio listening.
+ *
+ * @return struct diversity_instance *
+ */
+struct diversity_instance *
+diversity_init(struct diversity_instance * div, struct uwb_rng_instance * rng, struct uwb_dev * slave)
+{
+    assert(rng);
+    assert(slave && slave != rng->dev_inst);
+
+    if (div == NULL) {
+        div = (struct diversity_instance *) malloc(sizeof(struct diversity_instance));
+        assert(div);
+        memset(div, 0, sizeof(struct diversity_instance));
+        div->status.selfmalloc = 1;
+    }
+    div->dev_inst = rng->dev_inst;
+    div->slave = slave;
+    div->rng = rng;
+    div->idx = rng->idx;
+    div->offset = MYNEWT_VAL(DIVERSITY_OFFSET);
+    memset(div->rx, 0, sizeof(div->rx));
+    div->status.valid = 0;
+
+    div->cbs = (struct uwb_mac_interface){
+        .id = UWBEXT_DIVERSITY,
+        .inst_ptr = (void *) div,
+        .complete_cb = complete_cb
+    };
+    div->slave_cbs = (struct uwb_mac_interface){
+        .id = UWBEXT_DIVERSITY,
+        .inst_ptr = (void *) div,
+        .rx_complete_cb = slave_rx_complete_cb,
+        .rx_timeout_cb = slave_rx_error_cb,
+        .rx_error_cb = slave_rx_error_cb
+    };
+    if (!div->status.initialized) {
+        uwb_mac_append_interface(div->dev_inst, &div->cbs);
+        uwb_mac_append_interface(div->slave, &div->slave_cbs);
+#if MYNEWT_VAL(DIVERSITY_STATS)
+        int rc = stats_init(
+                    STATS_HDR(div->stat),
+                    STATS_SIZE_INIT_PARMS(div->stat, STATS_SIZE_32),
+                    STATS_NAME_INIT_PARMS(diversity_stat_section)
+            );
+        rc |= stats_register("diversity", STATS_HDR(div->stat));
+        assert(rc == 0);
+#endif
+    }
+    div->status.initialized = 1;
+    return div;
+}
+
+/**
+ * @fn diversity_free(struct diversity_instance * div)
+ * @brief Free the instance.
+ *
+ * @param div   Pointer to struct diversity_instance.
+ *
+ * @return void
+ */
+void
+diversity_free(struct diversity_instance * div)
+{
+    assert(div);
+    diversity_stop(div);
+    uwb_mac_remove_interface(div->dev_inst, div->cbs.id);
+    uwb_mac_remove_interface(div->slave, div->slave_cbs.id);
+    if (div->status.selfmalloc) {
+        free(div);
+    } else {
+        div->status.initialized = 0;
+    }
+}
+
+/**
+ * @fn diversity_get_instance(struct uwb_dev * inst)
+ * @brief Diversity instance of either radio.
+ *
+ * @param inst  Pointer to struct uwb_dev.
+ *
+ * @return struct diversity_instance *, NULL if the device has none
+ */
+struct diversity_instance *
+diversity_get_instance(struct uwb_dev * inst)
+{
+    return (struct diversity_instance *) uwb_mac_find_cb_inst_ptr(inst, UWBEXT_DIVERSITY);
+}
+
+/**
+ * @fn diversity_sync(struct diversity_instance * div)
+ * @brief Synchronise the radios to the shared clock, restarting the second
+ * radio's receiver if it was listening.
+ *
+ * @param div   Pointer to struct diversity_instance.
+ *
+ * @return struct uwb_dev_status of the second radio, ext_sync set on success
+ */
+struct uwb_dev_status
+diversity_sync(struct diversity_instance * div)
+{
+    struct uwb_dev_status status = uwb_sync_to_ext_clock(div->slave);
+
+    memset(div->rx, 0, sizeof(div->rx));
+    if (div->status.listening) {
+        diversity_listen(div);
+    }
+    return status;
+}
+
+/**
+ * @fn diversity_listen(struct diversity_instance * div)
+ * @brief Put the second radio in continuous receive, it is restarted after
+ * every frame, error and timeout until diversity_stop().
+ *
+ * @param div   Pointer to struct diversity_instance.
+ *
+ * @return struct uwb_dev_status
+ */
+struct uwb_dev_status
+diversity_listen(struct diversity_instance * div)
+{
+    div->status.listening = 1;
+    uwb_set_rx_timeout(div->slave, 0);
+    return uwb_start_rx(div->slave);
+}
+
+/**
+ * @fn diversity_stop(struct diversity_instance * div)
+ * @brief Take the second radio out of continuous receive.
+ *
+ * @param div   Pointer to struct diversity_instance.
+ *
+ * @return void
+ */
+void
+diversity_stop(struct diversity_instance * div)
+{
+    if (div->status.listening) {
+        div->status.listening = 0;
+        uwb_phy_forcetrxoff(div->slave);
+    }
+}
+
+/**
+ * @fn diversity_find_rx(struct diversity_instance * div, uint16_t src_address, uint8_t seq_num)
+ * @brief Most recent frame of a source and sequence number heard by the
+ * second radio.
+ *
+ * @param div           Pointer to struct diversity_instance.
+ * @param src_address   Source short address.
+ * @param seq_num       Sequence number.
+ *
+ * @return struct diversity_rx *, NULL if not heard
+ */
+struct diversity_rx *
+diversity_find_rx(struct diversity_instance * div, uint16_t src_address, uint8_t seq_num)
+{
+    for (uint16_t i = 1; i <= MYNEWT_VAL(DIVERSITY_RX_FRAMES); i++) {
+        struct diversity_rx * rx = &div->rx[(uint16_t)(div->rx_idx - i) % MYNEWT_VAL(DIVERSITY_RX_FRAMES)];
+        if (rx->src_address == src_address && rx->seq_num == seq_num) {
+            return rx;
+        }
+    }
+    return NULL;
+}
+
+/* Receive timestamp of the second radio in the clock the frames carry */
+static uint32_t
+slave_timestamp(struct diversity_instance * div, struct diversity_rx * rx, bool ss)
+{
+    uint64_t timestamp = rx->timestamp - div->offset;
+#if MYNEWT_VAL(UWB_WCS_ENABLED)
+    if (ss) {
+        timestamp = uwb_wcs_local_to_master(div->rng->ccp_inst->wcs, timestamp);
+    }
+#endif
+    return (uint32_t)(timestamp & 0xFFFFFFFFULL);
+}
+
+/**
+ * @fn diversity_combine(const struct uwb_rng_quality quality[2], const float tof[2], struct diversity_result * result)
+ * @brief Merge the times of flight of the two radios into the result.
+ * Exposed for feeding recorded or simulated ranges.
+ *
+ * @param quality   Quality of each radio's range.
+ * @param tof       Time of flight of each radio, dwt units, NAN for a miss.
+ * @param result    Result, peer, code and flags kept, the rest filled in.
+ *
+ * @return void
+ */
+void
+diversity_combine(const struct uwb_rng_quality quality[2], const float tof[2],
+                  struct diversity_result * result)
+{
+    float var[2];
+
+    for (uint8_t i = 0; i < 2; i++) {
+        result->ranges[i] = isfinite(tof[i]) ? uwb_rng_tof_to_meters(tof[i]) : NAN;
+        result->stdevs[i] = isfinite(result->ranges[i]) ? quality[i].stdev : NAN;
+        var[i] = result->stdevs[i] * result->stdevs[i];
+    }
+    result->radio = (isfinite(var[1]) && !(var[0] <= var[1])) ? 1 : 0;
+    result->tof = tof[result->radio];
+    result->range = result->ranges[result->radio];
+    result->stdev = result->stdevs[result->radio];
+    if (!isfinite(var[0]) || !isfinite(var[1])) {
+        return;
+    }
+
+    // Both radios see the same peer, ranges further apart than their spread allows are not averaged
+    float diff = result->ranges[1] - result->ranges[0];
+    if (diff * diff > MYNEWT_VAL(DIVERSITY_GATE) * MYNEWT_VAL(DIVERSITY_GATE) * (var[0] + var[1])) {
+        result->flags |= DIVERSITY_DISAGREE;
+        return;
+    }
+#if MYNEWT_VAL(DIVERSITY_COMBINE)
+    if (var[0] > 0 && var[1] > 0) {
+        float w = var[0] / (var[0] + var[1]);
+        result->tof = tof[0] + w * (tof[1] - tof[0]);
+        result->range = result->ranges[0] + w * diff;
+        result->stdev = sqrtf(var[0] * var[1] / (var[0] + var[1]));
+        result->flags |= DIVERSITY_COMBINED;
+    }
+#endif
+}
+
+/**
+ * @fn diversity_range(struct diversity_instance * div, uint16_t idx, struct diversity_result * result)
+ * @brief Range the exchange completed at a ring index on both radios.
+ *
+ * @param div       Pointer to struct diversity_instance.
+ * @param idx       Ring index of the final frame.
+ * @param result    Result out.
+ *
+ * @return true if idx holds a completed exchange
+ */
+bool
+diversity_range(struct diversity_instance * div, uint16_t idx, struct diversity_result * result)
+{
+    struct uwb_dev * inst = div->dev_inst;
+    struct uwb_rng_instance * rng = div->rng;
+    twr_frame_t first = *rng->frames[(uint16_t)(idx - 1) % rng->nframes];
+    twr_frame_t frame = *rng->frames[idx % rng->nframes];
+    struct uwb_rng_quality quality[2];
+    struct diversity_rx * rx_a = NULL, * rx_b = NULL, * rx_last;
+    float tof[2] = {NAN, NAN};
+    bool ss, sender;
+
+    switch(frame.code){
+        case DWT_SS_TWR_FINAL:
+        case DWT_SS_TWR_EXT_FINAL:
+            ss = true;
+            break;
+        case DWT_DS_TWR_FINAL:
+        case DWT_DS_TWR_EXT_FINAL:
+            ss = false;
+            break;
+        default:
+            return false;
+    }
+    // The final frame is sent by the single sided initiator and the double sided responder
+    sender = (frame.src_address == inst->my_short_address);
+    *result = (struct diversity_result){
+        .peer = sender ? frame.dst_address : frame.src_address,
+        .code = frame.code,
+        .pdoa = NAN
+    };
+
+    tof[0] = uwb_rng_twr_to_tof(rng, idx);
+    uwb_rng_get_quality(rng, idx, &quality[0]);
+    quality[1] = quality[0];
+
+    if (!div->slave->status.ext_sync) {
+        result->flags |= DIVERSITY_UNSYNCED;
+        DIVERSITY_STATS_INC(unsynced);
+    } else if (ss) {
+        rx_a = diversity_find_rx(div, result->peer, frame.seq_num);
+        if (rx_a && sender) {
+            frame.response_timestamp = slave_timestamp(div, rx_a, true);
+        } else if (rx_a) {
+            frame.reception_timestamp = slave_timestamp(div, rx_a, true);
+        }
+        rx_b = rx_a;
+    } else if (sender) {
+        rx_a = diversity_find_rx(div, result->peer, first.seq_num);
+        rx_b = diversity_find_rx(div, result->peer, frame.seq_num);
+        if (rx_a && rx_b) {
+            first.reception_timestamp = slave_timestamp(div, rx_a, false);
+            frame.response_timestamp = slave_timestamp(div, rx_b, false);
+        }
+    } else {
+        rx_a = rx_b = diversity_find_rx(div, result->peer, first.seq_num);
+        if (rx_a) {
+            first.response_timestamp = frame.reception_timestamp = slave_timestamp(div, rx_a, false);
+        }
+    }
+
+    if (rx_a && rx_b) {
+        tof[1] = uwb_rng_twr_to_tof_frames(inst, &first, &frame);
+        // Diagnostics of the last frame the peer sent, the skew and residual are those of the exchange
+        rx_last = diversity_find_rx(div, result->peer, frame.seq_num);
+        if (rx_last == NULL) {
+            rx_last = rx_b;
+        }
+        uwb_rng_quality_calc(div->slave, (div->slave->config.rxdiag_enable && rx_last->diag.rxd_len) ?
+                             &rx_last->diag : NULL, &quality[1]);
+#if MYNEWT_VAL(CIR_ENABLED)
+        // Both accumulators hold the last frame the peer sent if the slave's last frame is that one
+        struct diversity_rx * rx_prev = &div->rx[(uint16_t)(div->rx_idx - 1) % MYNEWT_VAL(DIVERSITY_RX_FRAMES)];
+        if (inst->cir && div->slave->cir && inst->cir->status.valid && div->slave->cir->status.valid &&
+            rx_prev->src_address == result->peer && rx_prev->seq_num == frame.seq_num) {
+            result->pdoa = cir_get_pdoa(inst->cir, div->slave->cir);
+        }
+#endif
+    } else if (!(result->flags & DIVERSITY_UNSYNCED)) {
+        result->flags |= DIVERSITY_SLAVE_MISS;
+        DIVERSITY_STATS_INC(slave_miss);
+    }
+
+    diversity_combine(quality, tof, result);
+    DIVERSITY_STATS_INC(ranges);
+    if (result->flags & DIVERSITY_DISAGREE) DIVERSITY_STATS_INC(disagree);
+    if (result->flags & DIVERSITY_COMBINED) {
+        DIVERSITY_STATS_INC(combined);
+    } else if (result->radio) {
+        DIVERSITY_STATS_INC(radio1);
+    } else {
+        DIVERSITY_STATS_INC(radio0);
+    }
+    return true;
+}
+
+/**
+ * @fn complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+ * @brief Range the exchange just completed on both radios, never consumes
+ * the event.
+ *
+ * @return false
+ */
+static bool
+complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct diversity_instance * div = (struct diversity_instance *) cbs->inst_ptr;
+
+    // Completions of other services leave the ring where it was
+    if (div->idx == div->rng->idx) {
+        return false;
+    }
+    div->idx = div->rng->idx;
+    if (!diversity_range(div, div->idx, &div->last)) {
+        return false;
+    }
+    div->status.valid = 1;
+#if MYNEWT_VAL(DIVERSITY_VERBOSE)
+    printf("{\"utime\": %lu,\"msg\": \"diversity\",\"addr\": \"%X\",\"flags\": \"%X\",\"range\": [%d,%d,%d],\"pdoa\": %d}\n",
+           os_cputime_ticks_to_usecs(os_cputime_get32()), div->last.peer, div->last.flags,
+           (int)(div->last.ranges[0] * 1000), (int)(div->last.ranges[1] * 1000), (int)(div->last.range * 1000),
+           (int)(div->last.pdoa * 1000));
+#endif
+    return false;
+}
+
+/**
+ * @fn slave_rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+ * @brief Keep the timestamp and diagnostics of ranging frames addressed to
+ * the first radio and listen on.
+ *
+ * @return true if the frame was kept
+ */
+static bool
+slave_rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct diversity_instance * div = (struct diversity_instance *) cbs->inst_ptr;
+    ieee_rng_request_frame_t * request = (ieee_rng_request_frame_t *) inst->rxbuf;
+
+    if (inst->fctrl != FCNTL_IEEE_RANGE_16 || inst->frame_len < sizeof(ieee_rng_request_frame_t)) {
+        return false;
+    }
+    switch(request->code){
+        case DWT_SS_TWR ... DWT_DS_TWR_EXT_END:
+            break;
+        default:
+            return false;
+    }
+    if (request->dst_address != div->dev_inst->my_short_address) {
+        return false;
+    }
+
+    struct diversity_rx * rx = &div->rx[div->rx_idx++ % MYNEWT_VAL(DIVERSITY_RX_FRAMES)];
+    rx->src_address = request->src_address;
+    rx->seq_num = request->seq_num;
+    rx->code = request->code;
+    rx->timestamp = inst->rxtimestamp;
+    rx->carrier_integrator = inst->carrier_integrator;
+    rx->diag.rxd_len = 0;
+    if (inst->config.rxdiag_enable && inst->rxdiag->rxd_len <= sizeof(rx->diag_storage)) {
+        memcpy(rx->diag_storage, inst->rxdiag, inst->rxdiag->rxd_len);
+    }
+    DIVERSITY_STATS_INC(rx_frames);
+
+    if (div->status.listening) {
+        uwb_start_rx(inst);
+    }
+    return true;
+}
+
+/**
+ * @fn slave_rx_error_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+ * @brief Restart the receiver of the second radio while listening.
+ *
+ * @return false
+ */
+static bool
+slave_rx_error_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct diversity_instance * div = (struct diversity_instance *) cbs->inst_ptr;
+
+    if (div->status.listening) {
+        uwb_start_rx(inst);
+    }
+    return false;
+}
+
+void
+diversity_pkg_init(void)
+{
+#if MYNEWT_VAL(DIVERSITY_VERBOSE)
+    printf("{\"utime\": %lu,\"msg\": \"diversity_pkg_init\"}\n", os_cputime_ticks_to_usecs(os_cputime_get32()));
+#endif
+#if MYNEWT_VAL(UWB_DEVICE_0) && MYNEWT_VAL(UWB_DEVICE_1)
+    struct uwb_rng_instance * rng = (struct uwb_rng_instance *)
+        uwb_mac_find_cb_inst_ptr(uwb_dev_idx_lookup(0), UWBEXT_RNG);
+    SYSINIT_PANIC_ASSERT(rng);
+    diversity_init(NULL, rng, uwb_dev_idx_lookup(1));
+#endif
+#if MYNEWT_VAL(DIVERSITY_CLI)
+    int rc = diversity_cli_register();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+}
+
+#endif /* MYNEWT_VAL(DIVERSITY_ENABLED) */
@@ -0,0 +1,130 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <os/os.h>
+#include <syscfg/syscfg.h>
+
+#if MYNEWT_VAL(DIVERSITY_ENABLED) && MYNEWT_VAL(DIVERSITY_CLI)
+
+#include <string.h>
+#include <stdlib.h>
+
+#include <shell/shell.h>
+#include <console/console.h>
+
+#include <uwb/uwb.h>
+#include "diversity/diversity.h"
+
+static int diversity_cli_cmd(int argc, char **argv);
+
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+const struct shell_param cmd_div_param[] = {
+    {"last", "result of the last range"},
+    {"sync", "synchronise the radios to the shared clock"},
+    {"listen", "second radio in continuous receive"},
+    {"stop", "second radio out of continuous receive"},
+    {"offset", "[<dwt>] second minus first radio timestamp of a frame"},
+    {"rx", "frames heard by the second radio"},
+    {NULL,NULL},
+};
+
+const struct shell_cmd_help cmd_div_help = {
+	"div", "<cmd>", cmd_div_param
+};
+#endif
+
+static struct shell_cmd shell_div_cmd = {
+    .sc_cmd = "div",
+    .sc_cmd_func = diversity_cli_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+    .help = &cmd_div_help
+#endif
+};
+
+static void
+diversity_cli_last(struct diversity_instance * div)
+{
+    struct diversity_result * r = &div->last;
+
+    if (!div->status.valid) {
+        console_printf("No range\n");
+        return;
+    }
+    console_printf("{\"addr\": \"%x\", \"code\": \"%x\", \"flags\": \"%x\", \"radio\": %d, \"range_mm\": %d, "
+                   "\"stdev_mm\": %d, \"ranges_mm\": [%d, %d], \"stdevs_mm\": [%d, %d], \"pdoa_mrad\": %d}\n",
+                   r->peer, r->code, r->flags, r->radio, (int)(r->range * 1000), (int)(r->stdev * 1000),
+                   (int)(r->ranges[0] * 1000), (int)(r->ranges[1] * 1000),
+                   (int)(r->stdevs[0] * 1000), (int)(r->stdevs[1] * 1000), (int)(r->pdoa * 1000));
+}
+
+static void
+diversity_cli_rx(struct diversity_instance * div)
+{
+    console_printf("#src, seq, code, timestamp\n");
+    for (int i = 0; i < MYNEWT_VAL(DIVERSITY_RX_FRAMES); i++) {
+        struct diversity_rx * rx = &div->rx[i];
+        if (rx->src_address) {
+            console_printf("%4x, %3d, %4x, %010llx\n", rx->src_address, rx->seq_num, rx->code,
+                           (unsigned long long)rx->timestamp);
+        }
+    }
+}
+
+static int
+diversity_cli_cmd(int argc, char **argv)
+{
+    struct diversity_instance * div = diversity_get_instance(uwb_dev_idx_lookup(0));
+
+    if (argc < 2) {
+        return 0;
+    }
+    if (div == NULL) {
+        console_printf("No diversity instance\n");
+        return 0;
+    }
+
+    if (!strcmp(argv[1], "last")) {
+        diversity_cli_last(div);
+    } else if (!strcmp(argv[1], "sync")) {
+        console_printf("{\"ext_sync\": %d}\n", diversity_sync(div).ext_sync);
+    } else if (!strcmp(argv[1], "listen")) {
+        if (diversity_listen(div).start_rx_error) {
+            console_printf("start_rx_error\n");
+        }
+    } else if (!strcmp(argv[1], "stop")) {
+        diversity_stop(div);
+    } else if (!strcmp(argv[1], "offset")) {
+        if (argc > 2) {
+            div->offset = strtol(argv[2], NULL, 0);
+        }
+        console_printf("{\"offset\": %ld}\n", (long)div->offset);
+    } else if (!strcmp(argv[1], "rx")) {
+        diversity_cli_rx(div);
+    } else {
+        console_printf("Unknown cmd\n");
+    }
+    return 0;
+}
+
+int
+diversity_cli_register(void)
+{
+    return shell_cmd_register(&shell_div_cmd);
+}
+#endif /* MYNEWT_VAL(DIVERSITY_ENABLED) && MYNEWT_VAL(DIVERSITY_CLI) */
@@ -0,0 +1,211 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "diversity_test.h"
+
+//! Turnaround of both sides, dwt units, 200 usec
+#define REPLY (200e-6 * 499.2e6 * 128)
+
+static struct uwb_dev g_dev[2];
+static twr_frame_t g_frames[DIVERSITY_TEST_NFRAMES];
+static struct uwb_rng_instance * g_rng;
+static struct diversity_instance g_div;
+static uint8_t g_seq;
+
+static float
+radio_calc_clock_offset_ratio(struct uwb_dev * dev, int32_t integrator_val, uwb_cr_types_t type)
+{
+    return 0;
+}
+
+static struct uwb_dev_status
+radio_sync_to_ext_clock(struct uwb_dev * dev)
+{
+    dev->status.ext_sync = 1;
+    return dev->status;
+}
+
+static const struct uwb_driver_funcs g_diversity_test_funcs = {
+    .uf_calc_clock_offset_ratio = radio_calc_clock_offset_ratio,
+};
+
+/** Meters to time of flight in dwt units */
+float
+diversity_test_m2tof(float m)
+{
+    return m / uwb_rng_tof_to_meters(1.0f);
+}
+
+/** Both radios synchronised, no frames heard, DIVERSITY_OFFSET 1000 */
+struct diversity_instance *
+diversity_test_setup(void)
+{
+    struct diversity_instance * div = &g_div;
+
+    if (g_rng == NULL) {
+        g_rng = (struct uwb_rng_instance *)calloc(1, sizeof(struct uwb_rng_instance)
+                                                  + DIVERSITY_TEST_NFRAMES * sizeof(twr_frame_t *));
+        assert(g_rng);
+        for (int i = 0; i < 2; i++) {
+            g_dev[i].uw_funcs = &g_diversity_test_funcs;
+            g_dev[i].uw_dyn_funcs.uf_sync_to_ext_clock = radio_sync_to_ext_clock;
+            g_dev[i].my_short_address = DIVERSITY_TEST_ADDR;
+        }
+        g_rng->dev_inst = &g_dev[0];
+        g_rng->nframes = DIVERSITY_TEST_NFRAMES;
+        for (int i = 0; i < DIVERSITY_TEST_NFRAMES; i++)
+            g_rng->frames[i] = &g_frames[i];
+    }
+    memset(g_frames, 0, sizeof(g_frames));
+    g_rng->idx = 0;
+    g_rng->quality_idx = 0xFFFF;
+    diversity_init(div, g_rng, &g_dev[1]);
+    diversity_sync(div);
+    div->offset = 1000;
+    return div;
+}
+
+/* Frame from the peer as the second radio receives it at timestamp, in the first radio's clock */
+static void
+slave_rx(struct diversity_instance * div, uint8_t seq, uint16_t code, double timestamp)
+{
+    struct uwb_dev * inst = div->slave;
+    ieee_rng_request_frame_t * frame = (ieee_rng_request_frame_t *)inst->rxbuf;
+
+    frame->fctrl = FCNTL_IEEE_RANGE_16;
+    frame->seq_num = seq;
+    frame->PANID = 0xDECA;
+    frame->dst_address = DIVERSITY_TEST_ADDR;
+    frame->src_address = DIVERSITY_TEST_PEER;
+    frame->code = code;
+    inst->fctrl = FCNTL_IEEE_RANGE_16;
+    inst->frame_len = sizeof(ieee_rng_request_frame_t);
+    inst->rxtimestamp = (uint64_t)timestamp + div->offset;
+    TEST_ASSERT(div->slave_cbs.rx_complete_cb(inst, &div->slave_cbs));
+}
+
+/**
+ * Write the next exchange with the peer at d0 m from the first radio and d1 m
+ * from the second to the rng ring, the first radio transmitting and
+ * receiving. The frames of the peer the second radio receives, as selected
+ * by heard, go through its rx_complete_cb. Returns the ring index of the
+ * final frame.
+ */
+uint16_t
+diversity_test_exchange(struct diversity_instance * div, diversity_test_role_t role,
+                        float d0, float d1, uint8_t heard)
+{
+    struct uwb_rng_instance * rng = div->rng;
+    uint16_t idx = rng->idx + 2;
+    twr_frame_t * first = rng->frames[(uint16_t)(idx - 1) % rng->nframes];
+    twr_frame_t * frame = rng->frames[idx % rng->nframes];
+    double tof0 = diversity_test_m2tof(d0), tof1 = diversity_test_m2tof(d1);
+    double t0 = 0x10000000 + (double)idx * 0x1000000;
+    double rx0, rx1;
+    uint8_t seq = g_seq;
+
+    g_seq += 2;
+    memset(first, 0, sizeof(*first));
+    memset(frame, 0, sizeof(*frame));
+    first->fctrl = frame->fctrl = FCNTL_IEEE_RANGE_16;
+    first->seq_num = seq;
+    frame->seq_num = seq + 1;
+    first->src_address = DIVERSITY_TEST_PEER;
+    first->dst_address = DIVERSITY_TEST_ADDR;
+    frame->src_address = DIVERSITY_TEST_PEER;
+    frame->dst_address = DIVERSITY_TEST_ADDR;
+
+    switch (role) {
+    case DIVERSITY_TEST_DS_RESPONDER:
+        // Request received, first response sent and received, final received
+        frame->src_address = DIVERSITY_TEST_ADDR;
+        frame->dst_address = DIVERSITY_TEST_PEER;
+        first->code = DWT_DS_TWR_T1;
+        frame->code = DWT_DS_TWR_FINAL;
+        first->request_timestamp = (uint32_t)t0;
+        first->reception_timestamp = (uint32_t)(t0 + tof0);
+        first->transmission_timestamp = (uint32_t)(t0 + tof0 + REPLY);
+        first->response_timestamp = (uint32_t)(t0 + 2 * tof0 + REPLY);
+        frame->request_timestamp = first->transmission_timestamp;
+        frame->reception_timestamp = first->response_timestamp;
+        frame->transmission_timestamp = (uint32_t)(t0 + 2 * tof0 + 2 * REPLY);
+        frame->response_timestamp = (uint32_t)(t0 + 3 * tof0 + 2 * REPLY);
+        if (heard & DIVERSITY_TEST_HEARD_FIRST)
+            slave_rx(div, first->seq_num, DWT_DS_TWR, t0 + tof1);
+        if (heard & DIVERSITY_TEST_HEARD_LAST)
+            slave_rx(div, frame->seq_num, DWT_DS_TWR_T2, t0 + 2 * tof0 + 2 * REPLY + tof1);
+        break;
+    case DIVERSITY_TEST_DS_INITIATOR:
+        first->code = DWT_DS_TWR_T1;
+        frame->code = DWT_DS_TWR_FINAL;
+        first->request_timestamp = (uint32_t)t0;
+        first->reception_timestamp = (uint32_t)(t0 + tof0);
+        first->transmission_timestamp = (uint32_t)(t0 + tof0 + REPLY);
+        first->response_timestamp = (uint32_t)(t0 + 2 * tof0 + REPLY);
+        frame->request_timestamp = first->transmission_timestamp;
+        frame->reception_timestamp = first->response_timestamp;
+        frame->transmission_timestamp = (uint32_t)(t0 + 2 * tof0 + 2 * REPLY);
+        frame->response_timestamp = (uint32_t)(t0 + 3 * tof0 + 2 * REPLY);
+        if (heard & DIVERSITY_TEST_HEARD_FIRST)
+            slave_rx(div, first->seq_num, DWT_DS_TWR_T1, t0 + tof0 + REPLY + tof1);
+        if (heard & DIVERSITY_TEST_HEARD_LAST)
+            slave_rx(div, frame->seq_num, DWT_DS_TWR_FINAL, t0 + 3 * tof0 + 3 * REPLY + tof1);
+        break;
+    case DIVERSITY_TEST_SS_INITIATOR:
+    case DIVERSITY_TEST_SS_RESPONDER:
+        // Request and response, the final frame carries all four timestamps
+        first->code = DWT_SS_TWR;
+        frame->code = DWT_SS_TWR_FINAL;
+        frame->request_timestamp = (uint32_t)t0;
+        frame->reception_timestamp = (uint32_t)(t0 + tof0);
+        frame->transmission_timestamp = (uint32_t)(t0 + tof0 + REPLY);
+        frame->response_timestamp = (uint32_t)(t0 + 2 * tof0 + REPLY);
+        if (role == DIVERSITY_TEST_SS_INITIATOR) {
+            frame->src_address = DIVERSITY_TEST_ADDR;
+            frame->dst_address = DIVERSITY_TEST_PEER;
+            rx0 = t0 + tof0 + REPLY;
+        } else {
+            rx0 = t0;
+        }
+        rx1 = rx0 + tof1;
+        if (heard & DIVERSITY_TEST_HEARD_LAST)
+            slave_rx(div, frame->seq_num, DWT_SS_TWR_T1, rx1);
+        break;
+    default:
+        assert(0);
+    }
+    rng->idx = idx;
+    return idx;
+}
+
+/** Quality of the first radio's range at idx, without diagnostics the second radio's is RNG_QUALITY_NODIAG */
+void
+diversity_test_quality(struct diversity_instance * div, uint16_t idx, float stdev)
+{
+    struct uwb_rng_instance * rng = div->rng;
+
+    rng->quality = (struct uwb_rng_quality){
+        .stdev = stdev,
+        .snr = NAN,
+        .los = NAN,
+        .skew = NAN,
+        .residual = NAN
+    };
+    rng->quality_idx = idx;
+}
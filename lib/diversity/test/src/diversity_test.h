@@ -0,0 +1,72 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _DIVERSITY_TEST_H
+#define _DIVERSITY_TEST_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "testutil/testutil.h"
+
+#include "uwb/uwb_ftypes.h"
+#include "diversity/diversity.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Address of the first radio
+#define DIVERSITY_TEST_ADDR (0x1111)
+//! Address of the peer ranged with
+#define DIVERSITY_TEST_PEER (0x2222)
+//! Frames in the rng ring
+#define DIVERSITY_TEST_NFRAMES (4)
+
+//! Side of the exchange the node is on
+typedef enum _diversity_test_role_t{
+    DIVERSITY_TEST_DS_RESPONDER = 0,   //!< Double sided, sends the final frame
+    DIVERSITY_TEST_DS_INITIATOR,       //!< Double sided, receives the final frame
+    DIVERSITY_TEST_SS_INITIATOR,       //!< Single sided, sends the final frame
+    DIVERSITY_TEST_SS_RESPONDER,       //!< Single sided, receives the final frame
+    DIVERSITY_TEST_ROLES
+}diversity_test_role_t;
+
+//! Frames of an exchange the second radio hears
+#define DIVERSITY_TEST_HEARD_FIRST (0x01)
+#define DIVERSITY_TEST_HEARD_LAST  (0x02)
+#define DIVERSITY_TEST_HEARD_BOTH  (0x03)
+
+struct diversity_instance * diversity_test_setup(void);
+float diversity_test_m2tof(float m);
+uint16_t diversity_test_exchange(struct diversity_instance * div, diversity_test_role_t role,
+                                 float d0, float d1, uint8_t heard);
+void diversity_test_quality(struct diversity_instance * div, uint16_t idx, float stdev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DIVERSITY_TEST_H */
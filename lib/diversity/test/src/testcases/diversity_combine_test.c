@@ -0,0 +1,100 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "diversity_test.h"
+
+static void
+combine(float r0, float s0, float r1, float s1, struct diversity_result * result)
+{
+    struct uwb_rng_quality quality[2] = {{.stdev = s0}, {.stdev = s1}};
+    float tof[2] = {diversity_test_m2tof(r0), diversity_test_m2tof(r1)};
+
+    memset(result, 0, sizeof(*result));
+    diversity_combine(quality, tof, result);
+}
+
+/**
+ * Ranges that agree are averaged with inverse variance weights, the
+ * standard deviation of the mean reported; past DIVERSITY_GATE standard
+ * deviations of their difference the range of lower standard deviation
+ * is reported alone.
+ */
+TEST_CASE(diversity_combine_test)
+{
+    struct diversity_result result;
+    struct uwb_rng_quality quality[2] = {{.stdev = 0.1f}, {.stdev = 0.1f}};
+    float tof[2];
+    float gate = MYNEWT_VAL(DIVERSITY_GATE) * sqrtf(0.1f * 0.1f + 0.2f * 0.2f);
+
+    /* Weights 0.8 and 0.2 */
+    combine(10.0f, 0.1f, 10.1f, 0.2f, &result);
+    TEST_ASSERT(result.radio == 0);
+    TEST_ASSERT(fabsf(result.ranges[1] - 10.1f) < 1e-4f);
+#if MYNEWT_VAL(DIVERSITY_COMBINE)
+    TEST_ASSERT(result.flags == DIVERSITY_COMBINED, "%x", result.flags);
+    TEST_ASSERT(fabsf(result.range - 10.02f) < 1e-4f, "%f", result.range);
+    TEST_ASSERT(fabsf(result.stdev - sqrtf(0.01f * 0.04f / 0.05f)) < 1e-5f, "%f", result.stdev);
+    TEST_ASSERT(fabsf(uwb_rng_tof_to_meters(result.tof) - result.range) < 1e-4f);
+#else
+    TEST_ASSERT(result.flags == 0 && result.range == result.ranges[0]);
+#endif
+
+    /* The better radio is the second */
+    combine(10.0f, 0.3f, 10.2f, 0.1f, &result);
+    TEST_ASSERT(result.radio == 1);
+#if MYNEWT_VAL(DIVERSITY_COMBINE)
+    TEST_ASSERT(fabsf(result.range - 10.18f) < 1e-4f, "%f", result.range);
+#endif
+
+    /* Either side of the gate */
+    combine(10.0f, 0.1f, 10.0f + gate * 0.99f, 0.2f, &result);
+    TEST_ASSERT(!(result.flags & DIVERSITY_DISAGREE));
+    combine(10.0f, 0.1f, 10.0f + gate * 1.01f, 0.2f, &result);
+    TEST_ASSERT(result.flags == DIVERSITY_DISAGREE, "%x", result.flags);
+    TEST_ASSERT(result.radio == 0 && result.range == result.ranges[0] && result.stdev == 0.1f);
+    combine(10.0f + gate * 1.01f, 0.2f, 10.0f, 0.1f, &result);
+    TEST_ASSERT(result.flags == DIVERSITY_DISAGREE && result.radio == 1);
+    TEST_ASSERT(fabsf(result.range - 10.0f) < 1e-4f && result.stdev == 0.1f);
+    combine(10.0f, 0.1f, 10.0f - gate * 1.01f, 0.2f, &result);
+    TEST_ASSERT(result.flags == DIVERSITY_DISAGREE && result.radio == 0);
+
+    /* Equal, the first radio */
+    combine(10.0f, 0.1f, 10.1f, 0.1f, &result);
+    TEST_ASSERT(result.radio == 0);
+#if MYNEWT_VAL(DIVERSITY_COMBINE)
+    TEST_ASSERT(fabsf(result.range - 10.05f) < 1e-4f && fabsf(result.stdev - 0.1f / sqrtf(2)) < 1e-5f);
+#endif
+
+    /* Either radio missing, flags of the caller kept */
+    tof[0] = diversity_test_m2tof(10.0f);
+    tof[1] = NAN;
+    memset(&result, 0, sizeof(result));
+    result.flags = DIVERSITY_SLAVE_MISS;
+    diversity_combine(quality, tof, &result);
+    TEST_ASSERT(result.flags == DIVERSITY_SLAVE_MISS && result.radio == 0);
+    TEST_ASSERT(fabsf(result.range - 10.0f) < 1e-4f && isnan(result.stdevs[1]));
+    tof[0] = NAN;
+    tof[1] = diversity_test_m2tof(10.0f);
+    memset(&result, 0, sizeof(result));
+    diversity_combine(quality, tof, &result);
+    TEST_ASSERT(result.flags == 0 && result.radio == 1 && fabsf(result.range - 10.0f) < 1e-4f);
+
+    /* A zero standard deviation is taken as is, not weighted */
+    combine(10.0f, 0.0f, 10.01f, 0.1f, &result);
+    TEST_ASSERT(result.flags == 0 && result.radio == 0 && result.range == result.ranges[0]);
+}
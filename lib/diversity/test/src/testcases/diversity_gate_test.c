@@ -0,0 +1,78 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "diversity_test.h"
+
+/**
+ * End to end through diversity_range and the mac complete callback: both
+ * radios' ranges combined while they agree, the better one reported when
+ * they do not, and the result left in diversity_instance::last.
+ */
+TEST_CASE(diversity_gate_test)
+{
+    struct diversity_instance * div = diversity_test_setup();
+    struct diversity_result result;
+    float nodiag = MYNEWT_VAL(RNG_QUALITY_NODIAG);
+    float gate = MYNEWT_VAL(DIVERSITY_GATE) * sqrtf(0.05f * 0.05f + nodiag * nodiag);
+    float w = 0.05f * 0.05f / (0.05f * 0.05f + nodiag * nodiag);
+    uint16_t idx;
+#if MYNEWT_VAL(DIVERSITY_STATS)
+    uint32_t disagree = div->stat.disagree, radio1 = div->stat.radio1;
+#endif
+
+    for (int role = 0; role < DIVERSITY_TEST_ROLES; role++) {
+        /* Radio 1 range 5 + gate * 0.9 agrees */
+        idx = diversity_test_exchange(div, role, 5.0f, 5.0f + 2 * gate * 0.9f, DIVERSITY_TEST_HEARD_BOTH);
+        diversity_test_quality(div, idx, 0.05f);
+        div->status.valid = 0;
+        TEST_ASSERT(!div->cbs.complete_cb(div->dev_inst, &div->cbs));
+        TEST_ASSERT_FATAL(div->status.valid && div->idx == idx);
+        result = div->last;
+#if MYNEWT_VAL(DIVERSITY_COMBINE)
+        TEST_ASSERT(result.flags == DIVERSITY_COMBINED, "%d %x", role, result.flags);
+        TEST_ASSERT(fabsf(result.range - (5.0f + w * gate * 0.9f)) < 0.01f, "%d %f", role, result.range);
+#else
+        TEST_ASSERT(result.flags == 0 && result.range == result.ranges[0]);
+#endif
+
+        /* 1.1 gates away, radio 0 has the lower standard deviation */
+        idx = diversity_test_exchange(div, role, 5.0f, 5.0f + 2 * gate * 1.1f, DIVERSITY_TEST_HEARD_BOTH);
+        diversity_test_quality(div, idx, 0.05f);
+        TEST_ASSERT_FATAL(diversity_range(div, idx, &result));
+        TEST_ASSERT(result.flags == DIVERSITY_DISAGREE, "%d %x", role, result.flags);
+        TEST_ASSERT(result.radio == 0 && fabsf(result.range - 5.0f) < 0.01f);
+
+        /* Radio 0 obstructed, radio 1 taken alone */
+        idx = diversity_test_exchange(div, role, 8.0f, 2.0f, DIVERSITY_TEST_HEARD_BOTH);
+        diversity_test_quality(div, idx, 0.5f);
+        TEST_ASSERT_FATAL(diversity_range(div, idx, &result));
+        TEST_ASSERT(result.flags == DIVERSITY_DISAGREE, "%d %x", role, result.flags);
+        TEST_ASSERT(result.radio == 1 && fabsf(result.range - 5.0f) < 0.01f && result.stdev == nodiag);
+        TEST_ASSERT(fabsf(uwb_rng_tof_to_meters(result.tof) - result.range) < 1e-4f);
+    }
+
+    /* Another service's completion leaves the ring index, and last, alone */
+    TEST_ASSERT(!div->cbs.complete_cb(div->dev_inst, &div->cbs));
+    div->status.valid = 0;
+    TEST_ASSERT(!div->cbs.complete_cb(div->dev_inst, &div->cbs));
+    TEST_ASSERT(!div->status.valid);
+#if MYNEWT_VAL(DIVERSITY_STATS)
+    TEST_ASSERT(div->stat.disagree - disagree == 2 * DIVERSITY_TEST_ROLES + 1);
+    TEST_ASSERT(div->stat.radio1 - radio1 == DIVERSITY_TEST_ROLES + 1);
+#endif
+}
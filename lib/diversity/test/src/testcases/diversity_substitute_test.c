@@ -0,0 +1,88 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "diversity_test.h"
+
+/**
+ * The second radio's timestamps of the peer's frames replace those of the
+ * first in a copy of the exchange, in each role, giving a time of flight
+ * over the peer to second radio path for the receptions. The ring is left
+ * as it was; a frame the second radio missed, or one of another exchange,
+ * leaves the first radio's range alone.
+ */
+TEST_CASE(diversity_substitute_test)
+{
+    struct diversity_instance * div = diversity_test_setup();
+    struct diversity_result result;
+    twr_frame_t ring[DIVERSITY_TEST_NFRAMES];
+    uint16_t idx;
+#if MYNEWT_VAL(DIVERSITY_STATS)
+    uint32_t slave_miss = div->stat.slave_miss, unsynced = div->stat.unsynced;
+#endif
+
+    for (int role = 0; role < DIVERSITY_TEST_ROLES; role++) {
+        idx = diversity_test_exchange(div, role, 5.0f, 5.6f, DIVERSITY_TEST_HEARD_BOTH);
+        diversity_test_quality(div, idx, 0.05f);
+        for (int i = 0; i < DIVERSITY_TEST_NFRAMES; i++)
+            ring[i] = *div->rng->frames[i];
+        TEST_ASSERT_FATAL(diversity_range(div, idx, &result));
+        TEST_ASSERT(memcmp(ring, div->rng->frames[0], sizeof(ring)) == 0);
+        TEST_ASSERT(result.peer == DIVERSITY_TEST_PEER, "%d", role);
+        TEST_ASSERT(!(result.flags & (DIVERSITY_SLAVE_MISS | DIVERSITY_UNSYNCED)), "%d", role);
+        TEST_ASSERT(fabsf(result.ranges[0] - 5.0f) < 0.01f, "%d %f", role, result.ranges[0]);
+        // Transmissions are the first radio's, receptions the second's
+        TEST_ASSERT(fabsf(result.ranges[1] - 5.3f) < 0.01f, "%d %f", role, result.ranges[1]);
+        TEST_ASSERT(fabsf(result.stdevs[1] - MYNEWT_VAL(RNG_QUALITY_NODIAG)) < 1e-6f);
+    }
+
+    /* Missed frames */
+    for (int role = 0; role < DIVERSITY_TEST_ROLES; role++) {
+        uint8_t heard = (role == DIVERSITY_TEST_DS_RESPONDER) ? DIVERSITY_TEST_HEARD_FIRST :
+                        (role == DIVERSITY_TEST_DS_INITIATOR) ? DIVERSITY_TEST_HEARD_LAST : 0;
+        idx = diversity_test_exchange(div, role, 5.0f, 5.6f, heard);
+        diversity_test_quality(div, idx, 0.05f);
+        TEST_ASSERT_FATAL(diversity_range(div, idx, &result));
+        TEST_ASSERT(result.flags == DIVERSITY_SLAVE_MISS, "%d %x", role, result.flags);
+        TEST_ASSERT(isnan(result.ranges[1]) && isnan(result.stdevs[1]));
+        TEST_ASSERT(result.radio == 0 && result.range == result.ranges[0]);
+        TEST_ASSERT(fabsf(result.range - 5.0f) < 0.01f);
+    }
+
+    /* The second radio's timestamps are taken less the offset of its counter */
+    idx = diversity_test_exchange(div, DIVERSITY_TEST_SS_INITIATOR, 5.0f, 5.6f, DIVERSITY_TEST_HEARD_BOTH);
+    div->offset -= 213;
+    TEST_ASSERT_FATAL(diversity_range(div, idx, &result));
+    TEST_ASSERT(fabsf(result.ranges[1] - 5.8f) < 0.01f, "%f", result.ranges[1]);
+    div->offset += 213;
+
+    /* Not synchronised, first radio only */
+    idx = diversity_test_exchange(div, DIVERSITY_TEST_DS_RESPONDER, 5.0f, 5.6f, DIVERSITY_TEST_HEARD_BOTH);
+    div->slave->status.ext_sync = 0;
+    TEST_ASSERT_FATAL(diversity_range(div, idx, &result));
+    TEST_ASSERT(result.flags == DIVERSITY_UNSYNCED, "%x", result.flags);
+    TEST_ASSERT(isnan(result.ranges[1]));
+    diversity_sync(div);
+
+    /* Not a final frame */
+    div->rng->frames[idx % DIVERSITY_TEST_NFRAMES]->code = DWT_DS_TWR_T2;
+    TEST_ASSERT(!diversity_range(div, idx, &result));
+#if MYNEWT_VAL(DIVERSITY_STATS)
+    TEST_ASSERT(div->stat.slave_miss - slave_miss == 4);
+    TEST_ASSERT(div->stat.unsynced - unsynced == 1);
+#endif
+}
@@ -0,0 +1,148 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file floor.h
+ * @brief Barometric floor detection fused with UWB height
+ *
+ * @details A reference anchor broadcasts its pressure, temperature and
+ * height. A tag turns the pressure difference to the reference into a
+ * height with the hypsometric equation, which cancels weather and building
+ * wide hvac changes common to both barometers. A two state Kalman filter
+ * (height, barometric offset) fuses that height with UWB z, the offset
+ * absorbs sensor mismatch and slow drift and is observed through UWB. The
+ * filtered height is mapped to a floor index with a confidence.
+ */
+
+#ifndef _FLOOR_H_
+#define _FLOOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stats/stats.h>
+#include <sensor/sensor.h>
+#include <uwb/uwb.h>
+#include <uwb/uwb_ftypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if MYNEWT_VAL(FLOOR_STATS)
+STATS_SECT_START(floor_stat_section)
+    STATS_SECT_ENTRY(baro_updates)
+    STATS_SECT_ENTRY(uwb_updates)
+    STATS_SECT_ENTRY(ref_tx)
+    STATS_SECT_ENTRY(ref_rx)
+    STATS_SECT_ENTRY(ref_stale)
+    STATS_SECT_ENTRY(transient)
+    STATS_SECT_ENTRY(gated)
+    STATS_SECT_ENTRY(relock)
+    STATS_SECT_ENTRY(floor_change)
+    STATS_SECT_ENTRY(start_tx_error)
+    STATS_SECT_ENTRY(start_rx_error)
+    STATS_SECT_ENTRY(rx_timeout)
+STATS_SECT_END
+#define FLOOR_STATS_INC(__X) STATS_INC(floor->stat, __X)
+#else
+#define FLOOR_STATS_INC(__X) {}
+#endif
+
+//! Reference pressure broadcast frame
+typedef union {
+    struct _floor_ref_frame_t{
+        struct _ieee_rng_request_frame_t;
+        float pressure;                //!< Reference pressure, Pa
+        float temperature;             //!< Reference temperature, C
+        float height;                  //!< Height of the reference barometer, m
+    }__attribute__((__packed__,aligned(1)));
+    uint8_t array[sizeof(struct _floor_ref_frame_t)];
+}floor_ref_frame_t;
+
+//! Floor status
+typedef struct _floor_status_t{
+    uint16_t selfmalloc:1;             //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;            //!< Instance allocated
+    uint16_t baro_valid:1;             //!< Local pressure seen
+    uint16_t ref_valid:1;              //!< Reference pressure seen
+    uint16_t height_valid:1;           //!< Height initialised from a measurement
+    uint16_t floor_valid:1;            //!< Floor index reported
+    uint16_t listening:1;              //!< Receiver started by floor_ref_listen
+    uint16_t start_tx_error:1;         //!< Start transmit error
+    uint16_t start_rx_error:1;         //!< Start receive error
+}floor_status_t;
+
+//! Floor detection instance
+struct floor_instance {
+#if MYNEWT_VAL(FLOOR_STATS)
+    STATS_SECT_DECL(floor_stat_section) stat; //!< Stats instance
+#endif
+    struct uwb_dev * dev_inst;         //!< Structure of uwb_dev
+    struct uwb_mac_interface cbs;      //!< MAC layer callbacks
+    floor_status_t status;             //!< Status
+    floor_ref_frame_t frame;           //!< Reference broadcast frame
+    struct sensor_listener listener;   //!< Barometer listener
+    uint16_t ref_address;              //!< Reference anchor, 0xffff accepts any
+    float pressure;                    //!< Last local pressure, Pa
+    float temperature;                 //!< Last local temperature, C
+    float height;                      //!< Height of the local barometer if used as reference, m
+    float ref_pressure;                //!< Last reference pressure, Pa
+    float ref_temperature;             //!< Last reference temperature, C
+    float ref_height;                  //!< Height of the reference barometer, m
+    uint32_t ref_timestamp;            //!< Cputime the reference was received
+    float z;                           //!< Filtered height, m
+    float bias;                        //!< Barometric height offset, m
+    float P[2][2];                     //!< Covariance of z, bias
+    uint32_t timestamp;                //!< Cputime of the last prediction
+    float baro_height;                 //!< Last accepted barometric height, m
+    uint32_t baro_timestamp;           //!< Cputime of the last barometric height
+    uint16_t gated_run;                //!< Consecutive gated barometric heights
+    int16_t floor;                     //!< Reported floor index
+    float confidence;                  //!< Probability of being on the reported floor
+    uint16_t nfloors;                  //!< Entries in floors[], 0 uses FLOOR_HEIGHT
+    float floors[MYNEWT_VAL(FLOOR_MAX_FLOORS)]; //!< Height of each floor slab, ascending, m
+};
+
+struct floor_instance * floor_init(struct floor_instance * floor, struct uwb_dev * inst);
+void floor_free(struct floor_instance * floor);
+struct floor_instance * floor_get_instance(void);
+void floor_reset(struct floor_instance * floor);
+int floor_set_floors(struct floor_instance * floor, const float heights[], uint16_t nfloors);
+void floor_set_reference(struct floor_instance * floor, uint16_t ref_address);
+void floor_set_height(struct floor_instance * floor, float height);
+
+void floor_pressure_update(struct floor_instance * floor, uint32_t timestamp, float pressure, float temperature);
+void floor_ref_update(struct floor_instance * floor, uint32_t timestamp, float pressure, float temperature, float height);
+int floor_uwb_update(struct floor_instance * floor, uint32_t timestamp, float z, float std);
+#if MYNEWT_VAL(FUSION_ENABLED)
+struct fusion_instance;
+int floor_fusion_update(struct floor_instance * floor, struct fusion_instance * fusion);
+#endif
+int floor_sensor_attach(struct floor_instance * floor, struct sensor * sensor);
+
+floor_status_t floor_ref_broadcast(struct floor_instance * floor, uint64_t dx_time);
+floor_status_t floor_ref_listen(struct floor_instance * floor, uint64_t dx_time);
+
+int16_t floor_get_floor(struct floor_instance * floor, float * confidence);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FLOOR_H_ */
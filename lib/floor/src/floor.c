@@ -0,0 +1,726 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file floor.c
+ * @brief Barometric floor detection fused with UWB height
+ *
+ * @details State x = [z, b], z the height of the tag and b the offset of
+ * the barometric height. Measurements:
+ *
+ *     baro: h = z_ref + Rd/g * T * ln(p_ref/p) = z + b
+ *     uwb:  z
+ *
+ * Both state components are random walks. Local pressure transients (doors,
+ * hvac zones) show up as barometric height rates no person or elevator can
+ * reach and are dropped before they reach the filter; anything slower that
+ * disagrees with UWB is gated and, if it persists, re-acquired as a new
+ * offset.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <os/os.h>
+#include <sysinit/sysinit.h>
+#include <stats/stats.h>
+#include <sensor/sensor.h>
+#include <sensor/pressure.h>
+#include <sensor/temperature.h>
+#include <uwb_rng/uwb_rng.h>
+#include <floor/floor.h>
+#if MYNEWT_VAL(FUSION_ENABLED)
+#include <fusion/fusion.h>
+#endif
+
+#if MYNEWT_VAL(FLOOR_STATS)
+STATS_NAME_START(floor_stat_section)
+    STATS_NAME(floor_stat_section, baro_updates)
+    STATS_NAME(floor_stat_section, uwb_updates)
+    STATS_NAME(floor_stat_section, ref_tx)
+    STATS_NAME(floor_stat_section, ref_rx)
+    STATS_NAME(floor_stat_section, ref_stale)
+    STATS_NAME(floor_stat_section, transient)
+    STATS_NAME(floor_stat_section, gated)
+    STATS_NAME(floor_stat_section, relock)
+    STATS_NAME(floor_stat_section, floor_change)
+    STATS_NAME(floor_stat_section, start_tx_error)
+    STATS_NAME(floor_stat_section, start_rx_error)
+    STATS_NAME(floor_stat_section, rx_timeout)
+STATS_NAME_END(floor_stat_section)
+#endif
+
+#define FLOOR_RD_OVER_G (29.2712f)     //!< Dry air gas constant over gravity, m/K
+#define FLOOR_KELVIN (273.15f)
+#define FLOOR_DEFAULT_TEMP (15.0f)     //!< Used until a barometer reports temperature, C
+#define FLOOR_DEFAULT_UWB_STD (0.3f)
+#define FLOOR_MAX_DT (60.0f)           //!< Longest prediction step, s
+
+static struct floor_instance * g_floor = NULL;
+
+static bool rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static bool rx_timeout_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static bool reset_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+
+#if MYNEWT_VAL(FLOOR_CLI)
+int floor_cli_register(void);
+#endif
+
+/**
+ * @fn floor_init(struct floor_instance * floor, struct uwb_dev * inst)
+ * @brief Allocate and initialise a floor detection instance.
+ *
+ * @param floor  Pointer to struct floor_instance, NULL to allocate.
+ * @param inst   Pointer to struct uwb_dev used for reference broadcasts.
+ *
+ * @return struct floor_instance *
+ */
+struct floor_instance *
+floor_init(struct floor_instance * floor, struct uwb_dev * inst)
+{
+    assert(inst);
+
+    if (floor == NULL) {
+        floor = (struct floor_instance *) malloc(sizeof(struct floor_instance));
+        assert(floor);
+        memset(floor, 0, sizeof(struct floor_instance));
+        floor->status.selfmalloc = 1;
+    }
+    floor->dev_inst = inst;
+    floor->ref_address = 0xffff;
+    floor->temperature = floor->ref_temperature = FLOOR_DEFAULT_TEMP;
+    floor->frame = (floor_ref_frame_t){
+        .PANID = 0xDECA,
+        .fctrl = FCNTL_IEEE_RANGE_16,
+        .dst_address = 0xffff,
+        .src_address = inst->my_short_address,
+        .code = DWT_FLOOR_REFERENCE
+    };
+    floor_reset(floor);
+
+    floor->cbs = (struct uwb_mac_interface){
+        .id = UWBEXT_FLOOR,
+        .inst_ptr = (void *) floor,
+        .rx_complete_cb = rx_complete_cb,
+        .rx_timeout_cb = rx_timeout_cb,
+        .reset_cb = reset_cb
+    };
+    uwb_mac_append_interface(inst, &floor->cbs);
+
+#if MYNEWT_VAL(FLOOR_STATS)
+    if (!floor->status.initialized) {
+        int rc = stats_init(
+                    STATS_HDR(floor->stat),
+                    STATS_SIZE_INIT_PARMS(floor->stat, STATS_SIZE_32),
+                    STATS_NAME_INIT_PARMS(floor_stat_section)
+            );
+        rc |= stats_register("floor", STATS_HDR(floor->stat));
+        assert(rc == 0);
+    }
+#endif
+    floor->status.initialized = 1;
+    g_floor = floor;
+    return floor;
+}
+
+/**
+ * @fn floor_free(struct floor_instance * floor)
+ * @brief Deconstructor.
+ *
+ * @param floor  Pointer to struct floor_instance.
+ *
+ * @return void
+ */
+void
+floor_free(struct floor_instance * floor)
+{
+    assert(floor);
+    uwb_mac_remove_interface(floor->dev_inst, floor->cbs.id);
+    if (g_floor == floor) {
+        g_floor = NULL;
+    }
+    if (floor->status.selfmalloc) {
+        free(floor);
+    } else {
+        floor->status.initialized = 0;
+    }
+}
+
+/**
+ * @fn floor_get_instance(void)
+ * @brief Instance created by the last floor_init, used by the cli.
+ *
+ * @return struct floor_instance *
+ */
+struct floor_instance *
+floor_get_instance(void)
+{
+    return g_floor;
+}
+
+/**
+ * @fn floor_reset(struct floor_instance * floor)
+ * @brief Forget the height and offset, the next measurement restarts the filter.
+ *
+ * @param floor  Pointer to struct floor_instance.
+ *
+ * @return void
+ */
+void
+floor_reset(struct floor_instance * floor)
+{
+    floor->z = floor->bias = 0;
+    memset(floor->P, 0, sizeof(floor->P));
+    floor->gated_run = 0;
+    floor->floor = 0;
+    floor->confidence = 0;
+    floor->status.height_valid = 0;
+    floor->status.floor_valid = 0;
+    floor->baro_timestamp = 0;
+    floor->timestamp = os_cputime_get32();
+}
+
+/**
+ * @fn floor_set_floors(struct floor_instance * floor, const float heights[], uint16_t nfloors)
+ * @brief Set the slab height of each floor, floor i spans heights[i] to
+ * heights[i+1]. With no table floors are FLOOR_HEIGHT apart from z = 0.
+ *
+ * @param floor    Pointer to struct floor_instance.
+ * @param heights  Floor heights in ascending order, m.
+ * @param nfloors  Number of floors, 0 clears the table.
+ *
+ * @return OS_OK, OS_EINVAL if the table is too long or not ascending.
+ */
+int
+floor_set_floors(struct floor_instance * floor, const float heights[], uint16_t nfloors)
+{
+    if (nfloors > MYNEWT_VAL(FLOOR_MAX_FLOORS)) {
+        return OS_EINVAL;
+    }
+    for (uint16_t i = 1; i < nfloors; i++) {
+        if (heights[i] <= heights[i-1]) {
+            return OS_EINVAL;
+        }
+    }
+    memcpy(floor->floors, heights, nfloors * sizeof(float));
+    floor->nfloors = nfloors;
+    floor->status.floor_valid = 0;
+    return OS_OK;
+}
+
+/**
+ * @fn floor_set_reference(struct floor_instance * floor, uint16_t ref_address)
+ * @brief Only accept reference broadcasts from one anchor.
+ *
+ * @param floor        Pointer to struct floor_instance.
+ * @param ref_address  Short address of the reference, 0xffff accepts any.
+ *
+ * @return void
+ */
+void
+floor_set_reference(struct floor_instance * floor, uint16_t ref_address)
+{
+    floor->ref_address = ref_address;
+}
+
+/**
+ * @fn floor_set_height(struct floor_instance * floor, float height)
+ * @brief Surveyed height of the local barometer, broadcast when this node
+ * acts as reference.
+ *
+ * @return void
+ */
+void
+floor_set_height(struct floor_instance * floor, float height)
+{
+    floor->height = height;
+}
+
+static void
+floor_predict(struct floor_instance * floor, uint32_t now)
+{
+    float dt = os_cputime_ticks_to_usecs(now - floor->timestamp) * 1e-6f;
+    float qz = MYNEWT_VAL(FLOOR_HEIGHT_WALK);
+    float qb = MYNEWT_VAL(FLOOR_BIAS_WALK);
+
+    floor->timestamp = now;
+    if (!floor->status.height_valid) {
+        return;
+    }
+    if (dt > FLOOR_MAX_DT) {
+        dt = FLOOR_MAX_DT;
+    }
+    floor->P[0][0] += qz * qz * dt;
+    floor->P[1][1] += qb * qb * dt;
+}
+
+/**
+ * @fn floor_correct(struct floor_instance * floor, float h0, float h1, float y, float r)
+ * @brief Gated scalar update with H = [h0, h1].
+ *
+ * @return OS_OK, OS_EINVAL if the innovation was gated.
+ */
+static int
+floor_correct(struct floor_instance * floor, float h0, float h1, float y, float r)
+{
+    float (*P)[2] = floor->P;
+    float PH0 = P[0][0] * h0 + P[0][1] * h1;
+    float PH1 = P[1][0] * h0 + P[1][1] * h1;
+    float S = h0 * PH0 + h1 * PH1 + r;
+    float K0 = PH0 / S, K1 = PH1 / S;
+
+    if (y * y / S > MYNEWT_VAL(FLOOR_GATE)) {
+        return OS_EINVAL;
+    }
+    floor->z += K0 * y;
+    floor->bias += K1 * y;
+    P[0][0] -= K0 * PH0;
+    P[0][1] -= K0 * PH1;
+    P[1][1] -= K1 * PH1;
+    P[1][0] = P[0][1];
+    return OS_OK;
+}
+
+static float
+floor_phi(float x)
+{
+    return 0.5f * (1.0f + erff(x * (float)M_SQRT1_2));
+}
+
+/**
+ * @fn floor_probability(struct floor_instance * floor, int16_t idx)
+ * @brief Probability mass of the height estimate within floor idx.
+ */
+static float
+floor_probability(struct floor_instance * floor, int16_t idx)
+{
+    float std = sqrtf(floor->P[0][0]);
+    float lo, hi;
+
+    if (floor->nfloors) {
+        if (idx < 0 || idx >= floor->nfloors) {
+            return 0;
+        }
+        lo = (idx == 0) ? -INFINITY : floor->floors[idx];
+        hi = (idx == floor->nfloors - 1) ? INFINITY : floor->floors[idx + 1];
+    } else {
+        lo = idx * MYNEWT_VAL(FLOOR_HEIGHT);
+        hi = lo + MYNEWT_VAL(FLOOR_HEIGHT);
+    }
+    return floor_phi((hi - floor->z) / std) - floor_phi((lo - floor->z) / std);
+}
+
+/**
+ * @fn floor_classify(struct floor_instance * floor)
+ * @brief Map the height to a floor, the reported floor only changes once
+ * the new one reaches FLOOR_MIN_CONFIDENCE.
+ */
+static void
+floor_classify(struct floor_instance * floor)
+{
+    int16_t idx;
+    float p;
+
+    if (floor->nfloors) {
+        for (idx = floor->nfloors - 1; idx > 0; idx--) {
+            if (floor->z >= floor->floors[idx]) {
+                break;
+            }
+        }
+    } else {
+        idx = (int16_t) floorf(floor->z / MYNEWT_VAL(FLOOR_HEIGHT));
+    }
+
+    p = floor_probability(floor, idx);
+    if (floor->status.floor_valid && idx == floor->floor) {
+        floor->confidence = p;
+    } else if (p >= MYNEWT_VAL(FLOOR_MIN_CONFIDENCE)) {
+        if (floor->status.floor_valid) {
+            FLOOR_STATS_INC(floor_change);
+        }
+        floor->floor = idx;
+        floor->confidence = p;
+        floor->status.floor_valid = 1;
+    } else if (floor->status.floor_valid) {
+        floor->confidence = floor_probability(floor, floor->floor);
+    }
+}
+
+/**
+ * @fn floor_baro_height(struct floor_instance * floor)
+ * @brief Hypsometric height of the local barometer relative to the reference.
+ */
+static float
+floor_baro_height(struct floor_instance * floor)
+{
+    float T = 0.5f * (floor->temperature + floor->ref_temperature) + FLOOR_KELVIN;
+    return floor->ref_height + FLOOR_RD_OVER_G * T * logf(floor->ref_pressure / floor->pressure);
+}
+
+/**
+ * @fn floor_pressure_update(struct floor_instance * floor, uint32_t timestamp, float pressure, float temperature)
+ * @brief Local barometer sample. Updates the height if a fresh reference is available.
+ *
+ * @param floor        Pointer to struct floor_instance.
+ * @param timestamp    Sample time, os_cputime ticks.
+ * @param pressure     Pressure, Pa.
+ * @param temperature  Temperature, C.
+ *
+ * @return void
+ */
+void
+floor_pressure_update(struct floor_instance * floor, uint32_t timestamp, float pressure, float temperature)
+{
+    float h, dt, bias_var = MYNEWT_VAL(FLOOR_BARO_BIAS_STD) * MYNEWT_VAL(FLOOR_BARO_BIAS_STD);
+    float r = MYNEWT_VAL(FLOOR_BARO_STD) * MYNEWT_VAL(FLOOR_BARO_STD);
+
+    if (pressure <= 0) {
+        return;
+    }
+    floor->pressure = pressure;
+    floor->temperature = temperature;
+    floor->status.baro_valid = 1;
+
+    if (!floor->status.ref_valid) {
+        return;
+    }
+    if (os_cputime_ticks_to_usecs(timestamp - floor->ref_timestamp) > MYNEWT_VAL(FLOOR_REF_TIMEOUT) * 1000UL) {
+        FLOOR_STATS_INC(ref_stale);
+        return;
+    }
+
+    h = floor_baro_height(floor);
+    if (floor->baro_timestamp) {
+        dt = os_cputime_ticks_to_usecs(timestamp - floor->baro_timestamp) * 1e-6f;
+        if (fabsf(h - floor->baro_height) > MYNEWT_VAL(FLOOR_MAX_RATE) * dt) {
+            /* Keep the new value as the rate reference so a genuine step
+             * is only dropped once */
+            floor->baro_height = h;
+            floor->baro_timestamp = timestamp;
+            FLOOR_STATS_INC(transient);
+            return;
+        }
+    }
+    floor->baro_height = h;
+    floor->baro_timestamp = timestamp;
+
+    floor_predict(floor, timestamp);
+    FLOOR_STATS_INC(baro_updates);
+    if (!floor->status.height_valid) {
+        /* z = h - b, with b unknown */
+        floor->z = h;
+        floor->bias = 0;
+        floor->P[0][0] = bias_var + r;
+        floor->P[0][1] = floor->P[1][0] = -bias_var;
+        floor->P[1][1] = bias_var;
+        floor->status.height_valid = 1;
+    } else if (floor_correct(floor, 1.0f, 1.0f, h - floor->z - floor->bias, r) != OS_OK) {
+        FLOOR_STATS_INC(gated);
+        if (++floor->gated_run >= MYNEWT_VAL(FLOOR_GATE_RELOCK)) {
+            /* Barometer and height disagree for good, e.g. the reference
+             * was moved, take a fresh offset */
+            floor->bias = h - floor->z;
+            floor->P[0][1] = floor->P[1][0] = 0;
+            floor->P[1][1] = bias_var;
+            floor->gated_run = 0;
+            FLOOR_STATS_INC(relock);
+        }
+        return;
+    }
+    floor->gated_run = 0;
+    floor_classify(floor);
+}
+
+/**
+ * @fn floor_ref_update(struct floor_instance * floor, uint32_t timestamp, float pressure, float temperature, float height)
+ * @brief Reference barometer sample, from a broadcast or a backhaul.
+ *
+ * @param floor        Pointer to struct floor_instance.
+ * @param timestamp    Reception time, os_cputime ticks.
+ * @param pressure     Reference pressure, Pa.
+ * @param temperature  Reference temperature, C.
+ * @param height       Height of the reference barometer, m.
+ *
+ * @return void
+ */
+void
+floor_ref_update(struct floor_instance * floor, uint32_t timestamp, float pressure, float temperature, float height)
+{
+    if (pressure <= 0) {
+        return;
+    }
+    floor->ref_pressure = pressure;
+    floor->ref_temperature = temperature;
+    floor->ref_height = height;
+    floor->ref_timestamp = timestamp;
+    floor->status.ref_valid = 1;
+}
+
+/**
+ * @fn floor_uwb_update(struct floor_instance * floor, uint32_t timestamp, float z, float std)
+ * @brief UWB height, observes the barometric offset.
+ *
+ * @param floor      Pointer to struct floor_instance.
+ * @param timestamp  Time of the position fix, os_cputime ticks.
+ * @param z          Height, m.
+ * @param std        Height std deviation, m, 0 for the default.
+ *
+ * @return OS_OK, OS_EINVAL if gated.
+ */
+int
+floor_uwb_update(struct floor_instance * floor, uint32_t timestamp, float z, float std)
+{
+    float r;
+
+    if (std <= 0) {
+        std = FLOOR_DEFAULT_UWB_STD;
+    }
+    r = std * std;
+
+    floor_predict(floor, timestamp);
+    FLOOR_STATS_INC(uwb_updates);
+    if (!floor->status.height_valid) {
+        floor->z = z;
+        floor->bias = 0;
+        floor->P[0][0] = r;
+        floor->P[0][1] = floor->P[1][0] = 0;
+        floor->P[1][1] = MYNEWT_VAL(FLOOR_BARO_BIAS_STD) * MYNEWT_VAL(FLOOR_BARO_BIAS_STD);
+        floor->status.height_valid = 1;
+    } else if (floor_correct(floor, 1.0f, 0, z - floor->z, r) != OS_OK) {
+        FLOOR_STATS_INC(gated);
+        return OS_EINVAL;
+    }
+    floor_classify(floor);
+    return OS_OK;
+}
+
+#if MYNEWT_VAL(FUSION_ENABLED)
+/**
+ * @fn floor_fusion_update(struct floor_instance * floor, struct fusion_instance * fusion)
+ * @brief UWB height from the fusion tracker, call after each tracker update.
+ *
+ * @return see floor_uwb_update
+ */
+int
+floor_fusion_update(struct floor_instance * floor, struct fusion_instance * fusion)
+{
+    triadf_t pos, var;
+
+    fusion_get_position(fusion, &pos, &var);
+    return floor_uwb_update(floor, os_cputime_get32(), pos.z, sqrtf(var.z));
+}
+#endif
+
+static int
+floor_sensor_data_cb(struct sensor * sensor, void * arg, void * data, sensor_type_t type)
+{
+    struct floor_instance * floor = (struct floor_instance *) arg;
+
+    if (type == SENSOR_TYPE_TEMPERATURE) {
+        struct sensor_temp_data * std = (struct sensor_temp_data *) data;
+        if (std->std_temp_is_valid) {
+            floor->temperature = std->std_temp;
+        }
+    } else if (type == SENSOR_TYPE_PRESSURE) {
+        struct sensor_press_data * spd = (struct sensor_press_data *) data;
+        if (spd->spd_press_is_valid) {
+            floor_pressure_update(floor, os_cputime_get32(), spd->spd_press, floor->temperature);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @fn floor_sensor_attach(struct floor_instance * floor, struct sensor * sensor)
+ * @brief Feed the instance from a barometer such as the lps22hb through a
+ * sensor listener, readings are then driven by sensor_read or the sensor
+ * manager poll rate.
+ *
+ * @param floor   Pointer to struct floor_instance.
+ * @param sensor  Pointer to the barometer sensor.
+ *
+ * @return sensor_register_listener return code.
+ */
+int
+floor_sensor_attach(struct floor_instance * floor, struct sensor * sensor)
+{
+    floor->listener = (struct sensor_listener){
+        .sl_sensor_type = SENSOR_TYPE_PRESSURE | SENSOR_TYPE_TEMPERATURE,
+        .sl_func = floor_sensor_data_cb,
+        .sl_arg = (void *) floor
+    };
+    return sensor_register_listener(sensor, &floor->listener);
+}
+
+/**
+ * @fn floor_ref_broadcast(struct floor_instance * floor, uint64_t dx_time)
+ * @brief Broadcast the local pressure as reference, call from a tdma slot
+ * on the reference anchor.
+ *
+ * @param floor    Pointer to struct floor_instance.
+ * @param dx_time  Delayed start time, 0 to send immediately.
+ *
+ * @return floor_status_t
+ */
+floor_status_t
+floor_ref_broadcast(struct floor_instance * floor, uint64_t dx_time)
+{
+    struct uwb_dev * inst = floor->dev_inst;
+
+    if (!floor->status.baro_valid) {
+        return floor->status;
+    }
+    floor->frame.seq_num++;
+    floor->frame.src_address = inst->my_short_address;
+    floor->frame.pressure = floor->pressure;
+    floor->frame.temperature = floor->temperature;
+    floor->frame.height = floor->height;
+
+    uwb_write_tx(inst, floor->frame.array, 0, sizeof(floor_ref_frame_t));
+    uwb_write_tx_fctrl(inst, sizeof(floor_ref_frame_t), 0);
+    if (dx_time) {
+        uwb_set_delay_start(inst, dx_time);
+    }
+    floor->status.start_tx_error = uwb_start_tx(inst).start_tx_error;
+    if (floor->status.start_tx_error) {
+        FLOOR_STATS_INC(start_tx_error);
+    } else {
+        FLOOR_STATS_INC(ref_tx);
+    }
+    return floor->status;
+}
+
+/**
+ * @fn floor_ref_listen(struct floor_instance * floor, uint64_t dx_time)
+ * @brief Listen for one reference broadcast, call from the tdma slot the
+ * reference transmits in.
+ *
+ * @param floor    Pointer to struct floor_instance.
+ * @param dx_time  Delayed start time, 0 to start immediately.
+ *
+ * @return floor_status_t
+ */
+floor_status_t
+floor_ref_listen(struct floor_instance * floor, uint64_t dx_time)
+{
+    struct uwb_dev * inst = floor->dev_inst;
+    uint16_t timeout = uwb_phy_frame_duration(inst, sizeof(floor_ref_frame_t))
+                        + MYNEWT_VAL(FLOOR_RX_TIMEOUT);
+
+    uwb_set_rx_timeout(inst, timeout);
+    if (dx_time) {
+        uwb_set_delay_start(inst, dx_time);
+    }
+    floor->status.listening = 1;
+    floor->status.start_rx_error = uwb_start_rx(inst).start_rx_error;
+    if (floor->status.start_rx_error) {
+        floor->status.listening = 0;
+        FLOOR_STATS_INC(start_rx_error);
+    }
+    return floor->status;
+}
+
+/**
+ * @fn floor_get_floor(struct floor_instance * floor, float * confidence)
+ * @brief Current floor estimate.
+ *
+ * @param floor       Pointer to struct floor_instance.
+ * @param confidence  Probability of being on the returned floor, 0 if no
+ *                    floor has been determined yet. May be NULL.
+ *
+ * @return Floor index.
+ */
+int16_t
+floor_get_floor(struct floor_instance * floor, float * confidence)
+{
+    if (confidence) {
+        *confidence = floor->status.floor_valid ? floor->confidence : 0;
+    }
+    return floor->floor;
+}
+
+/**
+ * @fn rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+ * @brief Take reference broadcasts whether or not floor_ref_listen started
+ * the receiver.
+ *
+ * @return true if the frame was a reference broadcast
+ */
+static bool
+rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct floor_instance * floor = (struct floor_instance *) cbs->inst_ptr;
+    floor_ref_frame_t * frame = (floor_ref_frame_t *) inst->rxbuf;
+
+    if (inst->fctrl != FCNTL_IEEE_RANGE_16 || inst->frame_len < sizeof(floor_ref_frame_t)) {
+        return false;
+    }
+    if (frame->code != DWT_FLOOR_REFERENCE || frame->dst_address != 0xffff) {
+        return false;
+    }
+    floor->status.listening = 0;
+    if (floor->ref_address != 0xffff && frame->src_address != floor->ref_address) {
+        return true;
+    }
+    FLOOR_STATS_INC(ref_rx);
+    floor_ref_update(floor, os_cputime_get32(), frame->pressure, frame->temperature, frame->height);
+    return true;
+}
+
+static bool
+rx_timeout_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct floor_instance * floor = (struct floor_instance *) cbs->inst_ptr;
+
+    if (!floor->status.listening) {
+        return false;
+    }
+    floor->status.listening = 0;
+    FLOOR_STATS_INC(rx_timeout);
+    return true;
+}
+
+static bool
+reset_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct floor_instance * floor = (struct floor_instance *) cbs->inst_ptr;
+
+    if (!floor->status.listening) {
+        return false;
+    }
+    floor->status.listening = 0;
+    return true;
+}
+
+void
+floor_pkg_init(void)
+{
+#if MYNEWT_VAL(FLOOR_VERBOSE)
+    printf("{\"utime\": %lu,\"msg\": \"floor_pkg_init\"}\n", os_cputime_ticks_to_usecs(os_cputime_get32()));
+#endif
+#if MYNEWT_VAL(UWB_DEVICE_0)
+    floor_init(NULL, uwb_dev_idx_lookup(0));
+#endif
+#if MYNEWT_VAL(FLOOR_CLI)
+    int rc = floor_cli_register();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+}
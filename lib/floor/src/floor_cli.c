@@ -0,0 +1,137 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <os/os.h>
+#include <syscfg/syscfg.h>
+
+#if MYNEWT_VAL(FLOOR_CLI)
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <shell/shell.h>
+#include <console/console.h>
+
+#include "floor/floor.h"
+
+static int floor_cli_cmd(int argc, char **argv);
+
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+const struct shell_param cmd_floor_param[] = {
+    {"state", "height, offset and floor"},
+    {"floors", "[<h0> <h1> ...] show or set floor heights, m"},
+    {"ref", "<addr> only accept this reference, 0xffff for any"},
+    {"height", "<z> height of the local barometer when used as reference, m"},
+    {"reset", "restart height filter"},
+    {NULL,NULL},
+};
+
+const struct shell_cmd_help cmd_floor_help = {
+	"floor", "<cmd>", cmd_floor_param
+};
+#endif
+
+static struct shell_cmd shell_floor_cmd = {
+    .sc_cmd = "floor",
+    .sc_cmd_func = floor_cli_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+    .help = &cmd_floor_help
+#endif
+};
+
+static void
+print_float(float v)
+{
+    console_printf("%s%d.%03d", (v < 0) ? "-" : "", (int)fabsf(v),
+                   (int)((fabsf(v) - (int)fabsf(v))*1000));
+}
+
+static void
+floor_cli_state(struct floor_instance * floor)
+{
+    float confidence;
+    int16_t idx = floor_get_floor(floor, &confidence);
+
+    console_printf("z: ");
+    print_float(floor->z);
+    console_printf(", z_std: ");
+    print_float(sqrtf(floor->P[0][0]));
+    console_printf(", bias: ");
+    print_float(floor->bias);
+    console_printf(", bias_std: ");
+    print_float(sqrtf(floor->P[1][1]));
+    console_printf("\nfloor: %d, confidence: ", idx);
+    print_float(confidence);
+    console_printf("\npressure: ");
+    print_float(floor->pressure);
+    console_printf(", ref_pressure: ");
+    print_float(floor->ref_pressure);
+    console_printf(", ref_age_ms: %lu\n", floor->status.ref_valid ?
+                   os_cputime_ticks_to_usecs(os_cputime_get32() - floor->ref_timestamp)/1000 : 0);
+}
+
+static int
+floor_cli_cmd(int argc, char **argv)
+{
+    struct floor_instance * floor = floor_get_instance();
+    float heights[MYNEWT_VAL(FLOOR_MAX_FLOORS)];
+
+    if (argc < 2) {
+        return 0;
+    }
+    if (floor == NULL) {
+        console_printf("No floor instance\n");
+        return 0;
+    }
+
+    if (!strcmp(argv[1], "state")) {
+        floor_cli_state(floor);
+    } else if (!strcmp(argv[1], "floors")) {
+        if (argc > 2) {
+            for (int i = 2; i < argc && i - 2 < MYNEWT_VAL(FLOOR_MAX_FLOORS); i++) {
+                heights[i - 2] = strtof(argv[i], NULL);
+            }
+            if (floor_set_floors(floor, heights, argc - 2) != OS_OK) {
+                console_printf("Failed\n");
+            }
+        }
+        for (int i = 0; i < floor->nfloors; i++) {
+            console_printf("%d: ", i);
+            print_float(floor->floors[i]);
+            console_printf("\n");
+        }
+    } else if (!strcmp(argv[1], "ref") && argc > 2) {
+        floor_set_reference(floor, strtol(argv[2], NULL, 0));
+    } else if (!strcmp(argv[1], "height") && argc > 2) {
+        floor_set_height(floor, strtof(argv[2], NULL));
+    } else if (!strcmp(argv[1], "reset")) {
+        floor_reset(floor);
+    } else {
+        console_printf("Unknown cmd\n");
+    }
+    return 0;
+}
+
+int
+floor_cli_register(void)
+{
+    return shell_cmd_register(&shell_floor_cmd);
+}
+#endif /* MYNEWT_VAL(FLOOR_CLI) */
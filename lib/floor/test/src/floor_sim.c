@@ -0,0 +1,184 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "floor_test.h"
+
+#define FLOOR_TEST_BARO_HZ (10)
+#define FLOOR_TEST_REF_DIV (10)
+#define FLOOR_TEST_RD_OVER_G (29.2712f)
+#define FLOOR_TEST_TEMP (20.0f)
+#define FLOOR_TEST_P0 (101325.0f)
+#define FLOOR_TEST_BARO_NOISE (1.0f)   /* Pa, about 8cm */
+#define FLOOR_TEST_REF_HEIGHT (2.5f)   /* Reference barometer on floor 0 */
+#define FLOOR_TEST_TAG_HEIGHT (1.2f)   /* Tag above its floor slab */
+#define FLOOR_TEST_ANCHOR_HEIGHT (2.8f) /* Anchor plane above each floor slab */
+#define FLOOR_TEST_DOOR (25.0f)        /* Door pressure spike, Pa */
+#define FLOOR_TEST_STEADY (5.0f)       /* Floors are expected right this long after a transition, s */
+
+/* Walk on floor 0, stairs to 1, elevator to 3, stairs to 2, elevator to 5
+ * and stairs to 4 */
+static const float g_route[][2] = {
+    {0.0f, 0}, {60.0f, 0}, {75.0f, 1}, {150.0f, 1}, {157.0f, 3},
+    {300.0f, 3}, {315.0f, 2}, {420.0f, 2}, {430.5f, 5}, {520.0f, 5},
+    {535.0f, 4}, {600.0f, 4},
+};
+#define FLOOR_TEST_NROUTE (sizeof(g_route)/sizeof(g_route[0]))
+
+static struct uwb_dev g_dev;
+static uint32_t g_seed = 1;
+
+void
+floor_test_seed(uint32_t seed)
+{
+    g_seed = (seed) ? seed : 1;
+}
+
+static float
+randu(void)
+{
+    g_seed ^= g_seed << 13;
+    g_seed ^= g_seed >> 17;
+    g_seed ^= g_seed << 5;
+    return (g_seed >> 8) * (1.0f / 16777216.0f);
+}
+
+static float
+randn(void)
+{
+    float u = randu();
+
+    while (u < 1e-7f) {
+        u = randu();
+    }
+    return sqrtf(-2.0f * logf(u)) * cosf(2.0f * (float)M_PI * randu());
+}
+
+/**
+ * Initialise the filter on a dummy uwb device, floors FLOOR_TEST_HEIGHT apart.
+ */
+void
+floor_test_setup(struct floor_instance * floor)
+{
+    memset(&g_dev, 0, sizeof(g_dev));
+    memset(floor, 0, sizeof(*floor));
+    TEST_ASSERT_FATAL(floor_init(floor, &g_dev) == floor);
+}
+
+/**
+ * Height of the tag along the route, m.
+ */
+float
+floor_test_height(float t)
+{
+    float a;
+    int i;
+
+    if (t <= g_route[0][0]) {
+        return g_route[0][1] * FLOOR_TEST_HEIGHT + FLOOR_TEST_TAG_HEIGHT;
+    }
+    for (i = 1; i < FLOOR_TEST_NROUTE; i++) {
+        if (t <= g_route[i][0]) {
+            a = (t - g_route[i-1][0]) / (g_route[i][0] - g_route[i-1][0]);
+            return (g_route[i-1][1] + a * (g_route[i][1] - g_route[i-1][1])) * FLOOR_TEST_HEIGHT
+                + FLOOR_TEST_TAG_HEIGHT;
+        }
+    }
+    return g_route[FLOOR_TEST_NROUTE - 1][1] * FLOOR_TEST_HEIGHT + FLOOR_TEST_TAG_HEIGHT;
+}
+
+static float
+pressure(float p0, float z)
+{
+    return p0 * expf(-z / (FLOOR_TEST_RD_OVER_G * (FLOOR_TEST_TEMP + 273.15f)));
+}
+
+static uint32_t
+ticks(float t)
+{
+    /* Start at 1s, a zero timestamp means no previous barometer sample */
+    return os_cputime_usecs_to_ticks((uint32_t)((t + 1.0f) * 1e6f));
+}
+
+/**
+ * Feed the filter with a synthetic trace. Weather drift is seen by both
+ * barometers, the hvac step, door spikes and the sensor offset only by the
+ * tag. Each second the reference broadcasts and a UWB height arrives.
+ */
+void
+floor_test_run(struct floor_instance * floor, struct floor_test_run * run)
+{
+    uint32_t k, steps = (uint32_t)((run->t1 - run->t0) * FLOOR_TEST_BARO_HZ + 0.5f);
+    float t, z, p0, p, ref_z, plane, err;
+    int16_t idx, truth, last = -1;
+    bool steady;
+
+    run->max_err = 0;
+    for (k = 0; k <= steps; k++) {
+        t = run->t0 + (float)k / FLOOR_TEST_BARO_HZ;
+        z = floor_test_height(t);
+        p0 = FLOOR_TEST_P0 + run->weather * t / 600.0f;
+
+        if (k % FLOOR_TEST_REF_DIV == 0) {
+            ref_z = FLOOR_TEST_REF_HEIGHT;
+            if (run->ref_move && t >= run->ref_move_time) {
+                ref_z += run->ref_move;
+            }
+            p = pressure(p0, ref_z) + FLOOR_TEST_BARO_NOISE * randn();
+            floor_ref_update(floor, ticks(t), p, FLOOR_TEST_TEMP, FLOOR_TEST_REF_HEIGHT);
+
+            if (randu() < run->mirror_rate) {
+                plane = floorf(z / FLOOR_TEST_HEIGHT) * FLOOR_TEST_HEIGHT + FLOOR_TEST_ANCHOR_HEIGHT;
+                floor_uwb_update(floor, ticks(t), 2.0f * plane - z, run->uwb_std);
+            } else {
+                floor_uwb_update(floor, ticks(t), z + run->uwb_std * randn(), run->uwb_std);
+            }
+        }
+
+        p = pressure(p0, z) + run->baro_offset + FLOOR_TEST_BARO_NOISE * randn();
+        if (run->hvac && t >= run->hvac_time) {
+            p += run->hvac;
+        }
+        if (fmodf(t, 100.0f) >= 37.0f && fmodf(t, 100.0f) < 37.25f) {
+            p += FLOOR_TEST_DOOR;
+        }
+        floor_pressure_update(floor, ticks(t), p, FLOOR_TEST_TEMP);
+
+        if (t - run->t0 < run->settle) {
+            continue;
+        }
+        idx = floor_get_floor(floor, NULL);
+        truth = (int16_t)floorf(z / FLOOR_TEST_HEIGHT);
+        steady = (floor_test_height(t - FLOOR_TEST_STEADY) == z);
+        run->samples++;
+        if (run->samples > 1 && idx != last) {
+            run->changes++;
+        }
+        last = idx;
+        if (!floor->status.floor_valid || idx != truth) {
+            run->wrong++;
+            run->wrong_steady += steady;
+        }
+        if (steady) {
+            err = fabsf(floor->z - z);
+            if (err > run->max_err) {
+                run->max_err = err;
+            }
+        }
+    }
+}
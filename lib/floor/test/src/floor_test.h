@@ -0,0 +1,74 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _FLOOR_TEST_H
+#define _FLOOR_TEST_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "testutil/testutil.h"
+
+#include "floor/floor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! One simulated run, 10Hz barometer, 1Hz reference broadcast and UWB height
+struct floor_test_run {
+    float t0;                          //!< Start time, s
+    float t1;                          //!< End time, s
+    float settle;                      //!< Floors are checked from t0 + settle, s
+    float baro_offset;                 //!< Local barometer offset, Pa
+    float weather;                     //!< Drift of the outside pressure over the run, Pa
+    float hvac;                        //!< Local pressure step at hvac_time, Pa
+    float hvac_time;                   //!< s
+    float ref_move;                    //!< Unannounced move of the reference barometer at ref_move_time, m
+    float ref_move_time;               //!< s
+    float uwb_std;                     //!< UWB height noise, m
+    float mirror_rate;                 //!< Fraction of UWB heights mirrored about the anchor plane
+    /* Results */
+    uint32_t samples;                  //!< Barometer samples after settling
+    uint32_t wrong;                    //!< Samples with a wrong or no floor
+    uint32_t wrong_steady;             //!< Of which away from a floor transition
+    uint32_t changes;                  //!< Reported floor changes after settling
+    float max_err;                     //!< Max height error away from a transition, m
+};
+
+//! Floor to floor height of the simulated building, matches FLOOR_HEIGHT
+#define FLOOR_TEST_HEIGHT (3.5f)
+//! Number of floor changes along the simulated route
+#define FLOOR_TEST_CROSSINGS (8)
+
+void floor_test_setup(struct floor_instance * floor);
+void floor_test_seed(uint32_t seed);
+float floor_test_height(float t);
+void floor_test_run(struct floor_instance * floor, struct floor_test_run * run);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,53 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "floor_test.h"
+
+TEST_CASE(floor_relock_test)
+{
+    struct floor_instance floor;
+    struct floor_test_run run = {
+        .t0 = 0.0f,
+        .t1 = 600.0f,
+        .settle = 60.0f,
+        .baro_offset = -40.0f,
+        .ref_move = FLOOR_TEST_HEIGHT,
+        .ref_move_time = 240.0f,
+        .uwb_std = 1.5f,
+        .mirror_rate = 0.05f,
+    };
+
+    /* The reference barometer is taken one floor up without updating its
+     * height, every barometric height is 3.5m low from then on */
+    floor_test_seed(0x9e3779b9);
+    floor_test_setup(&floor);
+    floor_test_run(&floor, &run);
+    printf("relock: wrong %lu/%lu steady %lu max %.3f\n", (unsigned long)run.wrong,
+           (unsigned long)run.samples, (unsigned long)run.wrong_steady, run.max_err);
+
+#if MYNEWT_VAL(FLOOR_STATS)
+    TEST_ASSERT(floor.stat.relock > 0);
+#endif
+    TEST_ASSERT(run.wrong_steady == 0, "wrong %lu away from transitions", (unsigned long)run.wrong_steady);
+    /* The new offset is taken against a height only held by UWB while the
+     * barometer was gated, the floor must hold while it settles */
+    TEST_ASSERT(run.max_err < 2.0f, "max %f", run.max_err);
+    TEST_ASSERT(run.changes == FLOOR_TEST_CROSSINGS, "changes %lu", (unsigned long)run.changes);
+
+    floor_free(&floor);
+}
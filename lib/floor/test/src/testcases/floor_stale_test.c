@@ -0,0 +1,59 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "floor_test.h"
+
+TEST_CASE(floor_stale_test)
+{
+    struct floor_instance floor;
+    uint32_t t, timeout = MYNEWT_VAL(FLOOR_REF_TIMEOUT) * 1000UL;
+    float z;
+
+    floor_test_setup(&floor);
+
+    /* No reference yet, the pressure is only stored */
+    floor_pressure_update(&floor, os_cputime_usecs_to_ticks(1000000), 101000.0f, 20.0f);
+    TEST_ASSERT(floor.status.baro_valid);
+    TEST_ASSERT(!floor.status.height_valid);
+
+    /* Invalid readings are ignored */
+    floor_ref_update(&floor, os_cputime_usecs_to_ticks(1000000), 0, 20.0f, 0);
+    TEST_ASSERT(!floor.status.ref_valid);
+
+    floor_ref_update(&floor, os_cputime_usecs_to_ticks(1000000), 101000.0f, 20.0f, 2.0f);
+    floor_pressure_update(&floor, os_cputime_usecs_to_ticks(1100000), 101000.0f, 20.0f);
+    TEST_ASSERT_FATAL(floor.status.height_valid);
+    TEST_ASSERT(fabsf(floor.z - 2.0f) < 0.01f, "z %f", floor.z);
+    z = floor.z;
+
+    /* The reference goes quiet, samples after the timeout leave the height */
+    for (t = 1200000; t < 1000000 + 2 * timeout; t += 100000) {
+        floor_pressure_update(&floor, os_cputime_usecs_to_ticks(t), 100990.0f, 20.0f);
+        if (t > 1000000 + timeout) {
+            TEST_ASSERT(floor.z == z);
+        } else {
+            z = floor.z;
+        }
+    }
+#if MYNEWT_VAL(FLOOR_STATS)
+    TEST_ASSERT(floor.stat.ref_stale > 0);
+#endif
+    TEST_ASSERT(z > 2.0f, "z %f", z);
+
+    floor_free(&floor);
+}
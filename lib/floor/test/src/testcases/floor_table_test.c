@@ -0,0 +1,76 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "floor_test.h"
+
+static void
+settle_at(struct floor_instance * floor, float z)
+{
+    int i;
+
+    floor_reset(floor);
+    for (i = 0; i < 20; i++) {
+        floor_uwb_update(floor, os_cputime_usecs_to_ticks(1000000 + i * 100000), z, 0.1f);
+    }
+}
+
+TEST_CASE(floor_table_test)
+{
+    struct floor_instance floor;
+    float heights[MYNEWT_VAL(FLOOR_MAX_FLOORS) + 1];
+    float conf;
+    int i, rc;
+
+    floor_test_setup(&floor);
+
+    for (i = 0; i <= MYNEWT_VAL(FLOOR_MAX_FLOORS); i++) {
+        heights[i] = i * 4.5f;
+    }
+    rc = floor_set_floors(&floor, heights, MYNEWT_VAL(FLOOR_MAX_FLOORS) + 1);
+    TEST_ASSERT(rc == OS_EINVAL);
+    heights[2] = heights[1];
+    rc = floor_set_floors(&floor, heights, 3);
+    TEST_ASSERT(rc == OS_EINVAL);
+    TEST_ASSERT(floor.nfloors == 0);
+
+    /* Without a table floors are FLOOR_HEIGHT apart */
+    settle_at(&floor, 8.0f);
+    TEST_ASSERT(floor_get_floor(&floor, &conf) == (int16_t)(8.0f / MYNEWT_VAL(FLOOR_HEIGHT)));
+    TEST_ASSERT(conf > MYNEWT_VAL(FLOOR_MIN_CONFIDENCE), "confidence %f", conf);
+
+    heights[2] = 9.0f;
+    rc = floor_set_floors(&floor, heights, 3);
+    TEST_ASSERT_FATAL(rc == OS_OK);
+    settle_at(&floor, 8.0f);
+    TEST_ASSERT(floor_get_floor(&floor, &conf) == 1);
+    TEST_ASSERT(conf > MYNEWT_VAL(FLOOR_MIN_CONFIDENCE), "confidence %f", conf);
+
+    /* Below the first and above the last slab */
+    settle_at(&floor, -3.0f);
+    TEST_ASSERT(floor_get_floor(&floor, NULL) == 0);
+    settle_at(&floor, 20.0f);
+    TEST_ASSERT(floor_get_floor(&floor, NULL) == 2);
+
+    /* Close to a slab the confidence stays low and no floor is reported */
+    settle_at(&floor, 9.0f);
+    floor_get_floor(&floor, &conf);
+    TEST_ASSERT(!floor.status.floor_valid);
+    TEST_ASSERT(conf == 0);
+
+    floor_free(&floor);
+}
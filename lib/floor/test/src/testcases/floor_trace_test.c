@@ -0,0 +1,53 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "floor_test.h"
+
+TEST_CASE(floor_trace_test)
+{
+    struct floor_instance floor;
+    struct floor_test_run run = {
+        .t0 = 0.0f,
+        .t1 = 600.0f,
+        .settle = 60.0f,
+        .baro_offset = 60.0f,
+        .weather = -150.0f,
+        .hvac = 8.0f,
+        .hvac_time = 200.0f,
+        .uwb_std = 1.5f,
+        .mirror_rate = 0.05f,
+    };
+
+    floor_test_seed(0x2545f491);
+    floor_test_setup(&floor);
+    floor_test_run(&floor, &run);
+    printf("trace: wrong %lu/%lu steady %lu max %.3f\n", (unsigned long)run.wrong,
+           (unsigned long)run.samples, (unsigned long)run.wrong_steady, run.max_err);
+
+    TEST_ASSERT(run.wrong_steady == 0, "wrong %lu away from transitions", (unsigned long)run.wrong_steady);
+    TEST_ASSERT(run.wrong * 50 < run.samples, "wrong %lu", (unsigned long)run.wrong);
+    TEST_ASSERT(run.max_err < 1.2f, "max %f", run.max_err);
+#if MYNEWT_VAL(FLOOR_STATS)
+    /* Door spikes are dropped */
+    TEST_ASSERT(floor.stat.transient >= 6, "transient %lu", (unsigned long)floor.stat.transient);
+#endif
+    /* Each floor along the route is reported once, without flicker */
+    TEST_ASSERT(run.changes == FLOOR_TEST_CROSSINGS, "changes %lu", (unsigned long)run.changes);
+
+    floor_free(&floor);
+}
@@ -0,0 +1,143 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file fusion.h
+ * @brief UWB/IMU error-state EKF tracker
+ *
+ * @details The nominal state (position, velocity, attitude, accel and gyro
+ * biases) is propagated with accelerometer and gyroscope samples, a 15 state
+ * error covariance is carried alongside. TWR ranges and TDoAs to anchors
+ * with known positions are applied as sequential scalar updates, each gated
+ * on its normalised innovation. Every step has a fixed operation count so the
+ * per update cost is bounded independently of the number of anchors.
+ */
+
+#ifndef _FUSION_H_
+#define _FUSION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <euclid/triad.h>
+#include <stats/stats.h>
+#include <uwb/uwb.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FUSION_NSTATES (15)            //!< Error state dimension
+#define FUSION_IDX_POS (0)             //!< Position error
+#define FUSION_IDX_VEL (3)             //!< Velocity error
+#define FUSION_IDX_ATT (6)             //!< Attitude error, small angle
+#define FUSION_IDX_BA  (9)             //!< Accelerometer bias error
+#define FUSION_IDX_BG  (12)            //!< Gyroscope bias error
+
+#if MYNEWT_VAL(FUSION_STATS)
+STATS_SECT_START(fusion_stat_section)
+    STATS_SECT_ENTRY(imu_updates)
+    STATS_SECT_ENTRY(range_updates)
+    STATS_SECT_ENTRY(tdoa_updates)
+    STATS_SECT_ENTRY(gated)
+    STATS_SECT_ENTRY(unknown_anchor)
+    STATS_SECT_ENTRY(dt_clamped)
+    STATS_SECT_ENTRY(relock)
+STATS_SECT_END
+#define FUSION_STATS_INC(__X) STATS_INC(fusion->stat, __X)
+#else
+#define FUSION_STATS_INC(__X) {}
+#endif
+
+//! Noise parameters, continuous time spectral densities
+struct fusion_config {
+    float acc_noise;                   //!< Accelerometer noise, m/s^2/sqrt(Hz)
+    float gyro_noise;                  //!< Gyroscope noise, rad/s/sqrt(Hz)
+    float acc_bias_walk;               //!< Accelerometer bias random walk, m/s^3/sqrt(Hz)
+    float gyro_bias_walk;              //!< Gyroscope bias random walk, rad/s^2/sqrt(Hz)
+    float range_std;                   //!< Default range std deviation, m
+    float tdoa_std;                    //!< Default tdoa std deviation, m
+    float init_pos_std;                //!< Initial position std deviation, m
+    float gate;                        //!< Squared normalised innovation gate
+};
+
+//! Anchor with a known position
+struct fusion_anchor {
+    uint16_t addr;                     //!< Short address, 0 marks a free entry
+    triadf_t pos;                      //!< Position in the local frame, m
+};
+
+//! Fusion tracker instance
+struct fusion_instance {
+#if MYNEWT_VAL(FUSION_STATS)
+    STATS_SECT_DECL(fusion_stat_section) stat; //!< Stats instance
+#endif
+    struct fusion_config config;       //!< Noise parameters
+    struct {
+        uint16_t selfmalloc:1;         //!< Internal flag for memory garbage collection
+        uint16_t initialized:1;        //!< Instance allocated
+        uint16_t imu_valid:1;          //!< At least one imu sample seen
+    } status;
+    float pos[3];                      //!< Nominal position, m
+    float vel[3];                      //!< Nominal velocity, m/s
+    float q[4];                        //!< Body to local attitude quaternion, w,x,y,z
+    float ba[3];                       //!< Accelerometer bias, m/s^2
+    float bg[3];                       //!< Gyroscope bias, rad/s
+    float P[FUSION_NSTATES][FUSION_NSTATES]; //!< Error state covariance
+    uint32_t imu_timestamp;            //!< Cputime of last imu sample
+    uint32_t last_ticks;               //!< Cputime spent in the last update
+    uint32_t max_ticks;                //!< Max cputime spent in any update
+    float last_nis;                    //!< Last normalised innovation squared
+    uint16_t gated_run;                //!< Gated less accepted measurements
+    struct fusion_anchor anchors[MYNEWT_VAL(FUSION_MAX_ANCHORS)];
+};
+
+struct fusion_instance * fusion_init(struct fusion_instance * fusion, struct fusion_config * config);
+void fusion_free(struct fusion_instance * fusion);
+struct fusion_instance * fusion_get_instance(void);
+void fusion_reset(struct fusion_instance * fusion, triadf_t * pos, float pos_std);
+
+int fusion_set_anchor(struct fusion_instance * fusion, uint16_t addr, triadf_t * pos);
+int fusion_remove_anchor(struct fusion_instance * fusion, uint16_t addr);
+
+void fusion_propagate(struct fusion_instance * fusion, float acc[], float gyro[], float dt);
+void fusion_imu_update(struct fusion_instance * fusion, uint32_t timestamp, float acc[], float gyro[]);
+int fusion_range_update(struct fusion_instance * fusion, uint16_t addr, float range, float std);
+int fusion_tdoa_update(struct fusion_instance * fusion, uint16_t addr, uint16_t ref_addr, float tdoa, float std);
+
+#if MYNEWT_VAL(UWB_RNG_ENABLED)
+struct uwb_rng_instance;
+int fusion_rng_update(struct fusion_instance * fusion, struct uwb_rng_instance * rng);
+#endif
+#if MYNEWT_VAL(NRNG_ENABLED)
+struct nrng_instance;
+int fusion_nrng_update(struct fusion_instance * fusion, struct nrng_instance * nrng, uint16_t nranges, uint16_t base);
+#endif
+#if MYNEWT_VAL(RTDOA_ENABLED)
+struct rtdoa_instance;
+int fusion_rtdoa_update(struct fusion_instance * fusion, struct rtdoa_instance * rtdoa);
+#endif
+
+void fusion_get_position(struct fusion_instance * fusion, triadf_t * pos, triadf_t * variance);
+float fusion_get_position_std(struct fusion_instance * fusion);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FUSION_H_ */
@@ -0,0 +1,845 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file fusion.c
+ * @brief UWB/IMU error-state EKF tracker
+ *
+ * @details Error state ordering is position, velocity, attitude, accel bias
+ * and gyro bias, see FUSION_IDX_*. The attitude error is a small rotation in
+ * the body frame. Error dynamics:
+ *
+ *     d(dp)/dt  = dv
+ *     d(dv)/dt  = -R [f]x dtheta - R dba
+ *     d(dth)/dt = -[w]x dtheta - dbg
+ *
+ * The transition matrix F = I + A*dt is never formed, A is applied as a
+ * sparse operator to the columns and then the rows of P in place, which
+ * keeps the covariance propagation at a few thousand flops without any
+ * 15x15 scratch matrix on the stack. Range and TDoA measurements only
+ * depend on position so each is a scalar update with a 3 element H.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <os/os.h>
+#include <sysinit/sysinit.h>
+#include <stats/stats.h>
+#include <fusion/fusion.h>
+
+#if MYNEWT_VAL(UWB_RNG_ENABLED)
+#include <uwb_rng/uwb_rng.h>
+#endif
+#if MYNEWT_VAL(NRNG_ENABLED)
+#include <nrng/nrng.h>
+#endif
+#if MYNEWT_VAL(RTDOA_ENABLED)
+#include <rtdoa/rtdoa.h>
+#endif
+
+#if MYNEWT_VAL(FUSION_STATS)
+STATS_NAME_START(fusion_stat_section)
+    STATS_NAME(fusion_stat_section, imu_updates)
+    STATS_NAME(fusion_stat_section, range_updates)
+    STATS_NAME(fusion_stat_section, tdoa_updates)
+    STATS_NAME(fusion_stat_section, gated)
+    STATS_NAME(fusion_stat_section, unknown_anchor)
+    STATS_NAME(fusion_stat_section, dt_clamped)
+    STATS_NAME(fusion_stat_section, relock)
+STATS_NAME_END(fusion_stat_section)
+#endif
+
+#define FUSION_GRAVITY (9.80665f)
+
+static struct fusion_instance * g_fusion = NULL;
+
+static const struct fusion_config g_fusion_config_default = {
+    .acc_noise = 0.05f,
+    .gyro_noise = 0.005f,
+    .acc_bias_walk = 0.001f,
+    .gyro_bias_walk = 0.0001f,
+    .range_std = 0.10f,
+    .tdoa_std = 0.15f,
+    .init_pos_std = 10.0f,
+    .gate = MYNEWT_VAL(FUSION_GATE),
+};
+
+#if MYNEWT_VAL(FUSION_CLI)
+int fusion_cli_register(void);
+#endif
+
+static inline void
+cross3(const float a[], const float b[], float out[])
+{
+    out[0] = a[1]*b[2] - a[2]*b[1];
+    out[1] = a[2]*b[0] - a[0]*b[2];
+    out[2] = a[0]*b[1] - a[1]*b[0];
+}
+
+/**
+ * @fn quat_to_dcm(const float q[], float R[3][3])
+ * @brief Rotation matrix body to local from a unit quaternion w,x,y,z.
+ */
+static void
+quat_to_dcm(const float q[], float R[3][3])
+{
+    float w = q[0], x = q[1], y = q[2], z = q[3];
+
+    R[0][0] = 1.0f - 2.0f*(y*y + z*z);
+    R[0][1] = 2.0f*(x*y - w*z);
+    R[0][2] = 2.0f*(x*z + w*y);
+    R[1][0] = 2.0f*(x*y + w*z);
+    R[1][1] = 1.0f - 2.0f*(x*x + z*z);
+    R[1][2] = 2.0f*(y*z - w*x);
+    R[2][0] = 2.0f*(x*z - w*y);
+    R[2][1] = 2.0f*(y*z + w*x);
+    R[2][2] = 1.0f - 2.0f*(x*x + y*y);
+}
+
+/**
+ * @fn quat_rotate(float q[], const float theta[])
+ * @brief q = q (x) exp(theta/2), theta is a rotation vector in the body frame.
+ */
+static void
+quat_rotate(float q[], const float theta[])
+{
+    float dq[4], r[4], n;
+    float angle = sqrtf(theta[0]*theta[0] + theta[1]*theta[1] + theta[2]*theta[2]);
+
+    if (angle < 1e-6f) {
+        dq[0] = 1.0f;
+        dq[1] = 0.5f*theta[0];
+        dq[2] = 0.5f*theta[1];
+        dq[3] = 0.5f*theta[2];
+    } else {
+        float s = sinf(0.5f*angle)/angle;
+        dq[0] = cosf(0.5f*angle);
+        dq[1] = s*theta[0];
+        dq[2] = s*theta[1];
+        dq[3] = s*theta[2];
+    }
+
+    r[0] = q[0]*dq[0] - q[1]*dq[1] - q[2]*dq[2] - q[3]*dq[3];
+    r[1] = q[0]*dq[1] + q[1]*dq[0] + q[2]*dq[3] - q[3]*dq[2];
+    r[2] = q[0]*dq[2] - q[1]*dq[3] + q[2]*dq[0] + q[3]*dq[1];
+    r[3] = q[0]*dq[3] + q[1]*dq[2] - q[2]*dq[1] + q[3]*dq[0];
+
+    n = 1.0f/sqrtf(r[0]*r[0] + r[1]*r[1] + r[2]*r[2] + r[3]*r[3]);
+    q[0] = r[0]*n;
+    q[1] = r[1]*n;
+    q[2] = r[2]*n;
+    q[3] = r[3]*n;
+}
+
+/**
+ * @fn fusion_apply_A(float R[3][3], const float f[], const float w[], const float x[], float out[])
+ * @brief out = A*x for the continuous time error dynamics A, ~40 flops.
+ */
+static void
+fusion_apply_A(float R[3][3], const float f[], const float w[], const float x[], float out[])
+{
+    float c[3];
+    const float *dth = &x[FUSION_IDX_ATT];
+
+    /* dp' = dv */
+    out[0] = x[FUSION_IDX_VEL + 0];
+    out[1] = x[FUSION_IDX_VEL + 1];
+    out[2] = x[FUSION_IDX_VEL + 2];
+
+    /* dv' = -R (f x dth + dba) */
+    cross3(f, dth, c);
+    c[0] += x[FUSION_IDX_BA + 0];
+    c[1] += x[FUSION_IDX_BA + 1];
+    c[2] += x[FUSION_IDX_BA + 2];
+    for (int i = 0; i < 3; i++) {
+        out[FUSION_IDX_VEL + i] = -(R[i][0]*c[0] + R[i][1]*c[1] + R[i][2]*c[2]);
+    }
+
+    /* dth' = dth x w - dbg */
+    cross3(dth, w, c);
+    out[FUSION_IDX_ATT + 0] = c[0] - x[FUSION_IDX_BG + 0];
+    out[FUSION_IDX_ATT + 1] = c[1] - x[FUSION_IDX_BG + 1];
+    out[FUSION_IDX_ATT + 2] = c[2] - x[FUSION_IDX_BG + 2];
+
+    /* Biases are random walks */
+    memset(&out[FUSION_IDX_BA], 0, 6 * sizeof(float));
+}
+
+static void
+fusion_symmetrize(struct fusion_instance * fusion)
+{
+    for (int i = 0; i < FUSION_NSTATES; i++) {
+        for (int j = i + 1; j < FUSION_NSTATES; j++) {
+            float m = 0.5f*(fusion->P[i][j] + fusion->P[j][i]);
+            fusion->P[i][j] = fusion->P[j][i] = m;
+        }
+        if (fusion->P[i][i] < 1e-9f) {
+            fusion->P[i][i] = 1e-9f;
+        }
+    }
+}
+
+static void
+fusion_account(struct fusion_instance * fusion, uint32_t start)
+{
+    fusion->last_ticks = os_cputime_get32() - start;
+    if (fusion->last_ticks > fusion->max_ticks) {
+        fusion->max_ticks = fusion->last_ticks;
+    }
+}
+
+/**
+ * @fn fusion_init(struct fusion_instance * fusion, struct fusion_config * config)
+ * @brief Allocate and initialise a tracker instance.
+ *
+ * @param fusion  Pointer to struct fusion_instance, NULL to allocate.
+ * @param config  Noise parameters, NULL for defaults.
+ *
+ * @return struct fusion_instance *
+ */
+struct fusion_instance *
+fusion_init(struct fusion_instance * fusion, struct fusion_config * config)
+{
+    if (fusion == NULL) {
+        fusion = (struct fusion_instance *) malloc(sizeof(struct fusion_instance));
+        assert(fusion);
+        memset(fusion, 0, sizeof(struct fusion_instance));
+        fusion->status.selfmalloc = 1;
+    }
+    fusion->config = (config) ? *config : g_fusion_config_default;
+    memset(fusion->anchors, 0, sizeof(fusion->anchors));
+    fusion_reset(fusion, NULL, fusion->config.init_pos_std);
+
+#if MYNEWT_VAL(FUSION_STATS)
+    if (!fusion->status.initialized) {
+        int rc = stats_init(
+                    STATS_HDR(fusion->stat),
+                    STATS_SIZE_INIT_PARMS(fusion->stat, STATS_SIZE_32),
+                    STATS_NAME_INIT_PARMS(fusion_stat_section)
+            );
+        rc |= stats_register("fusion", STATS_HDR(fusion->stat));
+        assert(rc == 0);
+    }
+#endif
+    fusion->status.initialized = 1;
+    if (g_fusion == NULL) {
+        g_fusion = fusion;
+    }
+    return fusion;
+}
+
+/**
+ * @fn fusion_free(struct fusion_instance * fusion)
+ * @brief Free the resources of an instance.
+ *
+ * @param fusion  Pointer to struct fusion_instance.
+ *
+ * @return void
+ */
+void
+fusion_free(struct fusion_instance * fusion)
+{
+    assert(fusion);
+    if (g_fusion == fusion) {
+        g_fusion = NULL;
+    }
+    if (fusion->status.selfmalloc) {
+        free(fusion);
+    } else {
+        fusion->status.initialized = 0;
+    }
+}
+
+/**
+ * @fn fusion_get_instance(void)
+ * @brief First instance initialised, used by the cli.
+ *
+ * @return struct fusion_instance *, NULL if none.
+ */
+struct fusion_instance *
+fusion_get_instance(void)
+{
+    return g_fusion;
+}
+
+/**
+ * @fn fusion_reset(struct fusion_instance * fusion, triadf_t * pos, float pos_std)
+ * @brief Reset the nominal state and covariance, keeps the anchor table.
+ *
+ * @param fusion   Pointer to struct fusion_instance.
+ * @param pos      Initial position, NULL for the centroid of the known anchors.
+ * @param pos_std  Initial position std deviation, m.
+ *
+ * @return void
+ */
+void
+fusion_reset(struct fusion_instance * fusion, triadf_t * pos, float pos_std)
+{
+    int i, n = 0;
+
+    memset(fusion->pos, 0, sizeof(fusion->pos));
+    if (pos) {
+        fusion->pos[0] = pos->x;
+        fusion->pos[1] = pos->y;
+        fusion->pos[2] = pos->z;
+    } else {
+        for (i = 0; i < MYNEWT_VAL(FUSION_MAX_ANCHORS); i++) {
+            if (fusion->anchors[i].addr) {
+                fusion->pos[0] += fusion->anchors[i].pos.x;
+                fusion->pos[1] += fusion->anchors[i].pos.y;
+                fusion->pos[2] += fusion->anchors[i].pos.z;
+                n++;
+            }
+        }
+        if (n) {
+            fusion->pos[0] /= n;
+            fusion->pos[1] /= n;
+            fusion->pos[2] /= n;
+        }
+    }
+    memset(fusion->vel, 0, sizeof(fusion->vel));
+    memset(fusion->ba, 0, sizeof(fusion->ba));
+    memset(fusion->bg, 0, sizeof(fusion->bg));
+    fusion->q[0] = 1.0f;
+    fusion->q[1] = fusion->q[2] = fusion->q[3] = 0.0f;
+    fusion->status.imu_valid = 0;
+
+    memset(fusion->P, 0, sizeof(fusion->P));
+    for (i = 0; i < 3; i++) {
+        fusion->P[FUSION_IDX_POS + i][FUSION_IDX_POS + i] = pos_std * pos_std;
+        fusion->P[FUSION_IDX_VEL + i][FUSION_IDX_VEL + i] = 1.0f;
+        fusion->P[FUSION_IDX_ATT + i][FUSION_IDX_ATT + i] = (i < 2) ? 0.01f : 1.0f;
+        fusion->P[FUSION_IDX_BA + i][FUSION_IDX_BA + i] = 0.04f;
+        fusion->P[FUSION_IDX_BG + i][FUSION_IDX_BG + i] = 1e-4f;
+    }
+    fusion->last_nis = 0;
+    fusion->gated_run = 0;
+}
+
+/**
+ * @fn fusion_set_anchor(struct fusion_instance * fusion, uint16_t addr, triadf_t * pos)
+ * @brief Add or move an anchor.
+ *
+ * @param fusion  Pointer to struct fusion_instance.
+ * @param addr    Anchor short address.
+ * @param pos     Anchor position, m.
+ *
+ * @return OS_OK, OS_EINVAL or OS_ENOMEM if the table is full.
+ */
+int
+fusion_set_anchor(struct fusion_instance * fusion, uint16_t addr, triadf_t * pos)
+{
+    struct fusion_anchor * free_entry = NULL;
+
+    if (!addr || !pos) {
+        return OS_EINVAL;
+    }
+    for (int i = 0; i < MYNEWT_VAL(FUSION_MAX_ANCHORS); i++) {
+        if (fusion->anchors[i].addr == addr) {
+            fusion->anchors[i].pos = *pos;
+            return OS_OK;
+        }
+        if (!fusion->anchors[i].addr && !free_entry) {
+            free_entry = &fusion->anchors[i];
+        }
+    }
+    if (!free_entry) {
+        return OS_ENOMEM;
+    }
+    free_entry->addr = addr;
+    free_entry->pos = *pos;
+    return OS_OK;
+}
+
+/**
+ * @fn fusion_remove_anchor(struct fusion_instance * fusion, uint16_t addr)
+ * @brief Remove an anchor.
+ *
+ * @return OS_OK or OS_ENOENT.
+ */
+int
+fusion_remove_anchor(struct fusion_instance * fusion, uint16_t addr)
+{
+    for (int i = 0; i < MYNEWT_VAL(FUSION_MAX_ANCHORS); i++) {
+        if (addr && fusion->anchors[i].addr == addr) {
+            fusion->anchors[i].addr = 0;
+            return OS_OK;
+        }
+    }
+    return OS_ENOENT;
+}
+
+static struct fusion_anchor *
+fusion_find_anchor(struct fusion_instance * fusion, uint16_t addr)
+{
+    for (int i = 0; i < MYNEWT_VAL(FUSION_MAX_ANCHORS); i++) {
+        if (addr && fusion->anchors[i].addr == addr) {
+            return &fusion->anchors[i];
+        }
+    }
+    FUSION_STATS_INC(unknown_anchor);
+    return NULL;
+}
+
+/**
+ * @fn fusion_propagate(struct fusion_instance * fusion, float acc[], float gyro[], float dt)
+ * @brief Propagate nominal state and covariance with one imu sample.
+ *
+ * @param fusion  Pointer to struct fusion_instance.
+ * @param acc     Specific force in the body frame, m/s^2.
+ * @param gyro    Angular rate in the body frame, rad/s.
+ * @param dt      Time step, s.
+ *
+ * @return void
+ */
+void
+fusion_propagate(struct fusion_instance * fusion, float acc[], float gyro[], float dt)
+{
+    float R[3][3];
+    float f[3], w[3], a[3], theta[3];
+    float col[FUSION_NSTATES], Acol[FUSION_NSTATES];
+    int i, j;
+
+    for (i = 0; i < 3; i++) {
+        f[i] = acc[i] - fusion->ba[i];
+        w[i] = gyro[i] - fusion->bg[i];
+    }
+    quat_to_dcm(fusion->q, R);
+
+    /* Covariance, P = (I + A dt) P (I + A dt)' + Q, columns then rows */
+    for (j = 0; j < FUSION_NSTATES; j++) {
+        for (i = 0; i < FUSION_NSTATES; i++) {
+            col[i] = fusion->P[i][j];
+        }
+        fusion_apply_A(R, f, w, col, Acol);
+        for (i = 0; i < FUSION_NSTATES; i++) {
+            fusion->P[i][j] = col[i] + dt * Acol[i];
+        }
+    }
+    for (i = 0; i < FUSION_NSTATES; i++) {
+        fusion_apply_A(R, f, w, fusion->P[i], Acol);
+        for (j = 0; j < FUSION_NSTATES; j++) {
+            fusion->P[i][j] += dt * Acol[j];
+        }
+    }
+    for (i = 0; i < 3; i++) {
+        fusion->P[FUSION_IDX_VEL + i][FUSION_IDX_VEL + i] +=
+            fusion->config.acc_noise * fusion->config.acc_noise * dt;
+        fusion->P[FUSION_IDX_ATT + i][FUSION_IDX_ATT + i] +=
+            fusion->config.gyro_noise * fusion->config.gyro_noise * dt;
+        fusion->P[FUSION_IDX_BA + i][FUSION_IDX_BA + i] +=
+            fusion->config.acc_bias_walk * fusion->config.acc_bias_walk * dt;
+        fusion->P[FUSION_IDX_BG + i][FUSION_IDX_BG + i] +=
+            fusion->config.gyro_bias_walk * fusion->config.gyro_bias_walk * dt;
+    }
+
+    /* Nominal state */
+    for (i = 0; i < 3; i++) {
+        a[i] = R[i][0]*f[0] + R[i][1]*f[1] + R[i][2]*f[2];
+    }
+    a[2] -= FUSION_GRAVITY;
+    for (i = 0; i < 3; i++) {
+        fusion->pos[i] += fusion->vel[i] * dt + 0.5f * a[i] * dt * dt;
+        fusion->vel[i] += a[i] * dt;
+        theta[i] = w[i] * dt;
+    }
+    quat_rotate(fusion->q, theta);
+}
+
+/**
+ * @fn fusion_align(struct fusion_instance * fusion, float acc[])
+ * @brief Coarse roll and pitch from the gravity vector, yaw is left at zero.
+ */
+static void
+fusion_align(struct fusion_instance * fusion, float acc[])
+{
+    float roll = atan2f(acc[1], acc[2]);
+    float pitch = atan2f(-acc[0], sqrtf(acc[1]*acc[1] + acc[2]*acc[2]));
+    float cr = cosf(0.5f*roll), sr = sinf(0.5f*roll);
+    float cp = cosf(0.5f*pitch), sp = sinf(0.5f*pitch);
+
+    fusion->q[0] = cr*cp;
+    fusion->q[1] = sr*cp;
+    fusion->q[2] = cr*sp;
+    fusion->q[3] = -sr*sp;
+}
+
+/**
+ * @fn fusion_imu_update(struct fusion_instance * fusion, uint32_t timestamp, float acc[], float gyro[])
+ * @brief Propagate with a timestamped imu sample, e.g. from an imu fifo batch.
+ * The first sample only aligns roll and pitch.
+ *
+ * @param fusion     Pointer to struct fusion_instance.
+ * @param timestamp  Sample time, os_cputime ticks.
+ * @param acc        Specific force in the body frame, m/s^2.
+ * @param gyro       Angular rate in the body frame, rad/s.
+ *
+ * @return void
+ */
+void
+fusion_imu_update(struct fusion_instance * fusion, uint32_t timestamp, float acc[], float gyro[])
+{
+    uint32_t start = os_cputime_get32();
+    uint32_t usecs;
+
+    if (!fusion->status.imu_valid) {
+        fusion_align(fusion, acc);
+        fusion->status.imu_valid = 1;
+        fusion->imu_timestamp = timestamp;
+        return;
+    }
+
+    usecs = os_cputime_ticks_to_usecs(timestamp - fusion->imu_timestamp);
+    fusion->imu_timestamp = timestamp;
+    if (usecs > MYNEWT_VAL(FUSION_MAX_DT)) {
+        usecs = MYNEWT_VAL(FUSION_MAX_DT);
+        FUSION_STATS_INC(dt_clamped);
+    }
+    fusion_propagate(fusion, acc, gyro, usecs * 1e-6f);
+    FUSION_STATS_INC(imu_updates);
+    fusion_account(fusion, start);
+}
+
+/**
+ * @fn fusion_scalar_update(struct fusion_instance * fusion, const float h[], float y, float r)
+ * @brief Scalar measurement update for a measurement depending on position only.
+ *
+ * @param fusion  Pointer to struct fusion_instance.
+ * @param h       Measurement jacobian wrt position.
+ * @param y       Innovation, measured - predicted.
+ * @param r       Measurement variance.
+ *
+ * @return OS_OK, OS_ERROR if gated.
+ */
+static int
+fusion_scalar_update(struct fusion_instance * fusion, const float h[], float y, float r)
+{
+    float PH[FUSION_NSTATES], dx[FUSION_NSTATES];
+    float S, K;
+    int i, j, n;
+
+    for (i = 0; i < FUSION_NSTATES; i++) {
+        PH[i] = fusion->P[i][0]*h[0] + fusion->P[i][1]*h[1] + fusion->P[i][2]*h[2];
+    }
+    S = h[0]*PH[0] + h[1]*PH[1] + h[2]*PH[2] + r;
+
+    fusion->last_nis = y * y / S;
+    if (fusion->last_nis > fusion->config.gate) {
+        FUSION_STATS_INC(gated);
+        /* Rejections outnumbering acceptances means the filter, not the
+         * measurements, is wrong. Anchors roughly equidistant from the true
+         * and the estimated position keep passing the gate, so they only
+         * slow this down rather than reset it. Start over from the anchor
+         * centroid */
+        if (++fusion->gated_run > MYNEWT_VAL(FUSION_GATE_RELOCK)) {
+            FUSION_STATS_INC(relock);
+            fusion_reset(fusion, NULL, fusion->config.init_pos_std);
+        }
+        return OS_ERROR;
+    }
+    if (fusion->gated_run) {
+        fusion->gated_run--;
+    }
+
+    /* Until the position has converged the linearisation is too poor to
+     * let ranges pull on attitude and biases, those are then
+     * only considered (Schmidt update) and keep their estimates */
+    n = (fusion_get_position_std(fusion) > MYNEWT_VAL(FUSION_ACQUIRE_STD)) ? FUSION_IDX_ATT : FUSION_NSTATES;
+    memset(dx, 0, sizeof(dx));
+    for (i = 0; i < n; i++) {
+        K = PH[i] / S;
+        dx[i] = K * y;
+        for (j = 0; j < FUSION_NSTATES; j++) {
+            fusion->P[i][j] -= K * PH[j];
+        }
+        for (j = n; j < FUSION_NSTATES; j++) {
+            fusion->P[j][i] = fusion->P[i][j];
+        }
+    }
+    fusion_symmetrize(fusion);
+
+    /* Inject the error state into the nominal state, reset is identity */
+    for (i = 0; i < 3; i++) {
+        fusion->pos[i] += dx[FUSION_IDX_POS + i];
+        fusion->vel[i] += dx[FUSION_IDX_VEL + i];
+        fusion->ba[i] += dx[FUSION_IDX_BA + i];
+        fusion->bg[i] += dx[FUSION_IDX_BG + i];
+    }
+    quat_rotate(fusion->q, &dx[FUSION_IDX_ATT]);
+    return OS_OK;
+}
+
+static float
+fusion_los(struct fusion_instance * fusion, struct fusion_anchor * anchor, float u[])
+{
+    float d;
+
+    u[0] = fusion->pos[0] - anchor->pos.x;
+    u[1] = fusion->pos[1] - anchor->pos.y;
+    u[2] = fusion->pos[2] - anchor->pos.z;
+    d = sqrtf(u[0]*u[0] + u[1]*u[1] + u[2]*u[2]);
+    if (d > 1e-3f) {
+        u[0] /= d;
+        u[1] /= d;
+        u[2] /= d;
+    } else {
+        u[0] = u[1] = u[2] = 0;
+    }
+    return d;
+}
+
+/**
+ * @fn fusion_range_update(struct fusion_instance * fusion, uint16_t addr, float range, float std)
+ * @brief Correct with a TWR range to a known anchor.
+ *
+ * @param fusion  Pointer to struct fusion_instance.
+ * @param addr    Anchor short address.
+ * @param range   Measured range, m.
+ * @param std     Range std deviation, m. 0 for the configured default.
+ *
+ * @return OS_OK, OS_ENOENT for an unknown anchor, OS_ERROR if gated as outlier.
+ */
+int
+fusion_range_update(struct fusion_instance * fusion, uint16_t addr, float range, float std)
+{
+    uint32_t start = os_cputime_get32();
+    struct fusion_anchor * anchor;
+    float u[3], d;
+    int rc;
+
+    if (isnan(range)) {
+        return OS_EINVAL;
+    }
+    anchor = fusion_find_anchor(fusion, addr);
+    if (!anchor) {
+        return OS_ENOENT;
+    }
+    if (std <= 0) {
+        std = fusion->config.range_std;
+    }
+
+    d = fusion_los(fusion, anchor, u);
+    rc = fusion_scalar_update(fusion, u, range - d, std * std);
+    if (rc == OS_OK) {
+        FUSION_STATS_INC(range_updates);
+    }
+    fusion_account(fusion, start);
+    return rc;
+}
+
+/**
+ * @fn fusion_tdoa_update(struct fusion_instance * fusion, uint16_t addr, uint16_t ref_addr, float tdoa, float std)
+ * @brief Correct with a TDoA, tdoa = |p - anchor| - |p - ref_anchor|.
+ *
+ * @param fusion    Pointer to struct fusion_instance.
+ * @param addr      Anchor short address.
+ * @param ref_addr  Reference anchor short address.
+ * @param tdoa      Measured range difference, m.
+ * @param std       TDoA std deviation, m. 0 for the configured default.
+ *
+ * @return OS_OK, OS_ENOENT for an unknown anchor, OS_ERROR if gated as outlier.
+ */
+int
+fusion_tdoa_update(struct fusion_instance * fusion, uint16_t addr, uint16_t ref_addr, float tdoa, float std)
+{
+    uint32_t start = os_cputime_get32();
+    struct fusion_anchor * anchor, * ref;
+    float u[3], uref[3], h[3], d;
+    int rc;
+
+    if (isnan(tdoa)) {
+        return OS_EINVAL;
+    }
+    anchor = fusion_find_anchor(fusion, addr);
+    ref = fusion_find_anchor(fusion, ref_addr);
+    if (!anchor || !ref) {
+        return OS_ENOENT;
+    }
+    if (std <= 0) {
+        std = fusion->config.tdoa_std;
+    }
+
+    d = fusion_los(fusion, anchor, u) - fusion_los(fusion, ref, uref);
+    h[0] = u[0] - uref[0];
+    h[1] = u[1] - uref[1];
+    h[2] = u[2] - uref[2];
+    rc = fusion_scalar_update(fusion, h, tdoa - d, std * std);
+    if (rc == OS_OK) {
+        FUSION_STATS_INC(tdoa_updates);
+    }
+    fusion_account(fusion, start);
+    return rc;
+}
+
+#if MYNEWT_VAL(UWB_RNG_ENABLED)
+/**
+ * @fn fusion_rng_update(struct fusion_instance * fusion, struct uwb_rng_instance * rng)
+ * @brief Correct with the last completed TWR, call from the rng complete callback
+ * or event. Weighted by the quality record of the range with RNG_QUALITY.
+ *
+ * @param fusion  Pointer to struct fusion_instance.
+ * @param rng     Pointer to struct uwb_rng_instance.
+ *
+ * @return see fusion_range_update
+ */
+int
+fusion_rng_update(struct fusion_instance * fusion, struct uwb_rng_instance * rng)
+{
+    twr_frame_t * frame = rng->frames[rng->idx_current];
+    uint16_t peer;
+    float range;
+
+    peer = (frame->src_address == rng->dev_inst->my_short_address) ?
+        frame->dst_address : frame->src_address;
+    range = uwb_rng_tof_to_meters(uwb_rng_twr_to_tof(rng, rng->idx_current));
+#if MYNEWT_VAL(RNG_QUALITY)
+    struct uwb_rng_quality quality;
+    uwb_rng_get_quality(rng, rng->idx_current, &quality);
+    return fusion_range_update(fusion, peer, range, quality.stdev);
+#else
+    return fusion_range_update(fusion, peer, range, 0);
+#endif
+}
+#endif
+
+#if MYNEWT_VAL(NRNG_ENABLED)
+/**
+ * @fn fusion_nrng_update(struct fusion_instance * fusion, struct nrng_instance * nrng, uint16_t nranges, uint16_t base)
+ * @brief Correct with every valid response of the last nrng request, same
+ * selection as nrng_get_ranges but keyed on the responder address. Weighted by
+ * the quality of each response with RNG_QUALITY.
+ *
+ * @param fusion   Pointer to struct fusion_instance.
+ * @param nrng     Pointer to struct nrng_instance.
+ * @param nranges  Number of slots requested.
+ * @param base     Index of the first frame.
+ *
+ * @return Number of ranges applied.
+ */
+int
+fusion_nrng_update(struct fusion_instance * fusion, struct nrng_instance * nrng, uint16_t nranges, uint16_t base)
+{
+    int applied = 0;
+
+    for (uint16_t i = 0; i < nranges; i++) {
+        if (!(nrng->slot_mask & 1UL << i)) {
+            continue;
+        }
+        uint16_t idx = BitIndex(nrng->slot_mask, 1UL << i, SLOT_POSITION);
+        nrng_frame_t * frame = nrng->frames[(base + idx)%nrng->nframes];
+        if (frame->code != DWT_SS_TWR_NRNG_FINAL || frame->seq_num != nrng->seq_num) {
+            continue;
+        }
+        float range = uwb_rng_tof_to_meters(nrng_twr_to_tof_frames(nrng->dev_inst, frame, frame));
+        float std = 0;
+#if MYNEWT_VAL(RNG_QUALITY)
+        struct uwb_rng_quality quality = {.skew = NAN, .residual = NAN};
+        struct uwb_dev * inst = nrng->dev_inst;
+        uwb_rng_quality_calc(inst, (inst->config.rxdiag_enable && frame->diag.rxd_len) ? &frame->diag : NULL, &quality);
+        std = quality.stdev;
+#endif
+        if (fusion_range_update(fusion, frame->src_address, range, std) == OS_OK) {
+            applied++;
+        }
+    }
+    return applied;
+}
+#endif
+
+#if MYNEWT_VAL(RTDOA_ENABLED)
+/**
+ * @fn fusion_rtdoa_update(struct fusion_instance * fusion, struct rtdoa_instance * rtdoa)
+ * @brief Correct with the TDoAs of all responses to the current rtdoa request.
+ * Responses are consumed by rtdoa_tdoa_between_frames.
+ *
+ * @param fusion  Pointer to struct fusion_instance.
+ * @param rtdoa   Pointer to struct rtdoa_instance.
+ *
+ * @return Number of tdoas applied.
+ */
+int
+fusion_rtdoa_update(struct fusion_instance * fusion, struct rtdoa_instance * rtdoa)
+{
+    int applied = 0;
+
+    if (rtdoa->req_frame == NULL) {
+        return 0;
+    }
+    for (uint16_t i = 0; i < rtdoa->nframes; i++) {
+        rtdoa_frame_t * frame = rtdoa->frames[i];
+        if (frame->code != DWT_RTDOA_RESP) {
+            continue;
+        }
+        uint16_t addr = frame->src_address;
+        float tdoa = rtdoa_tdoa_between_frames(rtdoa, rtdoa->req_frame, frame);
+        if (fusion_tdoa_update(fusion, addr, rtdoa->req_frame->src_address, tdoa, 0) == OS_OK) {
+            applied++;
+        }
+    }
+    return applied;
+}
+#endif
+
+/**
+ * @fn fusion_get_position(struct fusion_instance * fusion, triadf_t * pos, triadf_t * variance)
+ * @brief Current position estimate.
+ *
+ * @param fusion    Pointer to struct fusion_instance.
+ * @param pos       Position, m.
+ * @param variance  Position variance, m^2, may be NULL.
+ *
+ * @return void
+ */
+void
+fusion_get_position(struct fusion_instance * fusion, triadf_t * pos, triadf_t * variance)
+{
+    pos->x = fusion->pos[0];
+    pos->y = fusion->pos[1];
+    pos->z = fusion->pos[2];
+    if (variance) {
+        variance->x = fusion->P[0][0];
+        variance->y = fusion->P[1][1];
+        variance->z = fusion->P[2][2];
+    }
+}
+
+/**
+ * @fn fusion_get_position_std(struct fusion_instance * fusion)
+ * @brief Root of the trace of the position covariance, m.
+ */
+float
+fusion_get_position_std(struct fusion_instance * fusion)
+{
+    return sqrtf(fusion->P[0][0] + fusion->P[1][1] + fusion->P[2][2]);
+}
+
+void
+fusion_pkg_init(void)
+{
+#if MYNEWT_VAL(FUSION_VERBOSE)
+    printf("{\"utime\": %lu,\"msg\": \"fusion_pkg_init\"}\n", os_cputime_ticks_to_usecs(os_cputime_get32()));
+#endif
+#if MYNEWT_VAL(FUSION_CLI)
+    int rc = fusion_cli_register();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+}
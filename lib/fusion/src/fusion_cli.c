@@ -0,0 +1,150 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <os/os.h>
+#include <syscfg/syscfg.h>
+
+#if MYNEWT_VAL(FUSION_CLI)
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <shell/shell.h>
+#include <console/console.h>
+
+#include "fusion/fusion.h"
+
+static int fusion_cli_cmd(int argc, char **argv);
+
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+const struct shell_param cmd_fusion_param[] = {
+    {"state", "position, velocity and update cost"},
+    {"anchors", "list anchors"},
+    {"anchor", "<addr> <x> <y> <z> set anchor position, m"},
+    {"reset", "[<x> <y> <z>] restart tracker"},
+    {NULL,NULL},
+};
+
+const struct shell_cmd_help cmd_fusion_help = {
+	"fusion", "<cmd>", cmd_fusion_param
+};
+#endif
+
+static struct shell_cmd shell_fusion_cmd = {
+    .sc_cmd = "fusion",
+    .sc_cmd_func = fusion_cli_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+    .help = &cmd_fusion_help
+#endif
+};
+
+static void
+print_float(float v)
+{
+    console_printf("%s%d.%03d", (v < 0) ? "-" : "", (int)fabsf(v),
+                   (int)((fabsf(v) - (int)fabsf(v))*1000));
+}
+
+static void
+print_triad(const char *name, float v[])
+{
+    console_printf("%s: ", name);
+    for (int i = 0; i < 3; i++) {
+        print_float(v[i]);
+        console_printf((i < 2) ? ", " : "\n");
+    }
+}
+
+static void
+fusion_cli_state(struct fusion_instance * fusion)
+{
+    print_triad("pos", fusion->pos);
+    print_triad("vel", fusion->vel);
+    print_triad("ba ", fusion->ba);
+    print_triad("bg ", fusion->bg);
+    console_printf("pos_std: ");
+    print_float(fusion_get_position_std(fusion));
+    console_printf(", nis: ");
+    print_float(fusion->last_nis);
+    console_printf("\nupdate_usec: %lu, max_usec: %lu\n",
+                   os_cputime_ticks_to_usecs(fusion->last_ticks),
+                   os_cputime_ticks_to_usecs(fusion->max_ticks));
+}
+
+static void
+fusion_cli_anchors(struct fusion_instance * fusion)
+{
+    console_printf("#idx, addr, x, y, z\n");
+    for (int i = 0; i < MYNEWT_VAL(FUSION_MAX_ANCHORS); i++) {
+        if (!fusion->anchors[i].addr) {
+            continue;
+        }
+        console_printf("%4d, %4x, ", i, fusion->anchors[i].addr);
+        print_triad("", fusion->anchors[i].pos.array);
+    }
+}
+
+static int
+fusion_cli_cmd(int argc, char **argv)
+{
+    struct fusion_instance * fusion = fusion_get_instance();
+    triadf_t pos;
+
+    if (argc < 2) {
+        return 0;
+    }
+    if (fusion == NULL) {
+        console_printf("No fusion instance\n");
+        return 0;
+    }
+
+    if (!strcmp(argv[1], "state")) {
+        fusion_cli_state(fusion);
+    } else if (!strcmp(argv[1], "anchors")) {
+        fusion_cli_anchors(fusion);
+    } else if (!strcmp(argv[1], "anchor") && argc > 5) {
+        pos.x = strtof(argv[3], NULL);
+        pos.y = strtof(argv[4], NULL);
+        pos.z = strtof(argv[5], NULL);
+        if (fusion_set_anchor(fusion, strtol(argv[2], NULL, 0), &pos) != OS_OK) {
+            console_printf("Failed\n");
+        }
+    } else if (!strcmp(argv[1], "reset")) {
+        if (argc > 4) {
+            pos.x = strtof(argv[2], NULL);
+            pos.y = strtof(argv[3], NULL);
+            pos.z = strtof(argv[4], NULL);
+            fusion_reset(fusion, &pos, fusion->config.range_std);
+        } else {
+            fusion_reset(fusion, NULL, fusion->config.init_pos_std);
+        }
+        fusion->max_ticks = 0;
+    } else {
+        console_printf("Unknown cmd\n");
+    }
+    return 0;
+}
+
+int
+fusion_cli_register(void)
+{
+    return shell_cmd_register(&shell_fusion_cmd);
+}
+#endif /* MYNEWT_VAL(FUSION_CLI) */
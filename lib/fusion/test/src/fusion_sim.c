@@ -0,0 +1,149 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "fusion_test.h"
+
+#define FUSION_TEST_GRAVITY (9.80665f)
+#define FUSION_TEST_IMU_HZ (100)
+#define FUSION_TEST_RNG_DIV (10)
+
+/* Room of 10x10m, anchors alternating between floor and ceiling so z is
+ * observable */
+static const float g_anchor_pos[FUSION_TEST_NANCHORS][3] = {
+    {0.0f, 0.0f, 2.8f},
+    {10.0f, 0.0f, 0.3f},
+    {10.0f, 10.0f, 2.8f},
+    {0.0f, 10.0f, 0.3f},
+    {5.0f, 0.0f, 0.3f},
+    {5.0f, 10.0f, 2.8f},
+};
+
+static uint32_t g_seed = 1;
+
+void
+fusion_test_seed(uint32_t seed)
+{
+    g_seed = (seed) ? seed : 1;
+}
+
+static float
+randu(void)
+{
+    g_seed ^= g_seed << 13;
+    g_seed ^= g_seed >> 17;
+    g_seed ^= g_seed << 5;
+    return (g_seed >> 8) * (1.0f / 16777216.0f);
+}
+
+float
+fusion_test_randn(void)
+{
+    float u = randu();
+
+    while (u < 1e-7f) {
+        u = randu();
+    }
+    return sqrtf(-2.0f * logf(u)) * cosf(2.0f * (float)M_PI * randu());
+}
+
+/**
+ * Initialise the tracker with default noise parameters and the anchor set.
+ */
+void
+fusion_test_setup(struct fusion_instance * fusion)
+{
+    triadf_t pos;
+    int i, rc;
+
+    memset(fusion, 0, sizeof(*fusion));
+    TEST_ASSERT_FATAL(fusion_init(fusion, NULL) == fusion);
+    for (i = 0; i < FUSION_TEST_NANCHORS; i++) {
+        pos.x = g_anchor_pos[i][0];
+        pos.y = g_anchor_pos[i][1];
+        pos.z = g_anchor_pos[i][2];
+        rc = fusion_set_anchor(fusion, 0x1000 + i, &pos);
+        TEST_ASSERT_FATAL(rc == OS_OK);
+    }
+}
+
+static float
+dist3(const float a[], const float b[])
+{
+    float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+    return sqrtf(dx*dx + dy*dy + dz*dz);
+}
+
+/**
+ * Feed the tracker with a synthetic trace. The imu sees the true specific
+ * force and no rotation, each tenth imu sample one anchor is ranged.
+ */
+void
+fusion_test_run(struct fusion_instance * fusion, struct fusion_test_run * run)
+{
+    struct fusion_test_truth truth;
+    float acc[3], gyro[3] = {0};
+    float range, err, sum = 0, t;
+    triadf_t est;
+    uint32_t k, nerr = 0;
+    uint32_t steps = (uint32_t)((run->t1 - run->t0) * FUSION_TEST_IMU_HZ + 0.5f);
+    bool outlier;
+    int a = 0, rc;
+
+    run->max = 0;
+    for (k = 0; k <= steps; k++) {
+        t = run->t0 + (float)k / FUSION_TEST_IMU_HZ;
+        run->traj(t, &truth);
+
+        acc[0] = truth.acc[0];
+        acc[1] = truth.acc[1];
+        acc[2] = truth.acc[2] + FUSION_TEST_GRAVITY;
+        fusion_imu_update(fusion, os_cputime_usecs_to_ticks((uint32_t)(t * 1e6f)), acc, gyro);
+
+        if (k % FUSION_TEST_RNG_DIV) {
+            continue;
+        }
+        range = dist3(truth.pos, g_anchor_pos[a]) + run->range_std * fusion_test_randn();
+        outlier = randu() < run->outlier_rate;
+        if (outlier) {
+            range += run->outlier;
+        }
+        rc = fusion_range_update(fusion, 0x1000 + a, range, run->range_std);
+        TEST_ASSERT(rc == OS_OK || rc == OS_ERROR, "rc %d", rc);
+        a = (a + 1) % FUSION_TEST_NANCHORS;
+
+        run->ranges++;
+        run->outliers += outlier;
+        if (rc == OS_ERROR) {
+            run->outliers_gated += outlier;
+            run->good_gated += !outlier;
+        }
+
+        fusion_get_position(fusion, &est, NULL);
+        err = dist3(truth.pos, est.array);
+        run->last = err;
+        if (t - run->t0 >= run->settle) {
+            sum += err * err;
+            nerr++;
+            if (err > run->max) {
+                run->max = err;
+            }
+        }
+    }
+    run->rms = (nerr) ? sqrtf(sum / nerr) : 0;
+}
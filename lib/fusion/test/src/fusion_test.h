@@ -0,0 +1,78 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _FUSION_TEST_H
+#define _FUSION_TEST_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "testutil/testutil.h"
+
+#include "fusion/fusion.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! True motion at one instant, level body frame aligned with the local frame
+struct fusion_test_truth {
+    float pos[3];
+    float vel[3];
+    float acc[3];
+};
+
+typedef void (*fusion_test_traj_t)(float t, struct fusion_test_truth * truth);
+
+//! One simulated run, 100Hz imu and 10Hz round robin TWR
+struct fusion_test_run {
+    fusion_test_traj_t traj;
+    float t0;                          //!< Start time, s
+    float t1;                          //!< End time, s
+    float settle;                      //!< Errors are collected from t0 + settle, s
+    float range_std;                   //!< Range noise, m
+    float outlier_rate;                //!< Fraction of ranges with an outlier
+    float outlier;                     //!< Outlier size, m
+    /* Results */
+    float rms;                         //!< RMS position error after settling, m
+    float max;                         //!< Max position error after settling, m
+    float last;                        //!< Position error at t1, m
+    uint32_t ranges;
+    uint32_t outliers;
+    uint32_t outliers_gated;
+    uint32_t good_gated;
+};
+
+#define FUSION_TEST_NANCHORS (6)
+
+void fusion_test_setup(struct fusion_instance * fusion);
+float fusion_test_randn(void);
+void fusion_test_seed(uint32_t seed);
+void fusion_test_run(struct fusion_instance * fusion, struct fusion_test_run * run);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,49 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fusion_test.h"
+
+TEST_CASE(fusion_anchor_test)
+{
+    struct fusion_instance fusion;
+    triadf_t pos = {{1.0f, 2.0f, 3.0f}};
+    int i, rc;
+
+    memset(&fusion, 0, sizeof(fusion));
+    TEST_ASSERT_FATAL(fusion_init(&fusion, NULL) == &fusion);
+
+    TEST_ASSERT(fusion_set_anchor(&fusion, 0, &pos) == OS_EINVAL);
+    for (i = 0; i < MYNEWT_VAL(FUSION_MAX_ANCHORS); i++) {
+        rc = fusion_set_anchor(&fusion, 0x100 + i, &pos);
+        TEST_ASSERT_FATAL(rc == OS_OK);
+    }
+    TEST_ASSERT(fusion_set_anchor(&fusion, 0x200, &pos) == OS_ENOMEM);
+
+    /* Moving a known anchor needs no free entry */
+    pos.x = 4.0f;
+    TEST_ASSERT(fusion_set_anchor(&fusion, 0x100, &pos) == OS_OK);
+    TEST_ASSERT(fusion_remove_anchor(&fusion, 0x101) == OS_OK);
+    TEST_ASSERT(fusion_remove_anchor(&fusion, 0x101) == OS_ENOENT);
+    TEST_ASSERT(fusion_set_anchor(&fusion, 0x200, &pos) == OS_OK);
+
+    TEST_ASSERT(fusion_range_update(&fusion, 0x101, 1.0f, 0) == OS_ENOENT);
+    TEST_ASSERT(fusion_range_update(&fusion, 0x100, NAN, 0) == OS_EINVAL);
+    TEST_ASSERT(fusion_tdoa_update(&fusion, 0x100, 0x101, 1.0f, 0) == OS_ENOENT);
+
+    fusion_free(&fusion);
+}
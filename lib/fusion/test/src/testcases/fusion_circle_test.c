@@ -0,0 +1,79 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fusion_test.h"
+
+#define CIRCLE_R      (3.0f)
+#define CIRCLE_PERIOD (20.0f)
+
+static void
+traj_circle(float t, struct fusion_test_truth * truth)
+{
+    float w = 2.0f * (float)M_PI / CIRCLE_PERIOD;
+    float c = cosf(w * t), s = sinf(w * t);
+
+    truth->pos[0] = 5.0f + CIRCLE_R * c;
+    truth->pos[1] = 5.0f + CIRCLE_R * s;
+    truth->pos[2] = 1.2f;
+    truth->vel[0] = -CIRCLE_R * w * s;
+    truth->vel[1] = CIRCLE_R * w * c;
+    truth->vel[2] = 0.0f;
+    truth->acc[0] = -CIRCLE_R * w * w * c;
+    truth->acc[1] = -CIRCLE_R * w * w * s;
+    truth->acc[2] = 0.0f;
+}
+
+/* Circular trajectory from a reasonable initial fix, with 5m outliers */
+TEST_CASE(fusion_circle_test)
+{
+    struct fusion_instance fusion;
+    struct fusion_test_truth truth;
+    triadf_t pos;
+    struct fusion_test_run run = {
+        .traj = traj_circle,
+        .t0 = 0.0f,
+        .t1 = 60.0f,
+        .settle = 20.0f,
+        .range_std = 0.10f,
+        .outlier_rate = 0.05f,
+        .outlier = 5.0f,
+    };
+
+    fusion_test_seed(0x9e3779b9);
+    fusion_test_setup(&fusion);
+    traj_circle(0.0f, &truth);
+    pos.x = truth.pos[0] + 0.3f;
+    pos.y = truth.pos[1] - 0.3f;
+    pos.z = truth.pos[2];
+    fusion_reset(&fusion, &pos, 0.5f);
+
+    fusion_test_run(&fusion, &run);
+    printf("circle: rms %.3f max %.3f outliers %lu/%lu gated, good gated %lu/%lu\n",
+           run.rms, run.max, (unsigned long)run.outliers_gated, (unsigned long)run.outliers,
+           (unsigned long)run.good_gated, (unsigned long)run.ranges);
+
+    TEST_ASSERT(run.rms < 0.25f, "rms %f", run.rms);
+    TEST_ASSERT(run.max < 0.75f, "max %f", run.max);
+    TEST_ASSERT(run.outliers > 0);
+    TEST_ASSERT(run.outliers_gated == run.outliers, "%lu of %lu outliers gated",
+                (unsigned long)run.outliers_gated, (unsigned long)run.outliers);
+    TEST_ASSERT(run.good_gated * 20 < run.ranges, "%lu good ranges gated",
+                (unsigned long)run.good_gated);
+
+    fusion_free(&fusion);
+}
@@ -0,0 +1,74 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fusion_test.h"
+
+static float g_jump_t;
+
+/* Stationary, then moved 6m between two range epochs without the imu
+ * seeing it, as after a wrong initial fix or a lost track */
+static void
+traj_jump(float t, struct fusion_test_truth * truth)
+{
+    memset(truth, 0, sizeof(*truth));
+    truth->pos[0] = (t < g_jump_t) ? 2.0f : 8.0f;
+    truth->pos[1] = 3.0f;
+    truth->pos[2] = 1.0f;
+}
+
+TEST_CASE(fusion_relock_test)
+{
+    struct fusion_instance fusion;
+    struct fusion_test_run run = {
+        .traj = traj_jump,
+        .t0 = 0.0f,
+        .t1 = 20.0f,
+        .settle = 15.0f,
+        .range_std = 0.10f,
+    };
+
+    fusion_test_seed(0x61c88647);
+    fusion_test_setup(&fusion);
+    fusion_reset(&fusion, NULL, fusion.config.init_pos_std);
+
+    /* Converge before the jump */
+    g_jump_t = 1e9f;
+    fusion_test_run(&fusion, &run);
+    TEST_ASSERT_FATAL(run.last < 0.5f, "error %f before the jump", run.last);
+
+    /* Every range disagrees after the jump, the tracker must not stay locked */
+    memset(&run, 0, sizeof(run));
+    run.traj = traj_jump;
+    run.t0 = 20.0f;
+    run.t1 = 60.0f;
+    run.settle = 30.0f;
+    run.range_std = 0.10f;
+    g_jump_t = 20.05f;
+    fusion_test_run(&fusion, &run);
+    printf("relock: rms %.3f max %.3f gated %lu/%lu\n", run.rms, run.max,
+           (unsigned long)run.good_gated, (unsigned long)run.ranges);
+
+    TEST_ASSERT(run.good_gated > MYNEWT_VAL(FUSION_GATE_RELOCK));
+#if MYNEWT_VAL(FUSION_STATS)
+    TEST_ASSERT(fusion.stat.relock > 0);
+#endif
+    TEST_ASSERT(run.rms < 0.35f, "rms %f", run.rms);
+    TEST_ASSERT(run.max < 1.00f, "max %f", run.max);
+
+    fusion_free(&fusion);
+}
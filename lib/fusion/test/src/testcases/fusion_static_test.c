@@ -0,0 +1,61 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fusion_test.h"
+
+static void
+traj_static(float t, struct fusion_test_truth * truth)
+{
+    memset(truth, 0, sizeof(*truth));
+    truth->pos[0] = 3.0f;
+    truth->pos[1] = 4.0f;
+    truth->pos[2] = 1.0f;
+}
+
+/* Cold start from the anchor centroid, a stationary tag */
+TEST_CASE(fusion_static_test)
+{
+    struct fusion_instance fusion;
+    struct fusion_test_run run = {
+        .traj = traj_static,
+        .t0 = 0.0f,
+        .t1 = 30.0f,
+        .settle = 20.0f,
+        .range_std = 0.10f,
+    };
+
+    fusion_test_seed(0x2545f491);
+    fusion_test_setup(&fusion);
+    fusion_reset(&fusion, NULL, fusion.config.init_pos_std);
+
+    fusion_test_run(&fusion, &run);
+    printf("static: rms %.3f max %.3f std %.3f\n", run.rms, run.max,
+           fusion_get_position_std(&fusion));
+
+    TEST_ASSERT(run.rms < 0.25f, "rms %f", run.rms);
+    TEST_ASSERT(run.max < 0.60f, "max %f", run.max);
+
+    /* The reported uncertainty is consistent with the actual error */
+    TEST_ASSERT(fusion_get_position_std(&fusion) < 0.35f);
+    TEST_ASSERT(run.rms < 1.5f * fusion_get_position_std(&fusion));
+
+    /* The imu loop and each range update have a bounded cost */
+    TEST_ASSERT(fusion.max_ticks > 0);
+
+    fusion_free(&fusion);
+}
@@ -0,0 +1,153 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file handover.h
+ * @brief Tag handover between ccp cells
+ *
+ * @details A tag follows the ccp master of one cell and holds a pan lease
+ * from it. Without handover, walking into the next cell it loses the
+ * master's blinks, times out, resynchronises to whichever master it hears
+ * and requests a new lease, with no position in between.
+ *
+ * Here the tag hands its idle tdma slots to the handover instance. In those
+ * slots it listens for the ccp blinks of neighbouring masters, first with
+ * whole-slot windows to discover them, then with short windows at their
+ * predicted blink times. The level of each cell is a running mean of the
+ * blink rssi, where a missed blink counts as HANDOVER_MISS_LEVEL. Once a
+ * neighbour is HANDOVER_HYSTERESIS above the serving cell for
+ * HANDOVER_TTT superframes, the tag requests a lease in the pan slot of the
+ * target cell while still in the serving one; uwb_pan holds it back. With
+ * the lease granted, uwb_ccp_set_master() moves the ccp to the next blink of
+ * the target, which cuts the current superframe short, and the lease is
+ * taken with that blink, so the tag ranges in the first superframe of the
+ * new cell. Without a lease after HANDOVER_PREPARE_TIMEOUT superframes, e.g.
+ * as the pan slot of the target falls on a busy slot here, the tag switches
+ * all the same and joins from the new cell.
+ *
+ * Neighbouring cells are assumed to share the superframe layout, i.e. the
+ * number of tdma slots and the pan slot index.
+ */
+
+#ifndef _HANDOVER_H_
+#define _HANDOVER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stats/stats.h>
+#include <dpl/dpl.h>
+#include <uwb/uwb.h>
+#include <uwb_ccp/uwb_ccp.h>
+#include <uwb_pan/uwb_pan.h>
+#include <tdma/tdma.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if MYNEWT_VAL(HANDOVER_STATS)
+STATS_SECT_START(handover_stat_section)
+    STATS_SECT_ENTRY(serving_rx)
+    STATS_SECT_ENTRY(serving_miss)
+    STATS_SECT_ENTRY(neighbour_rx)
+    STATS_SECT_ENTRY(neighbour_miss)
+    STATS_SECT_ENTRY(neighbour_drop)
+    STATS_SECT_ENTRY(discover)
+    STATS_SECT_ENTRY(track)
+    STATS_SECT_ENTRY(candidate)
+    STATS_SECT_ENTRY(lease_request)
+    STATS_SECT_ENTRY(lease_granted)
+    STATS_SECT_ENTRY(prepare_timeout)
+    STATS_SECT_ENTRY(planned_switch)
+    STATS_SECT_ENTRY(forced_switch)
+    STATS_SECT_ENTRY(start_rx_error)
+STATS_SECT_END
+#define HANDOVER_STATS_INC(__X) STATS_INC(ho->stat, __X)
+#else
+#define HANDOVER_STATS_INC(__X) {}
+#endif
+
+//! Handover states
+typedef enum _handover_state_t{
+    HANDOVER_IDLE = 0,               //!< Serving cell good enough or no better neighbour
+    HANDOVER_CANDIDATE,              //!< A neighbour is better, waiting HANDOVER_TTT superframes
+    HANDOVER_PREPARE,                //!< Requesting a lease in the target cell
+    HANDOVER_SWITCHING               //!< Ccp moved to the target, waiting for its first blink
+}handover_state_t;
+
+//! Ccp cell as seen by the tag
+struct handover_cell {
+    uint64_t euid;                   //!< Clock master, 0 marks a free entry
+    uint64_t master_epoch;           //!< Transmission timestamp of the last blink
+    uint64_t local_epoch;            //!< Local time of the last blink, less relay delay
+    uint32_t period;                 //!< Ccp period, dwt usec
+    uint32_t os_epoch;               //!< Cputime of the last blink
+    float level;                     //!< Running mean of rssi, misses count as HANDOVER_MISS_LEVEL, dBm
+    uint16_t nblinks;                //!< Blinks heard since the entry was made
+    uint16_t misses;                 //!< Consecutive blinks missed
+    uint16_t src_address;            //!< Master or relay heard last
+};
+
+//! Handover status
+typedef struct _handover_status_t{
+    uint16_t selfmalloc:1;           //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;          //!< Instance allocated
+    uint16_t listening:1;            //!< Receiver started by a handover slot
+    uint16_t start_rx_error:1;       //!< Start receive error
+}handover_status_t;
+
+//! Handover instance
+struct handover_instance {
+#if MYNEWT_VAL(HANDOVER_STATS)
+    STATS_SECT_DECL(handover_stat_section) stat; //!< Stats instance
+#endif
+    tdma_instance_t * tdma;                  //!< Tdma instance owning the idle slots
+    struct uwb_ccp_instance * ccp;           //!< Clock sync of the serving cell
+    struct uwb_pan_instance * pan;           //!< Lease of the serving cell
+    struct uwb_mac_interface cbs;            //!< MAC layer callbacks
+    handover_status_t status;                //!< Status
+    handover_state_t state;                  //!< Handover state
+    struct handover_cell serving;            //!< Cell of the current clock master
+    struct handover_cell cells[MYNEWT_VAL(HANDOVER_MAX_NEIGHBOURS)]; //!< Neighbouring cells heard
+    int16_t target;                          //!< Index in cells of the handover target, -1 if none
+    int16_t tracked;                         //!< Index in cells listened for, -1 when discovering
+    uint16_t slots[MYNEWT_VAL(HANDOVER_MAX_SLOTS)]; //!< Idle slots handed over by the application
+    uint16_t nslots;                         //!< Number of idle slots
+    uint16_t scan_idx;                       //!< Idle slot for the next discovery window
+    uint16_t ttt;                            //!< Superframes the target has been better
+    uint16_t prepare;                        //!< Superframes spent in HANDOVER_PREPARE
+    uint8_t seq_num;                         //!< Serving superframe last evaluated
+    uint32_t superframes;                    //!< Serving superframes evaluated
+    uint32_t switch_epoch;                   //!< Cputime of the last switch
+};
+
+struct handover_instance * handover_init(struct handover_instance * ho, tdma_instance_t * tdma,
+        struct uwb_pan_instance * pan);
+void handover_free(struct handover_instance * ho);
+struct handover_instance * handover_get_instance(struct uwb_dev * inst);
+int handover_set_slots(struct handover_instance * ho, const uint16_t slots[], uint16_t nslots);
+void handover_evaluate(struct handover_instance * ho);
+void handover_slot_cb(struct dpl_event * ev);
+uint64_t handover_next_blink(struct handover_instance * ho, struct handover_cell * cell, uint64_t after);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HANDOVER_H_ */
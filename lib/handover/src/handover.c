@@ -0,0 +1,653 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file handover.c
+ * @brief Tag handover between ccp cells
+ *
+ * @details Blinks are taken from the MAC callbacks, so neighbours are also
+ * learned when heard outside of a handover slot. The decision runs once per
+ * serving superframe, from the first handover slot of it. Serving blinks
+ * missed are found from gaps in the ccp sequence number; as tdma only runs
+ * on blinks of the serving master, a tag that loses it altogether falls
+ * back to the ccp resynchronisation, after which the lease of the old cell
+ * is dropped so uwb_pan requests a new one.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <os/os.h>
+#include <stats/stats.h>
+
+#include <uwb/uwb.h>
+#include <uwb/uwb_ftypes.h>
+#include <uwb_ccp/uwb_ccp.h>
+#include <uwb_pan/uwb_pan.h>
+#include <tdma/tdma.h>
+#include <handover/handover.h>
+
+#if MYNEWT_VAL(HANDOVER_ENABLED)
+
+#define MASK40 0x0FFFFFFFFFFUL
+
+#if MYNEWT_VAL(HANDOVER_STATS)
+STATS_NAME_START(handover_stat_section)
+    STATS_NAME(handover_stat_section, serving_rx)
+    STATS_NAME(handover_stat_section, serving_miss)
+    STATS_NAME(handover_stat_section, neighbour_rx)
+    STATS_NAME(handover_stat_section, neighbour_miss)
+    STATS_NAME(handover_stat_section, neighbour_drop)
+    STATS_NAME(handover_stat_section, discover)
+    STATS_NAME(handover_stat_section, track)
+    STATS_NAME(handover_stat_section, candidate)
+    STATS_NAME(handover_stat_section, lease_request)
+    STATS_NAME(handover_stat_section, lease_granted)
+    STATS_NAME(handover_stat_section, prepare_timeout)
+    STATS_NAME(handover_stat_section, planned_switch)
+    STATS_NAME(handover_stat_section, forced_switch)
+    STATS_NAME(handover_stat_section, start_rx_error)
+STATS_NAME_END(handover_stat_section)
+#endif
+
+static bool rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static bool rx_timeout_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static bool reset_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+
+#if MYNEWT_VAL(HANDOVER_CLI)
+int handover_cli_register(void);
+#endif
+
+/**
+ * @fn handover_init(struct handover_instance * ho, tdma_instance_t * tdma, struct uwb_pan_instance * pan)
+ * @brief Allocate and initialise handover on a tag, the idle slots are
+ * handed over with handover_set_slots().
+ *
+ * @param ho     Pointer to struct handover_instance, NULL to allocate.
+ * @param tdma   Pointer to tdma_instance_t of the tag, with its ccp.
+ * @param pan    Pointer to struct uwb_pan_instance holding the lease.
+ *
+ * @return struct handover_instance *
+ */
+struct handover_instance *
+handover_init(struct handover_instance * ho, tdma_instance_t * tdma, struct uwb_pan_instance * pan)
+{
+    assert(tdma && tdma->ccp && pan);
+
+    if (ho == NULL) {
+        ho = (struct handover_instance *) malloc(sizeof(struct handover_instance));
+        assert(ho);
+        memset(ho, 0, sizeof(struct handover_instance));
+        ho->status.selfmalloc = 1;
+    }
+    ho->tdma = tdma;
+    ho->ccp = tdma->ccp;
+    ho->pan = pan;
+    ho->state = HANDOVER_IDLE;
+    ho->target = ho->tracked = -1;
+
+    ho->cbs = (struct uwb_mac_interface){
+        .id = UWBEXT_HANDOVER,
+        .inst_ptr = (void *) ho,
+        .rx_complete_cb = rx_complete_cb,
+        .rx_timeout_cb = rx_timeout_cb,
+        .reset_cb = reset_cb
+    };
+    uwb_mac_append_interface(tdma->dev_inst, &ho->cbs);
+
+#if MYNEWT_VAL(HANDOVER_STATS)
+    if (!ho->status.initialized) {
+        int rc = stats_init(
+                    STATS_HDR(ho->stat),
+                    STATS_SIZE_INIT_PARMS(ho->stat, STATS_SIZE_32),
+                    STATS_NAME_INIT_PARMS(handover_stat_section)
+            );
+        rc |= stats_register("handover", STATS_HDR(ho->stat));
+        assert(rc == 0);
+    }
+#endif
+    ho->status.initialized = 1;
+    return ho;
+}
+
+/**
+ * @fn handover_free(struct handover_instance * ho)
+ * @brief Release the idle slots and free the instance.
+ *
+ * @param ho  Pointer to struct handover_instance.
+ *
+ * @return void
+ */
+void
+handover_free(struct handover_instance * ho)
+{
+    assert(ho);
+    for (uint16_t i = 0; i < ho->nslots; i++) {
+        tdma_release_slot(ho->tdma, ho->slots[i]);
+    }
+    ho->nslots = 0;
+    uwb_mac_remove_interface(ho->tdma->dev_inst, ho->cbs.id);
+    if (ho->status.selfmalloc) {
+        free(ho);
+    } else {
+        ho->status.initialized = 0;
+    }
+}
+
+/**
+ * @fn handover_get_instance(struct uwb_dev * inst)
+ * @brief Handover instance of a device.
+ *
+ * @param inst  Pointer to struct uwb_dev.
+ *
+ * @return struct handover_instance *, NULL if the device has none
+ */
+struct handover_instance *
+handover_get_instance(struct uwb_dev * inst)
+{
+    return (struct handover_instance *) uwb_mac_find_cb_inst_ptr(inst, UWBEXT_HANDOVER);
+}
+
+/**
+ * @fn handover_set_slots(struct handover_instance * ho, const uint16_t slots[], uint16_t nslots)
+ * @brief Hand over the tdma slots the tag does not use, handover_slot_cb is
+ * assigned to them. Call from the tdma task or before tdma runs.
+ *
+ * @param ho      Pointer to struct handover_instance.
+ * @param slots   Idle slot indexes.
+ * @param nslots  Number of idle slots.
+ *
+ * @return OS_OK, OS_EINVAL if there are too many slots.
+ */
+int
+handover_set_slots(struct handover_instance * ho, const uint16_t slots[], uint16_t nslots)
+{
+    if (nslots > MYNEWT_VAL(HANDOVER_MAX_SLOTS)) {
+        return OS_EINVAL;
+    }
+    for (uint16_t i = 0; i < ho->nslots; i++) {
+        tdma_release_slot(ho->tdma, ho->slots[i]);
+    }
+    memcpy(ho->slots, slots, nslots * sizeof(uint16_t));
+    ho->nslots = nslots;
+    ho->scan_idx = 0;
+    for (uint16_t i = 0; i < nslots; i++) {
+        tdma_assign_slot(ho->tdma, handover_slot_cb, slots[i], (void *) ho);
+    }
+    return OS_OK;
+}
+
+/**
+ * @fn handover_next_blink(struct handover_instance * ho, struct handover_cell * cell, uint64_t after)
+ * @brief Local time of the first blink of a cell after a given time, from its
+ * last blink and period.
+ *
+ * @param ho     Pointer to struct handover_instance.
+ * @param cell   Cell heard.
+ * @param after  Local time, dtu.
+ *
+ * @return local time, dtu
+ */
+uint64_t
+handover_next_blink(struct handover_instance * ho, struct handover_cell * cell, uint64_t after)
+{
+    uint64_t period = (uint64_t)cell->period << 16;
+    uint64_t elapsed = (after - cell->local_epoch) & MASK40;
+
+    return (cell->local_epoch + (elapsed / period + 1) * period) & MASK40;
+}
+
+/* a at or before b, both 40 bit local times less than half a wrap apart */
+static bool
+before(uint64_t a, uint64_t b)
+{
+    return ((b - a) & MASK40) < (MASK40 >> 1);
+}
+
+static void
+cell_level(struct handover_cell * cell, float level)
+{
+    if (cell->nblinks == 0 && cell->misses == 0) {
+        cell->level = level;
+    } else {
+        cell->level += (level - cell->level) / MYNEWT_VAL(HANDOVER_AVG);
+    }
+}
+
+static void
+cell_miss(struct handover_cell * cell)
+{
+    cell_level(cell, MYNEWT_VAL(HANDOVER_MISS_LEVEL));
+    cell->misses++;
+}
+
+/* Timing and level of a blink, relayed blinks are taken back to the master's as in uwb_ccp */
+static void
+cell_blink(struct handover_cell * cell, struct uwb_dev * inst, uwb_ccp_blink_frame_t * frame)
+{
+    uint64_t local_epoch = inst->rxtimestamp;
+
+    cell->master_epoch = frame->transmission_timestamp.timestamp;
+    cell->period = frame->transmission_interval >> 16;
+    if (frame->rpt_count != 0) {
+        uint64_t master_interval = ((frame->transmission_interval/0x100000000UL+1)*0x100000000UL);
+        uint64_t repeat_dly = master_interval - frame->transmission_interval;
+        cell->period = master_interval >> 16;
+        cell->master_epoch -= repeat_dly;
+        local_epoch -= repeat_dly;
+    }
+    cell->local_epoch = local_epoch & MASK40;
+    cell->os_epoch = os_cputime_get32();
+    cell->src_address = frame->short_address;
+    cell_level(cell, uwb_calc_rssi(inst, inst->rxdiag));
+    cell->nblinks++;
+    cell->misses = 0;
+}
+
+/* Neighbour entry of a master, a free or the weakest non-target entry is taken over if alloc */
+static struct handover_cell *
+handover_cell(struct handover_instance * ho, uint64_t euid, bool alloc)
+{
+    struct handover_cell * spare = NULL;
+
+    for (int i = 0; i < MYNEWT_VAL(HANDOVER_MAX_NEIGHBOURS); i++) {
+        struct handover_cell * cell = &ho->cells[i];
+        if (cell->euid == euid) {
+            return cell;
+        }
+        if (i == ho->target) {
+            continue;
+        }
+        if (spare == NULL || (spare->euid && (cell->euid == 0 || cell->level < spare->level))) {
+            spare = cell;
+        }
+    }
+    if (!alloc || spare == NULL) {
+        return NULL;
+    }
+    memset(spare, 0, sizeof(struct handover_cell));
+    spare->euid = euid;
+    return spare;
+}
+
+static void
+handover_reset_target(struct handover_instance * ho)
+{
+    ho->state = HANDOVER_IDLE;
+    ho->target = -1;
+    ho->ttt = 0;
+    ho->prepare = 0;
+}
+
+/**
+ * @fn handover_master_changed(struct handover_instance * ho, uint64_t euid)
+ * @brief The ccp follows a new master. The lease prepared for it is taken,
+ * otherwise the lease of the old cell is dropped. The old serving cell
+ * becomes a neighbour, keeping its level for the hysteresis.
+ *
+ * Interrupt context, uwb_pan takes its leases there too.
+ */
+static void
+handover_master_changed(struct handover_instance * ho, uint64_t euid)
+{
+    struct uwb_pan_instance * pan = ho->pan;
+    struct handover_cell serving = {.euid = euid};
+    struct handover_cell * cell = handover_cell(ho, euid, false);
+    bool planned = ho->state >= HANDOVER_PREPARE && ho->target >= 0 && ho->cells[ho->target].euid == euid;
+
+    if (planned && pan->status.lease_pending) {
+        uwb_pan_commit_lease(pan);
+        HANDOVER_STATS_INC(planned_switch);
+    } else {
+        pan->status.lease_pending = false;
+        if (ho->serving.euid && pan->status.valid) {
+            /* Resynchronised by ccp on its own, the old lease is of no use here */
+            dpl_callout_stop(&pan->pan_lease_callout_expiry);
+            pan->status.valid = false;
+            pan->dev_inst->slot_id = 0xffff;
+            HANDOVER_STATS_INC(forced_switch);
+        }
+    }
+    if (cell) {
+        serving = *cell;
+        memset(cell, 0, sizeof(struct handover_cell));
+    }
+    if (ho->serving.euid) {
+        struct handover_cell * old = handover_cell(ho, ho->serving.euid, true);
+        if (old) {
+            *old = ho->serving;
+        }
+    }
+    ho->serving = serving;
+    ho->switch_epoch = os_cputime_get32();
+    handover_reset_target(ho);
+}
+
+/* Follow the target master from its next blink, heard in idle slots so far, clear of the tag's own */
+static void
+handover_switch(struct handover_instance * ho)
+{
+    struct handover_cell * cell = &ho->cells[ho->target];
+
+    uwb_ccp_set_master(ho->ccp, cell->euid, cell->master_epoch, cell->local_epoch, cell->period);
+    ho->state = HANDOVER_SWITCHING;
+    ho->prepare = 0;
+}
+
+/**
+ * @fn handover_evaluate(struct handover_instance * ho)
+ * @brief Update the serving level and the handover state, once per serving
+ * superframe, further calls in the same superframe return at once. Called
+ * from handover_slot_cb.
+ *
+ * @param ho  Pointer to struct handover_instance.
+ *
+ * @return void
+ */
+void
+handover_evaluate(struct handover_instance * ho)
+{
+    struct uwb_ccp_instance * ccp = ho->ccp;
+    uint32_t now = os_cputime_get32();
+    int16_t best = -1;
+
+    if (!ccp->status.valid || (ho->superframes && ccp->seq_num == ho->seq_num)) {
+        return;
+    }
+    if (ho->superframes) {
+        for (uint8_t missed = ccp->seq_num - ho->seq_num - 1; missed; missed--) {
+            cell_miss(&ho->serving);
+            HANDOVER_STATS_INC(serving_miss);
+        }
+    }
+    ho->seq_num = ccp->seq_num;
+    ho->superframes++;
+
+    for (int16_t i = 0; i < MYNEWT_VAL(HANDOVER_MAX_NEIGHBOURS); i++) {
+        struct handover_cell * cell = &ho->cells[i];
+        if (cell->euid == 0) {
+            continue;
+        }
+        if (os_cputime_ticks_to_usecs(now - cell->os_epoch) > MYNEWT_VAL(HANDOVER_TIMEOUT) * 1000UL
+            || cell->misses >= MYNEWT_VAL(HANDOVER_MAX_MISSES)) {
+            if (i == ho->target) {
+                handover_reset_target(ho);
+            }
+            memset(cell, 0, sizeof(struct handover_cell));
+            HANDOVER_STATS_INC(neighbour_drop);
+            continue;
+        }
+        if (cell->nblinks >= MYNEWT_VAL(HANDOVER_MIN_BLINKS) && (best < 0 || cell->level > ho->cells[best].level)) {
+            best = i;
+        }
+    }
+
+    switch (ho->state) {
+    case HANDOVER_IDLE:
+    case HANDOVER_CANDIDATE:
+        if (best < 0 || ho->cells[best].level < ho->serving.level + MYNEWT_VAL(HANDOVER_HYSTERESIS)) {
+            handover_reset_target(ho);
+            break;
+        }
+        if (ho->state == HANDOVER_IDLE || ho->target != best) {
+            ho->state = HANDOVER_CANDIDATE;
+            ho->target = best;
+            ho->ttt = 0;
+            HANDOVER_STATS_INC(candidate);
+        }
+        if (++ho->ttt >= MYNEWT_VAL(HANDOVER_TTT)) {
+            ho->state = HANDOVER_PREPARE;
+            ho->prepare = 0;
+        }
+        break;
+    case HANDOVER_PREPARE:
+        if (ho->cells[ho->target].level < ho->serving.level) {
+            handover_reset_target(ho);
+        } else if (++ho->prepare > MYNEWT_VAL(HANDOVER_PREPARE_TIMEOUT)) {
+            /* No lease in time, e.g. the target's pan slot falls on a busy
+             * slot here, follow the target anyway and join it from there */
+            HANDOVER_STATS_INC(prepare_timeout);
+            handover_switch(ho);
+        }
+        break;
+    case HANDOVER_SWITCHING:
+        /* Completed by the first blink of the target, see rx_complete_cb */
+        if (++ho->prepare > MYNEWT_VAL(HANDOVER_PREPARE_TIMEOUT)) {
+            ho->pan->status.lease_pending = false;
+            handover_reset_target(ho);
+        }
+        break;
+    }
+}
+
+/* Lease request in the pan slot of the target cell, if it falls in this idle slot */
+static bool
+handover_request_lease(struct handover_instance * ho, uint64_t start, uint64_t end)
+{
+    tdma_instance_t * tdma = ho->tdma;
+    struct uwb_dev * inst = tdma->dev_inst;
+    struct uwb_pan_instance * pan = ho->pan;
+    struct handover_cell * cell = &ho->cells[ho->target];
+
+    /* Request subslot of the pan slot, as uwb_pan_slot_timer_cb */
+    uint64_t slot = ((uint64_t)cell->period << 16) / tdma->nslots;
+    uint64_t offset = MYNEWT_VAL(HANDOVER_PAN_SLOT) * slot + slot / 16;
+    uint64_t dx_time = (handover_next_blink(ho, cell, (start - offset) & MASK40) + offset) & MASK40;
+    uint64_t duration = (uint64_t)(uwb_phy_frame_duration(inst, sizeof(struct _pan_frame_t))
+                                   + pan->config->rx_timeout_period) << 16;
+
+    if (!before(dx_time + duration, end)) {
+        return false;
+    }
+    pan->control.defer_lease = true;
+    HANDOVER_STATS_INC(lease_request);
+    uwb_pan_blink(pan, pan->config->network_role, UWB_BLOCKING, dx_time);
+    pan->control.defer_lease = false;
+
+    if (pan->status.lease_pending) {
+        HANDOVER_STATS_INC(lease_granted);
+        handover_switch(ho);
+    }
+    return true;
+}
+
+static void
+handover_listen(struct handover_instance * ho, uint64_t dx_time, uint16_t timeout, int16_t tracked)
+{
+    struct uwb_dev * inst = ho->tdma->dev_inst;
+
+    ho->tracked = tracked;
+    ho->status.listening = 1;
+    uwb_set_rx_timeout(inst, timeout);
+    uwb_set_delay_start(inst, dx_time);
+    ho->status.start_rx_error = uwb_start_rx(inst).start_rx_error;
+    if (ho->status.start_rx_error) {
+        ho->status.listening = 0;
+        HANDOVER_STATS_INC(start_rx_error);
+    }
+}
+
+/* Listen for a neighbour whose next blink falls in this idle slot */
+static bool
+handover_track(struct handover_instance * ho, uint64_t start, uint64_t end)
+{
+    struct uwb_dev * inst = ho->tdma->dev_inst;
+    uint64_t shr = (uint64_t)ceilf(uwb_usecs_to_dwt_usecs(uwb_phy_SHR_duration(inst))) << 16;
+    uint16_t frame = uwb_phy_frame_duration(inst, sizeof(uwb_ccp_blink_frame_t));
+
+    for (int16_t i = 0; i < MYNEWT_VAL(HANDOVER_MAX_NEIGHBOURS); i++) {
+        struct handover_cell * cell = &ho->cells[i];
+        if (cell->euid == 0) {
+            continue;
+        }
+        uint64_t blink = handover_next_blink(ho, cell, start);
+        /* Neither clock is known against the other, widen with the time since last heard */
+        uint64_t elapsed = ((blink - cell->local_epoch) & MASK40) >> 16;
+        uint64_t guard = MYNEWT_VAL(XTALT_GUARD) + elapsed * MYNEWT_VAL(HANDOVER_MAX_PPM) / 1000000;
+        if (guard > 0x7fff - frame) {
+            continue;
+        }
+        uint64_t dx_time = (blink - shr - (guard << 16)) & MASK40;
+        uint16_t timeout = frame + 2 * guard;
+        if (before(start, dx_time) && before(dx_time + ((uint64_t)timeout << 16), end)) {
+            HANDOVER_STATS_INC(track);
+            handover_listen(ho, dx_time, timeout, i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @fn handover_slot_cb(struct dpl_event * ev)
+ * @brief Slot callback of the idle slots. Evaluates the handover, then uses
+ * the slot to request a lease in the target cell, to listen for a known
+ * neighbour or to discover neighbours, in every idle slot while none is
+ * known and in one slot per HANDOVER_SCAN_INTERVAL superframes after.
+ * Neighbours are only monitored while the serving level is below
+ * HANDOVER_SCAN_LEVEL. Windows end before the timer of the next slot.
+ *
+ * @param ev  Pointer to dpl_event, argument is the tdma_slot_t.
+ *
+ * @return void
+ */
+void
+handover_slot_cb(struct dpl_event * ev)
+{
+    assert(ev);
+    tdma_slot_t * slot = (tdma_slot_t *) dpl_event_get_arg(ev);
+    tdma_instance_t * tdma = slot->parent;
+    struct handover_instance * ho = (struct handover_instance *) slot->arg;
+    uint16_t idx = slot->idx;
+    bool known = false;
+
+    handover_evaluate(ho);
+    if (!ho->ccp->status.valid || !ho->pan->status.valid || ho->state == HANDOVER_SWITCHING) {
+        /* Switching, the radio is left to the ccp listening for the target */
+        return;
+    }
+
+    uint64_t start = tdma_rx_slot_start(tdma, idx);
+    uint64_t end = tdma_rx_slot_start(tdma, idx + 1)
+        - ((uint64_t)ceilf(uwb_usecs_to_dwt_usecs(MYNEWT_VAL(OS_LATENCY))) << 16);
+
+    if (ho->state == HANDOVER_PREPARE && handover_request_lease(ho, start, end)) {
+        return;
+    }
+    if (ho->state == HANDOVER_IDLE && ho->serving.level > MYNEWT_VAL(HANDOVER_SCAN_LEVEL)) {
+        return;
+    }
+    if (handover_track(ho, start, end)) {
+        return;
+    }
+    for (int i = 0; i < MYNEWT_VAL(HANDOVER_MAX_NEIGHBOURS); i++) {
+        known |= ho->cells[i].euid != 0;
+    }
+    if (!known || (ho->nslots && ho->slots[ho->scan_idx] == idx
+        && ho->superframes % MYNEWT_VAL(HANDOVER_SCAN_INTERVAL) == 0)) {
+        uint64_t length = ((end - start) & MASK40) >> 16;
+        if (known) {
+            ho->scan_idx = (ho->scan_idx + 1) % ho->nslots;
+        }
+        HANDOVER_STATS_INC(discover);
+        handover_listen(ho, start, length > 0xffff ? 0xffff : (uint16_t) length, -1);
+    }
+}
+
+/**
+ * @fn rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+ * @brief Level and timing of the serving and neighbouring cells from every
+ * ccp blink heard. Blinks are passed on unless they end a handover listen.
+ *
+ * @return true if the blink ended a listen of handover_slot_cb
+ */
+static bool
+rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct handover_instance * ho = (struct handover_instance *) cbs->inst_ptr;
+    uwb_ccp_blink_frame_t * frame = (uwb_ccp_blink_frame_t *) inst->rxbuf;
+
+    if (inst->fctrl_array[0] != FCNTL_IEEE_BLINK_CCP_64 || inst->frame_len < sizeof(uwb_ccp_blink_frame_t)
+        || inst->status.lde_error) {
+        return false;
+    }
+    if (frame->euid == ho->ccp->master_euid) {
+        if (frame->euid != ho->serving.euid) {
+            handover_master_changed(ho, frame->euid);
+        }
+        cell_blink(&ho->serving, inst, frame);
+        HANDOVER_STATS_INC(serving_rx);
+        return false;
+    }
+
+    struct handover_cell * cell = handover_cell(ho, frame->euid, true);
+    if (cell) {
+        cell_blink(cell, inst, frame);
+        HANDOVER_STATS_INC(neighbour_rx);
+    }
+    if (ho->status.listening) {
+        ho->status.listening = 0;
+        return true;
+    }
+    return false;
+}
+
+static bool
+rx_timeout_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct handover_instance * ho = (struct handover_instance *) cbs->inst_ptr;
+
+    if (!ho->status.listening) {
+        return false;
+    }
+    ho->status.listening = 0;
+    if (ho->tracked >= 0 && ho->cells[ho->tracked].euid) {
+        cell_miss(&ho->cells[ho->tracked]);
+        HANDOVER_STATS_INC(neighbour_miss);
+    }
+    return true;
+}
+
+static bool
+reset_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct handover_instance * ho = (struct handover_instance *) cbs->inst_ptr;
+
+    if (!ho->status.listening) {
+        return false;
+    }
+    ho->status.listening = 0;
+    return true;
+}
+
+void
+handover_pkg_init(void)
+{
+#if MYNEWT_VAL(HANDOVER_VERBOSE)
+    printf("{\"utime\": %lu,\"msg\": \"handover_pkg_init\"}\n", os_cputime_ticks_to_usecs(os_cputime_get32()));
+#endif
+#if MYNEWT_VAL(HANDOVER_CLI)
+    int rc = handover_cli_register();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+}
+
+#endif /* MYNEWT_VAL(HANDOVER_ENABLED) */
@@ -0,0 +1,103 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <os/os.h>
+#include <syscfg/syscfg.h>
+
+#if MYNEWT_VAL(HANDOVER_ENABLED) && MYNEWT_VAL(HANDOVER_CLI)
+
+#include <string.h>
+#include <stdlib.h>
+
+#include <shell/shell.h>
+#include <console/console.h>
+
+#include <uwb/uwb.h>
+#include "handover/handover.h"
+
+static int handover_cli_cmd(int argc, char **argv);
+
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+const struct shell_param cmd_ho_param[] = {
+    {"state", "handover state and serving cell"},
+    {"cells", "neighbouring cells heard"},
+    {NULL,NULL},
+};
+
+const struct shell_cmd_help cmd_ho_help = {
+	"ho", "<cmd>", cmd_ho_param
+};
+#endif
+
+static struct shell_cmd shell_ho_cmd = {
+    .sc_cmd = "ho",
+    .sc_cmd_func = handover_cli_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+    .help = &cmd_ho_help
+#endif
+};
+
+static void
+handover_cli_cell(int idx, struct handover_cell * cell, uint32_t now)
+{
+    console_printf("{\"idx\": %d, \"euid\": \"%llx\", \"level\": %d, \"nblinks\": %d, \"misses\": %d, "
+                   "\"period\": %lu, \"src\": \"%x\", \"age_ms\": %lu}\n",
+                   idx, (unsigned long long)cell->euid, (int)cell->level, cell->nblinks, cell->misses,
+                   (unsigned long)cell->period, cell->src_address,
+                   (unsigned long)(os_cputime_ticks_to_usecs(now - cell->os_epoch) / 1000));
+}
+
+static int
+handover_cli_cmd(int argc, char **argv)
+{
+    struct handover_instance * ho = handover_get_instance(uwb_dev_idx_lookup(0));
+    uint32_t now = os_cputime_get32();
+
+    if (argc < 2) {
+        return 0;
+    }
+    if (ho == NULL) {
+        console_printf("No handover instance\n");
+        return 0;
+    }
+
+    if (!strcmp(argv[1], "state")) {
+        console_printf("{\"state\": %d, \"target\": %d, \"ttt\": %d, \"superframes\": %lu, "
+                       "\"since_switch_ms\": %lu}\n",
+                       ho->state, ho->target, ho->ttt, (unsigned long)ho->superframes,
+                       (unsigned long)(os_cputime_ticks_to_usecs(now - ho->switch_epoch) / 1000));
+        handover_cli_cell(-1, &ho->serving, now);
+    } else if (!strcmp(argv[1], "cells")) {
+        for (int i = 0; i < MYNEWT_VAL(HANDOVER_MAX_NEIGHBOURS); i++) {
+            if (ho->cells[i].euid) {
+                handover_cli_cell(i, &ho->cells[i], now);
+            }
+        }
+    } else {
+        console_printf("Unknown cmd\n");
+    }
+    return 0;
+}
+
+int
+handover_cli_register(void)
+{
+    return shell_cmd_register(&shell_ho_cmd);
+}
+#endif /* MYNEWT_VAL(HANDOVER_ENABLED) && MYNEWT_VAL(HANDOVER_CLI) */
@@ -0,0 +1,187 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "handover_test.h"
+
+#define MASK40 0x0FFFFFFFFFFULL
+
+static struct uwb_dev g_dev;
+static struct uwb_ccp_instance g_ccp;
+static tdma_instance_t g_tdma;
+static struct uwb_pan_instance g_pan;
+static struct handover_instance g_ho;
+static float g_level;
+static uint64_t g_systime;
+static uint32_t g_superframe;
+static uint8_t g_seq[3];
+
+static float
+radio_calc_rssi(struct uwb_dev * dev, struct uwb_dev_rxdiag * diag)
+{
+    return g_level;
+}
+
+static uint64_t
+radio_read_systime(struct uwb_dev * dev)
+{
+    return g_systime;
+}
+
+static void
+radio_set_panid(struct uwb_dev * dev, uint16_t pan_id)
+{
+    dev->pan_id = pan_id;
+}
+
+static void
+radio_set_uid(struct uwb_dev * dev, uint16_t uid)
+{
+    dev->uid = uid;
+}
+
+static const struct uwb_driver_funcs g_handover_test_funcs = {
+    .uf_calc_rssi = radio_calc_rssi,
+    .uf_read_systime = radio_read_systime,
+    .uf_set_panid = radio_set_panid,
+    .uf_set_uid = radio_set_uid,
+};
+
+static void
+timer_cb(void * arg)
+{
+}
+
+static void
+lease_expiry_cb(struct dpl_event * ev)
+{
+}
+
+/** Cell index, also the third of the period its blinks are offset by */
+static int
+cell(uint64_t euid)
+{
+    return (euid == HANDOVER_TEST_A) ? 0 : (euid == HANDOVER_TEST_B) ? 1 : 2;
+}
+
+/** Tag following master A with a lease from it, a first blink heard at -70 dBm */
+struct handover_instance *
+handover_test_setup(void)
+{
+    if (!g_ho.status.initialized) {
+        g_dev.uw_funcs = &g_handover_test_funcs;
+        g_ccp.dev_inst = &g_dev;
+        g_ccp.blink_frame_duration = 200;
+        os_cputime_timer_init(&g_ccp.timer, timer_cb, NULL);
+        g_tdma.dev_inst = &g_dev;
+        g_tdma.ccp = &g_ccp;
+        g_tdma.nslots = 16;
+        g_pan.dev_inst = &g_dev;
+        dpl_callout_init(&g_pan.pan_lease_callout_expiry, dpl_eventq_dflt_get(), lease_expiry_cb, NULL);
+    }
+    handover_init(&g_ho, &g_tdma, &g_pan);
+    memset(&g_ho.serving, 0, sizeof(g_ho.serving));
+    memset(g_ho.cells, 0, sizeof(g_ho.cells));
+    g_ho.superframes = 0;
+    g_ccp.master_euid = HANDOVER_TEST_A;
+    g_ccp.status.valid = 1;
+    g_ccp.status.master_pending = 0;
+    g_pan.status.valid = 1;
+    g_pan.status.lease_pending = 0;
+    g_dev.slot_id = 3;
+    handover_test_superframe(&g_ho, -70);
+    return &g_ho;
+}
+
+/** A ccp blink of master euid heard at level dBm, in the current superframe */
+void
+handover_test_blink(struct handover_instance * ho, uint64_t euid, float level)
+{
+    struct uwb_dev * inst = &g_dev;
+    uwb_ccp_blink_frame_t * frame = (uwb_ccp_blink_frame_t *) inst->rxbuf;
+    uint64_t period = (uint64_t)HANDOVER_TEST_PERIOD << 16;
+    uint64_t offset = cell(euid) * (period / 3);
+
+    memset(frame, 0, sizeof(uwb_ccp_blink_frame_t));
+    frame->euid = euid;
+    frame->seq_num = g_seq[cell(euid)]++;
+    frame->short_address = 0x100 + cell(euid);
+    frame->transmission_interval = period;
+    frame->transmission_timestamp.timestamp = (uint64_t)cell(euid) << 48 | (g_superframe * period);
+    inst->fctrl_array[0] = FCNTL_IEEE_BLINK_CCP_64;
+    inst->frame_len = sizeof(uwb_ccp_blink_frame_t);
+    inst->status.lde_error = 0;
+    inst->rxtimestamp = (g_superframe * period + offset) & MASK40;
+    g_level = level;
+    ho->cbs.rx_complete_cb(inst, &ho->cbs);
+}
+
+/** A handover window at the predicted blink of master euid ends without it */
+void
+handover_test_miss(struct handover_instance * ho, uint64_t euid)
+{
+    for (int16_t i = 0; i < MYNEWT_VAL(HANDOVER_MAX_NEIGHBOURS); i++) {
+        if (ho->cells[i].euid == euid) {
+            ho->tracked = i;
+            ho->status.listening = 1;
+            TEST_ASSERT(ho->cbs.rx_timeout_cb(&g_dev, &ho->cbs));
+            return;
+        }
+    }
+    TEST_ASSERT(0, "not tracked");
+}
+
+/**
+ * Next superframe of the ccp master, its blink heard at level dBm and
+ * evaluated from an idle slot. Missed if level is NAN, tdma then does not
+ * run and the ccp sequence number jumps at the next blink heard.
+ */
+void
+handover_test_superframe(struct handover_instance * ho, float level)
+{
+    g_superframe++;
+    g_ccp.seq_num++;
+    if (isnan(level)) {
+        return;
+    }
+    handover_test_blink(ho, g_ccp.master_euid, level);
+    handover_evaluate(ho);
+}
+
+/** The pan master of the target cell grants a lease, held back by uwb_pan */
+void
+handover_test_grant(struct handover_instance * ho)
+{
+    struct uwb_pan_instance * pan = ho->pan;
+
+    pan->pending = (uwb_pan_lease_t){
+        .pan_id = 0xDECA,
+        .short_address = 0x4321,
+        .slot_id = HANDOVER_TEST_SLOT,
+        .lease_time = 0,
+        .os_epoch = os_cputime_get32()
+    };
+    pan->status.lease_pending = 1;
+}
+
+/** Local time uwb_read_systime returns */
+void
+handover_test_systime(uint64_t systime)
+{
+    g_systime = systime;
+}
@@ -0,0 +1,63 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _HANDOVER_TEST_H
+#define _HANDOVER_TEST_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "testutil/testutil.h"
+
+#include "uwb/uwb.h"
+#include "uwb_ccp/uwb_ccp.h"
+#include "uwb_pan/uwb_pan.h"
+#include "handover/handover.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Masters of the serving cell and of two neighbours
+#define HANDOVER_TEST_A (0xA0000000000000A0ULL)
+#define HANDOVER_TEST_B (0xB0000000000000B0ULL)
+#define HANDOVER_TEST_C (0xC0000000000000C0ULL)
+//! Ccp period of all cells, dwt usec
+#define HANDOVER_TEST_PERIOD ((uint32_t)(MYNEWT_VAL(UWB_CCP_PERIOD) >> 16) << 16)
+//! Slot of the lease held back for the target cell
+#define HANDOVER_TEST_SLOT (7)
+
+struct handover_instance * handover_test_setup(void);
+void handover_test_blink(struct handover_instance * ho, uint64_t euid, float level);
+void handover_test_miss(struct handover_instance * ho, uint64_t euid);
+void handover_test_superframe(struct handover_instance * ho, float level);
+void handover_test_grant(struct handover_instance * ho);
+void handover_test_systime(uint64_t systime);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HANDOVER_TEST_H */
@@ -0,0 +1,81 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "handover_test.h"
+
+static struct handover_cell *
+target(struct handover_instance * ho)
+{
+    return (ho->target >= 0) ? &ho->cells[ho->target] : NULL;
+}
+
+/**
+ * A neighbour becomes the target once heard HANDOVER_MIN_BLINKS times and
+ * HANDOVER_HYSTERESIS dB above the serving cell, and a lease is prepared
+ * after HANDOVER_TTT superframes of it. A neighbour within the margin never
+ * is, a better one restarts the count and a target falling back is dropped.
+ */
+TEST_CASE(handover_hysteresis_test)
+{
+    struct handover_instance * ho = handover_test_setup();
+    int n;
+#if MYNEWT_VAL(HANDOVER_STATS)
+    uint32_t candidate = ho->stat.candidate;
+#endif
+
+    /* Within the margin */
+    for (int i = 0; i < 2 * MYNEWT_VAL(HANDOVER_MIN_BLINKS); i++) {
+        handover_test_blink(ho, HANDOVER_TEST_B, -70 + MYNEWT_VAL(HANDOVER_HYSTERESIS) - 0.5f);
+        handover_test_superframe(ho, -70);
+        TEST_ASSERT(ho->state == HANDOVER_IDLE && ho->target == -1);
+    }
+
+    /* Past it, a candidate from the HANDOVER_MIN_BLINKS-th blink */
+    for (n = 1; ho->state != HANDOVER_CANDIDATE && n <= MYNEWT_VAL(HANDOVER_MIN_BLINKS); n++) {
+        handover_test_blink(ho, HANDOVER_TEST_C, -70 + MYNEWT_VAL(HANDOVER_HYSTERESIS) + 0.5f);
+        handover_test_superframe(ho, -70);
+    }
+    TEST_ASSERT_FATAL(n == MYNEWT_VAL(HANDOVER_MIN_BLINKS) + 1, "%d", n);
+    TEST_ASSERT(ho->state == HANDOVER_CANDIDATE || MYNEWT_VAL(HANDOVER_TTT) <= 1);
+    TEST_ASSERT(target(ho) && target(ho)->euid == HANDOVER_TEST_C);
+
+    /* Falling back */
+    handover_test_blink(ho, HANDOVER_TEST_C, -90);
+    handover_test_superframe(ho, -70);
+    TEST_ASSERT(ho->state == HANDOVER_IDLE && ho->target == -1 && ho->ttt == 0);
+
+    /* The time to trigger restarts with a better neighbour */
+    handover_test_blink(ho, HANDOVER_TEST_C, -60);
+    handover_test_blink(ho, HANDOVER_TEST_C, -60);
+    handover_test_blink(ho, HANDOVER_TEST_C, -60);
+    handover_test_superframe(ho, -70);
+    TEST_ASSERT(target(ho) && target(ho)->euid == HANDOVER_TEST_C && ho->ttt == 1);
+    for (int i = 0; i < 6; i++) {
+        handover_test_blink(ho, HANDOVER_TEST_B, -50);
+    }
+    handover_test_superframe(ho, -70);
+    TEST_ASSERT(target(ho) && target(ho)->euid == HANDOVER_TEST_B && ho->ttt == 1);
+    for (n = 1; ho->state != HANDOVER_PREPARE && n <= MYNEWT_VAL(HANDOVER_TTT); n++) {
+        handover_test_superframe(ho, -70);
+    }
+    TEST_ASSERT(n == MYNEWT_VAL(HANDOVER_TTT), "%d", n);
+    TEST_ASSERT(ho->state == HANDOVER_PREPARE && ho->prepare == 0);
+#if MYNEWT_VAL(HANDOVER_STATS)
+    TEST_ASSERT(ho->stat.candidate - candidate == 3);
+#endif
+}
@@ -0,0 +1,74 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "handover_test.h"
+
+/**
+ * A serving blink missed, found from the gap in the ccp sequence numbers,
+ * and a tracked neighbour blink missed both count as HANDOVER_MISS_LEVEL in
+ * the running level; a neighbour missed HANDOVER_MAX_MISSES times in a row
+ * is dropped, as the target too.
+ */
+TEST_CASE(handover_miss_test)
+{
+    struct handover_instance * ho = handover_test_setup();
+    float level;
+#if MYNEWT_VAL(HANDOVER_STATS)
+    uint32_t serving_miss = ho->stat.serving_miss, neighbour_drop = ho->stat.neighbour_drop;
+#endif
+
+    for (int i = 0; i < MYNEWT_VAL(HANDOVER_MIN_BLINKS); i++) {
+        handover_test_blink(ho, HANDOVER_TEST_B, -68);
+        handover_test_superframe(ho, -70);
+    }
+    TEST_ASSERT(ho->state == HANDOVER_IDLE && fabsf(ho->serving.level + 70) < 1e-3f);
+
+    /* The serving level drops by a missed blink, below the margin */
+    handover_test_superframe(ho, NAN);
+    handover_test_blink(ho, HANDOVER_TEST_B, -68);
+    handover_test_superframe(ho, -70);
+    level = -70 + (MYNEWT_VAL(HANDOVER_MISS_LEVEL) + 70) / MYNEWT_VAL(HANDOVER_AVG);
+    TEST_ASSERT(fabsf(ho->serving.level - level) < 1e-3f, "%f", ho->serving.level);
+    TEST_ASSERT_FATAL(ho->target >= 0 && ho->cells[ho->target].euid == HANDOVER_TEST_B);
+#if MYNEWT_VAL(HANDOVER_STATS)
+    TEST_ASSERT(ho->stat.serving_miss - serving_miss == 1);
+#endif
+
+    /* Misses of the neighbour */
+    struct handover_cell * cell = &ho->cells[ho->target];
+    handover_test_miss(ho, HANDOVER_TEST_B);
+    level = -68 + (MYNEWT_VAL(HANDOVER_MISS_LEVEL) + 68) / MYNEWT_VAL(HANDOVER_AVG);
+    TEST_ASSERT(fabsf(cell->level - level) < 1e-3f && cell->misses == 1, "%f", cell->level);
+    for (int i = 1; i < MYNEWT_VAL(HANDOVER_MAX_MISSES) - 1; i++) {
+        handover_test_miss(ho, HANDOVER_TEST_B);
+    }
+    handover_test_blink(ho, HANDOVER_TEST_B, -40);
+    handover_test_superframe(ho, -70);
+    TEST_ASSERT(cell->euid == HANDOVER_TEST_B && cell->misses == 0);
+    for (int i = 0; i < MYNEWT_VAL(HANDOVER_MAX_MISSES) - 1; i++) {
+        handover_test_miss(ho, HANDOVER_TEST_B);
+    }
+    handover_test_superframe(ho, -70);
+    TEST_ASSERT(cell->euid == HANDOVER_TEST_B);
+    handover_test_miss(ho, HANDOVER_TEST_B);
+    handover_test_superframe(ho, -70);
+    TEST_ASSERT(cell->euid == 0 && ho->target == -1 && ho->state == HANDOVER_IDLE);
+#if MYNEWT_VAL(HANDOVER_STATS)
+    TEST_ASSERT(ho->stat.neighbour_drop - neighbour_drop == 1);
+#endif
+}
@@ -0,0 +1,135 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "handover_test.h"
+
+/* Neighbour C 10 dB above the serving cell until a lease is being prepared */
+static struct handover_instance *
+prepare(void)
+{
+    struct handover_instance * ho = handover_test_setup();
+
+    for (int i = 0; i < MYNEWT_VAL(HANDOVER_MIN_BLINKS) + MYNEWT_VAL(HANDOVER_TTT) - 1; i++) {
+        handover_test_blink(ho, HANDOVER_TEST_C, -60);
+        handover_test_superframe(ho, -70);
+    }
+    TEST_ASSERT(ho->state == HANDOVER_PREPARE);
+    return ho;
+}
+
+/* The ccp has moved to master C, the first superframe of it */
+static void
+switched(struct handover_instance * ho)
+{
+    ho->ccp->master_euid = HANDOVER_TEST_C;
+    ho->ccp->status.master_pending = 0;
+    handover_test_superframe(ho, -60);
+    TEST_ASSERT(ho->serving.euid == HANDOVER_TEST_C);
+    TEST_ASSERT(ho->state == HANDOVER_IDLE && ho->target == -1);
+    for (int i = 0; i < MYNEWT_VAL(HANDOVER_MAX_NEIGHBOURS); i++) {
+        if (ho->cells[i].euid == HANDOVER_TEST_A) {
+            TEST_ASSERT(fabsf(ho->cells[i].level + 70) < 1e-3f);
+            return;
+        }
+    }
+    TEST_ASSERT(0, "old serving cell not a neighbour");
+}
+
+/**
+ * A lease granted while preparing is taken with the first blink of the
+ * target. Without one within HANDOVER_PREPARE_TIMEOUT superframes the ccp
+ * is moved all the same and the old lease dropped on the switch, as on a
+ * resynchronisation the handover did not plan. A target falling below the
+ * serving cell while preparing, or not heard after the switch, is given up.
+ */
+TEST_CASE(handover_prepare_test)
+{
+    struct handover_instance * ho;
+#if MYNEWT_VAL(HANDOVER_STATS)
+    uint32_t planned_switch, forced_switch, prepare_timeout;
+#endif
+
+    /* With the lease */
+    ho = prepare();
+#if MYNEWT_VAL(HANDOVER_STATS)
+    planned_switch = ho->stat.planned_switch, forced_switch = ho->stat.forced_switch;
+#endif
+    handover_test_grant(ho);
+    switched(ho);
+    TEST_ASSERT(ho->pan->status.valid && !ho->pan->status.lease_pending);
+    TEST_ASSERT(ho->pan->dev_inst->slot_id == HANDOVER_TEST_SLOT);
+#if MYNEWT_VAL(HANDOVER_STATS)
+    TEST_ASSERT(ho->stat.planned_switch - planned_switch == 1 && ho->stat.forced_switch == forced_switch);
+#endif
+
+    /* Without, after the prepare timeout */
+    ho = prepare();
+#if MYNEWT_VAL(HANDOVER_STATS)
+    prepare_timeout = ho->stat.prepare_timeout;
+#endif
+    for (int i = 0; i < MYNEWT_VAL(HANDOVER_PREPARE_TIMEOUT); i++) {
+        handover_test_blink(ho, HANDOVER_TEST_C, -60);
+        handover_test_superframe(ho, -70);
+        TEST_ASSERT_FATAL(ho->state == HANDOVER_PREPARE);
+    }
+    TEST_ASSERT(!ho->ccp->status.master_pending);
+    handover_test_blink(ho, HANDOVER_TEST_C, -60);
+    handover_test_superframe(ho, -70);
+    TEST_ASSERT_FATAL(ho->state == HANDOVER_SWITCHING);
+    TEST_ASSERT(ho->ccp->status.master_pending && ho->ccp->next_master.euid == HANDOVER_TEST_C);
+    TEST_ASSERT(ho->ccp->next_master.local_epoch == ho->cells[ho->target].local_epoch);
+    TEST_ASSERT(ho->ccp->next_master.period == HANDOVER_TEST_PERIOD);
+    os_cputime_timer_stop(&ho->ccp->timer);
+#if MYNEWT_VAL(HANDOVER_STATS)
+    TEST_ASSERT(ho->stat.prepare_timeout - prepare_timeout == 1);
+    forced_switch = ho->stat.forced_switch;
+#endif
+    switched(ho);
+    TEST_ASSERT(!ho->pan->status.valid && ho->pan->dev_inst->slot_id == 0xffff);
+#if MYNEWT_VAL(HANDOVER_STATS)
+    TEST_ASSERT(ho->stat.forced_switch - forced_switch == 1);
+#endif
+
+    /* Not heard after the switch */
+    ho = prepare();
+    for (int i = 0; i <= MYNEWT_VAL(HANDOVER_PREPARE_TIMEOUT); i++) {
+        handover_test_superframe(ho, -70);
+    }
+    TEST_ASSERT_FATAL(ho->state == HANDOVER_SWITCHING);
+    os_cputime_timer_stop(&ho->ccp->timer);
+    handover_test_grant(ho);
+    for (int i = 0; i < MYNEWT_VAL(HANDOVER_PREPARE_TIMEOUT); i++) {
+        handover_test_superframe(ho, -70);
+        TEST_ASSERT(ho->state == HANDOVER_SWITCHING);
+    }
+    handover_test_superframe(ho, -70);
+    TEST_ASSERT(ho->state == HANDOVER_IDLE && !ho->pan->status.lease_pending);
+
+    /* Target falling below the serving cell */
+    ho = prepare();
+    handover_test_blink(ho, HANDOVER_TEST_C, -150);
+    handover_test_superframe(ho, -70);
+    TEST_ASSERT(ho->state == HANDOVER_IDLE && ho->target == -1);
+
+    /* Resynchronised to another master by the ccp, unplanned */
+    ho = handover_test_setup();
+    ho->ccp->master_euid = HANDOVER_TEST_B;
+    handover_test_superframe(ho, -80);
+    TEST_ASSERT(ho->serving.euid == HANDOVER_TEST_B && fabsf(ho->serving.level + 80) < 1e-3f);
+    TEST_ASSERT(!ho->pan->status.valid && ho->pan->dev_inst->slot_id == 0xffff);
+}
@@ -0,0 +1,74 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "handover_test.h"
+
+#define MASK40 0x0FFFFFFFFFFULL
+
+/* Timer of the ccp set remaining usec ahead of now, less the latency and blink */
+static void
+check(struct uwb_ccp_instance * ccp, uint32_t period, uint64_t local_epoch, uint64_t systime, uint32_t remaining)
+{
+    uint32_t guard = MYNEWT_VAL(OS_LATENCY) + ccp->blink_frame_duration;
+    uint32_t ticks = os_cputime_usecs_to_ticks(remaining - guard);
+
+    handover_test_systime(systime & MASK40);
+    uint32_t before = os_cputime_get32();
+    uwb_ccp_set_master(ccp, HANDOVER_TEST_B, 0x123456789ULL, local_epoch, period);
+    uint32_t after = os_cputime_get32();
+    os_cputime_timer_stop(&ccp->timer);
+
+    TEST_ASSERT(ccp->status.master_pending && ccp->next_master.euid == HANDOVER_TEST_B);
+    TEST_ASSERT(ccp->next_master.master_epoch == 0x123456789ULL);
+    TEST_ASSERT(ccp->next_master.local_epoch == local_epoch && ccp->next_master.period == period);
+    TEST_ASSERT((int32_t)(ccp->timer.expiry - before - ticks) >= 0
+                && (int32_t)(ccp->timer.expiry - after - ticks) <= 0,
+                "%lu %lu", (unsigned long)(ccp->timer.expiry - before), (unsigned long)ticks);
+}
+
+/**
+ * uwb_ccp_set_master arms the slave timer ahead of the next blink of the
+ * new master, from the last one heard any number of periods ago and across
+ * the 40 bit wrap of the local time, one period later if that blink is
+ * closer than OS_LATENCY and the blink duration. The period is not a power
+ * of two, so that the wrap of the local time shows through the modulo.
+ */
+TEST_CASE(handover_set_master_test)
+{
+    struct handover_instance * ho = handover_test_setup();
+    struct uwb_ccp_instance * ccp = ho->ccp;
+    uint64_t period = 0xB0000;
+    uint64_t local_epoch = 0x1234567890ULL;
+    uint32_t guard = (uint32_t)ceil(uwb_usecs_to_dwt_usecs(MYNEWT_VAL(OS_LATENCY) + ccp->blink_frame_duration));
+    uint32_t near;
+
+    check(ccp, period, local_epoch, local_epoch + ((period / 4) << 16), uwb_dwt_usecs_to_usecs(3 * period / 4));
+    check(ccp, period, local_epoch, local_epoch + ((5 * period + period / 4) << 16), uwb_dwt_usecs_to_usecs(3 * period / 4));
+
+    /* Last blink before the wrap */
+    check(ccp, period, MASK40 + 1 - ((period / 8) << 16), (period / 8) << 16, uwb_dwt_usecs_to_usecs(3 * period / 4));
+
+    /* Next blink too close, the one after */
+    check(ccp, period, local_epoch, local_epoch + ((period - guard / 2) << 16),
+          (uint32_t)uwb_dwt_usecs_to_usecs(guard / 2) + (uint32_t)uwb_dwt_usecs_to_usecs(period));
+    near = (uint32_t)ceil(uwb_usecs_to_dwt_usecs(MYNEWT_VAL(OS_LATENCY) + ccp->blink_frame_duration / 2));
+    check(ccp, period, local_epoch, local_epoch + ((period - near) << 16),
+          (uint32_t)uwb_dwt_usecs_to_usecs(near) + (uint32_t)uwb_dwt_usecs_to_usecs(period));
+    check(ccp, period, local_epoch, local_epoch + ((period - 2 * guard) << 16), uwb_dwt_usecs_to_usecs(2 * guard));
+    ccp->status.master_pending = 0;
+}
@@ -0,0 +1,136 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file json_stream.h
+ * @brief Streaming JSON encoder for fixed schema records
+ *
+ * @details Records are written straight into a caller provided buffer, no
+ * per field callbacks and no printf. Integers, hex ids and fixed point floats
+ * are formatted inline. A record with a fixed schema is described once by a
+ * template, a table of literal fragments (keys and punctuation) and field
+ * references into a C struct, and written with a single call.
+ *
+ * Two buffer modes are supported:
+ * - linear: each completed record, or a full buffer, is handed to a flush
+ *   callback, typically the console.
+ * - ring: completed records are committed to a single producer, single
+ *   consumer ring and drained with json_stream_read(). A record that does not
+ *   fit is dropped whole, readers never see partial records.
+ *
+ * Output is byte for byte that of the json_encode based printers, FLOAT_USER
+ * floats are quoted with JSON_STREAM_DECIMALS digits and NaN as "nan",
+ * otherwise the raw ieee754 bits are written as an unsigned integer.
+ */
+
+#ifndef _JSON_STREAM_H_
+#define _JSON_STREAM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Flush callback for linear mode, returns bytes consumed
+typedef int (*json_stream_flush_t)(void * arg, const char * data, uint16_t len);
+
+//! Template field types
+typedef enum _json_tpl_op_t{
+    JSON_TPL_OP_END = 0,               //!< End of template
+    JSON_TPL_OP_LIT,                   //!< Literal fragment
+    JSON_TPL_OP_U16,                   //!< uint16_t, decimal
+    JSON_TPL_OP_U32,                   //!< uint32_t, decimal
+    JSON_TPL_OP_U64,                   //!< uint64_t, decimal
+    JSON_TPL_OP_I32,                   //!< int32_t, decimal
+    JSON_TPL_OP_HEX16,                 //!< uint16_t, four lower case hex digits
+    JSON_TPL_OP_FLOAT,                 //!< float, see json_stream_float()
+    JSON_TPL_OP_FLOAT_NULL,            //!< float, NaN written as "null" as in raz arrays
+}json_tpl_op_t;
+
+//! Template entry
+struct json_tpl {
+    uint8_t op;                        //!< json_tpl_op_t
+    uint8_t len;                       //!< Literal length
+    uint16_t offset;                   //!< Field offset in the record
+    const char * lit;                  //!< Literal fragment
+};
+
+#define JSON_TPL_LIT(__s) {JSON_TPL_OP_LIT, sizeof(__s) - 1, 0, (__s)}
+#define JSON_TPL_FIELD(__op, __type, __field) {(__op), 0, offsetof(__type, __field), NULL}
+#define JSON_TPL_END() {JSON_TPL_OP_END, 0, 0, NULL}
+
+//! Encoder status
+typedef struct _json_stream_status_t{
+    uint16_t ring:1;                   //!< Ring mode, else linear
+    uint16_t comma:1;                  //!< Next value needs a separator
+    uint16_t overflow:1;               //!< Current record did not fit
+}json_stream_status_t;
+
+//! Streaming encoder
+struct json_stream {
+    char * buf;                        //!< Caller buffer
+    uint16_t size;                     //!< Buffer size, a power of two in ring mode
+    uint16_t wr;                       //!< Write position, free running in ring mode
+    uint16_t head;                     //!< Committed records end here, ring mode
+    uint16_t tail;                     //!< Consumer position, ring mode
+    uint16_t mark;                     //!< Start of the current record, ring mode
+    json_stream_status_t status;       //!< Status
+    json_stream_flush_t flush;         //!< Flush callback, linear mode
+    void * arg;                        //!< Flush callback argument
+    uint32_t records;                  //!< Records completed
+    uint32_t dropped;                  //!< Records dropped or truncated
+    uint32_t bytes;                    //!< Bytes of completed records
+};
+
+void json_stream_init(struct json_stream * js, char * buf, uint16_t size, json_stream_flush_t flush, void * arg);
+int json_stream_ring_init(struct json_stream * js, char * buf, uint16_t size);
+uint16_t json_stream_read(struct json_stream * js, char * dst, uint16_t len);
+uint16_t json_stream_available(struct json_stream * js);
+
+void json_stream_record_start(struct json_stream * js);
+int json_stream_record_end(struct json_stream * js);
+void json_stream_flush(struct json_stream * js);
+
+void json_stream_write(struct json_stream * js, const char * data, uint16_t len);
+void json_stream_putc(struct json_stream * js, char c);
+void json_stream_put_uint(struct json_stream * js, uint64_t v);
+void json_stream_put_int(struct json_stream * js, int64_t v);
+void json_stream_put_hex(struct json_stream * js, uint32_t v, uint8_t ndigits);
+void json_stream_put_fixed(struct json_stream * js, float v, uint8_t decimals);
+
+void json_stream_object_start(struct json_stream * js);
+void json_stream_object_finish(struct json_stream * js);
+void json_stream_array_start(struct json_stream * js);
+void json_stream_array_finish(struct json_stream * js);
+void json_stream_key(struct json_stream * js, const char * key);
+void json_stream_uint(struct json_stream * js, uint64_t v);
+void json_stream_int(struct json_stream * js, int64_t v);
+void json_stream_hex16(struct json_stream * js, uint16_t v);
+void json_stream_string(struct json_stream * js, const char * str);
+void json_stream_float(struct json_stream * js, float v);
+
+void json_stream_template(struct json_stream * js, const struct json_tpl * tpl, const void * rec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _JSON_STREAM_H_ */
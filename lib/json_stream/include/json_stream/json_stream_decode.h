@@ -0,0 +1,115 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file json_stream_decode.h
+ * @brief Fast decode of the range and survey JSON records
+ *
+ * @details Counterpart of the rng_encode and survey_encode printers for
+ * gateways ingesting their output. Unlike json_read_object() no attribute
+ * table is walked: keys are resolved with a perfect hash over the known
+ * schema, the line is parsed in a single pass straight from the caller
+ * buffer and values land in fixed structs. Keys outside the schema are
+ * skipped, so records with extra fields still decode.
+ *
+ * Float fields are accepted both as FLOAT_USER quoted decimals ("nan" or
+ * "null" for NaN) and as unquoted ieee754 bit patterns.
+ */
+
+#ifndef _JSON_STREAM_DECODE_H_
+#define _JSON_STREAM_DECODE_H_
+
+#include <stdint.h>
+#include <syscfg/syscfg.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Decode result
+typedef enum _json_decode_err_t{
+    JSON_DECODE_OK = 0,                //!< Record decoded
+    JSON_DECODE_ERR_SYNTAX,            //!< Malformed JSON
+    JSON_DECODE_ERR_SCHEMA,            //!< Valid JSON but neither a range nor a survey record
+    JSON_DECODE_ERR_RANGE,             //!< Value or array too large for the record
+    JSON_DECODE_ERR_INCOMPLETE,        //!< Buffer ends inside the record
+}json_decode_err_t;
+
+//! Record types
+typedef enum _json_record_type_t{
+    JSON_RECORD_NONE = 0,
+    JSON_RECORD_TWR,                   //!< {"utime", "twr": {"rng", "uid"}, "uid", "diag"}
+    JSON_RECORD_RAZ,                   //!< {"utime", "twr": {"raz", "uid"}, "uid", "diag"}
+    JSON_RECORD_SURVEY,                //!< {"utime", "survey": {"seq", "mask", "nrngs"}}
+}json_record_type_t;
+
+//! Range record
+struct json_twr_record {
+    uint64_t utime;                    //!< Timestamp, usec
+    uint16_t uid;                      //!< Address reporting the range, outer "uid"
+    uint16_t peer;                     //!< Ranged address, twr "uid"
+    float rng;                         //!< Range, m, raz[0] for raz records
+    float raz[3];                      //!< Range, azimuth, zenith
+    float rssi;                        //!< Diag rssi, dBm
+    float los;                         //!< Diag line of sight estimate
+};
+
+//! Survey node entry
+struct json_survey_node {
+    uint32_t mask;                     //!< Nodes ranged by this node
+    uint16_t nrng;                     //!< Entries in rng
+    float rng[MYNEWT_VAL(JSON_STREAM_DECODE_MAX_NRNG)]; //!< Ranges, m
+};
+
+//! Survey record
+struct json_survey_record {
+    uint64_t utime;                    //!< Timestamp, usec
+    uint16_t seq;                      //!< Survey sequence number
+    uint32_t mask;                     //!< Nodes that responded
+    uint16_t nnodes;                   //!< Entries in nodes
+    struct json_survey_node nodes[MYNEWT_VAL(JSON_STREAM_DECODE_MAX_NODES)];
+};
+
+//! Fields present in the decoded record
+typedef struct _json_record_status_t{
+    uint16_t utime:1;                  //!< utime seen
+    uint16_t uid:1;                    //!< Outer uid seen
+    uint16_t peer:1;                   //!< twr uid seen
+    uint16_t diag:1;                   //!< diag object seen
+    uint16_t seq:1;                    //!< survey seq seen
+    uint16_t mask:1;                   //!< survey mask seen
+}json_record_status_t;
+
+//! Decoded record
+struct json_record {
+    json_record_type_t type;           //!< Record type
+    json_record_status_t status;       //!< Fields present
+    union {
+        struct json_twr_record twr;
+        struct json_survey_record survey;
+    };
+};
+
+json_decode_err_t json_stream_decode(const char * buf, uint32_t len, struct json_record * rec, uint32_t * consumed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _JSON_STREAM_DECODE_H_ */
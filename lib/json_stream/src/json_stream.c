@@ -0,0 +1,712 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file json_stream.c
+ * @brief Streaming JSON encoder for fixed schema records
+ */
+
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <syscfg/syscfg.h>
+#include <json_stream/json_stream.h>
+
+static const char g_hex[] = "0123456789abcdef";
+
+static const uint32_t g_pow10[] = {
+    1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL,
+    1000000UL, 10000000UL, 100000000UL, 1000000000UL
+};
+
+/**
+ * @fn json_stream_init(struct json_stream * js, char * buf, uint16_t size, json_stream_flush_t flush, void * arg)
+ * @brief Initialise a linear mode encoder. Completed records, and the buffer
+ * whenever it fills, are passed to flush. Without a flush callback records
+ * longer than the buffer are truncated and counted as dropped.
+ *
+ * @param js     Pointer to struct json_stream.
+ * @param buf    Buffer.
+ * @param size   Size of buf.
+ * @param flush  Flush callback, may be NULL.
+ * @param arg    Argument passed to flush.
+ *
+ * @return void
+ */
+void
+json_stream_init(struct json_stream * js, char * buf, uint16_t size, json_stream_flush_t flush, void * arg)
+{
+    memset(js, 0, sizeof(struct json_stream));
+    js->buf = buf;
+    js->size = size;
+    js->flush = flush;
+    js->arg = arg;
+}
+
+/**
+ * @fn json_stream_ring_init(struct json_stream * js, char * buf, uint16_t size)
+ * @brief Initialise a ring mode encoder. Records are committed whole and
+ * drained with json_stream_read(), a record that does not fit is dropped.
+ * One producer and one consumer may run concurrently.
+ *
+ * @param js     Pointer to struct json_stream.
+ * @param buf    Buffer.
+ * @param size   Size of buf, a power of two no larger than 32768.
+ *
+ * @return 0 on success, -1 if size is not a power of two
+ */
+int
+json_stream_ring_init(struct json_stream * js, char * buf, uint16_t size)
+{
+    if (size == 0 || (size & (size - 1)) != 0 || size > 0x8000)
+        return -1;
+    json_stream_init(js, buf, size, NULL, NULL);
+    js->status.ring = 1;
+    return 0;
+}
+
+/**
+ * @fn json_stream_available(struct json_stream * js)
+ * @brief Bytes of completed records waiting in the ring.
+ *
+ * @param js     Pointer to struct json_stream.
+ *
+ * @return bytes available
+ */
+uint16_t
+json_stream_available(struct json_stream * js)
+{
+    return (uint16_t)(js->head - js->tail);
+}
+
+/**
+ * @fn json_stream_read(struct json_stream * js, char * dst, uint16_t len)
+ * @brief Copy completed records out of the ring.
+ *
+ * @param js     Pointer to struct json_stream.
+ * @param dst    Destination.
+ * @param len    Size of dst.
+ *
+ * @return bytes copied
+ */
+uint16_t
+json_stream_read(struct json_stream * js, char * dst, uint16_t len)
+{
+    uint16_t mask = js->size - 1;
+    uint16_t n = json_stream_available(js);
+    uint16_t first;
+
+    if (n > len)
+        n = len;
+    first = js->size - (js->tail & mask);
+    if (first > n)
+        first = n;
+    memcpy(dst, &js->buf[js->tail & mask], first);
+    memcpy(dst + first, js->buf, n - first);
+    js->tail += n;
+    return n;
+}
+
+static void
+_linear_flush(struct json_stream * js)
+{
+    if (js->wr && js->flush) {
+        js->flush(js->arg, js->buf, js->wr);
+        js->bytes += js->wr;
+    }
+    js->wr = 0;
+}
+
+/**
+ * @fn json_stream_write(struct json_stream * js, const char * data, uint16_t len)
+ * @brief Append raw bytes to the current record.
+ *
+ * @param js     Pointer to struct json_stream.
+ * @param data   Bytes to append.
+ * @param len    Number of bytes.
+ *
+ * @return void
+ */
+void
+json_stream_write(struct json_stream * js, const char * data, uint16_t len)
+{
+    uint16_t n;
+
+    if (js->status.overflow)
+        return;
+
+    if (js->status.ring) {
+        uint16_t mask = js->size - 1;
+        if ((uint16_t)(js->size - (uint16_t)(js->wr - js->tail)) < len) {
+            js->status.overflow = 1;
+            return;
+        }
+        n = js->size - (js->wr & mask);
+        if (n > len)
+            n = len;
+        memcpy(&js->buf[js->wr & mask], data, n);
+        memcpy(js->buf, data + n, len - n);
+        js->wr += len;
+        return;
+    }
+
+    while (len) {
+        if (js->wr == js->size) {
+            if (js->flush == NULL) {
+                js->status.overflow = 1;
+                return;
+            }
+            _linear_flush(js);
+        }
+        n = js->size - js->wr;
+        if (n > len)
+            n = len;
+        memcpy(&js->buf[js->wr], data, n);
+        js->wr += n;
+        data += n;
+        len -= n;
+    }
+}
+
+/**
+ * @fn json_stream_putc(struct json_stream * js, char c)
+ * @brief Append a single character to the current record.
+ *
+ * @param js     Pointer to struct json_stream.
+ * @param c      Character.
+ *
+ * @return void
+ */
+void
+json_stream_putc(struct json_stream * js, char c)
+{
+    json_stream_write(js, &c, 1);
+}
+
+/**
+ * @fn json_stream_record_start(struct json_stream * js)
+ * @brief Start a record.
+ *
+ * @param js     Pointer to struct json_stream.
+ *
+ * @return void
+ */
+void
+json_stream_record_start(struct json_stream * js)
+{
+    js->status.comma = 0;
+    js->status.overflow = 0;
+    if (js->status.ring)
+        js->mark = js->wr = js->head;
+}
+
+/**
+ * @fn json_stream_record_end(struct json_stream * js)
+ * @brief Terminate the current record with a newline and commit it, in
+ * linear mode the record is flushed, in ring mode it becomes visible to
+ * json_stream_read().
+ *
+ * @param js     Pointer to struct json_stream.
+ *
+ * @return 0 on success, -1 if the record was dropped or truncated
+ */
+int
+json_stream_record_end(struct json_stream * js)
+{
+    int rc = 0;
+
+    json_stream_putc(js, '\n');
+    if (js->status.overflow) {
+        js->dropped++;
+        rc = -1;
+    }
+
+    if (js->status.ring) {
+        if (rc == 0) {
+            js->bytes += (uint16_t)(js->wr - js->mark);
+            js->head = js->wr;
+            js->records++;
+        } else {
+            js->wr = js->mark;
+        }
+    } else {
+        _linear_flush(js);
+        if (rc == 0)
+            js->records++;
+    }
+    js->status.overflow = 0;
+    return rc;
+}
+
+/**
+ * @fn json_stream_flush(struct json_stream * js)
+ * @brief Hand what has been written of the current record to the flush
+ * callback without ending it, for printers that emit a line in pieces.
+ * Linear mode only, a no-op in ring mode.
+ *
+ * @param js     Pointer to struct json_stream.
+ *
+ * @return void
+ */
+void
+json_stream_flush(struct json_stream * js)
+{
+    if (!js->status.ring && !js->status.overflow)
+        _linear_flush(js);
+}
+
+/**
+ * @fn json_stream_put_uint(struct json_stream * js, uint64_t v)
+ * @brief Append an unsigned integer in decimal.
+ *
+ * @param js     Pointer to struct json_stream.
+ * @param v      Value.
+ *
+ * @return void
+ */
+void
+json_stream_put_uint(struct json_stream * js, uint64_t v)
+{
+    char tmp[20];
+    uint8_t i = sizeof(tmp);
+
+    /* Only the upper digits need 64 bit division */
+    while (v > UINT32_MAX) {
+        tmp[--i] = '0' + (char)(v % 10);
+        v /= 10;
+    }
+    uint32_t v32 = (uint32_t)v;
+    do {
+        tmp[--i] = '0' + (char)(v32 % 10);
+        v32 /= 10;
+    } while (v32);
+    json_stream_write(js, &tmp[i], sizeof(tmp) - i);
+}
+
+/**
+ * @fn json_stream_put_int(struct json_stream * js, int64_t v)
+ * @brief Append a signed integer in decimal.
+ *
+ * @param js     Pointer to struct json_stream.
+ * @param v      Value.
+ *
+ * @return void
+ */
+void
+json_stream_put_int(struct json_stream * js, int64_t v)
+{
+    if (v < 0) {
+        json_stream_putc(js, '-');
+        json_stream_put_uint(js, -(uint64_t)v);
+    } else {
+        json_stream_put_uint(js, (uint64_t)v);
+    }
+}
+
+/**
+ * @fn json_stream_put_hex(struct json_stream * js, uint32_t v, uint8_t ndigits)
+ * @brief Append the low ndigits hex digits of v, lower case, zero padded.
+ *
+ * @param js      Pointer to struct json_stream.
+ * @param v       Value.
+ * @param ndigits Number of digits, at most 8.
+ *
+ * @return void
+ */
+void
+json_stream_put_hex(struct json_stream * js, uint32_t v, uint8_t ndigits)
+{
+    char tmp[8];
+
+    if (ndigits > sizeof(tmp))
+        ndigits = sizeof(tmp);
+    for (uint8_t i = ndigits; i > 0; i--) {
+        tmp[i - 1] = g_hex[v & 0xf];
+        v >>= 4;
+    }
+    json_stream_write(js, tmp, ndigits);
+}
+
+/*
+ * Round frac * scale to the nearest integer, ties to even as printf does.
+ * frac, in [0, 1), is exactly m * 2^-k with a 24 bit mantissa so the
+ * product is exact in 64 bits and no float rounding creeps into the digits.
+ */
+static uint32_t
+_scale_fraction(float frac, uint32_t scale)
+{
+    int e;
+    uint64_t prod, rem, half;
+    uint32_t q, k;
+
+    if (frac == 0.0f)
+        return 0;
+    prod = (uint64_t)(uint32_t)ldexpf(frexpf(frac, &e), 24) * scale;
+    k = 24 - e;
+    if (k > 63)
+        return 0;
+    q = (uint32_t)(prod >> k);
+    rem = prod & (((uint64_t)1 << k) - 1);
+    half = (uint64_t)1 << (k - 1);
+    if (rem > half || (rem == half && (q & 1)))
+        q++;
+    return q;
+}
+
+/**
+ * @fn json_stream_put_fixed(struct json_stream * js, float v, uint8_t decimals)
+ * @brief Append a float in fixed point notation, digit for digit what
+ * %.<decimals>f prints for the same value.
+ *
+ * @param js       Pointer to struct json_stream.
+ * @param v        Value.
+ * @param decimals Fractional digits, at most 9.
+ *
+ * @return void
+ */
+void
+json_stream_put_fixed(struct json_stream * js, float v, uint8_t decimals)
+{
+    char tmp[9];
+    uint32_t scale, frac;
+    uint64_t ip;
+
+    if (isnan(v)) {
+        json_stream_write(js, "nan", 3);
+        return;
+    }
+    if (signbit(v)) {
+        json_stream_putc(js, '-');
+        v = -v;
+    }
+    if (isinf(v) || v >= 18446744073709551616.0f) {
+        json_stream_write(js, "inf", 3);
+        return;
+    }
+    if (decimals > sizeof(tmp))
+        decimals = sizeof(tmp);
+
+    scale = g_pow10[decimals];
+    if (v < 4294967296.0f)
+        ip = (uint32_t)v;
+    else
+        ip = (uint64_t)v;
+    frac = _scale_fraction(v - (float)ip, scale);
+    if (frac >= scale) {
+        ip++;
+        frac -= scale;
+    }
+
+    json_stream_put_uint(js, ip);
+    if (decimals == 0)
+        return;
+    for (uint8_t i = decimals; i > 0; i--) {
+        tmp[i - 1] = '0' + (char)(frac % 10);
+        frac /= 10;
+    }
+    json_stream_putc(js, '.');
+    json_stream_write(js, tmp, decimals);
+}
+
+/*
+ * Float values follow the json_encode printers: with FLOAT_USER a quoted
+ * fixed point string, NaN as sprintf writes it or as "null" where the
+ * printer special cased it, otherwise the raw ieee754 bits.
+ */
+static void
+_put_float(struct json_stream * js, float v, bool nan_null)
+{
+#if MYNEWT_VAL(FLOAT_USER)
+    json_stream_putc(js, '"');
+    if (isnan(v) && nan_null)
+        json_stream_write(js, "null", 4);
+    else
+        json_stream_put_fixed(js, v, MYNEWT_VAL(JSON_STREAM_DECIMALS));
+    json_stream_putc(js, '"');
+#else
+    union {
+        float f;
+        uint32_t u;
+    } bits = {.f = v};
+    (void)nan_null;
+    json_stream_put_uint(js, bits.u);
+#endif
+}
+
+static void
+_put_hex16(struct json_stream * js, uint16_t v)
+{
+    json_stream_putc(js, '"');
+    json_stream_put_hex(js, v, 4);
+    json_stream_putc(js, '"');
+}
+
+static void
+_value_start(struct json_stream * js)
+{
+    if (js->status.comma)
+        json_stream_putc(js, ',');
+}
+
+/**
+ * @fn json_stream_object_start(struct json_stream * js)
+ * @brief Open an object.
+ *
+ * @param js     Pointer to struct json_stream.
+ *
+ * @return void
+ */
+void
+json_stream_object_start(struct json_stream * js)
+{
+    _value_start(js);
+    json_stream_putc(js, '{');
+    js->status.comma = 0;
+}
+
+/**
+ * @fn json_stream_object_finish(struct json_stream * js)
+ * @brief Close an object.
+ *
+ * @param js     Pointer to struct json_stream.
+ *
+ * @return void
+ */
+void
+json_stream_object_finish(struct json_stream * js)
+{
+    json_stream_putc(js, '}');
+    js->status.comma = 1;
+}
+
+/**
+ * @fn json_stream_array_start(struct json_stream * js)
+ * @brief Open an array, following json_stream_key().
+ *
+ * @param js     Pointer to struct json_stream.
+ *
+ * @return void
+ */
+void
+json_stream_array_start(struct json_stream * js)
+{
+    json_stream_putc(js, '[');
+    js->status.comma = 0;
+}
+
+/**
+ * @fn json_stream_array_finish(struct json_stream * js)
+ * @brief Close an array.
+ *
+ * @param js     Pointer to struct json_stream.
+ *
+ * @return void
+ */
+void
+json_stream_array_finish(struct json_stream * js)
+{
+    json_stream_putc(js, ']');
+    js->status.comma = 1;
+}
+
+/**
+ * @fn json_stream_key(struct json_stream * js, const char * key)
+ * @brief Write an object key, the key is not escaped.
+ *
+ * @param js     Pointer to struct json_stream.
+ * @param key    Key.
+ *
+ * @return void
+ */
+void
+json_stream_key(struct json_stream * js, const char * key)
+{
+    _value_start(js);
+    json_stream_putc(js, '"');
+    json_stream_write(js, key, strlen(key));
+    json_stream_write(js, "\": ", 3);
+    js->status.comma = 0;
+}
+
+/**
+ * @fn json_stream_uint(struct json_stream * js, uint64_t v)
+ * @brief Write an unsigned integer value.
+ *
+ * @param js     Pointer to struct json_stream.
+ * @param v      Value.
+ *
+ * @return void
+ */
+void
+json_stream_uint(struct json_stream * js, uint64_t v)
+{
+    _value_start(js);
+    json_stream_put_uint(js, v);
+    js->status.comma = 1;
+}
+
+/**
+ * @fn json_stream_int(struct json_stream * js, int64_t v)
+ * @brief Write a signed integer value.
+ *
+ * @param js     Pointer to struct json_stream.
+ * @param v      Value.
+ *
+ * @return void
+ */
+void
+json_stream_int(struct json_stream * js, int64_t v)
+{
+    _value_start(js);
+    json_stream_put_int(js, v);
+    js->status.comma = 1;
+}
+
+/**
+ * @fn json_stream_hex16(struct json_stream * js, uint16_t v)
+ * @brief Write a 16 bit id as a quoted four digit hex string.
+ *
+ * @param js     Pointer to struct json_stream.
+ * @param v      Value.
+ *
+ * @return void
+ */
+void
+json_stream_hex16(struct json_stream * js, uint16_t v)
+{
+    _value_start(js);
+    _put_hex16(js, v);
+    js->status.comma = 1;
+}
+
+/**
+ * @fn json_stream_string(struct json_stream * js, const char * str)
+ * @brief Write a string value, escaping quotes, backslashes and control
+ * characters.
+ *
+ * @param js     Pointer to struct json_stream.
+ * @param str    NUL terminated string.
+ *
+ * @return void
+ */
+void
+json_stream_string(struct json_stream * js, const char * str)
+{
+    const char * run = str;
+
+    _value_start(js);
+    json_stream_putc(js, '"');
+    for (; *str; str++) {
+        uint8_t c = (uint8_t)*str;
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+        json_stream_write(js, run, str - run);
+        run = str + 1;
+        json_stream_putc(js, '\\');
+        switch (c) {
+            case '"':
+            case '\\':
+                json_stream_putc(js, c);
+                break;
+            case '\n':
+                json_stream_putc(js, 'n');
+                break;
+            case '\r':
+                json_stream_putc(js, 'r');
+                break;
+            case '\t':
+                json_stream_putc(js, 't');
+                break;
+            default:
+                json_stream_write(js, "u00", 3);
+                json_stream_put_hex(js, c, 2);
+        }
+    }
+    json_stream_write(js, run, str - run);
+    json_stream_putc(js, '"');
+    js->status.comma = 1;
+}
+
+/**
+ * @fn json_stream_float(struct json_stream * js, float v)
+ * @brief Write a float value.
+ *
+ * @param js     Pointer to struct json_stream.
+ * @param v      Value.
+ *
+ * @return void
+ */
+void
+json_stream_float(struct json_stream * js, float v)
+{
+    _value_start(js);
+    _put_float(js, v, false);
+    js->status.comma = 1;
+}
+
+/**
+ * @fn json_stream_template(struct json_stream * js, const struct json_tpl * tpl, const void * rec)
+ * @brief Write rec as described by tpl. Literal fragments carry the keys
+ * and punctuation so the template alone determines the layout; the
+ * separator state of the structural helpers is not consulted.
+ *
+ * @param js     Pointer to struct json_stream.
+ * @param tpl    Template, terminated by JSON_TPL_END().
+ * @param rec    Record the template field offsets refer to.
+ *
+ * @return void
+ */
+void
+json_stream_template(struct json_stream * js, const struct json_tpl * tpl, const void * rec)
+{
+    const uint8_t * base = (const uint8_t *)rec;
+
+    for (; tpl->op != JSON_TPL_OP_END; tpl++) {
+        const void * field = base + tpl->offset;
+        switch (tpl->op) {
+            case JSON_TPL_OP_LIT:
+                json_stream_write(js, tpl->lit, tpl->len);
+                break;
+            case JSON_TPL_OP_U16:
+                json_stream_put_uint(js, *(const uint16_t *)field);
+                break;
+            case JSON_TPL_OP_U32:
+                json_stream_put_uint(js, *(const uint32_t *)field);
+                break;
+            case JSON_TPL_OP_U64:
+                json_stream_put_uint(js, *(const uint64_t *)field);
+                break;
+            case JSON_TPL_OP_I32:
+                json_stream_put_int(js, *(const int32_t *)field);
+                break;
+            case JSON_TPL_OP_HEX16:
+                _put_hex16(js, *(const uint16_t *)field);
+                break;
+            case JSON_TPL_OP_FLOAT:
+                _put_float(js, *(const float *)field, false);
+                break;
+            case JSON_TPL_OP_FLOAT_NULL:
+                _put_float(js, *(const float *)field, true);
+                break;
+            default:
+                break;
+        }
+    }
+    js->status.comma = 1;
+}
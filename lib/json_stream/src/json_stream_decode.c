@@ -0,0 +1,716 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file json_stream_decode.c
+ * @brief Fast decode of the range and survey JSON records
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <math.h>
+#include <json_stream/json_stream_decode.h>
+
+//! Schema keys
+enum {
+    KEY_UTIME,
+    KEY_TWR,
+    KEY_RNG,
+    KEY_RAZ,
+    KEY_UID,
+    KEY_DIAG,
+    KEY_RSSI,
+    KEY_LOS,
+    KEY_SURVEY,
+    KEY_SEQ,
+    KEY_MASK,
+    KEY_NRNGS,
+    KEY_NRNG,
+    KEY_UNKNOWN = 0xfe,
+    KEY_END = 0xff
+};
+
+struct json_key {
+    const char * name;
+    uint8_t len;
+    uint8_t id;
+};
+
+/*
+ * Perfect hash of the schema keys over first character, last character and
+ * length; every key has a slot of its own so a lookup is one compare.
+ */
+#define KEY_HASH(__s, __n) \
+    (((uint8_t)(__s)[0] * 7 + (uint8_t)(__s)[(__n) - 1] * 21 + (__n)) >> 2 & 0xf)
+
+static const struct json_key g_keys[16] = {
+    [0] = {"utime", 5, KEY_UTIME},
+    [1] = {"mask", 4, KEY_MASK},
+    [2] = {"twr", 3, KEY_TWR},
+    [5] = {"rng", 3, KEY_RNG},
+    [6] = {"survey", 6, KEY_SURVEY},
+    [8] = {"raz", 3, KEY_RAZ},
+    [9] = {"los", 3, KEY_LOS},
+    [10] = {"uid", 3, KEY_UID},
+    [11] = {"seq", 3, KEY_SEQ},
+    [12] = {"diag", 4, KEY_DIAG},
+    [13] = {"nrngs", 5, KEY_NRNGS},
+    [14] = {"nrng", 4, KEY_NRNG},
+    [15] = {"rssi", 4, KEY_RSSI},
+};
+
+static const double g_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+    1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
+
+struct parser {
+    const char * p;
+    const char * end;
+};
+
+static json_decode_err_t
+ws(struct parser * ps)
+{
+    while (ps->p < ps->end && (*ps->p == ' ' || *ps->p == '\t' || *ps->p == '\r'))
+        ps->p++;
+    return ps->p < ps->end ? JSON_DECODE_OK : JSON_DECODE_ERR_INCOMPLETE;
+}
+
+static json_decode_err_t
+expect(struct parser * ps, char c)
+{
+    json_decode_err_t rc = ws(ps);
+    if (rc != JSON_DECODE_OK)
+        return rc;
+    if (*ps->p != c)
+        return JSON_DECODE_ERR_SYNTAX;
+    ps->p++;
+    return JSON_DECODE_OK;
+}
+
+/* Called past the opening quote, leaves p past the closing quote */
+static json_decode_err_t
+skip_string(struct parser * ps)
+{
+    while (ps->p < ps->end) {
+        char c = *ps->p++;
+        if (c == '"')
+            return JSON_DECODE_OK;
+        if (c == '\\') {
+            if (ps->p == ps->end)
+                break;
+            if (*ps->p == '\0' || !strchr("\"\\/bfnrtu", *ps->p++))
+                return JSON_DECODE_ERR_SYNTAX;
+        } else if ((uint8_t)c < 0x20)
+            return JSON_DECODE_ERR_SYNTAX;
+    }
+    return JSON_DECODE_ERR_INCOMPLETE;
+}
+
+static bool
+is_delim(char c)
+{
+    return c == ',' || c == '}' || c == ']' || c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool
+match(struct parser * ps, const char * lit, uint8_t len)
+{
+    if (ps->end - ps->p < len || memcmp(ps->p, lit, len) != 0)
+        return false;
+    ps->p += len;
+    return true;
+}
+
+static json_decode_err_t member(struct parser * ps, bool * first, uint8_t * id);
+static json_decode_err_t element(struct parser * ps, bool * first, bool * end);
+static json_decode_err_t parse_decimal(struct parser * ps, bool quoted, double * v);
+
+#define SKIP_MAX_DEPTH (8)
+
+/*
+ * Skip a value of any type, validating it on the way so a record is only
+ * accepted if it is well formed JSON throughout.
+ */
+static json_decode_err_t
+skip_value(struct parser * ps, uint8_t depth)
+{
+    json_decode_err_t rc = ws(ps);
+    bool first = true, end = false;
+    uint8_t id;
+    double d;
+
+    if (rc != JSON_DECODE_OK)
+        return rc;
+    if (depth == SKIP_MAX_DEPTH)
+        return JSON_DECODE_ERR_RANGE;
+
+    switch (*ps->p) {
+        case '"':
+            ps->p++;
+            return skip_string(ps);
+        case '{':
+            ps->p++;
+            while ((rc = member(ps, &first, &id)) == JSON_DECODE_OK && id != KEY_END)
+                if ((rc = skip_value(ps, depth + 1)) != JSON_DECODE_OK)
+                    break;
+            return rc;
+        case '[':
+            ps->p++;
+            while ((rc = element(ps, &first, &end)) == JSON_DECODE_OK && !end)
+                if ((rc = skip_value(ps, depth + 1)) != JSON_DECODE_OK)
+                    break;
+            return rc;
+        case 't':
+        case 'f':
+        case 'n':
+            if (!match(ps, "true", 4) && !match(ps, "false", 5) && !match(ps, "null", 4))
+                return ps->end - ps->p < 5 ? JSON_DECODE_ERR_INCOMPLETE : JSON_DECODE_ERR_SYNTAX;
+            if (ps->p == ps->end)
+                return JSON_DECODE_ERR_INCOMPLETE;
+            return is_delim(*ps->p) ? JSON_DECODE_OK : JSON_DECODE_ERR_SYNTAX;
+        default:
+            return parse_decimal(ps, false, &d);
+    }
+}
+
+static json_decode_err_t
+parse_key(struct parser * ps, uint8_t * id)
+{
+    json_decode_err_t rc = expect(ps, '"');
+    const char * start = ps->p;
+    uint8_t n;
+
+    if (rc != JSON_DECODE_OK)
+        return rc;
+    while (ps->p < ps->end && *ps->p != '"' && *ps->p != '\\')
+        ps->p++;
+    if (ps->p == ps->end)
+        return JSON_DECODE_ERR_INCOMPLETE;
+
+    *id = KEY_UNKNOWN;
+    if (*ps->p == '\\') {
+        /* No schema key needs escaping */
+        rc = skip_string(ps);
+        if (rc != JSON_DECODE_OK)
+            return rc;
+    } else {
+        if (ps->p - start > 0 && ps->p - start <= 6) {
+            n = (uint8_t)(ps->p - start);
+            const struct json_key * key = &g_keys[KEY_HASH(start, n)];
+            if (key->len == n && memcmp(key->name, start, n) == 0)
+                *id = key->id;
+        }
+        ps->p++;
+    }
+    return expect(ps, ':');
+}
+
+/*
+ * Object member iterator, call with first set after the opening brace.
+ * Returns KEY_END in id once the closing brace is consumed.
+ */
+static json_decode_err_t
+member(struct parser * ps, bool * first, uint8_t * id)
+{
+    json_decode_err_t rc = ws(ps);
+
+    if (rc != JSON_DECODE_OK)
+        return rc;
+    if (*ps->p == '}') {
+        ps->p++;
+        *id = KEY_END;
+        return JSON_DECODE_OK;
+    }
+    if (!*first) {
+        if (*ps->p != ',')
+            return JSON_DECODE_ERR_SYNTAX;
+        ps->p++;
+    }
+    *first = false;
+    return parse_key(ps, id);
+}
+
+/* Array element iterator, same convention as member() */
+static json_decode_err_t
+element(struct parser * ps, bool * first, bool * end)
+{
+    json_decode_err_t rc = ws(ps);
+
+    if (rc != JSON_DECODE_OK)
+        return rc;
+    *end = false;
+    if (*ps->p == ']') {
+        ps->p++;
+        *end = true;
+        return JSON_DECODE_OK;
+    }
+    if (!*first) {
+        if (*ps->p != ',')
+            return JSON_DECODE_ERR_SYNTAX;
+        ps->p++;
+    }
+    *first = false;
+    return JSON_DECODE_OK;
+}
+
+static json_decode_err_t
+parse_uint(struct parser * ps, uint64_t * v, uint64_t max)
+{
+    json_decode_err_t rc = ws(ps);
+    uint64_t x = 0;
+
+    if (rc != JSON_DECODE_OK)
+        return rc;
+    if (*ps->p < '0' || *ps->p > '9')
+        return JSON_DECODE_ERR_SYNTAX;
+    if (*ps->p == '0' && ps->p + 1 < ps->end && ps->p[1] >= '0' && ps->p[1] <= '9')
+        return JSON_DECODE_ERR_SYNTAX;
+    while (ps->p < ps->end && *ps->p >= '0' && *ps->p <= '9') {
+        uint8_t d = *ps->p++ - '0';
+        if (x > (max - d) / 10)
+            return JSON_DECODE_ERR_RANGE;
+        x = x * 10 + d;
+    }
+    if (ps->p == ps->end)
+        return JSON_DECODE_ERR_INCOMPLETE;
+    if (!is_delim(*ps->p))
+        return JSON_DECODE_ERR_SYNTAX;
+    *v = x;
+    return JSON_DECODE_OK;
+}
+
+static json_decode_err_t
+parse_u32(struct parser * ps, uint32_t * v)
+{
+    uint64_t x;
+    json_decode_err_t rc = parse_uint(ps, &x, UINT32_MAX);
+    if (rc == JSON_DECODE_OK)
+        *v = (uint32_t)x;
+    return rc;
+}
+
+static json_decode_err_t
+parse_hex16(struct parser * ps, uint16_t * v)
+{
+    json_decode_err_t rc = expect(ps, '"');
+    uint32_t x = 0;
+    uint8_t n = 0;
+
+    if (rc != JSON_DECODE_OK)
+        return rc;
+    for (; ps->p < ps->end && *ps->p != '"'; ps->p++, n++) {
+        char c = *ps->p;
+        if (n == 4)
+            return JSON_DECODE_ERR_RANGE;
+        if (c >= '0' && c <= '9')
+            x = x << 4 | (c - '0');
+        else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+            x = x << 4 | ((c | 0x20) - 'a' + 10);
+        else
+            return JSON_DECODE_ERR_SYNTAX;
+    }
+    if (ps->p == ps->end)
+        return JSON_DECODE_ERR_INCOMPLETE;
+    if (n == 0)
+        return JSON_DECODE_ERR_SYNTAX;
+    ps->p++;
+    *v = (uint16_t)x;
+    return JSON_DECODE_OK;
+}
+
+/*
+ * Decimal number at p, ending at the first delimiter (or quote when quoted).
+ * Up to 15 significant digits without exponent, which covers everything the
+ * encoders emit, the value is the correctly rounded quotient of two exact
+ * doubles and so identical to strtod(). Anything else falls back to strtod.
+ */
+static json_decode_err_t
+parse_decimal(struct parser * ps, bool quoted, double * v)
+{
+    const char * start = ps->p;
+    const char * q = ps->p;
+    bool neg = false;
+    uint64_t mant = 0;
+    uint8_t ndigits = 0, nfrac = 0;
+    bool dot = false, slow = false;
+
+    if (q < ps->end && *q == '-') {
+        neg = true;
+        q++;
+    }
+    if (q + 1 >= ps->end)
+        return JSON_DECODE_ERR_INCOMPLETE;
+    if (*q < '0' || *q > '9' || (q[0] == '0' && q[1] >= '0' && q[1] <= '9'))
+        return JSON_DECODE_ERR_SYNTAX;
+    for (; q < ps->end; q++) {
+        char c = *q;
+        if (c >= '0' && c <= '9') {
+            if (ndigits == 15 || nfrac == 15) {
+                slow = true;
+                continue;
+            }
+            if (mant || c != '0')
+                ndigits++;
+            mant = mant * 10 + (c - '0');
+            nfrac += dot;
+        } else if (c == '.' && !dot) {
+            dot = true;
+        } else if (c == 'e' || c == 'E' || c == '+' || (c == '-' && q > start)) {
+            slow = true;
+        } else {
+            break;
+        }
+    }
+    if (q == ps->end)
+        return JSON_DECODE_ERR_INCOMPLETE;
+    if (quoted ? *q != '"' : !is_delim(*q))
+        return JSON_DECODE_ERR_SYNTAX;
+    if (q == start + neg || q[-1] == '.')
+        return JSON_DECODE_ERR_SYNTAX;
+
+    if (slow) {
+        char tmp[64];
+        char * tail;
+        if (q - start >= (long)sizeof(tmp))
+            return JSON_DECODE_ERR_RANGE;
+        memcpy(tmp, start, q - start);
+        tmp[q - start] = '\0';
+        *v = strtod(tmp, &tail);
+        if (*tail != '\0')
+            return JSON_DECODE_ERR_SYNTAX;
+    } else {
+        *v = (double)mant / g_pow10[nfrac];
+        if (neg)
+            *v = -*v;
+    }
+    ps->p = q;
+    return JSON_DECODE_OK;
+}
+
+/*
+ * Float field, FLOAT_USER quoted decimal or unquoted ieee754 bits. An
+ * unquoted number with a fraction or sign is taken as a plain decimal.
+ */
+static json_decode_err_t
+parse_float(struct parser * ps, float * v)
+{
+    json_decode_err_t rc = ws(ps);
+    double d;
+
+    if (rc != JSON_DECODE_OK)
+        return rc;
+
+    if (*ps->p == '"') {
+        ps->p++;
+        if (match(ps, "null\"", 5) || match(ps, "nan\"", 4) || match(ps, "-nan\"", 5)) {
+            *v = NAN;
+            return JSON_DECODE_OK;
+        }
+        if (match(ps, "inf\"", 4)) {
+            *v = INFINITY;
+            return JSON_DECODE_OK;
+        }
+        if (match(ps, "-inf\"", 5)) {
+            *v = -INFINITY;
+            return JSON_DECODE_OK;
+        }
+        rc = parse_decimal(ps, true, &d);
+        if (rc != JSON_DECODE_OK)
+            return rc;
+        ps->p++;
+        *v = (float)d;
+        return JSON_DECODE_OK;
+    }
+    if (match(ps, "null", 4)) {
+        *v = NAN;
+        return JSON_DECODE_OK;
+    }
+
+    const char * q = ps->p;
+    while (q < ps->end && *q >= '0' && *q <= '9')
+        q++;
+    if (q < ps->end && q > ps->p && is_delim(*q)) {
+        union {
+            float f;
+            uint32_t u;
+        } bits;
+        rc = parse_u32(ps, &bits.u);
+        if (rc == JSON_DECODE_OK)
+            *v = bits.f;
+        return rc;
+    }
+    rc = parse_decimal(ps, false, &d);
+    if (rc == JSON_DECODE_OK)
+        *v = (float)d;
+    return rc;
+}
+
+static json_decode_err_t
+parse_float_array(struct parser * ps, float * dst, uint16_t max, uint16_t * n)
+{
+    json_decode_err_t rc = expect(ps, '[');
+    bool first = true, end;
+
+    *n = 0;
+    while (rc == JSON_DECODE_OK) {
+        rc = element(ps, &first, &end);
+        if (rc != JSON_DECODE_OK || end)
+            break;
+        if (*n == max)
+            return JSON_DECODE_ERR_RANGE;
+        rc = parse_float(ps, &dst[(*n)++]);
+    }
+    return rc;
+}
+
+static json_decode_err_t
+parse_twr(struct parser * ps, struct json_record * rec)
+{
+    json_decode_err_t rc = expect(ps, '{');
+    bool first = true;
+    uint8_t id;
+    uint16_t n;
+
+    while (rc == JSON_DECODE_OK) {
+        rc = member(ps, &first, &id);
+        if (rc != JSON_DECODE_OK || id == KEY_END)
+            break;
+        switch (id) {
+            case KEY_RNG:
+                rc = parse_float(ps, &rec->twr.rng);
+                rec->type = JSON_RECORD_TWR;
+                break;
+            case KEY_RAZ:
+                rc = parse_float_array(ps, rec->twr.raz, 3, &n);
+                if (rc == JSON_DECODE_OK && n > 0)
+                    rec->twr.rng = rec->twr.raz[0];
+                rec->type = JSON_RECORD_RAZ;
+                break;
+            case KEY_UID:
+                rc = parse_hex16(ps, &rec->twr.peer);
+                rec->status.peer = 1;
+                break;
+            default:
+                rc = skip_value(ps, 0);
+        }
+    }
+    if (rc == JSON_DECODE_OK && rec->type == JSON_RECORD_NONE)
+        rc = JSON_DECODE_ERR_SCHEMA;
+    return rc;
+}
+
+static json_decode_err_t
+parse_diag(struct parser * ps, struct json_record * rec)
+{
+    json_decode_err_t rc = expect(ps, '{');
+    bool first = true;
+    uint8_t id;
+
+    while (rc == JSON_DECODE_OK) {
+        rc = member(ps, &first, &id);
+        if (rc != JSON_DECODE_OK || id == KEY_END)
+            break;
+        switch (id) {
+            case KEY_RSSI:
+                rc = parse_float(ps, &rec->twr.rssi);
+                break;
+            case KEY_LOS:
+                rc = parse_float(ps, &rec->twr.los);
+                break;
+            default:
+                rc = skip_value(ps, 0);
+        }
+    }
+    rec->status.diag = 1;
+    return rc;
+}
+
+static json_decode_err_t
+parse_node(struct parser * ps, struct json_survey_node * node)
+{
+    json_decode_err_t rc = expect(ps, '{');
+    bool first = true;
+    uint8_t id;
+
+    node->mask = 0;
+    node->nrng = 0;
+    while (rc == JSON_DECODE_OK) {
+        rc = member(ps, &first, &id);
+        if (rc != JSON_DECODE_OK || id == KEY_END)
+            break;
+        switch (id) {
+            case KEY_MASK:
+                rc = parse_u32(ps, &node->mask);
+                break;
+            case KEY_NRNG:
+                rc = parse_float_array(ps, node->rng, MYNEWT_VAL(JSON_STREAM_DECODE_MAX_NRNG), &node->nrng);
+                break;
+            default:
+                rc = skip_value(ps, 0);
+        }
+    }
+    return rc;
+}
+
+static json_decode_err_t
+parse_survey(struct parser * ps, struct json_record * rec)
+{
+    json_decode_err_t rc = expect(ps, '{');
+    struct json_survey_record * survey = &rec->survey;
+    bool first = true, efirst, end;
+    uint8_t id;
+    uint64_t x;
+
+    while (rc == JSON_DECODE_OK) {
+        rc = member(ps, &first, &id);
+        if (rc != JSON_DECODE_OK || id == KEY_END)
+            break;
+        switch (id) {
+            case KEY_SEQ:
+                rc = parse_uint(ps, &x, UINT16_MAX);
+                survey->seq = (uint16_t)x;
+                rec->status.seq = 1;
+                break;
+            case KEY_MASK:
+                rc = parse_u32(ps, &survey->mask);
+                rec->status.mask = 1;
+                break;
+            case KEY_NRNGS:
+                rc = expect(ps, '[');
+                efirst = true;
+                survey->nnodes = 0;
+                while (rc == JSON_DECODE_OK) {
+                    rc = element(ps, &efirst, &end);
+                    if (rc != JSON_DECODE_OK || end)
+                        break;
+                    if (survey->nnodes == MYNEWT_VAL(JSON_STREAM_DECODE_MAX_NODES))
+                        return JSON_DECODE_ERR_RANGE;
+                    rc = parse_node(ps, &survey->nodes[survey->nnodes++]);
+                }
+                break;
+            default:
+                rc = skip_value(ps, 0);
+        }
+    }
+    return rc;
+}
+
+/**
+ * @fn json_stream_decode(const char * buf, uint32_t len, struct json_record * rec, uint32_t * consumed)
+ * @brief Decode one range or survey record from buf. Leading whitespace and
+ * the terminating newline are consumed, so a buffer of concatenated lines
+ * can be walked by advancing consumed bytes per call.
+ *
+ * @param buf      Buffer, need not be NUL terminated.
+ * @param len      Bytes in buf.
+ * @param rec      Decoded record.
+ * @param consumed Bytes consumed. On JSON_DECODE_ERR_INCOMPLETE 0, on other
+ *                 errors up to and including the newline ending the record's
+ *                 line, so the caller skips the offending line only.
+ *
+ * @return json_decode_err_t
+ */
+json_decode_err_t
+json_stream_decode(const char * buf, uint32_t len, struct json_record * rec, uint32_t * consumed)
+{
+    struct parser ps = {.p = buf, .end = buf + len};
+    json_decode_err_t rc;
+    bool first = true;
+    bool twr = false;
+    uint64_t utime = 0;
+    const char * nl;
+    uint8_t id;
+
+    memset(rec, 0, offsetof(struct json_record, survey.nodes));
+    memset(&rec->twr, 0, sizeof(rec->twr));
+
+    /* Parse within the record's own line, a broken line must not reach into the next */
+    while (ps.p < ps.end && (*ps.p == ' ' || *ps.p == '\t' || *ps.p == '\r' || *ps.p == '\n'))
+        ps.p++;
+    nl = memchr(ps.p, '\n', ps.end - ps.p);
+    if (nl)
+        ps.end = nl;
+
+    rc = expect(&ps, '{');
+    while (rc == JSON_DECODE_OK) {
+        rc = member(&ps, &first, &id);
+        if (rc != JSON_DECODE_OK || id == KEY_END)
+            break;
+        /* twr and survey fields share storage, a record holds one or the other */
+        if ((id == KEY_TWR || id == KEY_UID || id == KEY_DIAG) && rec->type == JSON_RECORD_SURVEY)
+            rc = JSON_DECODE_ERR_SCHEMA;
+        else if (id == KEY_SURVEY && (twr || rec->type != JSON_RECORD_NONE))
+            rc = JSON_DECODE_ERR_SCHEMA;
+        if (rc != JSON_DECODE_OK)
+            break;
+
+        switch (id) {
+            case KEY_UTIME:
+                rc = parse_uint(&ps, &utime, UINT64_MAX);
+                rec->status.utime = 1;
+                break;
+            case KEY_TWR:
+                rc = parse_twr(&ps, rec);
+                twr = true;
+                break;
+            case KEY_UID:
+                rc = parse_hex16(&ps, &rec->twr.uid);
+                rec->status.uid = 1;
+                twr = true;
+                break;
+            case KEY_DIAG:
+                rc = parse_diag(&ps, rec);
+                twr = true;
+                break;
+            case KEY_SURVEY:
+                rc = parse_survey(&ps, rec);
+                rec->type = JSON_RECORD_SURVEY;
+                break;
+            default:
+                rc = skip_value(&ps, 0);
+        }
+    }
+
+    if (rc == JSON_DECODE_OK && (rec->type == JSON_RECORD_NONE || (twr && rec->type == JSON_RECORD_SURVEY)))
+        rc = JSON_DECODE_ERR_SCHEMA;
+
+    if (rc == JSON_DECODE_OK) {
+        if (rec->type == JSON_RECORD_SURVEY)
+            rec->survey.utime = utime;
+        else
+            rec->twr.utime = utime;
+        while (ps.p < ps.end && (*ps.p == ' ' || *ps.p == '\t' || *ps.p == '\r'))
+            ps.p++;
+        if (ps.p < ps.end)
+            rc = JSON_DECODE_ERR_SYNTAX;
+    }
+    /* A line cut short is broken, only the buffer end leaves a record incomplete */
+    if (rc == JSON_DECODE_ERR_INCOMPLETE && nl)
+        rc = JSON_DECODE_ERR_SYNTAX;
+
+    if (rc == JSON_DECODE_ERR_INCOMPLETE)
+        *consumed = 0;
+    else
+        *consumed = nl ? (uint32_t)(nl + 1 - buf) : len;
+    return rc;
+}
@@ -0,0 +1,53 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "json_stream_test.h"
+
+TEST_CASE_DECL(json_encode_float_test)
+TEST_CASE_DECL(json_encode_flush_test)
+TEST_CASE_DECL(json_decode_twr_test)
+TEST_CASE_DECL(json_decode_survey_test)
+TEST_CASE_DECL(json_decode_resync_test)
+TEST_CASE_DECL(json_decode_fuzz_test)
+TEST_CASE_DECL(json_decode_bench_test)
+TEST_CASE_DECL(json_encode_bench_test)
+
+TEST_SUITE(json_stream_test_all)
+{
+    json_encode_float_test();
+    json_encode_flush_test();
+    json_decode_twr_test();
+    json_decode_survey_test();
+    json_decode_resync_test();
+    json_decode_fuzz_test();
+    json_decode_bench_test();
+    json_encode_bench_test();
+}
+
+#if MYNEWT_VAL(SELFTEST)
+int
+main(int argc, char **argv)
+{
+    sysinit();
+
+    json_stream_test_all();
+
+    return tu_any_failed;
+}
+#endif
@@ -0,0 +1,45 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _JSON_STREAM_TEST_H
+#define _JSON_STREAM_TEST_H
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "testutil/testutil.h"
+
+#include "json_stream/json_stream.h"
+#include "json_stream/json_stream_decode.h"
+#include "json/json.h"
+
+/* Decode a whole NUL terminated buffer as one call */
+static inline json_decode_err_t
+json_test_decode(const char * s, struct json_record * rec, uint32_t * consumed)
+{
+    return json_stream_decode(s, strlen(s), rec, consumed);
+}
+
+#endif /* _JSON_STREAM_TEST_H */
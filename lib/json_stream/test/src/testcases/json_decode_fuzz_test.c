@@ -0,0 +1,319 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "json_stream_test.h"
+
+/*
+ * Records are generated with known values, in random key order, with
+ * random spacing and unknown members, then decoded whole, truncated and
+ * with bytes mutated. The generator is the oracle: values are compared with
+ * the strtod() of the text written.
+ */
+
+#define FUZZ_RECORDS (5000)
+#define FUZZ_LINE (640)
+
+static uint32_t g_seed;
+
+static uint32_t
+rnd(void)
+{
+    g_seed ^= g_seed << 13;
+    g_seed ^= g_seed >> 17;
+    g_seed ^= g_seed << 5;
+    return g_seed;
+}
+
+struct gen {
+    char * p;
+    char * end;
+};
+
+static void
+put(struct gen * g, const char * fmt, ...)
+{
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = vsnprintf(g->p, g->end - g->p, fmt, ap);
+    va_end(ap);
+    g->p += n < g->end - g->p ? n : g->end - g->p - 1;
+}
+
+static void
+sp(struct gen * g)
+{
+    static const char * ws[] = {"", "", " ", "  ", "\t", " \r"};
+    put(g, "%s", ws[rnd() % 6]);
+}
+
+static void
+sep(struct gen * g, int * n)
+{
+    if ((*n)++)
+        put(g, ",");
+    sp(g);
+}
+
+static void
+unknown(struct gen * g, int * n)
+{
+    static const char * vals[] = {"null", "true", "false", "-12.5e3", "\"a\\\"b\"",
+                                  "[1, [2], {}]", "{\"rng\": \"9\", \"x\": [null]}"};
+    static const char * keys[] = {"x", "rn", "utimes", "twrx", "s\\\"x"};
+    if (rnd() % 4)
+        return;
+    sep(g, n);
+    put(g, "\"%s\":", keys[rnd() % 5]);
+    sp(g);
+    put(g, "%s", vals[rnd() % 7]);
+}
+
+/* Float in either encoding, returns the value it denotes */
+static float
+gen_float(struct gen * g)
+{
+    union {
+        float f;
+        uint32_t u;
+    } bits;
+    char tmp[32];
+
+    switch (rnd() % 8) {
+        case 0:
+            put(g, "\"null\"");
+            return NAN;
+        case 1:
+            bits.f = (float)(rnd() % 100000) / 64.0f;
+            put(g, "%lu", (unsigned long)bits.u);
+            return bits.f;
+        default:
+            snprintf(tmp, sizeof(tmp), "%.*f", (int)(rnd() % 7), ((int32_t)rnd() % 1000000) / 1000.0);
+            put(g, "\"%s\"", tmp);
+            return (float)strtod(tmp, NULL);
+    }
+}
+
+static bool
+same(float a, float b)
+{
+    return (isnan(a) && isnan(b)) || a == b;
+}
+
+static void
+gen_twr(struct gen * g, struct json_record * ref)
+{
+    int order[4] = {0, 1, 2, 3};
+    int i, j, k, n = 0, m;
+
+    ref->type = rnd() % 2 ? JSON_RECORD_TWR : JSON_RECORD_RAZ;
+    ref->twr.utime = ((uint64_t)rnd() << 16) ^ rnd();
+    ref->twr.uid = rnd();
+    ref->twr.peer = rnd();
+    ref->twr.rssi = ref->twr.los = 0;
+    for (i = 3; i > 0; i--) {
+        j = rnd() % (i + 1);
+        k = order[i]; order[i] = order[j]; order[j] = k;
+    }
+
+    put(g, "{");
+    for (i = 0; i < 4; i++) {
+        unknown(g, &n);
+        sep(g, &n);
+        switch (order[i]) {
+            case 0:
+                put(g, "\"utime\": %llu", (unsigned long long)ref->twr.utime);
+                break;
+            case 1:
+                put(g, "\"twr\": {");
+                m = 0;
+                unknown(g, &m);
+                sep(g, &m);
+                if (ref->type == JSON_RECORD_TWR) {
+                    put(g, "\"rng\": ");
+                    ref->twr.rng = gen_float(g);
+                } else {
+                    put(g, "\"raz\": [");
+                    for (k = 0; k < 3; k++) {
+                        if (k)
+                            put(g, ",");
+                        sp(g);
+                        ref->twr.raz[k] = gen_float(g);
+                    }
+                    put(g, "]");
+                    ref->twr.rng = ref->twr.raz[0];
+                }
+                sep(g, &m);
+                put(g, rnd() % 2 ? "\"uid\": \"%x\"" : "\"uid\": \"%X\"", ref->twr.peer);
+                unknown(g, &m);
+                sp(g);
+                put(g, "}");
+                break;
+            case 2:
+                put(g, "\"uid\": \"%04x\"", ref->twr.uid);
+                break;
+            case 3:
+                put(g, "\"diag\": {\"rssi\": ");
+                ref->twr.rssi = gen_float(g);
+                put(g, ",");
+                sp(g);
+                put(g, "\"los\": ");
+                ref->twr.los = gen_float(g);
+                put(g, "}");
+                break;
+        }
+    }
+    unknown(g, &n);
+    sp(g);
+    put(g, "}");
+}
+
+static void
+gen_survey(struct gen * g, struct json_record * ref)
+{
+    struct json_survey_record * s = &ref->survey;
+    uint16_t i, k;
+
+    ref->type = JSON_RECORD_SURVEY;
+    s->utime = rnd();
+    s->seq = rnd();
+    s->mask = rnd();
+    s->nnodes = rnd() % 5;
+    put(g, "{\"utime\": %llu,\"survey\": {\"seq\": %u,", (unsigned long long)s->utime, s->seq);
+    sp(g);
+    put(g, "\"mask\": %lu,\"nrngs\": [", (unsigned long)s->mask);
+    for (i = 0; i < s->nnodes; i++) {
+        s->nodes[i].mask = rnd();
+        s->nodes[i].nrng = rnd() % 5;
+        put(g, "%s{\"mask\": %lu,\"nrng\": [", i ? "," : "", (unsigned long)s->nodes[i].mask);
+        for (k = 0; k < s->nodes[i].nrng; k++) {
+            if (k)
+                put(g, ",");
+            s->nodes[i].rng[k] = gen_float(g);
+        }
+        put(g, "]}");
+    }
+    put(g, "]}}");
+}
+
+static bool
+same_record(const struct json_record * a, const struct json_record * b)
+{
+    uint16_t i, k;
+
+    if (a->type != b->type)
+        return false;
+    if (a->type == JSON_RECORD_SURVEY) {
+        if (a->survey.utime != b->survey.utime || a->survey.seq != b->survey.seq
+            || a->survey.mask != b->survey.mask || a->survey.nnodes != b->survey.nnodes)
+            return false;
+        for (i = 0; i < a->survey.nnodes; i++) {
+            if (a->survey.nodes[i].mask != b->survey.nodes[i].mask
+                || a->survey.nodes[i].nrng != b->survey.nodes[i].nrng)
+                return false;
+            for (k = 0; k < a->survey.nodes[i].nrng; k++)
+                if (!same(a->survey.nodes[i].rng[k], b->survey.nodes[i].rng[k]))
+                    return false;
+        }
+        return true;
+    }
+    if (a->twr.utime != b->twr.utime || a->twr.uid != b->twr.uid || a->twr.peer != b->twr.peer
+        || !same(a->twr.rng, b->twr.rng) || !same(a->twr.rssi, b->twr.rssi) || !same(a->twr.los, b->twr.los))
+        return false;
+    if (a->type == JSON_RECORD_RAZ)
+        for (k = 0; k < 3; k++)
+            if (!same(a->twr.raz[k], b->twr.raz[k]))
+                return false;
+    return true;
+}
+
+TEST_CASE(json_decode_fuzz_test)
+{
+    static char buf[2 * FUZZ_LINE];
+    static struct json_record ref, rec;
+    struct gen g;
+    uint32_t i, len, cut, consumed;
+    json_decode_err_t rc;
+
+    g_seed = 0x2545f491;
+    for (i = 0; i < FUZZ_RECORDS; i++) {
+        g.p = buf;
+        g.end = buf + FUZZ_LINE;
+        if (rnd() % 4)
+            gen_twr(&g, &ref);
+        else
+            gen_survey(&g, &ref);
+        put(&g, "\n");
+        len = g.p - buf;
+        TEST_ASSERT_FATAL(len < FUZZ_LINE - 1);
+
+        /* Whole record */
+        rc = json_stream_decode(buf, len, &rec, &consumed);
+        TEST_ASSERT_FATAL(rc == JSON_DECODE_OK, "%.*s", (int)len, buf);
+        TEST_ASSERT(consumed == len);
+        TEST_ASSERT(same_record(&rec, &ref), "%.*s", (int)len, buf);
+
+        /* Missing the newline, the last record of a buffer still decodes */
+        rc = json_stream_decode(buf, len - 1, &rec, &consumed);
+        TEST_ASSERT(rc == JSON_DECODE_OK && consumed == len - 1);
+
+        /* Truncated at the end of the buffer, the caller has to wait for more */
+        cut = 1 + rnd() % (len - 2);
+        rc = json_stream_decode(buf, cut, &rec, &consumed);
+        TEST_ASSERT(rc != JSON_DECODE_OK && (rc != JSON_DECODE_ERR_INCOMPLETE || consumed == 0));
+
+        /* Truncated line followed by the intact record */
+        memmove(buf + cut + 1, buf, len);
+        buf[cut] = '\n';
+        rc = json_stream_decode(buf, cut + 1 + len, &rec, &consumed);
+        TEST_ASSERT(rc != JSON_DECODE_OK && rc != JSON_DECODE_ERR_INCOMPLETE);
+        TEST_ASSERT_FATAL(consumed == cut + 1, "%.*s", (int)(cut + 1), buf);
+        rc = json_stream_decode(buf + consumed, len, &rec, &consumed);
+        TEST_ASSERT(rc == JSON_DECODE_OK && consumed == len && same_record(&rec, &ref));
+
+        /* Mutated byte followed by the intact record */
+        memmove(buf + len, buf + cut + 1, len);
+        memcpy(buf, buf + len, len);
+        cut = rnd() % (len - 1);
+        do {
+            buf[cut] = rnd();
+        } while (buf[cut] == '\n');
+        rc = json_stream_decode(buf, 2 * len, &rec, &consumed);
+        TEST_ASSERT(rc != JSON_DECODE_ERR_INCOMPLETE);
+        TEST_ASSERT_FATAL(consumed == len, "%.*s", (int)len, buf);
+        rc = json_stream_decode(buf + consumed, len, &rec, &consumed);
+        TEST_ASSERT(rc == JSON_DECODE_OK && same_record(&rec, &ref));
+    }
+}
+
+TEST_CASE(json_decode_bench_test)
+{
+    static const char line[] = "{\"utime\": 208317053, \"twr\": {\"rng\": \"0.703\",\"uid\": \"1234\"},"
+                               "\"uid\": \"55a6\", \"diag\": {\"rssi\": \"-79.675\",\"los\": \"1.000\"}}\n";
+    struct json_record rec;
+    uint32_t consumed, start, usecs;
+    uint32_t i, nok = 0;
+
+    start = os_cputime_get32();
+    for (i = 0; i < 10000; i++)
+        nok += json_stream_decode(line, sizeof(line) - 1, &rec, &consumed) == JSON_DECODE_OK;
+    usecs = os_cputime_ticks_to_usecs(os_cputime_get32() - start);
+    TEST_ASSERT(nok == 10000);
+    printf("json_stream_decode: %lu ns per range record\n", (unsigned long)(usecs / 10));
+}
@@ -0,0 +1,73 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "json_stream_test.h"
+
+#define GOOD "{\"utime\": 1, \"twr\": {\"rng\": \"2.000\",\"uid\": \"1234\"},\"uid\": \"55a6\"}\n"
+
+TEST_CASE(json_decode_resync_test)
+{
+    struct json_record rec;
+    uint32_t consumed, off, ngood;
+    json_decode_err_t rc;
+    const char * buf;
+
+    /* A line cut short must not take the next record with it */
+    buf = "{\"utime\": 5\n" GOOD;
+    rc = json_test_decode(buf, &rec, &consumed);
+    TEST_ASSERT(rc == JSON_DECODE_ERR_SYNTAX);
+    TEST_ASSERT_FATAL(consumed == strlen("{\"utime\": 5\n"));
+    rc = json_test_decode(buf + consumed, &rec, &consumed);
+    TEST_ASSERT(rc == JSON_DECODE_OK);
+    TEST_ASSERT(rec.twr.rng == 2.0f && rec.twr.uid == 0x55a6);
+
+    /* Cut inside a key, a string and a nested object */
+    buf = "{\"ut\n" GOOD;
+    rc = json_test_decode(buf, &rec, &consumed);
+    TEST_ASSERT(rc == JSON_DECODE_ERR_SYNTAX && consumed == 5);
+    buf = "{\"twr\": {\"rng\": \"2.0\n" GOOD;
+    rc = json_test_decode(buf, &rec, &consumed);
+    TEST_ASSERT(rc == JSON_DECODE_ERR_SYNTAX && consumed == strlen("{\"twr\": {\"rng\": \"2.0\n"));
+    buf = "{\"twr\": {\"rng\": \"2.0\"\n" GOOD;
+    rc = json_test_decode(buf, &rec, &consumed);
+    TEST_ASSERT(rc == JSON_DECODE_ERR_SYNTAX && consumed == strlen("{\"twr\": {\"rng\": \"2.0\"\n"));
+
+    /* Blank lines ahead of a record are consumed with it */
+    buf = "\n \r\n\t" GOOD;
+    rc = json_test_decode(buf, &rec, &consumed);
+    TEST_ASSERT(rc == JSON_DECODE_OK && consumed == strlen(buf));
+
+    /* Only the end of the buffer leaves a record incomplete */
+    buf = GOOD "{\"utime\": 5, \"tw";
+    rc = json_test_decode(buf, &rec, &consumed);
+    TEST_ASSERT(rc == JSON_DECODE_OK && consumed == strlen(GOOD));
+    rc = json_test_decode(buf + consumed, &rec, &consumed);
+    TEST_ASSERT(rc == JSON_DECODE_ERR_INCOMPLETE && consumed == 0);
+
+    /* Walk a buffer of mixed lines */
+    buf = GOOD "{\"utime\": 1, \"twr\": {\"rng\": \"2.000\"\n" GOOD "garbage\n\n" GOOD "{\"utime\": 1";
+    for (off = 0, ngood = 0; off < strlen(buf); off += consumed) {
+        rc = json_test_decode(buf + off, &rec, &consumed);
+        if (rc == JSON_DECODE_ERR_INCOMPLETE)
+            break;
+        TEST_ASSERT_FATAL(consumed > 0);
+        ngood += rc == JSON_DECODE_OK;
+    }
+    TEST_ASSERT(ngood == 3);
+    TEST_ASSERT(rc == JSON_DECODE_ERR_INCOMPLETE && strcmp(buf + off, "{\"utime\": 1") == 0);
+}
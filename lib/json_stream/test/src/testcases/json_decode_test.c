@@ -0,0 +1,92 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "json_stream_test.h"
+
+TEST_CASE(json_decode_twr_test)
+{
+    struct json_record rec;
+    uint32_t consumed;
+    json_decode_err_t rc;
+    const char * line;
+
+    line = "{\"utime\": 208317053, \"twr\": {\"rng\": \"0.703\",\"uid\": \"1234\"},\"uid\": \"55a6\", "
+           "\"diag\": {\"rssi\": \"-79.675\",\"los\": \"1.000\"}}\n";
+    rc = json_test_decode(line, &rec, &consumed);
+    TEST_ASSERT_FATAL(rc == JSON_DECODE_OK);
+    TEST_ASSERT(consumed == strlen(line));
+    TEST_ASSERT(rec.type == JSON_RECORD_TWR);
+    TEST_ASSERT(rec.status.utime && rec.status.uid && rec.status.peer && rec.status.diag);
+    TEST_ASSERT(rec.twr.utime == 208317053);
+    TEST_ASSERT(rec.twr.uid == 0x55a6 && rec.twr.peer == 0x1234);
+    TEST_ASSERT(rec.twr.rng == (float)strtod("0.703", NULL));
+    TEST_ASSERT(rec.twr.rssi == (float)strtod("-79.675", NULL));
+    TEST_ASSERT(rec.twr.los == 1.0f);
+
+    /* Raz, key order free, unknown keys skipped */
+    line = "{\"extra\": [1, {\"a\": null}, true], \"uid\": \"4321\", "
+           "\"twr\": {\"uid\": \"1234\", \"raz\": [\"1.100\",\"0.000\",\"-0.250\"]}}\n";
+    rc = json_test_decode(line, &rec, &consumed);
+    TEST_ASSERT_FATAL(rc == JSON_DECODE_OK);
+    TEST_ASSERT(rec.type == JSON_RECORD_RAZ);
+    TEST_ASSERT(!rec.status.utime && !rec.status.diag);
+    TEST_ASSERT(rec.twr.raz[0] == 1.1f && rec.twr.raz[1] == 0.0f && rec.twr.raz[2] == -0.25f);
+    TEST_ASSERT(rec.twr.rng == rec.twr.raz[0]);
+
+    /* Raw ieee754 bits, 0x3fc00000 is 1.5, and FLOAT_USER NaN */
+    line = "{\"twr\": {\"rng\": 1069547520,\"uid\": \"1\"},\"uid\": \"2\",\"diag\": {\"rssi\": \"null\",\"los\": null}}";
+    rc = json_test_decode(line, &rec, &consumed);
+    TEST_ASSERT_FATAL(rc == JSON_DECODE_OK);
+    TEST_ASSERT(consumed == strlen(line));
+    TEST_ASSERT(rec.twr.rng == 1.5f);
+    TEST_ASSERT(isnan(rec.twr.rssi) && isnan(rec.twr.los));
+
+    /* Wrong schema and bad values */
+    TEST_ASSERT(json_test_decode("{\"utime\": 1}\n", &rec, &consumed) == JSON_DECODE_ERR_SCHEMA);
+    TEST_ASSERT(json_test_decode("{\"twr\": {\"uid\": \"1\"}}\n", &rec, &consumed) == JSON_DECODE_ERR_SCHEMA);
+    TEST_ASSERT(json_test_decode("{\"twr\": {\"rng\": \"1\"},\"uid\": \"12345\"}\n", &rec, &consumed) == JSON_DECODE_ERR_RANGE);
+    TEST_ASSERT(json_test_decode("{\"twr\": {\"rng\": \"1\"},\"uid\": \"xy\"}\n", &rec, &consumed) == JSON_DECODE_ERR_SYNTAX);
+    TEST_ASSERT(json_test_decode("{\"twr\": {\"rng\": \"1\"}} x\n", &rec, &consumed) == JSON_DECODE_ERR_SYNTAX);
+}
+
+TEST_CASE(json_decode_survey_test)
+{
+    struct json_record rec;
+    uint32_t consumed;
+    json_decode_err_t rc;
+    const char * line;
+
+    line = "{\"utime\": 9,\"survey\": {\"seq\": 7,\"mask\": 3,\"nrngs\": ["
+           "{\"mask\": 3,\"nrng\": [\"null\",\"2.500\"]},{\"mask\": 1,\"nrng\": [\"1.250\"]}]}}\n";
+    rc = json_test_decode(line, &rec, &consumed);
+    TEST_ASSERT_FATAL(rc == JSON_DECODE_OK);
+    TEST_ASSERT(consumed == strlen(line));
+    TEST_ASSERT(rec.type == JSON_RECORD_SURVEY);
+    TEST_ASSERT(rec.status.seq && rec.status.mask);
+    TEST_ASSERT(rec.survey.utime == 9 && rec.survey.seq == 7 && rec.survey.mask == 3);
+    TEST_ASSERT_FATAL(rec.survey.nnodes == 2);
+    TEST_ASSERT(rec.survey.nodes[0].mask == 3 && rec.survey.nodes[0].nrng == 2);
+    TEST_ASSERT(isnan(rec.survey.nodes[0].rng[0]) && rec.survey.nodes[0].rng[1] == 2.5f);
+    TEST_ASSERT(rec.survey.nodes[1].nrng == 1 && rec.survey.nodes[1].rng[0] == 1.25f);
+
+    /* A record holds twr or survey fields, not both */
+    line = "{\"uid\": \"1\",\"survey\": {\"seq\": 1}}\n";
+    TEST_ASSERT(json_test_decode(line, &rec, &consumed) == JSON_DECODE_ERR_SCHEMA);
+    line = "{\"survey\": {\"seq\": 65536}}\n";
+    TEST_ASSERT(json_test_decode(line, &rec, &consumed) == JSON_DECODE_ERR_RANGE);
+}
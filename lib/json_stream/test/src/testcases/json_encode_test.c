@@ -0,0 +1,281 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "json_stream_test.h"
+
+static char g_out[512];
+static uint16_t g_out_len;
+static uint16_t g_flushes;
+
+static int
+capture(void * arg, const char * data, uint16_t len)
+{
+    if (g_out_len + len >= sizeof(g_out)) {
+        len = sizeof(g_out) - 1 - g_out_len;
+    }
+    memcpy(g_out + g_out_len, data, len);
+    g_out_len += len;
+    g_out[g_out_len] = '\0';
+    g_flushes++;
+    return len;
+}
+
+static void
+capture_reset(void)
+{
+    g_out_len = 0;
+    g_out[0] = '\0';
+    g_flushes = 0;
+}
+
+struct twr_test_record {
+    uint16_t uid;
+    float rng;
+    float raz[2];
+};
+
+static const struct json_tpl twr_test_tpl[] = {
+    JSON_TPL_LIT("{\"twr\": {\"rng\": "),
+    JSON_TPL_FIELD(JSON_TPL_OP_FLOAT, struct twr_test_record, rng),
+    JSON_TPL_LIT(",\"raz\": ["),
+    JSON_TPL_FIELD(JSON_TPL_OP_FLOAT_NULL, struct twr_test_record, raz[0]),
+    JSON_TPL_LIT(","),
+    JSON_TPL_FIELD(JSON_TPL_OP_FLOAT_NULL, struct twr_test_record, raz[1]),
+    JSON_TPL_LIT("],\"uid\": \"1\"},\"uid\": "),
+    JSON_TPL_FIELD(JSON_TPL_OP_HEX16, struct twr_test_record, uid),
+    JSON_TPL_LIT("}"),
+    JSON_TPL_END()
+};
+
+TEST_CASE(json_encode_float_test)
+{
+    struct json_stream js;
+    struct twr_test_record twr = {.uid = 0x55a6, .rng = NAN, .raz = {1.5f, NAN}};
+    struct json_record rec;
+    uint32_t consumed;
+    char buf[64], ref[64];
+    float v;
+    int i;
+
+    /* Fixed point output matches %f digit for digit */
+    for (i = 0; i < 20000; i++) {
+        v = (float)(rand() - RAND_MAX / 2) / (float)(1 + rand() % 100000);
+        json_stream_init(&js, buf, sizeof(buf), NULL, NULL);
+        json_stream_put_fixed(&js, v, 6);
+        buf[js.wr] = '\0';
+        snprintf(ref, sizeof(ref), "%f", v);
+        TEST_ASSERT_FATAL(strcmp(buf, ref) == 0, "%s != %s", buf, ref);
+    }
+
+    /* NaN as the json_encode printers wrote it, "nan" from sprintf except
+     * for raz entries */
+    json_stream_init(&js, g_out, sizeof(g_out), NULL, NULL);
+    json_stream_record_start(&js);
+    json_stream_template(&js, twr_test_tpl, &twr);
+    g_out[js.wr] = '\0';
+#if MYNEWT_VAL(FLOAT_USER)
+    TEST_ASSERT(strcmp(g_out, "{\"twr\": {\"rng\": \"nan\",\"raz\": [\"1.500000\",\"null\"],"
+                              "\"uid\": \"1\"},\"uid\": \"55a6\"}") == 0, "%s", g_out);
+#else
+    snprintf(ref, sizeof(ref), "\"rng\": %lu,", (unsigned long)0x7fc00000);
+    TEST_ASSERT(strstr(g_out, ref) != NULL, "%s", g_out);
+#endif
+    TEST_ASSERT_FATAL(json_test_decode(g_out, &rec, &consumed) == JSON_DECODE_OK, "%s", g_out);
+    TEST_ASSERT(isnan(rec.twr.raz[1]));
+    TEST_ASSERT(rec.twr.raz[0] == 1.5f);
+}
+
+TEST_CASE(json_encode_flush_test)
+{
+    struct json_stream js;
+    char buf[32];
+
+    /* A line written in pieces reaches the console as it is written */
+    capture_reset();
+    json_stream_init(&js, buf, sizeof(buf), capture, NULL);
+    json_stream_record_start(&js);
+    json_stream_write(&js, "{\"utime\": 1", 11);
+    TEST_ASSERT(g_out_len == 0);
+    json_stream_flush(&js);
+    TEST_ASSERT(strcmp(g_out, "{\"utime\": 1") == 0, "%s", g_out);
+    json_stream_flush(&js);
+    TEST_ASSERT(g_flushes == 1);
+    json_stream_write(&js, "}", 1);
+    TEST_ASSERT(json_stream_record_end(&js) == 0);
+    TEST_ASSERT(strcmp(g_out, "{\"utime\": 1}\n") == 0, "%s", g_out);
+    TEST_ASSERT(js.records == 1);
+
+    /* Ring mode keeps records whole */
+    TEST_ASSERT_FATAL(json_stream_ring_init(&js, buf, sizeof(buf)) == 0);
+    json_stream_record_start(&js);
+    json_stream_write(&js, "{}", 2);
+    json_stream_flush(&js);
+    TEST_ASSERT(json_stream_available(&js) == 0);
+    TEST_ASSERT(json_stream_record_end(&js) == 0);
+    TEST_ASSERT(json_stream_available(&js) == 3);
+}
+
+/* The twr + diag range record of rng_encode */
+struct bench_record {
+    uint64_t utime;
+    uint16_t dst_address;
+    uint16_t src_address;
+    float range;
+    float rssi;
+    float los;
+};
+
+static const struct json_tpl bench_tpl[] = {
+    JSON_TPL_LIT("{\"utime\": "),
+    JSON_TPL_FIELD(JSON_TPL_OP_U64, struct bench_record, utime),
+    JSON_TPL_LIT(", \"twr\": {\"rng\": "),
+    JSON_TPL_FIELD(JSON_TPL_OP_FLOAT, struct bench_record, range),
+    JSON_TPL_LIT(",\"uid\": "),
+    JSON_TPL_FIELD(JSON_TPL_OP_HEX16, struct bench_record, dst_address),
+    JSON_TPL_LIT("},\"uid\": "),
+    JSON_TPL_FIELD(JSON_TPL_OP_HEX16, struct bench_record, src_address),
+    JSON_TPL_LIT(", \"diag\": {\"rssi\": "),
+    JSON_TPL_FIELD(JSON_TPL_OP_FLOAT, struct bench_record, rssi),
+    JSON_TPL_LIT(",\"los\": "),
+    JSON_TPL_FIELD(JSON_TPL_OP_FLOAT, struct bench_record, los),
+    JSON_TPL_LIT("}}"),
+    JSON_TPL_END()
+};
+
+static int
+bench_write(void * arg, char * data, int len)
+{
+    return capture(arg, data, len);
+}
+
+static void
+bench_float(struct json_value * value, float v, char * str)
+{
+#if MYNEWT_VAL(FLOAT_USER)
+    sprintf(str, "%f", v);
+    JSON_VALUE_STRING(value, str);
+#else
+    JSON_VALUE_UINT(value, *(uint32_t *)&v);
+#endif
+}
+
+/* The same record through json_encode, as rng_encode wrote it before
+ * json_stream: each ", " separated fragment from a fresh encoder */
+static void
+bench_json_encode(const struct bench_record * rec)
+{
+    struct json_encoder encoder;
+    struct json_value value;
+    char str[32];
+
+    memset(&encoder, 0, sizeof(encoder));
+    encoder.je_write = bench_write;
+
+    json_encode_object_start(&encoder);
+    JSON_VALUE_UINT(&value, rec->utime);
+    json_encode_object_entry(&encoder, "utime", &value);
+
+    bench_write(NULL, ", ", 2);
+    encoder.je_wr_commas = 0;
+    json_encode_object_key(&encoder, "twr");
+    json_encode_object_start(&encoder);
+    bench_float(&value, rec->range, str);
+    json_encode_object_entry(&encoder, "rng", &value);
+    sprintf(str, "%04x", rec->dst_address);
+    JSON_VALUE_STRINGN(&value, str, 4);
+    json_encode_object_entry(&encoder, "uid", &value);
+    json_encode_object_finish(&encoder);
+    sprintf(str, "%04x", rec->src_address);
+    JSON_VALUE_STRINGN(&value, str, 4);
+    json_encode_object_entry(&encoder, "uid", &value);
+
+    bench_write(NULL, ", ", 2);
+    encoder.je_wr_commas = 0;
+    json_encode_object_key(&encoder, "diag");
+    json_encode_object_start(&encoder);
+    bench_float(&value, rec->rssi, str);
+    json_encode_object_entry(&encoder, "rssi", &value);
+    bench_float(&value, rec->los, str);
+    json_encode_object_entry(&encoder, "los", &value);
+    json_encode_object_finish(&encoder);
+
+    json_encode_object_finish(&encoder);
+    bench_write(NULL, "\n", 1);
+}
+
+static void
+bench_random(struct bench_record * rec, uint32_t i)
+{
+    rec->utime = 208317053ULL + 10000ULL * i;
+    rec->dst_address = rand();
+    rec->src_address = rand();
+    rec->range = (float)(rand() % 100000) / 1000.0f;
+    rec->rssi = -60.0f - (float)(rand() % 40000) / 1000.0f;
+    rec->los = (float)(rand() % 1000) / 1000.0f;
+}
+
+TEST_CASE(json_encode_bench_test)
+{
+    struct json_stream js;
+    struct bench_record rec;
+    char buf[256], ref[sizeof(g_out)];
+    uint32_t i, start, ticks[2], bytes[2] = {0};
+
+    /* Same bytes either way */
+    srand(1);
+    for (i = 0; i < 1000; i++) {
+        bench_random(&rec, i);
+        capture_reset();
+        bench_json_encode(&rec);
+        strcpy(ref, g_out);
+        capture_reset();
+        json_stream_init(&js, buf, sizeof(buf), capture, NULL);
+        json_stream_record_start(&js);
+        json_stream_template(&js, bench_tpl, &rec);
+        json_stream_record_end(&js);
+        TEST_ASSERT_FATAL(strcmp(g_out, ref) == 0, "%s != %s", g_out, ref);
+    }
+
+    /* Rate, both handing the record to the same capture */
+    start = os_cputime_get32();
+    for (i = 0; i < 10000; i++) {
+        capture_reset();
+        bench_json_encode(&rec);
+        bytes[0] += g_out_len;
+    }
+    ticks[0] = os_cputime_get32() - start;
+
+    start = os_cputime_get32();
+    for (i = 0; i < 10000; i++) {
+        capture_reset();
+        json_stream_record_start(&js);
+        json_stream_template(&js, bench_tpl, &rec);
+        json_stream_record_end(&js);
+        bytes[1] += g_out_len;
+    }
+    ticks[1] = os_cputime_get32() - start;
+    TEST_ASSERT(bytes[0] == bytes[1]);
+
+    for (i = 0; i < 2; i++) {
+        uint32_t usecs = os_cputime_ticks_to_usecs(ticks[i]);
+        printf("%s: %lu ns, %lu.%02lu cputime ticks per range record, %lu kB/s\n",
+               i ? "json_stream" : "json_encode", (unsigned long)(usecs / 10),
+               (unsigned long)(ticks[i] / 10000), (unsigned long)(ticks[i] / 100 % 100),
+               (unsigned long)(usecs ? (uint64_t)bytes[i] * 1000 / usecs : 0));
+    }
+}
@@ -0,0 +1,159 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file linkadapt.h
+ * @brief Per link adaptive data rate and preamble length
+ *
+ * @details The device default configuration (uwbcfg) stays the profile every
+ * node can always reach and that tdma slots are sized for. For each peer a
+ * faster profile, shorter preamble and/or higher data rate, is chosen from
+ * the received signal level, the line of sight estimate and the exchange
+ * success rate. Both ends of a link program the agreed profile before each
+ * exchange with linkadapt_select(). A change is proposed by the initiator
+ * with linkadapt_negotiate() and only takes effect once acknowledged; if the
+ * acknowledgement is lost the ends disagree, exchanges fail, and both fall
+ * back to the default profile after LINKADAPT_FALLBACK_FAILS failures.
+ */
+
+#ifndef _LINKADAPT_H_
+#define _LINKADAPT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stats/stats.h>
+#include <dpl/dpl.h>
+#include <uwb/uwb.h>
+#include <uwb/uwb_ftypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LINKADAPT_NPROFILES (6)           //!< Entries in the profile table
+#define LINKADAPT_PROFILE_DEFAULT (0xff)  //!< Device default configuration
+
+#if MYNEWT_VAL(LINKADAPT_STATS)
+STATS_SECT_START(linkadapt_stat_section)
+    STATS_SECT_ENTRY(select)
+    STATS_SECT_ENTRY(reconfig)
+    STATS_SECT_ENTRY(step_up)
+    STATS_SECT_ENTRY(step_down)
+    STATS_SECT_ENTRY(fallback)
+    STATS_SECT_ENTRY(request)
+    STATS_SECT_ENTRY(ack)
+    STATS_SECT_ENTRY(ack_rx)
+    STATS_SECT_ENTRY(rx_timeout)
+    STATS_SECT_ENTRY(start_tx_error)
+    STATS_SECT_ENTRY(start_rx_error)
+    STATS_SECT_ENTRY(no_link)
+STATS_SECT_END
+#define LINKADAPT_STATS_INC(__X) STATS_INC(la->stat, __X)
+#else
+#define LINKADAPT_STATS_INC(__X) {}
+#endif
+
+//! Phy profile, ordered fastest first
+struct linkadapt_profile {
+    uint8_t dataRate;                  //!< DWT_BR_110K, DWT_BR_850K or DWT_BR_6M8
+    uint8_t preambleLength;            //!< DWT_PLEN_64..DWT_PLEN_4096
+    uint8_t pacLength;                 //!< DWT_PAC8..DWT_PAC64
+    uint16_t nsync;                    //!< Preamble length in symbols
+    uint8_t nsfd;                      //!< SFD length in symbols
+    float Tbsym;                       //!< Baserate symbol duration, usec
+    float Tdsym;                       //!< Data symbol duration adjusted for RS coding, usec
+    float sensitivity;                 //!< Typical 1% PER sensitivity, dBm
+};
+
+//! Profile change frame
+typedef union {
+    struct _linkadapt_frame_t{
+        struct _ieee_rng_request_frame_t;
+        uint8_t profile;               //!< Proposed profile index
+    }__attribute__((__packed__,aligned(1)));
+    uint8_t array[sizeof(struct _linkadapt_frame_t)];
+}linkadapt_frame_t;
+
+//! Per peer link state
+struct linkadapt_link {
+    uint16_t addr;                     //!< Peer short address, 0 marks a free entry
+    uint8_t profile;                   //!< Agreed profile
+    uint8_t proposed;                  //!< Profile the policy wants, differs from profile until negotiated
+    float success;                     //!< Exchange success rate, moving average
+    float rssi;                        //!< Received level, moving average, dBm
+    float los;                         //!< Line of sight estimate, moving average
+    uint16_t ok_run;                   //!< Consecutive successful exchanges
+    uint16_t fail_run;                 //!< Consecutive failed exchanges
+    uint32_t exchanges;                //!< Exchanges reported
+    uint32_t failures;                 //!< Failed exchanges reported
+};
+
+//! Linkadapt status
+typedef struct _linkadapt_status_t{
+    uint16_t selfmalloc:1;             //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;            //!< Instance allocated
+    uint16_t acked:1;                  //!< Last request was acknowledged
+    uint16_t start_tx_error:1;         //!< Start transmit error
+    uint16_t start_rx_error:1;         //!< Start receive error
+    uint16_t rx_timeout_error:1;       //!< Receive timeout error
+}linkadapt_status_t;
+
+//! Linkadapt instance
+struct linkadapt_instance {
+#if MYNEWT_VAL(LINKADAPT_STATS)
+    STATS_SECT_DECL(linkadapt_stat_section) stat; //!< Stats instance
+#endif
+    struct uwb_dev * dev_inst;         //!< Structure of uwb_dev
+    struct uwb_mac_interface cbs;      //!< MAC layer callbacks
+    struct dpl_sem sem;                //!< Serialises negotiation
+    linkadapt_status_t status;         //!< Status
+    struct uwb_dev_config config;      //!< Device default configuration
+    struct uwb_phy_attributes attrib;  //!< Device default phy attributes
+    struct uwb_phy_attributes attribs[LINKADAPT_NPROFILES]; //!< Precomputed phy attributes per profile
+    uint8_t slowest;                   //!< Slowest profile tried, no slower than the default
+    uint8_t applied;                   //!< Profile currently programmed
+    uint8_t pending_profile;           //!< Profile acknowledged, committed on tx complete
+    uint16_t pending_addr;             //!< Peer of pending_profile, 0 if none
+    linkadapt_frame_t frame;           //!< Request and ack frame
+    uint64_t airtime_usec;             //!< Airtime of reported exchanges
+    uint64_t default_airtime_usec;     //!< Same exchanges at the default profile
+    struct linkadapt_link links[MYNEWT_VAL(LINKADAPT_MAX_PEERS)];
+};
+
+extern const struct linkadapt_profile g_linkadapt_profiles[LINKADAPT_NPROFILES];
+
+struct linkadapt_instance * linkadapt_init(struct linkadapt_instance * la, struct uwb_dev * inst);
+void linkadapt_free(struct linkadapt_instance * la);
+struct linkadapt_instance * linkadapt_get_instance(void);
+
+struct linkadapt_link * linkadapt_get_link(struct linkadapt_instance * la, uint16_t addr);
+int linkadapt_apply(struct linkadapt_instance * la, uint8_t profile);
+int linkadapt_select(struct linkadapt_instance * la, uint16_t addr);
+void linkadapt_result(struct linkadapt_instance * la, uint16_t addr, bool success, uint16_t nframes, uint16_t len);
+bool linkadapt_pending(struct linkadapt_instance * la, uint16_t addr);
+linkadapt_status_t linkadapt_negotiate(struct linkadapt_instance * la, uint16_t addr);
+linkadapt_status_t linkadapt_listen(struct linkadapt_instance * la, uint16_t timeout);
+
+uint16_t linkadapt_frame_duration(struct linkadapt_instance * la, uint8_t profile, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LINKADAPT_H_ */
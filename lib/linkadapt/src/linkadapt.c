@@ -0,0 +1,641 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file linkadapt.c
+ * @brief Per link adaptive data rate and preamble length
+ *
+ * @details Profiles are ordered fastest first. Only profiles whose airtime
+ * does not exceed that of the device default are used, so a link never
+ * overruns a slot dimensioned for the default. A link starts at the default
+ * and moves one profile at a time: faster after LINKADAPT_UP_COUNT clean
+ * exchanges if the averaged rssi clears the sensitivity of the faster
+ * profile by LINKADAPT_MARGIN (more when non line of sight), slower as soon
+ * as the success rate drops below LINKADAPT_TARGET.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <os/os.h>
+#include <sysinit/sysinit.h>
+#include <stats/stats.h>
+#include <uwb_rng/uwb_rng.h>
+#include <dw1000/dw1000_mac.h>
+#include <linkadapt/linkadapt.h>
+
+#if MYNEWT_VAL(LINKADAPT_STATS)
+STATS_NAME_START(linkadapt_stat_section)
+    STATS_NAME(linkadapt_stat_section, select)
+    STATS_NAME(linkadapt_stat_section, reconfig)
+    STATS_NAME(linkadapt_stat_section, step_up)
+    STATS_NAME(linkadapt_stat_section, step_down)
+    STATS_NAME(linkadapt_stat_section, fallback)
+    STATS_NAME(linkadapt_stat_section, request)
+    STATS_NAME(linkadapt_stat_section, ack)
+    STATS_NAME(linkadapt_stat_section, ack_rx)
+    STATS_NAME(linkadapt_stat_section, rx_timeout)
+    STATS_NAME(linkadapt_stat_section, start_tx_error)
+    STATS_NAME(linkadapt_stat_section, start_rx_error)
+    STATS_NAME(linkadapt_stat_section, no_link)
+STATS_NAME_END(linkadapt_stat_section)
+#endif
+
+/* Sensitivities are typical values for channel 5, 64MHz PRF, 1% PER */
+const struct linkadapt_profile g_linkadapt_profiles[LINKADAPT_NPROFILES] = {
+    {DWT_BR_6M8,  DWT_PLEN_64,   DWT_PAC8,  64,   8,  1.02564f, 0.12821f/0.87f, -88.0f},
+    {DWT_BR_6M8,  DWT_PLEN_128,  DWT_PAC8,  128,  8,  1.02564f, 0.12821f/0.87f, -91.0f},
+    {DWT_BR_850K, DWT_PLEN_256,  DWT_PAC16, 256,  8,  1.02564f, 1.02564f/0.87f, -96.0f},
+    {DWT_BR_850K, DWT_PLEN_512,  DWT_PAC16, 512,  8,  1.02564f, 1.02564f/0.87f, -99.0f},
+    {DWT_BR_110K, DWT_PLEN_1024, DWT_PAC32, 1024, 64, 8.20513f, 8.20513f/0.87f, -104.0f},
+    {DWT_BR_110K, DWT_PLEN_2048, DWT_PAC64, 2048, 64, 8.20513f, 8.20513f/0.87f, -106.0f},
+};
+
+#define LINKADAPT_RSSI_UNKNOWN (-200.0f)
+
+static struct linkadapt_instance * g_linkadapt = NULL;
+
+static bool rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static bool tx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static bool rx_timeout_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static bool reset_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+
+#if MYNEWT_VAL(LINKADAPT_CLI)
+int linkadapt_cli_register(void);
+#endif
+
+/**
+ * @fn linkadapt_init(struct linkadapt_instance * la, struct uwb_dev * inst)
+ * @brief Allocate and initialise a link adaptation instance. The current
+ * device configuration becomes the default profile, call again after
+ * changing it through uwbcfg.
+ *
+ * @param la    Pointer to struct linkadapt_instance, NULL to allocate.
+ * @param inst  Pointer to struct uwb_dev.
+ *
+ * @return struct linkadapt_instance *
+ */
+struct linkadapt_instance *
+linkadapt_init(struct linkadapt_instance * la, struct uwb_dev * inst)
+{
+    assert(inst);
+
+    if (la == NULL) {
+        la = (struct linkadapt_instance *) malloc(sizeof(struct linkadapt_instance));
+        assert(la);
+        memset(la, 0, sizeof(struct linkadapt_instance));
+        la->status.selfmalloc = 1;
+    }
+    if (!la->status.initialized) {
+        dpl_error_t err = dpl_sem_init(&la->sem, 0x1);
+        assert(err == DPL_OK);
+    }
+    la->dev_inst = inst;
+    la->config = inst->config;
+    la->attrib = inst->attrib;
+    la->applied = LINKADAPT_PROFILE_DEFAULT;
+
+    /* Precompute the phy attributes, keep the preamble symbol time and phr
+     * length of the device configuration */
+    uint16_t len = sizeof(ieee_rng_response_frame_t);
+    uint16_t limit = linkadapt_frame_duration(la, LINKADAPT_PROFILE_DEFAULT, len);
+    la->slowest = LINKADAPT_PROFILE_DEFAULT;
+    for (uint8_t i = 0; i < LINKADAPT_NPROFILES; i++) {
+        const struct linkadapt_profile * p = &g_linkadapt_profiles[i];
+        la->attribs[i] = (struct uwb_phy_attributes){
+            .Tpsym = inst->attrib.Tpsym,
+            .Tbsym = p->Tbsym,
+            .Tdsym = p->Tdsym,
+            .nsfd = p->nsfd,
+            .nphr = inst->attrib.nphr,
+            .nsync = p->nsync
+        };
+        if (linkadapt_frame_duration(la, i, len) <= limit) {
+            la->slowest = i;
+        }
+    }
+    for (uint16_t i = 0; i < MYNEWT_VAL(LINKADAPT_MAX_PEERS); i++) {
+        la->links[i].profile = la->links[i].proposed = LINKADAPT_PROFILE_DEFAULT;
+    }
+
+    la->cbs = (struct uwb_mac_interface){
+        .id = UWBEXT_LINKADAPT,
+        .inst_ptr = (void *) la,
+        .rx_complete_cb = rx_complete_cb,
+        .tx_complete_cb = tx_complete_cb,
+        .rx_timeout_cb = rx_timeout_cb,
+        .reset_cb = reset_cb
+    };
+    if (!la->status.initialized) {
+        uwb_mac_append_interface(inst, &la->cbs);
+#if MYNEWT_VAL(LINKADAPT_STATS)
+        int rc = stats_init(
+                    STATS_HDR(la->stat),
+                    STATS_SIZE_INIT_PARMS(la->stat, STATS_SIZE_32),
+                    STATS_NAME_INIT_PARMS(linkadapt_stat_section)
+            );
+        rc |= stats_register("linkadapt", STATS_HDR(la->stat));
+        assert(rc == 0);
+#endif
+    }
+    la->status.initialized = 1;
+    g_linkadapt = la;
+    return la;
+}
+
+/**
+ * @fn linkadapt_free(struct linkadapt_instance * la)
+ * @brief Restore the device default profile and free the instance.
+ *
+ * @param la  Pointer to struct linkadapt_instance.
+ *
+ * @return void
+ */
+void
+linkadapt_free(struct linkadapt_instance * la)
+{
+    assert(la);
+    linkadapt_apply(la, LINKADAPT_PROFILE_DEFAULT);
+    uwb_mac_remove_interface(la->dev_inst, la->cbs.id);
+    if (g_linkadapt == la) {
+        g_linkadapt = NULL;
+    }
+    if (la->status.selfmalloc) {
+        free(la);
+    } else {
+        la->status.initialized = 0;
+    }
+}
+
+/**
+ * @fn linkadapt_get_instance(void)
+ * @brief Instance created by the last linkadapt_init, used by the cli.
+ *
+ * @return struct linkadapt_instance *
+ */
+struct linkadapt_instance *
+linkadapt_get_instance(void)
+{
+    return g_linkadapt;
+}
+
+/**
+ * @fn linkadapt_frame_duration(struct linkadapt_instance * la, uint8_t profile, uint16_t len)
+ * @brief Airtime of a frame with a given profile, same as uwb_phy_frame_duration
+ * but from the precomputed attributes.
+ *
+ * @param la       Pointer to struct linkadapt_instance.
+ * @param profile  Profile index or LINKADAPT_PROFILE_DEFAULT.
+ * @param len      Frame length excluding crc.
+ *
+ * @return duration in usec
+ */
+uint16_t
+linkadapt_frame_duration(struct linkadapt_instance * la, uint8_t profile, uint16_t len)
+{
+    struct uwb_phy_attributes * attrib = (profile == LINKADAPT_PROFILE_DEFAULT) ?
+        &la->attrib : &la->attribs[profile];
+
+    return ceilf(attrib->Tpsym * (attrib->nsync + attrib->nsfd))
+        + ceilf(attrib->Tbsym * attrib->nphr + attrib->Tdsym * (len + 2) * 8);
+}
+
+/**
+ * @fn linkadapt_faster(struct linkadapt_instance * la, uint8_t profile)
+ * @brief Next faster profile, LINKADAPT_PROFILE_DEFAULT if there is none.
+ */
+static uint8_t
+linkadapt_faster(struct linkadapt_instance * la, uint8_t profile)
+{
+    if (profile == LINKADAPT_PROFILE_DEFAULT) {
+        return la->slowest;
+    }
+    return (profile == 0) ? LINKADAPT_PROFILE_DEFAULT : profile - 1;
+}
+
+/**
+ * @fn linkadapt_slower(struct linkadapt_instance * la, uint8_t profile)
+ * @brief Next more robust profile, the default past the slowest table entry.
+ */
+static uint8_t
+linkadapt_slower(struct linkadapt_instance * la, uint8_t profile)
+{
+    if (profile == LINKADAPT_PROFILE_DEFAULT || profile >= la->slowest) {
+        return LINKADAPT_PROFILE_DEFAULT;
+    }
+    return profile + 1;
+}
+
+/**
+ * @fn linkadapt_get_link(struct linkadapt_instance * la, uint16_t addr)
+ * @brief Link state of a peer, created at the default profile on first use.
+ *
+ * @param la    Pointer to struct linkadapt_instance.
+ * @param addr  Peer short address.
+ *
+ * @return struct linkadapt_link *, NULL if the table is full.
+ */
+struct linkadapt_link *
+linkadapt_get_link(struct linkadapt_instance * la, uint16_t addr)
+{
+    struct linkadapt_link * free_link = NULL;
+
+    for (uint16_t i = 0; i < MYNEWT_VAL(LINKADAPT_MAX_PEERS); i++) {
+        if (la->links[i].addr == addr) {
+            return &la->links[i];
+        }
+        if (!la->links[i].addr && !free_link) {
+            free_link = &la->links[i];
+        }
+    }
+    if (free_link == NULL || addr == 0) {
+        LINKADAPT_STATS_INC(no_link);
+        return NULL;
+    }
+    *free_link = (struct linkadapt_link){
+        .addr = addr,
+        .profile = LINKADAPT_PROFILE_DEFAULT,
+        .proposed = LINKADAPT_PROFILE_DEFAULT,
+        .success = 1.0f,
+        .rssi = LINKADAPT_RSSI_UNKNOWN,
+        .los = 1.0f
+    };
+    return free_link;
+}
+
+/**
+ * @fn linkadapt_apply(struct linkadapt_instance * la, uint8_t profile)
+ * @brief Program a profile, a no-op if it is already applied. The device
+ * must be idle.
+ *
+ * @param la       Pointer to struct linkadapt_instance.
+ * @param profile  Profile index or LINKADAPT_PROFILE_DEFAULT.
+ *
+ * @return OS_OK, OS_EINVAL for an unknown profile.
+ */
+int
+linkadapt_apply(struct linkadapt_instance * la, uint8_t profile)
+{
+    struct uwb_dev * inst = la->dev_inst;
+    struct uwb_dev_config config = la->config;
+
+    if (profile == la->applied) {
+        return OS_OK;
+    }
+    if (profile == LINKADAPT_PROFILE_DEFAULT) {
+        inst->attrib = la->attrib;
+    } else if (profile < LINKADAPT_NPROFILES) {
+        const struct linkadapt_profile * p = &g_linkadapt_profiles[profile];
+        config.dataRate = p->dataRate;
+        config.tx.preambleLength = p->preambleLength;
+        config.rx.pacLength = p->pacLength;
+        config.rx.sfdTimeout = p->nsync + 1 + p->nsfd - (8 << p->pacLength);
+        inst->attrib = la->attribs[profile];
+    } else {
+        return OS_EINVAL;
+    }
+    /* Keep channel, preamble code (agility) and frame filtering as currently configured */
+    config.channel = inst->config.channel;
+    config.txrf.PGdly = inst->config.txrf.PGdly;
+    config.rx.preambleCodeIndex = inst->config.rx.preambleCodeIndex;
+    config.tx.preambleCodeIndex = inst->config.tx.preambleCodeIndex;
+    config.framefilter_enabled = inst->config.framefilter_enabled;
+    config.autoack_enabled = inst->config.autoack_enabled;
+    uwb_mac_config(inst, &config);
+    la->applied = profile;
+    LINKADAPT_STATS_INC(reconfig);
+    return OS_OK;
+}
+
+/**
+ * @fn linkadapt_select(struct linkadapt_instance * la, uint16_t addr)
+ * @brief Program the agreed profile of a peer, both ends call this before
+ * an exchange, e.g. at the start of the tdma slot of the peer.
+ *
+ * @param la    Pointer to struct linkadapt_instance.
+ * @param addr  Peer short address.
+ *
+ * @return see linkadapt_apply
+ */
+int
+linkadapt_select(struct linkadapt_instance * la, uint16_t addr)
+{
+    struct linkadapt_link * link = linkadapt_get_link(la, addr);
+
+    LINKADAPT_STATS_INC(select);
+    return linkadapt_apply(la, link ? link->profile : LINKADAPT_PROFILE_DEFAULT);
+}
+
+/**
+ * @fn linkadapt_result(struct linkadapt_instance * la, uint16_t addr, bool success, uint16_t nframes, uint16_t len)
+ * @brief Report the outcome of an exchange with a peer. On success the
+ * received level of the last frame is read from the device, which requires
+ * rxdiag_enable. Both ends should report so both detect a broken link.
+ *
+ * @param la       Pointer to struct linkadapt_instance.
+ * @param addr     Peer short address.
+ * @param success  Exchange completed.
+ * @param nframes  Frames in the exchange, for airtime accounting.
+ * @param len      Typical frame length of the exchange.
+ *
+ * @return void
+ */
+void
+linkadapt_result(struct linkadapt_instance * la, uint16_t addr, bool success, uint16_t nframes, uint16_t len)
+{
+    struct uwb_dev * inst = la->dev_inst;
+    struct linkadapt_link * link = linkadapt_get_link(la, addr);
+    uint8_t next;
+
+    if (link == NULL) {
+        return;
+    }
+    la->airtime_usec += nframes * linkadapt_frame_duration(la, link->profile, len);
+    la->default_airtime_usec += nframes * linkadapt_frame_duration(la, LINKADAPT_PROFILE_DEFAULT, len);
+
+    link->exchanges++;
+    link->success += ((success ? 1.0f : 0.0f) - link->success) * (1.0f/8);
+    if (success) {
+        float rssi = uwb_get_rssi(inst);
+        float fppl = uwb_get_fppl(inst);
+        if (isfinite(rssi) && isfinite(fppl)) {
+            float los = uwb_estimate_los(inst, rssi, fppl);
+            if (link->rssi == LINKADAPT_RSSI_UNKNOWN) {
+                link->rssi = rssi;
+            } else {
+                link->rssi += (rssi - link->rssi) * 0.25f;
+            }
+            link->los += (los - link->los) * 0.25f;
+        }
+        link->ok_run++;
+        link->fail_run = 0;
+    } else {
+        link->failures++;
+        link->fail_run++;
+        link->ok_run = 0;
+    }
+
+    if (link->fail_run >= MYNEWT_VAL(LINKADAPT_FALLBACK_FAILS) && link->profile != LINKADAPT_PROFILE_DEFAULT) {
+        /* The peer may not have seen our last profile change, meet it at
+         * the default */
+        link->profile = link->proposed = LINKADAPT_PROFILE_DEFAULT;
+        link->success = 1.0f;
+        link->fail_run = 0;
+        LINKADAPT_STATS_INC(fallback);
+        return;
+    }
+
+    if (!success) {
+        if (link->success < MYNEWT_VAL(LINKADAPT_TARGET)) {
+            link->proposed = linkadapt_slower(la, link->profile);
+        }
+    } else if (link->ok_run >= MYNEWT_VAL(LINKADAPT_UP_COUNT)) {
+        next = linkadapt_faster(la, link->profile);
+        if (next != LINKADAPT_PROFILE_DEFAULT) {
+            float margin = MYNEWT_VAL(LINKADAPT_MARGIN);
+            if (link->los < 0.5f) {
+                margin += MYNEWT_VAL(LINKADAPT_NLOS_MARGIN);
+            }
+            if (link->rssi - margin >= g_linkadapt_profiles[next].sensitivity) {
+                link->proposed = next;
+            }
+        }
+        link->ok_run = 0;
+    }
+}
+
+/**
+ * @fn linkadapt_pending(struct linkadapt_instance * la, uint16_t addr)
+ * @brief True if the policy wants a different profile for this peer.
+ *
+ * @return bool
+ */
+bool
+linkadapt_pending(struct linkadapt_instance * la, uint16_t addr)
+{
+    struct linkadapt_link * link = linkadapt_get_link(la, addr);
+
+    return link && link->proposed != link->profile;
+}
+
+/**
+ * @fn linkadapt_negotiate(struct linkadapt_instance * la, uint16_t addr)
+ * @brief Propose the pending profile change to a peer and commit it once
+ * acknowledged. Request and ack use the currently agreed profile. Blocks
+ * until the ack or the receive timeout.
+ *
+ * @param la    Pointer to struct linkadapt_instance.
+ * @param addr  Peer short address.
+ *
+ * @return linkadapt_status_t, acked set if the change was committed.
+ */
+linkadapt_status_t
+linkadapt_negotiate(struct linkadapt_instance * la, uint16_t addr)
+{
+    struct uwb_dev * inst = la->dev_inst;
+    struct linkadapt_link * link = linkadapt_get_link(la, addr);
+
+    la->status.acked = 0;
+    if (link == NULL || link->proposed == link->profile) {
+        return la->status;
+    }
+
+    dpl_error_t err = dpl_sem_pend(&la->sem, DPL_TIMEOUT_NEVER);
+    assert(err == DPL_OK);
+    LINKADAPT_STATS_INC(request);
+
+    linkadapt_apply(la, link->profile);
+    la->frame.fctrl = FCNTL_IEEE_RANGE_16;
+    la->frame.PANID = 0xDECA;
+    la->frame.seq_num++;
+    la->frame.src_address = inst->my_short_address;
+    la->frame.dst_address = addr;
+    la->frame.code = DWT_LINKADAPT_REQUEST;
+    la->frame.profile = link->proposed;
+
+    uwb_write_tx(inst, la->frame.array, 0, sizeof(linkadapt_frame_t));
+    uwb_write_tx_fctrl(inst, sizeof(linkadapt_frame_t), 0);
+    uwb_set_wait4resp(inst, true);
+    uwb_set_wait4resp_delay(inst, 0);
+    uwb_set_rx_timeout(inst, uwb_phy_frame_duration(inst, sizeof(linkadapt_frame_t))
+                       + MYNEWT_VAL(LINKADAPT_RX_TIMEOUT));
+    uwb_set_rxauto_disable(inst, true);
+
+    la->status.start_tx_error = uwb_start_tx(inst).start_tx_error;
+    if (la->status.start_tx_error) {
+        LINKADAPT_STATS_INC(start_tx_error);
+        dpl_sem_release(&la->sem);
+    }
+    err = dpl_sem_pend(&la->sem, DPL_TIMEOUT_NEVER); // Wait for completion of transactions
+    assert(err == DPL_OK);
+
+    if (la->status.acked) {
+        if (link->proposed == linkadapt_slower(la, link->profile)) {
+            LINKADAPT_STATS_INC(step_down);
+        } else {
+            LINKADAPT_STATS_INC(step_up);
+        }
+        link->profile = link->proposed;
+        link->ok_run = link->fail_run = 0;
+    }
+    err = dpl_sem_release(&la->sem);
+    assert(err == DPL_OK);
+    return la->status;
+}
+
+/**
+ * @fn linkadapt_listen(struct linkadapt_instance * la, uint16_t timeout)
+ * @brief Listen for profile change requests, requests are also taken
+ * whenever another service has the receiver on.
+ *
+ * @param la       Pointer to struct linkadapt_instance.
+ * @param timeout  Receive timeout, usec.
+ *
+ * @return linkadapt_status_t
+ */
+linkadapt_status_t
+linkadapt_listen(struct linkadapt_instance * la, uint16_t timeout)
+{
+    struct uwb_dev * inst = la->dev_inst;
+
+    uwb_set_rx_timeout(inst, timeout);
+    la->status.start_rx_error = uwb_start_rx(inst).start_rx_error;
+    if (la->status.start_rx_error) {
+        LINKADAPT_STATS_INC(start_rx_error);
+    }
+    return la->status;
+}
+
+/**
+ * @fn rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+ * @brief Answer profile change requests and take acks.
+ *
+ * @return true if the frame was a linkadapt frame
+ */
+static bool
+rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct linkadapt_instance * la = (struct linkadapt_instance *) cbs->inst_ptr;
+    linkadapt_frame_t * frame = (linkadapt_frame_t *) inst->rxbuf;
+
+    if (inst->fctrl != FCNTL_IEEE_RANGE_16 || inst->frame_len < sizeof(linkadapt_frame_t)) {
+        return false;
+    }
+    if (frame->dst_address != inst->my_short_address) {
+        return false;
+    }
+
+    switch (frame->code) {
+        case DWT_LINKADAPT_REQUEST:
+            if (frame->profile >= LINKADAPT_NPROFILES && frame->profile != LINKADAPT_PROFILE_DEFAULT) {
+                return true;
+            }
+            /* The new profile is committed once the ack is on air */
+            la->pending_addr = frame->src_address;
+            la->pending_profile = frame->profile;
+            la->frame.fctrl = FCNTL_IEEE_RANGE_16;
+            la->frame.PANID = 0xDECA;
+            la->frame.seq_num = frame->seq_num;
+            la->frame.src_address = inst->my_short_address;
+            la->frame.dst_address = frame->src_address;
+            la->frame.code = DWT_LINKADAPT_ACK;
+            la->frame.profile = frame->profile;
+            uwb_write_tx(inst, la->frame.array, 0, sizeof(linkadapt_frame_t));
+            uwb_write_tx_fctrl(inst, sizeof(linkadapt_frame_t), 0);
+            if (uwb_start_tx(inst).start_tx_error) {
+                la->pending_addr = 0;
+                LINKADAPT_STATS_INC(start_tx_error);
+            } else {
+                LINKADAPT_STATS_INC(ack);
+            }
+            return true;
+        case DWT_LINKADAPT_ACK:
+            if (dpl_sem_get_count(&la->sem) == 1) {
+                return true;
+            }
+            if (frame->seq_num != la->frame.seq_num || frame->src_address != la->frame.dst_address) {
+                return true;
+            }
+            la->status.acked = 1;
+            LINKADAPT_STATS_INC(ack_rx);
+            dpl_sem_release(&la->sem);
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool
+tx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct linkadapt_instance * la = (struct linkadapt_instance *) cbs->inst_ptr;
+
+    if (la->pending_addr) {
+        struct linkadapt_link * link = linkadapt_get_link(la, la->pending_addr);
+        if (link) {
+            link->profile = link->proposed = la->pending_profile;
+            link->ok_run = link->fail_run = 0;
+        }
+        la->pending_addr = 0;
+    }
+    return false;
+}
+
+static bool
+rx_timeout_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct linkadapt_instance * la = (struct linkadapt_instance *) cbs->inst_ptr;
+
+    if (dpl_sem_get_count(&la->sem) == 1) {
+        return false;
+    }
+    LINKADAPT_STATS_INC(rx_timeout);
+    dpl_sem_release(&la->sem);
+    return true;
+}
+
+static bool
+reset_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct linkadapt_instance * la = (struct linkadapt_instance *) cbs->inst_ptr;
+
+    la->pending_addr = 0;
+    if (dpl_sem_get_count(&la->sem) == 1) {
+        return false;
+    }
+    dpl_sem_release(&la->sem);
+    return true;
+}
+
+void
+linkadapt_pkg_init(void)
+{
+#if MYNEWT_VAL(LINKADAPT_VERBOSE)
+    printf("{\"utime\": %lu,\"msg\": \"linkadapt_pkg_init\"}\n", os_cputime_ticks_to_usecs(os_cputime_get32()));
+#endif
+#if MYNEWT_VAL(UWB_DEVICE_0)
+    linkadapt_init(NULL, uwb_dev_idx_lookup(0));
+#endif
+#if MYNEWT_VAL(LINKADAPT_CLI)
+    int rc = linkadapt_cli_register();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+}
@@ -0,0 +1,141 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <os/os.h>
+#include <syscfg/syscfg.h>
+
+#if MYNEWT_VAL(LINKADAPT_CLI)
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <shell/shell.h>
+#include <console/console.h>
+
+#include "linkadapt/linkadapt.h"
+
+static int linkadapt_cli_cmd(int argc, char **argv);
+
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+const struct shell_param cmd_linkadapt_param[] = {
+    {"links", "per peer profile and link quality"},
+    {"profiles", "profile table and airtime of a range response"},
+    {"airtime", "airtime used against the default profile"},
+    {"set", "<addr> <profile> force the agreed profile of a peer"},
+    {NULL,NULL},
+};
+
+const struct shell_cmd_help cmd_linkadapt_help = {
+	"linkadapt", "<cmd>", cmd_linkadapt_param
+};
+#endif
+
+static struct shell_cmd shell_linkadapt_cmd = {
+    .sc_cmd = "linkadapt",
+    .sc_cmd_func = linkadapt_cli_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+    .help = &cmd_linkadapt_help
+#endif
+};
+
+static void
+print_float(float v)
+{
+    console_printf("%s%d.%03d", (v < 0) ? "-" : "", (int)fabsf(v),
+                   (int)((fabsf(v) - (int)fabsf(v))*1000));
+}
+
+static void
+linkadapt_cli_links(struct linkadapt_instance * la)
+{
+    console_printf("#addr, profile, proposed, success, rssi, los, exchanges, failures\n");
+    for (int i = 0; i < MYNEWT_VAL(LINKADAPT_MAX_PEERS); i++) {
+        struct linkadapt_link * link = &la->links[i];
+        if (!link->addr) {
+            continue;
+        }
+        console_printf("%4x, %d, %d, ", link->addr,
+                       (link->profile == LINKADAPT_PROFILE_DEFAULT) ? -1 : link->profile,
+                       (link->proposed == LINKADAPT_PROFILE_DEFAULT) ? -1 : link->proposed);
+        print_float(link->success);
+        console_printf(", ");
+        print_float(link->rssi);
+        console_printf(", ");
+        print_float(link->los);
+        console_printf(", %lu, %lu\n", link->exchanges, link->failures);
+    }
+}
+
+static void
+linkadapt_cli_profiles(struct linkadapt_instance * la)
+{
+    uint16_t len = sizeof(ieee_rng_response_frame_t);
+
+    console_printf("#profile, nsync, sensitivity, usec\n");
+    console_printf("default, %d, -, %d\n", la->attrib.nsync,
+                   linkadapt_frame_duration(la, LINKADAPT_PROFILE_DEFAULT, len));
+    for (int i = 0; i < LINKADAPT_NPROFILES; i++) {
+        console_printf("%d%s, %d, ", i, (i > la->slowest) ? "(unused)" : "",
+                       g_linkadapt_profiles[i].nsync);
+        print_float(g_linkadapt_profiles[i].sensitivity);
+        console_printf(", %d\n", linkadapt_frame_duration(la, i, len));
+    }
+}
+
+static int
+linkadapt_cli_cmd(int argc, char **argv)
+{
+    struct linkadapt_instance * la = linkadapt_get_instance();
+
+    if (argc < 2) {
+        return 0;
+    }
+    if (la == NULL) {
+        console_printf("No linkadapt instance\n");
+        return 0;
+    }
+
+    if (!strcmp(argv[1], "links")) {
+        linkadapt_cli_links(la);
+    } else if (!strcmp(argv[1], "profiles")) {
+        linkadapt_cli_profiles(la);
+    } else if (!strcmp(argv[1], "airtime")) {
+        console_printf("airtime_usec: %llu, default_airtime_usec: %llu\n",
+                       la->airtime_usec, la->default_airtime_usec);
+    } else if (!strcmp(argv[1], "set") && argc > 3) {
+        struct linkadapt_link * link = linkadapt_get_link(la, strtol(argv[2], NULL, 0));
+        int profile = strtol(argv[3], NULL, 0);
+        if (link == NULL || profile >= LINKADAPT_NPROFILES) {
+            console_printf("Failed\n");
+            return 0;
+        }
+        link->profile = link->proposed = (profile < 0) ? LINKADAPT_PROFILE_DEFAULT : profile;
+    } else {
+        console_printf("Unknown cmd\n");
+    }
+    return 0;
+}
+
+int
+linkadapt_cli_register(void)
+{
+    return shell_cmd_register(&shell_linkadapt_cmd);
+}
+#endif /* MYNEWT_VAL(LINKADAPT_CLI) */
@@ -0,0 +1,132 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file linkdiag.h
+ * @brief Per peer receive diagnostics aggregator
+ *
+ * @details The receive diagnostics of every frame with a short source
+ * address are folded into per peer rolling statistics of first path power,
+ * received power, their difference, leading edge noise, preamble
+ * accumulation count and carrier integrator clock offset. Each statistic is
+ * an exponentially weighted mean and variance, so memory is fixed and the
+ * cost per frame constant. Frames with an accumulation count well below or
+ * a noise level well above the peer mean are flagged as likely collisions,
+ * the smoothed power difference with hysteresis flags line of sight to non
+ * line of sight transitions.
+ */
+
+#ifndef _LINKDIAG_H_
+#define _LINKDIAG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stats/stats.h>
+#include <uwb/uwb.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MGMT_GROUP_ID_LINKDIAG   (0x104)
+#define LINKDIAG_EXPORT_VERSION  (1)       //!< Version byte leading a binary export
+
+#if MYNEWT_VAL(LINKDIAG_STATS)
+STATS_SECT_START(linkdiag_stat_section)
+    STATS_SECT_ENTRY(frames)
+    STATS_SECT_ENTRY(no_addr)
+    STATS_SECT_ENTRY(invalid)
+    STATS_SECT_ENTRY(evicted)
+    STATS_SECT_ENTRY(collision)
+    STATS_SECT_ENTRY(nlos_enter)
+    STATS_SECT_ENTRY(nlos_exit)
+STATS_SECT_END
+#define LINKDIAG_STATS_INC(__X) STATS_INC(ld->stat, __X)
+#else
+#define LINKDIAG_STATS_INC(__X) {}
+#endif
+
+//! Exponentially weighted mean and variance
+struct linkdiag_stat {
+    float mean;
+    float var;
+};
+
+//! Per peer statistics
+struct linkdiag_peer {
+    uint16_t addr;                     //!< Peer short address, 0 marks a free entry
+    uint16_t nlos:1;                   //!< Link currently non line of sight
+    uint16_t collision:1;              //!< Last frame flagged as a likely collision
+    uint32_t last_seen;                //!< Cputime of the last frame
+    uint32_t frames;                   //!< Frames aggregated
+    uint32_t collisions;               //!< Frames flagged as likely collisions
+    uint32_t nlos_transitions;         //!< Line of sight state changes
+    struct linkdiag_stat fppl;         //!< First path power level, dBm
+    struct linkdiag_stat rssi;         //!< Received power level, dBm
+    struct linkdiag_stat delta;        //!< rssi - fppl, dB
+    struct linkdiag_stat noise;        //!< Leading edge noise standard deviation
+    struct linkdiag_stat pacc;         //!< Preamble symbols accumulated
+    struct linkdiag_stat ppm;          //!< Clock offset from the carrier integrator, ppm
+};
+
+//! Binary export record, one per peer following the version and count bytes
+typedef struct _linkdiag_record_t{
+    uint16_t addr;                     //!< Peer short address
+    uint8_t flags;                     //!< Bit 0 nlos, bit 1 last frame collision
+    uint32_t age_ms;                   //!< Time since the last frame
+    uint32_t frames;                   //!< Frames aggregated
+    uint32_t collisions;               //!< Frames flagged as likely collisions
+    uint32_t nlos_transitions;         //!< Line of sight state changes
+    float mean[6];                     //!< fppl, rssi, delta, noise, pacc, ppm
+    float std[6];                      //!< Standard deviations, same order
+}__attribute__((__packed__,aligned(1))) linkdiag_record_t;
+
+//! Linkdiag status
+typedef struct _linkdiag_status_t{
+    uint16_t selfmalloc:1;             //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;            //!< Instance allocated
+}linkdiag_status_t;
+
+//! Linkdiag instance
+struct linkdiag_instance {
+#if MYNEWT_VAL(LINKDIAG_STATS)
+    STATS_SECT_DECL(linkdiag_stat_section) stat; //!< Stats instance
+#endif
+    struct uwb_dev * dev_inst;         //!< Structure of uwb_dev
+    struct uwb_mac_interface cbs;      //!< MAC layer callbacks
+    linkdiag_status_t status;          //!< Status
+    struct linkdiag_peer peers[MYNEWT_VAL(LINKDIAG_MAX_PEERS)]; //!< Open addressed on the short address
+};
+
+struct linkdiag_instance * linkdiag_init(struct linkdiag_instance * ld, struct uwb_dev * inst);
+void linkdiag_free(struct linkdiag_instance * ld);
+struct linkdiag_instance * linkdiag_get_instance(void);
+void linkdiag_reset(struct linkdiag_instance * ld);
+
+struct linkdiag_peer * linkdiag_get_peer(struct linkdiag_instance * ld, uint16_t addr);
+void linkdiag_update(struct linkdiag_instance * ld, uint32_t timestamp, uint16_t addr, float fppl,
+                     float rssi, float noise, float pacc, float ppm);
+float linkdiag_std(const struct linkdiag_stat * stat);
+int linkdiag_export(struct linkdiag_instance * ld, uint8_t * buf, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LINKDIAG_H_ */
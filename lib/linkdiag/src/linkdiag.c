@@ -0,0 +1,436 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file linkdiag.c
+ * @brief Per peer receive diagnostics aggregator
+ *
+ * @details Peers are kept in an open addressed table probed at most
+ * LINKDIAG_PROBE entries, when all are taken the least recently heard of
+ * them is replaced. Lookup and update are therefore constant time. Noise and
+ * accumulation count are read from the DW1000 diagnostics, powers through
+ * the device agnostic uwb_calc_fppl and uwb_calc_rssi.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <os/os.h>
+#include <sysinit/sysinit.h>
+#include <stats/stats.h>
+#include <uwb/uwb_ftypes.h>
+#include <uwb_ccp/uwb_ccp.h>
+#include <dw1000/dw1000_dev.h>
+#include <linkdiag/linkdiag.h>
+
+#if (MYNEWT_VAL(LINKDIAG_MAX_PEERS) & (MYNEWT_VAL(LINKDIAG_MAX_PEERS) - 1))
+#error "LINKDIAG_MAX_PEERS must be a power of two"
+#endif
+
+#define LINKDIAG_MASK (MYNEWT_VAL(LINKDIAG_MAX_PEERS) - 1)
+#define LINKDIAG_PROBE (4)
+
+#if MYNEWT_VAL(LINKDIAG_STATS)
+STATS_NAME_START(linkdiag_stat_section)
+    STATS_NAME(linkdiag_stat_section, frames)
+    STATS_NAME(linkdiag_stat_section, no_addr)
+    STATS_NAME(linkdiag_stat_section, invalid)
+    STATS_NAME(linkdiag_stat_section, evicted)
+    STATS_NAME(linkdiag_stat_section, collision)
+    STATS_NAME(linkdiag_stat_section, nlos_enter)
+    STATS_NAME(linkdiag_stat_section, nlos_exit)
+STATS_NAME_END(linkdiag_stat_section)
+#endif
+
+static struct linkdiag_instance * g_linkdiag = NULL;
+
+static bool rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+
+#if MYNEWT_VAL(LINKDIAG_CLI)
+int linkdiag_cli_register(void);
+#endif
+#if MYNEWT_VAL(LINKDIAG_NMGR)
+int linkdiag_nmgr_register(void);
+#endif
+
+/**
+ * @fn linkdiag_init(struct linkdiag_instance * ld, struct uwb_dev * inst)
+ * @brief Allocate and initialise a diagnostics aggregator.
+ *
+ * @param ld    Pointer to struct linkdiag_instance, NULL to allocate.
+ * @param inst  Pointer to struct uwb_dev.
+ *
+ * @return struct linkdiag_instance *
+ */
+struct linkdiag_instance *
+linkdiag_init(struct linkdiag_instance * ld, struct uwb_dev * inst)
+{
+    assert(inst);
+
+    if (ld == NULL) {
+        ld = (struct linkdiag_instance *) malloc(sizeof(struct linkdiag_instance));
+        assert(ld);
+        memset(ld, 0, sizeof(struct linkdiag_instance));
+        ld->status.selfmalloc = 1;
+    }
+    ld->dev_inst = inst;
+    linkdiag_reset(ld);
+
+    ld->cbs = (struct uwb_mac_interface){
+        .id = UWBEXT_LINKDIAG,
+        .inst_ptr = (void *) ld,
+        .rx_complete_cb = rx_complete_cb
+    };
+    if (!ld->status.initialized) {
+        uwb_mac_append_interface(inst, &ld->cbs);
+#if MYNEWT_VAL(LINKDIAG_STATS)
+        int rc = stats_init(
+                    STATS_HDR(ld->stat),
+                    STATS_SIZE_INIT_PARMS(ld->stat, STATS_SIZE_32),
+                    STATS_NAME_INIT_PARMS(linkdiag_stat_section)
+            );
+        rc |= stats_register("linkdiag", STATS_HDR(ld->stat));
+        assert(rc == 0);
+#endif
+    }
+    ld->status.initialized = 1;
+    g_linkdiag = ld;
+    return ld;
+}
+
+/**
+ * @fn linkdiag_free(struct linkdiag_instance * ld)
+ * @brief Free the instance.
+ *
+ * @param ld  Pointer to struct linkdiag_instance.
+ *
+ * @return void
+ */
+void
+linkdiag_free(struct linkdiag_instance * ld)
+{
+    assert(ld);
+    uwb_mac_remove_interface(ld->dev_inst, ld->cbs.id);
+    if (g_linkdiag == ld) {
+        g_linkdiag = NULL;
+    }
+    if (ld->status.selfmalloc) {
+        free(ld);
+    } else {
+        ld->status.initialized = 0;
+    }
+}
+
+/**
+ * @fn linkdiag_get_instance(void)
+ * @brief Instance created by the last linkdiag_init, used by the cli.
+ *
+ * @return struct linkdiag_instance *
+ */
+struct linkdiag_instance *
+linkdiag_get_instance(void)
+{
+    return g_linkdiag;
+}
+
+/**
+ * @fn linkdiag_reset(struct linkdiag_instance * ld)
+ * @brief Forget all peers.
+ *
+ * @return void
+ */
+void
+linkdiag_reset(struct linkdiag_instance * ld)
+{
+    memset(ld->peers, 0, sizeof(ld->peers));
+}
+
+static struct linkdiag_peer *
+linkdiag_lookup(struct linkdiag_instance * ld, uint16_t addr, uint32_t now)
+{
+    struct linkdiag_peer * free_peer = NULL, * oldest = NULL, * victim;
+    uint16_t h = (uint16_t)(addr * 40503u) >> 8;
+
+    if (addr == 0) {
+        return NULL;
+    }
+    for (uint16_t i = 0; i < LINKDIAG_PROBE && i <= LINKDIAG_MASK; i++) {
+        struct linkdiag_peer * peer = &ld->peers[(h + i) & LINKDIAG_MASK];
+        if (peer->addr == addr) {
+            return peer;
+        }
+        if (!peer->addr) {
+            if (free_peer == NULL) {
+                free_peer = peer;
+            }
+        } else if (oldest == NULL || now - peer->last_seen > now - oldest->last_seen) {
+            oldest = peer;
+        }
+    }
+    victim = free_peer ? free_peer : oldest;
+    if (victim->addr) {
+        LINKDIAG_STATS_INC(evicted);
+    }
+    memset(victim, 0, sizeof(struct linkdiag_peer));
+    victim->addr = addr;
+    victim->last_seen = now;
+    return victim;
+}
+
+/**
+ * @fn linkdiag_get_peer(struct linkdiag_instance * ld, uint16_t addr)
+ * @brief Statistics of a peer, a fresh entry replacing the least recently
+ * heard probed peer if it is not tracked.
+ *
+ * @param ld    Pointer to struct linkdiag_instance.
+ * @param addr  Peer short address.
+ *
+ * @return struct linkdiag_peer *, NULL for address 0
+ */
+struct linkdiag_peer *
+linkdiag_get_peer(struct linkdiag_instance * ld, uint16_t addr)
+{
+    return linkdiag_lookup(ld, addr, os_cputime_get32());
+}
+
+/**
+ * @fn linkdiag_std(const struct linkdiag_stat * stat)
+ * @brief Standard deviation of a rolling statistic.
+ *
+ * @return float
+ */
+float
+linkdiag_std(const struct linkdiag_stat * stat)
+{
+    return sqrtf(stat->var);
+}
+
+static void
+linkdiag_stat_update(struct linkdiag_stat * stat, float x, bool first)
+{
+    float d = x - stat->mean;
+
+    if (first) {
+        stat->mean = x;
+        stat->var = 0;
+        return;
+    }
+    stat->mean += MYNEWT_VAL(LINKDIAG_ALPHA) * d;
+    stat->var = (1.0f - MYNEWT_VAL(LINKDIAG_ALPHA)) * (stat->var + MYNEWT_VAL(LINKDIAG_ALPHA) * d * d);
+}
+
+/**
+ * @fn linkdiag_update(struct linkdiag_instance * ld, uint32_t timestamp, uint16_t addr, float fppl, float rssi, float noise, float pacc, float ppm)
+ * @brief Fold one frame into the statistics of a peer. Called for every
+ * received frame, exposed for feeding recorded diagnostics.
+ *
+ * @param ld         Pointer to struct linkdiag_instance.
+ * @param timestamp  Reception time, os_cputime ticks.
+ * @param addr       Peer short address.
+ * @param fppl       First path power level, dBm.
+ * @param rssi       Received power level, dBm.
+ * @param noise      Leading edge noise standard deviation.
+ * @param pacc       Preamble symbols accumulated.
+ * @param ppm        Clock offset, ppm, NAN if not available.
+ *
+ * @return void
+ */
+void
+linkdiag_update(struct linkdiag_instance * ld, uint32_t timestamp, uint16_t addr, float fppl,
+                float rssi, float noise, float pacc, float ppm)
+{
+    struct linkdiag_peer * peer = linkdiag_lookup(ld, addr, timestamp);
+    bool first;
+    float delta = rssi - fppl;
+
+    if (peer == NULL) {
+        return;
+    }
+    first = (peer->frames == 0);
+    LINKDIAG_STATS_INC(frames);
+
+    /* Test against the statistics before this frame enters them */
+    peer->collision = 0;
+    if (peer->frames >= MYNEWT_VAL(LINKDIAG_MIN_FRAMES)) {
+        if (pacc < peer->pacc.mean * (1.0f - MYNEWT_VAL(LINKDIAG_PACC_DROP))
+            || noise > peer->noise.mean + MYNEWT_VAL(LINKDIAG_NOISE_SIGMA) * linkdiag_std(&peer->noise)) {
+            peer->collision = 1;
+            peer->collisions++;
+            LINKDIAG_STATS_INC(collision);
+        }
+    }
+
+    linkdiag_stat_update(&peer->fppl, fppl, first);
+    linkdiag_stat_update(&peer->rssi, rssi, first);
+    linkdiag_stat_update(&peer->delta, delta, first);
+    linkdiag_stat_update(&peer->noise, noise, first);
+    linkdiag_stat_update(&peer->pacc, pacc, first);
+    if (isfinite(ppm)) {
+        linkdiag_stat_update(&peer->ppm, ppm, first || !isfinite(peer->ppm.mean));
+    } else if (first) {
+        peer->ppm.mean = NAN;
+    }
+    peer->frames++;
+    peer->last_seen = timestamp;
+
+    if (peer->frames < MYNEWT_VAL(LINKDIAG_MIN_FRAMES)) {
+        peer->nlos = (peer->delta.mean > MYNEWT_VAL(LINKDIAG_NLOS_ENTER));
+    } else if (!peer->nlos && peer->delta.mean > MYNEWT_VAL(LINKDIAG_NLOS_ENTER)) {
+        peer->nlos = 1;
+        peer->nlos_transitions++;
+        LINKDIAG_STATS_INC(nlos_enter);
+    } else if (peer->nlos && peer->delta.mean < MYNEWT_VAL(LINKDIAG_NLOS_EXIT)) {
+        peer->nlos = 0;
+        peer->nlos_transitions++;
+        LINKDIAG_STATS_INC(nlos_exit);
+    }
+#if MYNEWT_VAL(LINKDIAG_VERBOSE)
+    if (peer->collision) {
+        printf("{\"utime\": %lu,\"msg\": \"linkdiag_collision\",\"addr\": \"%X\"}\n",
+               os_cputime_ticks_to_usecs(peer->last_seen), addr);
+    }
+#endif
+}
+
+/**
+ * @fn linkdiag_export(struct linkdiag_instance * ld, uint8_t * buf, uint16_t len)
+ * @brief Binary export of all peers: version, count, then count
+ * linkdiag_record_t in little endian. Peers that do not fit are left out.
+ *
+ * @param ld   Pointer to struct linkdiag_instance.
+ * @param buf  Destination.
+ * @param len  Size of buf.
+ *
+ * @return bytes written, OS_EINVAL if buf cannot hold the header
+ */
+int
+linkdiag_export(struct linkdiag_instance * ld, uint8_t * buf, uint16_t len)
+{
+    uint32_t now = os_cputime_get32();
+    uint16_t off = 2;
+    uint8_t count = 0;
+
+    if (len < 2) {
+        return OS_EINVAL;
+    }
+    for (uint16_t i = 0; i <= LINKDIAG_MASK && off + sizeof(linkdiag_record_t) <= len; i++) {
+        struct linkdiag_peer * peer = &ld->peers[i];
+        if (!peer->addr) {
+            continue;
+        }
+        const struct linkdiag_stat * stats[6] = {
+            &peer->fppl, &peer->rssi, &peer->delta, &peer->noise, &peer->pacc, &peer->ppm
+        };
+        linkdiag_record_t rec = {
+            .addr = peer->addr,
+            .flags = peer->nlos | (peer->collision << 1),
+            .age_ms = os_cputime_ticks_to_usecs(now - peer->last_seen) / 1000,
+            .frames = peer->frames,
+            .collisions = peer->collisions,
+            .nlos_transitions = peer->nlos_transitions
+        };
+        for (int j = 0; j < 6; j++) {
+            rec.mean[j] = stats[j]->mean;
+            rec.std[j] = linkdiag_std(stats[j]);
+        }
+        memcpy(buf + off, &rec, sizeof(rec));
+        off += sizeof(rec);
+        count++;
+    }
+    buf[0] = LINKDIAG_EXPORT_VERSION;
+    buf[1] = count;
+    return off;
+}
+
+/**
+ * @fn linkdiag_src_address(struct uwb_dev * inst, uint16_t * addr)
+ * @brief Short source address of the received frame, clock calibration
+ * blinks and frames with short addresses and pan id compression.
+ */
+static bool
+linkdiag_src_address(struct uwb_dev * inst, uint16_t * addr)
+{
+    if (inst->fctrl_array[0] == FCNTL_IEEE_BLINK_CCP_64) {
+        if (inst->frame_len < sizeof(uwb_ccp_blink_frame_t)) {
+            return false;
+        }
+        *addr = ((uwb_ccp_blink_frame_t *) inst->rxbuf)->short_address;
+        return true;
+    }
+    if ((inst->fctrl & 0xCC40) == 0x8840 && inst->frame_len >= 9) {
+        *addr = inst->rxbuf[7] | (inst->rxbuf[8] << 8);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @fn rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+ * @brief Aggregate the diagnostics of the frame, never consumes it.
+ *
+ * @return false
+ */
+static bool
+rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct linkdiag_instance * ld = (struct linkdiag_instance *) cbs->inst_ptr;
+    dw1000_dev_rxdiag_t * diag = (dw1000_dev_rxdiag_t *) inst->rxdiag;
+    uint16_t addr;
+    float fppl, rssi, ppm = NAN;
+
+    if (!inst->config.rxdiag_enable) {
+        return false;
+    }
+    if (!linkdiag_src_address(inst, &addr)) {
+        LINKDIAG_STATS_INC(no_addr);
+        return false;
+    }
+    fppl = uwb_calc_fppl(inst, inst->rxdiag);
+    rssi = uwb_calc_rssi(inst, inst->rxdiag);
+    if (!isfinite(fppl) || !isfinite(rssi)) {
+        LINKDIAG_STATS_INC(invalid);
+        return false;
+    }
+    if (!inst->config.dblbuffon_enabled) {
+        ppm = uwb_calc_clock_offset_ratio(inst, inst->carrier_integrator, UWB_CR_CARRIER_INTEGRATOR) * 1e6f;
+    }
+    linkdiag_update(ld, os_cputime_get32(), addr, fppl, rssi, diag->rx_std, diag->pacc_cnt, ppm);
+    return false;
+}
+
+void
+linkdiag_pkg_init(void)
+{
+#if MYNEWT_VAL(LINKDIAG_VERBOSE)
+    printf("{\"utime\": %lu,\"msg\": \"linkdiag_pkg_init\"}\n", os_cputime_ticks_to_usecs(os_cputime_get32()));
+#endif
+#if MYNEWT_VAL(UWB_DEVICE_0)
+    linkdiag_init(NULL, uwb_dev_idx_lookup(0));
+#endif
+#if MYNEWT_VAL(LINKDIAG_CLI)
+    int rc = linkdiag_cli_register();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+#if MYNEWT_VAL(LINKDIAG_NMGR)
+    int rc_nmgr = linkdiag_nmgr_register();
+    SYSINIT_PANIC_ASSERT(rc_nmgr == 0);
+#endif
+}
@@ -0,0 +1,159 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <os/os.h>
+#include <syscfg/syscfg.h>
+
+#if MYNEWT_VAL(LINKDIAG_CLI)
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <shell/shell.h>
+#include <console/console.h>
+
+#include "linkdiag/linkdiag.h"
+
+static int linkdiag_cli_cmd(int argc, char **argv);
+
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+const struct shell_param cmd_linkdiag_param[] = {
+    {"peers", "per peer mean and std of fppl, rssi, delta, noise, pacc, ppm"},
+    {"peer", "<addr> statistics of one peer"},
+    {"export", "binary export as hex"},
+    {"reset", "forget all peers"},
+    {NULL,NULL},
+};
+
+const struct shell_cmd_help cmd_linkdiag_help = {
+	"linkdiag", "<cmd>", cmd_linkdiag_param
+};
+#endif
+
+static struct shell_cmd shell_linkdiag_cmd = {
+    .sc_cmd = "linkdiag",
+    .sc_cmd_func = linkdiag_cli_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+    .help = &cmd_linkdiag_help
+#endif
+};
+
+static void
+print_float(float v)
+{
+    if (!isfinite(v)) {
+        console_printf("-");
+        return;
+    }
+    console_printf("%s%d.%03d", (v < 0) ? "-" : "", (int)fabsf(v),
+                   (int)((fabsf(v) - (int)fabsf(v))*1000));
+}
+
+static void
+linkdiag_cli_stat(const struct linkdiag_stat * stat)
+{
+    console_printf(", ");
+    print_float(stat->mean);
+    console_printf("/");
+    print_float(linkdiag_std(stat));
+}
+
+static void
+linkdiag_cli_peer(struct linkdiag_peer * peer)
+{
+    console_printf("%4x, %lu, %lu, %lu, %d", peer->addr, peer->frames, peer->collisions,
+                   peer->nlos_transitions, peer->nlos);
+    linkdiag_cli_stat(&peer->fppl);
+    linkdiag_cli_stat(&peer->rssi);
+    linkdiag_cli_stat(&peer->delta);
+    linkdiag_cli_stat(&peer->noise);
+    linkdiag_cli_stat(&peer->pacc);
+    linkdiag_cli_stat(&peer->ppm);
+    console_printf("\n");
+}
+
+static void
+linkdiag_cli_header(void)
+{
+    console_printf("#addr, frames, collisions, nlos_transitions, nlos, fppl, rssi, delta, noise, pacc, ppm (mean/std)\n");
+}
+
+static void
+linkdiag_cli_export(struct linkdiag_instance * ld)
+{
+    uint16_t size = 2 + MYNEWT_VAL(LINKDIAG_MAX_PEERS) * sizeof(linkdiag_record_t);
+    uint8_t * buf = (uint8_t *) malloc(size);
+    int len;
+
+    if (buf == NULL) {
+        console_printf("No memory\n");
+        return;
+    }
+    len = linkdiag_export(ld, buf, size);
+    for (int i = 0; i < len; i++) {
+        console_printf("%02x", buf[i]);
+    }
+    console_printf("\n");
+    free(buf);
+}
+
+static int
+linkdiag_cli_cmd(int argc, char **argv)
+{
+    struct linkdiag_instance * ld = linkdiag_get_instance();
+
+    if (argc < 2) {
+        return 0;
+    }
+    if (ld == NULL) {
+        console_printf("No linkdiag instance\n");
+        return 0;
+    }
+
+    if (!strcmp(argv[1], "peers")) {
+        linkdiag_cli_header();
+        for (int i = 0; i < MYNEWT_VAL(LINKDIAG_MAX_PEERS); i++) {
+            if (ld->peers[i].addr) {
+                linkdiag_cli_peer(&ld->peers[i]);
+            }
+        }
+    } else if (!strcmp(argv[1], "peer") && argc > 2) {
+        uint16_t addr = strtol(argv[2], NULL, 16);
+        linkdiag_cli_header();
+        for (int i = 0; i < MYNEWT_VAL(LINKDIAG_MAX_PEERS); i++) {
+            if (ld->peers[i].addr == addr) {
+                linkdiag_cli_peer(&ld->peers[i]);
+            }
+        }
+    } else if (!strcmp(argv[1], "export")) {
+        linkdiag_cli_export(ld);
+    } else if (!strcmp(argv[1], "reset")) {
+        linkdiag_reset(ld);
+    } else {
+        console_printf("Unknown cmd\n");
+    }
+    return 0;
+}
+
+int
+linkdiag_cli_register(void)
+{
+    return shell_cmd_register(&shell_linkdiag_cmd);
+}
+#endif /* MYNEWT_VAL(LINKDIAG_CLI) */
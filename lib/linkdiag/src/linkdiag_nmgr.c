@@ -0,0 +1,87 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+
+#include "os/mynewt.h"
+#if MYNEWT_VAL(LINKDIAG_NMGR)
+#include "mgmt/mgmt.h"
+#include "cborattr/cborattr.h"
+
+#include <linkdiag/linkdiag.h>
+
+static int linkdiag_nmgr_read(struct mgmt_cbuf *);
+
+static const struct mgmt_handler linkdiag_nmgr_handlers[] = {
+    [0] = {
+        .mh_read = linkdiag_nmgr_read
+    }
+};
+
+#define LINKDIAG_HANDLER_CNT                                              \
+    sizeof(linkdiag_nmgr_handlers) / sizeof(linkdiag_nmgr_handlers[0])
+
+static struct mgmt_group linkdiag_nmgr_group = {
+    .mg_handlers = (struct mgmt_handler *)linkdiag_nmgr_handlers,
+    .mg_handlers_count = LINKDIAG_HANDLER_CNT,
+    .mg_group_id = MGMT_GROUP_ID_LINKDIAG,
+};
+
+/**
+ * @fn linkdiag_nmgr_read(struct mgmt_cbuf *cb)
+ * @brief Reply with the binary export as byte string "diag".
+ */
+static int
+linkdiag_nmgr_read(struct mgmt_cbuf *cb)
+{
+    struct linkdiag_instance * ld = linkdiag_get_instance();
+    uint16_t size = 2 + MYNEWT_VAL(LINKDIAG_MAX_PEERS) * sizeof(linkdiag_record_t);
+    CborError g_err = CborNoError;
+    uint8_t * buf;
+    int len;
+
+    if (ld == NULL) {
+        return MGMT_ERR_ENOENT;
+    }
+    buf = (uint8_t *) malloc(size);
+    if (buf == NULL) {
+        return MGMT_ERR_ENOMEM;
+    }
+    len = linkdiag_export(ld, buf, size);
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "diag");
+    g_err |= cbor_encode_byte_string(&cb->encoder, buf, len);
+    free(buf);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return 0;
+}
+
+int
+linkdiag_nmgr_register(void)
+{
+    return mgmt_group_register(&linkdiag_nmgr_group);
+}
+
+#endif // MYNEWT_VAL(LINKDIAG_NMGR)
@@ -0,0 +1,104 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "linkdiag_test.h"
+
+static struct uwb_dev g_dev;
+static uint32_t g_seed = 1;
+
+void
+linkdiag_test_seed(uint32_t seed)
+{
+    g_seed = (seed) ? seed : 1;
+}
+
+static float
+randu(void)
+{
+    g_seed ^= g_seed << 13;
+    g_seed ^= g_seed >> 17;
+    g_seed ^= g_seed << 5;
+    return (g_seed >> 8) * (1.0f / 16777216.0f);
+}
+
+float
+linkdiag_test_randn(void)
+{
+    float u = randu();
+
+    while (u < 1e-7f) {
+        u = randu();
+    }
+    return sqrtf(-2.0f * logf(u)) * cosf(2.0f * (float)M_PI * randu());
+}
+
+/**
+ * Initialise the aggregator on a dummy uwb device.
+ */
+void
+linkdiag_test_setup(struct linkdiag_instance * ld)
+{
+    memset(&g_dev, 0, sizeof(g_dev));
+    memset(ld, 0, sizeof(*ld));
+    TEST_ASSERT_FATAL(linkdiag_init(ld, &g_dev) == ld);
+}
+
+/**
+ * Reception time of the nth replayed frame, never zero.
+ */
+uint32_t
+linkdiag_test_time(uint32_t n)
+{
+    return (n + 1) * LINKDIAG_TEST_PERIOD;
+}
+
+/**
+ * Feed one recorded frame as the nth of a trace.
+ */
+void
+linkdiag_test_replay(struct linkdiag_instance * ld, const struct linkdiag_test_frame * frame, uint32_t n)
+{
+    linkdiag_update(ld, linkdiag_test_time(n), frame->addr, frame->fppl, frame->rssi,
+                    frame->noise, frame->pacc, frame->ppm);
+}
+
+/**
+ * First table entry probed for an address, mirrors the hash in linkdiag.c.
+ */
+uint16_t
+linkdiag_test_slot(uint16_t addr)
+{
+    return ((uint16_t)(addr * 40503u) >> 8) & (MYNEWT_VAL(LINKDIAG_MAX_PEERS) - 1);
+}
+
+/**
+ * Tracked peer without creating an entry, NULL if not in the table.
+ */
+struct linkdiag_peer *
+linkdiag_test_find(struct linkdiag_instance * ld, uint16_t addr)
+{
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(LINKDIAG_MAX_PEERS); i++) {
+        if (addr && ld->peers[i].addr == addr) {
+            return &ld->peers[i];
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,64 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _LINKDIAG_TEST_H
+#define _LINKDIAG_TEST_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "testutil/testutil.h"
+
+#include "linkdiag/linkdiag.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Diagnostics of one received frame, as recorded from rx_complete_cb
+struct linkdiag_test_frame {
+    uint16_t addr;
+    float fppl;                        //!< dBm
+    float rssi;                        //!< dBm
+    float noise;
+    float pacc;
+    float ppm;
+};
+
+//! Frame interval of a replayed trace, os_cputime ticks
+#define LINKDIAG_TEST_PERIOD (os_cputime_usecs_to_ticks(10000))
+
+void linkdiag_test_setup(struct linkdiag_instance * ld);
+void linkdiag_test_seed(uint32_t seed);
+float linkdiag_test_randn(void);
+uint32_t linkdiag_test_time(uint32_t n);
+void linkdiag_test_replay(struct linkdiag_instance * ld, const struct linkdiag_test_frame * frame, uint32_t n);
+uint16_t linkdiag_test_slot(uint16_t addr);
+struct linkdiag_peer * linkdiag_test_find(struct linkdiag_instance * ld, uint16_t addr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
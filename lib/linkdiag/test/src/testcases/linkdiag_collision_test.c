@@ -0,0 +1,77 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "linkdiag_test.h"
+
+#define COLLISION_EVERY (30)
+
+TEST_CASE(linkdiag_collision_test)
+{
+    struct linkdiag_instance ld;
+    struct linkdiag_test_frame frame = {
+        .addr = 0x2001, .fppl = -82.0f, .rssi = -78.0f, .ppm = NAN
+    };
+    struct linkdiag_peer * peer;
+    uint32_t n, injected = 0, missed = 0, false_alarms = 0;
+    bool collision;
+
+    linkdiag_test_seed(0xc2b2ae35);
+    linkdiag_test_setup(&ld);
+
+    /* Every COLLISION_EVERY frames a collision, alternately seen as a
+     * preamble accumulation drop and as a leading edge noise rise */
+    for (n = 0; n < 10 * COLLISION_EVERY; n++) {
+        collision = (n % COLLISION_EVERY == COLLISION_EVERY - 1);
+        frame.pacc = 1000.0f + 15.0f * linkdiag_test_randn();
+        frame.noise = 40.0f + 2.0f * linkdiag_test_randn();
+        if (collision && (n / COLLISION_EVERY) % 2) {
+            frame.pacc = 550.0f;
+        } else if (collision) {
+            frame.noise += 25.0f;
+        }
+        linkdiag_test_replay(&ld, &frame, n);
+
+        peer = linkdiag_test_find(&ld, frame.addr);
+        TEST_ASSERT_FATAL(peer != NULL);
+        injected += collision;
+        missed += collision && !peer->collision;
+        false_alarms += !collision && peer->collision;
+    }
+    printf("collision: %lu injected %lu missed %lu false\n", (unsigned long)injected,
+           (unsigned long)missed, (unsigned long)false_alarms);
+
+    TEST_ASSERT(missed == 0, "missed %lu", (unsigned long)missed);
+    TEST_ASSERT(false_alarms <= 2, "false alarms %lu", (unsigned long)false_alarms);
+    TEST_ASSERT(peer->collisions == injected + false_alarms);
+#if MYNEWT_VAL(LINKDIAG_STATS)
+    TEST_ASSERT(ld.stat.collision == peer->collisions);
+#endif
+
+    /* Nothing is flagged before LINKDIAG_MIN_FRAMES */
+    frame.addr = 0x2002;
+    frame.noise = 40.0f;
+    for (n = 0; n < MYNEWT_VAL(LINKDIAG_MIN_FRAMES); n++) {
+        frame.pacc = (n % 2) ? 1000.0f : 100.0f;
+        linkdiag_test_replay(&ld, &frame, n);
+    }
+    peer = linkdiag_test_find(&ld, frame.addr);
+    TEST_ASSERT_FATAL(peer != NULL);
+    TEST_ASSERT(peer->collisions == 0);
+
+    linkdiag_free(&ld);
+}
@@ -0,0 +1,72 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "linkdiag_test.h"
+
+TEST_CASE(linkdiag_export_test)
+{
+    struct linkdiag_instance ld;
+    struct linkdiag_test_frame frame = {
+        .noise = 40.0f, .pacc = 1000.0f, .ppm = 1.5f
+    };
+    uint8_t buf[2 + 3 * sizeof(linkdiag_record_t)];
+    linkdiag_record_t rec;
+    uint32_t n = 0, i, found = 0;
+    int rc;
+
+    linkdiag_test_setup(&ld);
+
+    rc = linkdiag_export(&ld, buf, 1);
+    TEST_ASSERT(rc == OS_EINVAL);
+    rc = linkdiag_export(&ld, buf, sizeof(buf));
+    TEST_ASSERT(rc == 2);
+    TEST_ASSERT(buf[0] == LINKDIAG_EXPORT_VERSION);
+    TEST_ASSERT(buf[1] == 0);
+
+    /* Peer a has a 3dB, b a 6dB and c a 15dB power difference */
+    for (i = 0; i < 3 * 20; i++) {
+        frame.addr = 0x5001 + i % 3;
+        frame.fppl = -80.0f - (i % 3);
+        frame.rssi = frame.fppl + ((i % 3 == 2) ? 15.0f : 3.0f * (1 + i % 3));
+        linkdiag_test_replay(&ld, &frame, n++);
+    }
+
+    rc = linkdiag_export(&ld, buf, sizeof(buf));
+    TEST_ASSERT_FATAL(rc == sizeof(buf), "rc %d", rc);
+    TEST_ASSERT(buf[0] == LINKDIAG_EXPORT_VERSION);
+    TEST_ASSERT_FATAL(buf[1] == 3);
+    for (i = 0; i < 3; i++) {
+        memcpy(&rec, buf + 2 + i * sizeof(rec), sizeof(rec));
+        TEST_ASSERT(rec.addr >= 0x5001 && rec.addr <= 0x5003, "addr %x", rec.addr);
+        TEST_ASSERT(rec.frames == 20);
+        TEST_ASSERT(rec.collisions == 0);
+        TEST_ASSERT(fabsf(rec.mean[0] - (-80.0f - (rec.addr - 0x5001))) < 1e-3f, "fppl %f", rec.mean[0]);
+        TEST_ASSERT(fabsf(rec.mean[5] - 1.5f) < 1e-4f, "ppm %f", rec.mean[5]);
+        TEST_ASSERT(rec.std[0] < 1e-3f);
+        TEST_ASSERT((rec.flags & 1) == (rec.addr == 0x5003), "addr %x flags %x", rec.addr, rec.flags);
+        found |= 1 << (rec.addr - 0x5001);
+    }
+    TEST_ASSERT(found == 7);
+
+    /* Records that do not fit are left out */
+    rc = linkdiag_export(&ld, buf, 2 + sizeof(rec) + 10);
+    TEST_ASSERT(rc == 2 + sizeof(rec));
+    TEST_ASSERT(buf[1] == 1);
+
+    linkdiag_free(&ld);
+}
@@ -0,0 +1,85 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "linkdiag_test.h"
+
+static uint32_t g_n;
+
+/* Frames with a given rssi to first path power difference, returns the
+ * number of nlos state changes seen */
+static uint32_t
+replay_delta(struct linkdiag_instance * ld, uint16_t addr, float delta, uint32_t frames)
+{
+    struct linkdiag_test_frame frame = {
+        .addr = addr, .noise = 40.0f, .pacc = 1000.0f, .ppm = NAN
+    };
+    struct linkdiag_peer * peer;
+    uint32_t i, changes = 0;
+    bool nlos;
+
+    peer = linkdiag_test_find(ld, addr);
+    nlos = peer ? peer->nlos : 0;
+    for (i = 0; i < frames; i++) {
+        frame.fppl = -85.0f + 0.5f * linkdiag_test_randn();
+        frame.rssi = frame.fppl + delta + 0.5f * linkdiag_test_randn();
+        linkdiag_test_replay(ld, &frame, g_n++);
+        peer = linkdiag_test_find(ld, addr);
+        changes += (peer->nlos != nlos);
+        nlos = peer->nlos;
+    }
+    return changes;
+}
+
+TEST_CASE(linkdiag_nlos_test)
+{
+    struct linkdiag_instance ld;
+    struct linkdiag_peer * peer;
+    float mid = 0.5f * (MYNEWT_VAL(LINKDIAG_NLOS_ENTER) + MYNEWT_VAL(LINKDIAG_NLOS_EXIT));
+
+    linkdiag_test_seed(0x27d4eb2f);
+    linkdiag_test_setup(&ld);
+    g_n = 0;
+
+    /* Line of sight, blocked, then between the thresholds and clear */
+    TEST_ASSERT(replay_delta(&ld, 0x3001, 3.0f, 100) == 0);
+    peer = linkdiag_test_find(&ld, 0x3001);
+    TEST_ASSERT_FATAL(peer != NULL);
+    TEST_ASSERT(!peer->nlos);
+    TEST_ASSERT(replay_delta(&ld, 0x3001, 14.0f, 100) == 1);
+    TEST_ASSERT(peer->nlos);
+    TEST_ASSERT(replay_delta(&ld, 0x3001, mid, 100) == 0);
+    TEST_ASSERT(peer->nlos);
+    TEST_ASSERT(replay_delta(&ld, 0x3001, 3.0f, 100) == 1);
+    TEST_ASSERT(!peer->nlos);
+    TEST_ASSERT(replay_delta(&ld, 0x3001, mid, 100) == 0);
+    TEST_ASSERT(!peer->nlos);
+    TEST_ASSERT(peer->nlos_transitions == 2);
+#if MYNEWT_VAL(LINKDIAG_STATS)
+    TEST_ASSERT(ld.stat.nlos_enter == 1);
+    TEST_ASSERT(ld.stat.nlos_exit == 1);
+#endif
+
+    /* A link first heard blocked is not a transition */
+    replay_delta(&ld, 0x3002, 14.0f, 50);
+    peer = linkdiag_test_find(&ld, 0x3002);
+    TEST_ASSERT_FATAL(peer != NULL);
+    TEST_ASSERT(peer->nlos);
+    TEST_ASSERT(peer->nlos_transitions == 0);
+
+    linkdiag_free(&ld);
+}
@@ -0,0 +1,73 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "linkdiag_test.h"
+
+TEST_CASE(linkdiag_stat_test)
+{
+    struct linkdiag_instance ld;
+    struct linkdiag_test_frame frame = {
+        .addr = 0x1001, .fppl = -80.0f, .rssi = -75.0f, .noise = 40.0f, .pacc = 1000.0f, .ppm = NAN
+    };
+    struct linkdiag_peer * peer;
+    uint32_t n;
+
+    linkdiag_test_setup(&ld);
+
+    /* A constant link, clock offset not available at first */
+    for (n = 0; n < 50; n++) {
+        linkdiag_test_replay(&ld, &frame, n);
+    }
+    peer = linkdiag_test_find(&ld, frame.addr);
+    TEST_ASSERT_FATAL(peer != NULL);
+    TEST_ASSERT(peer->frames == 50);
+    TEST_ASSERT(peer->last_seen == linkdiag_test_time(49));
+    TEST_ASSERT(fabsf(peer->fppl.mean + 80.0f) < 1e-4f, "fppl %f", peer->fppl.mean);
+    TEST_ASSERT(fabsf(peer->delta.mean - 5.0f) < 1e-4f, "delta %f", peer->delta.mean);
+    TEST_ASSERT(fabsf(peer->pacc.mean - 1000.0f) < 1e-2f, "pacc %f", peer->pacc.mean);
+    TEST_ASSERT(linkdiag_std(&peer->noise) < 1e-3f);
+    TEST_ASSERT(isnan(peer->ppm.mean));
+
+    /* The first clock offset seeds the statistic */
+    frame.ppm = 2.5f;
+    for (; n < 60; n++) {
+        linkdiag_test_replay(&ld, &frame, n);
+    }
+    TEST_ASSERT(fabsf(peer->ppm.mean - 2.5f) < 1e-4f, "ppm %f", peer->ppm.mean);
+    TEST_ASSERT(peer->collisions == 0);
+    TEST_ASSERT(!peer->nlos);
+
+    /* Noisy powers, the rolling statistics follow mean and spread */
+    linkdiag_test_seed(0x85ebca6b);
+    frame.addr = 0x1002;
+    for (n = 0; n < 2000; n++) {
+        frame.fppl = -85.0f + 2.0f * linkdiag_test_randn();
+        frame.rssi = frame.fppl + 4.0f + 0.5f * linkdiag_test_randn();
+        linkdiag_test_replay(&ld, &frame, n);
+    }
+    peer = linkdiag_test_find(&ld, frame.addr);
+    TEST_ASSERT_FATAL(peer != NULL);
+    printf("stat: fppl %.2f std %.2f delta %.2f std %.2f\n", peer->fppl.mean,
+           linkdiag_std(&peer->fppl), peer->delta.mean, linkdiag_std(&peer->delta));
+    TEST_ASSERT(fabsf(peer->fppl.mean + 85.0f) < 1.2f, "fppl %f", peer->fppl.mean);
+    TEST_ASSERT(fabsf(linkdiag_std(&peer->fppl) - 2.0f) < 1.5f, "std %f", linkdiag_std(&peer->fppl));
+    TEST_ASSERT(fabsf(peer->delta.mean - 4.0f) < 0.3f, "delta %f", peer->delta.mean);
+    TEST_ASSERT(fabsf(linkdiag_std(&peer->delta) - 0.5f) < 0.2f, "std %f", linkdiag_std(&peer->delta));
+
+    linkdiag_free(&ld);
+}
@@ -0,0 +1,91 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "linkdiag_test.h"
+
+#define NPROBE (5)
+
+TEST_CASE(linkdiag_table_test)
+{
+    struct linkdiag_instance ld;
+    struct linkdiag_test_frame frame = {
+        .fppl = -80.0f, .rssi = -76.0f, .noise = 40.0f, .pacc = 1000.0f, .ppm = NAN
+    };
+    uint16_t addr[NPROBE], a, slot = 0;
+    uint32_t n = 0, i, j, tracked;
+
+    linkdiag_test_setup(&ld);
+
+    /* Address 0 is never tracked */
+    TEST_ASSERT(linkdiag_get_peer(&ld, 0) == NULL);
+    frame.addr = 0;
+    linkdiag_test_replay(&ld, &frame, n++);
+#if MYNEWT_VAL(LINKDIAG_STATS)
+    TEST_ASSERT(ld.stat.frames == 0);
+#endif
+
+    /* Addresses hashing to the same entry fill its probe window */
+    for (a = 1, i = 0; i < NPROBE; a++) {
+        if (i == 0) {
+            slot = linkdiag_test_slot(a);
+        }
+        if (linkdiag_test_slot(a) == slot) {
+            addr[i++] = a;
+        }
+    }
+    for (i = 0; i < NPROBE - 1; i++) {
+        frame.addr = addr[i];
+        linkdiag_test_replay(&ld, &frame, n++);
+    }
+    for (i = 0; i < NPROBE - 1; i++) {
+        TEST_ASSERT(linkdiag_test_find(&ld, addr[i]) != NULL, "addr %x", addr[i]);
+    }
+
+    /* The least recently heard one makes room */
+    frame.addr = addr[0];
+    linkdiag_test_replay(&ld, &frame, n++);
+    frame.addr = addr[NPROBE - 1];
+    linkdiag_test_replay(&ld, &frame, n++);
+    TEST_ASSERT(linkdiag_test_find(&ld, addr[1]) == NULL);
+    TEST_ASSERT(linkdiag_test_find(&ld, addr[0])->frames == 2);
+    TEST_ASSERT(linkdiag_test_find(&ld, addr[NPROBE - 1])->frames == 1);
+#if MYNEWT_VAL(LINKDIAG_STATS)
+    TEST_ASSERT(ld.stat.evicted == 1);
+#endif
+
+    /* Many more peers than entries, no duplicates and the last one heard is kept */
+    linkdiag_reset(&ld);
+    for (a = 0x4000; a < 0x4000 + 8 * MYNEWT_VAL(LINKDIAG_MAX_PEERS); a++) {
+        frame.addr = a;
+        linkdiag_test_replay(&ld, &frame, n++);
+        TEST_ASSERT(linkdiag_test_find(&ld, a) != NULL);
+    }
+    tracked = 0;
+    for (i = 0; i < MYNEWT_VAL(LINKDIAG_MAX_PEERS); i++) {
+        if (!ld.peers[i].addr) {
+            continue;
+        }
+        tracked++;
+        for (j = i + 1; j < MYNEWT_VAL(LINKDIAG_MAX_PEERS); j++) {
+            TEST_ASSERT(ld.peers[i].addr != ld.peers[j].addr);
+        }
+    }
+    TEST_ASSERT(tracked > MYNEWT_VAL(LINKDIAG_MAX_PEERS) / 2, "tracked %lu", (unsigned long)tracked);
+
+    linkdiag_free(&ld);
+}
@@ -67,6 +67,9 @@ typedef union {
 typedef struct _nmgr_uwb_instance_t {
     struct uwb_dev* dev_inst;
     uint8_t frame_seq_num;
+    uint8_t ack_seq_num;            //!< Sequence number of the frame awaiting acknowledgement
+    uint8_t ack_pending:1;          //!< Waiting for a hardware acknowledgement
+    uint8_t acked:1;                //!< Acknowledgement received
     struct dpl_sem sem;
     struct os_mqueue tx_q;
 } nmgr_uwb_instance_t;
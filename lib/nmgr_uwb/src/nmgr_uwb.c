@@ -60,6 +60,7 @@ struct nmgr_uwb_usr_hdr{
 static bool rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
 static bool tx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
 static bool rx_timeout_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static bool rx_error_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
 static int nmgr_resp_cb(struct nmgr_transport *nt, struct os_mbuf *m);
 
 static struct nmgr_transport uwb_transport_0;
@@ -88,6 +89,7 @@ static struct uwb_mac_interface g_cbs[] = {
             .rx_complete_cb = rx_complete_cb,
             .tx_complete_cb = tx_complete_cb,
             .rx_timeout_cb = rx_timeout_cb,
+            .rx_error_cb = rx_error_cb,
         },
 #if MYNEWT_VAL(UWB_DEVICE_1)
         [1] = {
@@ -95,6 +97,7 @@ static struct uwb_mac_interface g_cbs[] = {
             .rx_complete_cb = rx_complete_cb,
             .tx_complete_cb = tx_complete_cb,
             .rx_timeout_cb = rx_timeout_cb,
+            .rx_error_cb = rx_error_cb,
         },
 #endif
 #if MYNEWT_VAL(UWB_DEVICE_2)
@@ -103,6 +106,7 @@ static struct uwb_mac_interface g_cbs[] = {
             .rx_complete_cb = rx_complete_cb,
             .tx_complete_cb = tx_complete_cb,
             .rx_timeout_cb = rx_timeout_cb,
+            .rx_error_cb = rx_error_cb,
         }
 #endif
 };
@@ -206,6 +210,27 @@ rx_timeout_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
     return false;
 }
 
+/**
+ * API for receive error callback. A corrupted acknowledgement is taken as
+ * lost so the frame is resent.
+ *
+ * @param inst  Pointer to struct uwb_dev.
+ *
+ * @return true on sucess
+ */
+static bool
+rx_error_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    nmgr_uwb_instance_t * nmgruwb = (nmgr_uwb_instance_t *)cbs->inst_ptr;
+    if(!nmgruwb->ack_pending) {
+        return false;
+    }
+    if(dpl_sem_get_count(&nmgruwb->sem) == 0){
+        dpl_sem_release(&nmgruwb->sem);
+    }
+    return true;
+}
+
 /** 
  * API for forming mngr response data
  *
@@ -262,12 +287,32 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
     static uint16_t last_rpt_src=0;
     static uint8_t last_rpt_seq_num=0;
 
-    if(inst->fctrl != NMGR_UWB_FCTRL) {
+#if MYNEWT_VAL(NMGR_UWB_AUTOACK)
+    if(nmgruwb->ack_pending && (inst->fctrl & FCNTL_IEEE_FTYPE_MASK) == FCNTL_IEEE_ACK) {
+        ieee_ack_frame_t * ack = (ieee_ack_frame_t *)inst->rxbuf;
+        if (ack->seq_num != nmgruwb->ack_seq_num) {
+            goto early_ret;
+        }
+        nmgruwb->acked = 1;
+        ret = true;
         goto early_ret;
     }
+#endif
 
     nmgr_uwb_frame_header_t *frame = (nmgr_uwb_frame_header_t*)inst->rxbuf;
 
+    if(inst->fctrl != NMGR_UWB_FCTRL) {
+#if MYNEWT_VAL(NMGR_UWB_AUTOACK)
+        /* Acknowledged frames are plain data frames, tell them apart by code */
+        if (inst->fctrl != FCNTL_IEEE_DATA_ACK_16 ||
+            (frame->code != NMGR_CMD_STATE_SEND && frame->code != NMGR_CMD_STATE_RSP)) {
+            goto early_ret;
+        }
+#else
+        goto early_ret;
+#endif
+    }
+
     /* If this packet should be repeated, repeat it (unless already repeated) */
     if (frame->rpt_count < frame->rpt_max &&
         frame->dst_address != inst->my_short_address &&
@@ -329,6 +374,10 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
     }
 
 early_ret:
+    /* Only the acknowledgement, an error or the timeout end an ack wait */
+    if(nmgruwb->ack_pending && !nmgruwb->acked) {
+        return ret;
+    }
     /* TODO: Check and reduce slot timeout */
     if(dpl_sem_get_count(&nmgruwb->sem) == 0) {
         dpl_sem_release(&nmgruwb->sem);
@@ -348,6 +397,10 @@ static bool
 tx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
 {
     nmgr_uwb_instance_t * nmgruwb = (nmgr_uwb_instance_t *)cbs->inst_ptr;
+    if(nmgruwb->ack_pending) {
+        /* Completed by the acknowledgement or its timeout */
+        return false;
+    }
     if(dpl_sem_get_count(&nmgruwb->sem) == 0) {
         dpl_sem_release(&nmgruwb->sem);
         return true;
@@ -404,8 +457,18 @@ nmgr_uwb_tx(struct _nmgr_uwb_instance_t *nmgruwb, uint16_t dst_addr, uint16_t co
     uint8_t buf[32];
     int mbuf_offset = 0;
     int device_offset;
+    bool ack_req = false;
+    uint16_t retries = MYNEWT_VAL(NMGR_UWB_ACK_RETRIES);
+    dpl_time_t ack_wait = OS_TIMEOUT_NEVER;
+    uint32_t ack_timeout;
     dpl_sem_pend(&nmgruwb->sem, OS_TIMEOUT_NEVER);
 
+#if MYNEWT_VAL(NMGR_UWB_AUTOACK)
+    /* The receiving transceiver acknowledges unicast frames, this device
+     * has to run auto-ACK too for the acknowledgement to pass its filter */
+    ack_req = inst->config.autoack_enabled && dst_addr != UWB_BROADCAST_ADDRESS;
+#endif
+
     /* Prepare header and write to device */
     uwb_hdr.src_address = inst->uid;
     uwb_hdr.code = code;
@@ -417,6 +480,12 @@ nmgr_uwb_tx(struct _nmgr_uwb_instance_t *nmgruwb, uint16_t dst_addr, uint16_t co
 
     /* TODO:BELOW IS UGLY, change to use code as identifier instead */
     uwb_hdr.fctrl = NMGR_UWB_FCTRL;
+    if (ack_req) {
+        /* Acknowledged frames must be filterable data frames, address
+         * filtering also leaves nothing for repeaters to hear */
+        uwb_hdr.fctrl = FCNTL_IEEE_DATA_ACK_16;
+        uwb_hdr.rpt_max = 0;
+    }
 
     /* If fx_time provided, delay until then with tx */
     if (dx_time) {
@@ -442,12 +511,34 @@ nmgr_uwb_tx(struct _nmgr_uwb_instance_t *nmgruwb, uint16_t dst_addr, uint16_t co
 
     uwb_write_tx_fctrl(inst, sizeof(nmgr_uwb_frame_header_t) + OS_MBUF_PKTLEN(m), 0);
 
-    if(uwb_start_tx(inst).start_tx_error){
-        dpl_sem_release(&nmgruwb->sem);
-        printf("UWB NMGR_tx: Tx Error \n");
+    nmgruwb->ack_seq_num = uwb_hdr.seq_num;
+    nmgruwb->acked = 0;
+    nmgruwb->ack_pending = ack_req;
+    if (ack_req) {
+        ack_timeout = uwb_phy_frame_duration(inst, sizeof(ieee_ack_frame_t) + 2)
+                      + MYNEWT_VAL(NMGR_UWB_ACK_TIMEOUT);
+        /* Bound the wait should no interrupt end it, a millisecond over the frame and its ack */
+        ack_wait = dpl_time_ms_to_ticks32((uwb_phy_frame_duration(inst, device_offset) + ack_timeout) / 1000 + 2);
     }
+    do {
+        /* The frame stays in the transmit buffer, a resend only restarts tx */
+        if (ack_req) {
+            uwb_set_wait4resp(inst, true);
+            uwb_set_rx_timeout(inst, ack_timeout);
+        }
+        if(uwb_start_tx(inst).start_tx_error){
+            nmgruwb->ack_pending = 0;
+            dpl_sem_release(&nmgruwb->sem);
+            printf("UWB NMGR_tx: Tx Error \n");
+        }
+
+        if (dpl_sem_pend(&nmgruwb->sem, ack_wait) == DPL_TIMEOUT) {
+            /* Nothing ended the wait, e.g. the receiver stopped on another frame, take the ack as lost */
+            uwb_phy_forcetrxoff(inst);
+        }
+    } while (nmgruwb->ack_pending && !nmgruwb->acked && retries--);
+    nmgruwb->ack_pending = 0;
 
-    dpl_sem_pend(&nmgruwb->sem, OS_TIMEOUT_NEVER);
     if(dpl_sem_get_count(&nmgruwb->sem) == 0) {
         dpl_sem_release(&nmgruwb->sem);
     }
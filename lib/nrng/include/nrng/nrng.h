@@ -146,6 +146,9 @@ struct uwb_dev_status nrng_config(struct nrng_instance * nrng, struct uwb_rng_co
 struct uwb_rng_config * nrng_get_config(struct nrng_instance * nrng, uwb_rng_modes_t code);
 struct uwb_dev_status nrng_listen(struct nrng_instance * nrng, uwb_dev_modes_t mode);
 uint32_t nrng_get_ranges(struct nrng_instance * nrng, float ranges[], uint16_t nranges, uint16_t base);
+#if MYNEWT_VAL(UWB_RNG_ENABLED) && MYNEWT_VAL(RNG_QUALITY)
+uint32_t nrng_get_quality(struct nrng_instance * nrng, struct uwb_rng_quality quality[], uint16_t nranges, uint16_t base);
+#endif
 uint32_t usecs_to_response(struct uwb_dev * inst, uint16_t nslots, struct uwb_rng_config * config, uint32_t duration);
 
 void nrng_append_config(struct nrng_instance * nrng, struct rng_config_list *cfgs);
@@ -21,6 +21,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
+#include <math.h>
 #include <os/os.h>
 #include <hal/hal_spi.h>
 #include <hal/hal_gpio.h>
@@ -182,17 +183,16 @@ nrng_set_frames(struct nrng_instance * nrng, uint16_t nframes)
 }
 
 /**
- * API to configure dw1000 to start transmission after certain delay.
+ * Slots of the last request that responded with a final frame.
  *
- * @param inst          Pointer to struct nrng_instance. 
- * @param ranges        []] to return results  
- * @param nranges       side of  ranges[]
- * @param code          base address of curcular buffer
+ * @param nrng          Pointer to struct nrng_instance.
+ * @param nranges       Number of slots requested.
+ * @param base          Base address of circular buffer.
  *
  * @return valid mask
  */
-uint32_t
-nrng_get_ranges(struct nrng_instance * nrng, float ranges[], uint16_t nranges, uint16_t base)
+static uint32_t
+nrng_valid_mask(struct nrng_instance * nrng, uint16_t nranges, uint16_t base)
 {
     uint32_t mask = 0;
 
@@ -208,6 +208,24 @@ nrng_get_ranges(struct nrng_instance * nrng, float ranges[], uint16_t nranges, u
             }
         }
     }
+    return mask;
+}
+
+/**
+ * API to configure dw1000 to start transmission after certain delay.
+ *
+ * @param inst          Pointer to struct nrng_instance. 
+ * @param ranges        []] to return results  
+ * @param nranges       side of  ranges[]
+ * @param code          base address of curcular buffer
+ *
+ * @return valid mask
+ */
+uint32_t
+nrng_get_ranges(struct nrng_instance * nrng, float ranges[], uint16_t nranges, uint16_t base)
+{
+    uint32_t mask = nrng_valid_mask(nrng, nranges, base);
+
     // Construct output vector 
     uint16_t j = 0;
     for (uint16_t i=0; i < nranges; i++){
@@ -220,6 +238,43 @@ nrng_get_ranges(struct nrng_instance * nrng, float ranges[], uint16_t nranges, u
     return mask;
 }
 
+#if MYNEWT_VAL(RNG_QUALITY)
+/**
+ * API to get the quality of the ranges returned by nrng_get_ranges, in the same order,
+ * from the diagnostics stored with each response.
+ *
+ * @param nrng          Pointer to struct nrng_instance.
+ * @param quality       [] to return results
+ * @param nranges       Number of slots requested.
+ * @param base          Base address of circular buffer.
+ *
+ * @return valid mask
+ */
+uint32_t
+nrng_get_quality(struct nrng_instance * nrng, struct uwb_rng_quality quality[], uint16_t nranges, uint16_t base)
+{
+    struct uwb_dev * inst = nrng->dev_inst;
+    uint32_t mask = nrng_valid_mask(nrng, nranges, base);
+
+    uint16_t j = 0;
+    for (uint16_t i=0; i < nranges; i++){
+        if (mask & 1UL << i){
+            uint16_t idx = BitIndex(nrng->slot_mask, 1UL << i, SLOT_POSITION); 
+            nrng_frame_t * frame = nrng->frames[(base + idx)%nrng->nframes];
+            // Single sided responses, no turnaround clock offset to compare against
+            quality[j] = (struct uwb_rng_quality){
+                .skew = NAN,
+                .residual = NAN
+            };
+            uwb_rng_quality_calc(inst, (inst->config.rxdiag_enable && frame->diag.rxd_len) ? &frame->diag : NULL,
+                                 &quality[j]);
+            j++;
+        }
+    }
+    return mask;
+}
+#endif
+
 /**
  * @fn nrng_get_config(struct nrng_instance * nrng, uwb_rng_modes_t code)
  * @brief API to get configuration using uwb_rng_modes_t.
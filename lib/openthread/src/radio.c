@@ -97,7 +97,7 @@ void otPlatRadioSetShortAddress(otInstance *aInstance, uint16_t aAddress){
 #if MYNEWT_VAL(OT_DEBUG)
 	printf("# %s #\n",__func__);
 #endif
-    g_ot_inst->dev_inst->my_short_address = aAddress;
+    uwb_set_uid(g_ot_inst->dev_inst, aAddress);
     (void)aInstance;
 }
 
@@ -0,0 +1,139 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file peer_sched.h
+ * @brief Fair multi-peer ranging session scheduler
+ *
+ * @details A tag registers the anchors it ranges with, each with a desired
+ * rate and a priority, and lets the scheduler pick the peer of every
+ * exchange instead of rotating through them itself. A peer is due when its
+ * deadline has passed; among due peers the highest priority is served and,
+ * within a priority, the earliest deadline, so peers of equal priority share
+ * the available exchanges in proportion to their rates when there are not
+ * enough for all. A peer that fails to range is backed off exponentially,
+ * starting at its period, and recovers on its first successful range.
+ *
+ * In a tdma slot callback peer_sched_slot() fits up to
+ * PEER_SCHED_SLOT_EXCHANGES exchanges into the slot; without tdma
+ * peer_sched_request() ranges immediately with the next due peer.
+ */
+
+#ifndef _PEER_SCHED_H_
+#define _PEER_SCHED_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stats/stats.h>
+#include <dpl/dpl.h>
+#include <uwb/uwb.h>
+#include <uwb_rng/uwb_rng.h>
+#include <tdma/tdma.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if MYNEWT_VAL(PEER_SCHED_STATS)
+STATS_SECT_START(peer_sched_stat_section)
+    STATS_SECT_ENTRY(requests)
+    STATS_SECT_ENTRY(ranges)
+    STATS_SECT_ENTRY(failures)
+    STATS_SECT_ENTRY(failing)
+    STATS_SECT_ENTRY(recovered)
+    STATS_SECT_ENTRY(idle)
+    STATS_SECT_ENTRY(start_tx_error)
+STATS_SECT_END
+#define PEER_SCHED_STATS_INC(__X) STATS_INC(ps->stat, __X)
+#else
+#define PEER_SCHED_STATS_INC(__X) {}
+#endif
+
+//! Registered peer
+struct peer_sched_peer{
+    uint16_t addr;                   //!< Short address, 0 when unused
+    uint16_t code;                   //!< Ranging profile, uwb_rng_modes_t
+    uint8_t priority;                //!< Served first among due peers when higher
+    uint8_t failures;                //!< Consecutive exchanges without a range
+    uint32_t period;                 //!< Desired interval, cputime ticks
+    uint32_t deadline;               //!< Cputime the next exchange is due
+    uint32_t backoff;                //!< Current backoff, cputime ticks, 0 if healthy
+    uint32_t requests;               //!< Exchanges started
+    uint32_t ranges;                 //!< Exchanges completed with a range
+    uint32_t win_ranges;             //!< Ranges since the last report
+    uint32_t win_latency_sum;        //!< Request to range, usec, since the last report
+    uint32_t win_latency_max;        //!< Longest request to range, usec
+    uint32_t win_lateness_sum;       //!< Deadline to request, usec, since the last report
+};
+
+//! Achieved service of one peer
+struct peer_sched_report{
+    uint16_t addr;                   //!< Short address
+    uint8_t failures;                //!< Consecutive exchanges without a range
+    bool failing;                    //!< At least PEER_SCHED_FAIL_THRESH failures
+    float rate;                      //!< Ranges per second since the last report
+    float target;                    //!< Desired ranges per second
+    uint32_t latency_mean;           //!< Request to range, usec
+    uint32_t latency_max;            //!< Longest request to range, usec
+    uint32_t lateness_mean;          //!< Deadline to request, usec
+    uint32_t backoff;                //!< Current backoff, usec
+    uint32_t requests;               //!< Exchanges started
+    uint32_t ranges;                 //!< Exchanges completed with a range
+};
+
+//! Scheduler status
+typedef struct _peer_sched_status_t{
+    uint16_t selfmalloc:1;           //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;          //!< Instance allocated
+    uint16_t ranged:1;               //!< Exchange in flight completed with a range
+}peer_sched_status_t;
+
+//! Scheduler instance
+struct peer_sched_instance{
+    struct uwb_rng_instance * rng;              //!< Ranging instance
+#if MYNEWT_VAL(PEER_SCHED_STATS)
+    STATS_SECT_DECL(peer_sched_stat_section) stat; //!< Stats instance
+#endif
+    peer_sched_status_t status;                 //!< Status
+    struct uwb_mac_interface cbs;               //!< MAC layer callbacks
+    struct dpl_mutex mutex;                     //!< Guards the peer table
+    int16_t current;                            //!< Peer of the exchange in flight, -1 if none
+    uint16_t exchanges;                         //!< Exchanges per tdma slot
+    uint32_t window_start;                      //!< Cputime of the last report reset
+    struct peer_sched_peer peers[MYNEWT_VAL(PEER_SCHED_MAX_PEERS)]; //!< Peers
+};
+
+struct peer_sched_instance * peer_sched_init(struct peer_sched_instance * ps, struct uwb_rng_instance * rng);
+void peer_sched_free(struct peer_sched_instance * ps);
+struct peer_sched_instance * peer_sched_get_instance(void);
+int peer_sched_add(struct peer_sched_instance * ps, uint16_t addr, float rate, uint8_t priority, uwb_rng_modes_t code);
+int peer_sched_remove(struct peer_sched_instance * ps, uint16_t addr);
+void peer_sched_set_exchanges(struct peer_sched_instance * ps, uint16_t exchanges);
+int peer_sched_next(struct peer_sched_instance * ps);
+int peer_sched_request(struct peer_sched_instance * ps);
+int peer_sched_slot(struct peer_sched_instance * ps, tdma_instance_t * tdma, uint16_t idx);
+int peer_sched_get_report(struct peer_sched_instance * ps, int peer, struct peer_sched_report * report);
+void peer_sched_reset_window(struct peer_sched_instance * ps);
+int peer_sched_cli_register(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PEER_SCHED_H_ */
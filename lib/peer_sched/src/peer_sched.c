@@ -0,0 +1,567 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file peer_sched.c
+ * @brief Fair multi-peer ranging session scheduler
+ *
+ * @details Times are cputime ticks compared through their signed difference,
+ * so they survive the wrap of the 32 bit counter. An exchange is started
+ * outside the peer table lock, uwb_rng_request blocks until it completes,
+ * and its outcome is taken from the mac completion seen while it was in
+ * flight. A late start of a delayed exchange is the slot's fault, not the
+ * peer's, and leaves the peer due.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <os/os.h>
+#include <sysinit/sysinit.h>
+#include <stats/stats.h>
+#include <uwb/uwb_ftypes.h>
+#include <uwb/uwb_mac.h>
+#include <peer_sched/peer_sched.h>
+
+#if MYNEWT_VAL(PEER_SCHED_STATS)
+STATS_NAME_START(peer_sched_stat_section)
+    STATS_NAME(peer_sched_stat_section, requests)
+    STATS_NAME(peer_sched_stat_section, ranges)
+    STATS_NAME(peer_sched_stat_section, failures)
+    STATS_NAME(peer_sched_stat_section, failing)
+    STATS_NAME(peer_sched_stat_section, recovered)
+    STATS_NAME(peer_sched_stat_section, idle)
+    STATS_NAME(peer_sched_stat_section, start_tx_error)
+STATS_NAME_END(peer_sched_stat_section)
+#endif
+
+static struct peer_sched_instance * g_peer_sched = NULL;
+
+static bool complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+
+/**
+ * @fn peer_sched_init(struct peer_sched_instance * ps, struct uwb_rng_instance * rng)
+ * @brief Allocate and initialise a scheduler ranging through rng.
+ *
+ * @param ps    Pointer to struct peer_sched_instance, NULL to allocate.
+ * @param rng   Pointer to struct uwb_rng_instance.
+ *
+ * @return struct peer_sched_instance *
+ */
+struct peer_sched_instance *
+peer_sched_init(struct peer_sched_instance * ps, struct uwb_rng_instance * rng)
+{
+    assert(rng);
+
+    if (ps == NULL) {
+        ps = (struct peer_sched_instance *) malloc(sizeof(struct peer_sched_instance));
+        assert(ps);
+        memset(ps, 0, sizeof(struct peer_sched_instance));
+        ps->status.selfmalloc = 1;
+    }
+    if (!ps->status.initialized) {
+        dpl_error_t err = dpl_mutex_init(&ps->mutex);
+        assert(err == DPL_OK);
+#if MYNEWT_VAL(PEER_SCHED_STATS)
+        int rc = stats_init(
+                    STATS_HDR(ps->stat),
+                    STATS_SIZE_INIT_PARMS(ps->stat, STATS_SIZE_32),
+                    STATS_NAME_INIT_PARMS(peer_sched_stat_section)
+            );
+        rc |= stats_register("peer_sched", STATS_HDR(ps->stat));
+        assert(rc == 0);
+#endif
+        ps->rng = rng;
+        ps->current = -1;
+        ps->exchanges = MYNEWT_VAL(PEER_SCHED_SLOT_EXCHANGES);
+        ps->window_start = os_cputime_get32();
+        ps->cbs = (struct uwb_mac_interface){
+            .id = UWBEXT_PEER_SCHED,
+            .inst_ptr = (void *) ps,
+            .complete_cb = complete_cb
+        };
+        uwb_mac_append_interface(rng->dev_inst, &ps->cbs);
+    }
+    ps->status.initialized = 1;
+    g_peer_sched = ps;
+    return ps;
+}
+
+/**
+ * @fn peer_sched_free(struct peer_sched_instance * ps)
+ * @brief Remove the mac interface and free the instance.
+ *
+ * @param ps    Pointer to struct peer_sched_instance.
+ *
+ * @return void
+ */
+void
+peer_sched_free(struct peer_sched_instance * ps)
+{
+    assert(ps);
+    uwb_mac_remove_interface(ps->rng->dev_inst, ps->cbs.id);
+    if (g_peer_sched == ps) {
+        g_peer_sched = NULL;
+    }
+    if (ps->status.selfmalloc) {
+        free(ps);
+    } else {
+        ps->status.initialized = 0;
+    }
+}
+
+/**
+ * @fn peer_sched_get_instance(void)
+ * @brief Instance created by the last peer_sched_init.
+ *
+ * @return struct peer_sched_instance *
+ */
+struct peer_sched_instance *
+peer_sched_get_instance(void)
+{
+    return g_peer_sched;
+}
+
+static int
+peer_find(struct peer_sched_instance * ps, uint16_t addr)
+{
+    for (int i = 0; i < MYNEWT_VAL(PEER_SCHED_MAX_PEERS); i++) {
+        if (ps->peers[i].addr == addr) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @fn peer_sched_add(struct peer_sched_instance * ps, uint16_t addr, float rate, uint8_t priority, uwb_rng_modes_t code)
+ * @brief Register a peer, or change the rate, priority and profile of a
+ * registered one. A new peer is due at once.
+ *
+ * @param ps        Pointer to struct peer_sched_instance.
+ * @param addr      Short address of the peer.
+ * @param rate      Desired ranges per second.
+ * @param priority  Higher is served first among due peers.
+ * @param code      Ranging profile, e.g. DWT_DS_TWR.
+ *
+ * @return OS_OK, OS_EINVAL for a bad address or rate, OS_ENOMEM if the table is full
+ */
+int
+peer_sched_add(struct peer_sched_instance * ps, uint16_t addr, float rate, uint8_t priority, uwb_rng_modes_t code)
+{
+    struct peer_sched_peer * p;
+    int i;
+
+    if (addr == 0 || addr == UWB_BROADCAST_ADDRESS || !(rate > 0)) {
+        return OS_EINVAL;
+    }
+    dpl_mutex_pend(&ps->mutex, DPL_TIMEOUT_NEVER);
+    i = peer_find(ps, addr);
+    if (i < 0) {
+        i = peer_find(ps, 0);
+        if (i < 0) {
+            dpl_mutex_release(&ps->mutex);
+            return OS_ENOMEM;
+        }
+        p = &ps->peers[i];
+        memset(p, 0, sizeof(*p));
+        p->addr = addr;
+        p->deadline = os_cputime_get32();
+    }
+    p = &ps->peers[i];
+    p->code = code;
+    p->priority = priority;
+    p->period = os_cputime_usecs_to_ticks((uint32_t)(1000000.0f / rate));
+    if (p->period == 0) {
+        p->period = 1;
+    }
+    dpl_mutex_release(&ps->mutex);
+    return OS_OK;
+}
+
+/**
+ * @fn peer_sched_remove(struct peer_sched_instance * ps, uint16_t addr)
+ * @brief Unregister a peer. An exchange with it in flight completes but is
+ * not accounted.
+ *
+ * @param ps    Pointer to struct peer_sched_instance.
+ * @param addr  Short address of the peer.
+ *
+ * @return OS_OK, OS_ENOENT if the peer is not registered
+ */
+int
+peer_sched_remove(struct peer_sched_instance * ps, uint16_t addr)
+{
+    int i;
+
+    if (addr == 0) {
+        return OS_ENOENT;
+    }
+    dpl_mutex_pend(&ps->mutex, DPL_TIMEOUT_NEVER);
+    i = peer_find(ps, addr);
+    if (i >= 0) {
+        ps->peers[i].addr = 0;
+    }
+    dpl_mutex_release(&ps->mutex);
+    return (i < 0) ? OS_ENOENT : OS_OK;
+}
+
+/**
+ * @fn peer_sched_set_exchanges(struct peer_sched_instance * ps, uint16_t exchanges)
+ * @brief Exchanges fitted into one tdma slot by peer_sched_slot(). The slot
+ * is split evenly, each part must hold a whole exchange of the profiles used.
+ *
+ * @param ps         Pointer to struct peer_sched_instance.
+ * @param exchanges  Exchanges per slot, at least 1.
+ *
+ * @return void
+ */
+void
+peer_sched_set_exchanges(struct peer_sched_instance * ps, uint16_t exchanges)
+{
+    ps->exchanges = (exchanges) ? exchanges : 1;
+}
+
+/*
+ * When the demand exceeds the exchanges available the due peers fall behind
+ * together. Their deadlines are moved forward together once the oldest is
+ * PEER_SCHED_MAX_LAG behind, which keeps the order and with it the share of
+ * each peer, but bounds the burst that follows when capacity returns. A peer
+ * less late than the shift stays due rather than being moved into the future.
+ */
+static void
+peer_bound_lag(struct peer_sched_instance * ps, uint32_t now)
+{
+    uint32_t max_lag = os_cputime_usecs_to_ticks(MYNEWT_VAL(PEER_SCHED_MAX_LAG) * 1000UL);
+    struct peer_sched_peer * p;
+    uint32_t oldest = now, shift;
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(PEER_SCHED_MAX_PEERS); i++) {
+        p = &ps->peers[i];
+        if (p->addr && (int32_t)(p->deadline - oldest) < 0) {
+            oldest = p->deadline;
+        }
+    }
+    if (now - oldest <= max_lag) {
+        return;
+    }
+    shift = now - oldest - max_lag;
+    for (i = 0; i < MYNEWT_VAL(PEER_SCHED_MAX_PEERS); i++) {
+        p = &ps->peers[i];
+        if (p->addr && (int32_t)(p->deadline - now) <= 0) {
+            p->deadline += shift;
+            if ((int32_t)(p->deadline - now) > 0) {
+                p->deadline = now;
+            }
+        }
+    }
+}
+
+static int
+peer_next(struct peer_sched_instance * ps, uint32_t now)
+{
+    struct peer_sched_peer * p, * best = NULL;
+    int i, b = -1;
+
+    peer_bound_lag(ps, now);
+    for (i = 0; i < MYNEWT_VAL(PEER_SCHED_MAX_PEERS); i++) {
+        p = &ps->peers[i];
+        if (p->addr == 0 || (int32_t)(p->deadline - now) > 0) {
+            continue;
+        }
+        if (best == NULL || p->priority > best->priority ||
+            (p->priority == best->priority && (int32_t)(p->deadline - best->deadline) < 0)) {
+            best = p;
+            b = i;
+        }
+    }
+    return b;
+}
+
+/**
+ * @fn peer_sched_next(struct peer_sched_instance * ps)
+ * @brief The peer to range with now: the highest priority due peer, earliest
+ * deadline first within a priority.
+ *
+ * @param ps    Pointer to struct peer_sched_instance.
+ *
+ * @return Peer index, -1 if no peer is due
+ */
+int
+peer_sched_next(struct peer_sched_instance * ps)
+{
+    int i;
+
+    dpl_mutex_pend(&ps->mutex, DPL_TIMEOUT_NEVER);
+    i = peer_next(ps, os_cputime_get32());
+    dpl_mutex_release(&ps->mutex);
+    return i;
+}
+
+/* Advance the peer past an exchange started at start and finished at end, retry is the peer's retry-after in ticks */
+static void
+peer_outcome(struct peer_sched_instance * ps, int i, uint16_t addr, bool ranged, uint32_t start, uint32_t end, uint32_t retry)
+{
+    struct peer_sched_peer * p = &ps->peers[i];
+    uint32_t backoff_max = os_cputime_usecs_to_ticks(MYNEWT_VAL(PEER_SCHED_BACKOFF_MAX) * 1000UL);
+
+    dpl_mutex_pend(&ps->mutex, DPL_TIMEOUT_NEVER);
+    if (p->addr != addr) {
+        /* Removed while in flight */
+        dpl_mutex_release(&ps->mutex);
+        return;
+    }
+    if (ranged) {
+        uint32_t latency = os_cputime_ticks_to_usecs(end - start);
+        PEER_SCHED_STATS_INC(ranges);
+        if (p->failures >= MYNEWT_VAL(PEER_SCHED_FAIL_THRESH)) {
+            PEER_SCHED_STATS_INC(recovered);
+        }
+        p->ranges++;
+        p->win_ranges++;
+        p->win_latency_sum += latency;
+        if (latency > p->win_latency_max) {
+            p->win_latency_max = latency;
+        }
+        if ((int32_t)(start - p->deadline) > 0) {
+            p->win_lateness_sum += os_cputime_ticks_to_usecs(start - p->deadline);
+        }
+        p->failures = 0;
+        p->backoff = 0;
+        p->deadline += p->period;
+    } else {
+        PEER_SCHED_STATS_INC(failures);
+        if (p->failures < UINT8_MAX) {
+            p->failures++;
+        }
+        if (p->failures == MYNEWT_VAL(PEER_SCHED_FAIL_THRESH)) {
+            PEER_SCHED_STATS_INC(failing);
+        }
+        p->backoff = (p->backoff) ? 2 * p->backoff : p->period;
+        if (p->backoff > backoff_max) {
+            p->backoff = backoff_max;
+        }
+        p->deadline = end + ((retry > p->backoff) ? retry : p->backoff);
+    }
+    dpl_mutex_release(&ps->mutex);
+}
+
+/* Range with peer i, immediately or at dx_time, and account the outcome */
+static int
+peer_exchange(struct peer_sched_instance * ps, int i, bool delayed, uint64_t dx_time)
+{
+    struct uwb_dev_status status;
+    uint16_t addr, code;
+    uint32_t start;
+
+    dpl_mutex_pend(&ps->mutex, DPL_TIMEOUT_NEVER);
+    addr = ps->peers[i].addr;
+    code = ps->peers[i].code;
+    ps->peers[i].requests++;
+    dpl_mutex_release(&ps->mutex);
+
+    PEER_SCHED_STATS_INC(requests);
+    ps->status.ranged = 0;
+    ps->current = i;
+    start = os_cputime_get32();
+    if (delayed) {
+        status = uwb_rng_request_delay_start(ps->rng, addr, dx_time, code);
+    } else {
+        status = uwb_rng_request(ps->rng, addr, code);
+    }
+    ps->current = -1;
+    if (status.start_tx_error) {
+        PEER_SCHED_STATS_INC(start_tx_error);
+        return OS_TIMEOUT;
+    }
+    peer_outcome(ps, i, addr, ps->status.ranged, start, os_cputime_get32(),
+                 os_cputime_usecs_to_ticks(uwb_rng_retry_after(ps->rng, addr)));
+    return OS_OK;
+}
+
+/**
+ * @fn peer_sched_request(struct peer_sched_instance * ps)
+ * @brief Range now with the next due peer. Blocks until the exchange
+ * completes.
+ *
+ * @param ps    Pointer to struct peer_sched_instance.
+ *
+ * @return Peer index ranged with, -1 if no peer is due
+ */
+int
+peer_sched_request(struct peer_sched_instance * ps)
+{
+    int i = peer_sched_next(ps);
+
+    if (i < 0) {
+        PEER_SCHED_STATS_INC(idle);
+        return -1;
+    }
+    peer_exchange(ps, i, false, 0);
+    return i;
+}
+
+/**
+ * @fn peer_sched_slot(struct peer_sched_instance * ps, tdma_instance_t * tdma, uint16_t idx)
+ * @brief Called from a tdma slot callback, ranges with due peers in the slot,
+ * up to the configured exchanges per slot, each at the start of its share of
+ * the slot. Stops early when no peer is due or a start was missed.
+ *
+ * @param ps    Pointer to struct peer_sched_instance.
+ * @param tdma  Pointer to tdma_instance_t.
+ * @param idx   Slot index of the callback.
+ *
+ * @return Exchanges started
+ */
+int
+peer_sched_slot(struct peer_sched_instance * ps, tdma_instance_t * tdma, uint16_t idx)
+{
+    int n;
+
+    for (n = 0; n < ps->exchanges; n++) {
+        int i = peer_sched_next(ps);
+        if (i < 0) {
+            if (n == 0) {
+                PEER_SCHED_STATS_INC(idle);
+            }
+            break;
+        }
+        uint64_t dx_time = tdma_tx_slot_start(tdma, (float)idx + (float)n / ps->exchanges) & 0xFFFFFFFE00UL;
+        if (peer_exchange(ps, i, true, dx_time) != OS_OK) {
+            break;
+        }
+    }
+    return n;
+}
+
+/**
+ * @fn peer_sched_get_report(struct peer_sched_instance * ps, int peer, struct peer_sched_report * report)
+ * @brief Service achieved by a peer since the last peer_sched_reset_window().
+ *
+ * @param ps      Pointer to struct peer_sched_instance.
+ * @param peer    Peer index, 0 to PEER_SCHED_MAX_PEERS - 1.
+ * @param report  Report filled in.
+ *
+ * @return OS_OK, OS_ENOENT if no peer is registered at the index
+ */
+int
+peer_sched_get_report(struct peer_sched_instance * ps, int peer, struct peer_sched_report * report)
+{
+    struct peer_sched_peer * p = &ps->peers[peer];
+    uint32_t usecs;
+
+    assert(peer >= 0 && peer < MYNEWT_VAL(PEER_SCHED_MAX_PEERS));
+    dpl_mutex_pend(&ps->mutex, DPL_TIMEOUT_NEVER);
+    if (p->addr == 0) {
+        dpl_mutex_release(&ps->mutex);
+        return OS_ENOENT;
+    }
+    usecs = os_cputime_ticks_to_usecs(os_cputime_get32() - ps->window_start);
+    *report = (struct peer_sched_report){
+        .addr = p->addr,
+        .failures = p->failures,
+        .failing = p->failures >= MYNEWT_VAL(PEER_SCHED_FAIL_THRESH),
+        .rate = (usecs) ? p->win_ranges * 1e6f / usecs : 0,
+        .target = 1e6f / os_cputime_ticks_to_usecs(p->period),
+        .latency_mean = (p->win_ranges) ? p->win_latency_sum / p->win_ranges : 0,
+        .latency_max = p->win_latency_max,
+        .lateness_mean = (p->win_ranges) ? p->win_lateness_sum / p->win_ranges : 0,
+        .backoff = os_cputime_ticks_to_usecs(p->backoff),
+        .requests = p->requests,
+        .ranges = p->ranges,
+    };
+    dpl_mutex_release(&ps->mutex);
+    return OS_OK;
+}
+
+/**
+ * @fn peer_sched_reset_window(struct peer_sched_instance * ps)
+ * @brief Start a new report window for all peers.
+ *
+ * @param ps    Pointer to struct peer_sched_instance.
+ *
+ * @return void
+ */
+void
+peer_sched_reset_window(struct peer_sched_instance * ps)
+{
+    dpl_mutex_pend(&ps->mutex, DPL_TIMEOUT_NEVER);
+    for (int i = 0; i < MYNEWT_VAL(PEER_SCHED_MAX_PEERS); i++) {
+        struct peer_sched_peer * p = &ps->peers[i];
+        p->win_ranges = 0;
+        p->win_latency_sum = 0;
+        p->win_latency_max = 0;
+        p->win_lateness_sum = 0;
+    }
+    ps->window_start = os_cputime_get32();
+    dpl_mutex_release(&ps->mutex);
+}
+
+/**
+ * API for mac complete callback, notes a range with the peer in flight.
+ *
+ * @param inst  Pointer to struct uwb_dev.
+ * @param cbs   Pointer to struct uwb_mac_interface.
+ *
+ * @return false, other interfaces see the completion too
+ */
+static bool
+complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct peer_sched_instance * ps = (struct peer_sched_instance *) cbs->inst_ptr;
+    struct uwb_rng_instance * rng = ps->rng;
+    twr_frame_t * frame;
+    int16_t current = ps->current;
+
+    if (inst->fctrl != FCNTL_IEEE_RANGE_16 || current < 0) {
+        return false;
+    }
+    frame = rng->frames[rng->idx % rng->nframes];
+    switch (frame->code) {
+        case DWT_SS_TWR_FINAL:
+        case DWT_DS_TWR_FINAL:
+        case DWT_SS_TWR_EXT_FINAL:
+        case DWT_DS_TWR_EXT_FINAL:
+            break;
+        default:
+            return false;
+    }
+    if (frame->dst_address == ps->peers[current].addr) {
+        ps->status.ranged = 1;
+    }
+    return false;
+}
+
+/**
+ * @fn peer_sched_pkg_init(void)
+ * @brief API to initialise the package, only the command line; instances
+ * are created by the application once its rng instance exists.
+ *
+ * @return void
+ */
+void
+peer_sched_pkg_init(void)
+{
+#if MYNEWT_VAL(PEER_SCHED_CLI)
+    int rc = peer_sched_cli_register();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+}
@@ -0,0 +1,116 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <os/os.h>
+#include <syscfg/syscfg.h>
+
+#if MYNEWT_VAL(PEER_SCHED_CLI)
+
+#include <string.h>
+#include <stdlib.h>
+
+#include <shell/shell.h>
+#include <console/console.h>
+
+#include "peer_sched/peer_sched.h"
+
+static int peer_sched_cli_cmd(int argc, char **argv);
+
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+const struct shell_param cmd_peers_param[] = {
+    {"list", "achieved rate, latency and backoff per peer"},
+    {"add", "<addr> <rate> [<prio>] [<code>] register a peer, rate in Hz"},
+    {"del", "<addr> unregister a peer"},
+    {"reset", "start a new report window"},
+    {NULL,NULL},
+};
+
+const struct shell_cmd_help cmd_peers_help = {
+	"peers", "<cmd>", cmd_peers_param
+};
+#endif
+
+static struct shell_cmd shell_peers_cmd = {
+    .sc_cmd = "peers",
+    .sc_cmd_func = peer_sched_cli_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+    .help = &cmd_peers_help
+#endif
+};
+
+static void
+peer_sched_cli_list(struct peer_sched_instance * ps)
+{
+    struct peer_sched_report r;
+
+    console_printf("#idx, addr, prio, rate_mhz, target_mhz, lat_us, lat_max_us, late_us, fails, backoff_ms, ranges/requests\n");
+    for (int i = 0; i < MYNEWT_VAL(PEER_SCHED_MAX_PEERS); i++) {
+        if (peer_sched_get_report(ps, i, &r) != OS_OK) {
+            continue;
+        }
+        console_printf("%4d, %4x, %4d, %8lu, %10lu, %6lu, %10lu, %7lu, %5d%s, %10lu, %lu/%lu\n",
+                       i, r.addr, ps->peers[i].priority,
+                       (unsigned long)(r.rate * 1000), (unsigned long)(r.target * 1000),
+                       (unsigned long)r.latency_mean, (unsigned long)r.latency_max,
+                       (unsigned long)r.lateness_mean, r.failures, (r.failing) ? "!" : "",
+                       (unsigned long)(r.backoff / 1000), (unsigned long)r.ranges, (unsigned long)r.requests);
+    }
+}
+
+static int
+peer_sched_cli_cmd(int argc, char **argv)
+{
+    struct peer_sched_instance * ps = peer_sched_get_instance();
+    int rc;
+
+    if (argc < 2) {
+        return 0;
+    }
+    if (ps == NULL) {
+        console_printf("No peer_sched instance\n");
+        return 0;
+    }
+
+    if (!strcmp(argv[1], "list")) {
+        peer_sched_cli_list(ps);
+    } else if (!strcmp(argv[1], "add") && argc > 3) {
+        rc = peer_sched_add(ps, strtol(argv[2], NULL, 0), strtof(argv[3], NULL),
+                            (argc > 4) ? strtol(argv[4], NULL, 0) : 0,
+                            (argc > 5) ? strtol(argv[5], NULL, 0) : DWT_DS_TWR);
+        if (rc != OS_OK) {
+            console_printf("Failed\n");
+        }
+    } else if (!strcmp(argv[1], "del") && argc > 2) {
+        if (peer_sched_remove(ps, strtol(argv[2], NULL, 0)) != OS_OK) {
+            console_printf("Unknown peer\n");
+        }
+    } else if (!strcmp(argv[1], "reset")) {
+        peer_sched_reset_window(ps);
+    } else {
+        console_printf("Unknown cmd\n");
+    }
+    return 0;
+}
+
+int
+peer_sched_cli_register(void)
+{
+    return shell_cmd_register(&shell_peers_cmd);
+}
+#endif /* MYNEWT_VAL(PEER_SCHED_CLI) */
@@ -0,0 +1,134 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "peer_sched_test.h"
+
+struct peer_sched_test_radio g_peer_sched_test_radio;
+
+static struct peer_sched_instance g_ps;
+static struct uwb_dev g_dev;
+static twr_frame_t g_frame;
+static struct uwb_rng_instance * g_rng;
+
+/*
+ * The scheduler reads the cputime itself. Virtual time is moved on by
+ * moving every deadline and the report window back instead, the real time
+ * a test takes is small against the periods used.
+ */
+void
+peer_sched_test_advance(struct peer_sched_instance * ps, uint32_t usecs)
+{
+    uint32_t ticks = os_cputime_usecs_to_ticks(usecs);
+
+    for (int i = 0; i < MYNEWT_VAL(PEER_SCHED_MAX_PEERS); i++)
+        ps->peers[i].deadline -= ticks;
+    ps->window_start -= ticks;
+    g_peer_sched_test_radio.now += usecs;
+}
+
+/** Time until the peer at addr is due, usec, negative once it is late */
+int32_t
+peer_sched_test_due(struct peer_sched_instance * ps, uint16_t addr)
+{
+    for (int i = 0; i < MYNEWT_VAL(PEER_SCHED_MAX_PEERS); i++) {
+        if (ps->peers[i].addr == addr) {
+            int32_t ticks = ps->peers[i].deadline - os_cputime_get32();
+            return (ticks < 0) ? -(int32_t)os_cputime_ticks_to_usecs(-ticks) : (int32_t)os_cputime_ticks_to_usecs(ticks);
+        }
+    }
+    TEST_ASSERT(0, "%04x not registered", addr);
+    return 0;
+}
+
+/** Range for usecs of virtual time, idle in 1 ms steps. Returns the exchanges */
+int
+peer_sched_test_run(struct peer_sched_instance * ps, uint32_t usecs)
+{
+    uint32_t end = g_peer_sched_test_radio.now + usecs;
+    int n = 0;
+
+    while ((int32_t)(g_peer_sched_test_radio.now - end) < 0) {
+        if (peer_sched_request(ps) < 0)
+            peer_sched_test_advance(ps, 1000);
+        else
+            n++;
+    }
+    return n;
+}
+
+struct uwb_dev_status
+uwb_rng_request(struct uwb_rng_instance * rng, uint16_t dst_address, uwb_rng_modes_t code)
+{
+    struct peer_sched_test_radio * radio = &g_peer_sched_test_radio;
+    struct peer_sched_instance * ps = &g_ps;
+    struct uwb_dev_status status = {0};
+    uint16_t n = dst_address - PEER_SCHED_TEST_ADDR(0);
+
+    radio->requests++;
+    if (radio->tx_error) {
+        status.start_tx_error = 1;
+        return status;
+    }
+    peer_sched_test_advance(ps, radio->exchange);
+    if (n < PEER_SCHED_TEST_NPEERS && radio->up[n]) {
+        g_frame.code = (code == DWT_SS_TWR) ? DWT_SS_TWR_FINAL : DWT_DS_TWR_FINAL;
+        g_frame.dst_address = dst_address;
+        rng->dev_inst->fctrl = FCNTL_IEEE_RANGE_16;
+        ps->cbs.complete_cb(rng->dev_inst, &ps->cbs);
+    }
+    return status;
+}
+
+struct uwb_dev_status
+uwb_rng_request_delay_start(struct uwb_rng_instance * rng, uint16_t dst_address, uint64_t delay, uwb_rng_modes_t code)
+{
+    return uwb_rng_request(rng, dst_address, code);
+}
+
+uint32_t
+uwb_rng_retry_after(struct uwb_rng_instance * rng, uint16_t dst_address)
+{
+    return g_peer_sched_test_radio.retry_after;
+}
+
+/** Scheduler with no peers, exchanges of 10 ms and every peer answering */
+struct peer_sched_instance *
+peer_sched_test_setup(void)
+{
+    struct peer_sched_instance * ps = &g_ps;
+
+    if (g_rng == NULL) {
+        g_rng = (struct uwb_rng_instance *)calloc(1, sizeof(struct uwb_rng_instance) + sizeof(twr_frame_t *));
+        assert(g_rng);
+        g_rng->dev_inst = &g_dev;
+        g_rng->frames[0] = &g_frame;
+        g_rng->nframes = 1;
+    }
+    if (!ps->status.initialized)
+        peer_sched_init(ps, g_rng);
+    memset(ps->peers, 0, sizeof(ps->peers));
+    peer_sched_set_exchanges(ps, 1);
+    peer_sched_reset_window(ps);
+
+    memset(&g_peer_sched_test_radio, 0, sizeof(g_peer_sched_test_radio));
+    g_peer_sched_test_radio.exchange = 10000;
+    for (int i = 0; i < PEER_SCHED_TEST_NPEERS; i++)
+        g_peer_sched_test_radio.up[i] = true;
+    return ps;
+}
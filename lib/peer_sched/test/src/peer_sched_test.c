@@ -0,0 +1,45 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "peer_sched_test.h"
+
+TEST_CASE_DECL(peer_sched_edf_test)
+TEST_CASE_DECL(peer_sched_share_test)
+TEST_CASE_DECL(peer_sched_backoff_test)
+TEST_CASE_DECL(peer_sched_lag_test)
+
+TEST_SUITE(peer_sched_test_all)
+{
+    peer_sched_edf_test();
+    peer_sched_share_test();
+    peer_sched_backoff_test();
+    peer_sched_lag_test();
+}
+
+#if MYNEWT_VAL(SELFTEST)
+int
+main(int argc, char **argv)
+{
+    sysinit();
+
+    peer_sched_test_all();
+
+    return tu_any_failed;
+}
+#endif
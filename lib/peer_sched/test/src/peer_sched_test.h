@@ -0,0 +1,68 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _PEER_SCHED_TEST_H
+#define _PEER_SCHED_TEST_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "testutil/testutil.h"
+
+#include "uwb/uwb_mac.h"
+#include "uwb/uwb_ftypes.h"
+#include "peer_sched/peer_sched.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Address of peer n
+#define PEER_SCHED_TEST_ADDR(__n) (0x1000 + (__n))
+//! Peers the stubbed exchange knows
+#define PEER_SCHED_TEST_NPEERS (8)
+
+//! Stubbed uwb_rng_request, every exchange takes exchange usec of virtual time
+struct peer_sched_test_radio {
+    uint32_t exchange;                 //!< Duration of an exchange, usec
+    uint32_t retry_after;              //!< Returned by uwb_rng_retry_after, usec
+    bool up[PEER_SCHED_TEST_NPEERS];   //!< Peer answers
+    bool tx_error;                     //!< Fail the next start, as a late delayed start
+    uint32_t requests;                 //!< Exchanges started
+    uint32_t now;                      //!< Virtual time, usec
+};
+
+extern struct peer_sched_test_radio g_peer_sched_test_radio;
+
+struct peer_sched_instance * peer_sched_test_setup(void);
+void peer_sched_test_advance(struct peer_sched_instance * ps, uint32_t usecs);
+int32_t peer_sched_test_due(struct peer_sched_instance * ps, uint16_t addr);
+int peer_sched_test_run(struct peer_sched_instance * ps, uint32_t usecs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PEER_SCHED_TEST_H */
@@ -0,0 +1,90 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "peer_sched_test.h"
+
+/**
+ * A peer that fails is retried after its period, doubling on each further
+ * failure up to PEER_SCHED_BACKOFF_MAX, or after the rng's retry-after when
+ * that is longer. It is reported failing from PEER_SCHED_FAIL_THRESH
+ * failures and recovers at once on a range. A start missed by the radio
+ * leaves the peer due and healthy.
+ */
+TEST_CASE(peer_sched_backoff_test)
+{
+    struct peer_sched_instance * ps = peer_sched_test_setup();
+    struct peer_sched_peer * p = &ps->peers[0];
+    struct peer_sched_report report;
+    uint32_t period = os_cputime_usecs_to_ticks(100000);
+    uint32_t backoff_max = os_cputime_usecs_to_ticks(MYNEWT_VAL(PEER_SCHED_BACKOFF_MAX) * 1000UL);
+    uint32_t backoff = period;
+    int32_t due;
+    int i;
+
+    TEST_ASSERT(peer_sched_add(ps, PEER_SCHED_TEST_ADDR(0), 10, 1, DWT_DS_TWR) == OS_OK);
+    TEST_ASSERT(peer_sched_add(ps, PEER_SCHED_TEST_ADDR(1), 10, 0, DWT_DS_TWR) == OS_OK);
+    g_peer_sched_test_radio.up[0] = false;
+    g_peer_sched_test_radio.exchange = 0;
+
+    for (i = 1; i <= 10; i++) {
+        /* The healthy peer keeps ranging in the gaps */
+        TEST_ASSERT(peer_sched_request(ps) == 0);
+        TEST_ASSERT(p->failures == i);
+        TEST_ASSERT(p->backoff == backoff, "%d %lu", i, (unsigned long)p->backoff);
+        due = peer_sched_test_due(ps, PEER_SCHED_TEST_ADDR(0));
+        TEST_ASSERT(abs(due - (int32_t)os_cputime_ticks_to_usecs(backoff)) < 500, "%d %ld", i, (long)due);
+        TEST_ASSERT(peer_sched_get_report(ps, 0, &report) == OS_OK);
+        TEST_ASSERT(report.failing == (i >= MYNEWT_VAL(PEER_SCHED_FAIL_THRESH)));
+        peer_sched_test_advance(ps, os_cputime_ticks_to_usecs(backoff) - 1000);
+        while (peer_sched_request(ps) == 1);
+        TEST_ASSERT(peer_sched_next(ps) == -1);
+        peer_sched_test_advance(ps, 1000);
+        backoff = (2 * backoff > backoff_max) ? backoff_max : 2 * backoff;
+    }
+    TEST_ASSERT(p->backoff == backoff_max);
+
+    /* A longer retry-after wins */
+    g_peer_sched_test_radio.retry_after = MYNEWT_VAL(PEER_SCHED_BACKOFF_MAX) * 1000UL + 2000000;
+    TEST_ASSERT(peer_sched_request(ps) == 0);
+    due = peer_sched_test_due(ps, PEER_SCHED_TEST_ADDR(0));
+    TEST_ASSERT(abs(due - (int32_t)g_peer_sched_test_radio.retry_after) < 500, "%ld", (long)due);
+    g_peer_sched_test_radio.retry_after = 0;
+
+    /* Recovers on the first range, then back to its period */
+    g_peer_sched_test_radio.up[0] = true;
+    peer_sched_test_advance(ps, MYNEWT_VAL(PEER_SCHED_BACKOFF_MAX) * 1000UL + 2000000);
+    TEST_ASSERT(peer_sched_request(ps) == 0);
+    TEST_ASSERT(p->failures == 0 && p->backoff == 0);
+    TEST_ASSERT(peer_sched_get_report(ps, 0, &report) == OS_OK);
+    TEST_ASSERT(!report.failing && report.ranges == 1 && report.requests == 12);
+    TEST_ASSERT(abs(peer_sched_test_due(ps, PEER_SCHED_TEST_ADDR(0)) - 100000) < 500);
+
+    /* A missed start is not the peer's failure */
+    peer_sched_test_advance(ps, 100000);
+    g_peer_sched_test_radio.tx_error = true;
+    TEST_ASSERT(peer_sched_request(ps) == 0);
+    TEST_ASSERT(p->failures == 0 && p->backoff == 0);
+    TEST_ASSERT(peer_sched_next(ps) == 0);
+    g_peer_sched_test_radio.tx_error = false;
+#if MYNEWT_VAL(PEER_SCHED_STATS)
+    TEST_ASSERT(ps->stat.failures == 11);
+    TEST_ASSERT(ps->stat.failing == 1);
+    TEST_ASSERT(ps->stat.recovered == 1);
+    TEST_ASSERT(ps->stat.start_tx_error == 1);
+#endif
+}
@@ -0,0 +1,76 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "peer_sched_test.h"
+
+/**
+ * Among due peers the highest priority is served first, then the earliest
+ * deadline; a peer not yet due waits whatever its priority.
+ */
+TEST_CASE(peer_sched_edf_test)
+{
+    struct peer_sched_instance * ps = peer_sched_test_setup();
+    int a = 0, b = 1, c = 2, d = 3;
+
+    TEST_ASSERT(peer_sched_request(ps) == -1);
+    TEST_ASSERT(peer_sched_add(ps, PEER_SCHED_TEST_ADDR(0), 10, 1, DWT_DS_TWR) == OS_OK);
+    TEST_ASSERT(peer_sched_add(ps, PEER_SCHED_TEST_ADDR(1), 10, 1, DWT_DS_TWR) == OS_OK);
+    TEST_ASSERT(peer_sched_add(ps, PEER_SCHED_TEST_ADDR(2), 10, 1, DWT_DS_TWR) == OS_OK);
+    TEST_ASSERT(peer_sched_add(ps, PEER_SCHED_TEST_ADDR(3), 10, 2, DWT_DS_TWR) == OS_OK);
+
+    /* Late by 20, 30 and 10 ms, the high priority peer due in 5 ms */
+    ps->peers[a].deadline -= os_cputime_usecs_to_ticks(20000);
+    ps->peers[b].deadline -= os_cputime_usecs_to_ticks(30000);
+    ps->peers[c].deadline -= os_cputime_usecs_to_ticks(10000);
+    ps->peers[d].deadline += os_cputime_usecs_to_ticks(5000);
+    g_peer_sched_test_radio.exchange = 1000;
+
+    TEST_ASSERT(peer_sched_request(ps) == b);
+    TEST_ASSERT(peer_sched_request(ps) == a);
+    TEST_ASSERT(peer_sched_request(ps) == c);
+    TEST_ASSERT(peer_sched_next(ps) == -1);
+    peer_sched_test_advance(ps, 2000);
+    TEST_ASSERT(peer_sched_request(ps) == d);
+
+    /* Each moved on by one period from its own deadline, 6 ms in */
+    TEST_ASSERT(abs(peer_sched_test_due(ps, PEER_SCHED_TEST_ADDR(0)) - 74000) < 500);
+    TEST_ASSERT(abs(peer_sched_test_due(ps, PEER_SCHED_TEST_ADDR(1)) - 64000) < 500);
+    TEST_ASSERT(abs(peer_sched_test_due(ps, PEER_SCHED_TEST_ADDR(2)) - 84000) < 500);
+    TEST_ASSERT(abs(peer_sched_test_due(ps, PEER_SCHED_TEST_ADDR(3)) - 99000) < 500);
+
+    /* Due together, priority first although its deadline is the latest */
+    peer_sched_test_advance(ps, 100000);
+    TEST_ASSERT(peer_sched_request(ps) == d);
+    TEST_ASSERT(peer_sched_request(ps) == b);
+    TEST_ASSERT(peer_sched_request(ps) == a);
+    TEST_ASSERT(peer_sched_request(ps) == c);
+
+    /* A changed rate applies from the next deadline, a removed peer is never picked */
+    TEST_ASSERT(peer_sched_add(ps, PEER_SCHED_TEST_ADDR(1), 20, 1, DWT_DS_TWR) == OS_OK);
+    TEST_ASSERT(ps->peers[b].period == os_cputime_usecs_to_ticks(50000));
+    TEST_ASSERT(peer_sched_remove(ps, PEER_SCHED_TEST_ADDR(3)) == OS_OK);
+    TEST_ASSERT(peer_sched_remove(ps, PEER_SCHED_TEST_ADDR(3)) == OS_ENOENT);
+    peer_sched_test_advance(ps, 200000);
+    TEST_ASSERT(peer_sched_request(ps) == b);
+    TEST_ASSERT(peer_sched_request(ps) == a);
+    TEST_ASSERT(peer_sched_request(ps) == c);
+
+    TEST_ASSERT(peer_sched_add(ps, 0, 10, 1, DWT_DS_TWR) == OS_EINVAL);
+    TEST_ASSERT(peer_sched_add(ps, UWB_BROADCAST_ADDRESS, 10, 1, DWT_DS_TWR) == OS_EINVAL);
+    TEST_ASSERT(peer_sched_add(ps, PEER_SCHED_TEST_ADDR(4), 0, 1, DWT_DS_TWR) == OS_EINVAL);
+}
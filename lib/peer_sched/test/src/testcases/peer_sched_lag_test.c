@@ -0,0 +1,71 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "peer_sched_test.h"
+
+/**
+ * After an outage the due peers are moved forward together so the oldest
+ * is PEER_SCHED_MAX_LAG behind: the catch-up burst is bounded, the order
+ * and spacing of the peers is kept and a peer not yet due is left alone.
+ */
+TEST_CASE(peer_sched_lag_test)
+{
+    struct peer_sched_instance * ps = peer_sched_test_setup();
+    int32_t max_lag = MYNEWT_VAL(PEER_SCHED_MAX_LAG) * 1000;
+    int n[3] = {0}, i, last = -1;
+
+    TEST_ASSERT(peer_sched_add(ps, PEER_SCHED_TEST_ADDR(0), 10, 1, DWT_DS_TWR) == OS_OK);
+    TEST_ASSERT(peer_sched_add(ps, PEER_SCHED_TEST_ADDR(1), 10, 1, DWT_DS_TWR) == OS_OK);
+    TEST_ASSERT(peer_sched_add(ps, PEER_SCHED_TEST_ADDR(2), 0.1f, 1, DWT_DS_TWR) == OS_OK);
+    ps->peers[1].deadline += os_cputime_usecs_to_ticks(30000);
+    ps->peers[2].deadline += os_cputime_usecs_to_ticks(5000000 + 800000);
+    g_peer_sched_test_radio.exchange = 0;
+
+    /* Nothing ranged for 5 s */
+    peer_sched_test_advance(ps, 5000000);
+    TEST_ASSERT(peer_sched_next(ps) == 0);
+    TEST_ASSERT(abs(peer_sched_test_due(ps, PEER_SCHED_TEST_ADDR(0)) + max_lag) < 500);
+    TEST_ASSERT(abs(peer_sched_test_due(ps, PEER_SCHED_TEST_ADDR(1)) + max_lag - 30000) < 500);
+    TEST_ASSERT(abs(peer_sched_test_due(ps, PEER_SCHED_TEST_ADDR(2)) - 800000) < 500);
+
+    /* Catching up alternates, one range per period of lag each */
+    while ((i = peer_sched_request(ps)) >= 0) {
+        TEST_ASSERT_FATAL(i < 2 && n[0] + n[1] < 100);
+        TEST_ASSERT(i != last);
+        last = i;
+        n[i]++;
+    }
+    TEST_ASSERT(n[0] == max_lag / 100000 + 1, "%d", n[0]);
+    TEST_ASSERT(n[1] == (max_lag - 30000) / 100000 + 1, "%d", n[1]);
+    TEST_ASSERT(abs(peer_sched_test_due(ps, PEER_SCHED_TEST_ADDR(1)) - peer_sched_test_due(ps, PEER_SCHED_TEST_ADDR(0)) - (30000 - 100000)) < 500);
+
+    /* A lag shorter than the bound is caught up in full */
+    peer_sched_test_advance(ps, max_lag - 100000);
+    n[0] = n[1] = 0;
+    while ((i = peer_sched_request(ps)) >= 0 && i < 2)
+        n[i]++;
+    TEST_ASSERT(n[0] == (max_lag - 100000) / 100000 && n[1] == n[0], "%d %d", n[0], n[1]);
+
+    /* A peer only just due is not pushed into the future by the others' lag */
+    ps->peers[2].deadline = os_cputime_get32() + os_cputime_usecs_to_ticks(2000000 - 10000);
+    peer_sched_test_advance(ps, 2000000);
+    TEST_ASSERT(peer_sched_next(ps) == 1);
+    TEST_ASSERT(abs(peer_sched_test_due(ps, PEER_SCHED_TEST_ADDR(1)) + max_lag) < 500);
+    TEST_ASSERT(peer_sched_test_due(ps, PEER_SCHED_TEST_ADDR(2)) <= 0);
+    TEST_ASSERT(peer_sched_test_due(ps, PEER_SCHED_TEST_ADDR(2)) > -500);
+}
@@ -0,0 +1,82 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "peer_sched_test.h"
+
+static void
+rates(struct peer_sched_instance * ps, float rate[4])
+{
+    struct peer_sched_report report;
+
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT(peer_sched_get_report(ps, i, &report) == OS_OK);
+        rate[i] = report.rate;
+    }
+    peer_sched_reset_window(ps);
+}
+
+/**
+ * With capacity to spare every peer gets its rate. Overloaded, a higher
+ * priority peer still gets its rate and the peers of equal priority share
+ * what is left in proportion to their rates, none falling further than
+ * PEER_SCHED_MAX_LAG behind.
+ */
+TEST_CASE(peer_sched_share_test)
+{
+    struct peer_sched_instance * ps = peer_sched_test_setup();
+    int32_t max_lag = MYNEWT_VAL(PEER_SCHED_MAX_LAG) * 1000;
+    float rate[4];
+    int n;
+
+    TEST_ASSERT(peer_sched_add(ps, PEER_SCHED_TEST_ADDR(0), 20, 1, DWT_DS_TWR) == OS_OK);
+    TEST_ASSERT(peer_sched_add(ps, PEER_SCHED_TEST_ADDR(1), 10, 1, DWT_DS_TWR) == OS_OK);
+    TEST_ASSERT(peer_sched_add(ps, PEER_SCHED_TEST_ADDR(2), 10, 1, DWT_SS_TWR) == OS_OK);
+    TEST_ASSERT(peer_sched_add(ps, PEER_SCHED_TEST_ADDR(3), 4, 2, DWT_DS_TWR) == OS_OK);
+
+    /* 44 exchanges/s asked of 200 */
+    g_peer_sched_test_radio.exchange = 5000;
+    n = peer_sched_test_run(ps, 20000000);
+    TEST_ASSERT(abs(n - 20 * 44) <= 4, "%d", n);
+    rates(ps, rate);
+    TEST_ASSERT(fabsf(rate[0] - 20) < 0.2f && fabsf(rate[1] - 10) < 0.1f, "%f %f", rate[0], rate[1]);
+    TEST_ASSERT(fabsf(rate[2] - 10) < 0.1f && fabsf(rate[3] - 4) < 0.1f, "%f %f", rate[2], rate[3]);
+
+    /* 20 available, the high priority peer takes 4, 16 shared 2:1:1 */
+    g_peer_sched_test_radio.exchange = 50000;
+    peer_sched_test_run(ps, 2000000);
+    peer_sched_reset_window(ps);
+    n = peer_sched_test_run(ps, 20000000);
+    TEST_ASSERT(abs(n - 20 * 20) <= 2, "%d", n);
+    rates(ps, rate);
+    TEST_ASSERT(fabsf(rate[3] - 4) < 0.1f, "%f", rate[3]);
+    TEST_ASSERT(fabsf(rate[0] - 8) < 0.2f, "%f", rate[0]);
+    TEST_ASSERT(fabsf(rate[1] - 4) < 0.2f && fabsf(rate[2] - 4) < 0.2f, "%f %f", rate[1], rate[2]);
+    for (int i = 0; i < 3; i++) {
+        int32_t due = peer_sched_test_due(ps, PEER_SCHED_TEST_ADDR(i));
+        TEST_ASSERT(due > -max_lag - 51000, "%d %ld", i, (long)due);
+    }
+
+    /* Back to spare capacity, the rates recover */
+    g_peer_sched_test_radio.exchange = 5000;
+    peer_sched_test_run(ps, 2000000);
+    peer_sched_reset_window(ps);
+    peer_sched_test_run(ps, 20000000);
+    rates(ps, rate);
+    TEST_ASSERT(fabsf(rate[0] - 20) < 0.2f && fabsf(rate[1] - 10) < 0.1f, "%f %f", rate[0], rate[1]);
+    TEST_ASSERT(fabsf(rate[2] - 10) < 0.1f && fabsf(rate[3] - 4) < 0.1f, "%f %f", rate[2], rate[3]);
+}
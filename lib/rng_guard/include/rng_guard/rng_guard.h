@@ -0,0 +1,157 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file rng_guard.h
+ * @brief Ranging integrity checks against relay and distance reduction attacks
+ *
+ * @details Every range completed by the twr services is cross checked on
+ * signals an attacker shortening or lengthening it has to keep consistent:
+ * - the single sided estimate over the round the peer replied in against the
+ *   double sided estimate, a misreported reply time moves them apart;
+ * - the clock offset implied by the double sided turnaround intervals
+ *   against the carrier integrator offset of the peer's frame, a relay on its
+ *   own oscillator or a misreported interval breaks their agreement;
+ * - received power against first path power and against the peer baseline,
+ *   an early detect attack puts a weak path ahead of the real one;
+ * - the leading edge, the amplitudes following the first path over the noise
+ *   and, with the CIR, the distance from the first to the strongest path.
+ *
+ * Each check x with threshold T contributes 1 / (1 + (x / T)^4) to a product
+ * trust score, so a check at its threshold halves the score. Single sided
+ * ranges have no double sided reference and are scored on power and edge.
+ * The result of the last range is in rng_guard_instance::last when the
+ * complete_cb of the applications run.
+ */
+
+#ifndef _RNG_GUARD_H_
+#define _RNG_GUARD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stats/stats.h>
+#include <uwb/uwb.h>
+#include <uwb_rng/uwb_rng.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RNG_GUARD_RESIDUAL   (0x01)    //!< Single and double sided estimates disagree
+#define RNG_GUARD_SKEW       (0x02)    //!< Turnaround and carrier clock offsets disagree
+#define RNG_GUARD_POWER      (0x04)    //!< Weak first path
+#define RNG_GUARD_JUMP       (0x08)    //!< First path weaker than the peer baseline
+#define RNG_GUARD_EDGE       (0x10)    //!< First path followed by noise
+#define RNG_GUARD_RISE       (0x20)    //!< Strongest path far behind the first path
+#define RNG_GUARD_UNTRUSTED  (0x80)    //!< Trust score below RNG_GUARD_TRUST
+
+#if MYNEWT_VAL(RNG_GUARD_STATS)
+STATS_SECT_START(rng_guard_stat_section)
+    STATS_SECT_ENTRY(ranges)
+    STATS_SECT_ENTRY(untrusted)
+    STATS_SECT_ENTRY(residual)
+    STATS_SECT_ENTRY(skew)
+    STATS_SECT_ENTRY(power)
+    STATS_SECT_ENTRY(jump)
+    STATS_SECT_ENTRY(edge)
+    STATS_SECT_ENTRY(rise)
+    STATS_SECT_ENTRY(evicted)
+STATS_SECT_END
+#define RNG_GUARD_STATS_INC(__X) STATS_INC(guard->stat, __X)
+#else
+#define RNG_GUARD_STATS_INC(__X) {}
+#endif
+
+//! Signals of one completed range, NAN where not available
+struct rng_guard_obs {
+    uint16_t peer;                     //!< Peer short address
+    uint16_t code;                     //!< Ranging code of the exchange
+    float tof;                         //!< Time of flight reported by the services, dwt units
+    float tof_ss;                      //!< Single sided time of flight over the round the peer replied in
+    float skew_ts;                     //!< Peer clock rate over ours minus one, from the turnaround intervals
+    float skew_ci;                     //!< Same from the carrier integrator of the peer's frame
+    float fppl;                        //!< First path power level, dBm
+    float rssi;                        //!< Received power level, dBm
+    float edge_snr;                    //!< Weakest amplitude following the first path over the noise std
+    float edge_rise;                   //!< Accumulator samples from the first to the strongest path
+};
+
+//! Outcome of the checks on one range
+struct rng_guard_result {
+    uint16_t peer;                     //!< Peer short address
+    uint16_t code;                     //!< Ranging code of the exchange
+    uint8_t flags;                     //!< RNG_GUARD_* checks past their threshold
+    float trust;                       //!< Trust score, 1 when all checks are well within bounds
+    float range;                       //!< Range, m
+    float residual;                    //!< Single minus double sided range, m
+    float skew;                        //!< Turnaround minus carrier clock offset, ppm
+    float delta;                       //!< Received minus first path power, dB
+    float jump;                        //!< delta above the peer baseline, dB
+    float edge_snr;                    //!< Leading edge over noise
+    float edge_rise;                   //!< First to strongest path, samples
+};
+
+//! Per peer baseline
+struct rng_guard_peer {
+    uint16_t addr;                     //!< Peer short address, 0 marks a free entry
+    uint32_t last;                     //!< Cputime of the last range
+    uint32_t ranges;                   //!< Ranges checked
+    uint32_t untrusted;                //!< Ranges marked untrusted
+    uint32_t baseline;                 //!< Trusted ranges in the power baseline
+    float delta;                       //!< Mean power difference of trusted ranges, dB
+    float trust;                       //!< Mean trust score
+    uint8_t flags;                     //!< Flags of the last range
+};
+
+//! Status
+typedef struct _rng_guard_status_t{
+    uint16_t selfmalloc:1;             //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;            //!< Instance allocated
+    uint16_t valid:1;                  //!< last holds a result
+}rng_guard_status_t;
+
+//! Guard instance
+struct rng_guard_instance {
+#if MYNEWT_VAL(RNG_GUARD_STATS)
+    STATS_SECT_DECL(rng_guard_stat_section) stat; //!< Stats instance
+#endif
+    struct uwb_dev * dev_inst;         //!< Structure of uwb_dev
+    struct uwb_rng_instance * rng;     //!< Ranging instance checked
+    struct uwb_mac_interface cbs;      //!< MAC layer callbacks
+    rng_guard_status_t status;         //!< Status
+    uint16_t idx;                      //!< Ring index of the last range checked
+    struct rng_guard_result last;      //!< Result of the last range
+    struct rng_guard_peer peers[MYNEWT_VAL(RNG_GUARD_MAX_PEERS)]; //!< Baselines
+};
+
+struct rng_guard_instance * rng_guard_init(struct rng_guard_instance * guard, struct uwb_rng_instance * rng);
+void rng_guard_free(struct rng_guard_instance * guard);
+struct rng_guard_instance * rng_guard_get_instance(struct uwb_dev * inst);
+void rng_guard_reset(struct rng_guard_instance * guard);
+
+bool rng_guard_observe(struct rng_guard_instance * guard, uint16_t idx, struct rng_guard_obs * obs);
+void rng_guard_check(struct rng_guard_instance * guard, const struct rng_guard_obs * obs,
+                     struct rng_guard_result * result);
+struct rng_guard_peer * rng_guard_get_peer(struct rng_guard_instance * guard, uint16_t addr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RNG_GUARD_H_ */
@@ -0,0 +1,430 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file rng_guard.c
+ * @brief Ranging integrity checks against relay and distance reduction attacks
+ *
+ * @details The completed exchange is read back from the rng frame ring. At
+ * the responder the final frame is the one it sent, with its own source
+ * address, at the initiator the one received; the four turnaround intervals
+ * are ordered accordingly so our round, the peer's reply in it, our reply and
+ * the peer's round are known on either side. Clock offsets are the peer's
+ * rate over ours minus one, the convention of the single sided correction in
+ * uwb_rng_twr_to_tof(). The carrier integrator and diagnostics are those of
+ * the last frame received, the peer's frame completing the exchange.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <os/os.h>
+#include <sysinit/sysinit.h>
+#include <stats/stats.h>
+#include <uwb/uwb_mac.h>
+#include <dw1000/dw1000_dev.h>
+#if MYNEWT_VAL(CIR_ENABLED)
+#include <cir_dw1000/cir_dw1000.h>
+#endif
+#include <rng_guard/rng_guard.h>
+
+#if MYNEWT_VAL(RNG_GUARD_ENABLED)
+
+#if MYNEWT_VAL(RNG_GUARD_STATS)
+STATS_NAME_START(rng_guard_stat_section)
+    STATS_NAME(rng_guard_stat_section, ranges)
+    STATS_NAME(rng_guard_stat_section, untrusted)
+    STATS_NAME(rng_guard_stat_section, residual)
+    STATS_NAME(rng_guard_stat_section, skew)
+    STATS_NAME(rng_guard_stat_section, power)
+    STATS_NAME(rng_guard_stat_section, jump)
+    STATS_NAME(rng_guard_stat_section, edge)
+    STATS_NAME(rng_guard_stat_section, rise)
+    STATS_NAME(rng_guard_stat_section, evicted)
+STATS_NAME_END(rng_guard_stat_section)
+#endif
+
+static bool complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+
+#if MYNEWT_VAL(RNG_GUARD_CLI)
+int rng_guard_cli_register(void);
+#endif
+
+/**
+ * @fn rng_guard_init(struct rng_guard_instance * guard, struct uwb_rng_instance * rng)
+ * @brief Allocate and initialise a guard over the ranges of an rng instance.
+ *
+ * @param guard Pointer to struct rng_guard_instance, NULL to allocate.
+ * @param rng   Pointer to struct uwb_rng_instance.
+ *
+ * @return struct rng_guard_instance *
+ */
+struct rng_guard_instance *
+rng_guard_init(struct rng_guard_instance * guard, struct uwb_rng_instance * rng)
+{
+    assert(rng);
+
+    if (guard == NULL) {
+        guard = (struct rng_guard_instance *) malloc(sizeof(struct rng_guard_instance));
+        assert(guard);
+        memset(guard, 0, sizeof(struct rng_guard_instance));
+        guard->status.selfmalloc = 1;
+    }
+    guard->dev_inst = rng->dev_inst;
+    guard->rng = rng;
+    guard->idx = rng->idx;
+    rng_guard_reset(guard);
+
+    guard->cbs = (struct uwb_mac_interface){
+        .id = UWBEXT_RNG_GUARD,
+        .inst_ptr = (void *) guard,
+        .complete_cb = complete_cb
+    };
+    if (!guard->status.initialized) {
+        uwb_mac_append_interface(guard->dev_inst, &guard->cbs);
+#if MYNEWT_VAL(RNG_GUARD_STATS)
+        int rc = stats_init(
+                    STATS_HDR(guard->stat),
+                    STATS_SIZE_INIT_PARMS(guard->stat, STATS_SIZE_32),
+                    STATS_NAME_INIT_PARMS(rng_guard_stat_section)
+            );
+        rc |= stats_register("rng_guard", STATS_HDR(guard->stat));
+        assert(rc == 0);
+#endif
+    }
+    guard->status.initialized = 1;
+    return guard;
+}
+
+/**
+ * @fn rng_guard_free(struct rng_guard_instance * guard)
+ * @brief Free the instance.
+ *
+ * @param guard Pointer to struct rng_guard_instance.
+ *
+ * @return void
+ */
+void
+rng_guard_free(struct rng_guard_instance * guard)
+{
+    assert(guard);
+    uwb_mac_remove_interface(guard->dev_inst, guard->cbs.id);
+    if (guard->status.selfmalloc) {
+        free(guard);
+    } else {
+        guard->status.initialized = 0;
+    }
+}
+
+/**
+ * @fn rng_guard_get_instance(struct uwb_dev * inst)
+ * @brief Guard of a device.
+ *
+ * @param inst  Pointer to struct uwb_dev.
+ *
+ * @return struct rng_guard_instance *, NULL if the device has none
+ */
+struct rng_guard_instance *
+rng_guard_get_instance(struct uwb_dev * inst)
+{
+    return (struct rng_guard_instance *) uwb_mac_find_cb_inst_ptr(inst, UWBEXT_RNG_GUARD);
+}
+
+/**
+ * @fn rng_guard_reset(struct rng_guard_instance * guard)
+ * @brief Forget the peer baselines and the last result.
+ *
+ * @param guard Pointer to struct rng_guard_instance.
+ *
+ * @return void
+ */
+void
+rng_guard_reset(struct rng_guard_instance * guard)
+{
+    memset(guard->peers, 0, sizeof(guard->peers));
+    guard->status.valid = 0;
+}
+
+/**
+ * @fn rng_guard_get_peer(struct rng_guard_instance * guard, uint16_t addr)
+ * @brief Baseline of a peer, a fresh entry replacing the least recently
+ * ranged peer if it is not tracked.
+ *
+ * @param guard Pointer to struct rng_guard_instance.
+ * @param addr  Peer short address.
+ *
+ * @return struct rng_guard_peer *, NULL for address 0
+ */
+struct rng_guard_peer *
+rng_guard_get_peer(struct rng_guard_instance * guard, uint16_t addr)
+{
+    struct rng_guard_peer * victim = &guard->peers[0];
+    uint32_t now = os_cputime_get32();
+
+    if (addr == 0) {
+        return NULL;
+    }
+    for (uint16_t i = 0; i < MYNEWT_VAL(RNG_GUARD_MAX_PEERS); i++) {
+        struct rng_guard_peer * peer = &guard->peers[i];
+        if (peer->addr == addr) {
+            return peer;
+        }
+        if (!peer->addr) {
+            if (victim->addr) {
+                victim = peer;
+            }
+        } else if (victim->addr && now - peer->last > now - victim->last) {
+            victim = peer;
+        }
+    }
+    if (victim->addr) {
+        RNG_GUARD_STATS_INC(evicted);
+    }
+    memset(victim, 0, sizeof(struct rng_guard_peer));
+    victim->addr = addr;
+    victim->trust = 1.0f;
+    victim->last = now;
+    return victim;
+}
+
+/**
+ * @fn rng_guard_observe(struct rng_guard_instance * guard, uint16_t idx, struct rng_guard_obs * obs)
+ * @brief Gather the signals of the range completed at a ring index, from
+ * the frames and the diagnostics of the last frame received.
+ *
+ * @param guard Pointer to struct rng_guard_instance.
+ * @param idx   Ring index of the final frame.
+ * @param obs   Signals out.
+ *
+ * @return true if idx holds a completed exchange
+ */
+bool
+rng_guard_observe(struct rng_guard_instance * guard, uint16_t idx, struct rng_guard_obs * obs)
+{
+    struct uwb_dev * inst = guard->dev_inst;
+    struct uwb_rng_instance * rng = guard->rng;
+    twr_frame_t * frame = rng->frames[idx % rng->nframes];
+    bool responder, ds;
+
+    switch(frame->code){
+        case DWT_SS_TWR_FINAL:
+        case DWT_SS_TWR_EXT_FINAL:
+            ds = false;
+            break;
+        case DWT_DS_TWR_FINAL:
+        case DWT_DS_TWR_EXT_FINAL:
+            ds = true;
+            break;
+        default:
+            return false;
+    }
+    responder = (frame->src_address == inst->my_short_address);
+    *obs = (struct rng_guard_obs){
+        .peer = responder ? frame->dst_address : frame->src_address,
+        .code = frame->code,
+        .tof = uwb_rng_twr_to_tof(rng, idx),
+        .tof_ss = NAN, .skew_ts = NAN, .skew_ci = NAN,
+        .fppl = NAN, .rssi = NAN, .edge_snr = NAN, .edge_rise = NAN
+    };
+
+    if (!inst->config.dblbuffon_enabled) {
+        obs->skew_ci = uwb_calc_clock_offset_ratio(inst, inst->carrier_integrator, UWB_CR_CARRIER_INTEGRATOR);
+    }
+    if (ds) {
+        obs->skew_ts = uwb_rng_twr_to_skew(rng, idx, obs->skew_ci, &obs->tof_ss);
+    }
+
+    if (inst->config.rxdiag_enable) {
+        dw1000_dev_rxdiag_t * diag = (dw1000_dev_rxdiag_t *) inst->rxdiag;
+        uint16_t amp = diag->fp_amp;
+
+        obs->fppl = uwb_calc_fppl(inst, inst->rxdiag);
+        obs->rssi = uwb_calc_rssi(inst, inst->rxdiag);
+        if (diag->fp_amp2 < amp) {
+            amp = diag->fp_amp2;
+        }
+        if (diag->fp_amp3 < amp) {
+            amp = diag->fp_amp3;
+        }
+        if (diag->rx_std) {
+            obs->edge_snr = (float) amp / diag->rx_std;
+        }
+    }
+#if MYNEWT_VAL(CIR_ENABLED)
+    if (inst->cir && inst->cir->status.valid && MYNEWT_VAL(CIR_SIZE) > MYNEWT_VAL(CIR_OFFSET) + 1) {
+        struct cir_dw1000_instance * cir = (struct cir_dw1000_instance *) inst->cir;
+        float peak = 0;
+        for (uint16_t i = MYNEWT_VAL(CIR_OFFSET); i < MYNEWT_VAL(CIR_SIZE); i++) {
+            float re = cir->cir.array[i].real, im = cir->cir.array[i].imag;
+            float mag = re * re + im * im;
+            if (mag > peak) {
+                peak = mag;
+                obs->edge_rise = i - MYNEWT_VAL(CIR_OFFSET);
+            }
+        }
+    }
+#endif
+    return true;
+}
+
+/* Score one check, 1/2 at the threshold, and flag it past the threshold */
+static float
+guard_test(struct rng_guard_result * result, float x, float threshold, uint8_t flag)
+{
+    float r;
+
+    if (isnan(x) || x <= 0) {
+        return 1.0f;
+    }
+    if (x > threshold) {
+        result->flags |= flag;
+    }
+    r = x / threshold;
+    r *= r;
+    return 1.0f / (1.0f + r * r);
+}
+
+/**
+ * @fn rng_guard_check(struct rng_guard_instance * guard, const struct rng_guard_obs * obs, struct rng_guard_result * result)
+ * @brief Score one range and fold it into the peer baseline. Exposed for
+ * feeding recorded or simulated signals.
+ *
+ * @param guard     Pointer to struct rng_guard_instance.
+ * @param obs       Signals of the range.
+ * @param result    Outcome out.
+ *
+ * @return void
+ */
+void
+rng_guard_check(struct rng_guard_instance * guard, const struct rng_guard_obs * obs,
+                struct rng_guard_result * result)
+{
+    struct rng_guard_peer * peer = rng_guard_get_peer(guard, obs->peer);
+    float trust = 1.0f;
+
+    *result = (struct rng_guard_result){
+        .peer = obs->peer,
+        .code = obs->code,
+        .range = uwb_rng_tof_to_meters(obs->tof),
+        .residual = uwb_rng_tof_to_meters(obs->tof_ss - obs->tof),
+        .skew = (obs->skew_ts - obs->skew_ci) * 1e6f,
+        .delta = obs->rssi - obs->fppl,
+        .jump = NAN,
+        .edge_snr = obs->edge_snr,
+        .edge_rise = obs->edge_rise
+    };
+    if (peer && peer->baseline >= MYNEWT_VAL(RNG_GUARD_MIN_RANGES)) {
+        result->jump = result->delta - peer->delta;
+    }
+    RNG_GUARD_STATS_INC(ranges);
+
+    trust *= guard_test(result, fabsf(result->residual), MYNEWT_VAL(RNG_GUARD_RESIDUAL), RNG_GUARD_RESIDUAL);
+    trust *= guard_test(result, fabsf(result->skew), MYNEWT_VAL(RNG_GUARD_SKEW), RNG_GUARD_SKEW);
+    trust *= guard_test(result, result->delta, MYNEWT_VAL(RNG_GUARD_DELTA), RNG_GUARD_POWER);
+    trust *= guard_test(result, result->jump, MYNEWT_VAL(RNG_GUARD_DELTA_JUMP), RNG_GUARD_JUMP);
+    // Scored on the shortfall, threshold^2 / snr passes the threshold as the snr falls below it
+    trust *= guard_test(result, MYNEWT_VAL(RNG_GUARD_EDGE_SNR) * MYNEWT_VAL(RNG_GUARD_EDGE_SNR) / result->edge_snr,
+                        MYNEWT_VAL(RNG_GUARD_EDGE_SNR), RNG_GUARD_EDGE);
+    trust *= guard_test(result, result->edge_rise, MYNEWT_VAL(RNG_GUARD_EDGE_RISE), RNG_GUARD_RISE);
+
+    if (result->flags & RNG_GUARD_RESIDUAL) RNG_GUARD_STATS_INC(residual);
+    if (result->flags & RNG_GUARD_SKEW) RNG_GUARD_STATS_INC(skew);
+    if (result->flags & RNG_GUARD_POWER) RNG_GUARD_STATS_INC(power);
+    if (result->flags & RNG_GUARD_JUMP) RNG_GUARD_STATS_INC(jump);
+    if (result->flags & RNG_GUARD_EDGE) RNG_GUARD_STATS_INC(edge);
+    if (result->flags & RNG_GUARD_RISE) RNG_GUARD_STATS_INC(rise);
+
+    result->trust = trust;
+    if (trust < MYNEWT_VAL(RNG_GUARD_TRUST)) {
+        result->flags |= RNG_GUARD_UNTRUSTED;
+        RNG_GUARD_STATS_INC(untrusted);
+    }
+    if (peer == NULL) {
+        return;
+    }
+
+    // Only trusted ranges move the power baseline, an attack does not become the norm
+    if (!(result->flags & RNG_GUARD_UNTRUSTED) && isfinite(result->delta)) {
+        if (peer->baseline == 0) {
+            peer->delta = result->delta;
+        } else {
+            peer->delta += MYNEWT_VAL(RNG_GUARD_ALPHA) * (result->delta - peer->delta);
+        }
+        peer->baseline++;
+    }
+    peer->trust += MYNEWT_VAL(RNG_GUARD_ALPHA) * (trust - peer->trust);
+    peer->untrusted += (result->flags & RNG_GUARD_UNTRUSTED) ? 1 : 0;
+    peer->flags = result->flags;
+    peer->ranges++;
+    peer->last = os_cputime_get32();
+}
+
+/**
+ * @fn complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+ * @brief Check the range just completed, never consumes the event.
+ *
+ * @return false
+ */
+static bool
+complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct rng_guard_instance * guard = (struct rng_guard_instance *) cbs->inst_ptr;
+    struct rng_guard_obs obs;
+
+    // Completions of other services leave the ring where it was
+    if (guard->idx == guard->rng->idx) {
+        return false;
+    }
+    guard->idx = guard->rng->idx;
+    if (!rng_guard_observe(guard, guard->idx, &obs)) {
+        return false;
+    }
+    rng_guard_check(guard, &obs, &guard->last);
+    guard->status.valid = 1;
+#if MYNEWT_VAL(RNG_GUARD_VERBOSE)
+    if (guard->last.flags & RNG_GUARD_UNTRUSTED) {
+        printf("{\"utime\": %lu,\"msg\": \"rng_guard_untrusted\",\"addr\": \"%X\",\"flags\": \"%X\",\"trust\": %d}\n",
+               os_cputime_ticks_to_usecs(os_cputime_get32()), guard->last.peer, guard->last.flags,
+               (int)(guard->last.trust * 100));
+    }
+#endif
+    return false;
+}
+
+void
+rng_guard_pkg_init(void)
+{
+#if MYNEWT_VAL(RNG_GUARD_VERBOSE)
+    printf("{\"utime\": %lu,\"msg\": \"rng_guard_pkg_init\"}\n", os_cputime_ticks_to_usecs(os_cputime_get32()));
+#endif
+#if MYNEWT_VAL(UWB_DEVICE_0)
+    struct uwb_rng_instance * rng = (struct uwb_rng_instance *)
+        uwb_mac_find_cb_inst_ptr(uwb_dev_idx_lookup(0), UWBEXT_RNG);
+    SYSINIT_PANIC_ASSERT(rng);
+    rng_guard_init(NULL, rng);
+#endif
+#if MYNEWT_VAL(RNG_GUARD_CLI)
+    int rc = rng_guard_cli_register();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+}
+
+#endif /* MYNEWT_VAL(RNG_GUARD_ENABLED) */
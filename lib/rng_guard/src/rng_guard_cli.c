@@ -0,0 +1,138 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <os/os.h>
+#include <syscfg/syscfg.h>
+
+#if MYNEWT_VAL(RNG_GUARD_ENABLED) && MYNEWT_VAL(RNG_GUARD_CLI)
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <shell/shell.h>
+#include <console/console.h>
+
+#include <uwb/uwb.h>
+#include "rng_guard/rng_guard.h"
+
+static int rng_guard_cli_cmd(int argc, char **argv);
+
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+const struct shell_param cmd_guard_param[] = {
+    {"last", "checks of the last range"},
+    {"peers", "per peer trust and power baseline"},
+    {"reset", "forget all peers"},
+    {NULL,NULL},
+};
+
+const struct shell_cmd_help cmd_guard_help = {
+	"guard", "<cmd>", cmd_guard_param
+};
+#endif
+
+static struct shell_cmd shell_guard_cmd = {
+    .sc_cmd = "guard",
+    .sc_cmd_func = rng_guard_cli_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+    .help = &cmd_guard_help
+#endif
+};
+
+static void
+print_float(float v)
+{
+    if (!isfinite(v)) {
+        console_printf("-");
+        return;
+    }
+    console_printf("%s%d.%03d", (v < 0) ? "-" : "", (int)fabsf(v),
+                   (int)((fabsf(v) - (int)fabsf(v))*1000));
+}
+
+static void
+rng_guard_cli_last(struct rng_guard_instance * guard)
+{
+    const struct rng_guard_result * r = &guard->last;
+    const float v[] = {r->trust, r->range, r->residual, r->skew, r->delta, r->jump, r->edge_snr, r->edge_rise};
+
+    if (!guard->status.valid) {
+        console_printf("No range checked\n");
+        return;
+    }
+    console_printf("#addr, code, flags, trust, range, residual, skew, delta, jump, edge_snr, edge_rise\n");
+    console_printf("%4x, %d, %02x", r->peer, r->code, r->flags);
+    for (int i = 0; i < sizeof(v)/sizeof(v[0]); i++) {
+        console_printf(", ");
+        print_float(v[i]);
+    }
+    console_printf("\n");
+}
+
+static void
+rng_guard_cli_peers(struct rng_guard_instance * guard)
+{
+    uint32_t now = os_cputime_get32();
+
+    console_printf("#addr, ranges, untrusted, flags, trust, delta, age_ms\n");
+    for (int i = 0; i < MYNEWT_VAL(RNG_GUARD_MAX_PEERS); i++) {
+        struct rng_guard_peer * peer = &guard->peers[i];
+        if (!peer->addr) {
+            continue;
+        }
+        console_printf("%4x, %lu, %lu, %02x, ", peer->addr, (unsigned long)peer->ranges,
+                       (unsigned long)peer->untrusted, peer->flags);
+        print_float(peer->trust);
+        console_printf(", ");
+        print_float(peer->baseline ? peer->delta : NAN);
+        console_printf(", %lu\n", os_cputime_ticks_to_usecs(now - peer->last) / 1000);
+    }
+}
+
+static int
+rng_guard_cli_cmd(int argc, char **argv)
+{
+    struct rng_guard_instance * guard = rng_guard_get_instance(uwb_dev_idx_lookup(0));
+
+    if (argc < 2) {
+        return 0;
+    }
+    if (guard == NULL) {
+        console_printf("No rng_guard instance\n");
+        return 0;
+    }
+
+    if (!strcmp(argv[1], "last")) {
+        rng_guard_cli_last(guard);
+    } else if (!strcmp(argv[1], "peers")) {
+        rng_guard_cli_peers(guard);
+    } else if (!strcmp(argv[1], "reset")) {
+        rng_guard_reset(guard);
+    } else {
+        console_printf("Unknown cmd\n");
+    }
+    return 0;
+}
+
+int
+rng_guard_cli_register(void)
+{
+    return shell_cmd_register(&shell_guard_cmd);
+}
+#endif /* MYNEWT_VAL(RNG_GUARD_ENABLED) && MYNEWT_VAL(RNG_GUARD_CLI) */
@@ -0,0 +1,167 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "rng_guard_test.h"
+
+#define RNG_GUARD_TEST_C (299792458.0f)
+#define RNG_GUARD_TEST_SKEW (5e-6f)        /* Peer clock offset */
+#define RNG_GUARD_TEST_RSSI (-80.0f)       /* dBm at the simulated range */
+
+static struct uwb_dev g_dev;
+static struct uwb_rng_instance g_rng;
+static uint32_t g_seed = 1;
+
+void
+rng_guard_test_seed(uint32_t seed)
+{
+    g_seed = (seed) ? seed : 1;
+}
+
+static float
+randu(void)
+{
+    g_seed ^= g_seed << 13;
+    g_seed ^= g_seed >> 17;
+    g_seed ^= g_seed << 5;
+    return (g_seed >> 8) * (1.0f / 16777216.0f);
+}
+
+static float
+randn(void)
+{
+    float u = randu();
+
+    while (u < 1e-7f) {
+        u = randu();
+    }
+    return sqrtf(-2.0f * logf(u)) * cosf(2.0f * (float)M_PI * randu());
+}
+
+/**
+ * Initialise a guard over a dummy rng instance on a dummy uwb device.
+ */
+void
+rng_guard_test_setup(struct rng_guard_instance * guard)
+{
+    memset(&g_dev, 0, sizeof(g_dev));
+    memset(&g_rng, 0, sizeof(g_rng));
+    memset(guard, 0, sizeof(*guard));
+    g_rng.dev_inst = &g_dev;
+    TEST_ASSERT_FATAL(rng_guard_init(guard, &g_rng) == guard);
+    rng_guard_test_seed(1);
+}
+
+void
+rng_guard_test_teardown(struct rng_guard_instance * guard)
+{
+    rng_guard_free(guard);
+}
+
+/** Metres to time of flight, dwt units */
+float
+rng_guard_test_m2tof(float m)
+{
+    return m / uwb_rng_tof_to_meters(1.0f);
+}
+
+/**
+ * Signals of one double sided range. Honest ranges: 5cm single sided
+ * noise, 0.2ppm carrier integrator and 0.3ppm turnaround noise, first path
+ * 2dB under the received power in line of sight and 6dB behind an
+ * obstruction, with a weaker leading edge a few samples ahead of the peak.
+ *
+ * A peer adding 4 x attack to its reported reply shortens the double sided
+ * estimate by attack and the single sided one by twice that, and skews the
+ * turnaround offset by the reply error over the reply time. A relay adds
+ * its own clock offset to the carrier of the frames it forwards. An early
+ * detect / late commit attacker advances the first path by attack with a
+ * lone pulse: weak, followed by noise and far ahead of the real peak.
+ */
+void
+rng_guard_test_obs(struct rng_guard_obs * obs, uint16_t kind, float distance, float attack)
+{
+    bool nlos = (kind == RNG_GUARD_TEST_NLOS);
+    float tof = rng_guard_test_m2tof(distance);
+
+    memset(obs, 0, sizeof(*obs));
+    obs->peer = RNG_GUARD_TEST_PEER;
+    obs->code = DWT_DS_TWR_FINAL;
+    obs->tof = tof;
+    obs->tof_ss = tof + rng_guard_test_m2tof(0.05f * randn());
+    obs->skew_ci = RNG_GUARD_TEST_SKEW + 0.2e-6f * randn();
+    obs->skew_ts = obs->skew_ci + 0.3e-6f * randn();
+    obs->rssi = RNG_GUARD_TEST_RSSI + randn();
+    obs->fppl = obs->rssi - ((nlos) ? 6.0f + 2.0f * randn() : 2.0f + randn());
+    obs->edge_snr = (nlos) ? 8.0f + 2.0f * randn() : 20.0f + 4.0f * randn();
+    obs->edge_rise = (nlos) ? 3.0f + randn() : 1.0f + 0.5f * randn();
+
+    switch(kind){
+        case RNG_GUARD_TEST_REPLY:
+            obs->tof -= rng_guard_test_m2tof(attack);
+            obs->tof_ss -= rng_guard_test_m2tof(2.0f * attack);
+            obs->skew_ts += 4.0f * attack / RNG_GUARD_TEST_C / (MYNEWT_VAL(RNG_TX_HOLDOFF) * 1e-6f);
+            break;
+        case RNG_GUARD_TEST_RELAY:
+            obs->skew_ci += attack * 1e-6f;
+            break;
+        case RNG_GUARD_TEST_EDLC:
+            obs->tof -= rng_guard_test_m2tof(attack);
+            obs->tof_ss -= rng_guard_test_m2tof(attack);
+            obs->fppl = obs->rssi - 14.0f + randn();
+            obs->edge_snr = 3.0f + randn();
+            obs->edge_rise = 10.0f + 2.0f * randn();
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Check a warmup of honest line of sight ranges followed by the trace.
+ */
+void
+rng_guard_test_run(struct rng_guard_instance * guard, struct rng_guard_test_run * run)
+{
+    struct rng_guard_obs obs;
+    struct rng_guard_result result;
+
+    run->untrusted = 0;
+    memset(run->flagged, 0, sizeof(run->flagged));
+    run->trust = 0;
+    run->range_err = 0;
+
+    for (uint32_t i = 0; i < run->warmup + run->ranges; i++) {
+        bool warm = (i < run->warmup);
+        rng_guard_test_obs(&obs, (warm) ? RNG_GUARD_TEST_LOS : run->kind, run->distance, run->attack);
+        rng_guard_check(guard, &obs, &result);
+        if (warm) {
+            continue;
+        }
+        run->untrusted += (result.flags & RNG_GUARD_UNTRUSTED) ? 1 : 0;
+        for (uint8_t k = 0; k < 6; k++) {
+            run->flagged[k] += (result.flags & (1 << k)) ? 1 : 0;
+        }
+        run->trust += result.trust;
+        run->range_err += result.range - run->distance;
+    }
+    if (run->ranges) {
+        run->trust /= run->ranges;
+        run->range_err /= run->ranges;
+    }
+}
@@ -0,0 +1,76 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _RNG_GUARD_TEST_H
+#define _RNG_GUARD_TEST_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "testutil/testutil.h"
+
+#include "rng_guard/rng_guard.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Address of the simulated peer
+#define RNG_GUARD_TEST_PEER (0x1234)
+
+//! Exchanges of a simulated trace
+typedef enum _rng_guard_test_kind_t{
+    RNG_GUARD_TEST_LOS = 0,            //!< Honest peer in line of sight
+    RNG_GUARD_TEST_NLOS,               //!< Honest peer behind an obstruction
+    RNG_GUARD_TEST_REPLY,              //!< Peer reporting a longer reply than it took
+    RNG_GUARD_TEST_RELAY,              //!< Relay retransmitting on its own oscillator
+    RNG_GUARD_TEST_EDLC,               //!< Early detect / late commit of the first path
+}rng_guard_test_kind_t;
+
+//! One simulated trace of double sided ranges to a single peer
+struct rng_guard_test_run {
+    uint16_t kind;                     //!< rng_guard_test_kind_t
+    float distance;                    //!< True range, m
+    float attack;                      //!< Range reduction, m, or relay clock offset, ppm
+    uint32_t warmup;                   //!< Honest line of sight ranges ahead of the trace
+    uint32_t ranges;                   //!< Ranges of the trace
+    /* Results, over the trace after the warmup */
+    uint32_t untrusted;                //!< Ranges marked untrusted
+    uint32_t flagged[6];               //!< Ranges past each threshold, in RNG_GUARD_* flag order
+    float trust;                       //!< Mean trust score
+    float range_err;                   //!< Mean reported minus true range, m
+};
+
+void rng_guard_test_setup(struct rng_guard_instance * guard);
+void rng_guard_test_teardown(struct rng_guard_instance * guard);
+void rng_guard_test_seed(uint32_t seed);
+float rng_guard_test_m2tof(float m);
+void rng_guard_test_obs(struct rng_guard_obs * obs, uint16_t kind, float distance, float attack);
+void rng_guard_test_run(struct rng_guard_instance * guard, struct rng_guard_test_run * run);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,64 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "rng_guard_test.h"
+
+/**
+ * Honest peers: line of sight ranges are trusted and build the power
+ * baseline, ranges behind an obstruction stay mostly trusted although
+ * their first path is weaker.
+ */
+TEST_CASE(rng_guard_baseline_test)
+{
+    static struct rng_guard_instance guard;
+    struct rng_guard_test_run run = {
+        .kind = RNG_GUARD_TEST_LOS, .distance = 10.0f, .ranges = 5000
+    };
+    struct rng_guard_peer * peer;
+
+    rng_guard_test_setup(&guard);
+    rng_guard_test_run(&guard, &run);
+    TEST_ASSERT(run.untrusted * 1000 <= run.ranges, "los untrusted %lu", (unsigned long)run.untrusted);
+    TEST_ASSERT(run.trust > 0.95f, "los trust %f", run.trust);
+    TEST_ASSERT(fabsf(run.range_err) < 0.01f, "los err %f", run.range_err);
+
+    peer = rng_guard_get_peer(&guard, RNG_GUARD_TEST_PEER);
+    TEST_ASSERT_FATAL(peer != NULL);
+    TEST_ASSERT(peer->ranges == run.ranges);
+    TEST_ASSERT(peer->baseline == run.ranges - run.untrusted);
+    TEST_ASSERT(fabsf(peer->delta - 2.0f) < 0.5f, "delta %f", peer->delta);
+    TEST_ASSERT(peer->trust > 0.9f, "trust %f", peer->trust);
+
+    // Obstructed, against the line of sight baseline
+    run.kind = RNG_GUARD_TEST_NLOS;
+    rng_guard_test_run(&guard, &run);
+    TEST_ASSERT(run.untrusted * 100 <= 3 * run.ranges, "nlos untrusted %lu", (unsigned long)run.untrusted);
+    TEST_ASSERT(run.flagged[1] * 100 <= run.ranges, "nlos skew %lu", (unsigned long)run.flagged[1]);
+
+    // From scratch, the baseline follows the obstructed path
+    rng_guard_reset(&guard);
+    rng_guard_test_run(&guard, &run);
+    TEST_ASSERT(run.untrusted * 100 <= 3 * run.ranges, "nlos untrusted %lu", (unsigned long)run.untrusted);
+    peer = rng_guard_get_peer(&guard, RNG_GUARD_TEST_PEER);
+    TEST_ASSERT(fabsf(peer->delta - 6.0f) < 1.0f, "delta %f", peer->delta);
+
+#if MYNEWT_VAL(RNG_GUARD_STATS)
+    TEST_ASSERT(guard.stat.ranges == 3 * run.ranges);
+#endif
+    rng_guard_test_teardown(&guard);
+}
@@ -0,0 +1,62 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "rng_guard_test.h"
+
+#define RANGES (5000)
+
+/**
+ * Early detect / late commit advancing the first path by 2m: the weak lone
+ * pulse is flagged on power, edge and rise, and against the baseline the
+ * honest warmup built, which the attack does not move.
+ */
+TEST_CASE(rng_guard_edlc_test)
+{
+    static struct rng_guard_instance guard;
+    struct rng_guard_test_run run = {
+        .kind = RNG_GUARD_TEST_EDLC, .distance = 10.0f, .attack = 2.0f,
+        .warmup = 20, .ranges = RANGES
+    };
+    struct rng_guard_peer * peer;
+    float delta;
+
+    rng_guard_test_setup(&guard);
+    rng_guard_test_run(&guard, &run);
+    TEST_ASSERT(fabsf(run.range_err + 2.0f) < 0.01f, "err %f", run.range_err);
+    TEST_ASSERT(run.untrusted == RANGES, "untrusted %lu", (unsigned long)run.untrusted);
+    TEST_ASSERT(run.flagged[2] * 100 >= 99 * RANGES, "power %lu", (unsigned long)run.flagged[2]);
+    TEST_ASSERT(run.flagged[3] * 100 >= 90 * RANGES, "jump %lu", (unsigned long)run.flagged[3]);
+    TEST_ASSERT(run.flagged[4] * 100 >= 80 * RANGES, "edge %lu", (unsigned long)run.flagged[4]);
+    TEST_ASSERT(run.flagged[5] * 100 >= 95 * RANGES, "rise %lu", (unsigned long)run.flagged[5]);
+    // The single and double sided estimates agree, only the signal gives it away
+    TEST_ASSERT(run.flagged[0] * 100 <= RANGES && run.flagged[1] * 100 <= RANGES);
+
+    peer = rng_guard_get_peer(&guard, RNG_GUARD_TEST_PEER);
+    TEST_ASSERT(peer->baseline == run.warmup, "baseline %lu", (unsigned long)peer->baseline);
+    TEST_ASSERT(peer->untrusted == RANGES);
+    TEST_ASSERT(fabsf(peer->delta - 2.0f) < 1.0f, "delta %f", peer->delta);
+    delta = peer->delta;
+
+    // Back to honest ranges, trusted again right away
+    run.kind = RNG_GUARD_TEST_LOS;
+    run.warmup = 0;
+    rng_guard_test_run(&guard, &run);
+    TEST_ASSERT(run.untrusted * 1000 <= RANGES, "untrusted %lu", (unsigned long)run.untrusted);
+    TEST_ASSERT(fabsf(peer->delta - delta) < 1.0f);
+    rng_guard_test_teardown(&guard);
+}
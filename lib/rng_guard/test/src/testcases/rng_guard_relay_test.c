@@ -0,0 +1,41 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "rng_guard_test.h"
+
+#define RANGES (5000)
+
+/**
+ * A relay on its own oscillator 8ppm off: the carrier integrator offset no
+ * longer matches the turnaround offset.
+ */
+TEST_CASE(rng_guard_relay_test)
+{
+    static struct rng_guard_instance guard;
+    struct rng_guard_test_run run = {
+        .kind = RNG_GUARD_TEST_RELAY, .distance = 10.0f, .attack = 8.0f,
+        .warmup = 20, .ranges = RANGES
+    };
+
+    rng_guard_test_setup(&guard);
+    rng_guard_test_run(&guard, &run);
+    TEST_ASSERT(run.untrusted == RANGES, "untrusted %lu", (unsigned long)run.untrusted);
+    TEST_ASSERT(run.flagged[1] == RANGES, "skew %lu", (unsigned long)run.flagged[1]);
+    TEST_ASSERT(run.flagged[0] * 100 <= RANGES, "residual %lu", (unsigned long)run.flagged[0]);
+    rng_guard_test_teardown(&guard);
+}
@@ -0,0 +1,48 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "rng_guard_test.h"
+
+#define RANGES (5000)
+
+/**
+ * A peer claiming a longer reply to appear 3m closer: the single and
+ * double sided estimates and the two clock offsets disagree on every range.
+ */
+TEST_CASE(rng_guard_reply_test)
+{
+    static struct rng_guard_instance guard;
+    struct rng_guard_test_run run = {
+        .kind = RNG_GUARD_TEST_REPLY, .distance = 10.0f, .attack = 3.0f,
+        .warmup = 20, .ranges = RANGES
+    };
+
+    rng_guard_test_setup(&guard);
+    rng_guard_test_run(&guard, &run);
+    TEST_ASSERT(fabsf(run.range_err + 3.0f) < 0.01f, "err %f", run.range_err);
+    TEST_ASSERT(run.untrusted == RANGES, "untrusted %lu", (unsigned long)run.untrusted);
+    TEST_ASSERT(run.flagged[0] == RANGES, "residual %lu", (unsigned long)run.flagged[0]);
+    TEST_ASSERT(run.flagged[1] == RANGES, "skew %lu", (unsigned long)run.flagged[1]);
+    // Power and edge are those of an honest peer
+    TEST_ASSERT(run.flagged[2] * 100 <= RANGES && run.flagged[4] * 100 <= RANGES);
+#if MYNEWT_VAL(RNG_GUARD_STATS)
+    TEST_ASSERT(guard.stat.untrusted == RANGES);
+    TEST_ASSERT(guard.stat.residual == RANGES);
+#endif
+    rng_guard_test_teardown(&guard);
+}
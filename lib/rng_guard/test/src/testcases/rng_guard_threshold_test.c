@@ -0,0 +1,158 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "rng_guard_test.h"
+
+/* A range at 10m with every signal unavailable */
+static void
+blank(struct rng_guard_obs * obs, uint16_t peer)
+{
+    memset(obs, 0, sizeof(*obs));
+    obs->peer = peer;
+    obs->code = DWT_DS_TWR_FINAL;
+    obs->tof = rng_guard_test_m2tof(10.0f);
+    obs->tof_ss = obs->skew_ts = obs->skew_ci = NAN;
+    obs->fppl = obs->rssi = obs->edge_snr = obs->edge_rise = NAN;
+}
+
+/* Score of a check at x times its threshold */
+static float
+score(float x)
+{
+    return 1.0f / (1.0f + x * x * x * x);
+}
+
+/**
+ * Every check against its threshold: just under it neither flags nor
+ * halves the score, just past it flags, one check alone marks the range
+ * untrusted only well past its threshold, two together just past theirs.
+ * Untrusted ranges never move the peer baseline.
+ */
+TEST_CASE(rng_guard_threshold_test)
+{
+    static struct rng_guard_instance guard;
+    struct rng_guard_obs obs;
+    struct rng_guard_result r;
+    struct rng_guard_peer * peer;
+    float T;
+
+    rng_guard_test_setup(&guard);
+
+    // No signals, single sided ranges at the initiator without diagnostics
+    blank(&obs, 0x101);
+    rng_guard_check(&guard, &obs, &r);
+    TEST_ASSERT(r.flags == 0 && r.trust == 1.0f);
+    TEST_ASSERT(fabsf(r.range - 10.0f) < 1e-3f, "range %f", r.range);
+    TEST_ASSERT(isnan(r.residual) && isnan(r.skew) && isnan(r.delta) && isnan(r.jump));
+
+    T = MYNEWT_VAL(RNG_GUARD_RESIDUAL);
+    obs.tof_ss = obs.tof + rng_guard_test_m2tof(0.97f * T);
+    rng_guard_check(&guard, &obs, &r);
+    TEST_ASSERT(r.flags == 0 && r.trust > 0.5f, "residual %f trust %f", r.residual, r.trust);
+    obs.tof_ss = obs.tof - rng_guard_test_m2tof(1.03f * T);
+    rng_guard_check(&guard, &obs, &r);
+    TEST_ASSERT(r.flags == RNG_GUARD_RESIDUAL && r.trust < 0.5f, "residual %f trust %f", r.residual, r.trust);
+    TEST_ASSERT(fabsf(r.trust - score(1.03f)) < 1e-3f);
+
+    blank(&obs, 0x101);
+    T = MYNEWT_VAL(RNG_GUARD_SKEW);
+    obs.skew_ci = 10e-6f;
+    obs.skew_ts = obs.skew_ci - 0.97f * T * 1e-6f;
+    rng_guard_check(&guard, &obs, &r);
+    TEST_ASSERT(r.flags == 0 && r.trust > 0.5f, "skew %f", r.skew);
+    obs.skew_ts = obs.skew_ci + 1.03f * T * 1e-6f;
+    rng_guard_check(&guard, &obs, &r);
+    TEST_ASSERT(r.flags == RNG_GUARD_SKEW, "skew %f", r.skew);
+
+    blank(&obs, 0x102);
+    T = MYNEWT_VAL(RNG_GUARD_DELTA);
+    obs.rssi = -80.0f;
+    obs.fppl = obs.rssi - 0.97f * T;
+    rng_guard_check(&guard, &obs, &r);
+    TEST_ASSERT(r.flags == 0 && r.trust > 0.5f, "delta %f", r.delta);
+    obs.fppl = obs.rssi - 1.03f * T;
+    rng_guard_check(&guard, &obs, &r);
+    TEST_ASSERT(r.flags == RNG_GUARD_POWER, "delta %f", r.delta);
+
+    // Scored on the shortfall of the edge below its threshold
+    blank(&obs, 0x101);
+    T = MYNEWT_VAL(RNG_GUARD_EDGE_SNR);
+    obs.edge_snr = 1.03f * T;
+    rng_guard_check(&guard, &obs, &r);
+    TEST_ASSERT(r.flags == 0 && r.trust > 0.5f, "edge %f", r.edge_snr);
+    obs.edge_snr = 0.97f * T;
+    rng_guard_check(&guard, &obs, &r);
+    TEST_ASSERT(r.flags == RNG_GUARD_EDGE, "edge %f", r.edge_snr);
+
+    blank(&obs, 0x101);
+    T = MYNEWT_VAL(RNG_GUARD_EDGE_RISE);
+    obs.edge_rise = 0.97f * T;
+    rng_guard_check(&guard, &obs, &r);
+    TEST_ASSERT(r.flags == 0 && r.trust > 0.5f);
+    obs.edge_rise = 1.03f * T;
+    rng_guard_check(&guard, &obs, &r);
+    TEST_ASSERT(r.flags == RNG_GUARD_RISE);
+
+    // One check alone, untrusted once its score drops under RNG_GUARD_TRUST
+    blank(&obs, 0x101);
+    T = powf(1.0f / MYNEWT_VAL(RNG_GUARD_TRUST) - 1.0f, 0.25f) * MYNEWT_VAL(RNG_GUARD_EDGE_RISE);
+    obs.edge_rise = 0.98f * T;
+    rng_guard_check(&guard, &obs, &r);
+    TEST_ASSERT(r.flags == RNG_GUARD_RISE, "trust %f", r.trust);
+    obs.edge_rise = 1.02f * T;
+    rng_guard_check(&guard, &obs, &r);
+    TEST_ASSERT(r.flags == (RNG_GUARD_RISE | RNG_GUARD_UNTRUSTED), "trust %f", r.trust);
+
+    // Two checks just past theirs
+    blank(&obs, 0x101);
+    obs.edge_rise = 1.03f * MYNEWT_VAL(RNG_GUARD_EDGE_RISE);
+    obs.skew_ci = 0;
+    obs.skew_ts = 1.03f * MYNEWT_VAL(RNG_GUARD_SKEW) * 1e-6f;
+    rng_guard_check(&guard, &obs, &r);
+    TEST_ASSERT(r.flags == (RNG_GUARD_RISE | RNG_GUARD_SKEW | RNG_GUARD_UNTRUSTED), "trust %f", r.trust);
+    TEST_ASSERT(fabsf(r.trust - score(1.03f) * score(1.03f)) < 1e-3f);
+
+    // The jump is checked once the baseline holds RNG_GUARD_MIN_RANGES trusted ranges
+    blank(&obs, 0x103);
+    obs.rssi = -80.0f;
+    obs.fppl = obs.rssi;
+    for (uint16_t i = 0; i < MYNEWT_VAL(RNG_GUARD_MIN_RANGES); i++) {
+        rng_guard_check(&guard, &obs, &r);
+        TEST_ASSERT(isnan(r.jump));
+    }
+    peer = rng_guard_get_peer(&guard, 0x103);
+    TEST_ASSERT_FATAL(peer->baseline == MYNEWT_VAL(RNG_GUARD_MIN_RANGES));
+    TEST_ASSERT(peer->delta == 0);
+    T = MYNEWT_VAL(RNG_GUARD_DELTA_JUMP);
+    obs.fppl = obs.rssi - peer->delta - 0.97f * T;
+    rng_guard_check(&guard, &obs, &r);
+    TEST_ASSERT(r.flags == 0, "jump %f", r.jump);
+    obs.fppl = obs.rssi - peer->delta - 1.03f * T;
+    rng_guard_check(&guard, &obs, &r);
+    TEST_ASSERT(r.flags == RNG_GUARD_JUMP, "jump %f", r.jump);
+    TEST_ASSERT(peer->baseline == MYNEWT_VAL(RNG_GUARD_MIN_RANGES) + 2);
+
+    // An untrusted range leaves the baseline where it is
+    obs.fppl = obs.rssi - peer->delta - 2.0f * T;
+    rng_guard_check(&guard, &obs, &r);
+    TEST_ASSERT(r.flags & RNG_GUARD_UNTRUSTED);
+    TEST_ASSERT(peer->baseline == MYNEWT_VAL(RNG_GUARD_MIN_RANGES) + 2);
+    TEST_ASSERT(peer->untrusted == 1);
+
+    rng_guard_test_teardown(&guard);
+}
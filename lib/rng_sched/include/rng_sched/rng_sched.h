@@ -0,0 +1,134 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file rng_sched.h
+ * @brief Motion adaptive ranging rate scheduler
+ *
+ * @details A tag hands the scheduler its candidate tdma slots in priority
+ * order together with the slot callback it would otherwise assign itself.
+ * From accelerometer samples (or a wake-on-motion interrupt) and the
+ * tracker position uncertainty the scheduler picks a motion level; each
+ * level defines how many of the candidate slots are assigned and in how
+ * many superframes they range. Unused slots are released so their timers
+ * never fire, and a stationary tag stops following ccp and puts the radio
+ * in deep sleep until motion is seen again.
+ */
+
+#ifndef _RNG_SCHED_H_
+#define _RNG_SCHED_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stats/stats.h>
+#include <dpl/dpl.h>
+#include <uwb/uwb.h>
+#include <tdma/tdma.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if MYNEWT_VAL(RNG_SCHED_STATS)
+STATS_SECT_START(rng_sched_stat_section)
+    STATS_SECT_ENTRY(level_change)
+    STATS_SECT_ENTRY(slot_assign)
+    STATS_SECT_ENTRY(slot_release)
+    STATS_SECT_ENTRY(ranges)
+    STATS_SECT_ENTRY(ranges_skipped)
+    STATS_SECT_ENTRY(fixed_rate_ranges)
+    STATS_SECT_ENTRY(sleep)
+    STATS_SECT_ENTRY(wakeup)
+STATS_SECT_END
+#define RNG_SCHED_STATS_INC(__X) STATS_INC(sched->stat, __X)
+#define RNG_SCHED_STATS_INCN(__X, __N) STATS_INCN(sched->stat, __X, __N)
+#else
+#define RNG_SCHED_STATS_INC(__X) {}
+#define RNG_SCHED_STATS_INCN(__X, __N) {}
+#endif
+
+//! Motion levels, ordered by ranging demand
+typedef enum _rng_sched_level_t{
+    RNG_SCHED_STATIONARY = 0,        //!< No ranging, radio asleep
+    RNG_SCHED_SLOW,                  //!< Moving slowly with a converged position
+    RNG_SCHED_MOVING,                //!< Normal motion
+    RNG_SCHED_FAST,                  //!< Fast motion or uncertain position
+    RNG_SCHED_NLEVELS
+}rng_sched_level_t;
+
+//! Slot usage of one motion level
+struct rng_sched_level_config{
+    uint16_t nslots;                 //!< Candidate slots assigned, 0 releases all
+    uint16_t decimation;             //!< Range in every n-th superframe
+};
+
+//! Scheduler status
+typedef struct _rng_sched_status_t{
+    uint16_t selfmalloc:1;           //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;          //!< Instance allocated
+    uint16_t sleeping:1;             //!< Radio put in deep sleep by the scheduler
+    uint16_t motion_valid:1;         //!< Motion statistics seeded
+}rng_sched_status_t;
+
+struct fusion_instance;
+
+//! Scheduler instance
+struct rng_sched_instance{
+    tdma_instance_t * tdma;                     //!< Tdma instance owning the slots
+    struct fusion_instance * fusion;            //!< Optional tracker for position std
+#if MYNEWT_VAL(RNG_SCHED_STATS)
+    STATS_SECT_DECL(rng_sched_stat_section) stat; //!< Stats instance
+#endif
+    rng_sched_status_t status;                  //!< Status
+    rng_sched_level_t level;                    //!< Level currently applied
+    rng_sched_level_t target;                   //!< Level requested by the motion estimate
+    struct rng_sched_level_config levels[RNG_SCHED_NLEVELS]; //!< Slot usage per level
+    uint16_t slots[MYNEWT_VAL(RNG_SCHED_MAX_SLOTS)];         //!< Candidate slots, priority order
+    uint16_t ncandidates;                       //!< Number of candidate slots
+    uint16_t nassigned;                         //!< Candidate slots currently assigned
+    dpl_event_fn * slot_cb;                     //!< Application slot callback
+    void * slot_arg;                            //!< Application slot argument
+    struct dpl_event apply_event;               //!< Applies level changes in the tdma task
+    float acc_mean;                             //!< Running mean of accel magnitude, m/s^2
+    float acc_var;                              //!< Running variance of accel magnitude
+    float pos_std;                              //!< Position std if no tracker is attached, m
+    uint32_t last_motion;                       //!< Cputime motion was last seen
+    uint32_t level_start;                       //!< Cputime the current level was entered
+    uint32_t level_usecs[RNG_SCHED_NLEVELS];    //!< Time spent per level, usec
+    uint8_t seq_num;                            //!< Last superframe seen by rng_sched_should_range
+};
+
+struct rng_sched_instance * rng_sched_init(struct rng_sched_instance * sched, tdma_instance_t * tdma);
+void rng_sched_free(struct rng_sched_instance * sched);
+int rng_sched_set_slots(struct rng_sched_instance * sched, const uint16_t slots[], uint16_t nslots,
+        dpl_event_fn * slot_cb, void * slot_arg);
+void rng_sched_set_level_config(struct rng_sched_instance * sched, rng_sched_level_t level,
+        struct rng_sched_level_config * config);
+void rng_sched_set_fusion(struct rng_sched_instance * sched, struct fusion_instance * fusion);
+void rng_sched_set_position_std(struct rng_sched_instance * sched, float pos_std);
+void rng_sched_imu_sample(struct rng_sched_instance * sched, float acc[]);
+void rng_sched_motion_event(struct rng_sched_instance * sched);
+void rng_sched_update(struct rng_sched_instance * sched);
+bool rng_sched_should_range(struct rng_sched_instance * sched, uint16_t idx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RNG_SCHED_H_ */
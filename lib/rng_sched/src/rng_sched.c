@@ -0,0 +1,398 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file rng_sched.c
+ * @brief Motion adaptive ranging rate scheduler
+ *
+ * @details Motion is estimated from the running variance of the
+ * accelerometer magnitude, which is insensitive to orientation and needs no
+ * gravity compensation. Level changes are computed in the caller's context
+ * but applied through an event on the tdma task queue so slot assignment
+ * never races the slot callbacks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <os/os.h>
+#include <stats/stats.h>
+#include <uwb_ccp/uwb_ccp.h>
+#include <rng_sched/rng_sched.h>
+#if MYNEWT_VAL(FUSION_ENABLED)
+#include <fusion/fusion.h>
+#endif
+
+#if MYNEWT_VAL(RNG_SCHED_STATS)
+STATS_NAME_START(rng_sched_stat_section)
+    STATS_NAME(rng_sched_stat_section, level_change)
+    STATS_NAME(rng_sched_stat_section, slot_assign)
+    STATS_NAME(rng_sched_stat_section, slot_release)
+    STATS_NAME(rng_sched_stat_section, ranges)
+    STATS_NAME(rng_sched_stat_section, ranges_skipped)
+    STATS_NAME(rng_sched_stat_section, fixed_rate_ranges)
+    STATS_NAME(rng_sched_stat_section, sleep)
+    STATS_NAME(rng_sched_stat_section, wakeup)
+STATS_NAME_END(rng_sched_stat_section)
+#endif
+
+static const struct rng_sched_level_config g_rng_sched_levels_default[RNG_SCHED_NLEVELS] = {
+    [RNG_SCHED_STATIONARY] = {.nslots = 0, .decimation = 1},
+    [RNG_SCHED_SLOW] = {.nslots = 1, .decimation = 8},
+    [RNG_SCHED_MOVING] = {.nslots = 1, .decimation = 1},
+    [RNG_SCHED_FAST] = {.nslots = MYNEWT_VAL(RNG_SCHED_MAX_SLOTS), .decimation = 1},
+};
+
+static void rng_sched_apply_cb(struct dpl_event * ev);
+
+/**
+ * @fn rng_sched_init(struct rng_sched_instance * sched, tdma_instance_t * tdma)
+ * @brief Allocate and initialise a scheduler on top of a tdma instance.
+ *
+ * @param sched  Pointer to struct rng_sched_instance, NULL to allocate.
+ * @param tdma   Pointer to tdma_instance_t.
+ *
+ * @return struct rng_sched_instance *
+ */
+struct rng_sched_instance *
+rng_sched_init(struct rng_sched_instance * sched, tdma_instance_t * tdma)
+{
+    assert(tdma);
+
+    if (sched == NULL) {
+        sched = (struct rng_sched_instance *) malloc(sizeof(struct rng_sched_instance));
+        assert(sched);
+        memset(sched, 0, sizeof(struct rng_sched_instance));
+        sched->status.selfmalloc = 1;
+    }
+    sched->tdma = tdma;
+    memcpy(sched->levels, g_rng_sched_levels_default, sizeof(sched->levels));
+    sched->level = sched->target = RNG_SCHED_MOVING;
+    sched->pos_std = 0.5f*(MYNEWT_VAL(RNG_SCHED_STD_LOW) + MYNEWT_VAL(RNG_SCHED_STD_HIGH));
+    sched->last_motion = sched->level_start = os_cputime_get32();
+    dpl_event_init(&sched->apply_event, rng_sched_apply_cb, (void *) sched);
+
+#if MYNEWT_VAL(RNG_SCHED_STATS)
+    if (!sched->status.initialized) {
+        int rc = stats_init(
+                    STATS_HDR(sched->stat),
+                    STATS_SIZE_INIT_PARMS(sched->stat, STATS_SIZE_32),
+                    STATS_NAME_INIT_PARMS(rng_sched_stat_section)
+            );
+        rc |= stats_register("rng_sched", STATS_HDR(sched->stat));
+        assert(rc == 0);
+    }
+#endif
+    sched->status.initialized = 1;
+    return sched;
+}
+
+/**
+ * @fn rng_sched_free(struct rng_sched_instance * sched)
+ * @brief Release all slots held by the scheduler and free the instance.
+ *
+ * @param sched  Pointer to struct rng_sched_instance.
+ *
+ * @return void
+ */
+void
+rng_sched_free(struct rng_sched_instance * sched)
+{
+    assert(sched);
+    for (uint16_t i = 0; i < sched->nassigned; i++) {
+        tdma_release_slot(sched->tdma, sched->slots[i]);
+    }
+    sched->nassigned = 0;
+    if (sched->status.selfmalloc) {
+        free(sched);
+    } else {
+        sched->status.initialized = 0;
+    }
+}
+
+/**
+ * @fn rng_sched_set_slots(struct rng_sched_instance * sched, const uint16_t slots[], uint16_t nslots,
+ *        dpl_event_fn * slot_cb, void * slot_arg)
+ * @brief Hand over the candidate slots of this tag. The slot callback should
+ * call rng_sched_should_range() before ranging.
+ *
+ * @param sched     Pointer to struct rng_sched_instance.
+ * @param slots     Candidate slot indexes, highest priority first.
+ * @param nslots    Number of candidate slots.
+ * @param slot_cb   Slot callback as passed to tdma_assign_slot.
+ * @param slot_arg  Slot argument as passed to tdma_assign_slot.
+ *
+ * @return OS_OK, OS_EINVAL if there are too many slots.
+ */
+int
+rng_sched_set_slots(struct rng_sched_instance * sched, const uint16_t slots[], uint16_t nslots,
+        dpl_event_fn * slot_cb, void * slot_arg)
+{
+    if (nslots > MYNEWT_VAL(RNG_SCHED_MAX_SLOTS)) {
+        return OS_EINVAL;
+    }
+    for (uint16_t i = 0; i < sched->nassigned; i++) {
+        tdma_release_slot(sched->tdma, sched->slots[i]);
+        RNG_SCHED_STATS_INC(slot_release);
+    }
+    sched->nassigned = 0;
+    memcpy(sched->slots, slots, nslots * sizeof(uint16_t));
+    sched->ncandidates = nslots;
+    sched->slot_cb = slot_cb;
+    sched->slot_arg = slot_arg;
+    dpl_eventq_put(&sched->tdma->eventq, &sched->apply_event);
+    return OS_OK;
+}
+
+/**
+ * @fn rng_sched_set_level_config(struct rng_sched_instance * sched, rng_sched_level_t level,
+ *        struct rng_sched_level_config * config)
+ * @brief Override the slot usage of one motion level.
+ *
+ * @return void
+ */
+void
+rng_sched_set_level_config(struct rng_sched_instance * sched, rng_sched_level_t level,
+        struct rng_sched_level_config * config)
+{
+    assert(level < RNG_SCHED_NLEVELS);
+    sched->levels[level] = *config;
+    if (sched->levels[level].decimation == 0) {
+        sched->levels[level].decimation = 1;
+    }
+    if (level == sched->level) {
+        dpl_eventq_put(&sched->tdma->eventq, &sched->apply_event);
+    }
+}
+
+/**
+ * @fn rng_sched_set_fusion(struct rng_sched_instance * sched, struct fusion_instance * fusion)
+ * @brief Take the position uncertainty from a fusion tracker.
+ *
+ * @return void
+ */
+void
+rng_sched_set_fusion(struct rng_sched_instance * sched, struct fusion_instance * fusion)
+{
+    sched->fusion = fusion;
+}
+
+/**
+ * @fn rng_sched_set_position_std(struct rng_sched_instance * sched, float pos_std)
+ * @brief Position uncertainty from another source than lib/fusion.
+ *
+ * @param sched    Pointer to struct rng_sched_instance.
+ * @param pos_std  Position std deviation, m.
+ *
+ * @return void
+ */
+void
+rng_sched_set_position_std(struct rng_sched_instance * sched, float pos_std)
+{
+    sched->pos_std = pos_std;
+}
+
+static float
+rng_sched_position_std(struct rng_sched_instance * sched)
+{
+#if MYNEWT_VAL(FUSION_ENABLED)
+    if (sched->fusion) {
+        return fusion_get_position_std(sched->fusion);
+    }
+#endif
+    return sched->pos_std;
+}
+
+/**
+ * @fn rng_sched_imu_sample(struct rng_sched_instance * sched, float acc[])
+ * @brief Feed an accelerometer sample, m/s^2. Any rate from a few Hz works,
+ * samples from an imu fifo batch can be fed back to back.
+ *
+ * @param sched  Pointer to struct rng_sched_instance.
+ * @param acc    Accelerometer x,y,z.
+ *
+ * @return void
+ */
+void
+rng_sched_imu_sample(struct rng_sched_instance * sched, float acc[])
+{
+    float m = sqrtf(acc[0]*acc[0] + acc[1]*acc[1] + acc[2]*acc[2]);
+
+    if (!sched->status.motion_valid) {
+        sched->acc_mean = m;
+        sched->acc_var = 0;
+        sched->status.motion_valid = 1;
+    } else {
+        /* Exponentially weighted mean and variance, alpha = 1/16 */
+        float d = m - sched->acc_mean;
+        sched->acc_mean += d * (1.0f/16);
+        sched->acc_var = (15.0f/16) * (sched->acc_var + d * d * (1.0f/16));
+    }
+    rng_sched_update(sched);
+}
+
+/**
+ * @fn rng_sched_motion_event(struct rng_sched_instance * sched)
+ * @brief Wake-on-motion interrupt, leaves the stationary level immediately.
+ *
+ * @return void
+ */
+void
+rng_sched_motion_event(struct rng_sched_instance * sched)
+{
+    float still = MYNEWT_VAL(RNG_SCHED_STILL_THRESH);
+
+    sched->last_motion = os_cputime_get32();
+    if (sched->acc_var < 4.0f * still * still) {
+        sched->acc_var = 4.0f * still * still;
+    }
+    rng_sched_update(sched);
+}
+
+/**
+ * @fn rng_sched_update(struct rng_sched_instance * sched)
+ * @brief Re-evaluate the motion level, called from rng_sched_imu_sample and
+ * from the slot callbacks. Changes are applied in the tdma task.
+ *
+ * @return void
+ */
+void
+rng_sched_update(struct rng_sched_instance * sched)
+{
+    float acc_std = sqrtf(sched->acc_var);
+    float pos_std = rng_sched_position_std(sched);
+    uint32_t now = os_cputime_get32();
+    rng_sched_level_t target;
+
+    if (acc_std > MYNEWT_VAL(RNG_SCHED_STILL_THRESH)) {
+        sched->last_motion = now;
+    }
+
+    if (os_cputime_ticks_to_usecs(now - sched->last_motion) >
+        MYNEWT_VAL(RNG_SCHED_STILL_TIMEOUT) * 1000UL) {
+        target = RNG_SCHED_STATIONARY;
+    } else if (acc_std > MYNEWT_VAL(RNG_SCHED_FAST_THRESH) || pos_std > MYNEWT_VAL(RNG_SCHED_STD_HIGH)) {
+        target = RNG_SCHED_FAST;
+    } else if (pos_std < MYNEWT_VAL(RNG_SCHED_STD_LOW) &&
+               acc_std < 2.0f * MYNEWT_VAL(RNG_SCHED_STILL_THRESH)) {
+        target = RNG_SCHED_SLOW;
+    } else {
+        target = RNG_SCHED_MOVING;
+    }
+
+    sched->target = target;
+    if (target != sched->level) {
+        dpl_eventq_put(&sched->tdma->eventq, &sched->apply_event);
+    }
+}
+
+/**
+ * @fn rng_sched_apply_cb(struct dpl_event * ev)
+ * @brief Assign or release candidate slots for the target level and
+ * handle deep sleep. Runs in the tdma task.
+ */
+static void
+rng_sched_apply_cb(struct dpl_event * ev)
+{
+    struct rng_sched_instance * sched = (struct rng_sched_instance *) dpl_event_get_arg(ev);
+    tdma_instance_t * tdma = sched->tdma;
+    struct uwb_ccp_instance * ccp = tdma->ccp;
+    rng_sched_level_t level = sched->target;
+    uint32_t now = os_cputime_get32();
+    uint32_t usecs = os_cputime_ticks_to_usecs(now - sched->level_start);
+    uint16_t i, n;
+
+    sched->level_usecs[sched->level] += usecs;
+    sched->level_start = now;
+
+    if (sched->status.sleeping && level != RNG_SCHED_STATIONARY) {
+        uwb_wakeup(tdma->dev_inst);
+        uwb_ccp_start(ccp, CCP_ROLE_SLAVE);
+        sched->status.sleeping = 0;
+        RNG_SCHED_STATS_INC(wakeup);
+        /* A fixed rate tag would have ranged in every superframe slept through */
+        if (ccp->period) {
+            RNG_SCHED_STATS_INCN(fixed_rate_ranges, sched->ncandidates *
+                (usecs / uwb_dwt_usecs_to_usecs(ccp->period)));
+        }
+    }
+
+    n = sched->levels[level].nslots;
+    if (n > sched->ncandidates) {
+        n = sched->ncandidates;
+    }
+    for (i = 0; i < sched->ncandidates; i++) {
+        if (i < n && i >= sched->nassigned) {
+            tdma_assign_slot(tdma, sched->slot_cb, sched->slots[i], sched->slot_arg);
+            RNG_SCHED_STATS_INC(slot_assign);
+        } else if (i >= n && i < sched->nassigned) {
+            tdma_release_slot(tdma, sched->slots[i]);
+            RNG_SCHED_STATS_INC(slot_release);
+        }
+    }
+    sched->nassigned = n;
+
+#if MYNEWT_VAL(RNG_SCHED_DEEP_SLEEP)
+    if (level == RNG_SCHED_STATIONARY && !sched->status.sleeping) {
+        uwb_ccp_stop(ccp);
+        uwb_sleep_config(tdma->dev_inst);
+        uwb_enter_sleep(tdma->dev_inst);
+        sched->status.sleeping = 1;
+        RNG_SCHED_STATS_INC(sleep);
+    }
+#endif
+
+    if (level != sched->level) {
+        RNG_SCHED_STATS_INC(level_change);
+        sched->level = level;
+    }
+}
+
+/**
+ * @fn rng_sched_should_range(struct rng_sched_instance * sched, uint16_t idx)
+ * @brief Called from the slot callback, returns false for superframes the
+ * current level skips. Tags using the same decimation are spread over the
+ * superframes by their slot index.
+ *
+ * @param sched  Pointer to struct rng_sched_instance.
+ * @param idx    Slot index of the callback.
+ *
+ * @return true if the slot should be used for ranging.
+ */
+bool
+rng_sched_should_range(struct rng_sched_instance * sched, uint16_t idx)
+{
+    struct uwb_ccp_instance * ccp = sched->tdma->ccp;
+    uint16_t decimation = sched->levels[sched->level].decimation;
+
+    if (ccp->seq_num != sched->seq_num) {
+        sched->seq_num = ccp->seq_num;
+        RNG_SCHED_STATS_INCN(fixed_rate_ranges, sched->ncandidates);
+        rng_sched_update(sched);
+    }
+
+    if (decimation > 1 && (uint16_t)(ccp->seq_num + idx) % decimation) {
+        RNG_SCHED_STATS_INC(ranges_skipped);
+        return false;
+    }
+    RNG_SCHED_STATS_INC(ranges);
+    return true;
+}
@@ -36,6 +36,9 @@
 #include <uwb_ccp/uwb_ccp.h>
 #endif
 #include <uwb_rng/slots.h>
+#if MYNEWT_VAL(UWB_XCS_ENABLED)
+#include <uwb_xcs/uwb_xcs.h>
+#endif
 
 #if MYNEWT_VAL(RTDOA_STATS)
 STATS_NAME_START(rtdoa_stat_section)
@@ -251,6 +254,19 @@ rtdoa_tdoa_between_frames(struct rtdoa_instance *rtdoa,
         case DWT_RTDOA_RESP: {
             /* Invalidate this frame to avoid it being used more than once */
             resp_frame->code = DWT_TWR_INVALID;
+#if MYNEWT_VAL(UWB_XCS_ENABLED)
+            /* Response from an anchor of another cell, onto the master timeline of the request */
+            struct uwb_xcs_instance * xcs = uwb_xcs_get_instance(rtdoa->dev_inst);
+            uint64_t req_euid, resp_euid;
+            if (xcs && !uwb_xcs_get_member(xcs, req_frame->src_address, &req_euid)
+                && !uwb_xcs_get_member(xcs, resp_frame->src_address, &resp_euid) && req_euid != resp_euid) {
+                uint64_t tx_ts;
+                if (uwb_xcs_convert(xcs, resp_euid, req_euid, resp_frame->tx_timestamp, &tx_ts)) {
+                    break;
+                }
+                resp_frame->tx_timestamp = tx_ts;
+            }
+#endif
 
             if (resp_frame->tx_timestamp < req_frame->tx_timestamp) {
                 break;
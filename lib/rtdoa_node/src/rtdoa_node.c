@@ -37,6 +37,9 @@
 #include <rtdoa_node/rtdoa_node.h>
 #include <dsp/polyval.h>
 #include <uwb_rng/slots.h>
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+#include <uwb_sec/uwb_sec.h>
+#endif
 
 #define WCS_DTU MYNEWT_VAL(WCS_DTU)
 
@@ -136,8 +139,12 @@ rtdoa_request(struct rtdoa_instance *rtdoa, uint64_t delay)
     /* Also set the local rx_timestamp to allow us to also transmit in the next part */
     rtdoa->req_frame->rx_timestamp = frame->tx_timestamp;
 
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+    uwb_sec_write_tx(inst, frame->array, sizeof(rtdoa_request_frame_t));
+#else
     uwb_write_tx(inst, frame->array, 0, sizeof(rtdoa_request_frame_t));
     uwb_write_tx_fctrl(inst, sizeof(rtdoa_request_frame_t), 0);
+#endif
     uwb_set_wait4resp(inst, false);
 
     if (uwb_start_tx(inst).start_tx_error) {
@@ -189,8 +196,12 @@ tx_rtdoa_response(struct rtdoa_instance * rtdoa)
                                                   inst->tx_antenna_delay,
                                                   rtdoa->req_frame);
 
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+    uwb_sec_write_tx(inst, frame->array, sizeof(rtdoa_response_frame_t));
+#else
     uwb_write_tx(inst, frame->array, 0, sizeof(rtdoa_response_frame_t));
     uwb_write_tx_fctrl(inst, sizeof(rtdoa_response_frame_t), 0);
+#endif
     uwb_set_wait4resp(inst, false);
 
     if (uwb_start_tx(inst).start_tx_error) {
@@ -376,8 +387,12 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
                     tx_timestamp += inst->tx_antenna_delay;
 
                     tx_frame.tx_timestamp = rtdoa_local_to_master64(inst, tx_timestamp, rtdoa->req_frame);
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+                    uwb_sec_write_tx(inst, tx_frame.array, sizeof(tx_frame));
+#else
                     uwb_write_tx_fctrl(inst, sizeof(tx_frame), 0);
                     uwb_write_tx(inst, tx_frame.array, 0, sizeof(tx_frame));
+#endif
                     if (uwb_start_tx(inst).start_tx_error) {
                         RTDOA_STATS_INC(tx_relay_error);
                         if(os_sem_get_count(&rtdoa->sem) == 0){
@@ -23,7 +23,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <uwb_rng/uwb_rng.h>
-#include <json/json.h>
+#include <json_stream/json_stream.h>
 #include <nrng/nrng_encode.h>
 #include <survey/survey_encode.h>
 
@@ -31,33 +31,11 @@
 
 #define JSON_BUF_SIZE (1024)
 static char _buf[JSON_BUF_SIZE];
-static uint16_t idx=0;
-
-static void
-json_fflush(){
-    _buf[idx] = '\0';
-    printf("%s\n", _buf);
-    idx=0;
-}
-
-static void
-_json_fflush(){
-    _buf[idx] = '\0';
-    printf("%s", _buf);
-    idx=0;
-}
+static struct json_stream _js;
 
 static int
-json_write(void *buf, char* data, int len) {
-
-    if (idx + len > JSON_BUF_SIZE) 
-        _json_fflush();
-
-    for (uint16_t i=0; i< len; i++)
-        _buf[i+idx] = data[i];
-    idx+=len;
-
-    return len;
+json_fflush(void * arg, const char * data, uint16_t len){
+    return fwrite(data, 1, len, stdout);
 }
 
 /**
@@ -70,9 +48,7 @@ json_write(void *buf, char* data, int len) {
 void 
 survey_encode(survey_instance_t * survey, uint16_t seq, uint16_t idx){
  
-    struct json_encoder encoder;
-    struct json_value value;
-    int rc;
+    struct json_stream * js = &_js;
     uint32_t utime = os_cputime_ticks_to_usecs(os_cputime_get32());
     survey_nrngs_t * nrngs = survey->nrngs[idx%survey->nframes];
 
@@ -87,54 +63,41 @@ survey_encode(survey_instance_t * survey, uint16_t seq, uint16_t idx){
     survey->status.empty = NumberOfBits(mask) == 0;
     if (survey->status.empty)
        return;
-       
-    /* reset the state of the internal test */
-    memset(&encoder, 0, sizeof(encoder));
-    encoder.je_write = json_write;
-    encoder.je_arg= NULL;
 
-    rc = json_encode_object_start(&encoder); 
-    JSON_VALUE_INT(&value,  utime);
-    rc |= json_encode_object_entry(&encoder, "utime", &value);   
-    rc |= json_encode_object_key(&encoder, "survey");
-    rc |= json_encode_object_start(&encoder);    
-  
-    JSON_VALUE_UINT(&value, seq);
-    rc |= json_encode_object_entry(&encoder, "seq", &value);
-    
-    JSON_VALUE_UINT(&value, mask);
-    rc |= json_encode_object_entry(&encoder, "mask", &value);
-    rc |= json_encode_object_key(&encoder, "nrngs");
-    rc |= json_encode_array_start(&encoder);
-   
+    if (js->buf == NULL)
+        json_stream_init(js, _buf, sizeof(_buf), json_fflush, NULL);
+
+    json_stream_record_start(js);
+    json_stream_object_start(js);
+    json_stream_key(js, "utime");
+    json_stream_int(js, utime);
+    json_stream_key(js, "survey");
+    json_stream_object_start(js);
+    json_stream_key(js, "seq");
+    json_stream_uint(js, seq);
+    json_stream_key(js, "mask");
+    json_stream_uint(js, mask);
+    json_stream_key(js, "nrngs");
+    json_stream_array_start(js);
+
     for (uint16_t i=0; i < survey->nnodes; i++){
         if (nrngs->nrng[i]->mask){
-            JSON_VALUE_UINT(&value, nrngs->nrng[i]->mask);
-             rc |= json_encode_object_start(&encoder); 
-            rc |= json_encode_object_entry(&encoder, "mask", &value);
-            rc |= json_encode_array_name(&encoder, "nrng");
-            rc |= json_encode_array_start(&encoder);
+            json_stream_object_start(js);
+            json_stream_key(js, "mask");
+            json_stream_uint(js, nrngs->nrng[i]->mask);
+            json_stream_key(js, "nrng");
+            json_stream_array_start(js);
             for (uint16_t j=0; j < NumberOfBits(nrngs->nrng[i]->mask); j++){
-#if MYNEWT_VAL(FLOAT_USER)
-                char float_string[16];
-                sprintf(float_string,"%f",nrngs->nrng[i]->rng[j]);
-                JSON_VALUE_STRING(&value, float_string);
-#else
-                JSON_VALUE_UINT(&value, *(uint32_t *)&nrngs->nrng[i]->rng[j]);
-#endif
-                rc |= json_encode_array_value(&encoder, &value); 
+                json_stream_float(js, nrngs->nrng[i]->rng[j]);
             }
-            rc |= json_encode_array_finish(&encoder); 
-            rc |= json_encode_object_finish(&encoder);
+            json_stream_array_finish(js);
+            json_stream_object_finish(js);
         }
     }
-    rc |= json_encode_array_finish(&encoder);  
-    rc |= json_encode_object_finish(&encoder);
-    rc |= json_encode_object_finish(&encoder);
-    assert(rc == 0);
-    json_fflush();
+    json_stream_array_finish(js);
+    json_stream_object_finish(js);
+    json_stream_object_finish(js);
+    json_stream_record_end(js);
 }
 
 #endif
-
-
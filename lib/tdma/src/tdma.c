@@ -282,7 +282,9 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
     tdma_instance_t * tdma = (tdma_instance_t*)cbs->inst_ptr;
     struct uwb_ccp_instance *ccp = tdma->ccp;
 
-    if (ccp->status.valid && inst->fctrl_array[0] == FCNTL_IEEE_BLINK_CCP_64){
+    /* Only blinks of our own master start a superframe, neighbouring cells are heard too */
+    if (ccp->status.valid && inst->fctrl_array[0] == FCNTL_IEEE_BLINK_CCP_64
+        && ((uwb_ccp_blink_frame_t *)inst->rxbuf)->euid == ccp->master_euid){
         TDMA_STATS_INC(rx_complete);
         DIAGMSG("{\"utime\": %lu,\"msg\": \"tdma:rx_complete_cb\"}\n",os_cputime_ticks_to_usecs(os_cputime_get32()));
         if (tdma != NULL && tdma->status.initialized){
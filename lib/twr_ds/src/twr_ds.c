@@ -44,6 +44,9 @@
 #if MYNEWT_VAL(UWB_WCS_ENABLED)
 #include <uwb_wcs/uwb_wcs.h>
 #endif
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+#include <uwb_sec/uwb_sec.h>
+#endif
 
 #if MYNEWT_VAL(RNG_VERBOSE)
 #define DIAGMSG(s,u) printf(s,u)
@@ -255,8 +258,16 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
 #endif
                 frame->code = DWT_DS_TWR_T1;
 
+#if MYNEWT_VAL(RNG_SESSIONS)
+                // The session scheduler programs the response once the radio is free for it
+                struct uwb_dev_status status = uwb_rng_session_tx(rng, frame, sizeof(ieee_rng_response_frame_t), response_tx_delay);
+#else
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+                uwb_sec_write_tx(inst, frame->array, sizeof(ieee_rng_response_frame_t));
+#else
                 uwb_write_tx(inst, frame->array, 0, sizeof(ieee_rng_response_frame_t));
                 uwb_write_tx_fctrl(inst, sizeof(ieee_rng_response_frame_t), 0);
+#endif
                 uwb_set_wait4resp(inst, true); 
 
                 uint16_t frame_duration = uwb_phy_frame_duration(inst,sizeof(ieee_rng_response_frame_t));
@@ -268,8 +279,9 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
                 uwb_set_rx_timeout(inst,  frame_duration + g_config.tx_holdoff_delay + g_config.rx_timeout_delay);
                 // Disable default behavor, do not RXENAB on RXFCG thereby avoiding rx timeout events  
                 uwb_set_rxauto_disable(inst, true);
-
-                if (uwb_start_tx(inst).start_tx_error){
+                struct uwb_dev_status status = uwb_start_tx(inst);
+#endif
+                if (status.start_tx_error){
                     STATS_INC(g_stat, start_tx_error);
                     dpl_sem_release(&rng->sem);  
                     if (cbs!=NULL && cbs->start_tx_error_cb) 
@@ -318,8 +330,12 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
                 frame->reception_timestamp =  (uint32_t) (request_timestamp & 0xFFFFFFFFUL);
                 frame->transmission_timestamp =  (uint32_t) (response_timestamp & 0xFFFFFFFFUL);
 
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+                uwb_sec_write_tx(inst, frame->array, sizeof(twr_frame_final_t));
+#else
                 uwb_write_tx(inst, frame->array, 0, sizeof(twr_frame_final_t));
                 uwb_write_tx_fctrl(inst, sizeof(twr_frame_final_t), 0);
+#endif
                 uwb_set_wait4resp(inst, true);
 
                 // The wait for response counter starts on the completion of the entire outgoing frame. 
@@ -359,7 +375,12 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
                 previous_frame->response_timestamp = frame->response_timestamp;
 
                 uint64_t request_timestamp = inst->rxtimestamp;
+#if MYNEWT_VAL(RNG_SESSIONS)
+                // Other sessions may have transmitted since, the response sent is in the session frame
+                frame->request_timestamp = previous_frame->transmission_timestamp;
+#else
                 frame->request_timestamp = uwb_read_txtime_lo32(inst);   // This corresponds to when the original request was actually sent
+#endif
                 frame->response_timestamp = (uint32_t) (request_timestamp & 0xFFFFFFFFUL);  // This corresponds to the response just received       
 
                 frame->dst_address = frame->src_address;
@@ -372,12 +393,20 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
                 frame->code = DWT_DS_TWR_FINAL;
 
                 // Transmit timestamp final report
-                uwb_write_tx(inst, frame->array, 0, sizeof(twr_frame_final_t));
-                uwb_write_tx_fctrl(inst, sizeof(twr_frame_final_t), 0); 
                 uint64_t final_tx_delay = inst->rxtimestamp + ((uint64_t) g_config.tx_holdoff_delay << 16);
+#if MYNEWT_VAL(RNG_SESSIONS)
+                struct uwb_dev_status status = uwb_rng_session_tx(rng, frame, sizeof(twr_frame_final_t), final_tx_delay);
+#else
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+                uwb_sec_write_tx(inst, frame->array, sizeof(twr_frame_final_t));
+#else
+                uwb_write_tx(inst, frame->array, 0, sizeof(twr_frame_final_t));
+                uwb_write_tx_fctrl(inst, sizeof(twr_frame_final_t), 0);
+#endif
                 uwb_set_delay_start(inst, final_tx_delay);
-
-                if (uwb_start_tx(inst).start_tx_error){
+                struct uwb_dev_status status = uwb_start_tx(inst);
+#endif
+                if (status.start_tx_error){
                     STATS_INC(g_stat, start_tx_error);
                     dpl_sem_release(&rng->sem);  
                     if (cbs!=NULL && cbs->start_tx_error_cb) 
@@ -289,6 +289,10 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
 #endif
                 frame->code = DWT_DS_TWR_EXT_T1;
 
+#if MYNEWT_VAL(RNG_SESSIONS)
+                // The session scheduler programs the response once the radio is free for it
+                struct uwb_dev_status status = uwb_rng_session_tx(rng, frame, sizeof(ieee_rng_response_frame_t), response_tx_delay);
+#else
                 uwb_write_tx(inst, frame->array, 0, sizeof(ieee_rng_response_frame_t));
                 uwb_write_tx_fctrl(inst, sizeof(ieee_rng_response_frame_t), 0);
                 uwb_set_wait4resp(inst, true);    
@@ -302,8 +306,9 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
                 uwb_set_rx_timeout(inst,  frame_duration + g_config.tx_holdoff_delay + g_config.rx_timeout_delay);
                 // Disable default behavor, do not RXENAB on RXFCG thereby avoiding rx timeout events  
                 uwb_set_rxauto_disable(inst, true);
-
-                if (uwb_start_tx(inst).start_tx_error){
+                struct uwb_dev_status status = uwb_start_tx(inst);
+#endif
+                if (status.start_tx_error){
                     dpl_sem_release(&rng->sem);
                     if (cbs!=NULL && cbs->start_tx_error_cb) 
                         cbs->start_tx_error_cb(inst, cbs);
@@ -387,7 +392,12 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
                 previous_frame->response_timestamp = frame->response_timestamp;
 
                 uint64_t request_timestamp = inst->rxtimestamp;
+#if MYNEWT_VAL(RNG_SESSIONS)
+                // Other sessions may have transmitted since, the response sent is in the session frame
+                frame->request_timestamp = previous_frame->transmission_timestamp;
+#else
                 frame->request_timestamp = uwb_read_txtime_lo32(inst);   // This corresponds to when the original request was actually sent
+#endif
                 frame->response_timestamp = (uint32_t) (request_timestamp & 0xFFFFFFFFUL);  // This corresponds to the response just received       
                 
                 frame->dst_address = frame->src_address;
@@ -404,12 +414,16 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
                     cbs->final_cb(inst, cbs);    
               
                 // Transmit timestamp final report
+                uint64_t final_tx_delay = inst->rxtimestamp + ((uint64_t) g_config.tx_holdoff_delay << 16);
+#if MYNEWT_VAL(RNG_SESSIONS)
+                struct uwb_dev_status status = uwb_rng_session_tx(rng, frame, sizeof(twr_frame_t), final_tx_delay);
+#else
                 uwb_write_tx(inst, frame->array, 0, sizeof(twr_frame_t));
                 uwb_write_tx_fctrl(inst, sizeof(twr_frame_t), 0);
-                uint64_t final_tx_delay = inst->rxtimestamp + ((uint64_t) g_config.tx_holdoff_delay << 16);
                 uwb_set_delay_start(inst, final_tx_delay);
-
-                if (uwb_start_tx(inst).start_tx_error){
+                struct uwb_dev_status status = uwb_start_tx(inst);
+#endif
+                if (status.start_tx_error){
                     dpl_sem_release(&rng->sem);
                     if (cbs!=NULL && cbs->start_tx_error_cb) 
                         cbs->start_tx_error_cb(inst, cbs);
@@ -46,6 +46,9 @@
 #if MYNEWT_VAL(UWB_WCS_ENABLED)
 #include <uwb_wcs/uwb_wcs.h>
 #endif
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+#include <uwb_sec/uwb_sec.h>
+#endif
 
 #if MYNEWT_VAL(RNG_VERBOSE)
 #define DIAGMSG(s,u) printf(s,u)
@@ -267,9 +270,17 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
 #else
                 frame->carrier_integrator  = - inst->carrier_integrator;
 #endif
+#if MYNEWT_VAL(RNG_SESSIONS)
+                // The session scheduler programs the response once the radio is free for it
+                struct uwb_dev_status status = uwb_rng_session_tx(rng, frame, sizeof(ieee_rng_response_frame_t), response_tx_delay);
+#else
                 // Write the second part of the response
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+                uwb_sec_write_tx(inst, frame->array, sizeof(ieee_rng_response_frame_t));
+#else
                 uwb_write_tx(inst, frame->array ,0 ,sizeof(ieee_rng_response_frame_t));
                 uwb_write_tx_fctrl(inst, sizeof(ieee_rng_response_frame_t), 0);
+#endif
                 uwb_set_wait4resp(inst, true); 
                  
                 uint16_t frame_duration = uwb_phy_frame_duration(inst,sizeof(ieee_rng_response_frame_t));
@@ -281,8 +292,9 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
 
                 // Disable default behavor, do not RXENAB on RXFCG thereby avoiding rx timeout events on sucess  
                 uwb_set_rxauto_disable(inst, true);
-
-                if (uwb_start_tx(inst).start_tx_error){
+                struct uwb_dev_status status = uwb_start_tx(inst);
+#endif
+                if (status.start_tx_error){
                     STATS_INC(g_stat, tx_error);
                     dpl_sem_release(&rng->sem);
                     if (cbs!=NULL && cbs->start_tx_error_cb)
@@ -316,8 +328,12 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
                 frame->carrier_integrator  = inst->carrier_integrator;
 #endif
                 // Transmit timestamp final report
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+                uwb_sec_write_tx(inst, frame->array, sizeof(twr_frame_final_t));
+#else
                 uwb_write_tx(inst, frame->array, 0,  sizeof(twr_frame_final_t));
                 uwb_write_tx_fctrl(inst, sizeof(twr_frame_final_t), 0);
+#endif
                 uint64_t final_tx_delay = response_timestamp + ((uint64_t) g_config.tx_holdoff_delay << 16);
                 uwb_set_delay_start(inst, final_tx_delay);
                 
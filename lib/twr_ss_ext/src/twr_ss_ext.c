@@ -269,11 +269,16 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
                 if (cbs!=NULL && cbs->final_cb)
                     cbs->final_cb(inst, cbs);
               
+#if MYNEWT_VAL(RNG_SESSIONS)
+                // The session scheduler programs the response once the radio is free for it
+                struct uwb_dev_status status = uwb_rng_session_tx(rng, frame, sizeof(twr_frame_t), response_tx_delay);
+#else
                 uwb_write_tx(inst, frame->array ,0 ,sizeof(twr_frame_t));
                 uwb_write_tx_fctrl(inst, sizeof(twr_frame_t), 0);
                 uwb_set_delay_start(inst, response_tx_delay);
-              
-                if (uwb_start_tx(inst).start_tx_error){
+                struct uwb_dev_status status = uwb_start_tx(inst);
+#endif
+                if (status.start_tx_error){
                     STATS_INC(g_stat, tx_error);
                     dpl_sem_release(&rng->sem);
                     if (cbs!=NULL && cbs->start_tx_error_cb)
@@ -0,0 +1,161 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file uwb_bridge.h
+ * @brief Broadcast of range, position, ccp and diagnostic records to host consumers
+ *
+ * @details One producer publishes records, each a JSON line with a type,
+ * sequence number and cputime stamp, into a byte ring. Any number of readers,
+ * up to UWB_BRIDGE_MAX_READERS, consume the same records at their own pace.
+ * The producer never waits: when the ring is full the oldest records are
+ * dropped, a reader that falls behind skips to the oldest record still held
+ * and the records it lost are counted from the sequence numbers.
+ *
+ * With UWB_BRIDGE_RANGE a bridge attached to a device publishes a range
+ * record from the mac completion of every two way range, in the format of
+ * rng_encode(). Other records are published by the application, e.g. from
+ * the ccp postprocess or a survey completion.
+ *
+ * On Linux, src/arch/linux serves the ring over a Unix domain socket, see
+ * uwb_bridge_unix.h and apps/uwb_bridge, and also provides a binary shared
+ * memory ring for consumers that cannot afford parsing, see uwb_bridge_shm.h.
+ */
+
+#ifndef _UWB_BRIDGE_H_
+#define _UWB_BRIDGE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stats/stats.h>
+#include <dpl/dpl.h>
+#include <uwb/uwb.h>
+#include <json_stream/json_stream.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if (MYNEWT_VAL(UWB_BRIDGE_RING_SIZE) & (MYNEWT_VAL(UWB_BRIDGE_RING_SIZE) - 1))
+#error "UWB_BRIDGE_RING_SIZE must be a power of two"
+#endif
+
+#if MYNEWT_VAL(UWB_BRIDGE_STATS)
+STATS_SECT_START(uwb_bridge_stat_section)
+    STATS_SECT_ENTRY(published)
+    STATS_SECT_ENTRY(evicted)
+    STATS_SECT_ENTRY(delivered)
+    STATS_SECT_ENTRY(dropped)
+    STATS_SECT_ENTRY(oversize)
+STATS_SECT_END
+#define UWB_BRIDGE_STATS_INC(__X) STATS_INC(br->stat, __X)
+#define UWB_BRIDGE_STATS_INCN(__X, __N) STATS_INCN(br->stat, __X, __N)
+#else
+#define UWB_BRIDGE_STATS_INC(__X) {}
+#define UWB_BRIDGE_STATS_INCN(__X, __N) {}
+#endif
+
+//! Record types
+typedef enum _uwb_bridge_type_t{
+    UWB_BRIDGE_TYPE_TEXT = 0,          //!< Anything else, e.g. diagnostic messages
+    UWB_BRIDGE_TYPE_RANGE,             //!< Two way range
+    UWB_BRIDGE_TYPE_POSITION,          //!< Position estimate
+    UWB_BRIDGE_TYPE_CCP,               //!< Clock calibration
+    UWB_BRIDGE_TYPE_DIAG,              //!< Receive diagnostics
+    UWB_BRIDGE_TYPE_SURVEY,            //!< Survey range matrix
+    UWB_BRIDGE_TYPE_TDOA,              //!< Time difference of arrival
+    UWB_BRIDGE_TYPE_TSYNC,             //!< Host time sync to the master timeline
+}uwb_bridge_type_t;
+
+//! Record header, payload follows, records are padded to 4 bytes
+struct uwb_bridge_hdr {
+    uint16_t len;                      //!< Payload bytes
+    uint8_t type;                      //!< uwb_bridge_type_t
+    uint8_t rsvd;
+    uint32_t seq;                      //!< Sequence number
+    uint32_t stamp;                    //!< Cputime at publish
+};
+
+//! Reader
+struct uwb_bridge_reader {
+    uint32_t rd;                       //!< Ring position, free running
+    uint32_t seq;                      //!< Sequence number expected next
+    uint32_t delivered;                //!< Records read
+    uint32_t dropped;                  //!< Records lost to the ring overwriting them
+    uint8_t active:1;                  //!< Reader open
+};
+
+//! Bridge status
+typedef struct _uwb_bridge_status_t{
+    uint16_t selfmalloc:1;             //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;            //!< Instance allocated
+    uint16_t attached:1;               //!< Mac interface appended
+}uwb_bridge_status_t;
+
+//! Delivery latency, cputime at publish to cputime at read, usec
+struct uwb_bridge_latency {
+    uint32_t n;                        //!< Samples
+    uint32_t max;                      //!< Largest
+    uint64_t sum;                      //!< Sum
+};
+
+//! Called after a record is published, outside the ring lock
+typedef void (*uwb_bridge_notify_t)(void * arg);
+
+//! Bridge instance
+struct uwb_bridge_instance {
+#if MYNEWT_VAL(UWB_BRIDGE_STATS)
+    STATS_SECT_DECL(uwb_bridge_stat_section) stat; //!< Stats instance
+#endif
+    struct uwb_dev * dev_inst;         //!< Attached device, may be NULL
+    struct uwb_mac_interface cbs;      //!< MAC layer callbacks
+    uwb_bridge_status_t status;        //!< Status
+    struct dpl_mutex mutex;            //!< Guards the ring and readers
+    uint32_t head;                     //!< Write position, free running
+    uint32_t tail;                     //!< Oldest record held, free running
+    uint32_t seq;                      //!< Sequence number of the next record
+    struct uwb_bridge_latency latency; //!< Delivery latency
+    uwb_bridge_notify_t notify;        //!< Wakes a transport waiting for records, may be NULL
+    void * notify_arg;                 //!< Notify argument
+    struct uwb_bridge_reader readers[MYNEWT_VAL(UWB_BRIDGE_MAX_READERS)]; //!< Readers
+#if MYNEWT_VAL(UWB_BRIDGE_RANGE)
+    struct json_stream js;             //!< Range record encoder, mac context
+    char rec[MYNEWT_VAL(UWB_BRIDGE_MAX_RECORD)]; //!< Range record
+#endif
+    uint8_t ring[MYNEWT_VAL(UWB_BRIDGE_RING_SIZE)]; //!< Records
+};
+
+struct uwb_bridge_instance * uwb_bridge_init(struct uwb_bridge_instance * br);
+void uwb_bridge_free(struct uwb_bridge_instance * br);
+struct uwb_bridge_instance * uwb_bridge_get_instance(void);
+void uwb_bridge_attach(struct uwb_bridge_instance * br, struct uwb_dev * inst);
+void uwb_bridge_detach(struct uwb_bridge_instance * br);
+void uwb_bridge_set_notify(struct uwb_bridge_instance * br, uwb_bridge_notify_t notify, void * arg);
+
+int uwb_bridge_publish(struct uwb_bridge_instance * br, uwb_bridge_type_t type, const char * data, uint16_t len);
+int uwb_bridge_open(struct uwb_bridge_instance * br);
+void uwb_bridge_close(struct uwb_bridge_instance * br, int reader);
+int uwb_bridge_read(struct uwb_bridge_instance * br, int reader, struct uwb_bridge_hdr * hdr, char * dst, uint16_t len);
+uint32_t uwb_bridge_pending(struct uwb_bridge_instance * br, int reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _UWB_BRIDGE_H_ */
@@ -0,0 +1,145 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file uwb_bridge_shm.h
+ * @brief Shared memory ring of binary range and tdoa records, Linux only
+ *
+ * @details The producer writes fixed size records into a POSIX shared memory
+ * object, one 64 byte slot each, and never waits for consumers. Consumers in
+ * any process map the object read only and follow the producer without locks:
+ * every slot carries a generation, odd while the slot is written, which tells
+ * a consumer whether the record it copied is the one it expected. A consumer
+ * lapped by the producer skips to the oldest record still held and counts the
+ * records it lost, so delivered + lost always equals the records passed.
+ *
+ * The producer side publishes a record from the mac completion of every two
+ * way range of the attached device, and from uwb_bridge_shm_nrng() and
+ * uwb_bridge_shm_rtdoa() called where the application handles nrng and rtdoa
+ * results.
+ *
+ * The header also carries the host clock disciplined to the WCS master
+ * timeline, see uwb_bridge_tsync.h, so consumers can put their own
+ * CLOCK_MONOTONIC timestamps, e.g. of camera frames, on the UWB timeline.
+ */
+
+#ifndef _UWB_BRIDGE_SHM_H_
+#define _UWB_BRIDGE_SHM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <dpl/dpl.h>
+#include <uwb/uwb.h>
+#include <uwb_bridge/uwb_bridge.h>
+#include <uwb_bridge/uwb_bridge_tsync.h>
+
+#if (MYNEWT_VAL(UWB_BRIDGE_SHM_SLOTS) & (MYNEWT_VAL(UWB_BRIDGE_SHM_SLOTS) - 1))
+#error "UWB_BRIDGE_SHM_SLOTS must be a power of two"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UWB_BRIDGE_SHM_MAGIC    0x55574253      //!< "UWBS", cleared when the producer exits
+#define UWB_BRIDGE_SHM_VERSION  2
+
+//! Record, fixed layout shared with consumers
+struct uwb_bridge_shm_rec {
+    uint64_t seq;                      //!< Record number, from 0, set by the ring
+    uint64_t utime;                    //!< Host usec at publish, CLOCK_MONOTONIC
+    uint64_t timestamp;                //!< Device receive timestamp, dtu
+    uint8_t type;                      //!< uwb_bridge_type_t
+    uint8_t frame_seq;                 //!< Frame sequence number
+    uint16_t uid;                      //!< Own address
+    uint16_t peer;                     //!< Responder, anchor of a tdoa
+    uint16_t ref;                      //!< Reference anchor of a tdoa
+    float value;                       //!< Range or tdoa, m
+    float rssi;                        //!< Receive power, dBm
+    float pos[3];                      //!< Position, m, UWB_BRIDGE_TYPE_POSITION
+    uint32_t rsvd;
+};
+
+//! Ring slot, generation 2 * seq + 1 while written and 2 * seq + 2 once done
+struct uwb_bridge_shm_slot {
+    uint64_t gen;                      //!< Generation
+    struct uwb_bridge_shm_rec rec;     //!< Record
+} __attribute__((aligned(64)));
+
+//! Layout of the shared memory object, slots follow
+struct uwb_bridge_shm_hdr {
+    uint32_t magic;                    //!< UWB_BRIDGE_SHM_MAGIC
+    uint32_t version;                  //!< UWB_BRIDGE_SHM_VERSION
+    uint32_t nslots;                   //!< Slots, power of two
+    uint32_t slot_size;                //!< sizeof(struct uwb_bridge_shm_slot)
+    uint64_t head __attribute__((aligned(64))); //!< Records published, own cache line
+    uint64_t clock_gen __attribute__((aligned(64))); //!< Seqlock of clock, odd while written, 0 while unset
+    struct uwb_bridge_tsync_clock clock; //!< Host clock disciplined to the master timeline
+} __attribute__((aligned(64)));
+
+//! Producer
+struct uwb_bridge_shm {
+    struct uwb_bridge_shm_hdr * hdr;   //!< Mapped object
+    struct uwb_bridge_shm_slot * slots;//!< Slots
+    size_t size;                       //!< Mapped bytes
+    uint64_t seq;                      //!< Next record number
+    struct dpl_mutex mutex;            //!< Serialises publishing contexts
+    struct uwb_dev * dev_inst;         //!< Attached device, may be NULL
+    struct uwb_mac_interface cbs;      //!< MAC layer callbacks
+    char name[64];                     //!< Object name
+};
+
+//! Consumer
+struct uwb_bridge_shm_reader {
+    const struct uwb_bridge_shm_hdr * hdr;    //!< Mapped object
+    const struct uwb_bridge_shm_slot * slots; //!< Slots
+    size_t size;                       //!< Mapped bytes
+    uint64_t mask;                     //!< Slots - 1
+    uint64_t cursor;                   //!< Record number expected next
+    uint64_t delivered;                //!< Records read
+    uint64_t lost;                     //!< Records overwritten before they were read
+};
+
+int uwb_bridge_shm_create(struct uwb_bridge_shm * shm, const char * name);
+void uwb_bridge_shm_destroy(struct uwb_bridge_shm * shm);
+uint64_t uwb_bridge_shm_put(struct uwb_bridge_shm * shm, struct uwb_bridge_shm_rec * rec);
+void uwb_bridge_shm_attach(struct uwb_bridge_shm * shm, struct uwb_dev * inst);
+void uwb_bridge_shm_detach(struct uwb_bridge_shm * shm);
+void uwb_bridge_shm_set_clock(struct uwb_bridge_shm * shm, const struct uwb_bridge_tsync_clock * clock);
+
+#if MYNEWT_VAL(NRNG_ENABLED)
+struct nrng_instance;
+int uwb_bridge_shm_nrng(struct uwb_bridge_shm * shm, struct nrng_instance * nrng, uint16_t nranges, uint16_t base);
+#endif
+#if MYNEWT_VAL(RTDOA_ENABLED)
+struct rtdoa_instance;
+int uwb_bridge_shm_rtdoa(struct uwb_bridge_shm * shm, struct rtdoa_instance * rtdoa);
+#endif
+
+int uwb_bridge_shm_open(struct uwb_bridge_shm_reader * rd, const char * name, bool oldest);
+int uwb_bridge_shm_read(struct uwb_bridge_shm_reader * rd, struct uwb_bridge_shm_rec * rec);
+int uwb_bridge_shm_get_clock(struct uwb_bridge_shm_reader * rd, struct uwb_bridge_tsync_clock * clock);
+void uwb_bridge_shm_close(struct uwb_bridge_shm_reader * rd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _UWB_BRIDGE_SHM_H_ */
@@ -0,0 +1,145 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file uwb_bridge_tsync.h
+ * @brief Host clock disciplined to the WCS master timeline
+ *
+ * @details The host sends a time request at t1 of its clock, the node takes
+ * the master time t2 at its receipt and t3 at its reply, see "wcs time" in
+ * lib/uwb_wcs, and the host receives the reply at t4. As in PTP the offset
+ * of the master from the host is ((t2 - t1) + (t3 - t4)) / 2 and the round
+ * trip delay (t4 - t1) - (t3 - t2), the offset being exact when both
+ * directions take equally long. Serial and USB links queue, so only the
+ * exchange of least delay among the last UWB_BRIDGE_TSYNC_WINDOW is used,
+ * and its offset steers a PI servo on the phase and rate of a linear host to
+ * master mapping, uwb_bridge_tsync_clock. The first exchange steps the clock,
+ * one UWB_BRIDGE_TSYNC_RATE_INTERVAL later sets the rate and later ones are
+ * slewed unless the error passes UWB_BRIDGE_TSYNC_STEP. A known difference
+ * between the request and reply path delays, e.g. the serialisation of lines
+ * of different length on a uart, is removed through asymmetry.
+ *
+ * Times are in ns, host times of CLOCK_MONOTONIC on Linux. The estimator
+ * does no I/O and takes no clock, the caller times the exchanges.
+ */
+
+#ifndef _UWB_BRIDGE_TSYNC_H_
+#define _UWB_BRIDGE_TSYNC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <syscfg/syscfg.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UWB_BRIDGE_TSYNC_LOCKED (0x01)  //!< Rate estimated, the clock is slewed
+
+//! Host to master mapping, master = master_ref + (host - host_ref) * (1 + rate)
+struct uwb_bridge_tsync_clock {
+    int64_t host_ref;                  //!< Host time of the reference point, ns
+    int64_t master_ref;                //!< Master time at host_ref, ns
+    double rate;                       //!< Master over host rate minus one
+    uint32_t flags;                    //!< UWB_BRIDGE_TSYNC_* flags
+    float jitter;                      //!< Rms offset error of the exchanges used, ns
+};
+
+//! One exchange
+struct uwb_bridge_tsync_sample {
+    int64_t host;                      //!< Host time midway, (t1 + t4) / 2, ns
+    int64_t offset;                    //!< Master minus host time, ns
+    int64_t delay;                     //!< Round trip less the node's turnaround, ns
+    bool used;                         //!< Steered the servo
+};
+
+//! Counters and last values
+struct uwb_bridge_tsync_stats {
+    uint32_t exchanges;                //!< Exchanges given
+    uint32_t rejected;                 //!< Negative delay or out of order
+    uint32_t used;                     //!< Steered the servo
+    uint32_t steps;                    //!< Clock stepped
+    int64_t error;                     //!< Offset error of the last exchange used, ns
+    int64_t delay;                     //!< Delay of the last exchange, ns
+    int64_t delay_min;                 //!< Least delay seen, ns
+};
+
+//! Estimator
+struct uwb_bridge_tsync {
+    struct uwb_bridge_tsync_clock clock;  //!< Disciplined clock
+    struct uwb_bridge_tsync_stats stats;  //!< Statistics
+    int64_t asymmetry;                 //!< Request minus reply path delay, ns, known link asymmetry
+    uint8_t state;                     //!< 0 unset, 1 stepped, 2 locked
+    uint16_t idx;                      //!< Samples written
+    struct uwb_bridge_tsync_sample window[MYNEWT_VAL(UWB_BRIDGE_TSYNC_WINDOW)]; //!< Recent exchanges
+};
+
+/**
+ * Master time of a host time
+ *
+ * @param clock Pointer to struct uwb_bridge_tsync_clock.
+ * @param host  Host time, ns.
+ *
+ * @return master time, ns
+ */
+static inline int64_t
+uwb_bridge_tsync_to_master(const struct uwb_bridge_tsync_clock * clock, int64_t host)
+{
+    int64_t dt = host - clock->host_ref;
+    return clock->master_ref + dt + (int64_t)(dt * clock->rate);
+}
+
+/**
+ * Host time of a master time
+ *
+ * @param clock     Pointer to struct uwb_bridge_tsync_clock.
+ * @param master    Master time, ns.
+ *
+ * @return host time, ns
+ */
+static inline int64_t
+uwb_bridge_tsync_to_host(const struct uwb_bridge_tsync_clock * clock, int64_t master)
+{
+    int64_t dt = master - clock->master_ref;
+    return clock->host_ref + dt - (int64_t)(dt * clock->rate / (1.0 + clock->rate));
+}
+
+/**
+ * Master timeline dtu to ns, exact for the whole 64 bit range
+ *
+ * @param dtu   Time, dtu of 1 / (128 * 499.2 MHz).
+ *
+ * @return ns
+ */
+static inline int64_t
+uwb_bridge_tsync_dtu_to_ns(uint64_t dtu)
+{
+    const uint64_t dtu_per_sec = 63897600000ull;
+    // 1e9 / dtu_per_sec reduces to 625 / 39936
+    return (int64_t)((dtu / dtu_per_sec) * 1000000000ull + ((dtu % dtu_per_sec) * 625 + 19968) / 39936);
+}
+
+void uwb_bridge_tsync_init(struct uwb_bridge_tsync * ts);
+int uwb_bridge_tsync_update(struct uwb_bridge_tsync * ts, int64_t t1, int64_t t2, int64_t t3, int64_t t4);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _UWB_BRIDGE_TSYNC_H_ */
@@ -0,0 +1,71 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file uwb_bridge_unix.h
+ * @brief Unix domain socket transport of the bridge, Linux only
+ *
+ * @details Every client connected to the stream socket is a bridge reader
+ * and receives the records as JSON lines. Sockets are non blocking, a client
+ * that does not keep up is lapped by the ring and, before its next record,
+ * receives {"dropped": n} with the number of records it lost. Clients only
+ * read, anything they send is discarded.
+ */
+
+#ifndef _UWB_BRIDGE_UNIX_H_
+#define _UWB_BRIDGE_UNIX_H_
+
+#include <stdint.h>
+#include <uwb_bridge/uwb_bridge.h>
+
+#if MYNEWT_VAL(UWB_BRIDGE_UNIX_BUF) < MYNEWT_VAL(UWB_BRIDGE_MAX_RECORD) + 32
+#error "UWB_BRIDGE_UNIX_BUF must hold a record and a drop notice"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Connected client
+struct uwb_bridge_client {
+    int fd;                            //!< Socket, -1 when unused
+    int reader;                        //!< Bridge reader
+    uint32_t dropped;                  //!< Reader drops already reported
+    uint16_t off;                      //!< Bytes of out already sent
+    uint16_t len;                      //!< Bytes in out
+    char out[MYNEWT_VAL(UWB_BRIDGE_UNIX_BUF)]; //!< Lines being sent
+};
+
+//! Socket server
+struct uwb_bridge_unix {
+    struct uwb_bridge_instance * br;   //!< Bridge served
+    int fd;                            //!< Listening socket
+    char path[108];                    //!< Socket path
+    struct uwb_bridge_client clients[MYNEWT_VAL(UWB_BRIDGE_MAX_READERS)]; //!< Clients
+};
+
+int uwb_bridge_unix_open(struct uwb_bridge_unix * ux, struct uwb_bridge_instance * br, const char * path);
+int uwb_bridge_unix_poll(struct uwb_bridge_unix * ux, int extra_fd, int timeout_ms);
+void uwb_bridge_unix_close(struct uwb_bridge_unix * ux);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _UWB_BRIDGE_UNIX_H_ */
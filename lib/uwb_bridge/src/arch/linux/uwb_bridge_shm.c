@@ -0,0 +1,326 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file uwb_bridge_shm.c
+ * @brief Shared memory ring of binary range and tdoa records, Linux only
+ *
+ * @details Slots are a seqlock each. The producer makes the generation odd,
+ * writes the record, makes the generation even and then advances head. A
+ * consumer copies a slot between two reads of its generation and keeps the
+ * copy only if both match the record it expected; any other generation means
+ * the producer lapped it and that record is counted as lost. The disciplined
+ * clock in the header is a seqlock of its own.
+ *
+ * The producer hooks are in uwb_bridge_shm_mac.c.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <os/os.h>
+#include <uwb_bridge/uwb_bridge_shm.h>
+
+_Static_assert(sizeof(struct uwb_bridge_shm_slot) == 64, "shm slot must be one cache line");
+
+#define SHM_SIZE(__n) (sizeof(struct uwb_bridge_shm_hdr) + (size_t)(__n) * sizeof(struct uwb_bridge_shm_slot))
+
+static uint64_t
+now_usec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000u;
+}
+
+/**
+ * @fn uwb_bridge_shm_create(struct uwb_bridge_shm * shm, const char * name)
+ * @brief Create the shared memory object and start publishing at record 0.
+ * An object left by a previous producer is unlinked first, consumers still
+ * mapping it see it closed.
+ *
+ * @param shm   Pointer to struct uwb_bridge_shm.
+ * @param name  Object name, e.g. "/uwb_bridge".
+ *
+ * @return OS_OK on success, OS_EINVAL if the name is too long, OS_ERROR if the object cannot be created
+ */
+int
+uwb_bridge_shm_create(struct uwb_bridge_shm * shm, const char * name)
+{
+    size_t size = SHM_SIZE(MYNEWT_VAL(UWB_BRIDGE_SHM_SLOTS));
+    void * p;
+    int fd;
+
+    if (strlen(name) >= sizeof(shm->name)) {
+        return OS_EINVAL;
+    }
+    memset(shm, 0, sizeof(*shm));
+    strcpy(shm->name, name);
+
+    shm_unlink(name);
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return OS_ERROR;
+    }
+    if (ftruncate(fd, size) < 0) {
+        close(fd);
+        shm_unlink(name);
+        return OS_ERROR;
+    }
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        shm_unlink(name);
+        return OS_ERROR;
+    }
+
+    dpl_error_t err = dpl_mutex_init(&shm->mutex);
+    assert(err == DPL_OK);
+    shm->hdr = (struct uwb_bridge_shm_hdr *) p;
+    shm->slots = (struct uwb_bridge_shm_slot *) (shm->hdr + 1);
+    shm->size = size;
+    shm->hdr->version = UWB_BRIDGE_SHM_VERSION;
+    shm->hdr->nslots = MYNEWT_VAL(UWB_BRIDGE_SHM_SLOTS);
+    shm->hdr->slot_size = sizeof(struct uwb_bridge_shm_slot);
+    /* Consumers check the magic last */
+    __atomic_store_n(&shm->hdr->magic, UWB_BRIDGE_SHM_MAGIC, __ATOMIC_RELEASE);
+    return OS_OK;
+}
+
+/**
+ * @fn uwb_bridge_shm_destroy(struct uwb_bridge_shm * shm)
+ * @brief Mark the ring closed for consumers and remove the object. A ring
+ * attached to a device is detached first with uwb_bridge_shm_detach().
+ *
+ * @param shm   Pointer to struct uwb_bridge_shm.
+ *
+ * @return void
+ */
+void
+uwb_bridge_shm_destroy(struct uwb_bridge_shm * shm)
+{
+    if (shm->hdr == NULL) {
+        return;
+    }
+    __atomic_store_n(&shm->hdr->magic, 0, __ATOMIC_RELEASE);
+    munmap(shm->hdr, shm->size);
+    shm_unlink(shm->name);
+    shm->hdr = NULL;
+}
+
+/**
+ * @fn uwb_bridge_shm_put(struct uwb_bridge_shm * shm, struct uwb_bridge_shm_rec * rec)
+ * @brief Publish a record, overwriting the oldest one. Never waits for
+ * consumers, only for another context publishing at the same time.
+ *
+ * @param shm   Pointer to struct uwb_bridge_shm.
+ * @param rec   Record, seq and utime are filled in.
+ *
+ * @return Record number
+ */
+uint64_t
+uwb_bridge_shm_put(struct uwb_bridge_shm * shm, struct uwb_bridge_shm_rec * rec)
+{
+    struct uwb_bridge_shm_slot * slot;
+    uint64_t n;
+
+    rec->utime = now_usec();
+    dpl_mutex_pend(&shm->mutex, DPL_TIMEOUT_NEVER);
+    n = shm->seq++;
+    rec->seq = n;
+    slot = &shm->slots[n & (MYNEWT_VAL(UWB_BRIDGE_SHM_SLOTS) - 1)];
+    __atomic_store_n(&slot->gen, 2 * n + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot->rec = *rec;
+    __atomic_store_n(&slot->gen, 2 * n + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&shm->hdr->head, n + 1, __ATOMIC_RELEASE);
+    dpl_mutex_release(&shm->mutex);
+    return n;
+}
+
+/**
+ * @fn uwb_bridge_shm_set_clock(struct uwb_bridge_shm * shm, const struct uwb_bridge_tsync_clock * clock)
+ * @brief Publish the disciplined host clock to consumers.
+ *
+ * @param shm   Pointer to struct uwb_bridge_shm.
+ * @param clock Clock, e.g. uwb_bridge_tsync::clock after an update.
+ *
+ * @return void
+ */
+void
+uwb_bridge_shm_set_clock(struct uwb_bridge_shm * shm, const struct uwb_bridge_tsync_clock * clock)
+{
+    uint64_t gen;
+
+    dpl_mutex_pend(&shm->mutex, DPL_TIMEOUT_NEVER);
+    gen = __atomic_load_n(&shm->hdr->clock_gen, __ATOMIC_RELAXED);
+    __atomic_store_n(&shm->hdr->clock_gen, gen + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    shm->hdr->clock = *clock;
+    __atomic_store_n(&shm->hdr->clock_gen, gen + 2, __ATOMIC_RELEASE);
+    dpl_mutex_release(&shm->mutex);
+}
+
+/**
+ * @fn uwb_bridge_shm_open(struct uwb_bridge_shm_reader * rd, const char * name, bool oldest)
+ * @brief Map a producer's ring read only.
+ *
+ * @param rd      Pointer to struct uwb_bridge_shm_reader.
+ * @param name    Object name.
+ * @param oldest  Start at the oldest record held, otherwise at the next one published.
+ *
+ * @return OS_OK on success, OS_ENOENT if there is no producer, OS_EINVAL if the layout differs
+ */
+int
+uwb_bridge_shm_open(struct uwb_bridge_shm_reader * rd, const char * name, bool oldest)
+{
+    struct uwb_bridge_shm_hdr hdr;
+    struct stat st;
+    void * p;
+    int fd;
+
+    memset(rd, 0, sizeof(*rd));
+    fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return OS_ENOENT;
+    }
+    if (fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(hdr)
+        || pread(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr)) {
+        close(fd);
+        return OS_ENOENT;
+    }
+    if (hdr.magic != UWB_BRIDGE_SHM_MAGIC) {
+        close(fd);
+        return OS_ENOENT;
+    }
+    if (hdr.version != UWB_BRIDGE_SHM_VERSION || hdr.slot_size != sizeof(struct uwb_bridge_shm_slot)
+        || hdr.nslots == 0 || (hdr.nslots & (hdr.nslots - 1)) || (size_t) st.st_size < SHM_SIZE(hdr.nslots)) {
+        close(fd);
+        return OS_EINVAL;
+    }
+    p = mmap(NULL, SHM_SIZE(hdr.nslots), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        return OS_ERROR;
+    }
+
+    rd->hdr = (const struct uwb_bridge_shm_hdr *) p;
+    rd->slots = (const struct uwb_bridge_shm_slot *) (rd->hdr + 1);
+    rd->size = SHM_SIZE(hdr.nslots);
+    rd->mask = hdr.nslots - 1;
+    rd->cursor = __atomic_load_n(&rd->hdr->head, __ATOMIC_ACQUIRE);
+    if (oldest) {
+        rd->cursor = (rd->cursor > rd->mask + 1) ? rd->cursor - (rd->mask + 1) : 0;
+    }
+    return OS_OK;
+}
+
+/**
+ * @fn uwb_bridge_shm_read(struct uwb_bridge_shm_reader * rd, struct uwb_bridge_shm_rec * rec)
+ * @brief Read the next record. Records are read in publishing order; when
+ * the producer has overwritten records not read yet they are skipped and
+ * added to rd->lost.
+ *
+ * @param rd    Pointer to struct uwb_bridge_shm_reader.
+ * @param rec   Record read.
+ *
+ * @return 1 if a record was read, 0 if none is pending, -1 if the producer has exited
+ */
+int
+uwb_bridge_shm_read(struct uwb_bridge_shm_reader * rd, struct uwb_bridge_shm_rec * rec)
+{
+    const struct uwb_bridge_shm_slot * slot;
+    uint64_t head, gen;
+
+    for (;;) {
+        head = __atomic_load_n(&rd->hdr->head, __ATOMIC_ACQUIRE);
+        if (head == rd->cursor) {
+            return (__atomic_load_n(&rd->hdr->magic, __ATOMIC_ACQUIRE) == UWB_BRIDGE_SHM_MAGIC) ? 0 : -1;
+        }
+        if (head - rd->cursor > rd->mask + 1) {
+            rd->lost += head - (rd->mask + 1) - rd->cursor;
+            rd->cursor = head - (rd->mask + 1);
+        }
+        slot = &rd->slots[rd->cursor & rd->mask];
+        gen = __atomic_load_n(&slot->gen, __ATOMIC_ACQUIRE);
+        if (gen == 2 * rd->cursor + 2) {
+            memcpy(rec, (const void *) &slot->rec, sizeof(*rec));
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&slot->gen, __ATOMIC_RELAXED) == gen) {
+                rd->cursor++;
+                rd->delivered++;
+                return 1;
+            }
+        }
+        /* Lapped since head was read, the record is gone */
+        rd->cursor++;
+        rd->lost++;
+    }
+}
+
+/**
+ * @fn uwb_bridge_shm_get_clock(struct uwb_bridge_shm_reader * rd, struct uwb_bridge_tsync_clock * clock)
+ * @brief Copy the disciplined host clock, for uwb_bridge_tsync_to_master()
+ * and uwb_bridge_tsync_to_host().
+ *
+ * @param rd    Pointer to struct uwb_bridge_shm_reader.
+ * @param clock Clock copied.
+ *
+ * @return 1 if the clock is locked, 0 if set but not locked yet, -1 if unset
+ */
+int
+uwb_bridge_shm_get_clock(struct uwb_bridge_shm_reader * rd, struct uwb_bridge_tsync_clock * clock)
+{
+    uint64_t gen;
+
+    do {
+        gen = __atomic_load_n(&rd->hdr->clock_gen, __ATOMIC_ACQUIRE);
+        memcpy(clock, (const void *) &rd->hdr->clock, sizeof(*clock));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((gen & 1) || __atomic_load_n(&rd->hdr->clock_gen, __ATOMIC_RELAXED) != gen);
+
+    if (gen == 0) {
+        return -1;
+    }
+    return (clock->flags & UWB_BRIDGE_TSYNC_LOCKED) ? 1 : 0;
+}
+
+/**
+ * @fn uwb_bridge_shm_close(struct uwb_bridge_shm_reader * rd)
+ * @brief Unmap the ring.
+ *
+ * @param rd    Pointer to struct uwb_bridge_shm_reader.
+ *
+ * @return void
+ */
+void
+uwb_bridge_shm_close(struct uwb_bridge_shm_reader * rd)
+{
+    if (rd->hdr) {
+        munmap((void *) rd->hdr, rd->size);
+        rd->hdr = NULL;
+    }
+}
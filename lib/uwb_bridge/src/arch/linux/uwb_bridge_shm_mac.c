@@ -0,0 +1,214 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file uwb_bridge_shm_mac.c
+ * @brief Producer hooks of the shared memory ring, two way range, nrng and
+ * rtdoa results as binary records
+ */
+
+#include <assert.h>
+#include <os/os.h>
+#include <uwb/uwb_ftypes.h>
+#include <uwb_rng/uwb_rng.h>
+#include <uwb_bridge/uwb_bridge_shm.h>
+
+#if MYNEWT_VAL(NRNG_ENABLED)
+#include <nrng/nrng.h>
+#endif
+#if MYNEWT_VAL(RTDOA_ENABLED)
+#include <rtdoa/rtdoa.h>
+#endif
+
+static bool complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+
+/**
+ * @fn uwb_bridge_shm_attach(struct uwb_bridge_shm * shm, struct uwb_dev * inst)
+ * @brief Publish a range record for every completed two way range of a device.
+ *
+ * @param shm   Pointer to struct uwb_bridge_shm.
+ * @param inst  Pointer to struct uwb_dev.
+ *
+ * @return void
+ */
+void
+uwb_bridge_shm_attach(struct uwb_bridge_shm * shm, struct uwb_dev * inst)
+{
+    assert(shm && inst);
+    if (shm->dev_inst) {
+        return;
+    }
+    shm->dev_inst = inst;
+    shm->cbs = (struct uwb_mac_interface){
+        .id = UWBEXT_BRIDGE_SHM,
+        .inst_ptr = (void *) shm,
+        .complete_cb = complete_cb
+    };
+    uwb_mac_append_interface(inst, &shm->cbs);
+}
+
+/**
+ * @fn uwb_bridge_shm_detach(struct uwb_bridge_shm * shm)
+ * @brief Stop publishing range records of the attached device.
+ *
+ * @param shm   Pointer to struct uwb_bridge_shm.
+ *
+ * @return void
+ */
+void
+uwb_bridge_shm_detach(struct uwb_bridge_shm * shm)
+{
+    if (shm->dev_inst == NULL) {
+        return;
+    }
+    uwb_mac_remove_interface(shm->dev_inst, shm->cbs.id);
+    shm->dev_inst = NULL;
+}
+
+/**
+ * API for mac complete callback, publishes the range of the final frame.
+ *
+ * @param inst  Pointer to struct uwb_dev.
+ * @param cbs   Pointer to struct uwb_mac_interface.
+ *
+ * @return false, other interfaces see the completion too
+ */
+static bool
+complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct uwb_bridge_shm * shm = (struct uwb_bridge_shm *) cbs->inst_ptr;
+    struct uwb_rng_instance * rng;
+    twr_frame_t * frame;
+    uint16_t idx;
+
+    if (inst->fctrl != FCNTL_IEEE_RANGE_16) {
+        return false;
+    }
+    rng = (struct uwb_rng_instance *) uwb_mac_find_cb_inst_ptr(inst, UWBEXT_RNG);
+    if (rng == NULL) {
+        return false;
+    }
+    idx = rng->idx % rng->nframes;
+    frame = rng->frames[idx];
+    switch (frame->code) {
+        case DWT_SS_TWR_FINAL:
+        case DWT_DS_TWR_FINAL:
+        case DWT_SS_TWR_EXT_FINAL:
+        case DWT_DS_TWR_EXT_FINAL:
+            break;
+        default:
+            return false;
+    }
+
+    struct uwb_bridge_shm_rec rec = {
+        .type = UWB_BRIDGE_TYPE_RANGE,
+        .timestamp = inst->rxtimestamp,
+        .frame_seq = frame->seq_num,
+        .uid = frame->src_address,
+        .peer = frame->dst_address,
+        .value = uwb_rng_tof_to_meters(uwb_rng_twr_to_tof(rng, idx)),
+        .rssi = uwb_get_rssi(inst),
+    };
+    uwb_bridge_shm_put(shm, &rec);
+    return false;
+}
+
+#if MYNEWT_VAL(NRNG_ENABLED)
+/**
+ * @fn uwb_bridge_shm_nrng(struct uwb_bridge_shm * shm, struct nrng_instance * nrng, uint16_t nranges, uint16_t base)
+ * @brief Publish a range record for every valid response of the last nrng
+ * request, same selection as nrng_get_ranges.
+ *
+ * @param shm      Pointer to struct uwb_bridge_shm.
+ * @param nrng     Pointer to struct nrng_instance.
+ * @param nranges  Number of slots requested.
+ * @param base     Index of the first frame.
+ *
+ * @return Number of records published
+ */
+int
+uwb_bridge_shm_nrng(struct uwb_bridge_shm * shm, struct nrng_instance * nrng, uint16_t nranges, uint16_t base)
+{
+    int published = 0;
+
+    for (uint16_t i = 0; i < nranges; i++) {
+        if (!(nrng->slot_mask & 1UL << i)) {
+            continue;
+        }
+        uint16_t idx = BitIndex(nrng->slot_mask, 1UL << i, SLOT_POSITION);
+        nrng_frame_t * frame = nrng->frames[(base + idx)%nrng->nframes];
+        if (frame->code != DWT_SS_TWR_NRNG_FINAL || frame->seq_num != nrng->seq_num) {
+            continue;
+        }
+        struct uwb_bridge_shm_rec rec = {
+            .type = UWB_BRIDGE_TYPE_RANGE,
+            .timestamp = nrng->dev_inst->rxtimestamp,
+            .frame_seq = frame->seq_num,
+            .uid = nrng->dev_inst->my_short_address,
+            .peer = frame->src_address,
+            .value = uwb_rng_tof_to_meters(nrng_twr_to_tof_frames(nrng->dev_inst, frame, frame)),
+            .rssi = uwb_calc_rssi(nrng->dev_inst, &frame->diag),
+        };
+        uwb_bridge_shm_put(shm, &rec);
+        published++;
+    }
+    return published;
+}
+#endif
+
+#if MYNEWT_VAL(RTDOA_ENABLED)
+/**
+ * @fn uwb_bridge_shm_rtdoa(struct uwb_bridge_shm * shm, struct rtdoa_instance * rtdoa)
+ * @brief Publish a tdoa record for every response to the current rtdoa
+ * request, against the anchor that sent the request.
+ *
+ * @param shm    Pointer to struct uwb_bridge_shm.
+ * @param rtdoa  Pointer to struct rtdoa_instance.
+ *
+ * @return Number of records published
+ */
+int
+uwb_bridge_shm_rtdoa(struct uwb_bridge_shm * shm, struct rtdoa_instance * rtdoa)
+{
+    int published = 0;
+
+    if (rtdoa->req_frame == NULL) {
+        return 0;
+    }
+    for (uint16_t i = 0; i < rtdoa->nframes; i++) {
+        rtdoa_frame_t * frame = rtdoa->frames[i];
+        if (frame->code != DWT_RTDOA_RESP || frame->seq_num != rtdoa->req_frame->seq_num) {
+            continue;
+        }
+        struct uwb_bridge_shm_rec rec = {
+            .type = UWB_BRIDGE_TYPE_TDOA,
+            .timestamp = frame->rx_timestamp,
+            .frame_seq = frame->seq_num,
+            .uid = rtdoa->dev_inst->my_short_address,
+            .peer = frame->src_address,
+            .ref = rtdoa->req_frame->src_address,
+            .value = rtdoa_tdoa_between_frames(rtdoa, rtdoa->req_frame, frame),
+            .rssi = uwb_calc_rssi(rtdoa->dev_inst, &frame->diag),
+        };
+        uwb_bridge_shm_put(shm, &rec);
+        published++;
+    }
+    return published;
+}
+#endif
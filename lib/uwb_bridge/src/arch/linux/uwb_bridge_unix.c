@@ -0,0 +1,293 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file uwb_bridge_unix.c
+ * @brief Unix domain socket transport of the bridge, Linux only
+ *
+ * @details Single threaded, uwb_bridge_unix_poll() accepts clients and moves
+ * records from the ring to the sockets, batching as many records per send as
+ * the client buffer holds. Publishers in other threads wake it through an
+ * eventfd, written only while the poller is about to sleep.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/eventfd.h>
+#include <os/os.h>
+#include <uwb_bridge/uwb_bridge_unix.h>
+
+static int g_event_fd = -1;
+static int g_armed;
+
+/* Only a poller about to sleep is woken, a busy one finds the records anyway */
+static void
+notify(void * arg)
+{
+    uint64_t one = 1;
+    if (__atomic_exchange_n(&g_armed, 0, __ATOMIC_ACQ_REL)) {
+        if (write(g_event_fd, &one, sizeof(one)) < 0) {
+            /* Counter saturated, the poller is awake anyway */
+        }
+    }
+}
+
+static void
+client_close(struct uwb_bridge_unix * ux, struct uwb_bridge_client * c)
+{
+    close(c->fd);
+    uwb_bridge_close(ux->br, c->reader);
+    c->fd = -1;
+}
+
+static void
+client_accept(struct uwb_bridge_unix * ux)
+{
+    struct uwb_bridge_client * c = NULL;
+    int fd, reader;
+
+    fd = accept4(ux->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    for (int i = 0; i < MYNEWT_VAL(UWB_BRIDGE_MAX_READERS); i++) {
+        if (ux->clients[i].fd < 0) {
+            c = &ux->clients[i];
+            break;
+        }
+    }
+    reader = (c) ? uwb_bridge_open(ux->br) : -1;
+    if (reader < 0) {
+        close(fd);
+        return;
+    }
+    *c = (struct uwb_bridge_client){
+        .fd = fd,
+        .reader = reader,
+    };
+}
+
+/*
+ * Refill the send buffer with as many records as fit, each preceded by a
+ * drop notice if the reader was lapped since the record before it.
+ */
+static bool
+client_fill(struct uwb_bridge_unix * ux, struct uwb_bridge_client * c)
+{
+    struct uwb_bridge_reader * r = &ux->br->readers[c->reader];
+    struct uwb_bridge_hdr hdr;
+    int n;
+
+    c->off = 0;
+    c->len = 0;
+    while (c->len + MYNEWT_VAL(UWB_BRIDGE_MAX_RECORD) + 32 <= sizeof(c->out)) {
+        char * line = &c->out[c->len + 32];
+        n = uwb_bridge_read(ux->br, c->reader, &hdr, line, MYNEWT_VAL(UWB_BRIDGE_MAX_RECORD));
+        if (n == 0) {
+            break;
+        }
+        if (r->dropped != c->dropped) {
+            c->len += snprintf(&c->out[c->len], 32, "{\"dropped\": %lu}\n",
+                               (unsigned long)(r->dropped - c->dropped));
+            c->dropped = r->dropped;
+        }
+        memmove(&c->out[c->len], line, n);
+        c->len += n;
+        c->out[c->len++] = '\n';
+    }
+    return c->len != 0;
+}
+
+static void
+client_send(struct uwb_bridge_unix * ux, struct uwb_bridge_client * c)
+{
+    for (;;) {
+        if (c->off == c->len && !client_fill(ux, c)) {
+            return;
+        }
+        ssize_t n = send(c->fd, &c->out[c->off], c->len - c->off, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                client_close(ux, c);
+            }
+            return;
+        }
+        c->off += n;
+    }
+}
+
+/**
+ * @fn uwb_bridge_unix_open(struct uwb_bridge_unix * ux, struct uwb_bridge_instance * br, const char * path)
+ * @brief Serve a bridge on a Unix domain stream socket. A stale socket file
+ * at path is replaced.
+ *
+ * @param ux    Pointer to struct uwb_bridge_unix.
+ * @param br    Pointer to struct uwb_bridge_instance.
+ * @param path  Socket path.
+ *
+ * @return OS_OK on success, OS_EINVAL if the path is too long, OS_ERROR if the socket cannot be created
+ */
+int
+uwb_bridge_unix_open(struct uwb_bridge_unix * ux, struct uwb_bridge_instance * br, const char * path)
+{
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+
+    if (strlen(path) >= sizeof(addr.sun_path) || strlen(path) >= sizeof(ux->path)) {
+        return OS_EINVAL;
+    }
+    memset(ux, 0, sizeof(*ux));
+    ux->br = br;
+    strcpy(ux->path, path);
+    strcpy(addr.sun_path, path);
+    for (int i = 0; i < MYNEWT_VAL(UWB_BRIDGE_MAX_READERS); i++) {
+        ux->clients[i].fd = -1;
+    }
+
+    if (g_event_fd < 0) {
+        g_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (g_event_fd < 0) {
+            return OS_ERROR;
+        }
+    }
+    ux->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (ux->fd < 0) {
+        return OS_ERROR;
+    }
+    unlink(path);
+    if (bind(ux->fd, (struct sockaddr *) &addr, sizeof(addr)) < 0 || listen(ux->fd, 4) < 0) {
+        close(ux->fd);
+        ux->fd = -1;
+        return OS_ERROR;
+    }
+    uwb_bridge_set_notify(br, notify, NULL);
+    return OS_OK;
+}
+
+/**
+ * @fn uwb_bridge_unix_poll(struct uwb_bridge_unix * ux, int extra_fd, int timeout_ms)
+ * @brief Wait for clients, records or input on extra_fd, then accept new
+ * clients and send pending records. Call in a loop.
+ *
+ * @param ux          Pointer to struct uwb_bridge_unix.
+ * @param extra_fd    Descriptor also waited on for input, e.g. a serial port, -1 for none.
+ * @param timeout_ms  Longest wait, -1 to wait forever.
+ *
+ * @return 1 if extra_fd is readable, 0 otherwise, -1 on a poll failure
+ */
+int
+uwb_bridge_unix_poll(struct uwb_bridge_unix * ux, int extra_fd, int timeout_ms)
+{
+    struct pollfd fds[MYNEWT_VAL(UWB_BRIDGE_MAX_READERS) + 3];
+    struct uwb_bridge_client * map[MYNEWT_VAL(UWB_BRIDGE_MAX_READERS) + 3] = {0};
+    int nfds = 0, rc = 0;
+    uint64_t count;
+
+    fds[nfds++] = (struct pollfd){.fd = ux->fd, .events = POLLIN};
+    fds[nfds++] = (struct pollfd){.fd = g_event_fd, .events = POLLIN};
+    fds[nfds++] = (struct pollfd){.fd = extra_fd, .events = POLLIN};
+    for (int i = 0; i < MYNEWT_VAL(UWB_BRIDGE_MAX_READERS); i++) {
+        struct uwb_bridge_client * c = &ux->clients[i];
+        if (c->fd < 0) {
+            continue;
+        }
+        map[nfds] = c;
+        fds[nfds++] = (struct pollfd){
+            .fd = c->fd,
+            .events = POLLIN | ((c->off != c->len) ? POLLOUT : 0)
+        };
+    }
+
+    /* Arm before the last look at the ring, a record published in between
+     * then either shows as pending or writes the eventfd */
+    __atomic_store_n(&g_armed, 1, __ATOMIC_SEQ_CST);
+    for (int i = 0; i < MYNEWT_VAL(UWB_BRIDGE_MAX_READERS); i++) {
+        struct uwb_bridge_client * c = &ux->clients[i];
+        if (c->fd >= 0 && c->off == c->len && uwb_bridge_pending(ux->br, c->reader)) {
+            timeout_ms = 0;
+        }
+    }
+    rc = poll(fds, nfds, timeout_ms);
+    __atomic_store_n(&g_armed, 0, __ATOMIC_RELEASE);
+    if (rc < 0) {
+        return (errno == EINTR) ? 0 : -1;
+    }
+    rc = 0;
+    if (fds[0].revents & POLLIN) {
+        client_accept(ux);
+    }
+    if (fds[1].revents & POLLIN) {
+        if (read(g_event_fd, &count, sizeof(count)) < 0) {
+            /* Already drained */
+        }
+    }
+    if (extra_fd >= 0 && (fds[2].revents & (POLLIN | POLLHUP))) {
+        rc = 1;
+    }
+    for (int i = 3; i < nfds; i++) {
+        struct uwb_bridge_client * c = map[i];
+        if (fds[i].revents & (POLLHUP | POLLERR)) {
+            client_close(ux, c);
+        } else if (fds[i].revents & POLLIN) {
+            char discard[64];
+            if (recv(c->fd, discard, sizeof(discard), MSG_DONTWAIT) == 0) {
+                client_close(ux, c);
+            }
+        }
+    }
+    /* Records published since the last poll, by this thread or any other */
+    for (int i = 0; i < MYNEWT_VAL(UWB_BRIDGE_MAX_READERS); i++) {
+        if (ux->clients[i].fd >= 0) {
+            client_send(ux, &ux->clients[i]);
+        }
+    }
+    return rc;
+}
+
+/**
+ * @fn uwb_bridge_unix_close(struct uwb_bridge_unix * ux)
+ * @brief Disconnect all clients and remove the socket.
+ *
+ * @param ux    Pointer to struct uwb_bridge_unix.
+ *
+ * @return void
+ */
+void
+uwb_bridge_unix_close(struct uwb_bridge_unix * ux)
+{
+    uwb_bridge_set_notify(ux->br, NULL, NULL);
+    for (int i = 0; i < MYNEWT_VAL(UWB_BRIDGE_MAX_READERS); i++) {
+        if (ux->clients[i].fd >= 0) {
+            client_close(ux, &ux->clients[i]);
+        }
+    }
+    if (ux->fd >= 0) {
+        close(ux->fd);
+        unlink(ux->path);
+        ux->fd = -1;
+    }
+}
@@ -0,0 +1,368 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file uwb_bridge.c
+ * @brief Broadcast of range, position, ccp and diagnostic records to host consumers
+ *
+ * @details The ring holds records back to back, header then payload padded
+ * to 4 bytes, and may wrap inside a record. head, tail and the reader
+ * positions run freely and are masked on access. Publishing advances tail
+ * past whole records until the new one fits, a reader found behind tail has
+ * been lapped and restarts at tail. Critical sections are a copy of one
+ * record.
+ *
+ * Nothing here calls into the uwb stack, the mac side is uwb_bridge_mac.c,
+ * so host tools link the ring without a radio.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <os/os.h>
+#include <stats/stats.h>
+#include <uwb_bridge/uwb_bridge.h>
+
+#define RING_MASK (MYNEWT_VAL(UWB_BRIDGE_RING_SIZE) - 1)
+#define RECORD_SIZE(__len) ((sizeof(struct uwb_bridge_hdr) + (__len) + 3) & ~3UL)
+
+#if MYNEWT_VAL(UWB_BRIDGE_STATS)
+STATS_NAME_START(uwb_bridge_stat_section)
+    STATS_NAME(uwb_bridge_stat_section, published)
+    STATS_NAME(uwb_bridge_stat_section, evicted)
+    STATS_NAME(uwb_bridge_stat_section, delivered)
+    STATS_NAME(uwb_bridge_stat_section, dropped)
+    STATS_NAME(uwb_bridge_stat_section, oversize)
+STATS_NAME_END(uwb_bridge_stat_section)
+#endif
+
+static struct uwb_bridge_instance * g_bridge = NULL;
+
+#if MYNEWT_VAL(UWB_BRIDGE_RANGE)
+static int range_flush(void * arg, const char * data, uint16_t len);
+#endif
+
+/**
+ * @fn uwb_bridge_init(struct uwb_bridge_instance * br)
+ * @brief Allocate and initialise a bridge.
+ *
+ * @param br    Pointer to struct uwb_bridge_instance, NULL to allocate.
+ *
+ * @return struct uwb_bridge_instance *
+ */
+struct uwb_bridge_instance *
+uwb_bridge_init(struct uwb_bridge_instance * br)
+{
+    if (br == NULL) {
+        br = (struct uwb_bridge_instance *) malloc(sizeof(struct uwb_bridge_instance));
+        assert(br);
+        memset(br, 0, sizeof(struct uwb_bridge_instance));
+        br->status.selfmalloc = 1;
+    }
+    if (!br->status.initialized) {
+        dpl_error_t err = dpl_mutex_init(&br->mutex);
+        assert(err == DPL_OK);
+#if MYNEWT_VAL(UWB_BRIDGE_RANGE)
+        json_stream_init(&br->js, br->rec, sizeof(br->rec), range_flush, br);
+#endif
+#if MYNEWT_VAL(UWB_BRIDGE_STATS)
+        int rc = stats_init(
+                    STATS_HDR(br->stat),
+                    STATS_SIZE_INIT_PARMS(br->stat, STATS_SIZE_32),
+                    STATS_NAME_INIT_PARMS(uwb_bridge_stat_section)
+            );
+        rc |= stats_register("uwb_bridge", STATS_HDR(br->stat));
+        assert(rc == 0);
+#endif
+    }
+    br->status.initialized = 1;
+    g_bridge = br;
+    return br;
+}
+
+/**
+ * @fn uwb_bridge_free(struct uwb_bridge_instance * br)
+ * @brief Free the instance, detached first with uwb_bridge_detach().
+ *
+ * @param br  Pointer to struct uwb_bridge_instance.
+ *
+ * @return void
+ */
+void
+uwb_bridge_free(struct uwb_bridge_instance * br)
+{
+    assert(br && !br->status.attached);
+    if (g_bridge == br) {
+        g_bridge = NULL;
+    }
+    if (br->status.selfmalloc) {
+        free(br);
+    } else {
+        br->status.initialized = 0;
+    }
+}
+
+/**
+ * @fn uwb_bridge_get_instance(void)
+ * @brief Instance created by the last uwb_bridge_init.
+ *
+ * @return struct uwb_bridge_instance *
+ */
+struct uwb_bridge_instance *
+uwb_bridge_get_instance(void)
+{
+    return g_bridge;
+}
+
+/**
+ * @fn uwb_bridge_set_notify(struct uwb_bridge_instance * br, uwb_bridge_notify_t notify, void * arg)
+ * @brief Set the callback run after every publish, lets a transport sleep
+ * until records arrive. Runs in the publishing context, mac included, and
+ * must not block.
+ *
+ * @param br      Pointer to struct uwb_bridge_instance.
+ * @param notify  Callback, NULL to remove.
+ * @param arg     Callback argument.
+ *
+ * @return void
+ */
+void
+uwb_bridge_set_notify(struct uwb_bridge_instance * br, uwb_bridge_notify_t notify, void * arg)
+{
+    br->notify_arg = arg;
+    br->notify = notify;
+}
+
+static void
+ring_put(struct uwb_bridge_instance * br, uint32_t pos, const void * src, uint16_t len)
+{
+    uint32_t off = pos & RING_MASK;
+    uint32_t n = MYNEWT_VAL(UWB_BRIDGE_RING_SIZE) - off;
+
+    if (n >= len) {
+        memcpy(&br->ring[off], src, len);
+    } else {
+        memcpy(&br->ring[off], src, n);
+        memcpy(br->ring, (const uint8_t *) src + n, len - n);
+    }
+}
+
+static void
+ring_get(struct uwb_bridge_instance * br, uint32_t pos, void * dst, uint16_t len)
+{
+    uint32_t off = pos & RING_MASK;
+    uint32_t n = MYNEWT_VAL(UWB_BRIDGE_RING_SIZE) - off;
+
+    if (n >= len) {
+        memcpy(dst, &br->ring[off], len);
+    } else {
+        memcpy(dst, &br->ring[off], n);
+        memcpy((uint8_t *) dst + n, br->ring, len - n);
+    }
+}
+
+/**
+ * @fn uwb_bridge_publish(struct uwb_bridge_instance * br, uwb_bridge_type_t type, const char * data, uint16_t len)
+ * @brief Publish a record to all readers, dropping the oldest records if the
+ * ring is full. Never blocks on readers.
+ *
+ * @param br    Pointer to struct uwb_bridge_instance.
+ * @param type  Record type.
+ * @param data  Payload, one JSON object without the line end.
+ * @param len   Payload bytes, at most UWB_BRIDGE_MAX_RECORD.
+ *
+ * @return OS_OK on success, OS_EINVAL if the payload is too large
+ */
+int
+uwb_bridge_publish(struct uwb_bridge_instance * br, uwb_bridge_type_t type, const char * data, uint16_t len)
+{
+    struct uwb_bridge_hdr hdr;
+    uint32_t need = RECORD_SIZE(len);
+
+    if (len > MYNEWT_VAL(UWB_BRIDGE_MAX_RECORD)) {
+        UWB_BRIDGE_STATS_INC(oversize);
+        return OS_EINVAL;
+    }
+    hdr = (struct uwb_bridge_hdr){
+        .len = len,
+        .type = type,
+        .stamp = os_cputime_get32()
+    };
+
+    dpl_error_t err = dpl_mutex_pend(&br->mutex, DPL_TIMEOUT_NEVER);
+    assert(err == DPL_OK);
+    while (br->head + need - br->tail > MYNEWT_VAL(UWB_BRIDGE_RING_SIZE)) {
+        struct uwb_bridge_hdr old;
+        ring_get(br, br->tail, &old, sizeof(old));
+        br->tail += RECORD_SIZE(old.len);
+        UWB_BRIDGE_STATS_INC(evicted);
+    }
+    hdr.seq = br->seq++;
+    ring_put(br, br->head, &hdr, sizeof(hdr));
+    ring_put(br, br->head + sizeof(hdr), data, len);
+    br->head += need;
+    err = dpl_mutex_release(&br->mutex);
+    assert(err == DPL_OK);
+
+    UWB_BRIDGE_STATS_INC(published);
+    if (br->notify) {
+        br->notify(br->notify_arg);
+    }
+    return OS_OK;
+}
+
+/**
+ * @fn uwb_bridge_open(struct uwb_bridge_instance * br)
+ * @brief Open a reader, it receives records published from now on.
+ *
+ * @param br    Pointer to struct uwb_bridge_instance.
+ *
+ * @return reader index, -1 if all readers are open
+ */
+int
+uwb_bridge_open(struct uwb_bridge_instance * br)
+{
+    int rc = -1;
+
+    dpl_error_t err = dpl_mutex_pend(&br->mutex, DPL_TIMEOUT_NEVER);
+    assert(err == DPL_OK);
+    for (int i = 0; i < MYNEWT_VAL(UWB_BRIDGE_MAX_READERS); i++) {
+        struct uwb_bridge_reader * r = &br->readers[i];
+        if (!r->active) {
+            *r = (struct uwb_bridge_reader){
+                .rd = br->head,
+                .seq = br->seq,
+                .active = 1
+            };
+            rc = i;
+            break;
+        }
+    }
+    err = dpl_mutex_release(&br->mutex);
+    assert(err == DPL_OK);
+    return rc;
+}
+
+/**
+ * @fn uwb_bridge_close(struct uwb_bridge_instance * br, int reader)
+ * @brief Close a reader.
+ *
+ * @param br      Pointer to struct uwb_bridge_instance.
+ * @param reader  Reader index from uwb_bridge_open.
+ *
+ * @return void
+ */
+void
+uwb_bridge_close(struct uwb_bridge_instance * br, int reader)
+{
+    assert(reader >= 0 && reader < MYNEWT_VAL(UWB_BRIDGE_MAX_READERS));
+    br->readers[reader].active = 0;
+}
+
+/**
+ * @fn uwb_bridge_read(struct uwb_bridge_instance * br, int reader, struct uwb_bridge_hdr * hdr, char * dst, uint16_t len)
+ * @brief Take the next record of a reader. Records overwritten before the
+ * reader got to them are added to its dropped count.
+ *
+ * @param br      Pointer to struct uwb_bridge_instance.
+ * @param reader  Reader index from uwb_bridge_open.
+ * @param hdr     Record header, hdr->len is the full payload length.
+ * @param dst     Payload, not terminated.
+ * @param len     Size of dst, payloads are cut to it.
+ *
+ * @return payload bytes copied, 0 if no record is pending
+ */
+int
+uwb_bridge_read(struct uwb_bridge_instance * br, int reader, struct uwb_bridge_hdr * hdr, char * dst, uint16_t len)
+{
+    struct uwb_bridge_reader * r = &br->readers[reader];
+    uint32_t lost = 0, usec;
+    int rc = 0;
+
+    assert(reader >= 0 && reader < MYNEWT_VAL(UWB_BRIDGE_MAX_READERS));
+    dpl_error_t err = dpl_mutex_pend(&br->mutex, DPL_TIMEOUT_NEVER);
+    assert(err == DPL_OK);
+    if ((int32_t)(r->rd - br->tail) < 0) {
+        r->rd = br->tail;
+    }
+    if (r->rd != br->head) {
+        ring_get(br, r->rd, hdr, sizeof(*hdr));
+        rc = (hdr->len < len) ? hdr->len : len;
+        ring_get(br, r->rd + sizeof(*hdr), dst, rc);
+        r->rd += RECORD_SIZE(hdr->len);
+        lost = hdr->seq - r->seq;
+        r->seq = hdr->seq + 1;
+        r->dropped += lost;
+        r->delivered++;
+
+        usec = os_cputime_ticks_to_usecs(os_cputime_get32() - hdr->stamp);
+        br->latency.n++;
+        br->latency.sum += usec;
+        if (usec > br->latency.max) {
+            br->latency.max = usec;
+        }
+    }
+    err = dpl_mutex_release(&br->mutex);
+    assert(err == DPL_OK);
+
+    if (rc) {
+        UWB_BRIDGE_STATS_INC(delivered);
+        UWB_BRIDGE_STATS_INCN(dropped, lost);
+    }
+    return rc;
+}
+
+/**
+ * @fn uwb_bridge_pending(struct uwb_bridge_instance * br, int reader)
+ * @brief Bytes of records waiting for a reader, headers included.
+ *
+ * @param br      Pointer to struct uwb_bridge_instance.
+ * @param reader  Reader index from uwb_bridge_open.
+ *
+ * @return bytes
+ */
+uint32_t
+uwb_bridge_pending(struct uwb_bridge_instance * br, int reader)
+{
+    struct uwb_bridge_reader * r = &br->readers[reader];
+    uint32_t rd;
+
+    dpl_error_t err = dpl_mutex_pend(&br->mutex, DPL_TIMEOUT_NEVER);
+    assert(err == DPL_OK);
+    rd = ((int32_t)(r->rd - br->tail) < 0) ? br->tail : r->rd;
+    rd = br->head - rd;
+    err = dpl_mutex_release(&br->mutex);
+    assert(err == DPL_OK);
+    return rd;
+}
+
+#if MYNEWT_VAL(UWB_BRIDGE_RANGE)
+
+/* The encoder buffer holds a whole record, it is flushed once at record_end */
+static int
+range_flush(void * arg, const char * data, uint16_t len)
+{
+    struct uwb_bridge_instance * br = (struct uwb_bridge_instance *) arg;
+    if (len && data[len - 1] == '\n') {
+        uwb_bridge_publish(br, UWB_BRIDGE_TYPE_RANGE, data, len - 1);
+    }
+    return len;
+}
+#endif
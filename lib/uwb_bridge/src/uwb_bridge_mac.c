@@ -0,0 +1,160 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file uwb_bridge_mac.c
+ * @brief Mac side of the bridge, range records from two way range completions
+ */
+
+#include <stdio.h>
+#include <assert.h>
+#include <os/os.h>
+#include <sysinit/sysinit.h>
+#include <uwb/uwb_ftypes.h>
+#include <uwb_rng/uwb_rng.h>
+#include <uwb_bridge/uwb_bridge.h>
+
+#if MYNEWT_VAL(UWB_BRIDGE_RANGE)
+static bool complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+#endif
+
+/**
+ * @fn uwb_bridge_attach(struct uwb_bridge_instance * br, struct uwb_dev * inst)
+ * @brief Publish records for a device, with UWB_BRIDGE_RANGE a range record
+ * for every completed two way range.
+ *
+ * @param br    Pointer to struct uwb_bridge_instance.
+ * @param inst  Pointer to struct uwb_dev.
+ *
+ * @return void
+ */
+void
+uwb_bridge_attach(struct uwb_bridge_instance * br, struct uwb_dev * inst)
+{
+    assert(br && inst);
+    if (br->status.attached) {
+        return;
+    }
+    br->dev_inst = inst;
+#if MYNEWT_VAL(UWB_BRIDGE_RANGE)
+    br->cbs = (struct uwb_mac_interface){
+        .id = UWBEXT_BRIDGE,
+        .inst_ptr = (void *) br,
+        .complete_cb = complete_cb
+    };
+    uwb_mac_append_interface(inst, &br->cbs);
+#endif
+    br->status.attached = 1;
+}
+
+/**
+ * @fn uwb_bridge_detach(struct uwb_bridge_instance * br)
+ * @brief Stop publishing records for the attached device.
+ *
+ * @param br    Pointer to struct uwb_bridge_instance.
+ *
+ * @return void
+ */
+void
+uwb_bridge_detach(struct uwb_bridge_instance * br)
+{
+    if (!br->status.attached) {
+        return;
+    }
+#if MYNEWT_VAL(UWB_BRIDGE_RANGE)
+    uwb_mac_remove_interface(br->dev_inst, br->cbs.id);
+#endif
+    br->dev_inst = NULL;
+    br->status.attached = 0;
+}
+
+#if MYNEWT_VAL(UWB_BRIDGE_RANGE)
+/**
+ * @fn complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+ * @brief Publish the completed range, same format as rng_encode()
+ * {"utime": 208317053,"twr": {"rng": "0.703","uid": "1234"},"uid": "55a6"}
+ *
+ * @param inst  Pointer to struct uwb_dev.
+ * @param cbs   Pointer to struct uwb_mac_interface.
+ *
+ * @return false, other interfaces see the completion too
+ */
+static bool
+complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct uwb_bridge_instance * br = (struct uwb_bridge_instance *) cbs->inst_ptr;
+    struct uwb_rng_instance * rng;
+    struct json_stream * js = &br->js;
+    twr_frame_t * frame;
+    uint16_t idx;
+
+    if (inst->fctrl != FCNTL_IEEE_RANGE_16) {
+        return false;
+    }
+    rng = (struct uwb_rng_instance *) uwb_mac_find_cb_inst_ptr(inst, UWBEXT_RNG);
+    if (rng == NULL) {
+        return false;
+    }
+    idx = rng->idx % rng->nframes;
+    frame = rng->frames[idx];
+    switch (frame->code) {
+        case DWT_SS_TWR_FINAL:
+        case DWT_DS_TWR_FINAL:
+        case DWT_SS_TWR_EXT_FINAL:
+        case DWT_DS_TWR_EXT_FINAL:
+            break;
+        default:
+            return false;
+    }
+
+    json_stream_record_start(js);
+    json_stream_object_start(js);
+    json_stream_key(js, "utime");
+    json_stream_uint(js, os_cputime_ticks_to_usecs(os_cputime_get32()));
+    json_stream_key(js, "twr");
+    json_stream_object_start(js);
+    json_stream_key(js, "rng");
+    json_stream_float(js, uwb_rng_tof_to_meters(uwb_rng_twr_to_tof(rng, idx)));
+    json_stream_key(js, "uid");
+    json_stream_hex16(js, frame->dst_address);
+    json_stream_object_finish(js);
+    json_stream_key(js, "uid");
+    json_stream_hex16(js, frame->src_address);
+    json_stream_object_finish(js);
+    json_stream_record_end(js);
+    return false;
+}
+#endif
+
+/**
+ * @fn uwb_bridge_pkg_init(void)
+ * @brief API to initialise the package, a bridge attached to device 0.
+ *
+ * @return void
+ */
+void
+uwb_bridge_pkg_init(void)
+{
+    struct uwb_bridge_instance * br = uwb_bridge_init(NULL);
+#if MYNEWT_VAL(UWB_DEVICE_0)
+    uwb_bridge_attach(br, uwb_dev_idx_lookup(0));
+#else
+    (void) br;
+#endif
+}
@@ -0,0 +1,151 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file uwb_bridge_tsync.c
+ * @brief Host clock disciplined to the WCS master timeline
+ */
+
+#include <string.h>
+#include <math.h>
+#include <syscfg/syscfg.h>
+#include <uwb_bridge/uwb_bridge_tsync.h>
+
+/**
+ * @fn uwb_bridge_tsync_init(struct uwb_bridge_tsync * ts)
+ * @brief Forget the exchanges and unset the clock.
+ *
+ * @param ts    Pointer to struct uwb_bridge_tsync.
+ *
+ * @return void
+ */
+void
+uwb_bridge_tsync_init(struct uwb_bridge_tsync * ts)
+{
+    memset(ts, 0, sizeof(struct uwb_bridge_tsync));
+    ts->stats.delay_min = INT64_MAX;
+}
+
+/* Step the clock to the offset of an exchange, the rate is kept */
+static void
+tsync_step(struct uwb_bridge_tsync * ts, const struct uwb_bridge_tsync_sample * s)
+{
+    ts->clock.host_ref = s->host;
+    ts->clock.master_ref = s->host + s->offset;
+    ts->stats.steps++;
+}
+
+/* Steer the clock with the exchange of least delay in the window, if not used yet */
+static int
+tsync_servo(struct uwb_bridge_tsync * ts)
+{
+    struct uwb_bridge_tsync_sample * best = NULL;
+    int64_t dt, error;
+
+    for (uint16_t i = 0; i < MYNEWT_VAL(UWB_BRIDGE_TSYNC_WINDOW) && i < ts->idx; i++) {
+        struct uwb_bridge_tsync_sample * s = &ts->window[i];
+        if (best == NULL || s->delay < best->delay) {
+            best = s;
+        }
+    }
+    // An older exchange becomes the least delayed as better ones leave, it is behind the reference then
+    if (best->used || (ts->state && best->host <= ts->clock.host_ref)) {
+        return 0;
+    }
+    best->used = true;
+    ts->stats.used++;
+
+    switch (ts->state) {
+        case 0:
+            tsync_step(ts, best);
+            ts->state = 1;
+            return 1;
+        case 1:
+            // Rate from the drift of the offset since the step, once long enough for the delay noise to average out
+            dt = best->host - ts->clock.host_ref;
+            if (dt < MYNEWT_VAL(UWB_BRIDGE_TSYNC_RATE_INTERVAL)) {
+                best->used = false;
+                ts->stats.used--;
+                return 0;
+            }
+            ts->clock.rate = (double)(best->offset - (ts->clock.master_ref - ts->clock.host_ref)) / dt;
+            tsync_step(ts, best);
+            ts->stats.steps--;
+            ts->clock.flags |= UWB_BRIDGE_TSYNC_LOCKED;
+            ts->state = 2;
+            return 1;
+        default:
+            break;
+    }
+
+    dt = best->host - ts->clock.host_ref;
+    error = best->host + best->offset - uwb_bridge_tsync_to_master(&ts->clock, best->host);
+    ts->stats.error = error;
+    if (error > MYNEWT_VAL(UWB_BRIDGE_TSYNC_STEP) || error < -MYNEWT_VAL(UWB_BRIDGE_TSYNC_STEP)) {
+        // Lost, e.g. the node rebooted or its wcs changed master, start over
+        tsync_step(ts, best);
+        ts->clock.rate = 0;
+        ts->clock.flags &= ~UWB_BRIDGE_TSYNC_LOCKED;
+        ts->clock.jitter = 0;
+        ts->state = 1;
+        return 1;
+    }
+    ts->clock.master_ref = uwb_bridge_tsync_to_master(&ts->clock, best->host)
+                         + (int64_t)(MYNEWT_VAL(UWB_BRIDGE_TSYNC_KP) * error);
+    ts->clock.host_ref = best->host;
+    ts->clock.rate += MYNEWT_VAL(UWB_BRIDGE_TSYNC_KI) * error / dt;
+    ts->clock.jitter = (ts->clock.jitter == 0) ? fabsf((float)error) :
+        sqrtf(ts->clock.jitter * ts->clock.jitter + ((float)error * error - ts->clock.jitter * ts->clock.jitter) / 16);
+    return 1;
+}
+
+/**
+ * @fn uwb_bridge_tsync_update(struct uwb_bridge_tsync * ts, int64_t t1, int64_t t2, int64_t t3, int64_t t4)
+ * @brief Add an exchange and steer the clock.
+ *
+ * @param ts    Pointer to struct uwb_bridge_tsync.
+ * @param t1    Host time of the request, ns.
+ * @param t2    Master time of its receipt, ns.
+ * @param t3    Master time of the reply, ns.
+ * @param t4    Host time of the reply's receipt, ns.
+ *
+ * @return 1 if the clock changed, 0 if the exchange was only kept, -1 if rejected
+ */
+int
+uwb_bridge_tsync_update(struct uwb_bridge_tsync * ts, int64_t t1, int64_t t2, int64_t t3, int64_t t4)
+{
+    struct uwb_bridge_tsync_sample s = {
+        .host = t1 + (t4 - t1) / 2,
+        .offset = ((t2 - t1) + (t3 - t4) - ts->asymmetry) / 2,
+        .delay = (t4 - t1) - (t3 - t2)
+    };
+
+    ts->stats.exchanges++;
+    ts->stats.delay = s.delay;
+    if (s.delay < 0 || t3 < t2 || (ts->idx && s.host <= ts->window[(uint16_t)(ts->idx - 1) %
+                                                   MYNEWT_VAL(UWB_BRIDGE_TSYNC_WINDOW)].host)) {
+        ts->stats.rejected++;
+        return -1;
+    }
+    if (s.delay < ts->stats.delay_min) {
+        ts->stats.delay_min = s.delay;
+    }
+    ts->window[ts->idx++ % MYNEWT_VAL(UWB_BRIDGE_TSYNC_WINDOW)] = s;
+    return tsync_servo(ts);
+}
@@ -60,6 +60,8 @@ STATS_SECT_START(uwb_ccp_stat_section)
     STATS_SECT_ENTRY(rx_complete)
     STATS_SECT_ENTRY(rx_relayed)
     STATS_SECT_ENTRY(rx_unsolicited)
+    STATS_SECT_ENTRY(rx_foreign)
+    STATS_SECT_ENTRY(master_switch)
     STATS_SECT_ENTRY(txrx_error)
     STATS_SECT_ENTRY(tx_start_error)
     STATS_SECT_ENTRY(tx_relay_error)
@@ -131,6 +133,7 @@ struct uwb_ccp_status {
     uint16_t start_rx_error:1;        //!< Set for start request error
     uint16_t rx_timeout_error:1;      //!< Receive timeout error 
     uint16_t timer_enabled:1;         //!< Indicates timer is enabled 
+    uint16_t master_pending:1;        //!< Switch to next_master at the next superframe
 };
 
 //! Extension ids for services.
@@ -151,6 +154,14 @@ struct uwb_ccp_config {
     uint16_t tx_holdoff_dly;          //!< Relay nodes holdoff
 };
 
+//! Master to follow from the next superframe on, see uwb_ccp_set_master()
+struct uwb_ccp_next_master {
+    uint64_t euid;                    //!< Master EUID
+    uint64_t master_epoch;            //!< Transmission timestamp of a blink heard from it
+    uint64_t local_epoch;             //!< Local time of that blink
+    uint32_t period;                  //!< Its ccp period, dwt usec
+};
+
 //! uwb_ccp instance parameters.
 struct uwb_ccp_instance {
     struct uwb_dev * dev_inst;                      //!< Pointer to struct uwb_dev
@@ -166,6 +177,7 @@ struct uwb_ccp_instance {
 #endif
     struct uwb_mac_interface cbs;                   //!< MAC Layer Callbacks
     uint64_t master_euid;                           //!< Clock Master EUID, used to reset wcs if master changes
+    struct uwb_ccp_next_master next_master;         //!< Handover target, valid with status.master_pending
     struct dpl_sem sem;                             //!< Structure containing os semaphores
     struct dpl_event postprocess_event;             //!< Structure of callout_postprocess
     struct uwb_ccp_status status;                   //!< uwb_ccp status parameters
@@ -196,6 +208,8 @@ void uwb_ccp_set_postprocess(struct uwb_ccp_instance * inst, dpl_event_fn * uwb_
 void uwb_ccp_set_tof_comp_cb(struct uwb_ccp_instance * inst, uwb_ccp_tof_compensation_cb_t tof_comp_cb);
 void uwb_ccp_start(struct uwb_ccp_instance *ccp, uwb_ccp_role_t role);
 void uwb_ccp_stop(struct uwb_ccp_instance *ccp);
+void uwb_ccp_set_master(struct uwb_ccp_instance *ccp, uint64_t euid, uint64_t master_epoch,
+                        uint64_t local_epoch, uint32_t period);
 
 /**
  * @}
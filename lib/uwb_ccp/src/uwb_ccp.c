@@ -42,6 +42,9 @@
 #if MYNEWT_VAL(UWB_WCS_ENABLED)
 #include <uwb_wcs/uwb_wcs.h>
 #endif
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+#include <uwb_sec/uwb_sec.h>
+#endif
 
 //#define DIAGMSG(s,u) printf(s,u)
 #ifndef DIAGMSG
@@ -95,6 +98,8 @@ STATS_NAME_START(uwb_ccp_stat_section)
     STATS_NAME(uwb_ccp_stat_section, rx_complete)
     STATS_NAME(uwb_ccp_stat_section, rx_relayed)
     STATS_NAME(uwb_ccp_stat_section, rx_unsolicited)
+    STATS_NAME(uwb_ccp_stat_section, rx_foreign)
+    STATS_NAME(uwb_ccp_stat_section, master_switch)
     STATS_NAME(uwb_ccp_stat_section, txrx_error)
     STATS_NAME(uwb_ccp_stat_section, tx_start_error)
     STATS_NAME(uwb_ccp_stat_section, tx_relay_error)
@@ -192,6 +197,37 @@ ccp_master_timer_ev_cb(struct dpl_event *ev)
     }
 }
 
+/**
+ * @fn ccp_apply_next_master(struct uwb_ccp_instance * ccp)
+ * @brief Take over the timing of the master set by uwb_ccp_set_master(), its
+ * last blink before now becomes the epoch so the next listen is for its next
+ * blink. wcs restarts from that blink.
+ *
+ * @param ccp  Pointer to struct uwb_ccp_instance.
+ * @return void
+ */
+static void
+ccp_apply_next_master(struct uwb_ccp_instance * ccp)
+{
+    struct uwb_ccp_next_master * next = &ccp->next_master;
+    uint64_t period = (uint64_t)next->period << 16;
+    uint64_t elapsed = (uwb_read_systime(ccp->dev_inst) - next->local_epoch) & 0x0FFFFFFFFFFUL;
+    uint64_t n = elapsed / period;
+
+    ccp->master_euid = next->euid;
+    ccp->master_epoch.timestamp = next->master_epoch + n * period;
+    ccp->local_epoch = (next->local_epoch + n * period) & 0x0FFFFFFFFFFUL;
+    ccp->period = next->period;
+    ccp->os_epoch = os_cputime_get32()
+        - os_cputime_usecs_to_ticks((uint32_t)uwb_dwt_usecs_to_usecs((elapsed - n * period) >> 16));
+    ccp->status.rx_timeout_error = 0;
+    ccp->status.master_pending = 0;
+#if MYNEWT_VAL(UWB_WCS_ENABLED)
+    ccp->wcs->status.initialized = 0;
+#endif
+    CCP_STATS_INC(master_switch);
+}
+
 /**
  * @fn ccp_slave_timer_ev_cb(struct os_event *ev)
  * @brief The OS scheduler is not accurate enough for the timing requirement of an RTLS system.
@@ -215,6 +251,11 @@ ccp_slave_timer_ev_cb(struct dpl_event *ev)
     /* Precalc / update blink frame duration */
     ccp->blink_frame_duration = uwb_phy_frame_duration(inst, sizeof(uwb_ccp_blink_frame_t));
 
+    /* Handover, listening for the new master from here */
+    if (ccp->status.master_pending) {
+        ccp_apply_next_master(ccp);
+    }
+
 
     /* Sync lost since earlier, just set a long rx timeout and
      * keep listening */
@@ -584,6 +625,17 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
     if (inst->status.lde_error)
         return true;
 
+    /* A neighbouring cell's master heard while synchronised, leave it to
+     * uwb_xcs and keep listening for our own */
+    if (frame->euid != ccp->master_euid && ccp->status.valid && !ccp->status.rx_timeout_error) {
+        CCP_STATS_INC(rx_foreign);
+        if (uwb_start_rx(inst).start_rx_error) {
+            ccp->status.rx_timeout_error = 1;
+            dpl_sem_release(&ccp->sem);
+        }
+        return false;
+    }
+
     /* A good ccp packet has been received, stop the receiver */
     uwb_stop_rx(inst); //Prevent timeout event
     
@@ -677,8 +729,12 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
          * original master's timestamp */
         tx_frame.transmission_interval = frame->transmission_interval - tx_delay;
 
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+        uwb_sec_write_tx(inst, tx_frame.array, sizeof(uwb_ccp_blink_frame_t));
+#else
         uwb_write_tx(inst, tx_frame.array, 0, sizeof(uwb_ccp_blink_frame_t));
         uwb_write_tx_fctrl(inst, sizeof(uwb_ccp_blink_frame_t), 0);
+#endif
         ccp->status.start_tx_error = uwb_start_tx(inst).start_tx_error;
         if (ccp->status.start_tx_error){
             CCP_STATS_INC(tx_relay_error);
@@ -876,8 +932,12 @@ ccp_send(struct uwb_ccp_instance *ccp, uwb_dev_modes_t mode)
     frame->short_address = inst->my_short_address;
     frame->transmission_interval = ((uint64_t)ccp->period << 16);
 
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+    uwb_sec_write_tx(inst, frame->array, sizeof(uwb_ccp_blink_frame_t));
+#else
     uwb_write_tx(inst, frame->array, 0, sizeof(uwb_ccp_blink_frame_t));
     uwb_write_tx_fctrl(inst, sizeof(uwb_ccp_blink_frame_t), 0);
+#endif
     uwb_set_wait4resp(inst, false);    
     ccp->status.start_tx_error = uwb_start_tx(inst).start_tx_error;
     if (ccp->status.start_tx_error ){
@@ -984,3 +1044,43 @@ uwb_ccp_stop(struct uwb_ccp_instance *ccp)
     assert(ccp);
     os_cputime_timer_stop(&ccp->timer);
 }
+
+/**
+ * @fn uwb_ccp_set_master(struct uwb_ccp_instance *ccp, uint64_t euid, uint64_t master_epoch,
+ *                        uint64_t local_epoch, uint32_t period)
+ * @brief Hand a slave over to another master, whose blink has been heard.
+ * The slave timer is moved ahead of the next blink of the new master and
+ * makes the switch there, the rest of the current superframe runs until
+ * that blink starts the next. The caller keeps the radio free around it.
+ *
+ * @param ccp           Pointer to struct uwb_ccp_instance.
+ * @param euid          New master EUID.
+ * @param master_epoch  Transmission timestamp of a blink of the new master.
+ * @param local_epoch   Local time of that blink, less time of flight and relay delay.
+ * @param period        Ccp period of the new master, dwt usec.
+ * @return void
+ */
+void
+uwb_ccp_set_master(struct uwb_ccp_instance *ccp, uint64_t euid, uint64_t master_epoch,
+                   uint64_t local_epoch, uint32_t period)
+{
+    assert(ccp && period);
+    ccp->status.master_pending = 0;
+    ccp->next_master = (struct uwb_ccp_next_master){
+        .euid = euid,
+        .master_epoch = master_epoch,
+        .local_epoch = local_epoch,
+        .period = period
+    };
+    ccp->status.master_pending = 1;
+
+    /* Time to the next blink of the new master, one more period if too close to make */
+    uint64_t elapsed = (uwb_read_systime(ccp->dev_inst) - local_epoch) & 0x0FFFFFFFFFFUL;
+    uint32_t remaining = (uint32_t)uwb_dwt_usecs_to_usecs(period - (uint32_t)((elapsed >> 16) % period));
+    if (remaining < MYNEWT_VAL(OS_LATENCY) + ccp->blink_frame_duration) {
+        remaining += (uint32_t)uwb_dwt_usecs_to_usecs(period);
+    }
+    os_cputime_timer_stop(&ccp->timer);
+    os_cputime_timer_start(&ccp->timer, os_cputime_get32()
+        + os_cputime_usecs_to_ticks(remaining - MYNEWT_VAL(OS_LATENCY) - ccp->blink_frame_duration));
+}
@@ -47,6 +47,8 @@ extern "C" {
 #include <lwip/netif.h>
 #include <lwip/raw.h>
 
+#define UWB_LWIP_CODE (0x574c)          //!< 'L' 'W', identifies acknowledged lwip data frames
+
 //! Lwip config parameters.
 typedef struct _uwb_lwip_config_t{
    uint16_t poll_resp_delay;    //!< Delay between frames, in UWB microseconds.
@@ -70,6 +72,8 @@ typedef struct _uwb_lwip_status_t{
     uint32_t rx_error:1;               //!< Set for receive error
     uint32_t rx_timeout_error:1;       //!< Set for receive timeout error 
     uint32_t request_timeout:1;        //!< Set for request timeout
+    uint32_t ack_pending:1;            //!< Waiting for a hardware acknowledgement
+    uint32_t acked:1;                  //!< Acknowledgement received
 }uwb_lwip_status_t;
 
 //! Lwip instance parameters.
@@ -89,6 +93,8 @@ typedef struct _uwb_lwip_instance_t{
     uint16_t buf_idx;                      //!< Indicates number of buffer instances for the chosen bsp 
     uint16_t buf_len;                      //!< Indicates buffer length 
     uint16_t dst_addr;                     //!< Destination address    
+    uint8_t frame_seq_num;                 //!< Sequence number of acknowledged frames
+    uint8_t ack_seq_num;                   //!< Sequence number of the frame awaiting acknowledgement
     struct netif lwip_netif;               //!< Network interface
     struct raw_pcb * pcb;                  //!< Pointer to raw_pcb structure                       
     void * payload_ptr;                    //!< Pointer to payload 
@@ -40,7 +40,12 @@
 #if MYNEWT_VAL(UWB_LWIP_ENABLED)
 
 #include <uwb/uwb.h>
+#include <uwb/uwb_mac.h>
 #include <uwb/uwb_ftypes.h>
+#if MYNEWT_VAL(UWB_LWIP_AGGR)
+/* Ahead of the lwIP headers, their stats_init() macro hides the one of sys/stats */
+#include <aggr/aggr.h>
+#endif
 #include <uwb_lwip/uwb_lwip.h>
 
 #include "sysinit/sysinit.h"
@@ -231,32 +236,105 @@ uwb_lwip_write(uwb_lwip_instance_t * lwip, struct pbuf *p, uwb_lwip_modes_t mode
 	assert(p != NULL);
 
 	char *id_pbuf, *temp_buf;
-	id_pbuf = (char *)malloc((lwip->buf_len) + 4+2);
+	uint16_t hdr_len = 4+2;
+	bool ack_req = false;
+	uint16_t retries = MYNEWT_VAL(UWB_LWIP_ACK_RETRIES);
+	uint32_t ack_timeout = 0;
+	os_time_t ack_wait = 0;
+#if MYNEWT_VAL(UWB_LWIP_AGGR)
+	struct aggr_instance * ag = aggr_get_instance();
+	if (ag && (ag->dev_inst != lwip->dev_inst
+			   || sizeof(aggr_frame_t) + AGGR_SUBFRAME_OVERHEAD + lwip->buf_len + hdr_len > ag->max_len))
+		ag = NULL;
+#endif
+#if MYNEWT_VAL(UWB_LWIP_AUTOACK)
+	/* The receiving transceiver acknowledges unicast data frames, this device
+	 * has to run auto-ACK too for the acknowledgement to pass its filter */
+	ack_req = lwip->dev_inst->config.autoack_enabled && lwip->dst_addr != UWB_BROADCAST_ADDRESS;
+#if MYNEWT_VAL(UWB_LWIP_AGGR)
+	/* Aggregates carry their own selective ack */
+	ack_req = ack_req && ag == NULL;
+#endif
+	if (ack_req)
+		hdr_len = sizeof(ieee_rng_request_frame_t);
+#endif
+	id_pbuf = (char *)malloc((lwip->buf_len) + hdr_len);
 	assert(id_pbuf);
-	/* Append the 'L' 'W' 'I' 'P' Identifier */
-	*(id_pbuf + 0) = 'L';	*(id_pbuf + 1) = 'W';
-	*(id_pbuf + 2) = 'I';	*(id_pbuf + 3) = 'P';
+	if (ack_req) {
+		ieee_rng_request_frame_t * hdr = (ieee_rng_request_frame_t *)id_pbuf;
+		hdr->fctrl = FCNTL_IEEE_DATA_ACK_16;
+		hdr->seq_num = lwip->frame_seq_num++;
+		hdr->PANID = lwip->dev_inst->pan_id;
+		hdr->dst_address = lwip->dst_addr;
+		hdr->src_address = lwip->dev_inst->uid;
+		hdr->code = UWB_LWIP_CODE;
+		lwip->ack_seq_num = hdr->seq_num;
+	} else {
+		/* Append the 'L' 'W' 'I' 'P' Identifier */
+		*(id_pbuf + 0) = 'L';	*(id_pbuf + 1) = 'W';
+		*(id_pbuf + 2) = 'I';	*(id_pbuf + 3) = 'P';
 
-	/* Append the destination Short Address */
-	*(id_pbuf + 4) = (char)((lwip->dst_addr >> 0) & 0xFF);
-	*(id_pbuf + 5) = (char)((lwip->dst_addr >> 8) & 0xFF);
+		/* Append the destination Short Address */
+		*(id_pbuf + 4) = (char)((lwip->dst_addr >> 0) & 0xFF);
+		*(id_pbuf + 5) = (char)((lwip->dst_addr >> 8) & 0xFF);
+	}
 
 	temp_buf = (char *)p;
 	/* Copy the LWIP packet after LWIP Id */
-	memcpy(id_pbuf+4+2, temp_buf, lwip->buf_len);
+	memcpy(id_pbuf+hdr_len, temp_buf, lwip->buf_len);
+
+#if MYNEWT_VAL(UWB_LWIP_AGGR)
+	if (ag) {
+		/* Queued with the other frames to the destination, a blocking write sends them now */
+		if (aggr_send(ag, lwip->dst_addr, (uint8_t *)id_pbuf, lwip->buf_len+hdr_len) == OS_OK
+			&& mode == LWIP_BLOCKING)
+			aggr_flush(ag, lwip->dst_addr);
+		free(id_pbuf);
+		pbuf_free(p);
+		err = os_sem_release(&lwip->sem);
+		assert(err == OS_OK);
+		return lwip->dev_inst->status;
+	}
+#endif
 
-	uwb_write_tx(lwip->dev_inst, (uint8_t *)id_pbuf, 0, lwip->buf_len+4+2);
+	uwb_write_tx(lwip->dev_inst, (uint8_t *)id_pbuf, 0, lwip->buf_len+hdr_len);
 	free(id_pbuf);
     pbuf_free(p);
     
-	uwb_write_tx_fctrl(lwip->dev_inst, lwip->buf_len+4+2, 0);
+	uwb_write_tx_fctrl(lwip->dev_inst, lwip->buf_len+hdr_len, 0);
 	lwip->lwip_netif.flags = NETIF_FLAG_UP | NETIF_FLAG_LINK_UP ;
-	lwip->status.start_tx_error = uwb_start_tx(lwip->dev_inst).start_tx_error;
 
-	if( mode == LWIP_BLOCKING )
-		err = os_sem_pend(&lwip->sem, OS_TIMEOUT_NEVER); // Wait for completion of transactions units os_clicks
-	else
-		err = os_sem_pend(&lwip->sem, 500); // Wait for completion of transactions units os_clicks
+	lwip->status.acked = 0;
+	lwip->status.ack_pending = ack_req;
+	if (ack_req) {
+		ack_timeout = uwb_phy_frame_duration(lwip->dev_inst, sizeof(ieee_ack_frame_t) + 2)
+					  + MYNEWT_VAL(UWB_LWIP_ACK_TIMEOUT);
+		/* Bound the wait should no interrupt end it, a millisecond over the frame and its ack */
+		ack_wait = dpl_time_ms_to_ticks32((uwb_phy_frame_duration(lwip->dev_inst, lwip->buf_len + hdr_len)
+										   + ack_timeout) / 1000 + 2);
+	}
+	do {
+		/* The frame stays in the transmit buffer, a resend only restarts tx */
+		if (ack_req) {
+			uwb_set_wait4resp(lwip->dev_inst, true);
+			uwb_set_rx_timeout(lwip->dev_inst, ack_timeout);
+		}
+		lwip->status.start_tx_error = uwb_start_tx(lwip->dev_inst).start_tx_error;
+
+		if (ack_req) {
+			err = os_sem_pend(&lwip->sem, ack_wait);
+			if (err == OS_TIMEOUT) {
+				/* Nothing ended the wait, e.g. the receiver stopped on another frame, take the ack as lost */
+				uwb_phy_forcetrxoff(lwip->dev_inst);
+				err = OS_OK;
+			}
+		} else if( mode == LWIP_BLOCKING )
+			err = os_sem_pend(&lwip->sem, OS_TIMEOUT_NEVER); // Wait for completion of transactions units os_clicks
+		else
+			err = os_sem_pend(&lwip->sem, 500); // Wait for completion of transactions units os_clicks
+	} while (lwip->status.ack_pending && !lwip->status.acked && err == OS_OK
+			 && !lwip->status.start_tx_error && retries--);
+	lwip->status.ack_pending = 0;
 
     if (os_sem_get_count(&lwip->sem) == 0) {
         os_sem_release(&lwip->sem);
@@ -280,6 +358,24 @@ uwb_lwip_start_rx(uwb_lwip_instance_t * lwip, uint16_t timeout)
     uwb_start_rx(lwip->dev_inst);
 }
 
+/**
+ * End an acknowledgement wait without the ack, uwb_lwip_write() resends.
+ * The receiver is off once a frame or an error ended the ack window.
+ *
+ * @param lwip   Pointer to uwb_lwip_instance_t.
+ * @return void
+ */
+static void
+ack_lost(uwb_lwip_instance_t * lwip)
+{
+    if (lwip->status.ack_pending && os_sem_get_count(&lwip->sem) == 0) {
+        os_error_t err = os_sem_release(&lwip->sem);
+        assert(err == OS_OK);
+    }
+}
+
+static bool rx_frame(uwb_lwip_instance_t * lwip, struct uwb_dev * inst);
+
 /**
  * API to confirm receive is complete. 
  * 
@@ -290,6 +386,37 @@ static bool
 rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
 {
     uwb_lwip_instance_t * lwip = (uwb_lwip_instance_t *)cbs->inst_ptr;
+    bool ret;
+#if MYNEWT_VAL(UWB_LWIP_AUTOACK)
+    if (lwip->status.ack_pending && (inst->fctrl & FCNTL_IEEE_FTYPE_MASK) == FCNTL_IEEE_ACK) {
+        if (((ieee_ack_frame_t *)inst->rxbuf)->seq_num != lwip->ack_seq_num) {
+            ack_lost(lwip);
+            return false;
+        }
+        lwip->status.acked = 1;
+        if (os_sem_get_count(&lwip->sem) == 0) {
+            os_error_t err = os_sem_release(&lwip->sem);
+            assert(err == OS_OK);
+        }
+        return true;
+    }
+#endif
+    ret = rx_frame(lwip, inst);
+    /* Any other frame ends the ack window */
+    ack_lost(lwip);
+    return ret;
+}
+
+static bool
+rx_frame(uwb_lwip_instance_t * lwip, struct uwb_dev * inst)
+{
+    uint16_t hdr_len = 4+2;
+#if MYNEWT_VAL(UWB_LWIP_AUTOACK)
+    ieee_rng_request_frame_t * hdr = (ieee_rng_request_frame_t *)inst->rxbuf;
+    if (inst->fctrl == FCNTL_IEEE_DATA_ACK_16 && hdr->code == UWB_LWIP_CODE)
+        hdr_len = sizeof(ieee_rng_request_frame_t);
+    else
+#endif
 	if(strncmp((char *)&inst->fctrl, "LW",2))
         return false;
 
@@ -303,12 +430,16 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
     uint16_t pkt_addr;
 
     pkt_addr = (uint8_t)(*(lwip->data_buf[0]+4)) + ((uint8_t)(*(lwip->data_buf[0]+5)) << 8);
+#if MYNEWT_VAL(UWB_LWIP_AUTOACK)
+    if (hdr_len == sizeof(ieee_rng_request_frame_t))
+        pkt_addr = hdr->dst_address;
+#endif
 
     if(pkt_addr == lwip->dev_inst->my_short_address){
         char * data_buf = (char *)malloc(buf_size);
         assert(data_buf != NULL);
 
-        memcpy(data_buf,lwip->data_buf[0]+4+2, buf_size);
+        memcpy(data_buf,lwip->data_buf[0]+hdr_len, buf_size);
 
         struct pbuf * buf = (struct pbuf *)data_buf;
         buf->payload = buf + sizeof(struct pbuf)/sizeof(struct pbuf);
@@ -331,7 +462,10 @@ static bool
 tx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
 {
     uwb_lwip_instance_t * lwip = (uwb_lwip_instance_t *)cbs->inst_ptr;
-	if(strncmp((char *)&inst->fctrl, "LW",2)) {
+	if(lwip->status.ack_pending) {
+        /* Completed by the acknowledgement or its timeout */
+        return false;
+    } else if(strncmp((char *)&inst->fctrl, "LW",2)) {
         return false;
     } else if (os_sem_get_count(&lwip->sem) == 0) {
 		os_error_t err = os_sem_release(&lwip->sem);
@@ -352,6 +486,11 @@ static bool
 rx_timeout_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
 {
     uwb_lwip_instance_t * lwip = (uwb_lwip_instance_t *)cbs->inst_ptr;
+    if (lwip->status.ack_pending){
+        /* No acknowledgement, uwb_lwip_write() resends */
+        ack_lost(lwip);
+        return true;
+    }
     if (os_sem_get_count(&lwip->data_sem) == 0){
 		os_error_t err = os_sem_release(&lwip->data_sem);
 		assert(err == OS_OK);
@@ -373,6 +512,11 @@ rx_error_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
 {
     uwb_lwip_instance_t * lwip = (uwb_lwip_instance_t *)cbs->inst_ptr;
 
+    if (lwip->status.ack_pending) {
+        /* A corrupted acknowledgement is taken as lost */
+        ack_lost(lwip);
+        return true;
+    }
 	if (os_sem_get_count(&lwip->data_sem) == 0) {
 		os_error_t err = os_sem_release(&lwip->data_sem);
 		assert(err == OS_OK);
@@ -101,6 +101,7 @@ typedef struct _uwb_pan_status_t{
     uint16_t valid:1;                      //!< Set for valid parameters
     uint16_t start_tx_error:1;             //!< Set for start transmit error
     uint16_t lease_expired:1;              //!< Set when lease has expired
+    uint16_t lease_pending:1;              //!< Set when a deferred lease waits for uwb_pan_commit_lease
 }uwb_pan_status_t;
 
 //! Pan configure parameters
@@ -116,8 +117,18 @@ typedef struct _uwb_pan_config_t{
 //! Pan control parameters
 typedef struct _uwb_pan_control_t{
     uint16_t postprocess:1;           //!< Pan postprocess
+    uint16_t defer_lease:1;           //!< Hold the next lease granted for uwb_pan_commit_lease
 }uwb_pan_control_t;
 
+//! Lease granted while defer_lease is set, e.g. by the pan master of a cell handed over to
+typedef struct _uwb_pan_lease_t{
+    uint16_t pan_id;                  //!< Assigned pan_id
+    uint16_t short_address;           //!< Assigned device_id
+    uint16_t slot_id;                 //!< Assigned slot_id
+    uint16_t lease_time;              //!< Lease time in seconds
+    uint32_t os_epoch;                //!< Cputime of the grant
+}uwb_pan_lease_t;
+
 //! Pan instance parameters
 struct uwb_pan_instance{
     struct uwb_dev * dev_inst;                   //!< pointer to struct uwb_dev
@@ -128,6 +139,7 @@ struct uwb_pan_instance{
     struct dpl_event postprocess_event;           //!< Structure of postprocess event
     struct dpl_callout pan_lease_callout_expiry;  //!< Structure of lease_callout_expiry
     uwb_pan_config_t * config;                //!< DW1000 pan config parameters
+    uwb_pan_lease_t pending;                  //!< Deferred lease, valid with status.lease_pending
     uint16_t nframes;                            //!< Number of buffers defined to store the data
     uint16_t idx;                                //!< Indicates number of DW1000 instances
     pan_frame_t * frames[];                      //!< Buffers to pan frames
@@ -141,6 +153,7 @@ struct uwb_dev_status uwb_pan_listen(struct uwb_pan_instance * pan, uwb_dev_mode
 uwb_pan_status_t uwb_pan_blink(struct uwb_pan_instance * pan, uint16_t role, uwb_dev_modes_t mode, uint64_t delay);
 uwb_pan_status_t uwb_pan_reset(struct uwb_pan_instance * pan, uint64_t delay);
 uint32_t uwb_pan_lease_remaining(struct uwb_pan_instance * pan);
+uwb_pan_status_t uwb_pan_commit_lease(struct uwb_pan_instance * pan);
 
 void uwb_pan_slot_timer_cb(struct dpl_event * ev);
 
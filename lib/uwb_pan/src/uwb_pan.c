@@ -374,6 +374,37 @@ lease_expiry_cb(struct dpl_event * ev)
     }
 }
 
+/**
+ * @fn pan_apply_lease(struct uwb_pan_instance * pan, uint16_t pan_id, uint16_t short_address,
+ *                     uint16_t slot_id, uint16_t lease_time, uint32_t lease_us)
+ * @brief Take the addresses of a lease and start its expiry.
+ *
+ * @param pan          Pointer to struct uwb_pan_instance.
+ * @param lease_time   Lease time granted in seconds, 0 for no expiry.
+ * @param lease_us     Lease time left in usec.
+ *
+ * @return void
+ */
+static void
+pan_apply_lease(struct uwb_pan_instance * pan, uint16_t pan_id, uint16_t short_address,
+                uint16_t slot_id, uint16_t lease_time, uint32_t lease_us)
+{
+    struct uwb_dev * inst = pan->dev_inst;
+
+    uwb_set_uid(inst, short_address);
+    uwb_set_panid(inst, pan_id);
+    inst->slot_id = slot_id;
+    pan->status.valid = true;
+    pan->status.lease_expired = false;
+    dpl_callout_stop(&pan->pan_lease_callout_expiry);
+    if (lease_time > 0) {
+        /* Calculate when our lease expires */
+        uint32_t exp_tics;
+        os_time_ms_to_ticks(lease_us/1000, &exp_tics);
+        dpl_callout_reset(&pan->pan_lease_callout_expiry, exp_tics);
+    }
+}
+
 /**
  * @fn rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
  * @brief This is an internal static function that executes on both the pan_master Node and the TAG/ANCHOR
@@ -435,26 +466,25 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
         }
         break;
     case DWT_PAN_RESP:
-        if(frame->long_address == inst->my_long_address){
+        if(frame->long_address == inst->my_long_address && pan->control.defer_lease){
+            /* TAG/ANCHOR side, lease of another cell kept until the handover */
+            pan->pending = (uwb_pan_lease_t){
+                .pan_id = frame->pan_id,
+                .short_address = frame->short_address,
+                .slot_id = frame->slot_id,
+                .lease_time = frame->lease_time,
+                .os_epoch = os_cputime_get32()
+            };
+            pan->control.defer_lease = false;
+            pan->status.lease_pending = true;
+        } else if(frame->long_address == inst->my_long_address){
             /* TAG/ANCHOR side */
-            inst->uid = frame->short_address;
-            inst->pan_id = frame->pan_id;
-            inst->slot_id = frame->slot_id;
-            pan->status.valid = true;
-            pan->status.lease_expired = false;
-            dpl_callout_stop(&pan->pan_lease_callout_expiry);
-            if (frame->lease_time > 0) {
-                /* Calculate when our lease expires */
-                uint32_t exp_tics;
-                uint32_t lease_us = 1000000;
-                lease_us = (uint32_t)(frame->lease_time)*1000000;
+            uint32_t lease_us = (uint32_t)(frame->lease_time)*1000000;
 #if MYNEWT_VAL(UWB_CCP_ENABLED)
-                struct uwb_ccp_instance *ccp = (struct uwb_ccp_instance*)uwb_mac_find_cb_inst_ptr(inst, UWBEXT_CCP);
-                lease_us -= (inst->rxtimestamp>>16) - (ccp->local_epoch>>16);
+            struct uwb_ccp_instance *ccp = (struct uwb_ccp_instance*)uwb_mac_find_cb_inst_ptr(inst, UWBEXT_CCP);
+            lease_us -= (inst->rxtimestamp>>16) - (ccp->local_epoch>>16);
 #endif
-                os_time_ms_to_ticks(lease_us/1000, &exp_tics);
-                dpl_callout_reset(&pan->pan_lease_callout_expiry, exp_tics);
-            }
+            pan_apply_lease(pan, frame->pan_id, frame->short_address, frame->slot_id, frame->lease_time, lease_us);
         } else {
             return true;
         }
@@ -722,6 +752,35 @@ uwb_pan_lease_remaining(struct uwb_pan_instance * pan)
     return os_time_ticks_to_ms32(rt);
 }
 
+/**
+ * @fn uwb_pan_commit_lease(struct uwb_pan_instance * pan)
+ * @brief Take the lease held back by control.defer_lease, used on handover to
+ * another cell once its clock master is followed. The time since the grant
+ * counts against the lease.
+ *
+ * @param pan    Pointer to struct uwb_pan_instance.
+ *
+ * @return uwb_pan_status_t, valid if a lease was taken
+ */
+uwb_pan_status_t
+uwb_pan_commit_lease(struct uwb_pan_instance * pan)
+{
+    uwb_pan_lease_t * lease = &pan->pending;
+
+    if (!pan->status.lease_pending) {
+        return pan->status;
+    }
+    pan->status.lease_pending = false;
+
+    uint32_t held_us = os_cputime_ticks_to_usecs(os_cputime_get32() - lease->os_epoch);
+    uint32_t lease_us = (uint32_t)(lease->lease_time)*1000000;
+    if (lease->lease_time > 0 && held_us >= lease_us) {
+        STATS_INC(g_stat, lease_expiry);
+        return pan->status;
+    }
+    pan_apply_lease(pan, lease->pan_id, lease->short_address, lease->slot_id, lease->lease_time, lease_us - held_us);
+    return pan->status;
+}
 
 #if MYNEWT_VAL(TDMA_ENABLED)
 /**
@@ -46,6 +46,9 @@ extern "C" {
 #include <euclid/triad.h>
 #include <stats/stats.h>
 #include <uwb_rng/slots.h>
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+#include <uwb_sec/uwb_sec.h>
+#endif
 
 #if MYNEWT_VAL(RNG_STATS)
 STATS_SECT_START(rng_stat_section)
@@ -58,6 +61,21 @@ STATS_SECT_START(rng_stat_section)
     STATS_SECT_ENTRY(tx_error)
     STATS_SECT_ENTRY(rx_timeout)
     STATS_SECT_ENTRY(reset)
+    STATS_SECT_ENTRY(rx_nack)
+#if MYNEWT_VAL(RNG_ADMIT)
+    STATS_SECT_ENTRY(admit_rate)
+    STATS_SECT_ENTRY(admit_util)
+    STATS_SECT_ENTRY(admit_evict)
+    STATS_SECT_ENTRY(tx_nack)
+#endif
+#if MYNEWT_VAL(RNG_SESSIONS)
+    STATS_SECT_ENTRY(session_open)
+    STATS_SECT_ENTRY(session_busy)
+    STATS_SECT_ENTRY(session_full)
+    STATS_SECT_ENTRY(session_miss)
+    STATS_SECT_ENTRY(session_expired)
+    STATS_SECT_ENTRY(session_late)
+#endif
 STATS_SECT_END
 #endif
 
@@ -119,9 +137,17 @@ typedef enum _uwb_rng_modes_t{
     DWT_DS_TWR_NRNG_INVALID,
     DWT_SURVEY_REQUEST = 0x60,
     DWT_SURVEY_BROADCAST,
+    DWT_FLOOR_REFERENCE = 0x70,      //!< Reference pressure broadcast
+    DWT_LINKADAPT_REQUEST = 0x74,    //!< Link profile change request
+    DWT_LINKADAPT_ACK,               //!< Link profile change acknowledgement
+    DWT_AGILITY_SWITCH = 0x78,       //!< Channel and preamble code switch announcement
+    DWT_AGGR_DATA = 0x7C,            //!< Aggregate of subframes
+    DWT_AGGR_ACK,                    //!< Selective acknowledgement of an aggregate
+    DWT_RNG_NACK,                    //!< Request refused by the responder, retry after the time given
     DWT_RTDOA_INVALID = 0x80,
     DWT_RTDOA_REQUEST,
     DWT_RTDOA_RESP,
+    DWT_XCS_LINK = 0x88,             //!< Inter-cell master clock mapping broadcast
 }uwb_rng_modes_t;
 
 //! Range status parameters
@@ -164,6 +190,98 @@ typedef union {
     uint8_t array[sizeof(struct _twr_frame_t)];        //!< Array of size twr_frame
 } twr_frame_t;
 
+//! Reasons a responder refuses a request
+typedef enum _uwb_rng_nack_reason_t{
+    RNG_NACK_RATE = 1,               //!< Initiator above its request rate
+    RNG_NACK_UTIL,                   //!< Responder above its utilization cap
+}uwb_rng_nack_reason_t;
+
+//! Refusal of a request, sent in place of the first response
+typedef union {
+    //! Structure of refusal frame
+    struct _rng_nack_frame_t{
+        struct _ieee_rng_request_frame_t;
+        uint16_t retry_after;            //!< Earliest time to retry, ms
+        uint8_t reason;                  //!< uwb_rng_nack_reason_t
+    }__attribute__((__packed__,aligned(1)));
+    uint8_t array[sizeof(struct _rng_nack_frame_t)]; //!< Array of size refusal frame
+} rng_nack_frame_t;
+
+#if MYNEWT_VAL(RNG_ADMIT)
+//! Request bucket of one initiator
+struct uwb_rng_admit_source{
+    uint16_t address;                //!< Initiator, 0 if unused
+    uint32_t tokens;                 //!< Requests available, 1/1000 request
+    uint32_t last;                   //!< Last refill, cputime ticks
+    uint32_t admitted;               //!< Requests admitted
+    uint32_t refused;                //!< Requests refused
+};
+
+//! Responder admission control
+struct uwb_rng_admit{
+    uint16_t rate;                   //!< Requests per second per initiator, 0 for no limit
+    uint16_t burst;                  //!< Requests an idle initiator may send back to back
+    uint8_t util;                    //!< Share of time the responder spends in exchanges, %, 0 for no cap
+    bool nack;                       //!< Answer refused requests with DWT_RNG_NACK
+    bool nack_pending;               //!< Refusal in the radio, the listen resumes once sent
+    uint32_t budget;                 //!< Responder time available, usec
+    uint32_t last;                   //!< Last budget refill, cputime ticks
+    struct uwb_rng_admit_source * charged; //!< Initiator of the request just admitted, NULL once it is handled
+    uint32_t charged_cost;           //!< Budget it took, usec
+    struct uwb_rng_admit_source sources[MYNEWT_VAL(RNG_ADMIT_SOURCES)]; //!< Initiators seen most recently
+};
+#endif
+
+#if MYNEWT_VAL(RNG_SESSIONS)
+//! Responder session states
+typedef enum _uwb_rng_session_state_t{
+    RNG_SESSION_FREE = 0,            //!< Unused
+    RNG_SESSION_RX,                  //!< Frame received, response not yet queued
+    RNG_SESSION_TX,                  //!< Response queued
+    RNG_SESSION_TXING,               //!< Response programmed in the radio
+    RNG_SESSION_WAIT,                //!< Waiting for the initiator's next frame
+}uwb_rng_session_state_t;
+
+//! Responder side context of one exchange, keyed by initiator address and sequence number
+struct uwb_rng_session{
+    uint16_t src_address;            //!< Initiator
+    uint8_t seq_num;                 //!< Sequence number of the request
+    uint8_t state;                   //!< uwb_rng_session_state_t
+    uint16_t code;                   //!< Request code
+    uint8_t step;                    //!< Current step, even steps are responses, odd steps the initiator's frames
+    uint8_t nsteps;                  //!< Steps of the exchange
+    uint16_t len;                    //!< Bytes of frame queued
+    uint64_t t0;                     //!< First response, dtu
+    uint64_t tx_time;                //!< Queued response, dtu
+    uint32_t holdoff;                //!< Time between steps, dtu
+    uint32_t guard;                  //!< Arrival uncertainty of the initiator's frames, dtu
+    uint32_t lead;                   //!< Time a response is programmed ahead of its timestamp, dtu
+    uint32_t duration[3];            //!< Airtime of each step, dtu
+    twr_frame_t frame;               //!< Last frame sent, restored to the ring with the next one received
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+    uint8_t sec[UWB_SEC_TRAILER_LEN]; //!< Security trailer of the queued frame
+    uint16_t sec_len;                //!< Its length, 0 for an unsecured frame
+#endif
+};
+#endif
+
+#if MYNEWT_VAL(RNG_QUALITY)
+#define RNG_QUALITY_NODIAG   (0x01)  //!< No receiver diagnostics, stdev from the exchange alone
+#define RNG_QUALITY_NLOS     (0x02)  //!< Line of sight likelihood below one half
+#define RNG_QUALITY_SKEW     (0x04)  //!< Turnaround and carrier clock offsets disagree
+
+//! Quality of a completed range
+struct uwb_rng_quality{
+    float stdev;                     //!< Estimated standard deviation of the range, m
+    float snr;                       //!< First path signal to noise ratio, dB, NAN without diagnostics
+    float los;                       //!< Line of sight likelihood, 0 to 1, NAN without diagnostics
+    float skew;                      //!< Turnaround minus carrier integrator clock offset, ppm, NAN if not double sided
+    float residual;                  //!< Single minus double sided range, m, NAN if not double sided
+    uint8_t retries;                 //!< Requests to the peer that failed before this range
+    uint8_t flags;                   //!< RNG_QUALITY_* flags
+};
+#endif
+
 struct rng_config_list {
     uint16_t rng_code;
     struct uwb_rng_config *config;
@@ -190,6 +308,22 @@ struct uwb_rng_instance{
     uint16_t idx_current;                   //!< Output index to circular buffer 
     uint16_t nframes;                       //!< Number of buffers defined to store the ranging data
     SLIST_HEAD(, rng_config_list) rng_configs;
+    uint16_t nack_address;                  //!< Responder of the last refusal received
+    uint32_t nack_until;                    //!< End of its retry-after, cputime ticks
+#if MYNEWT_VAL(RNG_ADMIT)
+    struct uwb_rng_admit admit;             //!< Responder admission control
+#endif
+#if MYNEWT_VAL(RNG_SESSIONS)
+    struct uwb_rng_session * session;       //!< Session of the frame being handled
+    struct uwb_rng_session * session_txing; //!< Session whose response is in the radio
+    struct uwb_rng_session sessions[MYNEWT_VAL(RNG_SESSIONS)]; //!< Responder sessions
+#endif
+#if MYNEWT_VAL(RNG_QUALITY)
+    uint16_t attempt_address;               //!< Destination of the last request
+    uint16_t attempts;                      //!< Requests to it since its last range
+    uint16_t quality_idx;                   //!< Ring index quality was captured for
+    struct uwb_rng_quality quality;         //!< Quality of the last range completed
+#endif
     twr_frame_t * frames[];                 //!< Pointer to twr buffers
 };
 
@@ -204,6 +338,8 @@ struct uwb_dev_status uwb_rng_request_delay_start(struct uwb_rng_instance * rng,
 struct uwb_rng_config * uwb_rng_get_config(struct uwb_rng_instance * rng, uwb_rng_modes_t code);
 void uwb_rng_set_frames(struct uwb_rng_instance * rng, twr_frame_t twr[], uint16_t nframes);
 float uwb_rng_twr_to_tof(struct uwb_rng_instance * rng, uint16_t idx);
+float uwb_rng_twr_to_tof_frames(struct uwb_dev * inst, twr_frame_t * first_frame, twr_frame_t * frame);
+float uwb_rng_twr_to_skew(struct uwb_rng_instance * rng, uint16_t idx, float skew_ci, float * tof_ss);
 float uwb_rng_tof_to_meters(float ToF);
 
 float uwb_rng_path_loss(float Pt, float G, float fc, float R);
@@ -212,6 +348,32 @@ uint32_t uwb_rng_twr_to_tof_sym(twr_frame_t twr[], uwb_rng_modes_t code);
 
 void uwb_rng_append_config(struct uwb_rng_instance * rng, struct rng_config_list *cfgs);
 void uwb_rng_remove_config(struct uwb_rng_instance * rng, uwb_rng_modes_t code);
+uint32_t uwb_rng_retry_after(struct uwb_rng_instance * rng, uint16_t dst_address);
+
+#if MYNEWT_VAL(RNG_ADMIT)
+void uwb_rng_admit_init(struct uwb_rng_instance * rng);
+void uwb_rng_admit_set(struct uwb_rng_instance * rng, uint16_t rate, uint16_t burst, uint8_t util);
+void uwb_rng_admit_reset(struct uwb_rng_instance * rng);
+bool uwb_rng_admit_rx(struct uwb_rng_instance * rng, uint32_t timestamp);
+void uwb_rng_admit_refund(struct uwb_rng_instance * rng);
+bool uwb_rng_admit_tx_complete(struct uwb_rng_instance * rng);
+int uwb_rng_admit_cli_register(void);
+#endif
+
+#if MYNEWT_VAL(RNG_QUALITY)
+void uwb_rng_quality_calc(struct uwb_dev * inst, struct uwb_dev_rxdiag * diag, struct uwb_rng_quality * quality);
+void uwb_rng_quality_capture(struct uwb_rng_instance * rng);
+void uwb_rng_get_quality(struct uwb_rng_instance * rng, uint16_t idx, struct uwb_rng_quality * quality);
+#endif
+
+#if MYNEWT_VAL(RNG_SESSIONS)
+struct uwb_dev_status uwb_rng_session_tx(struct uwb_rng_instance * rng, twr_frame_t * frame, uint16_t len, uint64_t tx_time);
+bool uwb_rng_session_active(struct uwb_rng_instance * rng);
+int uwb_rng_session_rx(struct uwb_rng_instance * rng);
+bool uwb_rng_session_tx_complete(struct uwb_rng_instance * rng);
+bool uwb_rng_session_run(struct uwb_rng_instance * rng);
+void uwb_rng_session_reset(struct uwb_rng_instance * rng);
+#endif
 
     
 #ifdef __cplusplus
@@ -0,0 +1,359 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file rng_admit.c
+ * @brief Admission control of requests on the responder side
+ *
+ * @details Every request addressed to a listening responder first takes a
+ * token from the bucket of its initiator, refilled at the configured rate up
+ * to the burst, and then the time the exchange keeps the responder busy from
+ * a global budget, refilled at the utilization cap. A request failing either
+ * is dropped before the twr services see it and, if enabled, answered with a
+ * DWT_RNG_NACK in the slot of the first response, carrying the time after
+ * which the same request would be admitted. A request admitted here but
+ * dropped by the responder sessions, busy or full, is refunded. Integer
+ * arithmetic and a scan of RNG_ADMIT_SOURCES entries only, it runs in
+ * rx_complete_cb.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <os/os.h>
+#include <stats/stats.h>
+
+#include <uwb/uwb.h>
+#include <uwb/uwb_mac.h>
+#include <uwb_rng/uwb_rng.h>
+
+#if MYNEWT_VAL(RNG_ADMIT)
+
+#if MYNEWT_VAL(RNG_STATS)
+#define RNG_STATS_INC(__X) STATS_INC(rng->stat, __X)
+#else
+#define RNG_STATS_INC(__X) {}
+#endif
+
+#define BUDGET_MAX(__a) ((uint32_t)MYNEWT_VAL(RNG_ADMIT_WINDOW) * 10 * (__a)->util)
+
+/**
+ * @fn uwb_rng_admit_init(struct uwb_rng_instance * rng)
+ * @brief Set the admission control to the syscfg defaults, all initiators
+ * start with a full bucket.
+ *
+ * @param rng   Pointer to struct uwb_rng_instance.
+ *
+ * @return void
+ */
+void
+uwb_rng_admit_init(struct uwb_rng_instance * rng)
+{
+    uwb_rng_admit_set(rng, MYNEWT_VAL(RNG_ADMIT_RATE), MYNEWT_VAL(RNG_ADMIT_BURST), MYNEWT_VAL(RNG_ADMIT_UTIL));
+    rng->admit.nack = MYNEWT_VAL(RNG_ADMIT_NACK);
+}
+
+/**
+ * @fn uwb_rng_admit_set(struct uwb_rng_instance * rng, uint16_t rate, uint16_t burst, uint8_t util)
+ * @brief Change the limits, the tracked initiators are forgotten.
+ *
+ * @param rng   Pointer to struct uwb_rng_instance.
+ * @param rate  Requests per second per initiator, 0 for no limit.
+ * @param burst Requests an idle initiator may send back to back, at least 1.
+ * @param util  Share of time spent in exchanges, %, 0 for no cap.
+ *
+ * @return void
+ */
+void
+uwb_rng_admit_set(struct uwb_rng_instance * rng, uint16_t rate, uint16_t burst, uint8_t util)
+{
+    struct uwb_rng_admit * a = &rng->admit;
+
+    a->rate = rate;
+    a->burst = (burst) ? burst : 1;
+    a->util = (util < 100) ? util : 0;
+    uwb_rng_admit_reset(rng);
+}
+
+/**
+ * @fn uwb_rng_admit_reset(struct uwb_rng_instance * rng)
+ * @brief Forget the tracked initiators and refill the budget.
+ *
+ * @param rng   Pointer to struct uwb_rng_instance.
+ *
+ * @return void
+ */
+void
+uwb_rng_admit_reset(struct uwb_rng_instance * rng)
+{
+    struct uwb_rng_admit * a = &rng->admit;
+
+    memset(a->sources, 0, sizeof(a->sources));
+    a->charged = NULL;
+    a->budget = BUDGET_MAX(a);
+    a->last = os_cputime_get32();
+}
+
+/* Bucket of an initiator refilled up to now, replacing the least recently seen one if it is not tracked */
+static struct uwb_rng_admit_source *
+admit_source(struct uwb_rng_instance * rng, uint16_t address, uint32_t now)
+{
+    struct uwb_rng_admit * a = &rng->admit;
+    uint32_t full = (uint32_t)a->burst * 1000;
+    struct uwb_rng_admit_source * src = NULL, * victim = &a->sources[0];
+
+    for (uint16_t i = 0; i < MYNEWT_VAL(RNG_ADMIT_SOURCES); i++) {
+        struct uwb_rng_admit_source * s = &a->sources[i];
+        if (s->address == address) {
+            src = s;
+            break;
+        }
+        if (s->address == 0) {
+            if (victim->address)
+                victim = s;
+        } else if (victim->address && now - s->last > now - victim->last) {
+            victim = s;
+        }
+    }
+    if (src == NULL) {
+        if (victim->address)
+            RNG_STATS_INC(admit_evict);
+        memset(victim, 0, sizeof(*victim));
+        victim->address = address;
+        victim->tokens = full;
+        victim->last = now;
+        return victim;
+    }
+
+    if (a->rate) {
+        uint32_t usecs = os_cputime_ticks_to_usecs(now - src->last);
+        // Time to fill an empty bucket bounds the product
+        if (usecs > full / a->rate * 1000)
+            src->tokens = full;
+        else
+            src->tokens += usecs * a->rate / 1000;
+        if (src->tokens > full)
+            src->tokens = full;
+    }
+    src->last = now;
+    return src;
+}
+
+/* Time the responder spends in an exchange, from the request to the initiator's last frame */
+static uint32_t
+admit_cost(struct uwb_rng_instance * rng, uint16_t code)
+{
+    struct uwb_rng_config * config = uwb_rng_get_config(rng, code);
+    uint32_t steps;
+
+    switch(code){
+        case DWT_SS_TWR_EXT: steps = 1; break;
+        case DWT_SS_TWR: steps = 2; break;
+        default: steps = 3; break;
+    }
+    return steps * config->tx_holdoff_delay + uwb_phy_frame_duration(rng->dev_inst, sizeof(twr_frame_final_t));
+}
+
+/* Answer in the slot of the first response, where the initiator listens */
+static bool
+admit_nack(struct uwb_rng_instance * rng, ieee_rng_request_frame_t * req, uint8_t reason, uint32_t retry_usecs)
+{
+    struct uwb_dev * inst = rng->dev_inst;
+    struct uwb_rng_config * config = uwb_rng_get_config(rng, req->code);
+    uint32_t retry_ms = (retry_usecs + 999) / 1000;
+    rng_nack_frame_t nack;
+
+    nack.fctrl = FCNTL_IEEE_RANGE_16;
+    nack.seq_num = req->seq_num;
+    nack.PANID = req->PANID;
+    nack.dst_address = req->src_address;
+    nack.src_address = inst->my_short_address;
+    nack.code = DWT_RNG_NACK;
+    nack.retry_after = (retry_ms < UINT16_MAX) ? retry_ms : UINT16_MAX;
+    nack.reason = reason;
+
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+    uwb_sec_write_tx(inst, nack.array, sizeof(rng_nack_frame_t));
+#else
+    uwb_write_tx(inst, nack.array, 0, sizeof(rng_nack_frame_t));
+    uwb_write_tx_fctrl(inst, sizeof(rng_nack_frame_t), 0);
+#endif
+    uwb_set_wait4resp(inst, false);
+    uwb_set_delay_start(inst, inst->rxtimestamp + ((uint64_t)config->tx_holdoff_delay << 16));
+    if (uwb_start_tx(inst).start_tx_error) {
+        RNG_STATS_INC(tx_error);
+        return false;
+    }
+    RNG_STATS_INC(tx_nack);
+    rng->admit.nack_pending = true;
+    return true;
+}
+
+/* The refused frame turned the receiver off, resume the listen */
+static void
+admit_resume(struct uwb_rng_instance * rng)
+{
+#if MYNEWT_VAL(RNG_SESSIONS)
+    if (uwb_rng_session_run(rng))
+        return;
+#endif
+    if (uwb_start_rx(rng->dev_inst).start_rx_error) {
+        dpl_error_t err = dpl_sem_release(&rng->sem);
+        assert(err == DPL_OK);
+        RNG_STATS_INC(rx_error);
+    }
+}
+
+/**
+ * @fn uwb_rng_admit_rx(struct uwb_rng_instance * rng, uint32_t timestamp)
+ * @brief Receive hook of the rng interface, decides on a request before the
+ * twr services see it.
+ *
+ * @param rng       Pointer to struct uwb_rng_instance.
+ * @param timestamp Reception time, cputime ticks.
+ *
+ * @return true if the request was refused and consumed
+ */
+bool
+uwb_rng_admit_rx(struct uwb_rng_instance * rng, uint32_t timestamp)
+{
+    struct uwb_dev * inst = rng->dev_inst;
+    struct uwb_rng_admit * a = &rng->admit;
+    ieee_rng_request_frame_t * req = (ieee_rng_request_frame_t *) inst->rxbuf;
+    struct uwb_rng_admit_source * src;
+    uint32_t now = timestamp, cost = 0, retry = 0;
+    uint8_t reason = 0;
+    bool busy = false;
+
+    a->charged = NULL;
+    if (inst->frame_len != sizeof(ieee_rng_request_frame_t))
+        return false;
+    switch(req->code){
+        case DWT_SS_TWR:
+        case DWT_SS_TWR_EXT:
+        case DWT_DS_TWR:
+        case DWT_DS_TWR_EXT:
+            break;
+        default:
+            return false;
+    }
+    if (inst->config.framefilter_enabled == false && req->dst_address != inst->my_short_address)
+        return false;
+#if MYNEWT_VAL(RNG_SESSIONS)
+    busy = uwb_rng_session_active(rng);
+#endif
+    if (!busy && dpl_sem_get_count(&rng->sem) == 1)
+        return false;       // Not listening, unsolicited
+
+    src = admit_source(rng, req->src_address, now);
+    if (a->rate && src->tokens < 1000) {
+        reason = RNG_NACK_RATE;
+        retry = (1000 - src->tokens) * 1000 / a->rate;
+    }
+
+    if (a->util) {
+        uint32_t usecs = os_cputime_ticks_to_usecs(now - a->last);
+        a->last = now;
+        if (usecs > BUDGET_MAX(a) / a->util * 100)
+            a->budget = BUDGET_MAX(a);
+        else
+            a->budget += usecs * a->util / 100;
+        if (a->budget > BUDGET_MAX(a))
+            a->budget = BUDGET_MAX(a);
+        cost = admit_cost(rng, req->code);
+        if (reason == 0 && a->budget < cost) {
+            reason = RNG_NACK_UTIL;
+            retry = (cost - a->budget) * 100 / a->util;
+        }
+    }
+
+    if (reason == 0) {
+        if (a->rate)
+            src->tokens -= 1000;
+        if (a->util)
+            a->budget -= cost;
+        src->admitted++;
+        a->charged = src;
+        a->charged_cost = cost;
+        return false;
+    }
+
+    src->refused++;
+    if (reason == RNG_NACK_RATE)
+        RNG_STATS_INC(admit_rate);
+    else
+        RNG_STATS_INC(admit_util);
+    // Open sessions own the radio, a refusal would take the slot of their responses
+    if (busy || !a->nack || !admit_nack(rng, req, reason, retry))
+        admit_resume(rng);
+    return true;
+}
+
+/**
+ * @fn uwb_rng_admit_refund(struct uwb_rng_instance * rng)
+ * @brief Give back the token and budget of the request just admitted, when
+ * it was dropped without an exchange.
+ *
+ * @param rng   Pointer to struct uwb_rng_instance.
+ *
+ * @return void
+ */
+void
+uwb_rng_admit_refund(struct uwb_rng_instance * rng)
+{
+    struct uwb_rng_admit * a = &rng->admit;
+    struct uwb_rng_admit_source * src = a->charged;
+
+    if (src == NULL)
+        return;
+    a->charged = NULL;
+    if (a->rate) {
+        src->tokens += 1000;
+        if (src->tokens > (uint32_t)a->burst * 1000)
+            src->tokens = (uint32_t)a->burst * 1000;
+    }
+    if (a->util) {
+        a->budget += a->charged_cost;
+        if (a->budget > BUDGET_MAX(a))
+            a->budget = BUDGET_MAX(a);
+    }
+    src->admitted--;
+}
+
+/**
+ * @fn uwb_rng_admit_tx_complete(struct uwb_rng_instance * rng)
+ * @brief Transmit hook of the rng interface, resumes the listen once a
+ * refusal is sent.
+ *
+ * @param rng   Pointer to struct uwb_rng_instance.
+ *
+ * @return true if the frame was a refusal
+ */
+bool
+uwb_rng_admit_tx_complete(struct uwb_rng_instance * rng)
+{
+    if (!rng->admit.nack_pending)
+        return false;
+    rng->admit.nack_pending = false;
+    if (dpl_sem_get_count(&rng->sem) == 0)
+        admit_resume(rng);
+    return true;
+}
+
+#endif
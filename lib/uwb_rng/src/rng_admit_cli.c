@@ -0,0 +1,132 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <os/os.h>
+#include <syscfg/syscfg.h>
+
+#if MYNEWT_VAL(RNG_ADMIT) && MYNEWT_VAL(RNG_ADMIT_CLI)
+
+#include <string.h>
+#include <stdlib.h>
+
+#include <shell/shell.h>
+#include <console/console.h>
+
+#include <uwb/uwb.h>
+#include <uwb_rng/uwb_rng.h>
+
+static int rng_admit_cli_cmd(int argc, char **argv);
+
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+const struct shell_param cmd_admit_param[] = {
+    {"list", "[<inst>] limits and admitted/refused requests per initiator"},
+    {"set", "<rate> <burst> <util> [<inst>] requests/s per initiator, burst, responder utilization %"},
+    {"nack", "<0|1> [<inst>] answer refused requests with a retry-after"},
+    {"reset", "[<inst>] forget the initiators"},
+    {NULL,NULL},
+};
+
+const struct shell_cmd_help cmd_admit_help = {
+	"admit", "<cmd>", cmd_admit_param
+};
+#endif
+
+static struct shell_cmd shell_admit_cmd = {
+    .sc_cmd = "admit",
+    .sc_cmd_func = rng_admit_cli_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+    .help = &cmd_admit_help
+#endif
+};
+
+static struct uwb_rng_instance *
+rng_admit_cli_instance(int argc, char **argv, int arg)
+{
+    struct uwb_dev * udev = uwb_dev_idx_lookup((argc > arg) ? strtol(argv[arg], NULL, 0) : 0);
+
+    if (udev == NULL) {
+        return NULL;
+    }
+    return (struct uwb_rng_instance *)uwb_mac_find_cb_inst_ptr(udev, UWBEXT_RNG);
+}
+
+static void
+rng_admit_cli_list(struct uwb_rng_instance * rng)
+{
+    struct uwb_rng_admit * a = &rng->admit;
+
+    console_printf("{\"rate\": %u, \"burst\": %u, \"util\": %u, \"nack\": %u, \"budget_us\": %lu}\n",
+                   a->rate, a->burst, a->util, a->nack, (unsigned long)a->budget);
+    console_printf("#addr, tokens, admitted, refused\n");
+    for (int i = 0; i < MYNEWT_VAL(RNG_ADMIT_SOURCES); i++) {
+        struct uwb_rng_admit_source * s = &a->sources[i];
+        if (s->address == 0) {
+            continue;
+        }
+        console_printf("%4x, %lu.%03lu, %lu, %lu\n", s->address,
+                       (unsigned long)(s->tokens / 1000), (unsigned long)(s->tokens % 1000),
+                       (unsigned long)s->admitted, (unsigned long)s->refused);
+    }
+}
+
+static int
+rng_admit_cli_cmd(int argc, char **argv)
+{
+    struct uwb_rng_instance * rng;
+
+    if (argc < 2) {
+        return 0;
+    }
+
+    if (!strcmp(argv[1], "list")) {
+        if ((rng = rng_admit_cli_instance(argc, argv, 2)) == NULL) {
+            goto no_instance;
+        }
+        rng_admit_cli_list(rng);
+    } else if (!strcmp(argv[1], "set") && argc > 4) {
+        if ((rng = rng_admit_cli_instance(argc, argv, 5)) == NULL) {
+            goto no_instance;
+        }
+        uwb_rng_admit_set(rng, strtol(argv[2], NULL, 0), strtol(argv[3], NULL, 0), strtol(argv[4], NULL, 0));
+    } else if (!strcmp(argv[1], "nack") && argc > 2) {
+        if ((rng = rng_admit_cli_instance(argc, argv, 3)) == NULL) {
+            goto no_instance;
+        }
+        rng->admit.nack = (strtol(argv[2], NULL, 0) != 0);
+    } else if (!strcmp(argv[1], "reset")) {
+        if ((rng = rng_admit_cli_instance(argc, argv, 2)) == NULL) {
+            goto no_instance;
+        }
+        uwb_rng_admit_reset(rng);
+    } else {
+        console_printf("Unknown cmd\n");
+    }
+    return 0;
+
+no_instance:
+    console_printf("No rng instance\n");
+    return 0;
+}
+
+int
+uwb_rng_admit_cli_register(void)
+{
+    return shell_cmd_register(&shell_admit_cmd);
+}
+#endif /* MYNEWT_VAL(RNG_ADMIT) && MYNEWT_VAL(RNG_ADMIT_CLI) */
@@ -22,8 +22,9 @@
 #include <assert.h>
 #include <string.h>
 #include <stdio.h>
+#include <stddef.h>
 #include <math.h>
-#include <json/json.h>
+#include <json_stream/json_stream.h>
 #include <uwb_rng/uwb_rng.h>
 #include <uwb_rng/rng_encode.h>
 
@@ -35,37 +36,82 @@
 
 #define JSON_BUF_SIZE (1024)
 static char _buf[JSON_BUF_SIZE];
-static uint16_t idx=0;
+static struct json_stream _js;
 
-static void
-json_fflush(){
-    _buf[idx] = '\0';
-    printf("%s\n", _buf);
-    idx=0;
+static int
+json_fflush(void * arg, const char * data, uint16_t len){
+    return fwrite(data, 1, len, stdout);
 }
 
-static void
-_json_fflush(){
-    _buf[idx] = '\0';
-    printf("%s", _buf);
-    idx=0;
+static struct json_stream *
+json_stream(void){
+    if (_js.buf == NULL)
+        json_stream_init(&_js, _buf, sizeof(_buf), json_fflush, NULL);
+    return &_js;
 }
 
-static int
-json_write(void *buf, char* data, int len) {
-
-    if (idx + len > JSON_BUF_SIZE)
-        _json_fflush();
-
-    for (uint16_t i=0; i< len; i++)
-        _buf[i+idx] = data[i];
-    idx+=len;
+//! Fields of a range record, laid out for the templates below
+struct rng_record {
+    uint64_t utime;
+    uint16_t dst_address;
+    uint16_t src_address;
+    float range;
+    float raz[3];
+    float rssi;
+    float los;
+};
+
+static const struct json_tpl utime_tpl[] = {
+    JSON_TPL_LIT("{\"utime\": "),
+    JSON_TPL_FIELD(JSON_TPL_OP_U64, struct rng_record, utime),
+    JSON_TPL_END()
+};
+
+static const struct json_tpl twr_tpl[] = {
+    JSON_TPL_LIT("\"twr\": {\"rng\": "),
+    JSON_TPL_FIELD(JSON_TPL_OP_FLOAT, struct rng_record, range),
+    JSON_TPL_LIT(",\"uid\": "),
+    JSON_TPL_FIELD(JSON_TPL_OP_HEX16, struct rng_record, dst_address),
+    JSON_TPL_LIT("},\"uid\": "),
+    JSON_TPL_FIELD(JSON_TPL_OP_HEX16, struct rng_record, src_address),
+    JSON_TPL_END()
+};
+
+static const struct json_tpl raz_tpl[] = {
+    JSON_TPL_LIT("\"twr\": {\"raz\": ["),
+    JSON_TPL_FIELD(JSON_TPL_OP_FLOAT_NULL, struct rng_record, raz[0]),
+    JSON_TPL_LIT(","),
+    JSON_TPL_FIELD(JSON_TPL_OP_FLOAT_NULL, struct rng_record, raz[1]),
+    JSON_TPL_LIT(","),
+    JSON_TPL_FIELD(JSON_TPL_OP_FLOAT_NULL, struct rng_record, raz[2]),
+    JSON_TPL_LIT("],\"uid\": "),
+    JSON_TPL_FIELD(JSON_TPL_OP_HEX16, struct rng_record, dst_address),
+    JSON_TPL_LIT("},\"uid\": "),
+    JSON_TPL_FIELD(JSON_TPL_OP_HEX16, struct rng_record, src_address),
+    JSON_TPL_END()
+};
+
+static const struct json_tpl diag_tpl[] = {
+    JSON_TPL_LIT("\"diag\": {\"rssi\": "),
+    JSON_TPL_FIELD(JSON_TPL_OP_FLOAT, struct rng_record, rssi),
+    JSON_TPL_LIT(",\"los\": "),
+    JSON_TPL_FIELD(JSON_TPL_OP_FLOAT, struct rng_record, los),
+    JSON_TPL_LIT("}"),
+    JSON_TPL_END()
+};
 
-    return len;
+static void
+frame_record(struct rng_record * rec, twr_frame_t * frame)
+{
+    rec->dst_address = frame->dst_address;
+    rec->src_address = frame->src_address;
+    rec->range = frame->spherical.range;
+    for (uint16_t i=0; i < 3; i++)
+        rec->raz[i] = frame->spherical.array[i];
 }
 
 /*!
- * @fn rng_encodestruct os_event * ev)
+ * @fn rng_encode(struct uwb_rng_instance * rng)
  *
  * @brief JSON encoding of range
  * {"utime": 208317053, "twr": {"rng": "0.703","uid": "1234"},"uid": "55a6", "diag": {"rssi": "-79.675","los": "1.000"}}
@@ -77,57 +123,63 @@ json_write(void *buf, char* data, int len) {
 void
 rng_encode(struct uwb_rng_instance * rng) {
 
-    struct json_encoder encoder;
-    struct json_value value;
-    int rc;
+    struct json_stream * js = json_stream();
+    struct rng_record rec;
 
-    memset(&encoder, 0, sizeof(encoder));
-    encoder.je_write = json_write;
-    encoder.je_arg= NULL;
-    
     twr_frame_t * frame = rng->frames[rng->idx_current];
-    
+
     float time_of_flight = uwb_rng_twr_to_tof(rng, rng->idx_current);
     frame->spherical.range = uwb_rng_tof_to_meters(time_of_flight);
 
-    rc = json_encode_object_start(&encoder);
 #if MYNEWT_VAL(UWB_WCS_ENABLED)
-    JSON_VALUE_UINT(&value, uwb_wcs_read_systime_master64(rng->dev_inst));   
+    rec.utime = uwb_wcs_read_systime_master64(rng->dev_inst);
 #else
-    JSON_VALUE_UINT(&value, os_cputime_ticks_to_usecs(os_cputime_get32()));
+    rec.utime = os_cputime_ticks_to_usecs(os_cputime_get32());
 #endif
-    rc |= json_encode_object_entry(&encoder, "utime", &value);
-    _json_fflush();
+    frame_record(&rec, frame);
+
+    json_stream_record_start(js);
+    json_stream_template(js, utime_tpl, &rec);
     switch(frame->code){
         case DWT_SS_TWR_FINAL:
         case DWT_DS_TWR_FINAL:
-         printf(", ");
-        _twr_encode(frame);
-        break;
+            json_stream_write(js, ", ", 2);
+            json_stream_template(js, twr_tpl, &rec);
+            break;
         case DWT_SS_TWR_EXT_FINAL:
         case DWT_DS_TWR_EXT_FINAL:
-         printf(", ");
-        _raz_encode(frame);
-        break;
-        default: printf(",error: \"Unknown Frame Code\"");
+            json_stream_write(js, ", ", 2);
+            json_stream_template(js, raz_tpl, &rec);
+            break;
+        default:
+            json_stream_write(js, ",error: \"Unknown Frame Code\"", sizeof(",error: \"Unknown Frame Code\"") - 1);
     }
 #if MYNEWT_VAL(RNG_VERBOSE) > 1
     if(rng->dev_inst->config.rxdiag_enable){
-        printf(", ");
-        _diag_encode(rng->dev_inst);
+        rec.rssi = uwb_get_rssi(rng->dev_inst);
+        rec.los = uwb_estimate_los(rng->dev_inst, rec.rssi, uwb_get_fppl(rng->dev_inst));
+        json_stream_write(js, ", ", 2);
+        json_stream_template(js, diag_tpl, &rec);
     }
 #endif
+    json_stream_putc(js, '}');
+    json_stream_record_end(js);
+}
+
+static void
+twr_fragment(struct json_stream * js, twr_frame_t * frame) {
+    struct rng_record rec;
 
-    rc |= json_encode_object_finish(&encoder);
-    assert(rc == 0);
-    json_fflush();
+    frame_record(&rec, frame);
+    json_stream_template(js, twr_tpl, &rec);
 }
 
 /*!
- * @fn twr_encode(twr_frame_t * frame) {
+ * @fn _twr_encode(twr_frame_t * frame)
  *
- * @brief JSON encoding twr_frames support the folowing json objects: 
+ * @brief JSON encoding twr_frames support the folowing json objects:
  * {"twr": {"rng": "1.100","uid": "1234"},"uid": "4321"}
+ * Written to the console straight away, without braces or newline.
  * input parameters
  * @param frame twr_frame_t *
  * output parameters
@@ -136,62 +188,37 @@ rng_encode(struct uwb_rng_instance * rng) {
 
 void
 _twr_encode(twr_frame_t * frame) {
-    struct json_encoder encoder;
-    struct json_value value;
-    int rc;
-
-    memset(&encoder, 0, sizeof(encoder));
-    encoder.je_write = json_write;
-    encoder.je_arg= NULL;
-
-    rc = json_encode_object_key(&encoder, "twr");  
-    rc |= json_encode_object_start(&encoder);  
+    struct json_stream * js = json_stream();
 
-#if MYNEWT_VAL(FLOAT_USER)
-    char float_string[32];
-    sprintf(float_string,"%f",frame->spherical.range);
-    JSON_VALUE_STRING(&value, float_string);
-#else
-    JSON_VALUE_UINT(&value, *(uint32_t *)&frame->spherical.range);
-#endif
-    rc |= json_encode_object_entry(&encoder, "rng", &value);
-   
-    char uuid[16];
-    sprintf(uuid,"%04x",frame->dst_address);
-    JSON_VALUE_STRINGN(&value, uuid,4);
-    rc |= json_encode_object_entry(&encoder, "uid", &value);
-    rc |= json_encode_object_finish(&encoder);
-
-    sprintf(uuid,"%04x",frame->src_address);
-    JSON_VALUE_STRINGN(&value, uuid,4);
-    rc |= json_encode_object_entry(&encoder, "uid", &value);
-
-    assert(rc == 0);
-    _json_fflush();
-   
+    twr_fragment(js, frame);
+    json_stream_flush(js);
 }
 
 void
 twr_encode(twr_frame_t * frame){
+    struct json_stream * js = json_stream();
+
+    json_stream_record_start(js);
+    json_stream_putc(js, '{');
+    twr_fragment(js, frame);
+    json_stream_putc(js, '}');
+    json_stream_record_end(js);
+}
+
+static void
+raz_fragment(struct json_stream * js, twr_frame_t * frame) {
+    struct rng_record rec;
 
-    struct json_encoder encoder;
-    int rc;
-
-    memset(&encoder, 0, sizeof(encoder));
-    encoder.je_write = json_write;
-    encoder.je_arg= NULL;
-        
-    rc = json_encode_object_start(&encoder); 
-    _twr_encode(frame);
-    rc |= json_encode_object_finish(&encoder);
-    json_fflush();
+    frame_record(&rec, frame);
+    json_stream_template(js, raz_tpl, &rec);
 }
 
 /*!
- * @fn raz_encode(twr_frame_t * frame) {
+ * @fn _raz_encode(twr_frame_t * frame)
  *
- * @brief JSON encoding twr_frames support the folowing json objects: 
+ * @brief JSON encoding twr_frames support the folowing json objects:
  * {"twr": {"raz": ["1.100","0.000","0.000"],"uid": "1234"},"uid": "4321"}
+ * Written to the console straight away, without braces or newline.
  * input parameters
  * @param frame twr_frame_t *
  * output parameters
@@ -200,82 +227,41 @@ twr_encode(twr_frame_t * frame){
 
 void
 _raz_encode(twr_frame_t * frame) {
-    struct json_encoder encoder;
-    struct json_value value;
-    int rc;
-
-    memset(&encoder, 0, sizeof(encoder));
-    encoder.je_write = json_write;
-    encoder.je_arg= NULL;
-
-    rc = json_encode_object_key(&encoder, "twr");  
-    rc |= json_encode_object_start(&encoder);  
-
-#if MYNEWT_VAL(FLOAT_USER)
-    char float_string[32];
-    sprintf(float_string,"%f",frame->spherical.range);
-    JSON_VALUE_STRING(&value, float_string);
-#else
-    JSON_VALUE_UINT(&value, *(uint32_t *)&frame->spherical.range);
-#endif
-
-    rc |= json_encode_array_name(&encoder, "raz");
-    rc |= json_encode_array_start(&encoder);
-
-    for (uint16_t i=0; i < 3; i++){
-#if MYNEWT_VAL(FLOAT_USER)
-        if (isnan(frame->spherical.array[i])){
-            JSON_VALUE_STRING(&value, "null");
-        }else{
-            char float_string[32];
-            sprintf(float_string,"%f",frame->spherical.array[i]);
-            JSON_VALUE_STRING(&value, float_string);
-        }        
-#else
-        JSON_VALUE_UINT(&value, *(uint32_t *)&frame->spherical.array[i]);
-#endif
-        rc |= json_encode_array_value(&encoder, &value);
-        if (i%64==0) _json_fflush();
-    }
-    rc |= json_encode_array_finish(&encoder);
+    struct json_stream * js = json_stream();
 
-    char uuid[16];
-    sprintf(uuid,"%04x",frame->dst_address);
-    JSON_VALUE_STRINGN(&value, uuid,4);
-    rc |= json_encode_object_entry(&encoder, "uid", &value);
-    rc |= json_encode_object_finish(&encoder);
-
-    sprintf(uuid,"%04x",frame->src_address);
-    JSON_VALUE_STRINGN(&value, uuid,4);
-    rc |= json_encode_object_entry(&encoder, "uid", &value);
-
-    assert(rc == 0);
-    _json_fflush();
-   
+    raz_fragment(js, frame);
+    json_stream_flush(js);
 }
 
 void
 raz_encode(twr_frame_t * frame){
-    struct json_encoder encoder;
-    int rc;
-
-    memset(&encoder, 0, sizeof(encoder));
-    encoder.je_write = json_write;
-    encoder.je_arg= NULL;
-        
-    rc = json_encode_object_start(&encoder); 
-    _raz_encode(frame);
-    rc |= json_encode_object_finish(&encoder);
-    json_fflush();
+    struct json_stream * js = json_stream();
+
+    json_stream_record_start(js);
+    json_stream_putc(js, '{');
+    raz_fragment(js, frame);
+    json_stream_putc(js, '}');
+    json_stream_record_end(js);
 }
 
 
+static void
+diag_fragment(struct json_stream * js, struct uwb_dev * inst)
+{
+    struct rng_record rec;
+
+    rec.rssi = uwb_get_rssi(inst);
+    rec.los = uwb_estimate_los(inst, rec.rssi, uwb_get_fppl(inst));
+    json_stream_template(js, diag_tpl, &rec);
+}
+
 /*!
- * @fn diag_encode(struct uwb_dev * inst) {
+ * @fn _diag_encode(struct uwb_dev * inst)
  *
- * @brief JSON encoding twr_frames support the folowing json objects: 
+ * @brief JSON encoding twr_frames support the folowing json objects:
  * {"diag": {"rssi": "-79.906","nlos": "0.836"}}
- * input parameters 
+ * Written to the console straight away, without braces or newline.
+ * input parameters
  * @param inst struct _dw1000_dev_instance_t *
  * output parameters
  * returns void
@@ -284,58 +270,21 @@ raz_encode(twr_frame_t * frame){
 void
 _diag_encode(struct uwb_dev * inst)
 {
-    struct json_encoder encoder;
-    struct json_value value;
-    int rc;
-
-    memset(&encoder, 0, sizeof(encoder));
-    encoder.je_write = json_write;
-    encoder.je_arg= NULL;
-
-    rc = json_encode_object_key(&encoder, "diag");  
-    rc |= json_encode_object_start(&encoder);  
-
-    float rssi = uwb_get_rssi(inst);
-    float fppl = uwb_get_fppl(inst);
-    float nlos = uwb_estimate_los(inst, rssi, fppl);
-
-#if MYNEWT_VAL(FLOAT_USER)
-    char float_string[32]={0};
-    sprintf(float_string,"%f",rssi);
-    JSON_VALUE_STRING(&value, float_string);
-#else
-    JSON_VALUE_UINT(&value, *(uint32_t *)&rssi);
-#endif
-    rc |= json_encode_object_entry(&encoder, "rssi", &value);
-
-#if MYNEWT_VAL(FLOAT_USER)
-sprintf(float_string,"%f",nlos);
-    JSON_VALUE_STRING(&value, float_string);
-#else
-    JSON_VALUE_UINT(&value, *(uint32_t *)&nlos);
-#endif
-    rc |= json_encode_object_entry(&encoder, "los", &value);
-    rc |= json_encode_object_finish(&encoder);
+    struct json_stream * js = json_stream();
 
-    assert(rc == 0);
-    _json_fflush();
-   
+    diag_fragment(js, inst);
+    json_stream_flush(js);
 }
 
 void
 diag_encode(struct uwb_dev * inst){
+    struct json_stream * js = json_stream();
 
-    struct json_encoder encoder;
-    int rc;
-
-    memset(&encoder, 0, sizeof(encoder));
-    encoder.je_write = json_write;
-    encoder.je_arg= NULL;
-        
-    rc = json_encode_object_start(&encoder); 
-    _diag_encode(inst);
-    rc |= json_encode_object_finish(&encoder);
-    json_fflush();
+    json_stream_record_start(js);
+    json_stream_putc(js, '{');
+    diag_fragment(js, inst);
+    json_stream_putc(js, '}');
+    json_stream_record_end(js);
 }
 
 #endif
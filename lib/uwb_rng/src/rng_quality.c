@@ -0,0 +1,183 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file rng_quality.c
+ * @brief Quality record of completed ranges
+ *
+ * @details The standard deviation of a range is modelled as independent
+ * terms added in quadrature: a floor reached in line of sight at high snr,
+ * a timing jitter inversely proportional to the first path amplitude over
+ * the noise, a non line of sight term weighted by one minus the line of
+ * sight likelihood of the driver, and for double sided exchanges the
+ * disagreement of the single and double sided estimates, which a clock
+ * offset inconsistent between the turnaround intervals and the carrier
+ * integrator shows up as. The record is captured in complete_cb of uwb_rng,
+ * ahead of the services and applications, while the diagnostics of the last
+ * frame received are current. Positioning engines weight ranges by
+ * 1 / stdev^2.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <os/os.h>
+
+#include <uwb/uwb.h>
+#include <uwb/uwb_mac.h>
+#include <uwb_rng/uwb_rng.h>
+
+#if MYNEWT_VAL(RNG_QUALITY)
+
+/**
+ * @fn uwb_rng_quality_calc(struct uwb_dev * inst, struct uwb_dev_rxdiag * diag, struct uwb_rng_quality * quality)
+ * @brief Standard deviation, snr, line of sight likelihood and flags of a range from the
+ * diagnostics of its last frame, skew, residual and retries are those set by the caller.
+ *
+ * @param inst      Pointer to struct uwb_dev.
+ * @param diag      Pointer to struct uwb_dev_rxdiag, NULL without diagnostics.
+ * @param quality   Pointer to struct uwb_rng_quality.
+ *
+ * @return void
+ */
+void
+uwb_rng_quality_calc(struct uwb_dev * inst, struct uwb_dev_rxdiag * diag, struct uwb_rng_quality * quality)
+{
+    const float floor = MYNEWT_VAL(RNG_QUALITY_FLOOR);
+    float var;
+
+    quality->snr = NAN;
+    quality->los = NAN;
+    quality->flags = 0;
+    if (diag) {
+        quality->snr = uwb_calc_fp_snr(inst, diag);
+        quality->los = uwb_estimate_los(inst, uwb_calc_rssi(inst, diag), uwb_calc_fppl(inst, diag));
+    }
+
+    if (isfinite(quality->snr) && isfinite(quality->los)) {
+        float jitter = floor * powf(10.0f, (MYNEWT_VAL(RNG_QUALITY_SNR_REF) - quality->snr) / 20.0f);
+        var = floor * floor + jitter * jitter
+            + (1.0f - quality->los) * MYNEWT_VAL(RNG_QUALITY_NLOS) * MYNEWT_VAL(RNG_QUALITY_NLOS);
+        if (quality->los < 0.5f)
+            quality->flags |= RNG_QUALITY_NLOS;
+    } else {
+        var = MYNEWT_VAL(RNG_QUALITY_NODIAG) * MYNEWT_VAL(RNG_QUALITY_NODIAG);
+        quality->flags |= RNG_QUALITY_NODIAG;
+    }
+    if (isfinite(quality->residual))
+        var += quality->residual * quality->residual;
+    if (fabsf(quality->skew) > MYNEWT_VAL(RNG_QUALITY_SKEW))
+        quality->flags |= RNG_QUALITY_SKEW;
+    quality->stdev = sqrtf(var);
+}
+
+/**
+ * @fn quality_exchange(struct uwb_rng_instance * rng, uint16_t idx, float skew_ci, struct uwb_rng_quality * quality)
+ * @brief Clock offset consistency of the exchange ending at idx.
+ *
+ * @param rng       Pointer to struct uwb_rng_instance.
+ * @param idx       Ring index of the final frame.
+ * @param skew_ci   Peer clock rate over ours minus one from the carrier integrator, NAN if unknown.
+ * @param quality   Pointer to struct uwb_rng_quality.
+ *
+ * @return false if idx does not hold a final frame
+ */
+static bool
+quality_exchange(struct uwb_rng_instance * rng, uint16_t idx, float skew_ci, struct uwb_rng_quality * quality)
+{
+    twr_frame_t * frame = rng->frames[idx%rng->nframes];
+    float tof_ss, skew_ts;
+
+    switch(frame->code){
+        case DWT_SS_TWR_FINAL:
+        case DWT_SS_TWR_EXT_FINAL:
+        case DWT_DS_TWR_FINAL:
+        case DWT_DS_TWR_EXT_FINAL:
+            break;
+        default:
+            return false;
+    }
+    skew_ts = uwb_rng_twr_to_skew(rng, idx, skew_ci, &tof_ss);
+    quality->skew = (skew_ts - skew_ci) * 1e6f;
+    quality->residual = uwb_rng_tof_to_meters(tof_ss - uwb_rng_twr_to_tof(rng, idx));
+    quality->retries = 0;
+    return true;
+}
+
+/**
+ * @fn uwb_rng_quality_capture(struct uwb_rng_instance * rng)
+ * @brief Record the quality of the range just completed, from complete_cb. Completions
+ * of other services leave the ring index where it was and are ignored.
+ *
+ * @param rng   Pointer to struct uwb_rng_instance.
+ *
+ * @return void
+ */
+void
+uwb_rng_quality_capture(struct uwb_rng_instance * rng)
+{
+    struct uwb_dev * inst = rng->dev_inst;
+    twr_frame_t * frame = rng->frames[rng->idx%rng->nframes];
+    float skew_ci = NAN;
+
+    if (rng->quality_idx == rng->idx)
+        return;
+    if (!inst->config.dblbuffon_enabled)
+        skew_ci = uwb_calc_clock_offset_ratio(inst, inst->carrier_integrator, UWB_CR_CARRIER_INTEGRATOR);
+    if (!quality_exchange(rng, rng->idx, skew_ci, &rng->quality))
+        return;
+
+    // Only the initiator knows of the requests that went unanswered
+    uint16_t peer = (frame->src_address == inst->my_short_address) ? frame->dst_address : frame->src_address;
+    if (peer == rng->attempt_address && rng->attempts) {
+        rng->quality.retries = (rng->attempts > UINT8_MAX) ? UINT8_MAX : rng->attempts - 1;
+        rng->attempts = 0;
+    }
+    uwb_rng_quality_calc(inst, inst->config.rxdiag_enable ? inst->rxdiag : NULL, &rng->quality);
+    rng->quality_idx = rng->idx;
+}
+
+/**
+ * @fn uwb_rng_get_quality(struct uwb_rng_instance * rng, uint16_t idx, struct uwb_rng_quality * quality)
+ * @brief Quality of the range ending at a ring index. The last range completed has its
+ * record captured with the diagnostics, older ones are scored on the exchange alone.
+ *
+ * @param rng       Pointer to struct uwb_rng_instance.
+ * @param idx       Ring index of the final frame, as passed to uwb_rng_twr_to_tof.
+ * @param quality   Pointer to struct uwb_rng_quality.
+ *
+ * @return void
+ */
+void
+uwb_rng_get_quality(struct uwb_rng_instance * rng, uint16_t idx, struct uwb_rng_quality * quality)
+{
+    if (rng->quality_idx != 0xFFFF && idx%rng->nframes == rng->quality_idx%rng->nframes) {
+        *quality = rng->quality;
+        return;
+    }
+    *quality = (struct uwb_rng_quality){
+        .skew = NAN,
+        .residual = NAN
+    };
+    quality_exchange(rng, idx, NAN, quality);
+    uwb_rng_quality_calc(rng->dev_inst, NULL, quality);
+}
+
+#endif /* MYNEWT_VAL(RNG_QUALITY) */
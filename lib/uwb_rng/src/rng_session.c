@@ -0,0 +1,501 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file rng_session.c
+ * @brief Concurrent responder sessions
+ *
+ * @details An exchange is a fixed timeline for the responder: its responses
+ * and the initiator's frames follow each other one holdoff apart, starting one
+ * holdoff after the request. A request is admitted only if that timeline does
+ * not overlap the steps left of the sessions already open, so every session
+ * keeps its airtime. Between steps the receiver stays on for the other
+ * initiators, and a response is programmed only once no frame is expected
+ * before it, because a pending delayed transmission blocks reception.
+ *
+ * Frames of a session reach the twr services as in a single exchange: the
+ * last frame sent is restored to the ring just ahead of the frame received,
+ * so rng->frames[idx - 1] and rng->frames[idx] belong to the same initiator.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <os/os.h>
+#include <stats/stats.h>
+
+#include <uwb/uwb.h>
+#include <uwb/uwb_mac.h>
+#include <uwb_rng/uwb_rng.h>
+
+#if MYNEWT_VAL(RNG_SESSIONS)
+
+#if MYNEWT_VAL(RNG_STATS)
+#define RNG_STATS_INC(__X) STATS_INC(rng->stat, __X)
+#else
+#define RNG_STATS_INC(__X) {}
+#endif
+
+#define DTU(__usec) ((uint64_t)(__usec) << 16)
+
+/* Signed difference of two 40 bit device times */
+static inline int64_t
+dtu_diff(uint64_t a, uint64_t b)
+{
+    return ((int64_t)((a - b) << 24)) >> 24;
+}
+
+/* Request code a frame continues, 0 if it is not one the responder receives mid exchange */
+static uint16_t
+session_request_code(uint16_t code)
+{
+    switch(code){
+        case DWT_SS_TWR_FINAL: return DWT_SS_TWR;
+        case DWT_DS_TWR_T2: return DWT_DS_TWR;
+        case DWT_DS_TWR_EXT_T2: return DWT_DS_TWR_EXT;
+        default: return 0;
+    }
+}
+
+/* Steps and airtime of an exchange, false for codes the responder does not answer */
+static bool
+session_steps(struct uwb_rng_session * s, struct uwb_dev * inst)
+{
+    uint16_t len[3] = {sizeof(ieee_rng_response_frame_t), sizeof(twr_frame_final_t), sizeof(twr_frame_final_t)};
+    uint16_t overhead = 0;
+
+    switch(s->code){
+        case DWT_SS_TWR:
+            s->nsteps = 2;
+            break;
+        case DWT_SS_TWR_EXT:
+            s->nsteps = 1;
+            len[0] = sizeof(twr_frame_t);
+            break;
+        case DWT_DS_TWR:
+            s->nsteps = 3;
+            break;
+        case DWT_DS_TWR_EXT:
+            s->nsteps = 3;
+            len[1] = len[2] = sizeof(twr_frame_t);
+            break;
+        default:
+            return false;
+    }
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+    overhead = uwb_sec_overhead(inst);
+#endif
+    for (uint8_t k = 0; k < s->nsteps; k++)
+        s->duration[k] = DTU(uwb_phy_frame_duration(inst, len[k] + overhead));
+    s->lead = DTU(uwb_phy_SHR_duration(inst) + MYNEWT_VAL(RNG_SESSION_TX_MARGIN));
+    return true;
+}
+
+/*
+ * Airtime of step k. A response occupies the radio from the time it must be
+ * programmed, a frame of the initiator for its arrival uncertainty around
+ * the expected time.
+ */
+static void
+session_interval(struct uwb_rng_session * s, uint8_t k, uint64_t * start, uint64_t * end)
+{
+    uint64_t t = s->t0 + (uint64_t)k * s->holdoff;
+
+    if (k & 1) {
+        *start = t - s->guard;
+        *end = t + s->duration[k] + s->guard;
+    } else {
+        *start = t - s->lead;
+        *end = t + s->duration[k] + ((k) ? s->guard : 0);
+    }
+}
+
+static bool
+session_overlap(struct uwb_rng_session * a, struct uwb_rng_session * b)
+{
+    uint64_t as, ae, bs, be;
+
+    for (uint8_t i = a->step; i < a->nsteps; i++) {
+        session_interval(a, i, &as, &ae);
+        for (uint8_t j = b->step; j < b->nsteps; j++) {
+            session_interval(b, j, &bs, &be);
+            if (dtu_diff(as, be) < 0 && dtu_diff(bs, ae) < 0)
+                return true;
+        }
+    }
+    return false;
+}
+
+/* Admit a request received at rx_time if its timeline fits between the open sessions */
+static struct uwb_rng_session *
+session_open(struct uwb_rng_instance * rng, uint16_t code, uint64_t rx_time)
+{
+    struct uwb_rng_config * config = uwb_rng_get_config(rng, code);
+    struct uwb_rng_session * free = NULL;
+    struct uwb_rng_session new = {
+        .code = code,
+        .holdoff = DTU(config->tx_holdoff_delay),
+        .guard = DTU(config->rx_timeout_delay),
+    };
+
+    if (!session_steps(&new, rng->dev_inst))
+        return NULL;
+    new.t0 = rx_time + new.holdoff;
+
+    for (uint16_t i = 0; i < MYNEWT_VAL(RNG_SESSIONS); i++) {
+        struct uwb_rng_session * s = &rng->sessions[i];
+        if (s->state == RNG_SESSION_FREE) {
+            if (free == NULL)
+                free = s;
+        } else if (session_overlap(s, &new)) {
+            RNG_STATS_INC(session_busy);
+            return NULL;
+        }
+    }
+    if (free == NULL) {
+        RNG_STATS_INC(session_full);
+        return NULL;
+    }
+    *free = new;
+    free->state = RNG_SESSION_RX;
+    RNG_STATS_INC(session_open);
+    return free;
+}
+
+static struct uwb_rng_session *
+session_find(struct uwb_rng_instance * rng, uint16_t src_address)
+{
+    for (uint16_t i = 0; i < MYNEWT_VAL(RNG_SESSIONS); i++) {
+        struct uwb_rng_session * s = &rng->sessions[i];
+        if (s->state != RNG_SESSION_FREE && s->src_address == src_address)
+            return s;
+    }
+    return NULL;
+}
+
+/**
+ * @fn uwb_rng_session_active(struct uwb_rng_instance * rng)
+ * @brief Check for open responder sessions.
+ *
+ * @param rng   Pointer to struct uwb_rng_instance.
+ *
+ * @return true if a session is open
+ */
+bool
+uwb_rng_session_active(struct uwb_rng_instance * rng)
+{
+    for (uint16_t i = 0; i < MYNEWT_VAL(RNG_SESSIONS); i++) {
+        if (rng->sessions[i].state != RNG_SESSION_FREE)
+            return true;
+    }
+    return false;
+}
+
+/*
+ * Drive the radio for the open sessions. The listen the sessions kept
+ * waiting is released once none is left, as a receive timeout releases it;
+ * ended is set when the caller closed a session itself.
+ */
+static bool
+session_run(struct uwb_rng_instance * rng, bool ended)
+{
+    struct uwb_dev * inst = rng->dev_inst;
+    struct uwb_rng_session * tx, * rx;
+    uint64_t now, start, end, rx_start = 0, deadline;
+    bool active, closed = false;
+
+again:
+    now = uwb_read_systime(inst);
+    tx = rx = NULL;
+    active = false;
+    deadline = now + DTU(0xFFFF);
+
+    for (uint16_t i = 0; i < MYNEWT_VAL(RNG_SESSIONS); i++) {
+        struct uwb_rng_session * s = &rng->sessions[i];
+        switch(s->state){
+            case RNG_SESSION_RX:
+                // The twr service has not queued the response, give up once it is too late to send
+                session_interval(s, s->step, &start, &end);
+                if (dtu_diff(start, now) < 0) {
+                    s->state = RNG_SESSION_FREE;
+                    closed = true;
+                    RNG_STATS_INC(session_late);
+                    continue;
+                }
+                if (dtu_diff(start, deadline) < 0)
+                    deadline = start;
+                break;
+            case RNG_SESSION_TX:
+                if (tx == NULL || dtu_diff(s->tx_time, tx->tx_time) < 0)
+                    tx = s;
+                break;
+            case RNG_SESSION_WAIT:
+                session_interval(s, s->step, &start, &end);
+                if (dtu_diff(now, end) > 0) {
+                    s->state = RNG_SESSION_FREE;
+                    closed = true;
+                    RNG_STATS_INC(session_expired);
+                    continue;
+                }
+                if (rx == NULL || dtu_diff(start, rx_start) < 0) {
+                    rx = s;
+                    rx_start = start;
+                }
+                if (dtu_diff(end, deadline) < 0)
+                    deadline = end;
+                break;
+            case RNG_SESSION_TXING:
+                break;
+            default:
+                continue;
+        }
+        active = true;
+    }
+
+    if (rng->session_txing)
+        return true;
+
+    if (tx && (rx == NULL || dtu_diff(rx_start, tx->tx_time) > 0)
+        && dtu_diff(tx->tx_time - tx->lead, now) <= 0) {
+        // Nothing to receive before the response and it is due, the radio is committed to it from now on
+        uwb_phy_forcetrxoff(inst);
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+        uwb_sec_write(inst, tx->frame.array, tx->len, tx->sec, tx->sec_len);
+#else
+        uwb_write_tx(inst, tx->frame.array, 0, tx->len);
+        uwb_write_tx_fctrl(inst, tx->len, 0);
+#endif
+        uwb_set_wait4resp(inst, false);
+        uwb_set_delay_start(inst, tx->tx_time);
+        if (uwb_start_tx(inst).start_tx_error) {
+            tx->state = RNG_SESSION_FREE;
+            closed = true;
+            RNG_STATS_INC(session_late);
+            goto again;
+        }
+        tx->state = RNG_SESSION_TXING;
+        rng->session_txing = tx;
+        return true;
+    }
+    if (tx && dtu_diff(tx->tx_time - tx->lead, deadline) < 0)
+        deadline = tx->tx_time - tx->lead;
+
+    if (!active) {
+        if ((closed || ended) && dpl_sem_get_count(&rng->sem) == 0) {
+            dpl_error_t err = dpl_sem_release(&rng->sem);
+            assert(err == DPL_OK);
+            if (closed)
+                RNG_STATS_INC(rx_timeout);
+        }
+        return false;
+    }
+
+    uwb_phy_forcetrxoff(inst);
+    uwb_set_rx_timeout(inst, (dtu_diff(deadline, now) > 0) ? (uint32_t)(dtu_diff(deadline, now) >> 16) + 1 : 1);
+    uwb_set_rxauto_disable(inst, true);
+    if (uwb_start_rx(inst).start_rx_error)
+        RNG_STATS_INC(rx_error);
+    return true;
+}
+
+/**
+ * @fn uwb_rng_session_run(struct uwb_rng_instance * rng)
+ * @brief Drive the radio for the open sessions: expire the ones past their
+ * steps, program the next response if no frame is expected before it and
+ * otherwise receive until the next step is due. Called on every radio event
+ * while sessions are open.
+ *
+ * @param rng   Pointer to struct uwb_rng_instance.
+ *
+ * @return true if sessions are still open
+ */
+bool
+uwb_rng_session_run(struct uwb_rng_instance * rng)
+{
+    return session_run(rng, false);
+}
+
+/**
+ * @fn uwb_rng_session_rx(struct uwb_rng_instance * rng)
+ * @brief Receive hook of the rng interface. A request opens a session and a
+ * frame continuing an exchange is matched to its session by source address
+ * and sequence number. Either is put in the ring for the twr services.
+ *
+ * @param rng   Pointer to struct uwb_rng_instance.
+ *
+ * @return 0 if the frame is in the ring for the twr services, 1 if it was dropped, -1 if sessions do not handle it
+ */
+int
+uwb_rng_session_rx(struct uwb_rng_instance * rng)
+{
+    struct uwb_dev * inst = rng->dev_inst;
+    ieee_rng_request_frame_t * req = (ieee_rng_request_frame_t *) inst->rxbuf;
+    uint16_t code, request_code;
+    struct uwb_rng_session * s;
+    bool active;
+
+    if (inst->frame_len < sizeof(ieee_rng_request_frame_t) || inst->frame_len > sizeof(twr_frame_t))
+        return -1;
+
+    code = req->code;
+    request_code = session_request_code(code);
+    switch(code){
+        case DWT_SS_TWR:
+        case DWT_SS_TWR_EXT:
+        case DWT_DS_TWR:
+        case DWT_DS_TWR_EXT:
+        case DWT_SS_TWR_FINAL:
+        case DWT_DS_TWR_T2:
+        case DWT_DS_TWR_EXT_T2:
+            break;
+        default:
+            return -1;
+    }
+    active = uwb_rng_session_active(rng);
+    if (!active && dpl_sem_get_count(&rng->sem) == 1)
+        return -1;      // Not listening, unsolicited
+
+    // IEEE 802.15.4 standard ranging frames, software MAC filtering
+    if (inst->config.framefilter_enabled == false && req->dst_address != inst->my_short_address)
+        goto drop;
+
+    if (request_code == 0) {
+        // A request, a retry replaces the initiator's session
+        s = session_find(rng, req->src_address);
+        if (s && s != rng->session_txing)
+            s->state = RNG_SESSION_FREE;
+        s = session_open(rng, code, inst->rxtimestamp);
+        if (s == NULL)
+            goto drop;
+        s->src_address = req->src_address;
+        s->seq_num = req->seq_num;
+        memcpy(rng->frames[(rng->idx + 1) % rng->nframes]->array, inst->rxbuf, inst->frame_len);
+        rng->idx++;
+    } else {
+        s = session_find(rng, req->src_address);
+        if (s == NULL || s->state != RNG_SESSION_WAIT || s->code != request_code
+            || (uint8_t)(req->seq_num - s->seq_num) > 1) {
+            RNG_STATS_INC(session_miss);
+            goto drop;
+        }
+        memcpy(rng->frames[(rng->idx + 1) % rng->nframes], &s->frame, sizeof(twr_frame_t));
+        memcpy(rng->frames[(rng->idx + 2) % rng->nframes]->array, inst->rxbuf, inst->frame_len);
+        rng->idx += 2;
+        s->step++;
+        s->state = (s->step < s->nsteps) ? RNG_SESSION_RX : RNG_SESSION_FREE;
+    }
+    rng->session = s;
+    rng->code = code;
+
+    // The twr services ignore frames while the semaphore is free
+    if (dpl_sem_get_count(&rng->sem) == 1) {
+        dpl_error_t err = dpl_sem_pend(&rng->sem, 0);
+        assert(err == DPL_OK);
+    }
+    // Keep receiving for the other sessions should the twr service not respond
+    uwb_rng_session_run(rng);
+    return 0;
+
+drop:
+    if (active)
+        uwb_rng_session_run(rng);
+    return 1;
+}
+
+/**
+ * @fn uwb_rng_session_tx(struct uwb_rng_instance * rng, twr_frame_t * frame, uint16_t len, uint64_t tx_time)
+ * @brief Queue the response of the session being handled. Replaces the
+ * uwb_write_tx() to uwb_start_tx() sequence of the twr services, the frame is
+ * programmed once the radio is free for it.
+ *
+ * @param rng       Pointer to struct uwb_rng_instance.
+ * @param frame     Frame to send, kept by the session.
+ * @param len       Bytes to send.
+ * @param tx_time   Delayed transmission time, dtu.
+ *
+ * @return struct uwb_dev_status, start_tx_error set if the response cannot be sent
+ */
+struct uwb_dev_status
+uwb_rng_session_tx(struct uwb_rng_instance * rng, twr_frame_t * frame, uint16_t len, uint64_t tx_time)
+{
+    struct uwb_rng_session * s = rng->session;
+    struct uwb_dev_status status = rng->dev_inst->status;
+
+    rng->session = NULL;
+    status.start_tx_error = 1;
+    if (s == NULL || s->state != RNG_SESSION_RX)
+        return status;
+
+    memcpy(&s->frame, frame, sizeof(twr_frame_t));
+    s->len = len;
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+    // The MIC is computed now, programming the frame is on the clock
+    s->sec_len = uwb_sec_protect(rng->dev_inst, s->frame.array, len, s->sec);
+#endif
+    s->tx_time = tx_time;
+    s->state = RNG_SESSION_TX;
+    uwb_rng_session_run(rng);
+
+    status.start_tx_error = (s->state == RNG_SESSION_FREE);
+    return status;
+}
+
+/**
+ * @fn uwb_rng_session_tx_complete(struct uwb_rng_instance * rng)
+ * @brief Transmit hook of the rng interface, advances the session whose
+ * response was sent.
+ *
+ * @param rng   Pointer to struct uwb_rng_instance.
+ *
+ * @return true if the frame was a session response
+ */
+bool
+uwb_rng_session_tx_complete(struct uwb_rng_instance * rng)
+{
+    struct uwb_rng_session * s = rng->session_txing;
+
+    if (s == NULL)
+        return false;
+    rng->session_txing = NULL;
+    if (s->state == RNG_SESSION_TXING) {
+        s->step++;
+        s->state = (s->step < s->nsteps) ? RNG_SESSION_WAIT : RNG_SESSION_FREE;
+    }
+    session_run(rng, s->state == RNG_SESSION_FREE);
+    return true;
+}
+
+/**
+ * @fn uwb_rng_session_reset(struct uwb_rng_instance * rng)
+ * @brief Close all sessions.
+ *
+ * @param rng   Pointer to struct uwb_rng_instance.
+ *
+ * @return void
+ */
+void
+uwb_rng_session_reset(struct uwb_rng_instance * rng)
+{
+    for (uint16_t i = 0; i < MYNEWT_VAL(RNG_SESSIONS); i++)
+        rng->sessions[i].state = RNG_SESSION_FREE;
+    rng->session = NULL;
+    rng->session_txing = NULL;
+}
+
+#endif
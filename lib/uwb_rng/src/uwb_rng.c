@@ -65,6 +65,21 @@ STATS_NAME_START(rng_stat_section)
     STATS_NAME(rng_stat_section, tx_error)
     STATS_NAME(rng_stat_section, rx_timeout)
     STATS_NAME(rng_stat_section, reset)
+    STATS_NAME(rng_stat_section, rx_nack)
+#if MYNEWT_VAL(RNG_ADMIT)
+    STATS_NAME(rng_stat_section, admit_rate)
+    STATS_NAME(rng_stat_section, admit_util)
+    STATS_NAME(rng_stat_section, admit_evict)
+    STATS_NAME(rng_stat_section, tx_nack)
+#endif
+#if MYNEWT_VAL(RNG_SESSIONS)
+    STATS_NAME(rng_stat_section, session_open)
+    STATS_NAME(rng_stat_section, session_busy)
+    STATS_NAME(rng_stat_section, session_full)
+    STATS_NAME(rng_stat_section, session_miss)
+    STATS_NAME(rng_stat_section, session_expired)
+    STATS_NAME(rng_stat_section, session_late)
+#endif
 STATS_NAME_END(rng_stat_section)
 
 #define RNG_STATS_INC(__X) STATS_INC(rng->stat, __X)
@@ -81,7 +96,10 @@ static bool rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs
 static bool tx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
 static bool reset_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
 static bool rx_timeout_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
-#if MYNEWT_VAL(RNG_VERBOSE)
+#if MYNEWT_VAL(RNG_SESSIONS)
+static bool rx_error_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+#endif
+#if MYNEWT_VAL(RNG_VERBOSE) || MYNEWT_VAL(RNG_QUALITY)
 static bool complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
 #endif
 
@@ -187,7 +205,10 @@ static struct uwb_mac_interface g_cbs[] = {
             .rx_complete_cb = rx_complete_cb,
             .tx_complete_cb = tx_complete_cb,
             .rx_timeout_cb = rx_timeout_cb,
-#if MYNEWT_VAL(RNG_VERBOSE)
+#if MYNEWT_VAL(RNG_SESSIONS)
+            .rx_error_cb = rx_error_cb,
+#endif
+#if MYNEWT_VAL(RNG_VERBOSE) || MYNEWT_VAL(RNG_QUALITY)
             .complete_cb  = complete_cb,
 #endif
             .reset_cb = reset_cb
@@ -198,7 +219,10 @@ static struct uwb_mac_interface g_cbs[] = {
             .rx_complete_cb = rx_complete_cb,
             .tx_complete_cb = tx_complete_cb,
             .rx_timeout_cb = rx_timeout_cb,
-#if MYNEWT_VAL(RNG_VERBOSE)
+#if MYNEWT_VAL(RNG_SESSIONS)
+            .rx_error_cb = rx_error_cb,
+#endif
+#if MYNEWT_VAL(RNG_VERBOSE) || MYNEWT_VAL(RNG_QUALITY)
             .complete_cb  = complete_cb,
 #endif
             .reset_cb = reset_cb
@@ -210,7 +234,10 @@ static struct uwb_mac_interface g_cbs[] = {
             .rx_complete_cb = rx_complete_cb,
             .tx_complete_cb = tx_complete_cb,
             .rx_timeout_cb = rx_timeout_cb,
-#if MYNEWT_VAL(RNG_VERBOSE)
+#if MYNEWT_VAL(RNG_SESSIONS)
+            .rx_error_cb = rx_error_cb,
+#endif
+#if MYNEWT_VAL(RNG_VERBOSE) || MYNEWT_VAL(RNG_QUALITY)
             .complete_cb  = complete_cb,
 #endif
             .reset_cb = reset_cb
@@ -257,6 +284,14 @@ uwb_rng_init(struct uwb_dev * dev, struct uwb_rng_config * config, uint16_t nfra
         .delay_start_enabled = 0,
     };
     rng->idx = 0xFFFF;
+    rng->nack_address = 0xFFFF;
+#if MYNEWT_VAL(RNG_QUALITY)
+    rng->attempt_address = 0xFFFF;
+    rng->quality_idx = 0xFFFF;
+#endif
+#if MYNEWT_VAL(RNG_ADMIT)
+    uwb_rng_admit_init(rng);
+#endif
     rng->status.initialized = 1;
     
 #if MYNEWT_VAL(RNG_STATS)
@@ -331,7 +366,10 @@ uwb_rng_pkg_init(void)
     uwb_rng_set_frames(rng, g_twr_2, sizeof(g_twr_2)/sizeof(twr_frame_t));
     uwb_mac_append_interface(udev, &g_cbs[2]);
 #endif
-
+#if MYNEWT_VAL(RNG_ADMIT) && MYNEWT_VAL(RNG_ADMIT_CLI)
+    int rc = uwb_rng_admit_cli_register();
+    assert(rc == 0);
+#endif
 }
 
 /**
@@ -438,6 +476,26 @@ uwb_rng_remove_config(struct uwb_rng_instance * rng, uwb_rng_modes_t code)
     }
 }
 
+/**
+ * @fn uwb_rng_retry_after(struct uwb_rng_instance * rng, uint16_t dst_address)
+ * @brief Time left before a responder that refused a request with
+ * DWT_RNG_NACK admits the next one.
+ *
+ * @param rng           Pointer to struct uwb_rng_instance.
+ * @param dst_address   Responder.
+ *
+ * @return usec left, 0 if the responder is not known to refuse requests
+ */
+uint32_t
+uwb_rng_retry_after(struct uwb_rng_instance * rng, uint16_t dst_address)
+{
+    int32_t left = (int32_t)(rng->nack_until - os_cputime_get32());
+
+    if (rng->nack_address != dst_address || left <= 0)
+        return 0;
+    return os_cputime_ticks_to_usecs(left);
+}
+
 
 /**
  * @fn uwb_rng_request(struct uwb_rng_instance * inst, uint16_t dst_address, uwb_rng_modes_t code)
@@ -473,13 +531,27 @@ uwb_rng_request(struct uwb_rng_instance * rng, uint16_t dst_address, uwb_rng_mod
     frame->src_address = inst->my_short_address;
     frame->dst_address = dst_address;
 
+#if MYNEWT_VAL(RNG_QUALITY)
+    // Requests to the same peer count as retries until one completes
+    if (rng->attempt_address != dst_address) {
+        rng->attempt_address = dst_address;
+        rng->attempts = 0;
+    }
+    if (rng->attempts < UINT16_MAX)
+        rng->attempts++;
+#endif
+
     // Download the CIR on the response
 #if MYNEWT_VAL(CIR_ENABLED)
     cir_enable(inst->cir, true);
 #endif
 
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+    uwb_sec_write_tx(inst, frame->array, sizeof(ieee_rng_request_frame_t));
+#else
     uwb_write_tx(inst, frame->array, 0, sizeof(ieee_rng_request_frame_t));
     uwb_write_tx_fctrl(inst, sizeof(ieee_rng_request_frame_t), 0);
+#endif
     uwb_set_wait4resp(inst, true); 
     
     uint16_t frame_duration = uwb_phy_frame_duration(inst, sizeof(ieee_rng_response_frame_t));
@@ -540,7 +612,11 @@ uwb_rng_listen(struct uwb_rng_instance * rng, uwb_dev_modes_t mode)
     uwb_set_rxauto_disable(rng->dev_inst, true);
 
     RNG_STATS_INC(rng_listen);
-    if(uwb_start_rx(rng->dev_inst).start_rx_error){
+    bool start_rx = true;
+#if MYNEWT_VAL(RNG_SESSIONS)
+    start_rx = !uwb_rng_session_active(rng);   // Open sessions keep the receiver on themselves
+#endif
+    if(start_rx && uwb_start_rx(rng->dev_inst).start_rx_error){
         err = dpl_sem_release(&rng->sem);
         assert(err == DPL_OK);
         RNG_STATS_INC(rx_error);
@@ -634,16 +710,30 @@ uwb_rng_bias_correction(struct uwb_dev * dev, float Pr){
  */
 float
 uwb_rng_twr_to_tof(struct uwb_rng_instance * rng, uint16_t idx)
+{
+    twr_frame_t * first_frame = rng->frames[(uint16_t)(idx-1)%rng->nframes];
+    twr_frame_t * frame = rng->frames[(idx)%rng->nframes];
+
+    return uwb_rng_twr_to_tof_frames(rng->dev_inst, first_frame, frame);
+}
+
+/**
+ * @fn uwb_rng_twr_to_tof_frames(struct uwb_dev * inst, twr_frame_t * first_frame, twr_frame_t * frame)
+ * @brief API to calculate time of flight from the frames of an exchange, the final frame and the one before.
+ *
+ * @param inst          Pointer to struct uwb_dev.
+ * @param first_frame   Frame preceding the final frame.
+ * @param frame         Final frame.
+ *
+ * @return Time of flight
+ */
+float
+uwb_rng_twr_to_tof_frames(struct uwb_dev * inst, twr_frame_t * first_frame, twr_frame_t * frame)
 {
     float ToF = 0;
     uint64_t T1R, T1r, T2R, T2r;
     int64_t nom,denom;
 
-    struct uwb_dev * inst = rng->dev_inst;
-
-    twr_frame_t * first_frame = rng->frames[(uint16_t)(idx-1)%rng->nframes];
-    twr_frame_t * frame = rng->frames[(idx)%rng->nframes];
-
     switch(frame->code){
         case DWT_SS_TWR ... DWT_SS_TWR_END:
         case DWT_SS_TWR_EXT ... DWT_SS_TWR_EXT_END:{
@@ -674,6 +764,55 @@ uwb_rng_twr_to_tof(struct uwb_rng_instance * rng, uint16_t idx)
     return ToF;
 }
 
+/**
+ * @fn uwb_rng_twr_to_skew(struct uwb_rng_instance * rng, uint16_t idx, float skew_ci, float * tof_ss)
+ * @brief Clock offset of the peer implied by the turnaround intervals of a double sided
+ * exchange, both spans running from the first frame to the last in the peer's clock and
+ * ours, and the single sided time of flight over the round the peer replied in.
+ *
+ * @param rng      Pointer to struct uwb_rng_instance.
+ * @param idx      Ring index of the final frame.
+ * @param skew_ci  Peer clock rate over ours minus one from the carrier integrator, NAN if unknown.
+ * @param tof_ss   Single sided time of flight corrected with skew_ci, NAN if unknown, may be NULL.
+ *
+ * @return Peer clock rate over ours minus one, NAN for single sided exchanges
+ */
+float
+uwb_rng_twr_to_skew(struct uwb_rng_instance * rng, uint16_t idx, float skew_ci, float * tof_ss)
+{
+    twr_frame_t * first_frame = rng->frames[(uint16_t)(idx-1)%rng->nframes];
+    twr_frame_t * frame = rng->frames[(idx)%rng->nframes];
+    bool responder = (frame->src_address == rng->dev_inst->my_short_address);
+    uint32_t T1R, T1r, T2R, T2r, round, reply, own, peer_round;
+    float skew_ts;
+
+    if (tof_ss) {
+        *tof_ss = NAN;
+    }
+    switch(frame->code){
+        case DWT_DS_TWR ... DWT_DS_TWR_END:
+        case DWT_DS_TWR_EXT ... DWT_DS_TWR_EXT_END:
+            break;
+        default:
+            return NAN;
+    }
+    T1R = (first_frame->response_timestamp - first_frame->request_timestamp);
+    T1r = (first_frame->transmission_timestamp  - first_frame->reception_timestamp);
+    T2R = (frame->response_timestamp - frame->request_timestamp);
+    T2r = (frame->transmission_timestamp - frame->reception_timestamp);
+    // Our round and the peer's reply within it, our reply and the peer's round
+    round = responder ? T2R : T1R;
+    reply = responder ? T2r : T1r;
+    own = responder ? T1r : T2r;
+    peer_round = responder ? T1R : T2R;
+
+    skew_ts = (float)((double)((uint64_t)reply + peer_round) / (double)((uint64_t)round + own) - 1.0);
+    if (tof_ss && isfinite(skew_ci)) {
+        *tof_ss = ((float)round - (float)reply * (1.0f - skew_ci)) / 2.0f;
+    }
+    return skew_ts;
+}
+
 /**
  * @fn uwb_rng_tof_to_meters(float ToF)
  * @brief API to calculate range in meters from time-of-flight based on type of ranging.
@@ -732,6 +871,10 @@ static bool
 rx_timeout_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
 {
     struct uwb_rng_instance * rng = (struct uwb_rng_instance *)cbs->inst_ptr;
+#if MYNEWT_VAL(RNG_SESSIONS)
+    if (uwb_rng_session_run(rng))
+        return true;
+#endif
     if(dpl_sem_get_count(&rng->sem) == 1)
         return false;
 
@@ -766,6 +909,12 @@ static bool
 reset_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
 {
     struct uwb_rng_instance * rng = (struct uwb_rng_instance *)cbs->inst_ptr;
+#if MYNEWT_VAL(RNG_ADMIT)
+    rng->admit.nack_pending = false;
+#endif
+#if MYNEWT_VAL(RNG_SESSIONS)
+    uwb_rng_session_reset(rng);
+#endif
     if(dpl_sem_get_count(&rng->sem) == 0){
         dpl_error_t err = dpl_sem_release(&rng->sem);
         assert(err == DPL_OK);
@@ -776,6 +925,24 @@ reset_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
         return false;
 }
 
+#if MYNEWT_VAL(RNG_SESSIONS)
+/**
+ * @fn rx_error_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+ * @brief API for receive error callback, keeps the receiver on for open sessions.
+ *
+ * @param inst  Pointer to struct uwb_dev.
+ * @param cbs   Pointer to struct uwb_mac_interface.
+ *
+ * @return true if sessions are open
+ */
+static bool
+rx_error_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct uwb_rng_instance * rng = (struct uwb_rng_instance *)cbs->inst_ptr;
+    return uwb_rng_session_run(rng);
+}
+#endif
+
 /**
  * @fn rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
  * @brief API for receive complete callback.
@@ -792,6 +959,25 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
         return false;
 
     struct uwb_rng_instance * rng = (struct uwb_rng_instance *)cbs->inst_ptr;
+#if MYNEWT_VAL(RNG_ADMIT)
+    if (uwb_rng_admit_rx(rng, os_cputime_get32()))
+        return true;
+#endif
+#if MYNEWT_VAL(RNG_SESSIONS)
+    switch(uwb_rng_session_rx(rng)) {
+        case 0:
+            RNG_STATS_INC(rx_complete);
+            return false;   // Allow sub extensions to handle event
+        case 1:
+#if MYNEWT_VAL(RNG_ADMIT)
+            // No session could take the request, it is not charged
+            uwb_rng_admit_refund(rng);
+#endif
+            return true;
+        default:
+            break;
+    }
+#endif
     if(dpl_sem_get_count(&rng->sem) == 1){
         // unsolicited inbound
         RNG_STATS_INC(rx_unsolicited);
@@ -820,6 +1006,22 @@ rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
                 }
             }
             break;
+        case DWT_RNG_NACK:
+            {
+                // The responder refused our request, the exchange ends here
+                rng_nack_frame_t * nack = (rng_nack_frame_t *) inst->rxbuf;
+                if (inst->frame_len != sizeof(rng_nack_frame_t) || nack->seq_num != (uint8_t)rng->seq_num)
+                    break;
+                if (inst->config.framefilter_enabled == false && nack->dst_address != inst->my_short_address)
+                    break;
+                rng->nack_address = nack->src_address;
+                rng->nack_until = os_cputime_get32() + os_cputime_usecs_to_ticks(nack->retry_after * 1000UL);
+                RNG_STATS_INC(rx_nack);
+                dpl_error_t err = dpl_sem_release(&rng->sem);
+                assert(err == DPL_OK);
+                return true;
+            }
+            break;
         default:
             return false;
     }
@@ -842,6 +1044,16 @@ tx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
         return false;
     
     struct uwb_rng_instance * rng = (struct uwb_rng_instance *)cbs->inst_ptr;
+#if MYNEWT_VAL(RNG_ADMIT)
+    if (uwb_rng_admit_tx_complete(rng))
+        return true;
+#endif
+#if MYNEWT_VAL(RNG_SESSIONS)
+    if (uwb_rng_session_tx_complete(rng)) {
+        RNG_STATS_INC(tx_complete);
+        return true;
+    }
+#endif
     if(dpl_sem_get_count(&rng->sem) == 1) {
         // unsolicited inbound
         return false;
@@ -877,10 +1089,13 @@ complete_ev_cb(struct dpl_event *ev) {
 }
 
 static struct dpl_event rng_event;
+#endif
 
+#if MYNEWT_VAL(RNG_VERBOSE) || MYNEWT_VAL(RNG_QUALITY)
 /**
  * @fn complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
- * @brief API for rng complete callback and put complete_event_cb in queue.
+ * @brief API for rng complete callback, captures the quality of the range while the
+ * diagnostics of its last frame are current and put complete_event_cb in queue.
  *
  * @param inst   Pointer to struct uwb_dev.
  * @param cbs    Pointer to struct uwb_mac_interface.
@@ -894,11 +1109,16 @@ complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
     if (inst->fctrl != FCNTL_IEEE_RANGE_16)
         return false;
 
+#if MYNEWT_VAL(RNG_QUALITY)
+    uwb_rng_quality_capture(rng);
+#endif
+#if MYNEWT_VAL(RNG_VERBOSE)
     rng->idx_current = (rng->idx)%rng->nframes;
     if (!dpl_event_get_arg(&rng_event)) {
         dpl_event_init(&rng_event, complete_ev_cb, (void*) rng);
     }
     dpl_eventq_put(dpl_eventq_dflt_get(), &rng_event);
+#endif
     return false;
 }
 #endif
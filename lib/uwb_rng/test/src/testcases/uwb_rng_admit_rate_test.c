@@ -0,0 +1,124 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "uwb_rng_test.h"
+
+#define SRC_A (0x1001)
+#define SRC_B (0x1002)
+
+/* Refusal sent in place of the response, NULL if none */
+static rng_nack_frame_t *
+sent_nack(uint32_t tx_count)
+{
+    rng_nack_frame_t * nack = (rng_nack_frame_t *)g_uwb_rng_test_radio.txbuf;
+
+    if (g_uwb_rng_test_radio.tx_count == tx_count || nack->code != DWT_RNG_NACK)
+        return NULL;
+    return nack;
+}
+
+/* Request from src, an admitted one completes its exchange at once, a refusal is sent */
+static int
+request(struct uwb_rng_instance * rng, uint16_t src, uint32_t t)
+{
+    int rc = uwb_rng_test_request(rng, src, t, DWT_SS_TWR, t);
+
+    if (rc == 0)
+        uwb_rng_session_reset(rng);
+    else if (rc == UWB_RNG_TEST_REFUSED)
+        uwb_rng_admit_tx_complete(rng);
+    return rc;
+}
+
+/**
+ * Token bucket of one flooding initiator: the burst is admitted back to
+ * back, then one request per 1/rate, each refusal carrying the time its
+ * bucket holds a token again. Other initiators are not affected.
+ */
+TEST_CASE(uwb_rng_admit_rate_test)
+{
+    struct uwb_rng_instance * rng = uwb_rng_test_setup();
+    struct uwb_rng_admit * a = &rng->admit;
+    uint32_t tx_count, rx_count, admitted = 0, refused = 0, t;
+    rng_nack_frame_t * nack;
+
+    uwb_rng_admit_set(rng, 20, 4, 0);
+    a->nack = true;
+
+    // Burst of 4 at 1kHz, 20 millitokens back per ms
+    for (t = 0; t < 4000; t += 1000)
+        TEST_ASSERT(request(rng, SRC_A, t) == 0, "t %lu", (unsigned long)t);
+    TEST_ASSERT(a->sources[0].tokens == 60, "tokens %lu", (unsigned long)a->sources[0].tokens);
+
+    // 80 millitokens, (1000 - 80) / 20 per ms to go
+    tx_count = g_uwb_rng_test_radio.tx_count;
+    rx_count = g_uwb_rng_test_radio.rx_count;
+    TEST_ASSERT(uwb_rng_test_request(rng, SRC_A, 4, DWT_SS_TWR, 4000) == UWB_RNG_TEST_REFUSED);
+    nack = sent_nack(tx_count);
+    TEST_ASSERT_FATAL(nack != NULL);
+    TEST_ASSERT(nack->reason == RNG_NACK_RATE);
+    TEST_ASSERT(nack->retry_after == 46, "retry_after %d", nack->retry_after);
+    TEST_ASSERT(nack->dst_address == SRC_A && nack->src_address == UWB_RNG_TEST_ADDR);
+    TEST_ASSERT(nack->seq_num == 4);
+    // In the slot of the first response, the receiver resumes once it is sent
+    TEST_ASSERT(g_uwb_rng_test_radio.tx_time == UWB_RNG_TEST_DTU(4000) + ((uint64_t)MYNEWT_VAL(RNG_TX_HOLDOFF) << 16));
+    TEST_ASSERT(a->nack_pending);
+    TEST_ASSERT(uwb_rng_admit_tx_complete(rng));
+    TEST_ASSERT(g_uwb_rng_test_radio.rx_count == rx_count + 1);
+    TEST_ASSERT(dpl_sem_get_count(&rng->sem) == 0);
+
+    // One ms early is still refused, rounded up, on time is admitted
+    tx_count = g_uwb_rng_test_radio.tx_count;
+    TEST_ASSERT(request(rng, SRC_A, 49000) == UWB_RNG_TEST_REFUSED);
+    nack = sent_nack(tx_count);
+    TEST_ASSERT_FATAL(nack != NULL);
+    TEST_ASSERT(nack->retry_after == 1, "retry_after %d", nack->retry_after);
+    TEST_ASSERT(request(rng, SRC_A, 50000) == 0);
+    TEST_ASSERT(a->sources[0].admitted == 5 && a->sources[0].refused == 2);
+
+    // Flood at 1kHz for 2s while B asks at 10Hz, A gets one request per 50ms
+    for (t = 51000; t < 2051000; t += 1000) {
+        int rc = request(rng, SRC_A, t);
+        if (rc == 0) {
+            admitted++;
+        } else {
+            TEST_ASSERT_FATAL(rc == UWB_RNG_TEST_REFUSED);
+            nack = sent_nack(g_uwb_rng_test_radio.tx_count - 1);
+            TEST_ASSERT_FATAL(nack != NULL);
+            TEST_ASSERT(nack->reason == RNG_NACK_RATE);
+            TEST_ASSERT(nack->retry_after >= 1 && nack->retry_after <= 50, "retry_after %d", nack->retry_after);
+            refused++;
+        }
+        if (t % 100000 == 0)
+            TEST_ASSERT(request(rng, SRC_B, t + 500) == 0, "B at %lu", (unsigned long)t);
+    }
+    TEST_ASSERT(admitted == 40, "admitted %lu", (unsigned long)admitted);
+    TEST_ASSERT(refused == 2000 - 40, "refused %lu", (unsigned long)refused);
+    TEST_ASSERT(a->sources[1].address == SRC_B && a->sources[1].refused == 0);
+#if MYNEWT_VAL(RNG_STATS)
+    TEST_ASSERT(rng->stat.admit_rate == refused + 2);
+    TEST_ASSERT(rng->stat.tx_nack == refused + 2);
+#endif
+
+    // Back to a full bucket after an idle burst time
+    for (uint16_t i = 0; i < 4; i++)
+        TEST_ASSERT(request(rng, SRC_A, 2300000 + i) == 0);
+    TEST_ASSERT(request(rng, SRC_A, 2300004) == UWB_RNG_TEST_REFUSED);
+
+    uwb_rng_test_teardown(rng);
+}
@@ -0,0 +1,85 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "uwb_rng_test.h"
+
+#define SRC_A (0x3001)
+#define SRC_B (0x3002)
+#define SRC_C (0x3003)
+
+/**
+ * A request admitted but dropped by the responder sessions gets its token
+ * and budget back, so an initiator colliding with an open session is not
+ * throttled for exchanges that never happened. While a session is open a
+ * refusal is not answered, the radio stays with the session.
+ */
+TEST_CASE(uwb_rng_admit_refund_test)
+{
+    struct uwb_rng_instance * rng = uwb_rng_test_setup();
+    struct uwb_rng_admit * a = &rng->admit;
+    struct uwb_rng_admit_source * b;
+    uint32_t budget, tx_count, rx_count;
+
+    uwb_rng_admit_set(rng, 20, 2, 50);
+    a->nack = true;
+    a->last = 0;
+
+    TEST_ASSERT_FATAL(uwb_rng_test_request(rng, SRC_A, 1, DWT_DS_TWR, 1000) == 0);
+    TEST_ASSERT_FATAL(uwb_rng_session_active(rng));
+    TEST_ASSERT(a->charged == &a->sources[0]);
+    TEST_ASSERT(a->budget == MYNEWT_VAL(RNG_ADMIT_WINDOW) * 10 * 50 - uwb_rng_test_cost(rng, DWT_DS_TWR));
+    budget = a->budget;
+
+    // B overlaps A's exchange, as often as it likes
+    for (uint32_t t = 1010; t < 1050; t += 10) {
+        TEST_ASSERT(uwb_rng_test_request(rng, SRC_B, t, DWT_SS_TWR, t) == 1, "t %lu", (unsigned long)t);
+        TEST_ASSERT(a->charged == NULL);
+    }
+    b = &a->sources[1];
+    TEST_ASSERT_FATAL(b->address == SRC_B);
+    TEST_ASSERT(b->tokens == 2000, "tokens %lu", (unsigned long)b->tokens);
+    TEST_ASSERT(b->admitted == 0 && b->refused == 0);
+    TEST_ASSERT(a->budget == budget + 40 * 50 / 100, "budget %lu", (unsigned long)a->budget);
+    TEST_ASSERT(a->sources[0].admitted == 1 && a->sources[0].tokens == 1000);
+#if MYNEWT_VAL(RNG_STATS)
+    TEST_ASSERT(rng->stat.session_busy == 4);
+    TEST_ASSERT(rng->stat.session_open == 1);
+#endif
+
+    // No budget left, C is refused without a refusal on air
+    tx_count = g_uwb_rng_test_radio.tx_count;
+    rx_count = g_uwb_rng_test_radio.rx_count;
+    a->budget = 0;
+    TEST_ASSERT(uwb_rng_test_request(rng, SRC_C, 1, DWT_SS_TWR, 1050) == UWB_RNG_TEST_REFUSED);
+    TEST_ASSERT(g_uwb_rng_test_radio.tx_count == tx_count);
+    TEST_ASSERT(!a->nack_pending);
+    TEST_ASSERT(g_uwb_rng_test_radio.rx_count == rx_count + 1);
+    TEST_ASSERT(uwb_rng_session_active(rng));
+
+    // Not listening, a request is not the responder's and not charged
+    uwb_rng_session_reset(rng);
+    TEST_ASSERT_FATAL(dpl_sem_release(&rng->sem) == DPL_OK);
+    uwb_rng_test_frame(rng, SRC_C, 2, DWT_SS_TWR, sizeof(ieee_rng_request_frame_t), 500000);
+    TEST_ASSERT(!uwb_rng_admit_rx(rng, 500000));
+    TEST_ASSERT(a->charged == NULL);
+    TEST_ASSERT(a->sources[2].admitted == 0 && a->sources[2].refused == 1);
+    uwb_rng_admit_refund(rng);
+    TEST_ASSERT(a->sources[2].admitted == 0);
+
+    uwb_rng_test_teardown(rng);
+}
@@ -0,0 +1,108 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "uwb_rng_test.h"
+
+#define SOURCES (16)
+#define UTIL (50)
+#define BUDGET (MYNEWT_VAL(RNG_ADMIT_WINDOW) * 10 * UTIL)
+
+/* Request from the n-th initiator, an admitted one completes its exchange at once */
+static int
+request(struct uwb_rng_instance * rng, uint16_t n, uint32_t t)
+{
+    int rc = uwb_rng_test_request(rng, 0x2000 + n % SOURCES, n, DWT_SS_TWR, t);
+
+    if (rc == 0)
+        uwb_rng_session_reset(rng);
+    else if (rc == UWB_RNG_TEST_REFUSED)
+        uwb_rng_admit_tx_complete(rng);
+    return rc;
+}
+
+/**
+ * Utilization budget under initiators that each stay within their rate:
+ * the window is admitted at once, then exchanges as the budget refills at
+ * the cap, refusals carrying the time the budget covers one exchange again.
+ */
+TEST_CASE(uwb_rng_admit_util_test)
+{
+    struct uwb_rng_instance * rng = uwb_rng_test_setup();
+    struct uwb_rng_admit * a = &rng->admit;
+    rng_nack_frame_t * nack = (rng_nack_frame_t *)g_uwb_rng_test_radio.txbuf;
+    uint32_t cost = uwb_rng_test_cost(rng, DWT_SS_TWR);
+    uint32_t budget, retry, admitted = 0, t;
+    uint16_t n;
+
+    uwb_rng_admit_set(rng, 0, 1, UTIL);
+    a->nack = true;
+    a->last = 0;
+    TEST_ASSERT_FATAL(a->budget == BUDGET);
+    TEST_ASSERT_FATAL(cost < BUDGET / 4);
+
+    // Every 200us, 100us of budget back each
+    for (n = 0; n < SOURCES; n++) {
+        budget = BUDGET + n * 200 * UTIL / 100 - n * cost;
+        if (budget < cost)
+            break;
+        TEST_ASSERT(request(rng, n, n * 200) == 0, "n %d", n);
+        TEST_ASSERT(a->budget == budget - cost, "budget %lu", (unsigned long)a->budget);
+    }
+    TEST_ASSERT_FATAL(n == (BUDGET - 100) / (cost - 100), "admitted %d", n);
+    TEST_ASSERT(request(rng, n, n * 200) == UWB_RNG_TEST_REFUSED);
+    TEST_ASSERT(nack->reason == RNG_NACK_UTIL);
+    TEST_ASSERT(nack->dst_address == 0x2000 + n);
+    retry = (cost - budget) * 100 / UTIL;
+    TEST_ASSERT(nack->retry_after == (retry + 999) / 1000, "retry_after %d", nack->retry_after);
+    TEST_ASSERT(a->sources[n].refused == 1);
+
+    // One ms early is still refused, rounded up, on time is admitted
+    t = n * 200;
+    TEST_ASSERT(request(rng, n, t + (nack->retry_after - 1) * 1000) == UWB_RNG_TEST_REFUSED);
+    TEST_ASSERT(request(rng, n, t + nack->retry_after * 1000) == 0);
+
+    // A request above its initiator's rate takes no budget
+    uwb_rng_admit_set(rng, 20, 1, UTIL);
+    a->last = t = 100000;
+    TEST_ASSERT(request(rng, 1, t) == 0);
+    budget = a->budget;
+    TEST_ASSERT(request(rng, 1, t + 10) == UWB_RNG_TEST_REFUSED);
+    TEST_ASSERT(nack->reason == RNG_NACK_RATE);
+    TEST_ASSERT(a->budget == budget + 10 * UTIL / 100);
+
+    // Requests every 200us for 4s, the responder spends UTIL% of it in exchanges
+    uwb_rng_admit_set(rng, 0, 1, UTIL);
+    a->last = t = 200000;
+    for (n = 0; n < 20000; n++) {
+        int rc = request(rng, n, t + n * 200);
+        if (rc == 0) {
+            admitted++;
+        } else {
+            TEST_ASSERT_FATAL(rc == UWB_RNG_TEST_REFUSED);
+            TEST_ASSERT(nack->reason == RNG_NACK_UTIL);
+            TEST_ASSERT(nack->retry_after <= (cost * 100 / UTIL + 999) / 1000, "retry_after %d", nack->retry_after);
+        }
+    }
+    TEST_ASSERT(admitted * cost >= 4000000 * UTIL / 100 - 2 * cost, "busy %lu us", (unsigned long)(admitted * cost));
+    TEST_ASSERT(admitted * cost <= 4000000 * UTIL / 100 + BUDGET, "busy %lu us", (unsigned long)(admitted * cost));
+#if MYNEWT_VAL(RNG_STATS)
+    TEST_ASSERT(rng->stat.admit_util == 20000 - admitted + 2, "util %lu", (unsigned long)rng->stat.admit_util);
+#endif
+
+    uwb_rng_test_teardown(rng);
+}
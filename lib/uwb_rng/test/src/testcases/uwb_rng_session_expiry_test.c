@@ -0,0 +1,108 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "uwb_rng_test.h"
+
+#define SRC_A (0x401)
+#define RESP_LEN (sizeof(ieee_rng_response_frame_t))
+#define FINAL_LEN (sizeof(twr_frame_final_t))
+
+static void
+listen(struct uwb_rng_instance * rng)
+{
+    if (dpl_sem_get_count(&rng->sem) == 1)
+        TEST_ASSERT(dpl_sem_pend(&rng->sem, 0) == DPL_OK);
+}
+
+/* Request at t answered and its response sent, waiting for the initiator's frame at t + 1600 */
+static void
+open_wait(struct uwb_rng_instance * rng, uint16_t code, uint16_t resp_code, uint32_t t)
+{
+    listen(rng);
+    TEST_ASSERT(uwb_rng_test_request(rng, SRC_A, 1, code, t) == 0);
+    TEST_ASSERT(uwb_rng_test_respond(rng, resp_code, RESP_LEN).start_tx_error == 0);
+    uwb_rng_test_time(t + 620);
+    TEST_ASSERT(uwb_rng_session_run(rng));
+    TEST_ASSERT(uwb_rng_test_tx_done(rng));
+    TEST_ASSERT(rng->sessions[0].state == RNG_SESSION_WAIT);
+}
+
+/**
+ * Every step has its own deadline: a response not queued by the start of
+ * its slot closes the session, as does a frame of the initiator missing at
+ * the end of its window. The listen ends with the last session.
+ */
+TEST_CASE(uwb_rng_session_expiry_test)
+{
+    struct uwb_rng_instance * rng = uwb_rng_test_setup();
+
+    // Never answered, the response slot opens at 800 - 188
+    TEST_ASSERT(uwb_rng_test_request(rng, SRC_A, 1, DWT_SS_TWR, 0) == 0);
+    uwb_rng_test_time(611);
+    TEST_ASSERT(uwb_rng_session_run(rng));
+    uwb_rng_test_time(613);
+    TEST_ASSERT(!uwb_rng_session_run(rng));
+    TEST_ASSERT(dpl_sem_get_count(&rng->sem) == 1);
+#if MYNEWT_VAL(RNG_STATS)
+    TEST_ASSERT(rng->stat.session_late == 1);
+#endif
+
+    // The final is expected in [1600 - 32, 1600 + 348 + 32]
+    open_wait(rng, DWT_SS_TWR, DWT_SS_TWR_T1, 10000);
+    uwb_rng_test_time(11979);
+    TEST_ASSERT(uwb_rng_session_run(rng));
+    TEST_ASSERT(g_uwb_rng_test_radio.rx_timeout == 2);
+    uwb_rng_test_time(11981);
+    TEST_ASSERT(!uwb_rng_session_run(rng));
+    TEST_ASSERT(dpl_sem_get_count(&rng->sem) == 1);
+#if MYNEWT_VAL(RNG_STATS)
+    TEST_ASSERT(rng->stat.session_expired == 1);
+    TEST_ASSERT(rng->stat.rx_timeout == 2);
+#endif
+
+    // Double sided, the second response slot opens at 2400 - 188
+    open_wait(rng, DWT_DS_TWR, DWT_DS_TWR_T1, 20000);
+    uwb_rng_test_frame(rng, SRC_A, 1, DWT_DS_TWR_T2, FINAL_LEN, 21600);
+    TEST_ASSERT(uwb_rng_test_rx(rng, 21600) == 0);
+    TEST_ASSERT(rng->sessions[0].state == RNG_SESSION_RX && rng->sessions[0].step == 2);
+    uwb_rng_test_time(22211);
+    TEST_ASSERT(uwb_rng_session_run(rng));
+    uwb_rng_test_time(22213);
+    TEST_ASSERT(!uwb_rng_session_run(rng));
+    // Too late for the twr service to respond
+    TEST_ASSERT(uwb_rng_test_respond(rng, DWT_DS_TWR_FINAL, FINAL_LEN).start_tx_error == 1);
+#if MYNEWT_VAL(RNG_STATS)
+    TEST_ASSERT(rng->stat.session_late == 2);
+#endif
+
+    // A response the radio refuses to schedule closes the session too
+    open_wait(rng, DWT_DS_TWR, DWT_DS_TWR_T1, 30000);
+    uwb_rng_test_frame(rng, SRC_A, 1, DWT_DS_TWR_T2, FINAL_LEN, 31600);
+    TEST_ASSERT(uwb_rng_test_rx(rng, 31600) == 0);
+    TEST_ASSERT(uwb_rng_test_respond(rng, DWT_DS_TWR_FINAL, FINAL_LEN).start_tx_error == 0);
+    g_uwb_rng_test_radio.tx_error = true;
+    uwb_rng_test_time(32300);
+    TEST_ASSERT(!uwb_rng_session_run(rng));
+    TEST_ASSERT(uwb_rng_test_open(rng) == 0);
+    TEST_ASSERT(dpl_sem_get_count(&rng->sem) == 1);
+#if MYNEWT_VAL(RNG_STATS)
+    TEST_ASSERT(rng->stat.session_late == 3);
+#endif
+
+    uwb_rng_test_teardown(rng);
+}
@@ -0,0 +1,77 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "uwb_rng_test.h"
+
+#define RESP_LEN (sizeof(ieee_rng_response_frame_t))
+
+/* Request from src at t usec, answered at once if a session takes it */
+static int
+request(struct uwb_rng_instance * rng, uint16_t src, uint32_t t)
+{
+    int rc = uwb_rng_test_request(rng, src, 1, DWT_SS_TWR, t);
+
+    if (rc == 0)
+        TEST_ASSERT(uwb_rng_test_respond(rng, DWT_SS_TWR_T1, RESP_LEN).start_tx_error == 0);
+    return rc;
+}
+
+/**
+ * Admission of overlapping requests. With a 3000usec holdoff a single sided
+ * exchange occupies the response [t + 2812, t + 3252] and the final
+ * [t + 5968, t + 6380], so requests 500usec apart interleave, 250usec apart
+ * collide, and a fifth one finds no free session.
+ */
+TEST_CASE(uwb_rng_session_overlap_test)
+{
+    struct uwb_rng_instance * rng = uwb_rng_test_setup();
+    struct uwb_rng_config config = {.tx_holdoff_delay = 3000, .rx_timeout_delay = 32};
+    struct rng_config_list cfgs = {.rng_code = DWT_SS_TWR, .config = &config};
+    struct uwb_rng_session * s;
+
+    uwb_rng_append_config(rng, &cfgs);
+
+    TEST_ASSERT_FATAL(request(rng, 0x101, 0) == 0);
+    s = &rng->sessions[0];
+    TEST_ASSERT(s->state == RNG_SESSION_TX && s->src_address == 0x101 && s->nsteps == 2);
+    TEST_ASSERT(s->t0 == UWB_RNG_TEST_DTU(3000));
+    TEST_ASSERT(s->tx_time == UWB_RNG_TEST_DTU(3000));
+    // The response is not due, the receiver stays on until it is
+    TEST_ASSERT(g_uwb_rng_test_radio.tx_count == 0);
+    TEST_ASSERT(g_uwb_rng_test_radio.rx_timeout == 2812 - 50 + 1, "timeout %lu", (unsigned long)g_uwb_rng_test_radio.rx_timeout);
+
+    TEST_ASSERT(request(rng, 0x102, 250) == 1);
+    TEST_ASSERT(request(rng, 0x103, 500) == 0);
+    TEST_ASSERT(request(rng, 0x104, 1000) == 0);
+    TEST_ASSERT(request(rng, 0x105, 1500) == 0);
+    TEST_ASSERT(uwb_rng_test_open(rng) == 4);
+    TEST_ASSERT(request(rng, 0x106, 2000) == 1);
+    TEST_ASSERT(uwb_rng_test_open(rng) == 4);
+    // A first response overlapping the final of another session by 1usec is refused, one just after it fits
+    uwb_rng_session_reset(rng);
+    TEST_ASSERT(request(rng, 0x101, 10000) == 0);
+    TEST_ASSERT(request(rng, 0x102, 10000 + 5968 - 3252 + 1) == 1);
+    TEST_ASSERT(request(rng, 0x102, 10000 + 6380 - 2812) == 0);
+#if MYNEWT_VAL(RNG_STATS)
+    TEST_ASSERT(rng->stat.session_open == 6, "open %lu", (unsigned long)rng->stat.session_open);
+    TEST_ASSERT(rng->stat.session_busy == 2);
+    TEST_ASSERT(rng->stat.session_full == 1);
+#endif
+
+    uwb_rng_test_teardown(rng);
+}
@@ -0,0 +1,69 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "uwb_rng_test.h"
+
+#define SRC_A (0x301)
+#define RESP_LEN (sizeof(ieee_rng_response_frame_t))
+
+/**
+ * A retried request replaces the initiator's session, unless its response
+ * is already in the radio: that one completes and the retry is dropped.
+ */
+TEST_CASE(uwb_rng_session_retry_test)
+{
+    struct uwb_rng_instance * rng = uwb_rng_test_setup();
+    struct uwb_rng_session * s;
+
+    TEST_ASSERT_FATAL(uwb_rng_test_request(rng, SRC_A, 1, DWT_SS_TWR, 0) == 0);
+    TEST_ASSERT(uwb_rng_test_respond(rng, DWT_SS_TWR_T1, RESP_LEN).start_tx_error == 0);
+    // Within the first exchange's timeline, it would overlap it
+    TEST_ASSERT_FATAL(uwb_rng_test_request(rng, SRC_A, 2, DWT_SS_TWR, 300) == 0);
+    TEST_ASSERT(uwb_rng_test_open(rng) == 1);
+    s = rng->session;
+    TEST_ASSERT_FATAL(s != NULL);
+    TEST_ASSERT(s->seq_num == 2 && s->state == RNG_SESSION_RX);
+    TEST_ASSERT(s->t0 == UWB_RNG_TEST_DTU(300 + MYNEWT_VAL(RNG_TX_HOLDOFF)));
+    TEST_ASSERT(uwb_rng_test_respond(rng, DWT_SS_TWR_T1, RESP_LEN).start_tx_error == 0);
+    // Only the retry is answered
+    uwb_rng_test_time(950);
+    TEST_ASSERT(uwb_rng_session_run(rng));
+    TEST_ASSERT(g_uwb_rng_test_radio.tx_time == UWB_RNG_TEST_DTU(1100));
+    TEST_ASSERT(uwb_rng_test_tx_done(rng));
+#if MYNEWT_VAL(RNG_STATS)
+    TEST_ASSERT(rng->stat.session_open == 2 && rng->stat.session_busy == 0);
+#endif
+
+    // Retry while the response is programmed
+    uwb_rng_session_reset(rng);
+    TEST_ASSERT_FATAL(uwb_rng_test_request(rng, SRC_A, 5, DWT_SS_TWR, 10000) == 0);
+    TEST_ASSERT(uwb_rng_test_respond(rng, DWT_SS_TWR_T1, RESP_LEN).start_tx_error == 0);
+    uwb_rng_test_time(10620);
+    TEST_ASSERT(uwb_rng_session_run(rng));
+    TEST_ASSERT(rng->session_txing != NULL);
+    TEST_ASSERT(uwb_rng_test_request(rng, SRC_A, 6, DWT_SS_TWR, 10700) == 1);
+    TEST_ASSERT(uwb_rng_test_open(rng) == 1);
+    TEST_ASSERT(uwb_rng_test_tx_done(rng));
+    s = &rng->sessions[0];
+    TEST_ASSERT(s->seq_num == 5 && s->state == RNG_SESSION_WAIT && s->step == 1);
+#if MYNEWT_VAL(RNG_STATS)
+    TEST_ASSERT(rng->stat.session_busy == 1);
+#endif
+
+    uwb_rng_test_teardown(rng);
+}
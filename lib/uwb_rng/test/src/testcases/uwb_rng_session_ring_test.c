@@ -0,0 +1,106 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "uwb_rng_test.h"
+
+#define SRC_A (0x201)
+#define SRC_B (0x202)
+#define RESP_LEN (sizeof(ieee_rng_response_frame_t))
+#define FINAL_LEN (sizeof(twr_frame_final_t))
+
+static twr_frame_t *
+ring(struct uwb_rng_instance * rng, int16_t back)
+{
+    return rng->frames[(uint16_t)(rng->idx - back) % rng->nframes];
+}
+
+/**
+ * Two single sided exchanges interleaved 480usec apart, then a double
+ * sided one. Each frame of an initiator reaches the ring right after the
+ * response it answers, as in an exchange without sessions.
+ */
+TEST_CASE(uwb_rng_session_ring_test)
+{
+    struct uwb_rng_instance * rng = uwb_rng_test_setup();
+
+    TEST_ASSERT_FATAL(uwb_rng_test_request(rng, SRC_A, 1, DWT_SS_TWR, 0) == 0);
+    TEST_ASSERT(ring(rng, 0)->src_address == SRC_A && ring(rng, 0)->code == DWT_SS_TWR);
+    TEST_ASSERT(uwb_rng_test_respond(rng, DWT_SS_TWR_T1, RESP_LEN).start_tx_error == 0);
+    TEST_ASSERT_FATAL(uwb_rng_test_request(rng, SRC_B, 7, DWT_SS_TWR, 480) == 0);
+    TEST_ASSERT(uwb_rng_test_respond(rng, DWT_SS_TWR_T1, RESP_LEN).start_tx_error == 0);
+    TEST_ASSERT(uwb_rng_test_open(rng) == 2);
+
+    // A's response is due 188usec ahead of its 800usec slot
+    uwb_rng_test_time(620);
+    TEST_ASSERT(uwb_rng_session_run(rng));
+    TEST_ASSERT_FATAL(g_uwb_rng_test_radio.tx_count == 1);
+    TEST_ASSERT(g_uwb_rng_test_radio.tx_time == UWB_RNG_TEST_DTU(800));
+    TEST_ASSERT(((twr_frame_t *)g_uwb_rng_test_radio.txbuf)->dst_address == SRC_A);
+    TEST_ASSERT(uwb_rng_test_tx_done(rng));
+    // Receive until B's response is due
+    TEST_ASSERT(g_uwb_rng_test_radio.rx_timeout == 1092 - 1052 + 1, "timeout %lu", (unsigned long)g_uwb_rng_test_radio.rx_timeout);
+    uwb_rng_test_time(1100);
+    TEST_ASSERT(uwb_rng_session_run(rng));
+    TEST_ASSERT_FATAL(g_uwb_rng_test_radio.tx_count == 2);
+    TEST_ASSERT(g_uwb_rng_test_radio.tx_time == UWB_RNG_TEST_DTU(1280));
+    TEST_ASSERT(uwb_rng_test_tx_done(rng));
+
+    uwb_rng_test_frame(rng, SRC_A, 1, DWT_SS_TWR_FINAL, FINAL_LEN, 1600);
+    TEST_ASSERT_FATAL(uwb_rng_test_rx(rng, 1600) == 0);
+    TEST_ASSERT(ring(rng, 1)->dst_address == SRC_A && ring(rng, 1)->code == DWT_SS_TWR_T1);
+    TEST_ASSERT(ring(rng, 0)->src_address == SRC_A && ring(rng, 0)->code == DWT_SS_TWR_FINAL);
+    TEST_ASSERT(rng->code == DWT_SS_TWR_FINAL);
+    TEST_ASSERT(uwb_rng_test_open(rng) == 1);
+
+    uwb_rng_test_frame(rng, SRC_B, 8, DWT_SS_TWR_FINAL, FINAL_LEN, 2080);
+    TEST_ASSERT_FATAL(uwb_rng_test_rx(rng, 2080) == 0);
+    TEST_ASSERT(ring(rng, 1)->dst_address == SRC_B && ring(rng, 1)->seq_num == 7);
+    TEST_ASSERT(ring(rng, 0)->src_address == SRC_B && ring(rng, 0)->seq_num == 8);
+    TEST_ASSERT(uwb_rng_test_open(rng) == 0);
+
+    // A final nobody waits for, or out of sequence
+    uwb_rng_test_frame(rng, SRC_B, 9, DWT_SS_TWR_FINAL, FINAL_LEN, 2500);
+    TEST_ASSERT(uwb_rng_test_rx(rng, 2500) == 1);
+    TEST_ASSERT(uwb_rng_test_request(rng, SRC_A, 20, DWT_DS_TWR, 10000) == 0);
+    TEST_ASSERT(uwb_rng_test_respond(rng, DWT_DS_TWR_T1, RESP_LEN).start_tx_error == 0);
+    uwb_rng_test_time(10620);
+    TEST_ASSERT(uwb_rng_session_run(rng));
+    TEST_ASSERT(uwb_rng_test_tx_done(rng));
+    uwb_rng_test_frame(rng, SRC_A, 22, DWT_DS_TWR_T2, FINAL_LEN, 11600);
+    TEST_ASSERT(uwb_rng_test_rx(rng, 11600) == 1);
+#if MYNEWT_VAL(RNG_STATS)
+    TEST_ASSERT(rng->stat.session_miss == 2);
+#endif
+
+    // Double sided, the responder's final follows the initiator's T2
+    uwb_rng_test_frame(rng, SRC_A, 21, DWT_DS_TWR_T2, FINAL_LEN, 11600);
+    TEST_ASSERT_FATAL(uwb_rng_test_rx(rng, 11600) == 0);
+    TEST_ASSERT(ring(rng, 1)->dst_address == SRC_A && ring(rng, 1)->code == DWT_DS_TWR_T1);
+    TEST_ASSERT(ring(rng, 0)->src_address == SRC_A && ring(rng, 0)->code == DWT_DS_TWR_T2);
+    TEST_ASSERT(uwb_rng_test_respond(rng, DWT_DS_TWR_FINAL, FINAL_LEN).start_tx_error == 0);
+    uwb_rng_test_time(12300);
+    TEST_ASSERT(uwb_rng_session_run(rng));
+    TEST_ASSERT(g_uwb_rng_test_radio.tx_time == UWB_RNG_TEST_DTU(12400));
+    TEST_ASSERT(((twr_frame_t *)g_uwb_rng_test_radio.txbuf)->code == DWT_DS_TWR_FINAL);
+    // The last step ends the exchange and the listen with it
+    TEST_ASSERT(uwb_rng_test_tx_done(rng));
+    TEST_ASSERT(uwb_rng_test_open(rng) == 0);
+    TEST_ASSERT(dpl_sem_get_count(&rng->sem) == 1);
+
+    uwb_rng_test_teardown(rng);
+}
@@ -0,0 +1,270 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "uwb_rng_test.h"
+
+struct uwb_rng_test_radio g_uwb_rng_test_radio;
+
+static twr_frame_t g_uwb_rng_test_frames[UWB_RNG_TEST_NFRAMES];
+
+#define RADIO (&g_uwb_rng_test_radio)
+
+static struct uwb_dev_status
+radio_ok(struct uwb_dev * dev)
+{
+    return (struct uwb_dev_status){0};
+}
+
+static uint64_t
+radio_read_systime(struct uwb_dev * dev)
+{
+    return RADIO->systime;
+}
+
+/* 110 kbps-like airtime, long enough for the steps to matter */
+static uint16_t
+radio_frame_duration(struct uwb_dev * dev, uint16_t nlen)
+{
+    return 100 + 8 * nlen;
+}
+
+static uint16_t
+radio_SHR_duration(struct uwb_dev * dev)
+{
+    return 60;
+}
+
+static struct uwb_dev_status
+radio_write_tx(struct uwb_dev * dev, uint8_t * buf, uint16_t offset, uint16_t len)
+{
+    memcpy(RADIO->txbuf + offset, buf, len);
+    RADIO->txlen = offset + len;
+    return radio_ok(dev);
+}
+
+static void
+radio_write_tx_fctrl(struct uwb_dev * dev, uint16_t len, uint16_t offset)
+{
+}
+
+static struct uwb_dev_status
+radio_set_delay_start(struct uwb_dev * dev, uint64_t dx_time)
+{
+    RADIO->delay_start = dx_time;
+    return radio_ok(dev);
+}
+
+static struct uwb_dev_status
+radio_start_tx(struct uwb_dev * dev)
+{
+    struct uwb_dev_status status = {0};
+
+    if (RADIO->tx_error) {
+        status.start_tx_error = 1;
+        return status;
+    }
+    RADIO->tx_time = RADIO->delay_start;
+    RADIO->tx_count++;
+    return status;
+}
+
+static struct uwb_dev_status
+radio_start_rx(struct uwb_dev * dev)
+{
+    RADIO->rx_count++;
+    return radio_ok(dev);
+}
+
+static struct uwb_dev_status
+radio_set_rx_timeout(struct uwb_dev * dev, uint32_t timeout)
+{
+    RADIO->rx_timeout = timeout;
+    return radio_ok(dev);
+}
+
+static void
+radio_forcetrxoff(struct uwb_dev * dev)
+{
+    RADIO->trxoff_count++;
+}
+
+static struct uwb_dev_status
+radio_set_bool(struct uwb_dev * dev, bool enable)
+{
+    return radio_ok(dev);
+}
+
+static struct uwb_dev_status
+radio_set_wait4resp_delay(struct uwb_dev * dev, uint32_t delay)
+{
+    return radio_ok(dev);
+}
+
+static const struct uwb_driver_funcs g_uwb_rng_test_funcs = {
+    .uf_set_rx_timeout = radio_set_rx_timeout,
+    .uf_set_delay_start = radio_set_delay_start,
+    .uf_start_tx = radio_start_tx,
+    .uf_start_rx = radio_start_rx,
+    .uf_write_tx = radio_write_tx,
+    .uf_write_tx_fctrl = radio_write_tx_fctrl,
+    .uf_set_wait4resp = radio_set_bool,
+    .uf_set_wait4resp_delay = radio_set_wait4resp_delay,
+    .uf_set_rxauto_disable = radio_set_bool,
+    .uf_read_systime = radio_read_systime,
+    .uf_phy_frame_duration = radio_frame_duration,
+    .uf_phy_SHR_duration = radio_SHR_duration,
+    .uf_phy_forcetrxoff = radio_forcetrxoff,
+};
+
+/**
+ * Initialise a responder on the simulated radio, listening from time 0
+ * with the admission control off.
+ */
+struct uwb_rng_instance *
+uwb_rng_test_setup(void)
+{
+    struct uwb_rng_instance * rng;
+
+    memset(RADIO, 0, sizeof(*RADIO));
+    RADIO->dev.uw_funcs = &g_uwb_rng_test_funcs;
+    RADIO->dev.my_short_address = UWB_RNG_TEST_ADDR;
+    RADIO->dev.fctrl = FCNTL_IEEE_RANGE_16;
+
+    rng = uwb_rng_init(&RADIO->dev, NULL, UWB_RNG_TEST_NFRAMES);
+    assert(rng);
+    memset(g_uwb_rng_test_frames, 0, sizeof(g_uwb_rng_test_frames));
+    uwb_rng_set_frames(rng, g_uwb_rng_test_frames, UWB_RNG_TEST_NFRAMES);
+    uwb_rng_admit_set(rng, 0, 1, 0);
+    rng->admit.last = 0;
+    // Listening, as uwb_rng_listen() leaves it
+    TEST_ASSERT(dpl_sem_pend(&rng->sem, 0) == DPL_OK);
+    return rng;
+}
+
+void
+uwb_rng_test_teardown(struct uwb_rng_instance * rng)
+{
+    uwb_rng_free(rng);
+}
+
+/** Set the device time, usec */
+void
+uwb_rng_test_time(uint32_t usecs)
+{
+    RADIO->systime = UWB_RNG_TEST_DTU(usecs);
+}
+
+/** Put a ranging frame from src in the receive buffer, timestamped at timestamp usec */
+void
+uwb_rng_test_frame(struct uwb_rng_instance * rng, uint16_t src, uint8_t seq, uint16_t code, uint16_t len, uint32_t timestamp)
+{
+    struct uwb_dev * inst = rng->dev_inst;
+    twr_frame_t * frame = (twr_frame_t *)inst->rxbuf;
+
+    memset(inst->rxbuf, 0, len);
+    frame->fctrl = FCNTL_IEEE_RANGE_16;
+    frame->seq_num = seq;
+    frame->PANID = 0xDECA;
+    frame->dst_address = UWB_RNG_TEST_ADDR;
+    frame->src_address = src;
+    frame->code = code;
+    inst->fctrl = FCNTL_IEEE_RANGE_16;
+    inst->frame_len = len;
+    inst->rxtimestamp = UWB_RNG_TEST_DTU(timestamp);
+}
+
+/**
+ * Hand the frame in the receive buffer to the rng interface as its receive
+ * callback does, UWB_RNG_TEST_LATENCY after the frame's timestamp.
+ *
+ * @return UWB_RNG_TEST_REFUSED if the admission control refused it,
+ * otherwise uwb_rng_session_rx()
+ */
+int
+uwb_rng_test_rx(struct uwb_rng_instance * rng, uint32_t timestamp)
+{
+    int rc;
+
+    uwb_rng_test_time(timestamp + UWB_RNG_TEST_LATENCY);
+    if (uwb_rng_admit_rx(rng, timestamp))
+        return UWB_RNG_TEST_REFUSED;
+    rc = uwb_rng_session_rx(rng);
+    if (rc == 1)
+        uwb_rng_admit_refund(rng);
+    return rc;
+}
+
+/** Receive a request from src at timestamp usec */
+int
+uwb_rng_test_request(struct uwb_rng_instance * rng, uint16_t src, uint8_t seq, uint16_t code, uint32_t timestamp)
+{
+    uwb_rng_test_frame(rng, src, seq, code, sizeof(ieee_rng_request_frame_t), timestamp);
+    return uwb_rng_test_rx(rng, timestamp);
+}
+
+/** Time an exchange keeps the responder busy, usec, as the admission control charges it */
+uint32_t
+uwb_rng_test_cost(struct uwb_rng_instance * rng, uint16_t code)
+{
+    uint32_t steps = (code == DWT_SS_TWR_EXT) ? 1 : (code == DWT_SS_TWR) ? 2 : 3;
+
+    return steps * uwb_rng_get_config(rng, code)->tx_holdoff_delay
+        + radio_frame_duration(rng->dev_inst, sizeof(twr_frame_final_t));
+}
+
+/**
+ * Queue the response to the frame just received as a twr service does, one
+ * holdoff after its timestamp.
+ */
+struct uwb_dev_status
+uwb_rng_test_respond(struct uwb_rng_instance * rng, uint16_t code, uint16_t len)
+{
+    struct uwb_dev * inst = rng->dev_inst;
+    twr_frame_t * rx = (twr_frame_t *)inst->rxbuf;
+    twr_frame_t frame;
+
+    memset(&frame, 0, sizeof(frame));
+    frame.fctrl = FCNTL_IEEE_RANGE_16;
+    frame.seq_num = rx->seq_num;
+    frame.PANID = rx->PANID;
+    frame.dst_address = rx->src_address;
+    frame.src_address = UWB_RNG_TEST_ADDR;
+    frame.code = code;
+    return uwb_rng_session_tx(rng, &frame, len,
+        inst->rxtimestamp + ((uint64_t)uwb_rng_get_config(rng, rx->code)->tx_holdoff_delay << 16));
+}
+
+/** Complete the transmission in the radio, at the end of its airtime */
+bool
+uwb_rng_test_tx_done(struct uwb_rng_instance * rng)
+{
+    RADIO->systime = RADIO->tx_time + UWB_RNG_TEST_DTU(radio_frame_duration(&RADIO->dev, RADIO->txlen));
+    return uwb_rng_session_tx_complete(rng);
+}
+
+/** Sessions open */
+uint16_t
+uwb_rng_test_open(struct uwb_rng_instance * rng)
+{
+    uint16_t n = 0;
+
+    for (uint16_t i = 0; i < MYNEWT_VAL(RNG_SESSIONS); i++)
+        n += (rng->sessions[i].state != RNG_SESSION_FREE);
+    return n;
+}
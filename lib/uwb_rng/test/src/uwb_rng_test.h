@@ -0,0 +1,84 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _UWB_RNG_TEST_H
+#define _UWB_RNG_TEST_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "testutil/testutil.h"
+
+#include "uwb_rng/uwb_rng.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Address of the responder
+#define UWB_RNG_TEST_ADDR (0x4321)
+//! Frames in the ring
+#define UWB_RNG_TEST_NFRAMES (8)
+//! Time from a frame's timestamp to its receive callback, usec
+#define UWB_RNG_TEST_LATENCY (50)
+//! Result of uwb_rng_test_rx() for a request the admission control refused
+#define UWB_RNG_TEST_REFUSED (2)
+
+//! usec to device time units
+#define UWB_RNG_TEST_DTU(__usec) (((uint64_t)(__usec) << 16) & 0xFFFFFFFFFFULL)
+
+//! Simulated radio, records what the rng interface programs
+struct uwb_rng_test_radio {
+    struct uwb_dev dev;
+    uint64_t systime;                  //!< Device time, dtu
+    uint8_t txbuf[sizeof(twr_frame_t)];//!< Frame written
+    uint16_t txlen;
+    uint64_t delay_start;              //!< Delayed start programmed, dtu
+    uint64_t tx_time;                  //!< Delayed start of the last frame sent, dtu
+    uint32_t rx_timeout;               //!< Receive timeout programmed, usec
+    uint32_t tx_count;                 //!< Transmissions started
+    uint32_t rx_count;                 //!< Receptions started
+    uint32_t trxoff_count;             //!< Radio forced off
+    bool tx_error;                     //!< Fail the next transmissions, as a late delayed start
+};
+
+extern struct uwb_rng_test_radio g_uwb_rng_test_radio;
+
+struct uwb_rng_instance * uwb_rng_test_setup(void);
+void uwb_rng_test_teardown(struct uwb_rng_instance * rng);
+void uwb_rng_test_time(uint32_t usecs);
+void uwb_rng_test_frame(struct uwb_rng_instance * rng, uint16_t src, uint8_t seq, uint16_t code, uint16_t len, uint32_t timestamp);
+int uwb_rng_test_rx(struct uwb_rng_instance * rng, uint32_t timestamp);
+int uwb_rng_test_request(struct uwb_rng_instance * rng, uint16_t src, uint8_t seq, uint16_t code, uint32_t timestamp);
+uint32_t uwb_rng_test_cost(struct uwb_rng_instance * rng, uint16_t code);
+struct uwb_dev_status uwb_rng_test_respond(struct uwb_rng_instance * rng, uint16_t code, uint16_t len);
+bool uwb_rng_test_tx_done(struct uwb_rng_instance * rng);
+uint16_t uwb_rng_test_open(struct uwb_rng_instance * rng);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,182 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file uwb_sec.h
+ * @brief Authenticated ranging and clock calibration frames
+ *
+ * @details Frames sent through uwb_sec_write_tx() get a trailer of a frame
+ * counter, a key id and an IEEE 802.15.4 CCM* MIC (security levels 1 to 3,
+ * authentication only) over the whole frame. Frames with 16 bit frame
+ * control carry the security enabled bit, clock calibration blinks are
+ * secured when UWB_SEC_CCP is set. The trailer sits after the payload rather
+ * than after the mac header so the services keep their frame layouts. On
+ * receive the MIC is checked and the counter tested against a 32 frame
+ * replay window of the source before the trailer is stripped and the frame
+ * handed to the interfaces registered after this one. Up to UWB_SEC_SOURCES
+ * sources keep a window of their own; when one is replaced its highest
+ * counter is kept as a high-water mark of that address under its key, and
+ * the source has to exceed it to get a window again. Each key keeps
+ * UWB_SEC_EVICTED marks, the oldest one is dropped when full: past
+ * UWB_SEC_SOURCES + UWB_SEC_EVICTED senders the frames of the source whose
+ * mark was dropped can be replayed once more, no sender is ever locked out.
+ * Size both for the senders heard, see the mark_dropped stat. Rejected frames are
+ * handled as a frame check error. The nonce is the source short address,
+ * the frame counter and the security level; the counter is shared by all
+ * keys and the last value should be restored with uwb_sec_set_tx_key()
+ * after a reboot, receivers otherwise take the frames as replays.
+ */
+
+#ifndef _UWB_SEC_H_
+#define _UWB_SEC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stats/stats.h>
+#include <uwb/uwb.h>
+#include <uwb/uwb_ftypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if MYNEWT_VAL(UWB_SEC_MIC_LEN) != 4 && MYNEWT_VAL(UWB_SEC_MIC_LEN) != 8 && MYNEWT_VAL(UWB_SEC_MIC_LEN) != 16
+#error "UWB_SEC_MIC_LEN must be 4, 8 or 16"
+#endif
+
+#define UWB_SEC_LEVEL       (MYNEWT_VAL(UWB_SEC_MIC_LEN) == 4 ? 1 : MYNEWT_VAL(UWB_SEC_MIC_LEN) == 8 ? 2 : 3)
+#define UWB_SEC_TRAILER_LEN (sizeof(uwb_sec_aux_t) + MYNEWT_VAL(UWB_SEC_MIC_LEN))
+#define UWB_SEC_PEER_ANY    (0xFFFF)    //!< Key used with any peer
+#define UWB_SEC_WINDOW      (32)        //!< Replay window, frames
+
+#if MYNEWT_VAL(UWB_SEC_STATS)
+STATS_SECT_START(uwb_sec_stat_section)
+    STATS_SECT_ENTRY(tx_secured)
+    STATS_SECT_ENTRY(tx_precomputed)
+    STATS_SECT_ENTRY(tx_exhausted)
+    STATS_SECT_ENTRY(rx_secured)
+    STATS_SECT_ENTRY(rx_unsecured)
+    STATS_SECT_ENTRY(rx_malformed)
+    STATS_SECT_ENTRY(rx_no_key)
+    STATS_SECT_ENTRY(rx_mic_fail)
+    STATS_SECT_ENTRY(rx_replay)
+    STATS_SECT_ENTRY(evicted)
+    STATS_SECT_ENTRY(mark_dropped)
+STATS_SECT_END
+#define UWB_SEC_STATS_INC(__X) STATS_INC(sec->stat, __X)
+#else
+#define UWB_SEC_STATS_INC(__X) {}
+#endif
+
+//! Auxiliary security fields, followed by the MIC
+typedef struct _uwb_sec_aux_t{
+    uint32_t frame_counter;            //!< Frame counter of the sender
+    uint8_t key_id;                    //!< Key table entry, 0 is not a key
+}__attribute__((__packed__,aligned(1))) uwb_sec_aux_t;
+
+//! AES-128 round keys
+typedef struct _uwb_sec_aes_t{
+    uint8_t rk[176];
+}uwb_sec_aes_t;
+
+//! CCM* authentication in progress
+struct uwb_sec_ccm {
+    uint8_t x[16];                     //!< CBC-MAC chaining value
+    uint8_t s0[16];                    //!< Key stream block encrypting the MIC
+    uint8_t pos;                       //!< Bytes folded into x since its last encryption
+};
+
+//! High-water mark of a source whose replay window was replaced
+struct uwb_sec_mark {
+    uint16_t address;                  //!< Source short address
+    uint32_t next;                     //!< Lowest counter not accepted yet, 0 marks a free entry
+    uint32_t last;                     //!< Cputime of the eviction
+};
+
+//! Key table entry
+struct uwb_sec_key {
+    uint8_t id;                        //!< Key id, 0 marks a free entry
+    uint16_t peer;                     //!< Only peer using the key, UWB_SEC_PEER_ANY for a group key
+    uwb_sec_aes_t aes;                 //!< Expanded key
+    struct uwb_sec_mark evicted[MYNEWT_VAL(UWB_SEC_EVICTED)]; //!< Marks of the sources evicted, the oldest one is dropped when full
+};
+
+//! Replay window of a source
+struct uwb_sec_source {
+    uint16_t address;                  //!< Source short address
+    uint8_t key_id;                    //!< Key the counters apply to, 0 marks a free entry
+    uint32_t counter;                  //!< Highest frame counter accepted
+    uint32_t window;                   //!< Bit n set if counter - n was accepted
+    uint32_t last;                     //!< Cputime of the last frame
+};
+
+//! Config parameters
+struct uwb_sec_config {
+    uint8_t required:1;                //!< Drop unsecured ranging frames and blinks
+    uint8_t ccp:1;                     //!< Clock calibration blinks are secured
+};
+
+//! Status
+typedef struct _uwb_sec_status_t{
+    uint16_t selfmalloc:1;             //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;            //!< Instance allocated
+    uint16_t next_valid:1;             //!< next holds the precomputed blocks of tx_counter
+}uwb_sec_status_t;
+
+//! Security instance
+struct uwb_sec_instance {
+#if MYNEWT_VAL(UWB_SEC_STATS)
+    STATS_SECT_DECL(uwb_sec_stat_section) stat; //!< Stats instance
+#endif
+    struct uwb_dev * dev_inst;         //!< Structure of uwb_dev
+    struct uwb_mac_interface cbs;      //!< MAC layer callbacks
+    uwb_sec_status_t status;           //!< Status
+    struct uwb_sec_config config;      //!< Config
+    uint8_t tx_key_id;                 //!< Group key of sent frames, 0 sends them unsecured
+    uint32_t tx_counter;               //!< Frame counter of the next secured frame
+    struct uwb_sec_ccm next;           //!< Nonce blocks of tx_counter under the group key, computed off the tx path
+    struct uwb_sec_key keys[MYNEWT_VAL(UWB_SEC_KEYS)];          //!< Key table
+    struct uwb_sec_source sources[MYNEWT_VAL(UWB_SEC_SOURCES)]; //!< Replay windows
+};
+
+struct uwb_sec_instance * uwb_sec_init(struct uwb_sec_instance * sec, struct uwb_dev * inst);
+void uwb_sec_free(struct uwb_sec_instance * sec);
+struct uwb_sec_instance * uwb_sec_get_instance(struct uwb_dev * inst);
+
+int uwb_sec_key_set(struct uwb_sec_instance * sec, uint8_t id, const uint8_t key[16], uint16_t peer);
+int uwb_sec_key_delete(struct uwb_sec_instance * sec, uint8_t id);
+int uwb_sec_set_tx_key(struct uwb_sec_instance * sec, uint8_t id, uint32_t counter);
+void uwb_sec_reset_sources(struct uwb_sec_instance * sec);
+
+uint16_t uwb_sec_overhead(struct uwb_dev * inst);
+uint16_t uwb_sec_protect(struct uwb_dev * inst, const uint8_t * frame, uint16_t len, uint8_t * trailer);
+void uwb_sec_write(struct uwb_dev * inst, const uint8_t * frame, uint16_t len, const uint8_t * trailer, uint16_t trailer_len);
+uint16_t uwb_sec_write_tx(struct uwb_dev * inst, const uint8_t * frame, uint16_t len);
+
+void uwb_sec_aes_expand(uwb_sec_aes_t * aes, const uint8_t key[16]);
+void uwb_sec_aes_encrypt(const uwb_sec_aes_t * aes, const uint8_t in[16], uint8_t out[16]);
+void uwb_sec_ccm_start(const uwb_sec_aes_t * aes, struct uwb_sec_ccm * ccm, const uint8_t nonce[13], uint8_t mic_len);
+void uwb_sec_ccm_update(const uwb_sec_aes_t * aes, struct uwb_sec_ccm * ccm, const uint8_t * data, uint16_t len);
+void uwb_sec_ccm_mic(const uwb_sec_aes_t * aes, struct uwb_sec_ccm * ccm, uint8_t * mic, uint8_t mic_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _UWB_SEC_H_ */
@@ -0,0 +1,786 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file uwb_sec.c
+ * @brief Authenticated ranging and clock calibration frames
+ *
+ * @details The nonce blocks of the next frame counter under the group key
+ * are encrypted from tx_complete_cb, once the radio is done with the
+ * previous frame, so the tx path of a response only pays for the frame
+ * blocks: two to four AES blocks for the ranging frames. Pairwise keys, a
+ * source other than our own address or a counter taken by another frame fall
+ * back to computing all blocks inline.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <os/os.h>
+#include <sysinit/sysinit.h>
+#include <stats/stats.h>
+#include <uwb/uwb_mac.h>
+#include <uwb_sec/uwb_sec.h>
+
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+
+#if MYNEWT_VAL(UWB_SEC_STATS)
+STATS_NAME_START(uwb_sec_stat_section)
+    STATS_NAME(uwb_sec_stat_section, tx_secured)
+    STATS_NAME(uwb_sec_stat_section, tx_precomputed)
+    STATS_NAME(uwb_sec_stat_section, tx_exhausted)
+    STATS_NAME(uwb_sec_stat_section, rx_secured)
+    STATS_NAME(uwb_sec_stat_section, rx_unsecured)
+    STATS_NAME(uwb_sec_stat_section, rx_malformed)
+    STATS_NAME(uwb_sec_stat_section, rx_no_key)
+    STATS_NAME(uwb_sec_stat_section, rx_mic_fail)
+    STATS_NAME(uwb_sec_stat_section, rx_replay)
+    STATS_NAME(uwb_sec_stat_section, evicted)
+    STATS_NAME(uwb_sec_stat_section, mark_dropped)
+STATS_NAME_END(uwb_sec_stat_section)
+#endif
+
+static bool rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static bool tx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static void sec_precompute(struct uwb_sec_instance * sec);
+
+#if MYNEWT_VAL(UWB_SEC_CLI)
+int uwb_sec_cli_register(void);
+#endif
+
+/**
+ * @fn uwb_sec_init(struct uwb_sec_instance * sec, struct uwb_dev * inst)
+ * @brief Allocate and initialise a security instance, without keys frames
+ * are sent unsecured.
+ *
+ * @param sec   Pointer to struct uwb_sec_instance, NULL to allocate.
+ * @param inst  Pointer to struct uwb_dev.
+ *
+ * @return struct uwb_sec_instance *
+ */
+struct uwb_sec_instance *
+uwb_sec_init(struct uwb_sec_instance * sec, struct uwb_dev * inst)
+{
+    assert(inst);
+
+    if (sec == NULL) {
+        sec = (struct uwb_sec_instance *) malloc(sizeof(struct uwb_sec_instance));
+        assert(sec);
+        memset(sec, 0, sizeof(struct uwb_sec_instance));
+        sec->status.selfmalloc = 1;
+    }
+    sec->dev_inst = inst;
+    sec->config = (struct uwb_sec_config){
+        .required = MYNEWT_VAL(UWB_SEC_REQUIRED),
+        .ccp = MYNEWT_VAL(UWB_SEC_CCP)
+    };
+
+    sec->cbs = (struct uwb_mac_interface){
+        .id = UWBEXT_SEC,
+        .inst_ptr = (void *) sec,
+        .rx_complete_cb = rx_complete_cb,
+        .tx_complete_cb = tx_complete_cb
+    };
+    if (!sec->status.initialized) {
+        uwb_mac_append_interface(inst, &sec->cbs);
+#if MYNEWT_VAL(UWB_SEC_STATS)
+        int rc = stats_init(
+                    STATS_HDR(sec->stat),
+                    STATS_SIZE_INIT_PARMS(sec->stat, STATS_SIZE_32),
+                    STATS_NAME_INIT_PARMS(uwb_sec_stat_section)
+            );
+        rc |= stats_register("uwb_sec", STATS_HDR(sec->stat));
+        assert(rc == 0);
+#endif
+    }
+    sec->status.initialized = 1;
+    return sec;
+}
+
+/**
+ * @fn uwb_sec_free(struct uwb_sec_instance * sec)
+ * @brief Free the instance, the keys are wiped.
+ *
+ * @param sec  Pointer to struct uwb_sec_instance.
+ *
+ * @return void
+ */
+void
+uwb_sec_free(struct uwb_sec_instance * sec)
+{
+    assert(sec);
+    uwb_mac_remove_interface(sec->dev_inst, sec->cbs.id);
+    memset(sec->keys, 0, sizeof(sec->keys));
+    memset(&sec->next, 0, sizeof(sec->next));
+    if (sec->status.selfmalloc) {
+        free(sec);
+    } else {
+        sec->status.initialized = 0;
+    }
+}
+
+/**
+ * @fn uwb_sec_get_instance(struct uwb_dev * inst)
+ * @brief Security instance of a device.
+ *
+ * @param inst  Pointer to struct uwb_dev.
+ *
+ * @return struct uwb_sec_instance *, NULL if the device has none
+ */
+struct uwb_sec_instance *
+uwb_sec_get_instance(struct uwb_dev * inst)
+{
+    return (struct uwb_sec_instance *) uwb_mac_find_cb_inst_ptr(inst, UWBEXT_SEC);
+}
+
+static struct uwb_sec_key *
+sec_key(struct uwb_sec_instance * sec, uint8_t id)
+{
+    if (id == 0) {
+        return NULL;
+    }
+    for (uint8_t i = 0; i < MYNEWT_VAL(UWB_SEC_KEYS); i++) {
+        if (sec->keys[i].id == id) {
+            return &sec->keys[i];
+        }
+    }
+    return NULL;
+}
+
+static void
+sec_forget_key(struct uwb_sec_instance * sec, uint8_t id)
+{
+    for (uint16_t i = 0; i < MYNEWT_VAL(UWB_SEC_SOURCES); i++) {
+        if (sec->sources[i].key_id == id) {
+            memset(&sec->sources[i], 0, sizeof(sec->sources[i]));
+        }
+    }
+    sec->status.next_valid = 0;
+}
+
+/**
+ * @fn uwb_sec_key_set(struct uwb_sec_instance * sec, uint8_t id, const uint8_t key[16], uint16_t peer)
+ * @brief Install or replace a key. The replay windows of the key id are reset.
+ *
+ * @param sec   Pointer to struct uwb_sec_instance.
+ * @param id    Key id, 1 to 255.
+ * @param key   AES-128 key.
+ * @param peer  Short address of the only peer using the key, UWB_SEC_PEER_ANY for a group key.
+ *
+ * @return OS_OK, OS_EINVAL for key id 0, OS_ENOMEM if the table is full
+ */
+int
+uwb_sec_key_set(struct uwb_sec_instance * sec, uint8_t id, const uint8_t key[16], uint16_t peer)
+{
+    struct uwb_sec_key * entry;
+
+    if (id == 0) {
+        return OS_EINVAL;
+    }
+    if ((entry = sec_key(sec, id)) == NULL) {
+        for (uint8_t i = 0; i < MYNEWT_VAL(UWB_SEC_KEYS); i++) {
+            if (sec->keys[i].id == 0) {
+                entry = &sec->keys[i];
+                break;
+            }
+        }
+        if (entry == NULL) {
+            return OS_ENOMEM;
+        }
+    }
+    if (id == sec->tx_key_id && peer != UWB_SEC_PEER_ANY) {
+        sec->tx_key_id = 0;
+    }
+    sec_forget_key(sec, id);
+    memset(entry->evicted, 0, sizeof(entry->evicted));
+    uwb_sec_aes_expand(&entry->aes, key);
+    entry->peer = peer;
+    entry->id = id;
+    sec_precompute(sec);
+    return OS_OK;
+}
+
+/**
+ * @fn uwb_sec_key_delete(struct uwb_sec_instance * sec, uint8_t id)
+ * @brief Wipe a key, frames are sent unsecured if it was the group key.
+ *
+ * @param sec   Pointer to struct uwb_sec_instance.
+ * @param id    Key id.
+ *
+ * @return OS_OK, OS_ENOENT if there is no such key
+ */
+int
+uwb_sec_key_delete(struct uwb_sec_instance * sec, uint8_t id)
+{
+    struct uwb_sec_key * entry = sec_key(sec, id);
+
+    if (entry == NULL) {
+        return OS_ENOENT;
+    }
+    if (id == sec->tx_key_id) {
+        sec->tx_key_id = 0;
+    }
+    sec_forget_key(sec, id);
+    memset(entry, 0, sizeof(*entry));
+    return OS_OK;
+}
+
+/**
+ * @fn uwb_sec_set_tx_key(struct uwb_sec_instance * sec, uint8_t id, uint32_t counter)
+ * @brief Select the group key of the frames sent, frames to a peer holding
+ * a pairwise key use that one instead.
+ *
+ * @param sec       Pointer to struct uwb_sec_instance.
+ * @param id        Key id, 0 to send unsecured frames.
+ * @param counter   Frame counter of the next frame, the last one used plus one after a reboot.
+ *
+ * @return OS_OK, OS_ENOENT if there is no such key, OS_EINVAL if it is a pairwise key
+ */
+int
+uwb_sec_set_tx_key(struct uwb_sec_instance * sec, uint8_t id, uint32_t counter)
+{
+    struct uwb_sec_key * entry = sec_key(sec, id);
+    os_sr_t sr;
+
+    if (id && entry == NULL) {
+        return OS_ENOENT;
+    }
+    if (entry && entry->peer != UWB_SEC_PEER_ANY) {
+        return OS_EINVAL;
+    }
+    OS_ENTER_CRITICAL(sr);
+    sec->tx_key_id = id;
+    sec->tx_counter = counter;
+    sec->status.next_valid = 0;
+    OS_EXIT_CRITICAL(sr);
+    sec_precompute(sec);
+    return OS_OK;
+}
+
+/**
+ * @fn uwb_sec_reset_sources(struct uwb_sec_instance * sec)
+ * @brief Forget the frame counters of all sources, the high-water marks
+ * of evicted sources included.
+ *
+ * @param sec   Pointer to struct uwb_sec_instance.
+ *
+ * @return void
+ */
+void
+uwb_sec_reset_sources(struct uwb_sec_instance * sec)
+{
+    memset(sec->sources, 0, sizeof(sec->sources));
+    for (uint8_t i = 0; i < MYNEWT_VAL(UWB_SEC_KEYS); i++) {
+        memset(sec->keys[i].evicted, 0, sizeof(sec->keys[i].evicted));
+    }
+}
+
+/* Source short address where the ranging frames and clock calibration blinks keep it */
+static bool
+sec_source(const uint8_t * frame, uint16_t len, bool * blink, uint16_t * src)
+{
+    if (len >= 1 && frame[0] == FCNTL_IEEE_BLINK_CCP_64) {
+        if (len < sizeof(ieee_blink_frame_t) + sizeof(uint16_t)) {
+            return false;
+        }
+        *blink = true;
+        *src = frame[sizeof(ieee_blink_frame_t)] | (frame[sizeof(ieee_blink_frame_t) + 1] << 8);
+        return true;
+    }
+    // Short destination and source addresses with pan id compression
+    if (len < 9 || ((frame[0] | (frame[1] << 8)) & 0xCC40) != 0x8840) {
+        return false;
+    }
+    *blink = false;
+    *src = frame[7] | (frame[8] << 8);
+    return true;
+}
+
+static void
+sec_nonce(uint8_t nonce[13], uint16_t src, uint32_t counter)
+{
+    memset(nonce, 0, 6);
+    nonce[6] = src >> 8;
+    nonce[7] = src & 0xFF;
+    nonce[8] = counter >> 24;
+    nonce[9] = (counter >> 16) & 0xFF;
+    nonce[10] = (counter >> 8) & 0xFF;
+    nonce[11] = counter & 0xFF;
+    nonce[12] = UWB_SEC_LEVEL;
+}
+
+/* Fold the frame, with its security bit, and the auxiliary fields */
+static void
+sec_authenticate(const uwb_sec_aes_t * aes, struct uwb_sec_ccm * ccm, const uint8_t * frame, uint16_t len,
+                 bool blink, const uwb_sec_aux_t * aux, uint8_t * mic)
+{
+    uint16_t alen = len + sizeof(uwb_sec_aux_t);
+    uint8_t head[3] = {alen >> 8, alen & 0xFF, frame[0] | (blink ? 0 : FCNTL_IEEE_SECURITY)};
+
+    uwb_sec_ccm_update(aes, ccm, head, sizeof(head));
+    uwb_sec_ccm_update(aes, ccm, frame + 1, len - 1);
+    uwb_sec_ccm_update(aes, ccm, (const uint8_t *) aux, sizeof(uwb_sec_aux_t));
+    uwb_sec_ccm_mic(aes, ccm, mic, MYNEWT_VAL(UWB_SEC_MIC_LEN));
+}
+
+/* Encrypt the nonce blocks of the next frame counter, outside of the tx path */
+static void
+sec_precompute(struct uwb_sec_instance * sec)
+{
+    struct uwb_sec_key * key = sec_key(sec, sec->tx_key_id);
+    uint32_t counter = sec->tx_counter;
+    uint8_t nonce[13];
+    struct uwb_sec_ccm ccm;
+    os_sr_t sr;
+
+    if (key == NULL || sec->status.next_valid || counter == UINT32_MAX) {
+        return;
+    }
+    sec_nonce(nonce, sec->dev_inst->my_short_address, counter);
+    uwb_sec_ccm_start(&key->aes, &ccm, nonce, MYNEWT_VAL(UWB_SEC_MIC_LEN));
+
+    OS_ENTER_CRITICAL(sr);
+    if (sec->tx_counter == counter && sec->tx_key_id == key->id) {
+        sec->next = ccm;
+        sec->status.next_valid = 1;
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * @fn uwb_sec_overhead(struct uwb_dev * inst)
+ * @brief Bytes the trailer adds to the frames sent, for airtime estimates.
+ *
+ * @param inst  Pointer to struct uwb_dev.
+ *
+ * @return UWB_SEC_TRAILER_LEN, 0 if frames are sent unsecured
+ */
+uint16_t
+uwb_sec_overhead(struct uwb_dev * inst)
+{
+    struct uwb_sec_instance * sec = uwb_sec_get_instance(inst);
+
+    return (sec && sec->tx_key_id) ? UWB_SEC_TRAILER_LEN : 0;
+}
+
+/**
+ * @fn uwb_sec_protect(struct uwb_dev * inst, const uint8_t * frame, uint16_t len, uint8_t * trailer)
+ * @brief Take a frame counter and compute the trailer of a frame, the frame
+ * itself is left untouched. Frames queued well ahead of their transmission
+ * are protected when queued, see uwb_sec_write().
+ *
+ * @param inst      Pointer to struct uwb_dev.
+ * @param frame     Frame as the services build it.
+ * @param len       Frame length, without fcs.
+ * @param trailer   UWB_SEC_TRAILER_LEN bytes out.
+ *
+ * @return trailer bytes, 0 if the frame is to be sent unsecured
+ */
+uint16_t
+uwb_sec_protect(struct uwb_dev * inst, const uint8_t * frame, uint16_t len, uint8_t * trailer)
+{
+    struct uwb_sec_instance * sec = uwb_sec_get_instance(inst);
+    struct uwb_sec_key * key = NULL;
+    struct uwb_sec_ccm ccm;
+    uwb_sec_aux_t aux;
+    bool blink, precomputed = false;
+    uint16_t src;
+    os_sr_t sr;
+
+    if (sec == NULL || sec->tx_key_id == 0 || !sec_source(frame, len, &blink, &src)) {
+        return 0;
+    }
+    if (blink && !sec->config.ccp) {
+        return 0;
+    }
+    if (!blink) {
+        uint16_t dst = frame[5] | (frame[6] << 8);
+        for (uint8_t i = 0; i < MYNEWT_VAL(UWB_SEC_KEYS) && dst != UWB_BROADCAST_ADDRESS; i++) {
+            if (sec->keys[i].id && sec->keys[i].peer == dst) {
+                key = &sec->keys[i];
+                break;
+            }
+        }
+    }
+    if (key == NULL && (key = sec_key(sec, sec->tx_key_id)) == NULL) {
+        return 0;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    aux.frame_counter = sec->tx_counter;
+    if (sec->tx_counter != UINT32_MAX) {
+        sec->tx_counter++;
+        if (sec->status.next_valid && key->id == sec->tx_key_id && src == inst->my_short_address) {
+            ccm = sec->next;
+            precomputed = true;
+        }
+    }
+    sec->status.next_valid = 0;
+    OS_EXIT_CRITICAL(sr);
+    aux.key_id = key->id;
+    memcpy(trailer, &aux, sizeof(aux));
+
+    if (aux.frame_counter == UINT32_MAX) {
+        // Exhausted, a new key is needed. The frame goes out with a MIC no receiver takes
+        UWB_SEC_STATS_INC(tx_exhausted);
+        memset(trailer + sizeof(aux), 0, MYNEWT_VAL(UWB_SEC_MIC_LEN));
+        return UWB_SEC_TRAILER_LEN;
+    }
+    if (precomputed) {
+        UWB_SEC_STATS_INC(tx_precomputed);
+    } else {
+        uint8_t nonce[13];
+        sec_nonce(nonce, src, aux.frame_counter);
+        uwb_sec_ccm_start(&key->aes, &ccm, nonce, MYNEWT_VAL(UWB_SEC_MIC_LEN));
+    }
+    sec_authenticate(&key->aes, &ccm, frame, len, blink, &aux, trailer + sizeof(aux));
+    UWB_SEC_STATS_INC(tx_secured);
+    return UWB_SEC_TRAILER_LEN;
+}
+
+/**
+ * @fn uwb_sec_write(struct uwb_dev * inst, const uint8_t * frame, uint16_t len, const uint8_t * trailer, uint16_t trailer_len)
+ * @brief Write a frame and its trailer to the tx buffer and set the frame
+ * length, the security bit is set on air only.
+ *
+ * @param inst          Pointer to struct uwb_dev.
+ * @param frame         Frame.
+ * @param len           Frame length.
+ * @param trailer       Trailer from uwb_sec_protect().
+ * @param trailer_len   Its length, 0 for an unsecured frame.
+ *
+ * @return void
+ */
+void
+uwb_sec_write(struct uwb_dev * inst, const uint8_t * frame, uint16_t len, const uint8_t * trailer, uint16_t trailer_len)
+{
+    uwb_write_tx(inst, (uint8_t *) frame, 0, len);
+    if (trailer_len) {
+        if (frame[0] != FCNTL_IEEE_BLINK_CCP_64) {
+            uint8_t fctrl = frame[0] | FCNTL_IEEE_SECURITY;
+            uwb_write_tx(inst, &fctrl, 0, sizeof(fctrl));
+        }
+        uwb_write_tx(inst, (uint8_t *) trailer, len, trailer_len);
+    }
+    uwb_write_tx_fctrl(inst, len + trailer_len, 0);
+}
+
+/**
+ * @fn uwb_sec_write_tx(struct uwb_dev * inst, const uint8_t * frame, uint16_t len)
+ * @brief Replaces the uwb_write_tx() and uwb_write_tx_fctrl() pair of the
+ * services, protecting the frame if a key is set.
+ *
+ * @param inst      Pointer to struct uwb_dev.
+ * @param frame     Frame.
+ * @param len       Frame length, without fcs.
+ *
+ * @return length on air, without fcs
+ */
+uint16_t
+uwb_sec_write_tx(struct uwb_dev * inst, const uint8_t * frame, uint16_t len)
+{
+    uint8_t trailer[UWB_SEC_TRAILER_LEN];
+    uint16_t trailer_len = uwb_sec_protect(inst, frame, len, trailer);
+
+    uwb_sec_write(inst, frame, len, trailer, trailer_len);
+    return len + trailer_len;
+}
+
+/* Replay window of a source, NULL if it has none */
+static struct uwb_sec_source *
+sec_source_find(struct uwb_sec_instance * sec, uint16_t address, uint8_t key_id)
+{
+    for (uint16_t i = 0; i < MYNEWT_VAL(UWB_SEC_SOURCES); i++) {
+        struct uwb_sec_source * s = &sec->sources[i];
+        if (s->key_id == key_id && s->address == address) {
+            return s;
+        }
+    }
+    return NULL;
+}
+
+/* High-water mark of an evicted source, NULL if it has none */
+static struct uwb_sec_mark *
+sec_mark_find(struct uwb_sec_key * key, uint16_t address)
+{
+    for (uint16_t i = 0; i < MYNEWT_VAL(UWB_SEC_EVICTED); i++) {
+        struct uwb_sec_mark * m = &key->evicted[i];
+        if (m->next && m->address == address) {
+            return m;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Keep the highest counter of an evicted source, so frames it accepted
+ * stay replays once its window is gone. The oldest mark makes room when
+ * full and its source is taken as a new one when heard again.
+ */
+static void
+sec_mark_set(struct uwb_sec_instance * sec, struct uwb_sec_key * key, uint16_t address, uint32_t counter, uint32_t now)
+{
+    struct uwb_sec_mark * m = sec_mark_find(key, address);
+    uint32_t next = counter == UINT32_MAX ? UINT32_MAX : counter + 1;
+
+    if (m == NULL) {
+        m = &key->evicted[0];
+        for (uint16_t i = 0; i < MYNEWT_VAL(UWB_SEC_EVICTED); i++) {
+            struct uwb_sec_mark * it = &key->evicted[i];
+            if (it->next == 0) {
+                if (m->next)
+                    m = it;
+            } else if (m->next && now - it->last > now - m->last) {
+                m = it;
+            }
+        }
+        if (m->next) {
+            UWB_SEC_STATS_INC(mark_dropped);
+        }
+        m->next = 0;
+    }
+    m->address = address;
+    if (next > m->next) {
+        m->next = next;
+    }
+    m->last = now;
+}
+
+/*
+ * New replay window, the least recently heard one is replaced when full.
+ * A returning source takes its mark back into the window: every counter
+ * below it counts as accepted, the mark is freed.
+ */
+static struct uwb_sec_source *
+sec_source_new(struct uwb_sec_instance * sec, uint16_t address, uint8_t key_id, uint32_t now)
+{
+    struct uwb_sec_source * victim = &sec->sources[0];
+    struct uwb_sec_key * key = sec_key(sec, key_id);
+    struct uwb_sec_mark * m = key ? sec_mark_find(key, address) : NULL;
+    uint32_t next = 0;
+
+    // Taken before the eviction below can drop it
+    if (m) {
+        next = m->next;
+        memset(m, 0, sizeof(*m));
+    }
+
+    for (uint16_t i = 0; i < MYNEWT_VAL(UWB_SEC_SOURCES); i++) {
+        struct uwb_sec_source * s = &sec->sources[i];
+        if (s->key_id == 0) {
+            if (victim->key_id)
+                victim = s;
+        } else if (victim->key_id && now - s->last > now - victim->last) {
+            victim = s;
+        }
+    }
+    if (victim->key_id) {
+        UWB_SEC_STATS_INC(evicted);
+        if ((key = sec_key(sec, victim->key_id)) != NULL) {
+            sec_mark_set(sec, key, victim->address, victim->counter, now);
+        }
+    }
+    memset(victim, 0, sizeof(*victim));
+    victim->address = address;
+    victim->key_id = key_id;
+    if (next) {
+        victim->counter = next - 1;
+        victim->window = UINT32_MAX;
+    }
+    return victim;
+}
+
+/* Frame of a source without a replay window, at or below what it accepted before its eviction */
+static bool
+sec_evicted_replayed(struct uwb_sec_key * key, uint16_t address, uint32_t counter)
+{
+    struct uwb_sec_mark * m = sec_mark_find(key, address);
+
+    return m != NULL && counter < m->next;
+}
+
+static bool
+sec_replayed(struct uwb_sec_source * s, uint32_t counter)
+{
+    uint32_t age;
+
+    if (s->window == 0 || counter > s->counter) {
+        return false;
+    }
+    age = s->counter - counter;
+    return age >= UWB_SEC_WINDOW || (s->window & (1UL << age));
+}
+
+static void
+sec_accept(struct uwb_sec_source * s, uint32_t counter, uint32_t now)
+{
+    if (s->window == 0 || counter > s->counter) {
+        uint32_t shift = counter - s->counter;
+        s->window = (s->window == 0 || shift >= UWB_SEC_WINDOW) ? 1 : (s->window << shift) | 1;
+        s->counter = counter;
+    } else {
+        s->window |= 1UL << (s->counter - counter);
+    }
+    s->last = now;
+}
+
+/* Handle a rejected frame as a frame check error: restart the receiver and notify the services */
+static bool
+sec_reject(struct uwb_sec_instance * sec, struct uwb_mac_interface * cbs)
+{
+    struct uwb_dev * inst = sec->dev_inst;
+
+    // The services test the frame control of the last frame received on tx complete
+    inst->fctrl &= ~FCNTL_IEEE_SECURITY;
+    if (!inst->status.rx_restarted) {
+        uwb_start_rx(inst);
+    }
+    for (struct uwb_mac_interface * it = SLIST_NEXT(cbs, next); it != NULL; it = SLIST_NEXT(it, next)) {
+        if (it->rx_error_cb) {
+            it->rx_error_cb(inst, it);
+        }
+    }
+    return true;
+}
+
+static bool
+sec_keyed(struct uwb_sec_instance * sec)
+{
+    for (uint8_t i = 0; i < MYNEWT_VAL(UWB_SEC_KEYS); i++) {
+        if (sec->keys[i].id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @fn rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+ * @brief Verify secured frames and strip their trailer before the services
+ * see them.
+ *
+ * @param inst  Pointer to struct uwb_dev.
+ * @param cbs   Pointer to struct uwb_mac_interface.
+ *
+ * @return true if the frame was rejected
+ */
+static bool
+rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct uwb_sec_instance * sec = (struct uwb_sec_instance *) cbs->inst_ptr;
+    uint8_t * frame = inst->rxbuf;
+    uint16_t len = inst->frame_len;
+    struct uwb_sec_key * key;
+    struct uwb_sec_source * s;
+    struct uwb_sec_ccm ccm;
+    uwb_sec_aux_t aux;
+    uint8_t nonce[13], mic[MYNEWT_VAL(UWB_SEC_MIC_LEN)], diff = 0;
+    uint16_t src;
+    uint32_t now;
+    bool blink;
+
+    if (len == 0) {
+        return false;
+    }
+    if (frame[0] == FCNTL_IEEE_BLINK_CCP_64) {
+        if (!sec->config.ccp || !sec_keyed(sec)) {
+            return false;
+        }
+    } else if (len < sizeof(uint16_t) || (inst->fctrl & FCNTL_IEEE_SECURITY) == 0) {
+        if (sec->config.required && inst->fctrl == FCNTL_IEEE_RANGE_16) {
+            UWB_SEC_STATS_INC(rx_unsecured);
+            return sec_reject(sec, cbs);
+        }
+        return false;
+    }
+
+    if (len <= UWB_SEC_TRAILER_LEN || !sec_source(frame, len - UWB_SEC_TRAILER_LEN, &blink, &src)) {
+        UWB_SEC_STATS_INC(rx_malformed);
+        return sec_reject(sec, cbs);
+    }
+    len -= UWB_SEC_TRAILER_LEN;
+    memcpy(&aux, frame + len, sizeof(aux));
+    key = sec_key(sec, aux.key_id);
+    if (key == NULL || (key->peer != UWB_SEC_PEER_ANY && key->peer != src)) {
+        UWB_SEC_STATS_INC(rx_no_key);
+        return sec_reject(sec, cbs);
+    }
+
+    sec_nonce(nonce, src, aux.frame_counter);
+    uwb_sec_ccm_start(&key->aes, &ccm, nonce, MYNEWT_VAL(UWB_SEC_MIC_LEN));
+    sec_authenticate(&key->aes, &ccm, frame, len, blink, &aux, mic);
+    for (uint8_t i = 0; i < sizeof(mic); i++) {
+        diff |= mic[i] ^ frame[len + sizeof(aux) + i];
+    }
+    if (diff) {
+        UWB_SEC_STATS_INC(rx_mic_fail);
+        return sec_reject(sec, cbs);
+    }
+
+    // Only authentic frames move the windows
+    now = os_cputime_get32();
+    s = sec_source_find(sec, src, key->id);
+    if (s ? sec_replayed(s, aux.frame_counter) : sec_evicted_replayed(key, src, aux.frame_counter)) {
+        UWB_SEC_STATS_INC(rx_replay);
+        return sec_reject(sec, cbs);
+    }
+    if (s == NULL) {
+        s = sec_source_new(sec, src, key->id, now);
+    }
+    sec_accept(s, aux.frame_counter, now);
+
+    inst->frame_len = len;
+    if (!blink) {
+        frame[0] &= ~FCNTL_IEEE_SECURITY;
+        inst->fctrl &= ~FCNTL_IEEE_SECURITY;
+    }
+    UWB_SEC_STATS_INC(rx_secured);
+    return false;
+}
+
+/**
+ * @fn tx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+ * @brief Prepare the nonce blocks of the next frame while the radio is idle.
+ *
+ * @return false
+ */
+static bool
+tx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    sec_precompute((struct uwb_sec_instance *) cbs->inst_ptr);
+    return false;
+}
+
+void
+uwb_sec_pkg_init(void)
+{
+#if MYNEWT_VAL(UWB_SEC_VERBOSE)
+    printf("{\"utime\": %lu,\"msg\": \"uwb_sec_pkg_init\"}\n", os_cputime_ticks_to_usecs(os_cputime_get32()));
+#endif
+#if MYNEWT_VAL(UWB_DEVICE_0)
+    uwb_sec_init(NULL, uwb_dev_idx_lookup(0));
+#endif
+#if MYNEWT_VAL(UWB_SEC_CLI)
+    int rc = uwb_sec_cli_register();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+}
+
+#endif /* MYNEWT_VAL(UWB_SEC_ENABLED) */
@@ -0,0 +1,214 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file uwb_sec_aes.c
+ * @brief Software AES-128 encryption and CCM* authentication
+ *
+ * @details Byte oriented AES with the 256 byte sbox as only table, the
+ * inverse cipher is not needed by CCM*. Round keys are expanded once when a
+ * key is installed. The MIC follows RFC 3610 with a 13 byte nonce, a two
+ * byte length field and no message, all of the frame being additional
+ * authenticated data: the nonce blocks B0 and A0 do not depend on the frame
+ * and can be encrypted ahead of it.
+ */
+
+#include <string.h>
+#include <os/os.h>
+#include <uwb_sec/uwb_sec.h>
+
+#if MYNEWT_VAL(UWB_SEC_ENABLED)
+
+static const uint8_t g_sbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+#define XTIME(__x) ((uint8_t)(((__x) << 1) ^ (((__x) & 0x80) ? 0x1b : 0x00)))
+
+/**
+ * @fn uwb_sec_aes_expand(uwb_sec_aes_t * aes, const uint8_t key[16])
+ * @brief Expand an AES-128 key into its 11 round keys.
+ *
+ * @param aes   Round keys.
+ * @param key   Key, 16 bytes.
+ *
+ * @return void
+ */
+void
+uwb_sec_aes_expand(uwb_sec_aes_t * aes, const uint8_t key[16])
+{
+    uint8_t * rk = aes->rk;
+    uint8_t rcon = 0x01;
+
+    memcpy(rk, key, 16);
+    for (uint8_t i = 16; i < sizeof(aes->rk); i += 4) {
+        uint8_t t[4] = {rk[i - 4], rk[i - 3], rk[i - 2], rk[i - 1]};
+        if (i % 16 == 0) {
+            uint8_t t0 = t[0];
+            t[0] = g_sbox[t[1]] ^ rcon;
+            t[1] = g_sbox[t[2]];
+            t[2] = g_sbox[t[3]];
+            t[3] = g_sbox[t0];
+            rcon = XTIME(rcon);
+        }
+        for (uint8_t j = 0; j < 4; j++) {
+            rk[i + j] = rk[i + j - 16] ^ t[j];
+        }
+    }
+}
+
+/**
+ * @fn uwb_sec_aes_encrypt(const uwb_sec_aes_t * aes, const uint8_t in[16], uint8_t out[16])
+ * @brief Encrypt one block, in and out may be the same buffer.
+ *
+ * @param aes   Round keys.
+ * @param in    Plain block.
+ * @param out   Cipher block.
+ *
+ * @return void
+ */
+void
+uwb_sec_aes_encrypt(const uwb_sec_aes_t * aes, const uint8_t in[16], uint8_t out[16])
+{
+    const uint8_t * rk = aes->rk;
+    uint8_t s[16];
+
+    for (uint8_t i = 0; i < 16; i++) {
+        s[i] = in[i] ^ rk[i];
+    }
+    for (uint8_t round = 1; round <= 10; round++) {
+        uint8_t t[16];
+        // SubBytes and ShiftRows, the state is column major
+        for (uint8_t c = 0; c < 4; c++) {
+            t[4*c + 0] = g_sbox[s[(4*c + 0) & 15]];
+            t[4*c + 1] = g_sbox[s[(4*c + 5) & 15]];
+            t[4*c + 2] = g_sbox[s[(4*c + 10) & 15]];
+            t[4*c + 3] = g_sbox[s[(4*c + 15) & 15]];
+        }
+        rk += 16;
+        if (round == 10) {
+            for (uint8_t i = 0; i < 16; i++) {
+                out[i] = t[i] ^ rk[i];
+            }
+            break;
+        }
+        // MixColumns and AddRoundKey
+        for (uint8_t c = 0; c < 16; c += 4) {
+            uint8_t a0 = t[c], a1 = t[c + 1], a2 = t[c + 2], a3 = t[c + 3];
+            uint8_t all = a0 ^ a1 ^ a2 ^ a3;
+            s[c + 0] = a0 ^ all ^ XTIME(a0 ^ a1) ^ rk[c + 0];
+            s[c + 1] = a1 ^ all ^ XTIME(a1 ^ a2) ^ rk[c + 1];
+            s[c + 2] = a2 ^ all ^ XTIME(a2 ^ a3) ^ rk[c + 2];
+            s[c + 3] = a3 ^ all ^ XTIME(a3 ^ a0) ^ rk[c + 3];
+        }
+    }
+}
+
+/**
+ * @fn uwb_sec_ccm_start(const uwb_sec_aes_t * aes, struct uwb_sec_ccm * ccm, const uint8_t nonce[13], uint8_t mic_len)
+ * @brief Encrypt the nonce blocks B0 and A0 of a MIC over additional data
+ * only. The two byte length of that data is the first thing folded in with
+ * uwb_sec_ccm_update().
+ *
+ * @param aes       Round keys.
+ * @param ccm       Authentication state.
+ * @param nonce     Source, frame counter and security level.
+ * @param mic_len   MIC bytes, 4, 8 or 16.
+ *
+ * @return void
+ */
+void
+uwb_sec_ccm_start(const uwb_sec_aes_t * aes, struct uwb_sec_ccm * ccm, const uint8_t nonce[13], uint8_t mic_len)
+{
+    uint8_t b[16];
+
+    // Adata, M' = (M - 2) / 2, L' = L - 1 with L = 2, l(m) = 0
+    b[0] = 0x40 | (((mic_len - 2) / 2) << 3) | 0x01;
+    memcpy(b + 1, nonce, 13);
+    b[14] = b[15] = 0;
+    uwb_sec_aes_encrypt(aes, b, ccm->x);
+
+    // Counter block 0
+    b[0] = 0x01;
+    uwb_sec_aes_encrypt(aes, b, ccm->s0);
+    ccm->pos = 0;
+}
+
+/**
+ * @fn uwb_sec_ccm_update(const uwb_sec_aes_t * aes, struct uwb_sec_ccm * ccm, const uint8_t * data, uint16_t len)
+ * @brief Fold authenticated bytes into the CBC-MAC.
+ *
+ * @param aes   Round keys.
+ * @param ccm   Authentication state.
+ * @param data  Bytes.
+ * @param len   Number of bytes.
+ *
+ * @return void
+ */
+void
+uwb_sec_ccm_update(const uwb_sec_aes_t * aes, struct uwb_sec_ccm * ccm, const uint8_t * data, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++) {
+        ccm->x[ccm->pos++] ^= data[i];
+        if (ccm->pos == 16) {
+            uwb_sec_aes_encrypt(aes, ccm->x, ccm->x);
+            ccm->pos = 0;
+        }
+    }
+}
+
+/**
+ * @fn uwb_sec_ccm_mic(const uwb_sec_aes_t * aes, struct uwb_sec_ccm * ccm, uint8_t * mic, uint8_t mic_len)
+ * @brief Pad the last block and produce the encrypted MIC.
+ *
+ * @param aes       Round keys.
+ * @param ccm       Authentication state, spent.
+ * @param mic       MIC out.
+ * @param mic_len   MIC bytes, as given to uwb_sec_ccm_start().
+ *
+ * @return void
+ */
+void
+uwb_sec_ccm_mic(const uwb_sec_aes_t * aes, struct uwb_sec_ccm * ccm, uint8_t * mic, uint8_t mic_len)
+{
+    if (ccm->pos) {
+        uwb_sec_aes_encrypt(aes, ccm->x, ccm->x);
+        ccm->pos = 0;
+    }
+    for (uint8_t i = 0; i < mic_len; i++) {
+        mic[i] = ccm->x[i] ^ ccm->s0[i];
+    }
+}
+
+#endif /* MYNEWT_VAL(UWB_SEC_ENABLED) */
@@ -0,0 +1,52 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "uwb_sec_test.h"
+
+static void
+hex(const char * s, uint8_t * out, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++) {
+        unsigned v;
+        sscanf(s + 2 * i, "%2x", &v);
+        out[i] = v;
+    }
+}
+
+/* FIPS-197 appendix A.1 key expansion and appendix C.1 cipher example */
+TEST_CASE(uwb_sec_aes_test)
+{
+    uwb_sec_aes_t aes;
+    uint8_t key[16], in[16], out[16], expect[16];
+
+    hex("2b7e151628aed2a6abf7158809cf4f3c", key, 16);
+    uwb_sec_aes_expand(&aes, key);
+    hex("d014f9a8c9ee2589e13f0cc8b6630ca6", expect, 16);
+    TEST_ASSERT(memcmp(aes.rk + 160, expect, 16) == 0);
+
+    hex("000102030405060708090a0b0c0d0e0f", key, 16);
+    hex("00112233445566778899aabbccddeeff", in, 16);
+    hex("69c4e0d86a7b0430d8cdb78070b4c55a", expect, 16);
+    uwb_sec_aes_expand(&aes, key);
+    uwb_sec_aes_encrypt(&aes, in, out);
+    TEST_ASSERT(memcmp(out, expect, 16) == 0);
+
+    /* In place */
+    uwb_sec_aes_encrypt(&aes, in, in);
+    TEST_ASSERT(memcmp(in, expect, 16) == 0);
+}
@@ -0,0 +1,62 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "uwb_sec_test.h"
+
+#define UWB_SEC_BENCH_N (2000)
+
+/* MIC of a 36 byte ranging frame, in full and with the nonce blocks encrypted ahead */
+TEST_CASE(uwb_sec_bench_test)
+{
+    static uwb_sec_aes_t aes;
+    struct uwb_sec_ccm ccm, next;
+    uint8_t frame[36] = {0}, nonce[13] = {0}, block[16] = {0}, mic[16];
+    uint32_t start, aes_us, full_us, pre_us;
+
+    uwb_sec_aes_expand(&aes, g_uwb_sec_test_key);
+
+    start = os_cputime_get32();
+    for (uint32_t i = 0; i < UWB_SEC_BENCH_N; i++) {
+        uwb_sec_aes_encrypt(&aes, block, block);
+    }
+    aes_us = os_cputime_ticks_to_usecs(os_cputime_get32() - start);
+
+    start = os_cputime_get32();
+    for (uint32_t i = 0; i < UWB_SEC_BENCH_N; i++) {
+        nonce[11] = i;
+        uwb_sec_ccm_start(&aes, &ccm, nonce, MYNEWT_VAL(UWB_SEC_MIC_LEN));
+        uwb_sec_ccm_update(&aes, &ccm, frame, sizeof(frame));
+        uwb_sec_ccm_mic(&aes, &ccm, mic, MYNEWT_VAL(UWB_SEC_MIC_LEN));
+    }
+    full_us = os_cputime_ticks_to_usecs(os_cputime_get32() - start);
+
+    uwb_sec_ccm_start(&aes, &next, nonce, MYNEWT_VAL(UWB_SEC_MIC_LEN));
+    start = os_cputime_get32();
+    for (uint32_t i = 0; i < UWB_SEC_BENCH_N; i++) {
+        ccm = next;
+        uwb_sec_ccm_update(&aes, &ccm, frame, sizeof(frame));
+        uwb_sec_ccm_mic(&aes, &ccm, mic, MYNEWT_VAL(UWB_SEC_MIC_LEN));
+    }
+    pre_us = os_cputime_ticks_to_usecs(os_cputime_get32() - start);
+
+    printf("{\"n\": %d, \"block_usec\": %.3f, \"mic_usec\": %.3f, \"precomputed_usec\": %.3f}\n", UWB_SEC_BENCH_N,
+           (float)aes_us / UWB_SEC_BENCH_N, (float)full_us / UWB_SEC_BENCH_N, (float)pre_us / UWB_SEC_BENCH_N);
+
+    /* Five blocks in full, three with B0 and A0 ahead */
+    TEST_ASSERT(pre_us < full_us, "precomputed %lu full %lu", (unsigned long)pre_us, (unsigned long)full_us);
+}
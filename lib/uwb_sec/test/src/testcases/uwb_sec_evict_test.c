@@ -0,0 +1,65 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "uwb_sec_test.h"
+
+#define SOURCES MYNEWT_VAL(UWB_SEC_SOURCES)
+
+/* A source evicted from the replay windows keeps its counter, and only its own */
+TEST_CASE(uwb_sec_evict_test)
+{
+    static struct uwb_sec_test_node tx, rx;
+    struct uwb_sec_test_frame f11, f12;
+    uint16_t a = 0x1000;
+
+    uwb_sec_test_setup(&tx, a);
+    uwb_sec_test_setup(&rx, UWB_SEC_TEST_RX_ADDR);
+
+    TEST_ASSERT(uwb_sec_test_deliver(&tx, &rx, a, 10));
+    uwb_sec_test_send(&tx, a, 11, &f11);
+    uwb_sec_test_send(&tx, a, 12, &f12);
+    TEST_ASSERT(uwb_sec_test_receive(&rx, &f12));
+
+    /* A is the least recently heard when the table fills up */
+    for (uint16_t i = 0; i < SOURCES; i++) {
+        TEST_ASSERT(uwb_sec_test_deliver(&tx, &rx, 0x2000 + i, 1));
+    }
+#if MYNEWT_VAL(UWB_SEC_STATS)
+    TEST_ASSERT(rx.sec.stat.evicted == 1, "evicted %d", rx.sec.stat.evicted);
+#endif
+
+    /* Its frames stay replays, the unseen 11 included */
+    TEST_ASSERT(!uwb_sec_test_receive(&rx, &f12));
+    TEST_ASSERT(!uwb_sec_test_receive(&rx, &f11));
+
+    /* Senders at any address other than A are not held to its counter */
+    for (uint16_t i = 1; i < MYNEWT_VAL(UWB_SEC_EVICTED); i++) {
+        TEST_ASSERT(uwb_sec_test_deliver(&tx, &rx, a + i * MYNEWT_VAL(UWB_SEC_EVICTED), 0), "source %x", a + i * MYNEWT_VAL(UWB_SEC_EVICTED));
+    }
+
+    /* A is back above its mark, the frames it had accepted remain replays */
+    TEST_ASSERT(uwb_sec_test_deliver(&tx, &rx, a, 13));
+    TEST_ASSERT(!uwb_sec_test_receive(&rx, &f12));
+    TEST_ASSERT(!uwb_sec_test_receive(&rx, &f11));
+    TEST_ASSERT(uwb_sec_test_deliver(&tx, &rx, a, 14));
+
+#if MYNEWT_VAL(UWB_SEC_STATS)
+    TEST_ASSERT(rx.sec.stat.rx_replay == 4, "replay %d", rx.sec.stat.rx_replay);
+    TEST_ASSERT(rx.sec.stat.mark_dropped == 0);
+#endif
+}
@@ -0,0 +1,70 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "uwb_sec_test.h"
+
+TEST_CASE(uwb_sec_frame_test)
+{
+    static struct uwb_sec_test_node tx, rx;
+    struct uwb_sec_test_frame frame, bad;
+
+    uwb_sec_test_setup(&tx, 0x1234);
+    uwb_sec_test_setup(&rx, UWB_SEC_TEST_RX_ADDR);
+
+    /* Authentic frame, the trailer and security bit are stripped */
+    uwb_sec_test_send(&tx, 0x1234, 7, &frame);
+    TEST_ASSERT(uwb_sec_test_receive(&rx, &frame));
+    TEST_ASSERT(memcmp(rx.dev.rxbuf + 1, frame.buf + 1, UWB_SEC_TEST_LEN - 1) == 0);
+
+    /* Any bit flipped in the frame or trailer is caught */
+    for (uint16_t i = 0; i < frame.len; i++) {
+        uwb_sec_test_send(&tx, 0x1234, 8 + i, &bad);
+        bad.buf[i] ^= 0x01;
+        TEST_ASSERT(!uwb_sec_test_receive(&rx, &bad), "byte %d", i);
+    }
+
+    /* Unknown key */
+    uwb_sec_test_send(&tx, 0x1234, 100, &bad);
+    bad.buf[UWB_SEC_TEST_LEN + sizeof(uint32_t)] = 9;
+    TEST_ASSERT(!uwb_sec_test_receive(&rx, &bad));
+
+    /* Pairwise key of another peer */
+    TEST_ASSERT_FATAL(uwb_sec_key_set(&rx.sec, 2, g_uwb_sec_test_key, 0x5555) == OS_OK);
+    bad.buf[UWB_SEC_TEST_LEN + sizeof(uint32_t)] = 2;
+    TEST_ASSERT(!uwb_sec_test_receive(&rx, &bad));
+
+    /* The frame still passes after all these, its counter is unused */
+    uwb_sec_test_send(&tx, 0x1234, 100, &frame);
+    TEST_ASSERT(uwb_sec_test_receive(&rx, &frame));
+
+    /* Unsecured frames pass unless required */
+    uwb_sec_test_send(&tx, 0x1234, 200, &frame);
+    frame.buf[0] &= ~FCNTL_IEEE_SECURITY;
+    frame.len = UWB_SEC_TEST_LEN;
+    TEST_ASSERT(uwb_sec_test_receive(&rx, &frame));
+    rx.sec.config.required = 1;
+    TEST_ASSERT(!uwb_sec_test_receive(&rx, &frame));
+
+#if MYNEWT_VAL(UWB_SEC_STATS)
+    TEST_ASSERT(rx.sec.stat.rx_mic_fail == UWB_SEC_TEST_LEN + UWB_SEC_TRAILER_LEN - 1,
+                "mic_fail %d", rx.sec.stat.rx_mic_fail);
+    TEST_ASSERT(rx.sec.stat.rx_no_key == 3, "no_key %d", rx.sec.stat.rx_no_key);
+    TEST_ASSERT(rx.sec.stat.rx_unsecured == 1);
+    TEST_ASSERT(rx.sec.stat.rx_secured == 2);
+#endif
+}
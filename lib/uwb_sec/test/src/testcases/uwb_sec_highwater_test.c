@@ -0,0 +1,68 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "uwb_sec_test.h"
+
+#define SOURCES MYNEWT_VAL(UWB_SEC_SOURCES)
+#define EVICTED MYNEWT_VAL(UWB_SEC_EVICTED)
+
+/*
+ * Past UWB_SEC_SOURCES + UWB_SEC_EVICTED senders the oldest mark is
+ * dropped: that source can be replayed once more, nobody is locked out.
+ */
+TEST_CASE(uwb_sec_highwater_test)
+{
+    static struct uwb_sec_test_node tx, rx;
+    struct uwb_sec_test_frame first, second;
+    uint16_t i, n = SOURCES + EVICTED + 1;
+
+    uwb_sec_test_setup(&tx, 0x3000);
+    uwb_sec_test_setup(&rx, UWB_SEC_TEST_RX_ADDR);
+
+    for (i = 0; i < n; i++) {
+        struct uwb_sec_test_frame frame;
+        uwb_sec_test_send(&tx, 0x3000 + i, 1000 + i, &frame);
+        TEST_ASSERT(uwb_sec_test_receive(&rx, &frame), "source %d", i);
+        if (i == 0) {
+            first = frame;
+        } else if (i == 1) {
+            second = frame;
+        }
+    }
+#if MYNEWT_VAL(UWB_SEC_STATS)
+    TEST_ASSERT(rx.sec.stat.evicted == EVICTED + 1, "evicted %d", rx.sec.stat.evicted);
+    TEST_ASSERT(rx.sec.stat.mark_dropped == 1, "dropped %d", rx.sec.stat.mark_dropped);
+#endif
+
+    /* The second source still has its mark, the first one lost it */
+    TEST_ASSERT(!uwb_sec_test_receive(&rx, &second));
+    TEST_ASSERT(uwb_sec_test_receive(&rx, &first));
+
+    /* Every sender carries on, a new one starting from 0 too */
+    for (i = 0; i < n; i++) {
+        TEST_ASSERT(uwb_sec_test_deliver(&tx, &rx, 0x3000 + i, 2000 + i), "source %d", i);
+    }
+    TEST_ASSERT(uwb_sec_test_deliver(&tx, &rx, 0x4000, 0));
+
+    /* Key changes start over */
+    TEST_ASSERT_FATAL(uwb_sec_key_set(&rx.sec, UWB_SEC_TEST_KEY_ID, g_uwb_sec_test_key, UWB_SEC_PEER_ANY) == OS_OK);
+    for (i = 0; i < EVICTED; i++) {
+        TEST_ASSERT(rx.sec.keys[0].evicted[i].next == 0);
+    }
+    TEST_ASSERT(uwb_sec_test_receive(&rx, &second));
+}
@@ -0,0 +1,62 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "uwb_sec_test.h"
+
+TEST_CASE(uwb_sec_replay_test)
+{
+    static struct uwb_sec_test_node tx, rx;
+    struct uwb_sec_test_frame f100, f99;
+
+    uwb_sec_test_setup(&tx, 0x1234);
+    uwb_sec_test_setup(&rx, UWB_SEC_TEST_RX_ADDR);
+
+    uwb_sec_test_send(&tx, 0x1234, 100, &f100);
+    TEST_ASSERT(uwb_sec_test_receive(&rx, &f100));
+    TEST_ASSERT(!uwb_sec_test_receive(&rx, &f100));
+
+    /* Late frames within the window pass once */
+    uwb_sec_test_send(&tx, 0x1234, 99, &f99);
+    TEST_ASSERT(uwb_sec_test_receive(&rx, &f99));
+    TEST_ASSERT(!uwb_sec_test_receive(&rx, &f99));
+    TEST_ASSERT(uwb_sec_test_deliver(&tx, &rx, 0x1234, 100 - UWB_SEC_WINDOW + 1));
+    TEST_ASSERT(!uwb_sec_test_deliver(&tx, &rx, 0x1234, 100 - UWB_SEC_WINDOW));
+
+    /* A jump forward keeps the frames still in the window */
+    TEST_ASSERT(uwb_sec_test_deliver(&tx, &rx, 0x1234, 110));
+    TEST_ASSERT(!uwb_sec_test_receive(&rx, &f100));
+    TEST_ASSERT(!uwb_sec_test_receive(&rx, &f99));
+    TEST_ASSERT(uwb_sec_test_deliver(&tx, &rx, 0x1234, 101));
+
+    /* And one past the window clears it */
+    TEST_ASSERT(uwb_sec_test_deliver(&tx, &rx, 0x1234, 110 + UWB_SEC_WINDOW));
+    TEST_ASSERT(uwb_sec_test_deliver(&tx, &rx, 0x1234, 111));
+    TEST_ASSERT(!uwb_sec_test_deliver(&tx, &rx, 0x1234, 110));
+
+    /* Other sources have windows of their own */
+    TEST_ASSERT(uwb_sec_test_deliver(&tx, &rx, 0x1235, 100));
+    TEST_ASSERT(!uwb_sec_test_deliver(&tx, &rx, 0x1235, 100));
+
+    /* Reset forgets the counters */
+    uwb_sec_reset_sources(&rx.sec);
+    TEST_ASSERT(uwb_sec_test_receive(&rx, &f100));
+
+#if MYNEWT_VAL(UWB_SEC_STATS)
+    TEST_ASSERT(rx.sec.stat.rx_replay == 7, "replay %d", rx.sec.stat.rx_replay);
+#endif
+}
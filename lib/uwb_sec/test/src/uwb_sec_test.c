@@ -0,0 +1,51 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "uwb_sec_test.h"
+
+TEST_CASE_DECL(uwb_sec_aes_test)
+TEST_CASE_DECL(uwb_sec_ccm_test)
+TEST_CASE_DECL(uwb_sec_frame_test)
+TEST_CASE_DECL(uwb_sec_replay_test)
+TEST_CASE_DECL(uwb_sec_evict_test)
+TEST_CASE_DECL(uwb_sec_highwater_test)
+TEST_CASE_DECL(uwb_sec_bench_test)
+
+TEST_SUITE(uwb_sec_test_all)
+{
+    uwb_sec_aes_test();
+    uwb_sec_ccm_test();
+    uwb_sec_frame_test();
+    uwb_sec_replay_test();
+    uwb_sec_evict_test();
+    uwb_sec_highwater_test();
+    uwb_sec_bench_test();
+}
+
+#if MYNEWT_VAL(SELFTEST)
+int
+main(int argc, char **argv)
+{
+    sysinit();
+
+    uwb_sec_test_all();
+
+    return tu_any_failed;
+}
+#endif
@@ -0,0 +1,69 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _UWB_SEC_TEST_H
+#define _UWB_SEC_TEST_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "testutil/testutil.h"
+
+#include "uwb_sec/uwb_sec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Group key of the tests, id 1
+#define UWB_SEC_TEST_KEY_ID (1)
+//! Address of the receiving node
+#define UWB_SEC_TEST_RX_ADDR (0x4321)
+//! Ranging frame length without trailer
+#define UWB_SEC_TEST_LEN (sizeof(ieee_rng_request_frame_t) + 16)
+
+//! One node, a device and its security instance
+struct uwb_sec_test_node {
+    struct uwb_dev dev;
+    struct uwb_sec_instance sec;
+};
+
+//! Frame as seen on air, kept to be replayed
+struct uwb_sec_test_frame {
+    uint8_t buf[UWB_SEC_TEST_LEN + UWB_SEC_TRAILER_LEN];
+    uint16_t len;
+};
+
+extern const uint8_t g_uwb_sec_test_key[16];
+
+void uwb_sec_test_setup(struct uwb_sec_test_node * node, uint16_t addr);
+void uwb_sec_test_send(struct uwb_sec_test_node * tx, uint16_t src, uint32_t counter, struct uwb_sec_test_frame * frame);
+bool uwb_sec_test_receive(struct uwb_sec_test_node * rx, const struct uwb_sec_test_frame * frame);
+bool uwb_sec_test_deliver(struct uwb_sec_test_node * tx, struct uwb_sec_test_node * rx, uint16_t src, uint32_t counter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -42,6 +42,7 @@
 #include <hal/hal_spi.h>
 #include <hal/hal_gpio.h>
 #include <os/os_dev.h>
+#include <sysinit/sysinit.h>
 
 #include <uwb/uwb.h>
 #include <uwb_ccp/uwb_ccp.h>
@@ -500,4 +501,17 @@ uint32_t uwb_wcs_read_txtime_lo_master(struct uwb_dev * inst){
     return (uint32_t) (uwb_wcs_local_to_master(wcs, uwb_read_txtime_lo32(inst))& 0xFFFFFFFFUL);
 }
 
+#if MYNEWT_VAL(UWB_WCS_CLI)
+int uwb_wcs_cli_register(void);
+#endif
+
+void
+uwb_wcs_pkg_init(void)
+{
+#if MYNEWT_VAL(UWB_WCS_CLI)
+    int rc = uwb_wcs_cli_register();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+}
+
 #endif  /* MYNEWT_VAL(UWB_WCS_ENABLED) */
@@ -0,0 +1,100 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file uwb_wcs_cli.c
+ * @brief Host time sync requests
+ *
+ * @details "wcs time <id>" is answered with one line
+ * {"tsync": {"id": id, "valid": v, "t2": t2, "t3": t3}}, t2 the master time
+ * when the command reached the handler and t3 the master time just before
+ * the reply is queued, in dtu of the 64 bit master timeline of
+ * uwb_wcs_read_systime_master64(). The host brackets the exchange with its
+ * own clock for a PTP style offset and delay estimate, see
+ * lib/uwb_bridge/include/uwb_bridge/uwb_bridge_tsync.h. valid is 0 until the
+ * wcs follows the clock master, the times are then local.
+ */
+
+#include <os/os.h>
+#include <syscfg/syscfg.h>
+
+#if MYNEWT_VAL(UWB_WCS_ENABLED) && MYNEWT_VAL(UWB_WCS_CLI)
+
+#include <string.h>
+#include <stdlib.h>
+
+#include <shell/shell.h>
+#include <console/console.h>
+
+#include <uwb/uwb.h>
+#include <uwb_ccp/uwb_ccp.h>
+#include "uwb_wcs/uwb_wcs.h"
+
+static int uwb_wcs_cli_cmd(int argc, char **argv);
+
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+const struct shell_param cmd_wcs_param[] = {
+    {"time", "<id> master time at receipt and reply, host time sync"},
+    {NULL,NULL},
+};
+
+const struct shell_cmd_help cmd_wcs_help = {
+	"wcs", "<cmd>", cmd_wcs_param
+};
+#endif
+
+static struct shell_cmd shell_wcs_cmd = {
+    .sc_cmd = "wcs",
+    .sc_cmd_func = uwb_wcs_cli_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+    .help = &cmd_wcs_help
+#endif
+};
+
+static int
+uwb_wcs_cli_cmd(int argc, char **argv)
+{
+    struct uwb_dev * inst = uwb_dev_idx_lookup(0);
+    struct uwb_ccp_instance * ccp = (struct uwb_ccp_instance *) uwb_mac_find_cb_inst_ptr(inst, UWBEXT_CCP);
+    uint64_t t2, t3;
+
+    // Receipt first, nothing ahead of it but the shell dispatch
+    if (ccp == NULL || ccp->wcs == NULL) {
+        console_printf("No wcs instance\n");
+        return 0;
+    }
+    t2 = uwb_wcs_read_systime_master64(inst);
+
+    if (argc < 3 || strcmp(argv[1], "time")) {
+        console_printf("Unknown cmd\n");
+        return 0;
+    }
+    t3 = uwb_wcs_read_systime_master64(inst);
+    console_printf("{\"tsync\": {\"id\": %lu, \"valid\": %d, \"t2\": %llu, \"t3\": %llu}}\n",
+                   strtoul(argv[2], NULL, 0), ccp->wcs->status.valid,
+                   (unsigned long long)t2, (unsigned long long)t3);
+    return 0;
+}
+
+int
+uwb_wcs_cli_register(void)
+{
+    return shell_cmd_register(&shell_wcs_cmd);
+}
+#endif /* MYNEWT_VAL(UWB_WCS_ENABLED) && MYNEWT_VAL(UWB_WCS_CLI) */
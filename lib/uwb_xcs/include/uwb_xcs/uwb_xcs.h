@@ -0,0 +1,187 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file uwb_xcs.h
+ * @brief Cross-cell clock synchronization
+ *
+ * @details Each ccp cell has its own clock master and uwb_wcs maps local
+ * time to it, so timestamps of different cells are on unrelated timelines.
+ * A border anchor, synchronised to its own master, also hears the ccp
+ * blinks of a neighbouring master. Each such blink pairs the foreign master
+ * time of its transmission with the own master time of its reception, less
+ * the time of flight from ccp->tof_comp_cb, and a timescale filter with the
+ * model and noise settings of uwb_wcs tracks the offset and skew of the
+ * foreign master against the own one. The estimate is kept as a link,
+ * a reference point on both timelines and a skew, and broadcast with
+ * uwb_xcs_broadcast() so that any node in range can map master times
+ * between the cells with uwb_xcs_convert(), either way.
+ *
+ * The cell of an anchor is that of the master whose ccp blinks it sends or
+ * relays, learned from the blinks heard, or set with uwb_xcs_set_member().
+ * rtdoa uses it to bring responses from anchors of another cell onto the
+ * timeline of the request.
+ *
+ * Master times are the 64 bit timelines of the ccp transmission timestamps
+ * and uwb_wcs_local_to_master64(), in dtu.
+ */
+
+#ifndef _UWB_XCS_H_
+#define _UWB_XCS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stats/stats.h>
+#include <uwb/uwb.h>
+#include <uwb/uwb_ftypes.h>
+#include <uwb_ccp/uwb_ccp.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if MYNEWT_VAL(UWB_XCS_STATS)
+STATS_SECT_START(uwb_xcs_stat_section)
+    STATS_SECT_ENTRY(rx_foreign)
+    STATS_SECT_ENTRY(obs_dropped)
+    STATS_SECT_ENTRY(estimates)
+    STATS_SECT_ENTRY(restarts)
+    STATS_SECT_ENTRY(outliers)
+    STATS_SECT_ENTRY(link_tx)
+    STATS_SECT_ENTRY(link_rx)
+    STATS_SECT_ENTRY(convert)
+    STATS_SECT_ENTRY(convert_miss)
+    STATS_SECT_ENTRY(start_tx_error)
+    STATS_SECT_ENTRY(start_rx_error)
+    STATS_SECT_ENTRY(rx_timeout)
+STATS_SECT_END
+#define XCS_STATS_INC(__X) STATS_INC(xcs->stat, __X)
+#else
+#define XCS_STATS_INC(__X) {}
+#endif
+
+//! Link broadcast frame
+typedef union {
+    struct _uwb_xcs_frame_t{
+        struct _ieee_rng_request_frame_t;
+        uint64_t euid;                 //!< Master of the sender's cell
+        uint64_t foreign_euid;         //!< Master of the neighbouring cell
+        uint64_t epoch;                //!< Reference point, master time, dtu
+        uint64_t foreign_epoch;        //!< Foreign master time at epoch, dtu
+        float skew;                    //!< Foreign over master clock rate, minus one
+        float jitter;                  //!< Rms prediction error of the estimate, dtu
+    }__attribute__((__packed__,aligned(1)));
+    uint8_t array[sizeof(struct _uwb_xcs_frame_t)];
+}uwb_xcs_frame_t;
+
+//! Mapping between the master timelines of two cells
+struct uwb_xcs_link {
+    uint64_t euid;                     //!< Master mapped from, 0 marks a free entry
+    uint64_t foreign_euid;             //!< Master mapped to
+    uint64_t epoch;                    //!< Reference point, master time, dtu
+    uint64_t foreign_epoch;            //!< Foreign master time at epoch, dtu
+    double skew;                       //!< Foreign over master clock rate, minus one
+    float jitter;                      //!< Rms prediction error of the estimate, dtu
+    uint16_t src_address;              //!< Border anchor that estimated it
+    uint32_t os_epoch;                 //!< Cputime of the last update
+};
+
+//! Filter of a foreign master on a border anchor
+struct uwb_xcs_estimator {
+    uint64_t foreign_euid;             //!< Foreign master, 0 marks a free entry
+    uint64_t master_euid;              //!< Own master the estimate refers to
+    uint64_t epoch;                    //!< Own master time of the last blink, dtu
+    uint64_t foreign_base;             //!< Foreign master time the filter time is relative to, dtu
+    uint64_t local_epoch;              //!< Local time of the last blink, dtu
+    uint32_t period;                   //!< Foreign ccp period, dwt usec
+    uint32_t os_epoch;                 //!< Cputime of the last blink
+    uint16_t nobs;                     //!< Blinks since the filter started
+    uint16_t outliers;                 //!< Consecutive blinks gated
+    float jitter;                      //!< Rms innovation, dtu
+    struct _timescale_instance_t * timescale; //!< Filter, set up as in uwb_wcs
+};
+
+//! Foreign blink handed from the interrupt to the event queue
+struct uwb_xcs_obs {
+    uint64_t euid;                     //!< Foreign master
+    uint64_t foreign_time;             //!< Transmission, foreign master time, dtu
+    uint64_t local_time;               //!< Reception, local time, dtu
+    uint64_t master_time;              //!< Reception less the time of flight, own master time, dtu
+    double skew;                       //!< Foreign over own master rate minus one, 0 if relayed
+    uint32_t period;                  //!< Foreign ccp period, dwt usec
+    uint16_t src_address;              //!< Master or relay that sent it
+};
+
+//! Anchor to cell assignment
+struct uwb_xcs_member {
+    uint16_t address;                  //!< Anchor short address, 0 marks a free entry
+    uint16_t configured:1;             //!< Set by uwb_xcs_set_member, not learned
+    uint64_t euid;                     //!< Master of its cell
+};
+
+//! Cross-cell status
+typedef struct _uwb_xcs_status_t{
+    uint16_t selfmalloc:1;             //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;            //!< Instance allocated
+    uint16_t obs_pending:1;            //!< Foreign blink waiting for the event queue
+    uint16_t listening:1;              //!< Receiver started by uwb_xcs_listen
+    uint16_t start_tx_error:1;         //!< Start transmit error
+    uint16_t start_rx_error:1;         //!< Start receive error
+}uwb_xcs_status_t;
+
+//! Cross-cell instance
+struct uwb_xcs_instance {
+#if MYNEWT_VAL(UWB_XCS_STATS)
+    STATS_SECT_DECL(uwb_xcs_stat_section) stat; //!< Stats instance
+#endif
+    struct uwb_dev * dev_inst;         //!< Structure of uwb_dev
+    struct uwb_ccp_instance * ccp;     //!< Own cell's clock sync
+    struct uwb_mac_interface cbs;      //!< MAC layer callbacks
+    uwb_xcs_status_t status;           //!< Status
+    uwb_xcs_frame_t frame;             //!< Link broadcast frame
+    struct uwb_xcs_obs obs;            //!< Foreign blink to process
+    struct dpl_event obs_event;        //!< Processes obs
+    uint16_t bcast_idx;                //!< Estimator broadcast next
+    struct uwb_xcs_estimator est[MYNEWT_VAL(UWB_XCS_MAX_FOREIGN)];   //!< Foreign masters heard
+    struct uwb_xcs_link links[MYNEWT_VAL(UWB_XCS_MAX_LINKS)];        //!< Known mappings
+    struct uwb_xcs_member members[MYNEWT_VAL(UWB_XCS_MAX_MEMBERS)];  //!< Known anchors
+};
+
+struct uwb_xcs_instance * uwb_xcs_init(struct uwb_xcs_instance * xcs, struct uwb_ccp_instance * ccp);
+void uwb_xcs_free(struct uwb_xcs_instance * xcs);
+struct uwb_xcs_instance * uwb_xcs_get_instance(struct uwb_dev * inst);
+
+int uwb_xcs_foreign_update(struct uwb_xcs_instance * xcs, uint64_t foreign_euid, uint64_t foreign_time,
+                           uint64_t master_time, double skew);
+int uwb_xcs_link_update(struct uwb_xcs_instance * xcs, const struct uwb_xcs_link * link);
+int uwb_xcs_convert(struct uwb_xcs_instance * xcs, uint64_t from_euid, uint64_t to_euid,
+                    uint64_t time, uint64_t * converted);
+
+int uwb_xcs_set_member(struct uwb_xcs_instance * xcs, uint16_t address, uint64_t euid);
+int uwb_xcs_get_member(struct uwb_xcs_instance * xcs, uint16_t address, uint64_t * euid);
+
+uwb_xcs_status_t uwb_xcs_broadcast(struct uwb_xcs_instance * xcs, uint64_t dx_time);
+uwb_xcs_status_t uwb_xcs_listen(struct uwb_xcs_instance * xcs, uint64_t dx_time);
+uint64_t uwb_xcs_foreign_next(struct uwb_xcs_instance * xcs, uint16_t idx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _UWB_XCS_H_ */
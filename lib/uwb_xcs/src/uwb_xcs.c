@@ -0,0 +1,736 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file uwb_xcs.c
+ * @brief Cross-cell clock synchronization
+ *
+ * @details The filter of a foreign master treats the own master time as its
+ * local clock: for a blink received at own master time m with foreign
+ * transmission time f, timescale tracks f as a function of m, z = [f, skew]
+ * every T = dm seconds, with the process and measurement noise of uwb_wcs.
+ * The skew measurement is the carrier integrator of blinks direct from the
+ * foreign master over the own wcs skew, both being rates against the local
+ * crystal. The filter time is kept relative to foreign_base, rebased every
+ * blink, so the doubles stay small.
+ *
+ * A link maps own master time m to foreign master time
+ *
+ *     f = foreign_epoch + (m - epoch) * (1 + skew)
+ *
+ * and back, refreshed at every blink and broadcast, so the extrapolation is
+ * over one broadcast interval at most.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <os/os.h>
+#include <sysinit/sysinit.h>
+#include <stats/stats.h>
+
+#include <uwb/uwb.h>
+#include <uwb/uwb_ftypes.h>
+#include <uwb_ccp/uwb_ccp.h>
+#include <uwb_wcs/uwb_wcs.h>
+#include <uwb_rng/uwb_rng.h>
+#include <timescale/timescale.h>
+#include <uwb_xcs/uwb_xcs.h>
+
+#if MYNEWT_VAL(UWB_XCS_ENABLED)
+
+#define WCS_DTU MYNEWT_VAL(UWB_WCS_DTU)
+
+#if MYNEWT_VAL(UWB_XCS_STATS)
+STATS_NAME_START(uwb_xcs_stat_section)
+    STATS_NAME(uwb_xcs_stat_section, rx_foreign)
+    STATS_NAME(uwb_xcs_stat_section, obs_dropped)
+    STATS_NAME(uwb_xcs_stat_section, estimates)
+    STATS_NAME(uwb_xcs_stat_section, restarts)
+    STATS_NAME(uwb_xcs_stat_section, outliers)
+    STATS_NAME(uwb_xcs_stat_section, link_tx)
+    STATS_NAME(uwb_xcs_stat_section, link_rx)
+    STATS_NAME(uwb_xcs_stat_section, convert)
+    STATS_NAME(uwb_xcs_stat_section, convert_miss)
+    STATS_NAME(uwb_xcs_stat_section, start_tx_error)
+    STATS_NAME(uwb_xcs_stat_section, start_rx_error)
+    STATS_NAME(uwb_xcs_stat_section, rx_timeout)
+STATS_NAME_END(uwb_xcs_stat_section)
+#endif
+
+static const double g_x0[TIMESCALE_N] = {0};
+static const double g_q[] = { MYNEWT_VAL(TIMESCALE_QVAR) * 1.0l, MYNEWT_VAL(TIMESCALE_QVAR) * 0.1l, MYNEWT_VAL(TIMESCALE_QVAR) * 0.01l};
+static const double g_T = 1e-6l * MYNEWT_VAL(UWB_CCP_PERIOD);  // period in sec
+
+static bool rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static bool rx_timeout_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static bool reset_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs);
+static void xcs_obs_ev_cb(struct dpl_event * ev);
+
+#if MYNEWT_VAL(UWB_XCS_CLI)
+int uwb_xcs_cli_register(void);
+#endif
+
+/**
+ * @fn uwb_xcs_init(struct uwb_xcs_instance * xcs, struct uwb_ccp_instance * ccp)
+ * @brief Allocate and initialise a cross-cell instance.
+ *
+ * @param xcs   Pointer to struct uwb_xcs_instance, NULL to allocate.
+ * @param ccp   Pointer to struct uwb_ccp_instance of the own cell, with wcs.
+ *
+ * @return struct uwb_xcs_instance *
+ */
+struct uwb_xcs_instance *
+uwb_xcs_init(struct uwb_xcs_instance * xcs, struct uwb_ccp_instance * ccp)
+{
+    assert(ccp && ccp->wcs);
+
+    if (xcs == NULL) {
+        xcs = (struct uwb_xcs_instance *) malloc(sizeof(struct uwb_xcs_instance));
+        assert(xcs);
+        memset(xcs, 0, sizeof(struct uwb_xcs_instance));
+        xcs->status.selfmalloc = 1;
+    }
+    xcs->dev_inst = ccp->dev_inst;
+    xcs->ccp = ccp;
+    xcs->frame = (uwb_xcs_frame_t){
+        .PANID = 0xDECA,
+        .fctrl = FCNTL_IEEE_RANGE_16,
+        .dst_address = 0xffff,
+        .src_address = ccp->dev_inst->my_short_address,
+        .code = DWT_XCS_LINK
+    };
+    dpl_event_init(&xcs->obs_event, xcs_obs_ev_cb, (void *) xcs);
+
+    xcs->cbs = (struct uwb_mac_interface){
+        .id = UWBEXT_XCS,
+        .inst_ptr = (void *) xcs,
+        .rx_complete_cb = rx_complete_cb,
+        .rx_timeout_cb = rx_timeout_cb,
+        .reset_cb = reset_cb
+    };
+    uwb_mac_append_interface(xcs->dev_inst, &xcs->cbs);
+
+#if MYNEWT_VAL(UWB_XCS_STATS)
+    if (!xcs->status.initialized) {
+        int rc = stats_init(
+                    STATS_HDR(xcs->stat),
+                    STATS_SIZE_INIT_PARMS(xcs->stat, STATS_SIZE_32),
+                    STATS_NAME_INIT_PARMS(uwb_xcs_stat_section)
+            );
+        rc |= stats_register("xcs", STATS_HDR(xcs->stat));
+        assert(rc == 0);
+    }
+#endif
+    xcs->status.initialized = 1;
+    return xcs;
+}
+
+/**
+ * @fn uwb_xcs_free(struct uwb_xcs_instance * xcs)
+ * @brief Deconstructor.
+ *
+ * @param xcs   Pointer to struct uwb_xcs_instance.
+ *
+ * @return void
+ */
+void
+uwb_xcs_free(struct uwb_xcs_instance * xcs)
+{
+    assert(xcs);
+    uwb_mac_remove_interface(xcs->dev_inst, xcs->cbs.id);
+    for (int i = 0; i < MYNEWT_VAL(UWB_XCS_MAX_FOREIGN); i++) {
+        if (xcs->est[i].timescale) {
+            timescale_free(xcs->est[i].timescale);
+            xcs->est[i].timescale = NULL;
+        }
+    }
+    if (xcs->status.selfmalloc) {
+        free(xcs);
+    } else {
+        xcs->status.initialized = 0;
+    }
+}
+
+/**
+ * @fn uwb_xcs_get_instance(struct uwb_dev * inst)
+ * @brief Cross-cell instance of a device.
+ *
+ * @param inst  Pointer to struct uwb_dev.
+ *
+ * @return struct uwb_xcs_instance *, NULL if the device has none
+ */
+struct uwb_xcs_instance *
+uwb_xcs_get_instance(struct uwb_dev * inst)
+{
+    return (struct uwb_xcs_instance *) uwb_mac_find_cb_inst_ptr(inst, UWBEXT_XCS);
+}
+
+static bool
+xcs_stale(uint32_t os_epoch, uint32_t now)
+{
+    return os_cputime_ticks_to_usecs(now - os_epoch) > MYNEWT_VAL(UWB_XCS_TIMEOUT) * 1000UL;
+}
+
+/* Filter of a foreign master, a free or the stalest entry is taken over if alloc */
+static struct uwb_xcs_estimator *
+xcs_estimator(struct uwb_xcs_instance * xcs, uint64_t foreign_euid, bool alloc)
+{
+    struct uwb_xcs_estimator * spare = NULL;
+
+    for (int i = 0; i < MYNEWT_VAL(UWB_XCS_MAX_FOREIGN); i++) {
+        struct uwb_xcs_estimator * est = &xcs->est[i];
+        if (est->foreign_euid == foreign_euid) {
+            return est;
+        }
+        if (spare == NULL || (spare->foreign_euid &&
+            (est->foreign_euid == 0 || (int32_t)(est->os_epoch - spare->os_epoch) < 0))) {
+            spare = est;
+        }
+    }
+    if (!alloc) {
+        return NULL;
+    }
+    spare->foreign_euid = foreign_euid;
+    spare->nobs = 0;
+    return spare;
+}
+
+/**
+ * @fn uwb_xcs_foreign_update(struct uwb_xcs_instance * xcs, uint64_t foreign_euid, uint64_t foreign_time,
+ *                            uint64_t master_time, double skew)
+ * @brief Add a blink of a foreign master and update its link.
+ *
+ * @param xcs           Pointer to struct uwb_xcs_instance.
+ * @param foreign_euid  Foreign master.
+ * @param foreign_time  Transmission of the blink, foreign master time, dtu.
+ * @param master_time   Its reception less the time of flight, own master time, dtu.
+ * @param skew          Measured foreign over own master rate minus one, 0 if not measured.
+ *
+ * @return 1 if the link was updated, 0 if the filter is not valid yet, -1 if rejected
+ */
+int
+uwb_xcs_foreign_update(struct uwb_xcs_instance * xcs, uint64_t foreign_euid, uint64_t foreign_time,
+                       uint64_t master_time, double skew)
+{
+    struct uwb_xcs_estimator * est = xcs_estimator(xcs, foreign_euid, true);
+    timescale_states_t * states;
+    double T = (int64_t)(master_time - est->epoch) / WCS_DTU;
+
+    // Unseen, own or foreign master restarted, or gone too long
+    if (est->nobs == 0 || est->master_euid != xcs->ccp->master_euid
+        || (int64_t)(foreign_time - est->foreign_base) <= 0 || T > MYNEWT_VAL(UWB_XCS_TIMEOUT) * 1e-3) {
+        est->timescale = timescale_init(est->timescale, g_x0, g_q, g_T);
+        states = (timescale_states_t *) (est->timescale->eke->x);
+        states->time = 0;
+        states->skew = (1.0l + skew) * WCS_DTU;
+        est->master_euid = xcs->ccp->master_euid;
+        est->foreign_base = foreign_time;
+        est->epoch = master_time;
+        est->os_epoch = os_cputime_get32();
+        est->nobs = 1;
+        est->outliers = 0;
+        est->jitter = 0;
+        XCS_STATS_INC(restarts);
+        return 0;
+    }
+    if (T <= 0) {
+        return -1;
+    }
+
+    double z0 = (double)(int64_t)(foreign_time - est->foreign_base);
+    double innovation = z0 - timescale_forward(est->timescale, T);
+    if (est->nobs >= MYNEWT_VAL(UWB_XCS_VALID_THRESHOLD) && fabs(innovation) > MYNEWT_VAL(UWB_XCS_GATE)) {
+        XCS_STATS_INC(outliers);
+        if (++est->outliers >= MYNEWT_VAL(UWB_XCS_RELOCK)) {
+            est->nobs = 0;
+        }
+        return -1;
+    }
+    est->outliers = 0;
+
+    double q[] = {MYNEWT_VAL(TIMESCALE_QVAR) * 1.0, MYNEWT_VAL(TIMESCALE_QVAR) * 0.1, MYNEWT_VAL(TIMESCALE_QVAR) * 0.01};
+    double r[] = {MYNEWT_VAL(TIMESCALE_RVAR), WCS_DTU * 1e20};
+    double z[] = {z0, (1.0l + skew) * WCS_DTU};
+    bool valid = timescale_main(est->timescale, z, q, r, T).valid;
+    states = (timescale_states_t *) (est->timescale->eke->x);
+
+    if (est->nobs < MYNEWT_VAL(UWB_XCS_VALID_THRESHOLD)) {
+        est->jitter = fabsf((float) innovation);
+    } else {
+        est->jitter = sqrtf(est->jitter * est->jitter + ((float)(innovation * innovation) - est->jitter * est->jitter) / 16);
+    }
+    est->epoch = master_time;
+    est->os_epoch = os_cputime_get32();
+    est->nobs++;
+    XCS_STATS_INC(estimates);
+
+    // Rebase, the full foreign time is in foreign_base
+    int64_t shift = (int64_t) floor(states->time);
+    est->foreign_base += shift;
+    states->time -= shift;
+
+    if (!valid || est->nobs < MYNEWT_VAL(UWB_XCS_VALID_THRESHOLD)) {
+        return 0;
+    }
+    struct uwb_xcs_link link = {
+        .euid = est->master_euid,
+        .foreign_euid = est->foreign_euid,
+        .epoch = master_time,
+        .foreign_epoch = est->foreign_base + (int64_t) llround(states->time),
+        .skew = states->skew / WCS_DTU - 1.0l,
+        .jitter = est->jitter,
+        .src_address = xcs->dev_inst->my_short_address
+    };
+    uwb_xcs_link_update(xcs, &link);
+    return 1;
+}
+
+/**
+ * @fn uwb_xcs_link_update(struct uwb_xcs_instance * xcs, const struct uwb_xcs_link * link)
+ * @brief Store a link. Of the links of the same pair of masters from
+ * different border anchors the one of least jitter is kept while fresh.
+ *
+ * @param xcs   Pointer to struct uwb_xcs_instance.
+ * @param link  Link, os_epoch is set here.
+ *
+ * @return 1 if stored, 0 if a better link is kept
+ */
+int
+uwb_xcs_link_update(struct uwb_xcs_instance * xcs, const struct uwb_xcs_link * link)
+{
+    struct uwb_xcs_link * entry = NULL;
+    uint32_t now = os_cputime_get32();
+    uint32_t sr = dpl_hw_enter_critical();
+
+    for (int i = 0; i < MYNEWT_VAL(UWB_XCS_MAX_LINKS); i++) {
+        struct uwb_xcs_link * l = &xcs->links[i];
+        if (l->euid == link->euid && l->foreign_euid == link->foreign_euid) {
+            if (l->src_address != link->src_address && !xcs_stale(l->os_epoch, now) && l->jitter < link->jitter) {
+                dpl_hw_exit_critical(sr);
+                return 0;
+            }
+            entry = l;
+            break;
+        }
+        if (entry == NULL || (entry->euid && (l->euid == 0 || (int32_t)(l->os_epoch - entry->os_epoch) < 0))) {
+            entry = l;
+        }
+    }
+    *entry = *link;
+    entry->os_epoch = now;
+    dpl_hw_exit_critical(sr);
+    return 1;
+}
+
+/**
+ * @fn uwb_xcs_convert(struct uwb_xcs_instance * xcs, uint64_t from_euid, uint64_t to_euid,
+ *                     uint64_t time, uint64_t * converted)
+ * @brief Map a master time of one cell to the master timeline of another,
+ * with the freshest link of least jitter in either direction.
+ *
+ * @param xcs       Pointer to struct uwb_xcs_instance.
+ * @param from_euid Master of the cell of time.
+ * @param to_euid   Master of the cell to map to.
+ * @param time      Master time, dtu.
+ * @param converted Mapped time, dtu.
+ *
+ * @return 0 on success, -1 if no fresh link joins the cells
+ */
+int
+uwb_xcs_convert(struct uwb_xcs_instance * xcs, uint64_t from_euid, uint64_t to_euid,
+                uint64_t time, uint64_t * converted)
+{
+    struct uwb_xcs_link best;
+    bool found = false, inverse = false;
+    uint32_t now = os_cputime_get32();
+
+    if (from_euid == to_euid) {
+        *converted = time;
+        return 0;
+    }
+    uint32_t sr = dpl_hw_enter_critical();
+    for (int i = 0; i < MYNEWT_VAL(UWB_XCS_MAX_LINKS); i++) {
+        struct uwb_xcs_link * l = &xcs->links[i];
+        bool forward = l->euid == from_euid && l->foreign_euid == to_euid;
+        bool backward = l->euid == to_euid && l->foreign_euid == from_euid;
+        if (!(forward || backward) || l->euid == 0 || xcs_stale(l->os_epoch, now)) {
+            continue;
+        }
+        if (!found || l->jitter < best.jitter) {
+            best = *l;
+            inverse = backward;
+            found = true;
+        }
+    }
+    dpl_hw_exit_critical(sr);
+
+    if (!found) {
+        XCS_STATS_INC(convert_miss);
+        return -1;
+    }
+    if (!inverse) {
+        int64_t dt = (int64_t)(time - best.epoch);
+        *converted = best.foreign_epoch + dt + (int64_t) llround(dt * best.skew);
+    } else {
+        int64_t dt = (int64_t)(time - best.foreign_epoch);
+        *converted = best.epoch + dt - (int64_t) llround(dt * best.skew / (1.0l + best.skew));
+    }
+    XCS_STATS_INC(convert);
+    return 0;
+}
+
+/* Cell of an anchor from the blinks it sends, configured entries are kept */
+static void
+xcs_learn_member(struct uwb_xcs_instance * xcs, uint16_t address, uint64_t euid)
+{
+    struct uwb_xcs_member * spare = NULL;
+
+    for (int i = 0; i < MYNEWT_VAL(UWB_XCS_MAX_MEMBERS); i++) {
+        struct uwb_xcs_member * m = &xcs->members[i];
+        if (m->address == address) {
+            if (!m->configured) {
+                m->euid = euid;
+            }
+            return;
+        }
+        if (m->address == 0 && spare == NULL) {
+            spare = m;
+        }
+    }
+    if (spare) {
+        *spare = (struct uwb_xcs_member){.address = address, .euid = euid};
+    }
+}
+
+/**
+ * @fn uwb_xcs_set_member(struct uwb_xcs_instance * xcs, uint16_t address, uint64_t euid)
+ * @brief Assign an anchor to the cell of a master, overriding what is learned.
+ *
+ * @param xcs       Pointer to struct uwb_xcs_instance.
+ * @param address   Anchor short address.
+ * @param euid      Master of its cell, 0 to forget the anchor.
+ *
+ * @return 0 on success, -1 if the table is full
+ */
+int
+uwb_xcs_set_member(struct uwb_xcs_instance * xcs, uint16_t address, uint64_t euid)
+{
+    struct uwb_xcs_member * spare = NULL;
+
+    for (int i = 0; i < MYNEWT_VAL(UWB_XCS_MAX_MEMBERS); i++) {
+        struct uwb_xcs_member * m = &xcs->members[i];
+        if (m->address == address) {
+            spare = m;
+            break;
+        }
+        if (m->address == 0 && spare == NULL) {
+            spare = m;
+        }
+    }
+    if (spare == NULL) {
+        return euid ? -1 : 0;
+    }
+    if (euid == 0) {
+        memset(spare, 0, sizeof(struct uwb_xcs_member));
+    } else {
+        *spare = (struct uwb_xcs_member){.address = address, .configured = 1, .euid = euid};
+    }
+    return 0;
+}
+
+/**
+ * @fn uwb_xcs_get_member(struct uwb_xcs_instance * xcs, uint16_t address, uint64_t * euid)
+ * @brief Cell of an anchor.
+ *
+ * @param xcs       Pointer to struct uwb_xcs_instance.
+ * @param address   Anchor short address.
+ * @param euid      Master of its cell.
+ *
+ * @return 0 on success, -1 if the cell is not known
+ */
+int
+uwb_xcs_get_member(struct uwb_xcs_instance * xcs, uint16_t address, uint64_t * euid)
+{
+    if (address == xcs->dev_inst->my_short_address && xcs->ccp->status.valid) {
+        *euid = xcs->ccp->master_euid;
+        return 0;
+    }
+    for (int i = 0; i < MYNEWT_VAL(UWB_XCS_MAX_MEMBERS); i++) {
+        if (xcs->members[i].address == address) {
+            *euid = xcs->members[i].euid;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @fn uwb_xcs_broadcast(struct uwb_xcs_instance * xcs, uint64_t dx_time)
+ * @brief Broadcast a link estimated here, in turn, call from a tdma slot on
+ * a border anchor.
+ *
+ * @param xcs       Pointer to struct uwb_xcs_instance.
+ * @param dx_time   Delayed start time, 0 to send immediately.
+ *
+ * @return uwb_xcs_status_t
+ */
+uwb_xcs_status_t
+uwb_xcs_broadcast(struct uwb_xcs_instance * xcs, uint64_t dx_time)
+{
+    struct uwb_dev * inst = xcs->dev_inst;
+    uint32_t now = os_cputime_get32();
+    struct uwb_xcs_link * link = NULL;
+
+    for (int i = 0; i < MYNEWT_VAL(UWB_XCS_MAX_LINKS) && link == NULL; i++) {
+        struct uwb_xcs_link * l = &xcs->links[(xcs->bcast_idx + i) % MYNEWT_VAL(UWB_XCS_MAX_LINKS)];
+        if (l->euid && l->src_address == inst->my_short_address && !xcs_stale(l->os_epoch, now)) {
+            link = l;
+            xcs->bcast_idx = (xcs->bcast_idx + i + 1) % MYNEWT_VAL(UWB_XCS_MAX_LINKS);
+        }
+    }
+    if (link == NULL) {
+        return xcs->status;
+    }
+    xcs->frame.seq_num++;
+    xcs->frame.src_address = inst->my_short_address;
+    xcs->frame.euid = link->euid;
+    xcs->frame.foreign_euid = link->foreign_euid;
+    xcs->frame.epoch = link->epoch;
+    xcs->frame.foreign_epoch = link->foreign_epoch;
+    xcs->frame.skew = (float) link->skew;
+    xcs->frame.jitter = link->jitter;
+
+    uwb_write_tx(inst, xcs->frame.array, 0, sizeof(uwb_xcs_frame_t));
+    uwb_write_tx_fctrl(inst, sizeof(uwb_xcs_frame_t), 0);
+    if (dx_time) {
+        uwb_set_delay_start(inst, dx_time);
+    }
+    xcs->status.start_tx_error = uwb_start_tx(inst).start_tx_error;
+    if (xcs->status.start_tx_error) {
+        XCS_STATS_INC(start_tx_error);
+    } else {
+        XCS_STATS_INC(link_tx);
+    }
+    return xcs->status;
+}
+
+/**
+ * @fn uwb_xcs_listen(struct uwb_xcs_instance * xcs, uint64_t dx_time)
+ * @brief Listen for one foreign blink or link broadcast, see
+ * uwb_xcs_foreign_next() for when the next blink of a foreign master is due.
+ *
+ * @param xcs       Pointer to struct uwb_xcs_instance.
+ * @param dx_time   Delayed start time, 0 to start immediately.
+ *
+ * @return uwb_xcs_status_t
+ */
+uwb_xcs_status_t
+uwb_xcs_listen(struct uwb_xcs_instance * xcs, uint64_t dx_time)
+{
+    struct uwb_dev * inst = xcs->dev_inst;
+    uint16_t timeout = uwb_phy_frame_duration(inst, sizeof(uwb_xcs_frame_t))
+                        + MYNEWT_VAL(UWB_XCS_RX_TIMEOUT);
+
+    uwb_set_rx_timeout(inst, timeout);
+    if (dx_time) {
+        uwb_set_delay_start(inst, dx_time);
+    }
+    xcs->status.listening = 1;
+    xcs->status.start_rx_error = uwb_start_rx(inst).start_rx_error;
+    if (xcs->status.start_rx_error) {
+        xcs->status.listening = 0;
+        XCS_STATS_INC(start_rx_error);
+    }
+    return xcs->status;
+}
+
+/**
+ * @fn uwb_xcs_foreign_next(struct uwb_xcs_instance * xcs, uint16_t idx)
+ * @brief Local time to start listening for the next blink of a foreign
+ * master, one period after the last, less the preamble.
+ *
+ * @param xcs   Pointer to struct uwb_xcs_instance.
+ * @param idx   Estimator index, < UWB_XCS_MAX_FOREIGN.
+ *
+ * @return local time, dtu, 0 if the master has not been heard
+ */
+uint64_t
+uwb_xcs_foreign_next(struct uwb_xcs_instance * xcs, uint16_t idx)
+{
+    struct uwb_xcs_estimator * est = &xcs->est[idx % MYNEWT_VAL(UWB_XCS_MAX_FOREIGN)];
+    struct uwb_dev * inst = xcs->dev_inst;
+
+    if (est->foreign_euid == 0 || est->nobs == 0) {
+        return 0;
+    }
+    return (est->local_epoch + ((uint64_t)est->period << 16)
+            - ((uint64_t)ceilf(uwb_usecs_to_dwt_usecs(uwb_phy_SHR_duration(inst))) << 16)) & 0x0FFFFFFFFFFUL;
+}
+
+/* Filter the foreign blink outside of the interrupt context */
+static void
+xcs_obs_ev_cb(struct dpl_event * ev)
+{
+    struct uwb_xcs_instance * xcs = (struct uwb_xcs_instance *) dpl_event_get_arg(ev);
+    struct uwb_xcs_obs * obs = &xcs->obs;
+    struct uwb_xcs_estimator * est;
+
+    uwb_xcs_foreign_update(xcs, obs->euid, obs->foreign_time, obs->master_time, obs->skew);
+    est = xcs_estimator(xcs, obs->euid, false);
+    if (est) {
+        est->local_epoch = obs->local_time;
+        est->period = obs->period;
+    }
+    xcs->status.obs_pending = 0;
+}
+
+/* Own master time of a foreign blink, taken here as a later wcs update would move the local epoch past it */
+static void
+xcs_foreign_rx(struct uwb_xcs_instance * xcs, struct uwb_dev * inst, uwb_ccp_blink_frame_t * frame)
+{
+    struct uwb_ccp_instance * ccp = xcs->ccp;
+    struct uwb_wcs_instance * wcs = ccp->wcs;
+    struct uwb_xcs_obs * obs = &xcs->obs;
+    uint64_t local = inst->rxtimestamp;
+
+    XCS_STATS_INC(rx_foreign);
+    if (xcs->status.obs_pending) {
+        XCS_STATS_INC(obs_dropped);
+        return;
+    }
+    obs->euid = frame->euid;
+    obs->foreign_time = frame->transmission_timestamp.timestamp;
+    obs->local_time = local;
+    obs->src_address = frame->short_address;
+    obs->skew = 0;
+    if (ccp->tof_comp_cb) {
+        local -= (uint64_t)(ccp->tof_comp_cb(frame->short_address) * (1.0l - wcs->skew));
+    }
+    obs->master_time = uwb_wcs_local_to_master64(wcs, local);
+    if (frame->rpt_count == 0) {
+        obs->period = frame->transmission_interval >> 16;
+        // Both rates are against the local crystal
+        obs->skew = (1.0l + uwb_calc_clock_offset_ratio(inst, inst->carrier_integrator, UWB_CR_CARRIER_INTEGRATOR))
+                    / (1.0l - wcs->skew) - 1.0l;
+    } else {
+        // Relays send a shorter interval, the rest of the master's period
+        obs->period = ((frame->transmission_interval / 0x100000000UL + 1) * 0x100000000UL) >> 16;
+    }
+    xcs->status.obs_pending = 1;
+    dpl_eventq_put(dpl_eventq_dflt_get(), &xcs->obs_event);
+}
+
+/**
+ * @fn rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+ * @brief Learn the cells of ccp senders, take foreign blinks and link
+ * broadcasts. Blinks are passed on.
+ *
+ * @return true if the frame was a link broadcast or ended uwb_xcs_listen
+ */
+static bool
+rx_complete_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct uwb_xcs_instance * xcs = (struct uwb_xcs_instance *) cbs->inst_ptr;
+
+    if (inst->fctrl_array[0] == FCNTL_IEEE_BLINK_CCP_64) {
+        uwb_ccp_blink_frame_t * frame = (uwb_ccp_blink_frame_t *) inst->rxbuf;
+        if (inst->frame_len < sizeof(uwb_ccp_blink_frame_t) || inst->status.lde_error) {
+            return false;
+        }
+        xcs_learn_member(xcs, frame->short_address, frame->euid);
+        if (frame->euid != xcs->ccp->master_euid && xcs->ccp->status.valid && xcs->ccp->wcs->status.valid) {
+            xcs_foreign_rx(xcs, inst, frame);
+        }
+        if (xcs->status.listening && frame->euid != xcs->ccp->master_euid) {
+            xcs->status.listening = 0;
+            return true;
+        }
+        return false;
+    }
+
+    uwb_xcs_frame_t * frame = (uwb_xcs_frame_t *) inst->rxbuf;
+    if (inst->fctrl != FCNTL_IEEE_RANGE_16 || inst->frame_len < sizeof(uwb_xcs_frame_t)) {
+        return false;
+    }
+    if (frame->code != DWT_XCS_LINK || frame->dst_address != 0xffff) {
+        return false;
+    }
+    struct uwb_xcs_link link = {
+        .euid = frame->euid,
+        .foreign_euid = frame->foreign_euid,
+        .epoch = frame->epoch,
+        .foreign_epoch = frame->foreign_epoch,
+        .skew = frame->skew,
+        .jitter = frame->jitter,
+        .src_address = frame->src_address
+    };
+    xcs->status.listening = 0;
+    xcs_learn_member(xcs, frame->src_address, frame->euid);
+    uwb_xcs_link_update(xcs, &link);
+    XCS_STATS_INC(link_rx);
+    return true;
+}
+
+static bool
+rx_timeout_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct uwb_xcs_instance * xcs = (struct uwb_xcs_instance *) cbs->inst_ptr;
+
+    if (!xcs->status.listening) {
+        return false;
+    }
+    xcs->status.listening = 0;
+    XCS_STATS_INC(rx_timeout);
+    return true;
+}
+
+static bool
+reset_cb(struct uwb_dev * inst, struct uwb_mac_interface * cbs)
+{
+    struct uwb_xcs_instance * xcs = (struct uwb_xcs_instance *) cbs->inst_ptr;
+
+    if (!xcs->status.listening) {
+        return false;
+    }
+    xcs->status.listening = 0;
+    return true;
+}
+
+void
+uwb_xcs_pkg_init(void)
+{
+#if MYNEWT_VAL(UWB_XCS_VERBOSE)
+    printf("{\"utime\": %lu,\"msg\": \"uwb_xcs_pkg_init\"}\n", os_cputime_ticks_to_usecs(os_cputime_get32()));
+#endif
+#if MYNEWT_VAL(UWB_DEVICE_0)
+    struct uwb_ccp_instance * ccp = (struct uwb_ccp_instance *)
+        uwb_mac_find_cb_inst_ptr(uwb_dev_idx_lookup(0), UWBEXT_CCP);
+    SYSINIT_PANIC_ASSERT(ccp);
+    uwb_xcs_init(NULL, ccp);
+#endif
+#if MYNEWT_VAL(UWB_XCS_CLI)
+    int rc = uwb_xcs_cli_register();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+}
+
+#endif /* MYNEWT_VAL(UWB_XCS_ENABLED) */
@@ -0,0 +1,158 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <os/os.h>
+#include <syscfg/syscfg.h>
+
+#if MYNEWT_VAL(UWB_XCS_ENABLED) && MYNEWT_VAL(UWB_XCS_CLI)
+
+#include <string.h>
+#include <stdlib.h>
+
+#include <shell/shell.h>
+#include <console/console.h>
+
+#include <uwb/uwb.h>
+#include "uwb_xcs/uwb_xcs.h"
+
+static int uwb_xcs_cli_cmd(int argc, char **argv);
+
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+const struct shell_param cmd_xcs_param[] = {
+    {"links", "known mappings between cells"},
+    {"est", "foreign masters heard and their filters"},
+    {"members", "known anchors and their cells"},
+    {"member", "<addr> <euid> assign an anchor to a cell, euid 0 forgets it"},
+    {"map", "<from> <to> <time> map a master time between cells"},
+    {"listen", "listen for a foreign blink or link broadcast"},
+    {"bcast", "broadcast the next link estimated here"},
+    {NULL,NULL},
+};
+
+const struct shell_cmd_help cmd_xcs_help = {
+	"xcs", "<cmd>", cmd_xcs_param
+};
+#endif
+
+static struct shell_cmd shell_xcs_cmd = {
+    .sc_cmd = "xcs",
+    .sc_cmd_func = uwb_xcs_cli_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+    .help = &cmd_xcs_help
+#endif
+};
+
+static void
+uwb_xcs_cli_links(struct uwb_xcs_instance * xcs)
+{
+    uint32_t now = os_cputime_get32();
+
+    for (int i = 0; i < MYNEWT_VAL(UWB_XCS_MAX_LINKS); i++) {
+        struct uwb_xcs_link * l = &xcs->links[i];
+        if (l->euid == 0) {
+            continue;
+        }
+        console_printf("{\"euid\": \"%llx\", \"foreign_euid\": \"%llx\", \"epoch\": %llu, \"foreign_epoch\": %llu, "
+                       "\"skew_ppb\": %ld, \"jitter\": %d, \"src\": \"%x\", \"age_ms\": %lu}\n",
+                       (unsigned long long)l->euid, (unsigned long long)l->foreign_euid,
+                       (unsigned long long)l->epoch, (unsigned long long)l->foreign_epoch,
+                       (long)(l->skew * 1e9), (int)l->jitter, l->src_address,
+                       (unsigned long)(os_cputime_ticks_to_usecs(now - l->os_epoch) / 1000));
+    }
+}
+
+static void
+uwb_xcs_cli_est(struct uwb_xcs_instance * xcs)
+{
+    for (int i = 0; i < MYNEWT_VAL(UWB_XCS_MAX_FOREIGN); i++) {
+        struct uwb_xcs_estimator * est = &xcs->est[i];
+        if (est->foreign_euid == 0) {
+            continue;
+        }
+        console_printf("{\"idx\": %d, \"foreign_euid\": \"%llx\", \"master_euid\": \"%llx\", \"nobs\": %d, "
+                       "\"outliers\": %d, \"jitter\": %d, \"period\": %lu, \"next\": \"%010llx\"}\n",
+                       i, (unsigned long long)est->foreign_euid, (unsigned long long)est->master_euid,
+                       est->nobs, est->outliers, (int)est->jitter, (unsigned long)est->period,
+                       (unsigned long long)uwb_xcs_foreign_next(xcs, i));
+    }
+}
+
+static void
+uwb_xcs_cli_members(struct uwb_xcs_instance * xcs)
+{
+    for (int i = 0; i < MYNEWT_VAL(UWB_XCS_MAX_MEMBERS); i++) {
+        struct uwb_xcs_member * m = &xcs->members[i];
+        if (m->address) {
+            console_printf("{\"addr\": \"%x\", \"euid\": \"%llx\", \"configured\": %d}\n",
+                           m->address, (unsigned long long)m->euid, m->configured);
+        }
+    }
+}
+
+static int
+uwb_xcs_cli_cmd(int argc, char **argv)
+{
+    struct uwb_xcs_instance * xcs = uwb_xcs_get_instance(uwb_dev_idx_lookup(0));
+
+    if (argc < 2) {
+        return 0;
+    }
+    if (xcs == NULL) {
+        console_printf("No xcs instance\n");
+        return 0;
+    }
+
+    if (!strcmp(argv[1], "links")) {
+        uwb_xcs_cli_links(xcs);
+    } else if (!strcmp(argv[1], "est")) {
+        uwb_xcs_cli_est(xcs);
+    } else if (!strcmp(argv[1], "members")) {
+        uwb_xcs_cli_members(xcs);
+    } else if (!strcmp(argv[1], "member") && argc > 3) {
+        if (uwb_xcs_set_member(xcs, strtol(argv[2], NULL, 16), strtoull(argv[3], NULL, 16))) {
+            console_printf("Member table full\n");
+        }
+    } else if (!strcmp(argv[1], "map") && argc > 4) {
+        uint64_t converted;
+        if (uwb_xcs_convert(xcs, strtoull(argv[2], NULL, 16), strtoull(argv[3], NULL, 16),
+                            strtoull(argv[4], NULL, 0), &converted)) {
+            console_printf("No link\n");
+        } else {
+            console_printf("{\"time\": %llu}\n", (unsigned long long)converted);
+        }
+    } else if (!strcmp(argv[1], "listen")) {
+        if (uwb_xcs_listen(xcs, 0).start_rx_error) {
+            console_printf("start_rx_error\n");
+        }
+    } else if (!strcmp(argv[1], "bcast")) {
+        if (uwb_xcs_broadcast(xcs, 0).start_tx_error) {
+            console_printf("start_tx_error\n");
+        }
+    } else {
+        console_printf("Unknown cmd\n");
+    }
+    return 0;
+}
+
+int
+uwb_xcs_cli_register(void)
+{
+    return shell_cmd_register(&shell_xcs_cmd);
+}
+#endif /* MYNEWT_VAL(UWB_XCS_ENABLED) && MYNEWT_VAL(UWB_XCS_CLI) */
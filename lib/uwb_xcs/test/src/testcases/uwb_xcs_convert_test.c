@@ -0,0 +1,68 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "uwb_xcs_test.h"
+
+/**
+ * A border anchor of cell A filters the blinks of master B, with 10 dtu of
+ * reception noise. No link before UWB_XCS_VALID_THRESHOLD blinks, one per
+ * blink after; master times between blinks then map A to B and B to A
+ * within the filter error, and back again to within rounding.
+ */
+TEST_CASE(uwb_xcs_convert_test)
+{
+    struct uwb_xcs_instance * xcs = uwb_xcs_test_setup();
+    double se = 0, se_inv = 0;
+    int n = 0;
+
+    srand(1);
+    TEST_ASSERT(uwb_xcs_test_lock(xcs, 1, MYNEWT_VAL(UWB_XCS_VALID_THRESHOLD) - 1, 10) == 0);
+    TEST_ASSERT(uwb_xcs_convert(xcs, UWB_XCS_TEST_A, UWB_XCS_TEST_B, 0, &(uint64_t){0}) == -1);
+
+    for (int i = MYNEWT_VAL(UWB_XCS_VALID_THRESHOLD); i < 120; i++) {
+        TEST_ASSERT(uwb_xcs_test_lock(xcs, i, 1, 10) == 1, "%d", i);
+        if (i < 60) {
+            continue;
+        }
+        // Up to a period after the blink, as far as a broadcast link is extrapolated
+        for (int k = 1; k < 10; k++) {
+            double t = uwb_xcs_test_blink(i) + k * (uwb_xcs_test_blink(i + 1) - uwb_xcs_test_blink(i)) / 10;
+            uint64_t a = uwb_xcs_test_master(UWB_XCS_TEST_A, t), b = uwb_xcs_test_master(UWB_XCS_TEST_B, t);
+            uint64_t out, back;
+            TEST_ASSERT_FATAL(uwb_xcs_convert(xcs, UWB_XCS_TEST_A, UWB_XCS_TEST_B, a, &out) == 0);
+            se += pow((double)(int64_t)(out - b), 2);
+            TEST_ASSERT(uwb_xcs_convert(xcs, UWB_XCS_TEST_B, UWB_XCS_TEST_A, out, &back) == 0);
+            TEST_ASSERT(llabs((int64_t)(back - a)) <= 1, "%lld", (long long)(int64_t)(back - a));
+            TEST_ASSERT_FATAL(uwb_xcs_convert(xcs, UWB_XCS_TEST_B, UWB_XCS_TEST_A, b, &out) == 0);
+            se_inv += pow((double)(int64_t)(out - a), 2);
+            n++;
+        }
+    }
+    TEST_ASSERT(sqrt(se / n) < 20, "%f", sqrt(se / n));
+    TEST_ASSERT(sqrt(se_inv / n) < 20, "%f", sqrt(se_inv / n));
+
+    TEST_ASSERT(xcs->links[0].euid == UWB_XCS_TEST_A && xcs->links[0].foreign_euid == UWB_XCS_TEST_B);
+    TEST_ASSERT(xcs->links[0].src_address == UWB_XCS_TEST_ADDR);
+    TEST_ASSERT(fabs(xcs->links[0].skew - uwb_xcs_test_skew(uwb_xcs_test_blink(119))) < 1e-8);
+    TEST_ASSERT(xcs->links[0].jitter > 0 && xcs->links[0].jitter < 30, "%f", xcs->links[0].jitter);
+
+    /* An own master change restarts the filter */
+    xcs->ccp->master_euid = UWB_XCS_TEST_B + 1;
+    TEST_ASSERT(uwb_xcs_test_lock(xcs, 120, 1, 10) == 0);
+    TEST_ASSERT(xcs->est[0].nobs == 1);
+}
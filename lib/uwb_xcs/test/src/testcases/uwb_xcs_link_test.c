@@ -0,0 +1,98 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "uwb_xcs_test.h"
+
+static struct uwb_xcs_link
+link(uint64_t euid, uint64_t foreign_euid, uint16_t src_address, float jitter, int64_t bias)
+{
+    double t = 100;
+
+    return (struct uwb_xcs_link){
+        .euid = euid,
+        .foreign_euid = foreign_euid,
+        .epoch = uwb_xcs_test_master(euid, t),
+        .foreign_epoch = uwb_xcs_test_master(foreign_euid, t) + bias,
+        .skew = (euid == UWB_XCS_TEST_A) ? uwb_xcs_test_skew(t) : 1 / (1 + uwb_xcs_test_skew(t)) - 1,
+        .jitter = jitter,
+        .src_address = src_address
+    };
+}
+
+static int64_t
+error(struct uwb_xcs_instance * xcs, uint64_t from, uint64_t to)
+{
+    uint64_t out;
+
+    if (uwb_xcs_convert(xcs, from, to, uwb_xcs_test_master(from, 100.1), &out)) {
+        return INT64_MAX;
+    }
+    return (int64_t)(out - uwb_xcs_test_master(to, 100.1));
+}
+
+/**
+ * Of the links between two masters, a fresh one of less jitter from another
+ * border anchor is kept over a new one; the sender's own refresh and a stale
+ * entry are replaced. Conversion takes the least jitter link either way,
+ * and none once UWB_XCS_TIMEOUT passes.
+ */
+TEST_CASE(uwb_xcs_link_test)
+{
+    struct uwb_xcs_instance * xcs = uwb_xcs_test_setup();
+    struct uwb_xcs_link l;
+#if MYNEWT_VAL(UWB_XCS_STATS)
+    uint32_t convert_miss = xcs->stat.convert_miss;
+#endif
+
+    /* Least jitter kept */
+    l = link(UWB_XCS_TEST_A, UWB_XCS_TEST_B, 0x10, 20, 100);
+    TEST_ASSERT(uwb_xcs_link_update(xcs, &l) == 1);
+    TEST_ASSERT(llabs(error(xcs, UWB_XCS_TEST_A, UWB_XCS_TEST_B) - 100) <= 2);
+    l = link(UWB_XCS_TEST_A, UWB_XCS_TEST_B, 0x20, 10, 200);
+    TEST_ASSERT(uwb_xcs_link_update(xcs, &l) == 1);
+    l = link(UWB_XCS_TEST_A, UWB_XCS_TEST_B, 0x10, 20, 100);
+    TEST_ASSERT(uwb_xcs_link_update(xcs, &l) == 0);
+    TEST_ASSERT(llabs(error(xcs, UWB_XCS_TEST_A, UWB_XCS_TEST_B) - 200) <= 2);
+    l = link(UWB_XCS_TEST_A, UWB_XCS_TEST_B, 0x20, 30, 300);
+    TEST_ASSERT(uwb_xcs_link_update(xcs, &l) == 1);
+    TEST_ASSERT(llabs(error(xcs, UWB_XCS_TEST_A, UWB_XCS_TEST_B) - 300) <= 2);
+
+    /* The inverse link of less jitter, of the same mapping */
+    l = link(UWB_XCS_TEST_B, UWB_XCS_TEST_A, 0x30, 5, -400);
+    TEST_ASSERT(uwb_xcs_link_update(xcs, &l) == 1);
+    TEST_ASSERT(llabs(error(xcs, UWB_XCS_TEST_A, UWB_XCS_TEST_B) - 400) <= 2);
+    TEST_ASSERT(llabs(error(xcs, UWB_XCS_TEST_B, UWB_XCS_TEST_A) + 400) <= 2);
+
+    /* Fresh until the timeout */
+    uwb_xcs_test_age(xcs, MYNEWT_VAL(UWB_XCS_TIMEOUT) - 100);
+    TEST_ASSERT(llabs(error(xcs, UWB_XCS_TEST_B, UWB_XCS_TEST_A) + 400) <= 2);
+    l = link(UWB_XCS_TEST_A, UWB_XCS_TEST_B, 0x10, 40, 100);
+    TEST_ASSERT(uwb_xcs_link_update(xcs, &l) == 0);
+    uwb_xcs_test_age(xcs, 200);
+    TEST_ASSERT(uwb_xcs_link_update(xcs, &l) == 1);
+    TEST_ASSERT(llabs(error(xcs, UWB_XCS_TEST_B, UWB_XCS_TEST_A) + 100) <= 2);
+
+    /* No fresh link */
+    uwb_xcs_test_age(xcs, MYNEWT_VAL(UWB_XCS_TIMEOUT) + 100);
+    TEST_ASSERT(error(xcs, UWB_XCS_TEST_A, UWB_XCS_TEST_B) == INT64_MAX);
+    TEST_ASSERT(error(xcs, UWB_XCS_TEST_B, UWB_XCS_TEST_A) == INT64_MAX);
+    TEST_ASSERT(error(xcs, UWB_XCS_TEST_B, UWB_XCS_TEST_B) == 0);
+#if MYNEWT_VAL(UWB_XCS_STATS)
+    TEST_ASSERT(xcs->stat.convert_miss - convert_miss == 2);
+#endif
+}
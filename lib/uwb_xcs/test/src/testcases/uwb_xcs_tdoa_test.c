@@ -0,0 +1,90 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "uwb_xcs_test.h"
+#include "uwb_rng/uwb_rng.h"
+#include "rtdoa/rtdoa.h"
+
+//! Anchor of cell A sending the request, and of cell B responding
+#define REQ_ADDR  (0x10)
+#define RESP_ADDR (0x20)
+
+static float
+tdoa(struct rtdoa_instance * rtdoa, double t, float d_req, float d_resp)
+{
+    rtdoa_frame_t req = {0}, resp = {0};
+    uint64_t euid;
+    double tof = 1 / uwb_rng_tof_to_meters(1.0f);
+
+    // Local clock runs as master A, wcs not valid
+    req.src_address = REQ_ADDR;
+    req.code = DWT_RTDOA_REQUEST;
+    req.tx_timestamp = uwb_xcs_test_master(UWB_XCS_TEST_A, t);
+    req.rx_timestamp = (req.tx_timestamp + (uint64_t)llround(d_req * tof)) & 0x0FFFFFFFFFFULL;
+    resp.src_address = RESP_ADDR;
+    resp.code = DWT_RTDOA_RESP;
+    TEST_ASSERT(uwb_xcs_get_member(uwb_xcs_get_instance(rtdoa->dev_inst), RESP_ADDR, &euid) == 0);
+    resp.tx_timestamp = uwb_xcs_test_master(euid, t + 2e-3);
+    resp.rx_timestamp = (uwb_xcs_test_master(UWB_XCS_TEST_A, t + 2e-3)
+                         + (uint64_t)llround(d_resp * tof)) & 0x0FFFFFFFFFFULL;
+    rtdoa->req_frame = &req;
+    float diff = rtdoa_tdoa_between_frames(rtdoa, &req, &resp);
+    TEST_ASSERT(resp.code == DWT_TWR_INVALID);
+    return diff;
+}
+
+/**
+ * A response from an anchor of cell B is brought onto the timeline of a
+ * request from cell A with the link; without a fresh link there is no
+ * tdoa, rather than one across unrelated timelines.
+ */
+TEST_CASE(uwb_xcs_tdoa_test)
+{
+    struct uwb_xcs_instance * xcs = uwb_xcs_test_setup();
+    struct rtdoa_instance rtdoa = {.dev_inst = xcs->dev_inst};
+    struct uwb_xcs_link l = {
+        .euid = UWB_XCS_TEST_A,
+        .foreign_euid = UWB_XCS_TEST_B,
+        .epoch = uwb_xcs_test_master(UWB_XCS_TEST_A, 50),
+        .foreign_epoch = uwb_xcs_test_master(UWB_XCS_TEST_B, 50),
+        .skew = uwb_xcs_test_skew(50),
+        .jitter = 10,
+        .src_address = 0x30
+    };
+    float diff;
+
+    TEST_ASSERT_FATAL(uwb_xcs_get_instance(xcs->dev_inst) == xcs);
+    TEST_ASSERT(uwb_xcs_set_member(xcs, REQ_ADDR, UWB_XCS_TEST_A) == 0);
+    TEST_ASSERT(uwb_xcs_set_member(xcs, RESP_ADDR, UWB_XCS_TEST_B) == 0);
+    TEST_ASSERT(uwb_xcs_link_update(xcs, &l) == 1);
+
+    diff = tdoa(&rtdoa, 50.5, 10, 30);
+    TEST_ASSERT(fabsf(diff - 20) < 0.1f, "%f", diff);
+    diff = tdoa(&rtdoa, 50.5, 30, 10);
+    TEST_ASSERT(fabsf(diff + 20) < 0.1f, "%f", diff);
+
+    /* Stale */
+    uwb_xcs_test_age(xcs, MYNEWT_VAL(UWB_XCS_TIMEOUT) + 100);
+    diff = tdoa(&rtdoa, 50.5, 10, 30);
+    TEST_ASSERT(isnan(diff), "%f", diff);
+
+    /* Same cell, no link needed */
+    TEST_ASSERT(uwb_xcs_set_member(xcs, RESP_ADDR, UWB_XCS_TEST_A) == 0);
+    diff = tdoa(&rtdoa, 50.5, 10, 30);
+    TEST_ASSERT(fabsf(diff - 20) < 0.1f, "%f", diff);
+}
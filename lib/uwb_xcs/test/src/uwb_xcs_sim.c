@@ -0,0 +1,131 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "uwb_xcs_test.h"
+
+#define DTU MYNEWT_VAL(UWB_WCS_DTU)
+
+//! Master clocks, c(t) = c0 + (t * (1 + e) + d * t * t / 2) * DTU
+struct clock {
+    double c0, e, d;
+};
+static const struct clock g_clocks[] = {
+    {1e15, 10e-6, 1e-10},
+    {3e15, -15e-6, -2e-10}
+};
+
+static struct uwb_dev g_dev;
+static struct uwb_wcs_instance g_wcs;
+static struct uwb_ccp_instance g_ccp;
+static struct uwb_xcs_instance g_xcs;
+
+static const struct clock *
+master_clock(uint64_t euid)
+{
+    return &g_clocks[euid == UWB_XCS_TEST_B];
+}
+
+/** Master time of the cell of euid at t s */
+uint64_t
+uwb_xcs_test_master(uint64_t euid, double t)
+{
+    const struct clock * c = master_clock(euid);
+
+    return (uint64_t)llround(c->c0 + (t * (1 + c->e) + 0.5 * c->d * t * t) * DTU);
+}
+
+/** Time, s, of the n-th blink of master B */
+double
+uwb_xcs_test_blink(int n)
+{
+    const struct clock * c = master_clock(UWB_XCS_TEST_B);
+    double v = c->c0 + n * (double)UWB_XCS_TEST_PERIOD;
+    double t = (v - c->c0) / DTU;
+
+    for (int i = 0; i < 4; i++) {
+        t -= (c->c0 + (t * (1 + c->e) + 0.5 * c->d * t * t) * DTU - v) / (DTU * (1 + c->e + c->d * t));
+    }
+    return t;
+}
+
+/** Rate of master B over master A, minus one, at t s */
+double
+uwb_xcs_test_skew(double t)
+{
+    const struct clock * a = master_clock(UWB_XCS_TEST_A), * b = master_clock(UWB_XCS_TEST_B);
+
+    return (1 + b->e + b->d * t) / (1 + a->e + a->d * t) - 1;
+}
+
+/** Border anchor in the cell of A, synchronised, nothing heard of B */
+struct uwb_xcs_instance *
+uwb_xcs_test_setup(void)
+{
+    if (!g_xcs.status.initialized) {
+        g_dev.my_short_address = UWB_XCS_TEST_ADDR;
+        g_ccp.dev_inst = &g_dev;
+        g_ccp.wcs = &g_wcs;
+        g_ccp.cbs = (struct uwb_mac_interface){
+            .id = UWBEXT_CCP,
+            .inst_ptr = (void *) &g_ccp
+        };
+        uwb_mac_append_interface(&g_dev, &g_ccp.cbs);
+        uwb_xcs_init(&g_xcs, &g_ccp);
+    }
+    g_ccp.master_euid = UWB_XCS_TEST_A;
+    g_ccp.status.valid = 1;
+    for (int i = 0; i < MYNEWT_VAL(UWB_XCS_MAX_FOREIGN); i++) {
+        g_xcs.est[i].foreign_euid = 0;
+        g_xcs.est[i].nobs = 0;
+    }
+    memset(g_xcs.links, 0, sizeof(g_xcs.links));
+    memset(g_xcs.members, 0, sizeof(g_xcs.members));
+    return &g_xcs;
+}
+
+/** Links as if last updated ms earlier */
+void
+uwb_xcs_test_age(struct uwb_xcs_instance * xcs, uint32_t ms)
+{
+    for (int i = 0; i < MYNEWT_VAL(UWB_XCS_MAX_LINKS); i++) {
+        xcs->links[i].os_epoch -= os_cputime_usecs_to_ticks(ms * 1000);
+    }
+}
+
+/**
+ * Feed blinks n0 to n0 + n - 1 of master B to the filter, received on the
+ * timeline of A with sigma dtu of gaussian noise and the true skew. Returns
+ * the number of link updates.
+ */
+int
+uwb_xcs_test_lock(struct uwb_xcs_instance * xcs, int n0, int n, double sigma)
+{
+    int updates = 0;
+
+    for (int i = n0; i < n0 + n; i++) {
+        double t = uwb_xcs_test_blink(i);
+        double u = (rand() + 1.0) / (RAND_MAX + 2.0), v = (rand() + 1.0) / (RAND_MAX + 2.0);
+        double noise = sigma * sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+        int rc = uwb_xcs_foreign_update(xcs, UWB_XCS_TEST_B, uwb_xcs_test_master(UWB_XCS_TEST_B, t),
+                                        uwb_xcs_test_master(UWB_XCS_TEST_A, t) + (int64_t)llround(noise),
+                                        uwb_xcs_test_skew(t));
+        updates += (rc == 1);
+    }
+    return updates;
+}
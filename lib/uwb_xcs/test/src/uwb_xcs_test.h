@@ -0,0 +1,63 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _UWB_XCS_TEST_H
+#define _UWB_XCS_TEST_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "testutil/testutil.h"
+
+#include "uwb/uwb.h"
+#include "uwb_ccp/uwb_ccp.h"
+#include "uwb_wcs/uwb_wcs.h"
+#include "uwb_xcs/uwb_xcs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Master of the own cell
+#define UWB_XCS_TEST_A (0xA000000000000001ULL)
+//! Master of the neighbouring cell
+#define UWB_XCS_TEST_B (0xB000000000000002ULL)
+//! Address of the border anchor
+#define UWB_XCS_TEST_ADDR (0x1234)
+//! Ccp period of both masters, dtu
+#define UWB_XCS_TEST_PERIOD ((uint64_t)MYNEWT_VAL(UWB_CCP_PERIOD) << 16)
+
+struct uwb_xcs_instance * uwb_xcs_test_setup(void);
+void uwb_xcs_test_age(struct uwb_xcs_instance * xcs, uint32_t ms);
+uint64_t uwb_xcs_test_master(uint64_t euid, double t);
+double uwb_xcs_test_blink(int n);
+double uwb_xcs_test_skew(double t);
+int uwb_xcs_test_lock(struct uwb_xcs_instance * xcs, int n0, int n, double sigma);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _UWB_XCS_TEST_H */